@@ -0,0 +1,143 @@
+/*
+ * comm_backpressure.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../include/libbrb_core.h"
+
+/**************************************************************************************************************************/
+void CommEvBackpressureInit(CommEvBackpressure *backpressure, void *owner_ptr, CommEvBackpressureReadCtlCBH *read_ctl_cbh)
+{
+	/* Sanity check */
+	if (!backpressure)
+		return;
+
+	memset(backpressure, 0, sizeof(CommEvBackpressure));
+	backpressure->owner_ptr		= owner_ptr;
+	backpressure->read_ctl_cbh	= read_ctl_cbh;
+
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvBackpressureLink(CommEvBackpressure *backpressure_a, CommEvBackpressure *backpressure_b)
+{
+	/* Sanity check */
+	if ((!backpressure_a) || (!backpressure_b) || (backpressure_a == backpressure_b))
+		return;
+
+	/* Drop any previous pairing, releasing whoever was paused by it */
+	CommEvBackpressureUnlink(backpressure_a);
+	CommEvBackpressureUnlink(backpressure_b);
+
+	/* Link is symmetric, each side feeds the write queue of the other */
+	backpressure_a->peer = backpressure_b;
+	backpressure_b->peer = backpressure_a;
+
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvBackpressureUnlink(CommEvBackpressure *backpressure)
+{
+	CommEvBackpressure *peer;
+
+	/* Sanity check */
+	if ((!backpressure) || (!backpressure->peer))
+		return;
+
+	peer = backpressure->peer;
+
+	/* We paused peer, let it read again */
+	CommEvBackpressurePeerResume(backpressure);
+
+	/* Peer paused us, nobody will ever resume us if link goes away */
+	if (peer->flags.peer_paused)
+	{
+		peer->flags.peer_paused = 0;
+		CommEvBackpressureReadResume(backpressure);
+	}
+
+	backpressure->peer	= NULL;
+	peer->peer			= NULL;
+
+	return;
+}
+/**************************************************************************************************************************/
+int CommEvBackpressurePeerPause(CommEvBackpressure *backpressure)
+{
+	/* No peer or already paused by us */
+	if ((!backpressure->peer) || (backpressure->flags.peer_paused))
+		return 0;
+
+	backpressure->flags.peer_paused = 1;
+	return CommEvBackpressureReadPause(backpressure->peer);
+}
+/**************************************************************************************************************************/
+int CommEvBackpressurePeerResume(CommEvBackpressure *backpressure)
+{
+	/* No peer or not paused by us */
+	if ((!backpressure->peer) || (!backpressure->flags.peer_paused))
+		return 0;
+
+	backpressure->flags.peer_paused = 0;
+	return CommEvBackpressureReadResume(backpressure->peer);
+}
+/**************************************************************************************************************************/
+int CommEvBackpressureReadPause(CommEvBackpressure *backpressure)
+{
+	/* Already paused */
+	if (backpressure->flags.read_paused)
+		return 0;
+
+	backpressure->flags.read_paused = 1;
+
+	/* Let owner drop its READ_EV */
+	if (backpressure->read_ctl_cbh)
+		backpressure->read_ctl_cbh(backpressure->owner_ptr, 1);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+int CommEvBackpressureReadResume(CommEvBackpressure *backpressure)
+{
+	/* Not paused */
+	if (!backpressure->flags.read_paused)
+		return 0;
+
+	backpressure->flags.read_paused = 0;
+
+	/* Let owner arm its READ_EV again */
+	if (backpressure->read_ctl_cbh)
+		backpressure->read_ctl_cbh(backpressure->owner_ptr, 0);
+
+	return 1;
+}
+/**************************************************************************************************************************/
@@ -102,6 +102,31 @@ static EvBaseKQCBH CommEvDNSWriteEvent;
 static EvBaseKQCBH CommEvDNSPeriodicTimerEvent;
 static int CommEvDNStvSubMsec(struct timeval *t1, struct timeval *t2);
 
+static EvBaseKQCBH CommEvDNSCacheDispatchTimerEvent;
+static DNSPendingQuery *CommEvDNSPendingQueryGrab(EvDNSResolverBase *resolv_base, CommEvDNSResolverCBH *cb_handler, void *cb_data);
+static void CommEvDNSPendingQueryRelease(EvDNSResolverBase *resolv_base, DNSPendingQuery *pending_query);
+static void CommEvDNSPendingQueryTransmit(EvDNSResolverBase *resolv_base, DNSPendingQuery *pending_query, char *host, int query_x);
+static long CommEvDNSCacheNowGet(EvDNSResolverBase *resolv_base);
+static int CommEvDNSCacheKeyBuild(char *host, int query_x, char *key_str, int key_sz);
+static DNSCacheEntry *CommEvDNSCacheEntryNew(EvDNSResolverBase *resolv_base, char *key_str);
+static void CommEvDNSCacheEntryDestroy(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry);
+static int CommEvDNSCacheEntryCheckRelease(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry);
+static int CommEvDNSCacheEvict(EvDNSResolverBase *resolv_base);
+static void CommEvDNSCacheReplyStore(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry, DNSAReply *a_reply, int reply_count);
+static void CommEvDNSCacheReplyFill(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry, DNSAReply *a_reply);
+static void CommEvDNSCacheWaitersNotify(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry, DNSAReply *a_reply, int code);
+
+static EvBaseKQCBH CommEvDNSHedgeTimerEvent;
+static void CommEvDNSCurrentTimeGet(EvDNSResolverBase *resolv_base, struct timeval *current_tv);
+static int CommEvDNSServerListParse(EvDNSResolverBase *resolv_base, char *ip_list_str, unsigned short dns_port);
+static int CommEvDNSServerSelect(EvDNSResolverBase *resolv_base, unsigned int exclude_mask);
+static int CommEvDNSServerFailCountGet(DNSUpstreamServer *upstream_server, struct timeval *current_tv);
+static int CommEvDNSServerFindByAddr(EvDNSResolverBase *resolv_base, struct sockaddr_in *addr);
+static int CommEvDNSServerWrite(EvDNSResolverBase *resolv_base, DNSPendingQuery *pending_query, int server_idx);
+static void CommEvDNSServerTimeout(EvDNSResolverBase *resolv_base, DNSPendingQuery *pending_query);
+static void CommEvDNSServerRTTUpdate(EvDNSResolverBase *resolv_base, int server_idx, int rtt_ms);
+static int CommEvDNSIntCmp(const void *a, const void *b);
+
 static int rfc1035AnswersUnpack(const char *buf, size_t sz, rfc1035_rr **records, unsigned short *id);
 static unsigned short rfc1035BuildAllQuery(const char *hostname, char *buf, size_t *szp, unsigned short qid);
 static unsigned short rfc1035BuildAQuery(const char *hostname, char *buf, size_t *szp, unsigned short qid);
@@ -125,18 +150,37 @@ static int rfc1035MessageUnpack(const char *buf, size_t sz, rfc1035_message ** a
 EvDNSResolverBase *CommEvDNSResolverBaseNew(EvKQBase *ev_base, EvDNSResolverConf *conf)
 {
 	EvDNSResolverBase *resolv_base = calloc(1, sizeof(EvDNSResolverBase));
+	int socket_count;
+	int i;
 
-	/* Create a new UDP socket and set it to non_blocking */
-	resolv_base->socket_fd = EvKQBaseSocketUDPNew(ev_base);
-	EvKQBaseSocketSetNonBlock(ev_base, resolv_base->socket_fd);
+	resolv_base->ev_base						= ev_base;
 
-	/* Set socket description */
-	EvKQBaseFDDescriptionSetByFD(ev_base, resolv_base->socket_fd , "BRB_EV_COMM - DNS resolver UDP client - Port [%u]", htons(conf->dns_port));
+	/* Load upstream server list, first one is kept on dns_serv_addr for compatibility */
+	CommEvDNSServerListParse(resolv_base, conf->dns_ip_str, conf->dns_port);
+	memcpy(&resolv_base->dns_serv_addr, &resolv_base->server.arr[0].addr, sizeof(struct sockaddr_in));
 
-	resolv_base->ev_base						= ev_base;
-	resolv_base->dns_serv_addr.sin_family		= AF_INET;
-	resolv_base->dns_serv_addr.sin_port			= htons(conf->dns_port);
-	resolv_base->dns_serv_addr.sin_addr.s_addr	= inet_addr(conf->dns_ip_str);
+	/* Spread queries over a few source sockets, each one gets its own kernel chosen ephemeral port on first write */
+	socket_count = ((conf->socket_count > 0) ? conf->socket_count : 1);
+	socket_count = ((socket_count > RESOLVER_DNS_SOCKET_MAX) ? RESOLVER_DNS_SOCKET_MAX : socket_count);
+
+	for (i = 0; i < socket_count; i++)
+	{
+		/* Create a new UDP socket and set it to non_blocking */
+		resolv_base->socket.fd_arr[i] = EvKQBaseSocketUDPNew(ev_base);
+
+		/* Failed creating socket, stop here */
+		if (resolv_base->socket.fd_arr[i] < 0)
+			break;
+
+		EvKQBaseSocketSetNonBlock(ev_base, resolv_base->socket.fd_arr[i]);
+
+		/* Set socket description */
+		EvKQBaseFDDescriptionSetByFD(ev_base, resolv_base->socket.fd_arr[i], "BRB_EV_COMM - DNS resolver UDP client [%d/%d] - Port [%u]", (i + 1), socket_count, conf->dns_port);
+		resolv_base->socket.count++;
+	}
+
+	/* First socket also carries WRITE events */
+	resolv_base->socket_fd						= ((resolv_base->socket.count > 0) ? resolv_base->socket.fd_arr[0] : -1);
 
 	resolv_base->retry_count					= conf->retry_count;
 	resolv_base->timeout_ms.lookup				= conf->lookup_timeout_ms;
@@ -150,6 +194,33 @@ EvDNSResolverBase *CommEvDNSResolverBaseNew(EvKQBase *ev_base, EvDNSResolverConf
 	DLinkedListInit(&resolv_base->pending_req.req_list, BRBDATA_THREAD_UNSAFE);
 	DLinkedListInit(&resolv_base->pending_req.reply_list, BRBDATA_THREAD_UNSAFE);
 
+	/* Hedge to a second server after a RTT percentile, unless asked to fan out to all of them */
+	resolv_base->flags.parallel_query			= ((conf->flags.parallel_query && (resolv_base->server.count > 1)) ? 1 : 0);
+	resolv_base->flags.hedge_enabled			= ((!conf->flags.hedge_disabled && !resolv_base->flags.parallel_query && (resolv_base->server.count > 1)) ? 1 : 0);
+	resolv_base->hedge.fixed_ms					= ((conf->hedge_ms > 0) ? conf->hedge_ms : 0);
+	resolv_base->hedge.delay_ms					= ((conf->hedge_ms > 0) ? conf->hedge_ms : (resolv_base->timeout_ms.retry / 2));
+	resolv_base->hedge.timer_id					= -1;
+
+	/* Initialize answer cache, unless upper layer asked us not to */
+	resolv_base->flags.cache_enabled			= (conf->flags.cache_disabled ? 0 : 1);
+	resolv_base->cache.dispatch_timer_id		= -1;
+	resolv_base->cache.max_entries				= ((conf->cache.max_entries > 0) ? conf->cache.max_entries : RESOLVER_DNS_CACHE_MAX_ENTRIES);
+	resolv_base->cache.ttl_max					= ((conf->cache.ttl_max > 0) ? conf->cache.ttl_max : RESOLVER_DNS_CACHE_TTL_MAX);
+	resolv_base->cache.ttl_min					= ((conf->cache.ttl_min > 0) ? conf->cache.ttl_min : RESOLVER_DNS_CACHE_TTL_MIN);
+	resolv_base->cache.negative_ttl				= ((conf->cache.negative_ttl > 0) ? conf->cache.negative_ttl : RESOLVER_DNS_CACHE_NEGATIVE_TTL);
+	resolv_base->cache.stale_sec				= ((conf->cache.stale_sec > 0) ? conf->cache.stale_sec : RESOLVER_DNS_CACHE_STALE_SEC);
+
+	/* MIN clamp can not be above MAX clamp */
+	if (resolv_base->cache.ttl_min > resolv_base->cache.ttl_max)
+		resolv_base->cache.ttl_min				= resolv_base->cache.ttl_max;
+
+	if (resolv_base->flags.cache_enabled)
+	{
+		resolv_base->cache.table				= AssocArrayNew(BRBDATA_THREAD_UNSAFE, resolv_base->cache.max_entries, NULL);
+		DLinkedListInit(&resolv_base->cache.lru_list, BRBDATA_THREAD_UNSAFE);
+		DLinkedListInit(&resolv_base->cache.hit_list, BRBDATA_THREAD_UNSAFE);
+	}
+
 	/* Initialize periodic timer */
 	resolv_base->timer_id 	= EvKQBaseTimerAdd(resolv_base->ev_base, COMM_ACTION_ADD_VOLATILE, (resolv_base->timeout_ms.retry / 2), CommEvDNSPeriodicTimerEvent, resolv_base);
 
@@ -158,14 +229,42 @@ EvDNSResolverBase *CommEvDNSResolverBaseNew(EvKQBase *ev_base, EvDNSResolverConf
 /**************************************************************************************************************************/
 void CommEvDNSResolverBaseDestroy(EvDNSResolverBase *resolv_base)
 {
+	DNSCacheEntry *cache_entry;
+	int i;
+
 	/* Sanity check */
 	if (!resolv_base)
 		return;
 
-	if (resolv_base->socket_fd > -1)
+	/* Close all source sockets */
+	for (i = 0; i < resolv_base->socket.count; i++)
+		EvKQBaseSocketClose(resolv_base->ev_base, resolv_base->socket.fd_arr[i]);
+
+	resolv_base->socket.count	= 0;
+	resolv_base->socket_fd		= -1;
+
+	/* Drop pending hedge check */
+	if (resolv_base->hedge.timer_id > -1)
+	{
+		EvKQBaseTimerCtl(resolv_base->ev_base, resolv_base->hedge.timer_id, COMM_ACTION_DELETE);
+		resolv_base->hedge.timer_id = -1;
+	}
+
+	/* Drop pending cache dispatch */
+	if (resolv_base->cache.dispatch_timer_id > -1)
 	{
-		EvKQBaseSocketClose(resolv_base->ev_base, resolv_base->socket_fd);
-		resolv_base->socket_fd = -1;
+		EvKQBaseTimerCtl(resolv_base->ev_base, resolv_base->cache.dispatch_timer_id, COMM_ACTION_DELETE);
+		resolv_base->cache.dispatch_timer_id = -1;
+	}
+
+	/* Destroy answer cache */
+	if (resolv_base->cache.table)
+	{
+		while ((cache_entry = DLinkedListPopHead(&resolv_base->cache.lru_list)))
+			free(cache_entry);
+
+		AssocArrayDestroy(resolv_base->cache.table);
+		resolv_base->cache.table = NULL;
 	}
 
 	SlotQueueDestroy(&resolv_base->pending_req.slots);
@@ -183,93 +282,116 @@ int CommEvDNSGetHostByName(EvDNSResolverBase *resolv_base, char *host, CommEvDNS
 /**************************************************************************************************************************/
 int CommEvDNSGetHostByNameX(EvDNSResolverBase *resolv_base, char *host, CommEvDNSResolverCBH *cb_handler, void *cb_data, int query_x)
 {
-	struct timeval *current_time_ptr;
-	struct timeval current_time;
-	int slot_id;
+	char key_str[RESOLVER_DNS_CACHE_KEY_SZ];
+	DNSPendingQuery *refresh_query;
+	DNSCacheEntry *cache_entry;
+	long now_ts;
 
 	DNSPendingQuery *pending_query	= NULL;
 
-	/* Must have a notification handler */
-	if (!cb_handler)
+	/* Must have a notification handler, and somewhere to send the query to */
+	if ((!cb_handler) || (resolv_base->server.count <= 0) || (resolv_base->socket.count <= 0))
 	{
 		/* Touch base statistics */
 		resolv_base->stats.request_failed++;
 		return -1;
 	}
 
-	slot_id = SlotQueueGrab(&resolv_base->pending_req.slots);
+	/* Grab a new pending query - Its SLOT_ID is the REQ_ID upper layers hold, even if the answer comes from cache */
+	pending_query = CommEvDNSPendingQueryGrab(resolv_base, cb_handler, cb_data);
 
 	/* No more slots left, bail out */
-	if (slot_id < 0)
+	if (!pending_query)
 	{
 		/* Touch base statistics */
 		resolv_base->stats.request_failed++;
 		return -1;
 	}
 
-	pending_query 						= MemArenaGrabByID(resolv_base->pending_req.arena, slot_id);
+	/* Cache disabled or HOSTNAME can not be used as key, go straight to the wire */
+	if ((!resolv_base->flags.cache_enabled) || (!CommEvDNSCacheKeyBuild(host, query_x, (char*)&key_str, sizeof(key_str))))
+		goto transmit;
 
-	/* FATAL: Already in use, bail out */
-	assert(!pending_query->flags.in_use);
+	now_ts		= CommEvDNSCacheNowGet(resolv_base);
+	cache_entry	= AssocArrayLookup(resolv_base->cache.table, (char*)&key_str);
 
-	/* Clean query info */
-	memset(pending_query, 0, sizeof(DNSPendingQuery));
+	/* Answer inside TTL or inside STALE window - Deliver it on next IO loop, upper layers do not expect CB_H from inside this call */
+	if ((cache_entry) && (cache_entry->flags.valid) && (now_ts < cache_entry->stale_ts))
+	{
+		/* Touch base statistics */
+		resolv_base->stats.cache_hit++;
 
-	/* Mark as in use */
-	pending_query->flags.in_use			= 1;
+		if (cache_entry->flags.negative)
+			resolv_base->stats.cache_hit_negative++;
 
-	/* Finish event cb_hanler and data */
-	pending_query->events.cb_handler	= cb_handler;
-	pending_query->events.cb_data		= cb_data;
-	pending_query->slot_id				= slot_id;
+		/* TTL expired but still inside STALE window - Serve it, and revalidate on background if nobody is doing it already */
+		if (now_ts >= cache_entry->expire_ts)
+		{
+			resolv_base->stats.cache_hit_stale++;
 
-	/* Get current TIMESTAMP only if its not inside ev_base */
-	if (0 == resolv_base->ev_base->stats.cur_invoke_tv.tv_sec)
-	{
-		gettimeofday(&current_time, NULL);
-		current_time_ptr 				= &current_time;
-	}
-	else
-		current_time_ptr 				= &resolv_base->ev_base->stats.cur_invoke_tv;
+			if ((cache_entry->inflight_id < 0) && (refresh_query = CommEvDNSPendingQueryGrab(resolv_base, NULL, NULL)))
+			{
+				KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "SLOT_ID [%d] - Refreshing STALE [%s]\n", refresh_query->slot_id, cache_entry->key_str);
 
-	KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "SLOT_ID [%d] - Will resolve [%s]\n", slot_id, host);
+				/* Refresh query leads the lookup, with no CB_H of its own */
+				refresh_query->cache_entry	= cache_entry;
+				cache_entry->inflight_id	= refresh_query->slot_id;
 
-	/* Save sent time */
-	memcpy(&pending_query->transmit_tv, current_time_ptr, sizeof(struct timeval));
-	memcpy(&pending_query->retransmit_tv, current_time_ptr, sizeof(struct timeval));
+				CommEvDNSPendingQueryTransmit(resolv_base, refresh_query, host, query_x);
+				resolv_base->stats.cache_refresh++;
+			}
+		}
 
-	/* Build 1035 packet */
-	if (query_x > 0)
-		rfc1035BuildAAAAQuery(host, (char*)&pending_query->rfc1035_request, (size_t*)&pending_query->rfc1035_request_sz, pending_query->slot_id);
-	else
-		rfc1035BuildAQuery(host, (char*)&pending_query->rfc1035_request, (size_t*)&pending_query->rfc1035_request_sz, pending_query->slot_id);
+		/* Hold entry while we are on HIT list */
+		pending_query->cache_entry		= cache_entry;
+		pending_query->flags.cache_hit	= 1;
+		cache_entry->ref_count++;
 
-	/* Enqueue for writing */
-	DLinkedListAddTail(&resolv_base->pending_req.req_list, &pending_query->node, pending_query);
+		/* Touch LRU and enqueue for dispatch */
+		DLinkedListMoveToTail(&resolv_base->cache.lru_list, &cache_entry->node);
+		DLinkedListAddTail(&resolv_base->cache.hit_list, &pending_query->node, pending_query);
 
-	/* Set write event for socket */
-	EvKQBaseSetEvent(resolv_base->ev_base, resolv_base->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvDNSWriteEvent, resolv_base);
+		/* Schedule dispatch timer */
+		if (resolv_base->cache.dispatch_timer_id < 0)
+			resolv_base->cache.dispatch_timer_id = EvKQBaseTimerAdd(resolv_base->ev_base, COMM_ACTION_ADD_VOLATILE, RESOLVER_DNS_CACHE_DISPATCH_MS, CommEvDNSCacheDispatchTimerEvent, resolv_base);
 
-	/* If there is ENQUEUED data, schedule WRITE event and LEAVE, as we need to PRESERVE WRITE ORDER */
-	if (!DLINKED_LIST_PTR_ISEMPTY(&resolv_base->pending_req.reply_list))
-	{
-		/* Set write event for socket */
-		EvKQBaseSetEvent(resolv_base->ev_base, resolv_base->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvDNSWriteEvent, resolv_base);
+		return pending_query->slot_id;
 	}
-	/* Try to write on this very same IO LOOP */
-	else
+
+	/* Same NAME and TYPE already on the wire - Wait for its answer instead of sending a new query */
+	if ((cache_entry) && (cache_entry->inflight_id > -1))
 	{
-		CommEvDNSWriteEvent(resolv_base->socket_fd, 8092, -1, resolv_base, resolv_base->ev_base);
+		KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "SLOT_ID [%d] - Coalesced [%s] into SLOT_ID [%d]\n",
+				pending_query->slot_id, cache_entry->key_str, cache_entry->inflight_id);
+
+		/* Touch base statistics */
+		resolv_base->stats.cache_coalesced++;
+
+		pending_query->cache_entry		= cache_entry;
+		pending_query->flags.coalesced	= 1;
+		DLinkedListAddTail(&cache_entry->waiter_list, &pending_query->node, pending_query);
+
+		return pending_query->slot_id;
 	}
 
 	/* Touch base statistics */
-	resolv_base->stats.request_sent_sched++;
+	resolv_base->stats.cache_miss++;
 
-	/* Initialize periodic timer */
-	if (resolv_base->timer_id < 0)
-		resolv_base->timer_id 			= EvKQBaseTimerAdd(resolv_base->ev_base, COMM_ACTION_ADD_VOLATILE, (resolv_base->timeout_ms.retry / 2), CommEvDNSPeriodicTimerEvent, resolv_base);
+	/* Create entry for this NAME and TYPE - If cache is full of busy entries, just go to the wire without it */
+	if (!cache_entry)
+		cache_entry = CommEvDNSCacheEntryNew(resolv_base, (char*)&key_str);
 
-	return slot_id;
+	/* We lead this lookup, anyone asking the same while we are on the wire will wait for us */
+	if (cache_entry)
+	{
+		pending_query->cache_entry		= cache_entry;
+		cache_entry->inflight_id		= pending_query->slot_id;
+	}
+
+	transmit:
+
+	CommEvDNSPendingQueryTransmit(resolv_base, pending_query, host, query_x);
+	return pending_query->slot_id;
 }
 /**************************************************************************************************************************/
 int CommEvDNSCheckIfNeedDNSLookup(char *host_ptr)
@@ -358,6 +480,7 @@ int CommEvDNSDataCancelAndClean(EvDNSReplyHandler *dnsdata)
 int CommEvDNSCancelPendingRequest(EvDNSResolverBase *resolv_base, int req_id)
 {
 	DNSPendingQuery *pending_query;
+	DNSCacheEntry *cache_entry;
 
 	/* sanitize */
 	if (!resolv_base)
@@ -374,9 +497,32 @@ int CommEvDNSCancelPendingRequest(EvDNSResolverBase *resolv_base, int req_id)
 
 	KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "SLOT_ID [%d] - WAITING_REPLY [%d]\n", pending_query->slot_id, pending_query->flags.waiting_reply);
 
+	cache_entry			= pending_query->cache_entry;
+
 	/* There are two conditions to be addressed here: if we are not waiting for reply, just wipe the pending request out. Otherwise, mark it as canceled, and release
-	 * the slot once we see a reply, or if we try to RXMIT */
-	if (pending_query->flags.waiting_reply)
+	 * the slot once we see a reply, or if we try to RXMIT. Requests being dispatched right now will be released by the dispatcher */
+	if ((pending_query->flags.waiting_reply) || (pending_query->flags.dispatching))
+	{
+		/* Mark it as canceled */
+		pending_query->flags.canceled_req = 1;
+	}
+	/* Waiting for a cached answer dispatch */
+	else if (pending_query->flags.cache_hit)
+	{
+		DLinkedListDelete(&resolv_base->cache.hit_list, &pending_query->node);
+		cache_entry->ref_count--;
+
+		CommEvDNSPendingQueryRelease(resolv_base, pending_query);
+		CommEvDNSCacheEntryCheckRelease(resolv_base, cache_entry);
+	}
+	/* Waiting for another query answer */
+	else if (pending_query->flags.coalesced)
+	{
+		DLinkedListDelete(&cache_entry->waiter_list, &pending_query->node);
+		CommEvDNSPendingQueryRelease(resolv_base, pending_query);
+	}
+	/* Leading a lookup others are waiting for, keep it going without notifying us */
+	else if ((cache_entry) && (!DLINKED_LIST_ISEMPTY(cache_entry->waiter_list)))
 	{
 		/* Mark it as canceled */
 		pending_query->flags.canceled_req = 1;
@@ -384,16 +530,45 @@ int CommEvDNSCancelPendingRequest(EvDNSResolverBase *resolv_base, int req_id)
 	else
 	{
 		/* Free slot and delete from pending list */
-		SlotQueueFree(&resolv_base->pending_req.slots, pending_query->slot_id);
 		DLinkedListDelete(&resolv_base->pending_req.req_list, &pending_query->node);
+		CommEvDNSPendingQueryRelease(resolv_base, pending_query);
 
-		/* Clean array slot */
-		memset(pending_query, 0, sizeof(DNSPendingQuery));
+		/* Nobody leading this entry anymore */
+		if ((cache_entry) && (cache_entry->inflight_id == req_id))
+		{
+			cache_entry->inflight_id = -1;
+			CommEvDNSCacheEntryCheckRelease(resolv_base, cache_entry);
+		}
 	}
 
 	return 1;
 }
 /**************************************************************************************************************************/
+int CommEvDNSCacheFlush(EvDNSResolverBase *resolv_base)
+{
+	DLinkedListNode *node;
+	DNSCacheEntry *cache_entry;
+	int flush_count = 0;
+
+	/* Sanity check */
+	if ((!resolv_base) || (!resolv_base->cache.table))
+		return 0;
+
+	for (node = resolv_base->cache.lru_list.head; node; )
+	{
+		cache_entry	= node->data;
+		node		= node->next;
+
+		/* Invalidate answer, busy entries will be released once the last user leaves */
+		cache_entry->flags.valid = 0;
+
+		flush_count += CommEvDNSCacheEntryCheckRelease(resolv_base, cache_entry);
+		continue;
+	}
+
+	return flush_count;
+}
+/**************************************************************************************************************************/
 /**/
 /**/
 /**************************************************************************************************************************/
@@ -401,6 +576,7 @@ static int CommEvDNSPeriodicTimerEvent(int fd, int can_write_sz, int thrd_id, vo
 {
 	DLinkedListNode *node;
 	DNSPendingQuery *pending_query;
+	DNSCacheEntry *cache_entry;
 	DNSAReply a_reply;
 	int total_delta_ms;
 	int rxmit_delta_ms;
@@ -451,6 +627,9 @@ static int CommEvDNSPeriodicTimerEvent(int fd, int can_write_sz, int thrd_id, vo
 				/* Touch rxmit_timestamp */
 				memcpy(&pending_query->retransmit_tv,  &resolv_base->ev_base->stats.cur_invoke_tv, sizeof(struct timeval));
 
+				/* Penalize silent server, and fail over to the best one we have not tried yet */
+				CommEvDNSServerTimeout(resolv_base, pending_query);
+
 				/* Move it to pending reply list and increment sent request count */
 				DLinkedListDelete(&resolv_base->pending_req.reply_list, &pending_query->node);
 				DLinkedListAddTail(&resolv_base->pending_req.req_list, &pending_query->node, pending_query);
@@ -475,24 +654,37 @@ static int CommEvDNSPeriodicTimerEvent(int fd, int can_write_sz, int thrd_id, vo
 
 		resolv_base->stats.request_timeout++;
 
+		/* Penalize silent server */
+		CommEvDNSServerTimeout(resolv_base, pending_query);
+
 		/* Clean buffers */
 		memset(&a_reply, 0, sizeof(DNSAReply));
 
+		/* Stop leading cache entry, timeouts are never cached */
+		cache_entry = pending_query->cache_entry;
+
+		if ((cache_entry) && (cache_entry->inflight_id == pending_query->slot_id))
+			cache_entry->inflight_id = -1;
+
 		/* Invoke CB_HANDLER with zero reply */
 		if ((pending_query->events.cb_handler) && (!pending_query->flags.canceled_req))
 			pending_query->events.cb_handler(resolv_base, pending_query->events.cb_data, (void*)&a_reply, DNS_REPLY_TIMEDOUT);
 
+		/* Anyone coalesced into us times out too */
+		if (cache_entry)
+		{
+			CommEvDNSCacheWaitersNotify(resolv_base, cache_entry, &a_reply, DNS_REPLY_TIMEDOUT);
+			CommEvDNSCacheEntryCheckRelease(resolv_base, cache_entry);
+		}
+
 		/* Point to next node */
 		node = node->next;
 
 		KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "TIMED_OUT REQ_ID [%d] - TOTAL [%d/%d]\n", pending_query->slot_id, pending_query->req_count, resolv_base->retry_count);
 
 		/* Free slot and remove node from list */
-		SlotQueueFree(&resolv_base->pending_req.slots, pending_query->slot_id);
 		DLinkedListDelete(&resolv_base->pending_req.reply_list, &pending_query->node);
-
-		/* Clean pending request */
-		memset(pending_query, 0, sizeof(DNSPendingQuery));
+		CommEvDNSPendingQueryRelease(resolv_base, pending_query);
 
 		goto loop_without_move;
 	}
@@ -510,7 +702,9 @@ static int CommEvDNSPeriodicTimerEvent(int fd, int can_write_sz, int thrd_id, vo
 static int CommEvDNSWriteEvent(int fd, int can_write_sz, int thrd_id, void *cb_data, void *base_ptr)
 {
 	DNSPendingQuery *pending_query;
-	DNSPendingQuery *next_pending_query;
+	int target_count;
+	int sent_count;
+	int i;
 
 	EvDNSResolverBase *resolv_base	= cb_data;
 	int wrote_bytes 				= 0;
@@ -526,16 +720,16 @@ static int CommEvDNSWriteEvent(int fd, int can_write_sz, int thrd_id, void *cb_d
 		if (!pending_query)
 		{
 			KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FINISH LIST - Wrote [%d] requests\n", total_req_sent);
-
-			/* Set read event for socket */
-			EvKQBaseSetEvent(resolv_base->ev_base, resolv_base->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvDNSDataEvent, resolv_base);
 			return total_wrote_bytes;
 		}
 
 		assert(!pending_query->flags.waiting_reply);
 
+		/* First transmission of a PARALLEL query goes to every server, anything else goes to selected target */
+		target_count = (((resolv_base->flags.parallel_query) && (0 == pending_query->upstream.sent_mask)) ? resolv_base->server.count : 1);
+
 		/* Unable to write next request, leave */
-		if ( (pending_query->rfc1035_request_sz + wrote_bytes + 1) > can_write_sz)
+		if (((pending_query->rfc1035_request_sz * target_count) + total_wrote_bytes + 1) > can_write_sz)
 		{
 			/* Enqueue request back for next IO loop */
 			DLinkedListAdd(&resolv_base->pending_req.req_list, &pending_query->node, pending_query);
@@ -543,14 +737,17 @@ static int CommEvDNSWriteEvent(int fd, int can_write_sz, int thrd_id, void *cb_d
 			goto leave;
 		}
 
-		/* Write DNS query */
-		wrote_bytes = sendto(resolv_base->socket_fd, (char*)&pending_query->rfc1035_request, pending_query->rfc1035_request_sz, 0,
-				(struct sockaddr *)&resolv_base->dns_serv_addr, sizeof(struct sockaddr_in));
+		/* Write DNS query, from its own source socket */
+		for (sent_count = 0, i = 0; i < target_count; i++)
+		{
+			if (CommEvDNSServerWrite(resolv_base, pending_query, ((target_count > 1) ? i : pending_query->upstream.target_idx)) > 0)
+				sent_count++;
 
-		KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "WROTE [%d] bytes\n", wrote_bytes);
+			continue;
+		}
 
 		/* Failed writing, enqueue it back and bail out */
-		if (wrote_bytes < pending_query->rfc1035_request_sz)
+		if (sent_count <= 0)
 		{
 			KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "Failed writing\n");
 
@@ -563,6 +760,8 @@ static int CommEvDNSWriteEvent(int fd, int can_write_sz, int thrd_id, void *cb_d
 			goto leave;
 		}
 
+		wrote_bytes = (pending_query->rfc1035_request_sz * sent_count);
+
 		total_req_sent++;
 		total_wrote_bytes += wrote_bytes;
 
@@ -571,21 +770,29 @@ static int CommEvDNSWriteEvent(int fd, int can_write_sz, int thrd_id, void *cb_d
 		resolv_base->stats.total_bytes_sent += wrote_bytes;
 
 		/* Move it to pending reply list and increment sent request count */
-		DLinkedListDelete(&resolv_base->pending_req.req_list, &pending_query->node);
 		DLinkedListAddTail(&resolv_base->pending_req.reply_list, &pending_query->node, pending_query);
-		pending_query->req_count++;
+
+		/* HEDGE writes do not spend RETRY budget */
+		if (pending_query->flags.hedge_xmit)
+		{
+			pending_query->flags.hedge_xmit = 0;
+			pending_query->hedge_count++;
+		}
+		else
+			pending_query->req_count++;
 
 		/* Set as waiting for reply - On reply_list */
 		pending_query->flags.waiting_reply = 1;
 
+		/* Schedule HEDGE check */
+		if ((resolv_base->flags.hedge_enabled) && (!pending_query->flags.hedged) && (resolv_base->hedge.timer_id < 0))
+			resolv_base->hedge.timer_id = EvKQBaseTimerAdd(resolv_base->ev_base, COMM_ACTION_ADD_VOLATILE, resolv_base->hedge.delay_ms, CommEvDNSHedgeTimerEvent, resolv_base);
+
 		continue;
 	}
 
 	leave:
 
-	/* Set read event for socket */
-	EvKQBaseSetEvent(resolv_base->ev_base, resolv_base->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvDNSDataEvent, resolv_base);
-
 	/* Reschedule WRITE event */
 	EvKQBaseSetEvent(resolv_base->ev_base, resolv_base->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvDNSWriteEvent, resolv_base);
 
@@ -597,8 +804,13 @@ static int CommEvDNSWriteEvent(int fd, int can_write_sz, int thrd_id, void *cb_d
 static int CommEvDNSDataEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
 {
 	DNSPendingQuery *pending_query;
+	DNSCacheEntry *cache_entry;
 	rfc1035_rr *answers = NULL;
+	struct sockaddr_in from_addr;
+	struct timeval current_tv;
+	socklen_t from_addr_sz;
 	DNSAReply a_reply;
+	int server_idx;
 
 	char rfc1053_reply[to_read_sz + 16];
 	int data_read;
@@ -622,7 +834,8 @@ static int CommEvDNSDataEvent(int fd, int to_read_sz, int thrd_id, void *cb_data
 //		goto next_packet;
 
 	/* Read UDP data from socket */
-	data_read 						= recv(fd, (void*)&rfc1053_reply, to_read_sz, 0);
+	from_addr_sz					= sizeof(struct sockaddr_in);
+	data_read 						= recvfrom(fd, (void*)&rfc1053_reply, to_read_sz, 0, (struct sockaddr *)&from_addr, &from_addr_sz);
 
 	KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] READ [%d]/[%d] bytes\n", fd, data_read, to_read_sz);
 
@@ -634,6 +847,17 @@ static int CommEvDNSDataEvent(int fd, int to_read_sz, int thrd_id, void *cb_data
 	resolv_base->stats.reply_received_total++;
 	resolv_base->stats.total_bytes_received += data_read;
 
+	/* Only listen to servers we know about */
+	server_idx				= CommEvDNSServerFindByAddr(resolv_base, &from_addr);
+
+	if (server_idx < 0)
+	{
+		KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Reply from unknown server [%s:%u]\n", fd, inet_ntoa(from_addr.sin_addr), ntohs(from_addr.sin_port));
+
+		resolv_base->stats.reply_unmatched++;
+		goto next_packet;
+	}
+
 	/* Parse DNS reply */
 	reply_count 			= rfc1035AnswersUnpack((const char*)&rfc1053_reply, data_read, &answers, &reply_seq_id);
 
@@ -646,13 +870,29 @@ static int CommEvDNSDataEvent(int fd, int to_read_sz, int thrd_id, void *cb_data
 
 //	assert(pending_query->flags.in_use);
 
-	/* Unexpected reply */
-	if (!pending_query->flags.in_use)
+	/* Unexpected reply - Requests answered by cache never went to the wire, and SLOT_ID alone may match a late reply for a previous
+	 * query on the same SLOT. It must come from a server we sent it to, and echo back the exact question we asked */
+	if ((!pending_query->flags.in_use) || (pending_query->flags.cache_hit) || (pending_query->flags.coalesced) ||
+			(!(pending_query->upstream.sent_mask & (1 << server_idx))) || (data_read < pending_query->rfc1035_request_sz) ||
+			(memcmp(((char*)&rfc1053_reply + 12), ((char*)&pending_query->rfc1035_request + 12), (pending_query->rfc1035_request_sz - 12))))
 	{
 		KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_WARNING, LOGCOLOR_GREEN, "Unexpected reply for REQ_ID [%d]\n", reply_seq_id);
+
+		resolv_base->stats.reply_unmatched++;
 		goto next_packet;
 	}
 
+	/* Retransmitted queries give ambiguous RTT samples, skip them */
+	if (!pending_query->flags.re_xmit)
+	{
+		CommEvDNSCurrentTimeGet(resolv_base, &current_tv);
+		CommEvDNSServerRTTUpdate(resolv_base, server_idx, CommEvDNStvSubMsec(&pending_query->upstream.sent_tv[server_idx], &current_tv));
+	}
+
+	/* Server is alive */
+	resolv_base->server.arr[server_idx].fail_count = 0;
+	resolv_base->server.arr[server_idx].stats.reply_received++;
+
 	/* Negative replies means error */
 	if (reply_count < 0)
 	{
@@ -690,14 +930,29 @@ static int CommEvDNSDataEvent(int fd, int to_read_sz, int thrd_id, void *cb_data
 
 	failed_invoke:
 
+	cache_entry = pending_query->cache_entry;
+
+	/* We lead this cache entry, save answer before anyone sees it */
+	if ((cache_entry) && (cache_entry->inflight_id == pending_query->slot_id))
+	{
+		cache_entry->inflight_id = -1;
+		CommEvDNSCacheReplyStore(resolv_base, cache_entry, &a_reply, reply_count);
+	}
+
 	/* Invoke CB_HANDLER */
 	if ((pending_query->events.cb_handler) && (!pending_query->flags.canceled_req))
 		pending_query->events.cb_handler(resolv_base, pending_query->events.cb_data, (void*)&a_reply, DNS_REPLY_SUCCESS);
 
-	/* Release pending query */
-	SlotQueueFree(&resolv_base->pending_req.slots, pending_query->slot_id);
-	DLinkedListDelete(&resolv_base->pending_req.reply_list, &pending_query->node);
-	memset(pending_query, 0, sizeof(DNSPendingQuery));
+	/* Hand the same answer to anyone coalesced into us */
+	if (cache_entry)
+	{
+		CommEvDNSCacheWaitersNotify(resolv_base, cache_entry, &a_reply, DNS_REPLY_SUCCESS);
+		CommEvDNSCacheEntryCheckRelease(resolv_base, cache_entry);
+	}
+
+	/* Release pending query - A hedged or retransmitted query may still be waiting on write list */
+	DLinkedListDelete((pending_query->flags.waiting_reply ? &resolv_base->pending_req.reply_list : &resolv_base->pending_req.req_list), &pending_query->node);
+	CommEvDNSPendingQueryRelease(resolv_base, pending_query);
 
 	next_packet:
 
@@ -716,6 +971,624 @@ static int CommEvDNStvSubMsec(struct timeval *t1, struct timeval *t2)
 	return (t2->tv_sec - t1->tv_sec) * 1000 +	(t2->tv_usec - t1->tv_usec) / 1000;
 }
 /**************************************************************************************************************************/
+static int CommEvDNSCacheDispatchTimerEvent(int fd, int can_write_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	DNSPendingQuery *pending_query;
+	DNSCacheEntry *cache_entry;
+	DNSAReply a_reply;
+	int dispatch_count;
+
+	EvDNSResolverBase *resolv_base	= cb_data;
+
+	/* Anything enqueued from now on will schedule a new timer */
+	resolv_base->cache.dispatch_timer_id = -1;
+
+	/* Dispatch only what is on HIT list now, so CB_H asking for the same NAME again can not keep us here forever */
+	for (dispatch_count = resolv_base->cache.hit_list.size; dispatch_count > 0; dispatch_count--)
+	{
+		pending_query = DLinkedListPopHead(&resolv_base->cache.hit_list);
+
+		/* Drained */
+		if (!pending_query)
+			break;
+
+		cache_entry = pending_query->cache_entry;
+
+		/* Load answer with remaining TTL */
+		CommEvDNSCacheReplyFill(resolv_base, cache_entry, &a_reply);
+
+		/* Invoke CB_HANDLER */
+		pending_query->flags.dispatching = 1;
+
+		if ((pending_query->events.cb_handler) && (!pending_query->flags.canceled_req))
+			pending_query->events.cb_handler(resolv_base, pending_query->events.cb_data, (void*)&a_reply, DNS_REPLY_SUCCESS);
+
+		/* Release entry and pending query */
+		cache_entry->ref_count--;
+		CommEvDNSPendingQueryRelease(resolv_base, pending_query);
+		CommEvDNSCacheEntryCheckRelease(resolv_base, cache_entry);
+		continue;
+	}
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static DNSPendingQuery *CommEvDNSPendingQueryGrab(EvDNSResolverBase *resolv_base, CommEvDNSResolverCBH *cb_handler, void *cb_data)
+{
+	DNSPendingQuery *pending_query;
+	int slot_id;
+
+	slot_id = SlotQueueGrab(&resolv_base->pending_req.slots);
+
+	/* No more slots left, bail out */
+	if (slot_id < 0)
+		return NULL;
+
+	pending_query 						= MemArenaGrabByID(resolv_base->pending_req.arena, slot_id);
+
+	/* FATAL: Already in use, bail out */
+	assert(!pending_query->flags.in_use);
+
+	/* Clean query info */
+	memset(pending_query, 0, sizeof(DNSPendingQuery));
+
+	/* Mark as in use */
+	pending_query->flags.in_use			= 1;
+
+	/* Finish event cb_hanler and data */
+	pending_query->events.cb_handler	= cb_handler;
+	pending_query->events.cb_data		= cb_data;
+	pending_query->slot_id				= slot_id;
+
+	/* Pick source socket by SLOT_ID and best upstream server */
+	pending_query->upstream.socket_fd	= resolv_base->socket.fd_arr[slot_id % resolv_base->socket.count];
+	pending_query->upstream.target_idx	= CommEvDNSServerSelect(resolv_base, 0);
+
+	/* Save sent time */
+	CommEvDNSCurrentTimeGet(resolv_base, &pending_query->transmit_tv);
+	memcpy(&pending_query->retransmit_tv, &pending_query->transmit_tv, sizeof(struct timeval));
+
+	return pending_query;
+}
+/**************************************************************************************************************************/
+static void CommEvDNSPendingQueryRelease(EvDNSResolverBase *resolv_base, DNSPendingQuery *pending_query)
+{
+	/* Free slot and clean array slot - Caller MUST have removed it from any list */
+	SlotQueueFree(&resolv_base->pending_req.slots, pending_query->slot_id);
+	memset(pending_query, 0, sizeof(DNSPendingQuery));
+
+	return;
+}
+/**************************************************************************************************************************/
+static void CommEvDNSPendingQueryTransmit(EvDNSResolverBase *resolv_base, DNSPendingQuery *pending_query, char *host, int query_x)
+{
+	KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "SLOT_ID [%d] - Will resolve [%s]\n", pending_query->slot_id, host);
+
+	/* Build 1035 packet */
+	if (query_x > 0)
+		rfc1035BuildAAAAQuery(host, (char*)&pending_query->rfc1035_request, (size_t*)&pending_query->rfc1035_request_sz, pending_query->slot_id);
+	else
+		rfc1035BuildAQuery(host, (char*)&pending_query->rfc1035_request, (size_t*)&pending_query->rfc1035_request_sz, pending_query->slot_id);
+
+	/* Enqueue for writing */
+	DLinkedListAddTail(&resolv_base->pending_req.req_list, &pending_query->node, pending_query);
+
+	/* Set write event for socket */
+	EvKQBaseSetEvent(resolv_base->ev_base, resolv_base->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvDNSWriteEvent, resolv_base);
+
+	/* If there is ENQUEUED data, schedule WRITE event and LEAVE, as we need to PRESERVE WRITE ORDER */
+	if (!DLINKED_LIST_PTR_ISEMPTY(&resolv_base->pending_req.reply_list))
+	{
+		/* Set write event for socket */
+		EvKQBaseSetEvent(resolv_base->ev_base, resolv_base->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvDNSWriteEvent, resolv_base);
+	}
+	/* Try to write on this very same IO LOOP */
+	else
+	{
+		CommEvDNSWriteEvent(resolv_base->socket_fd, 8092, -1, resolv_base, resolv_base->ev_base);
+	}
+
+	/* Touch base statistics */
+	resolv_base->stats.request_sent_sched++;
+
+	/* Initialize periodic timer */
+	if (resolv_base->timer_id < 0)
+		resolv_base->timer_id 			= EvKQBaseTimerAdd(resolv_base->ev_base, COMM_ACTION_ADD_VOLATILE, (resolv_base->timeout_ms.retry / 2), CommEvDNSPeriodicTimerEvent, resolv_base);
+
+	return;
+}
+/**************************************************************************************************************************/
+static long CommEvDNSCacheNowGet(EvDNSResolverBase *resolv_base)
+{
+	/* Get current TIMESTAMP only if its not inside ev_base */
+	if (0 == resolv_base->ev_base->stats.cur_invoke_ts_sec)
+		return time(NULL);
+
+	return resolv_base->ev_base->stats.cur_invoke_ts_sec;
+}
+/**************************************************************************************************************************/
+static int CommEvDNSCacheKeyBuild(char *host, int query_x, char *key_str, int key_sz)
+{
+	int host_sz;
+	int i;
+
+	/* Sanity check */
+	if (!host)
+		return 0;
+
+	host_sz = strlen(host);
+
+	/* Ignore trailing dot, so FQDN and relative forms share the same entry */
+	if ((host_sz > 0) && ('.' == host[host_sz - 1]))
+		host_sz--;
+
+	/* Can not be a DNS name */
+	if ((host_sz <= 0) || (host_sz >= RFC1035_MAXHOSTNAMESZ) || ((host_sz + 8) > key_sz))
+		return 0;
+
+	/* Names are case insensitive */
+	for (i = 0; i < host_sz; i++)
+		key_str[i] = tolower(host[i]);
+
+	/* Append query TYPE */
+	snprintf((key_str + host_sz), (key_sz - host_sz), "/%s", ((query_x > 0) ? "AAAA" : "A"));
+	return 1;
+}
+/**************************************************************************************************************************/
+static DNSCacheEntry *CommEvDNSCacheEntryNew(EvDNSResolverBase *resolv_base, char *key_str)
+{
+	DNSCacheEntry *cache_entry;
+
+	/* Cache is full, try to make room */
+	if ((resolv_base->cache.lru_list.size >= resolv_base->cache.max_entries) && (!CommEvDNSCacheEvict(resolv_base)))
+		return NULL;
+
+	cache_entry					= calloc(1, sizeof(DNSCacheEntry));
+
+	/* Failed allocating, go to the wire without cache */
+	if (!cache_entry)
+		return NULL;
+
+	cache_entry->inflight_id	= -1;
+
+	strlcpy((char*)&cache_entry->key_str, key_str, sizeof(cache_entry->key_str));
+	DLinkedListInit(&cache_entry->waiter_list, BRBDATA_THREAD_UNSAFE);
+
+	/* Index it and add to LRU tail */
+	AssocArrayAdd(resolv_base->cache.table, (char*)&cache_entry->key_str, cache_entry);
+	DLinkedListAddTail(&resolv_base->cache.lru_list, &cache_entry->node, cache_entry);
+
+	return cache_entry;
+}
+/**************************************************************************************************************************/
+static void CommEvDNSCacheEntryDestroy(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry)
+{
+	/* Remove from index and LRU */
+	AssocArrayDelete(resolv_base->cache.table, (char*)&cache_entry->key_str);
+	DLinkedListDelete(&resolv_base->cache.lru_list, &cache_entry->node);
+
+	free(cache_entry);
+	return;
+}
+/**************************************************************************************************************************/
+static int CommEvDNSCacheEntryCheckRelease(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry)
+{
+	/* Still has an answer, or someone is still using it */
+	if ((cache_entry->flags.valid) || (cache_entry->inflight_id > -1) || (cache_entry->ref_count > 0) || (!DLINKED_LIST_ISEMPTY(cache_entry->waiter_list)))
+		return 0;
+
+	CommEvDNSCacheEntryDestroy(resolv_base, cache_entry);
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvDNSCacheEvict(EvDNSResolverBase *resolv_base)
+{
+	DLinkedListNode *node;
+	DNSCacheEntry *cache_entry;
+
+	/* Walk from least recently used, and drop first entry nobody is using */
+	for (node = resolv_base->cache.lru_list.head; node; node = node->next)
+	{
+		cache_entry = node->data;
+
+		/* Busy, skip it */
+		if ((cache_entry->inflight_id > -1) || (cache_entry->ref_count > 0) || (!DLINKED_LIST_ISEMPTY(cache_entry->waiter_list)))
+			continue;
+
+		/* Touch base statistics */
+		resolv_base->stats.cache_evicted++;
+
+		CommEvDNSCacheEntryDestroy(resolv_base, cache_entry);
+		return 1;
+	}
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static void CommEvDNSCacheReplyStore(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry, DNSAReply *a_reply, int reply_count)
+{
+	long now_ts;
+	int ttl;
+	int i;
+
+	/* Server failures and garbled replies say nothing about the NAME, keep whatever we had */
+	if ((reply_count < 0) && (reply_count != -RFC1035_RCODE_NXDOMAIN))
+		return;
+
+	/* NXDOMAIN or NODATA - Negative answer */
+	if (a_reply->ip_count <= 0)
+	{
+		ttl									= resolv_base->cache.negative_ttl;
+		cache_entry->flags.negative			= 1;
+	}
+	/* Positive answer lives as long as its lowest TTL, clamped */
+	else
+	{
+		for (ttl = a_reply->ip_arr[0].ttl, i = 1; i < a_reply->ip_count; i++)
+		{
+			if (a_reply->ip_arr[i].ttl < ttl)
+				ttl = a_reply->ip_arr[i].ttl;
+		}
+
+		if (ttl < resolv_base->cache.ttl_min)
+			ttl								= resolv_base->cache.ttl_min;
+
+		cache_entry->flags.negative			= 0;
+	}
+
+	if (ttl > resolv_base->cache.ttl_max)
+		ttl									= resolv_base->cache.ttl_max;
+
+	now_ts									= CommEvDNSCacheNowGet(resolv_base);
+
+	/* Save answer */
+	memcpy(&cache_entry->a_reply, a_reply, sizeof(DNSAReply));
+	cache_entry->expire_ts					= (now_ts + ttl);
+	cache_entry->stale_ts					= (cache_entry->expire_ts + resolv_base->cache.stale_sec);
+	cache_entry->flags.valid				= 1;
+
+	KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "Cached [%s] - [%s] - IP_COUNT [%d] - TTL [%d]\n",
+			cache_entry->key_str, (cache_entry->flags.negative ? "NEGATIVE" : "POSITIVE"), a_reply->ip_count, ttl);
+
+	return;
+}
+/**************************************************************************************************************************/
+static void CommEvDNSCacheReplyFill(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry, DNSAReply *a_reply)
+{
+	long ttl_left;
+	int i;
+
+	memcpy(a_reply, &cache_entry->a_reply, sizeof(DNSAReply));
+
+	/* Upper layers schedule their own expire based on TTL, so report what is left of it - Zero if we are serving STALE */
+	ttl_left = (cache_entry->expire_ts - CommEvDNSCacheNowGet(resolv_base));
+	ttl_left = ((ttl_left < 0) ? 0 : ttl_left);
+
+	for (i = 0; i < a_reply->ip_count; i++)
+		a_reply->ip_arr[i].ttl = ttl_left;
+
+	return;
+}
+/**************************************************************************************************************************/
+static void CommEvDNSCacheWaitersNotify(EvDNSResolverBase *resolv_base, DNSCacheEntry *cache_entry, DNSAReply *a_reply, int code)
+{
+	DNSPendingQuery *pending_query;
+
+	/* Pop one by one, CB_H may cancel other waiters */
+	while ((pending_query = DLinkedListPopHead(&cache_entry->waiter_list)))
+	{
+		pending_query->flags.dispatching = 1;
+
+		/* Invoke CB_HANDLER */
+		if ((pending_query->events.cb_handler) && (!pending_query->flags.canceled_req))
+			pending_query->events.cb_handler(resolv_base, pending_query->events.cb_data, (void*)a_reply, code);
+
+		CommEvDNSPendingQueryRelease(resolv_base, pending_query);
+		continue;
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static int CommEvDNSHedgeTimerEvent(int fd, int can_write_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	DLinkedListNode *node;
+	DNSPendingQuery *pending_query;
+	struct timeval current_tv;
+	int elapsed_ms;
+	int hedge_idx;
+
+	EvDNSResolverBase *resolv_base	= cb_data;
+	int hedge_count					= 0;
+	int waiting_count				= 0;
+
+	/* We will reschedule timer after done */
+	resolv_base->hedge.timer_id		= -1;
+
+	CommEvDNSCurrentTimeGet(resolv_base, &current_tv);
+
+	/* Walk all pending reply list */
+	for (node = resolv_base->pending_req.reply_list.head; node; )
+	{
+		pending_query	= node->data;
+		node			= node->next;
+
+		/* Already hedged */
+		if (pending_query->flags.hedged)
+			continue;
+
+		elapsed_ms		= CommEvDNStvSubMsec(&pending_query->upstream.sent_tv[pending_query->upstream.target_idx], &current_tv);
+
+		/* Not late yet, check it again later */
+		if (elapsed_ms < resolv_base->hedge.delay_ms)
+		{
+			waiting_count++;
+			continue;
+		}
+
+		/* Mark as hedged even if there is no other server left */
+		pending_query->flags.hedged	= 1;
+		hedge_idx					= CommEvDNSServerSelect(resolv_base, pending_query->upstream.sent_mask);
+
+		if (hedge_idx < 0)
+			continue;
+
+		KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "HEDGE REQ_ID [%d] - SERVER [%d] -> [%d] - ELAPSED [%d] ms\n",
+				pending_query->slot_id, pending_query->upstream.target_idx, hedge_idx, elapsed_ms);
+
+		/* Move it back to write list, targeting second server - First one can still answer it */
+		DLinkedListDelete(&resolv_base->pending_req.reply_list, &pending_query->node);
+		DLinkedListAddTail(&resolv_base->pending_req.req_list, &pending_query->node, pending_query);
+
+		pending_query->flags.waiting_reply	= 0;
+		pending_query->flags.hedge_xmit		= 1;
+		pending_query->upstream.target_idx	= hedge_idx;
+
+		/* Touch base statistics */
+		resolv_base->stats.request_hedged++;
+		hedge_count++;
+		continue;
+	}
+
+	/* Schedule WRITE event */
+	if (hedge_count > 0)
+		EvKQBaseSetEvent(resolv_base->ev_base, resolv_base->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvDNSWriteEvent, resolv_base);
+
+	/* Reschedule timer */
+	if ((waiting_count > 0) && (resolv_base->hedge.timer_id < 0))
+		resolv_base->hedge.timer_id = EvKQBaseTimerAdd(resolv_base->ev_base, COMM_ACTION_ADD_VOLATILE, resolv_base->hedge.delay_ms, CommEvDNSHedgeTimerEvent, resolv_base);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static void CommEvDNSCurrentTimeGet(EvDNSResolverBase *resolv_base, struct timeval *current_tv)
+{
+	/* Get current TIMESTAMP only if its not inside ev_base */
+	if (0 == resolv_base->ev_base->stats.cur_invoke_tv.tv_sec)
+		gettimeofday(current_tv, NULL);
+	else
+		memcpy(current_tv, &resolv_base->ev_base->stats.cur_invoke_tv, sizeof(struct timeval));
+
+	return;
+}
+/**************************************************************************************************************************/
+static int CommEvDNSServerListParse(EvDNSResolverBase *resolv_base, char *ip_list_str, unsigned short dns_port)
+{
+	DNSUpstreamServer *upstream_server;
+	char *list_dup;
+	char *token_ptr;
+	char *save_ptr;
+	char *port_ptr;
+
+	/* Sanity check */
+	if (!ip_list_str)
+		return 0;
+
+	list_dup = strdup(ip_list_str);
+
+	/* Accept "IP[:PORT][,IP[:PORT]...]", port defaults to DNS_PORT */
+	for (token_ptr = strtok_r(list_dup, ", ;", &save_ptr); token_ptr; token_ptr = strtok_r(NULL, ", ;", &save_ptr))
+	{
+		/* Server list full */
+		if (resolv_base->server.count >= RESOLVER_DNS_SERVER_MAX)
+		{
+			KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "Ignoring DNS server [%s] - Max of [%d] servers\n", token_ptr, RESOLVER_DNS_SERVER_MAX);
+			break;
+		}
+
+		upstream_server 					= &resolv_base->server.arr[resolv_base->server.count];
+		port_ptr							= strchr(token_ptr, ':');
+
+		if (port_ptr)
+			*port_ptr++ = '\0';
+
+		upstream_server->addr.sin_family	= AF_INET;
+		upstream_server->addr.sin_port		= htons(port_ptr ? atoi(port_ptr) : dns_port);
+
+		/* Invalid address, skip it */
+		if (!inet_aton(token_ptr, &upstream_server->addr.sin_addr))
+		{
+			KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "Ignoring invalid DNS server [%s]\n", token_ptr);
+			memset(upstream_server, 0, sizeof(DNSUpstreamServer));
+			continue;
+		}
+
+		resolv_base->server.count++;
+		continue;
+	}
+
+	free(list_dup);
+
+	return resolv_base->server.count;
+}
+/**************************************************************************************************************************/
+static int CommEvDNSServerSelect(EvDNSResolverBase *resolv_base, unsigned int exclude_mask)
+{
+	DNSUpstreamServer *upstream_server;
+	struct timeval current_tv;
+	int cur_score;
+	int i;
+
+	int best_score	= 0;
+	int best_idx	= -1;
+
+	CommEvDNSCurrentTimeGet(resolv_base, &current_tv);
+
+	/* Lowest expected RTT wins - Untried servers get a default guess, and each consecutive timeout costs a full retry timeout */
+	for (i = 0; i < resolv_base->server.count; i++)
+	{
+		if (exclude_mask & (1 << i))
+			continue;
+
+		upstream_server	= &resolv_base->server.arr[i];
+		cur_score		= ((upstream_server->srtt_ms > 0) ? (upstream_server->srtt_ms + upstream_server->rttvar_ms) : RESOLVER_DNS_RTT_INIT_MS);
+		cur_score		+= (CommEvDNSServerFailCountGet(upstream_server, &current_tv) * resolv_base->timeout_ms.retry);
+
+		if ((best_idx < 0) || (cur_score < best_score))
+		{
+			best_score	= cur_score;
+			best_idx	= i;
+		}
+
+		continue;
+	}
+
+	return best_idx;
+}
+/**************************************************************************************************************************/
+static int CommEvDNSServerFailCountGet(DNSUpstreamServer *upstream_server, struct timeval *current_tv)
+{
+	int decay_steps;
+
+	/* Never failed, or already answered again */
+	if (upstream_server->fail_count <= 0)
+		return 0;
+
+	/* Halve FAIL_COUNT for each DECAY period since last timeout, so a server silent for a while gets probed again */
+	decay_steps = (CommEvDNStvSubMsec(&upstream_server->fail_tv, current_tv) / RESOLVER_DNS_FAIL_DECAY_MS);
+
+	if (decay_steps <= 0)
+		return upstream_server->fail_count;
+
+	return ((decay_steps < 31) ? (upstream_server->fail_count >> decay_steps) : 0);
+}
+/**************************************************************************************************************************/
+static int CommEvDNSServerFindByAddr(EvDNSResolverBase *resolv_base, struct sockaddr_in *addr)
+{
+	int i;
+
+	for (i = 0; i < resolv_base->server.count; i++)
+	{
+		if ((resolv_base->server.arr[i].addr.sin_addr.s_addr == addr->sin_addr.s_addr) && (resolv_base->server.arr[i].addr.sin_port == addr->sin_port))
+			return i;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+static int CommEvDNSServerWrite(EvDNSResolverBase *resolv_base, DNSPendingQuery *pending_query, int server_idx)
+{
+	DNSUpstreamServer *upstream_server = &resolv_base->server.arr[server_idx];
+	int wrote_bytes;
+
+	/* Write DNS query */
+	wrote_bytes = sendto(pending_query->upstream.socket_fd, (char*)&pending_query->rfc1035_request, pending_query->rfc1035_request_sz, 0,
+			(struct sockaddr *)&upstream_server->addr, sizeof(struct sockaddr_in));
+
+	KQBASE_LOG_PRINTF(resolv_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "REQ_ID [%d] - FD [%d] - WROTE [%d] bytes to SERVER [%d]\n",
+			pending_query->slot_id, pending_query->upstream.socket_fd, wrote_bytes, server_idx);
+
+	/* Failed writing */
+	if (wrote_bytes < (int)pending_query->rfc1035_request_sz)
+		return 0;
+
+	/* Save sent time to measure server RTT */
+	CommEvDNSCurrentTimeGet(resolv_base, &pending_query->upstream.sent_tv[server_idx]);
+	pending_query->upstream.sent_mask |= (1 << server_idx);
+	upstream_server->stats.request_sent++;
+
+	/* Set read event for socket */
+	EvKQBaseSetEvent(resolv_base->ev_base, pending_query->upstream.socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvDNSDataEvent, resolv_base);
+
+	return wrote_bytes;
+}
+/**************************************************************************************************************************/
+static void CommEvDNSServerTimeout(EvDNSResolverBase *resolv_base, DNSPendingQuery *pending_query)
+{
+	DNSUpstreamServer *upstream_server	= &resolv_base->server.arr[pending_query->upstream.target_idx];
+	struct timeval current_tv;
+	int next_idx;
+
+	CommEvDNSCurrentTimeGet(resolv_base, &current_tv);
+
+	/* Touch server statistics - Decay what is left from older timeouts before counting this one */
+	upstream_server->stats.request_timeout++;
+	upstream_server->fail_count	= (CommEvDNSServerFailCountGet(upstream_server, &current_tv) + 1);
+	upstream_server->fail_tv	= current_tv;
+
+	/* Next transmit goes to best server other than the silent one, if any */
+	next_idx = CommEvDNSServerSelect(resolv_base, (1 << pending_query->upstream.target_idx));
+
+	if (next_idx > -1)
+		pending_query->upstream.target_idx = next_idx;
+
+	/* Allow retransmit to be hedged again */
+	pending_query->flags.hedged = 0;
+
+	return;
+}
+/**************************************************************************************************************************/
+static void CommEvDNSServerRTTUpdate(EvDNSResolverBase *resolv_base, int server_idx, int rtt_ms)
+{
+	DNSUpstreamServer *upstream_server = &resolv_base->server.arr[server_idx];
+	int sorted_arr[RESOLVER_DNS_RTT_SAMPLE_COUNT];
+	int rtt_delta;
+
+	/* Keep it at least one, zero means untried */
+	rtt_ms = ((rtt_ms < 1) ? 1 : rtt_ms);
+
+	/* Smooth it the same way TCP does */
+	if (upstream_server->srtt_ms <= 0)
+	{
+		upstream_server->srtt_ms	= rtt_ms;
+		upstream_server->rttvar_ms	= (rtt_ms / 2);
+	}
+	else
+	{
+		rtt_delta					= ((upstream_server->srtt_ms > rtt_ms) ? (upstream_server->srtt_ms - rtt_ms) : (rtt_ms - upstream_server->srtt_ms));
+		upstream_server->rttvar_ms	= (((3 * upstream_server->rttvar_ms) + rtt_delta) / 4);
+		upstream_server->srtt_ms	= (((7 * upstream_server->srtt_ms) + rtt_ms) / 8);
+	}
+
+	/* Fixed HEDGE delay, no need for samples */
+	if (resolv_base->hedge.fixed_ms > 0)
+		return;
+
+	/* Save sample */
+	resolv_base->hedge.sample_arr[resolv_base->hedge.sample_idx]	= rtt_ms;
+	resolv_base->hedge.sample_idx									= ((resolv_base->hedge.sample_idx + 1) % RESOLVER_DNS_RTT_SAMPLE_COUNT);
+
+	if (resolv_base->hedge.sample_count < RESOLVER_DNS_RTT_SAMPLE_COUNT)
+		resolv_base->hedge.sample_count++;
+
+	/* Recalculate percentile every few samples */
+	if ((resolv_base->hedge.sample_idx % 8) != 0)
+		return;
+
+	memcpy(&sorted_arr, &resolv_base->hedge.sample_arr, (resolv_base->hedge.sample_count * sizeof(int)));
+	qsort(&sorted_arr, resolv_base->hedge.sample_count, sizeof(int), CommEvDNSIntCmp);
+
+	resolv_base->hedge.delay_ms = sorted_arr[((resolv_base->hedge.sample_count - 1) * RESOLVER_DNS_HEDGE_PERCENTILE) / 100];
+	resolv_base->hedge.delay_ms = ((resolv_base->hedge.delay_ms < RESOLVER_DNS_HEDGE_MIN_MS) ? RESOLVER_DNS_HEDGE_MIN_MS : resolv_base->hedge.delay_ms);
+
+	return;
+}
+/**************************************************************************************************************************/
+static int CommEvDNSIntCmp(const void *a, const void *b)
+{
+	return (*(int*)a - *(int*)b);
+}
+/**************************************************************************************************************************/
 /**/
 /**/
 /**************************************************************************************************************************/
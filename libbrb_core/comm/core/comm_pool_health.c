@@ -0,0 +1,234 @@
+/*
+ * comm_pool_health.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../include/libbrb_core.h"
+
+static unsigned long CommEvPoolHealthTimeValSubUsec(struct timeval *when, struct timeval *now);
+static void CommEvPoolHealthEject(CommEvPoolHealth *health, struct timeval *now_tv);
+static void CommEvPoolHealthReadmit(CommEvPoolHealth *health);
+
+/**************************************************************************************************************************/
+void CommEvPoolHealthClean(CommEvPoolHealth *health)
+{
+	/* Sanity check */
+	if (!health)
+		return;
+
+	memset(health, 0, sizeof(CommEvPoolHealth));
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvPoolHealthWriteMark(CommEvPoolHealth *health, struct timeval *now_tv)
+{
+	/* First write waiting for reply, start the latency clock */
+	if (0 == health->pending_count)
+		memcpy(&health->pending_tv, now_tv, sizeof(struct timeval));
+
+	health->pending_count++;
+
+	/* Ejected client being selected again, this write is its probe */
+	if (health->flags.ejected)
+		health->flags.probing = 1;
+
+	return;
+}
+/**************************************************************************************************************************/
+int CommEvPoolHealthReplyMark(CommEvPoolHealth *health, struct timeval *now_tv, int reply_count)
+{
+	unsigned long sample_us;
+
+	/* Reply without a pool write waiting for it, nothing to measure */
+	if (health->pending_count <= 0)
+		return 0;
+
+	sample_us					= CommEvPoolHealthTimeValSubUsec(&health->pending_tv, now_tv);
+	health->latency_last_us		= sample_us;
+	health->fail_count			= 0;
+
+	/* Successful probe, bring client back with a fresh latency history */
+	if (health->flags.probing)
+	{
+		CommEvPoolHealthReadmit(health);
+		health->sample_count	= 0;
+	}
+
+	/* First sample seeds the average, then EWMA(1/8) */
+	if (0 == health->sample_count)
+		health->latency_ewma_us = sample_us;
+	else if (sample_us > health->latency_ewma_us)
+		health->latency_ewma_us += ((sample_us - health->latency_ewma_us) >> COMM_POOL_HEALTH_EWMA_SHIFT);
+	else
+		health->latency_ewma_us -= ((health->latency_ewma_us - sample_us) >> COMM_POOL_HEALTH_EWMA_SHIFT);
+
+	health->sample_count++;
+
+	/* Replies are in order, so the next pending write started no earlier than now */
+	health->pending_count		-= ((reply_count > 0) ? reply_count : 1);
+
+	if (health->pending_count > 0)
+		memcpy(&health->pending_tv, now_tv, sizeof(struct timeval));
+	else
+		health->pending_count	= 0;
+
+	return 1;
+}
+/**************************************************************************************************************************/
+int CommEvPoolHealthFailMark(CommEvPoolHealth *health, struct timeval *now_tv, int can_eject)
+{
+	/* Whatever was in flight will never be answered */
+	health->pending_count	= 0;
+	health->fail_count++;
+
+	/* Failed probe, already out of the pool, back-off grows */
+	if (health->flags.probing)
+	{
+		CommEvPoolHealthEject(health, now_tv);
+		return 1;
+	}
+
+	/* Too many consecutive failures, eject - Unless caller has no other healthy client left */
+	if ((can_eject) && (!health->flags.ejected) && (health->fail_count >= COMM_POOL_HEALTH_FAIL_MAX))
+	{
+		CommEvPoolHealthEject(health, now_tv);
+		return 1;
+	}
+
+	return 0;
+}
+/**************************************************************************************************************************/
+int CommEvPoolHealthPendingExpire(CommEvPoolHealth *health, struct timeval *now_tv)
+{
+	/* Nothing in flight, or oldest write still within reply timeout */
+	if ((health->pending_count <= 0) || (EvKQBaseTimeValSubMsec(&health->pending_tv, now_tv) <= COMM_POOL_HEALTH_REPLY_TIMEOUT_MS))
+		return 0;
+
+	/* Unanswered probe still fails, it only keeps an already ejected client out */
+	if (health->flags.probing)
+		return CommEvPoolHealthFailMark(health, now_tv, 0);
+
+	/* Peer does not reply to everything we write, drop stale writes so they stop counting as load */
+	health->pending_count = 0;
+	return 0;
+}
+/**************************************************************************************************************************/
+int CommEvPoolHealthCanSelect(CommEvPoolHealth *health, struct timeval *now_tv)
+{
+	/* Healthy client */
+	if (!health->flags.ejected)
+		return 1;
+
+	/* Only one probe at a time */
+	if (health->flags.probing)
+		return 0;
+
+	/* Back-off elapsed, client can take a probe */
+	if (EvKQBaseTimeValSubMsec(&health->ejected_tv, now_tv) >= health->eject_ms)
+		return 1;
+
+	return 0;
+}
+/**************************************************************************************************************************/
+int CommEvPoolHealthCheck(CommEvPoolHealth *health, struct timeval *now_tv, unsigned long pool_ewma_us, int can_eject)
+{
+	/* Oldest pending write did not get a reply in time, count as failure */
+	if ((health->pending_count > 0) && (EvKQBaseTimeValSubMsec(&health->pending_tv, now_tv) > COMM_POOL_HEALTH_REPLY_TIMEOUT_MS))
+		return CommEvPoolHealthFailMark(health, now_tv, can_eject);
+
+	/* Already ejected, or caller wont let the pool shrink any further */
+	if ((health->flags.ejected) || (!can_eject))
+		return 0;
+
+	/* Not enough samples or no pool reference yet */
+	if ((health->sample_count < COMM_POOL_HEALTH_SLOW_MIN_SAMPLES) || (0 == pool_ewma_us))
+		return 0;
+
+	/* Latency outlier against the pool average */
+	if ((health->latency_ewma_us > COMM_POOL_HEALTH_SLOW_MIN_US) && (health->latency_ewma_us > (pool_ewma_us * COMM_POOL_HEALTH_SLOW_FACTOR)))
+	{
+		CommEvPoolHealthEject(health, now_tv);
+		return 1;
+	}
+
+	return 0;
+}
+/**************************************************************************************************************************/
+unsigned long CommEvPoolHealthCost(CommEvPoolHealth *health, long load)
+{
+	/* Expected time to drain: latency times queue depth. Unsampled clients cost only their load, so they get explored */
+	return ((health->latency_ewma_us + 1) * (load + health->pending_count + 1));
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static unsigned long CommEvPoolHealthTimeValSubUsec(struct timeval *when, struct timeval *now)
+{
+	long delta_us;
+
+	delta_us = ((now->tv_sec - when->tv_sec) * 1000000L) + (now->tv_usec - when->tv_usec);
+
+	/* Clock went backwards */
+	if (delta_us < 0)
+		return 0;
+
+	return delta_us;
+}
+/**************************************************************************************************************************/
+static void CommEvPoolHealthEject(CommEvPoolHealth *health, struct timeval *now_tv)
+{
+	/* Exponential back-off between probes */
+	if (health->eject_ms <= 0)
+		health->eject_ms = COMM_POOL_HEALTH_EJECT_MIN_MS;
+	else if (health->flags.probing)
+		health->eject_ms = ((health->eject_ms * 2) > COMM_POOL_HEALTH_EJECT_MAX_MS) ? COMM_POOL_HEALTH_EJECT_MAX_MS : (health->eject_ms * 2);
+
+	memcpy(&health->ejected_tv, now_tv, sizeof(struct timeval));
+
+	health->flags.ejected	= 1;
+	health->flags.probing	= 0;
+	health->eject_count++;
+
+	return;
+}
+/**************************************************************************************************************************/
+static void CommEvPoolHealthReadmit(CommEvPoolHealth *health)
+{
+	health->flags.ejected	= 0;
+	health->flags.probing	= 0;
+	health->fail_count		= 0;
+	health->eject_ms		= 0;
+
+	return;
+}
+/**************************************************************************************************************************/
@@ -34,6 +34,9 @@
 
 #include "../include/libbrb_core.h"
 
+static EvBaseKQCBH CommEvTCPInfoSamplerTimer;
+static void CommEvTCPInfoSamplerPeerStr(CommEvStatistics *statistics, char *ret_buf, int ret_buf_maxsz);
+
 /**************************************************************************************************************************/
 void CommEvStatisticsRateCalculate(EvKQBase *ev_base, CommEvStatistics *statistics, int socket_fd, int rates_type)
 {
@@ -360,3 +363,282 @@ void CommEvStatisticsRateClean(CommEvStatistics *statistics)
 	return;
 }
 /**************************************************************************************************************************/
+int CommEvStatisticsTCPInfoSample(CommEvStatistics *statistics, int socket_fd, unsigned long sample_ts)
+{
+	struct tcp_info tcp_info;
+	socklen_t tcp_info_sz = sizeof(struct tcp_info);
+#if !defined(__linux__) && defined(FIONWRITE)
+	int pending_bytes = 0;
+#endif
+
+	/* Sanity check */
+	if (socket_fd < 0)
+		return 0;
+
+	memset(&tcp_info, 0, sizeof(struct tcp_info));
+
+	if (getsockopt(socket_fd, IPPROTO_TCP, TCP_INFO, &tcp_info, &tcp_info_sz) < 0)
+		return 0;
+
+	/* Kernel RTT is already smoothed (SRTT), in microseconds on both platforms */
+	statistics->tcp_info.rtt_us			= tcp_info.tcpi_rtt;
+	statistics->tcp_info.rttvar_us		= tcp_info.tcpi_rttvar;
+
+#if defined(__linux__)
+	/* Linux reports CWND and UNACKED in segments */
+	statistics->tcp_info.cwnd_bytes		= (tcp_info.tcpi_snd_cwnd * tcp_info.tcpi_snd_mss);
+	statistics->tcp_info.unacked_bytes	= (tcp_info.tcpi_unacked * tcp_info.tcpi_snd_mss);
+	statistics->tcp_info.retransmits	= tcp_info.tcpi_total_retrans;
+#else
+	statistics->tcp_info.cwnd_bytes		= tcp_info.tcpi_snd_cwnd;
+	statistics->tcp_info.retransmits	= tcp_info.tcpi_snd_rexmitpack;
+
+	/* No SND_UNA on TCP_INFO, use send queue size, unacked plus not yet sent */
+#if defined(FIONWRITE)
+	if (ioctl(socket_fd, FIONWRITE, &pending_bytes) == 0)
+		statistics->tcp_info.unacked_bytes = pending_bytes;
+#endif
+#endif
+
+	statistics->tcp_info.sample_ts		= sample_ts;
+	return 1;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+CommEvTCPInfoSampler *CommEvTCPInfoSamplerNew(EvKQBase *kq_base, int interval_ms, int batch_max)
+{
+	CommEvTCPInfoSampler *sampler;
+
+	BRB_CALLOC(sampler, 1, sizeof(CommEvTCPInfoSampler));
+
+	/* Failed allocating sampler, caller runs without TCP_INFO samples */
+	if (!sampler)
+		return NULL;
+
+	/* Connections register from any thread, list is protected by our own mutex */
+	DLinkedListInit(&sampler->stats_list, BRBDATA_THREAD_UNSAFE);
+	pthread_mutex_init(&sampler->mutex, NULL);
+
+	sampler->kq_base		= kq_base;
+	sampler->interval_ms	= ((interval_ms > 0) ? interval_ms : COMM_TCP_INFO_SAMPLE_INTERVAL_MS);
+	sampler->batch_max		= ((batch_max > 0) ? batch_max : COMM_TCP_INFO_SAMPLE_BATCH_MAX);
+
+	/* Single base level timer walks all registered connections, batch_max at a time */
+	sampler->timer_id		= EvKQBaseTimerAdd(kq_base, COMM_ACTION_ADD_PERSIST, sampler->interval_ms, CommEvTCPInfoSamplerTimer, sampler);
+
+	return sampler;
+}
+/**************************************************************************************************************************/
+void CommEvTCPInfoSamplerDestroy(CommEvTCPInfoSampler *sampler)
+{
+	CommEvStatistics *statistics;
+
+	/* Sanity check */
+	if (!sampler)
+		return;
+
+	if (sampler->timer_id > -1)
+		EvKQBaseTimerCtl(sampler->kq_base, sampler->timer_id, COMM_ACTION_DELETE);
+
+	pthread_mutex_lock(&sampler->mutex);
+
+	/* Detach everyone still registered, nodes live inside their owners */
+	while ((statistics = DLinkedListPopHead(&sampler->stats_list)))
+		statistics->tcp_info.sampler = NULL;
+
+	pthread_mutex_unlock(&sampler->mutex);
+	pthread_mutex_destroy(&sampler->mutex);
+
+	BRB_FREE(sampler);
+	return;
+}
+/**************************************************************************************************************************/
+int CommEvTCPInfoSamplerAdd(CommEvTCPInfoSampler *sampler, CommEvStatistics *statistics, int socket_fd, struct sockaddr_storage *peer_addr, char *label_str)
+{
+	/* Sanity check */
+	if ((!sampler) || (socket_fd < 0))
+		return 0;
+
+	/* Already registered, move it over */
+	if (statistics->tcp_info.sampler)
+		CommEvTCPInfoSamplerDel(statistics);
+
+	pthread_mutex_lock(&sampler->mutex);
+
+	statistics->tcp_info.sampler	= sampler;
+	statistics->tcp_info.peer_addr	= peer_addr;
+	statistics->tcp_info.label_str	= label_str;
+	statistics->tcp_info.socket_fd	= socket_fd;
+	statistics->tcp_info.sample_ts	= 0;
+
+	/* New connections go to head, so next round samples them first */
+	DLinkedListAddHead(&sampler->stats_list, &statistics->tcp_info.node, statistics);
+
+	pthread_mutex_unlock(&sampler->mutex);
+	return 1;
+}
+/**************************************************************************************************************************/
+int CommEvTCPInfoSamplerDel(CommEvStatistics *statistics)
+{
+	CommEvTCPInfoSampler *sampler = statistics->tcp_info.sampler;
+
+	/* Not registered */
+	if (!sampler)
+		return 0;
+
+	/* Must leave list before owner closes FD, so sampler never queries a reused descriptor */
+	pthread_mutex_lock(&sampler->mutex);
+	DLinkedListDelete(&sampler->stats_list, &statistics->tcp_info.node);
+	statistics->tcp_info.sampler	= NULL;
+	statistics->tcp_info.socket_fd	= -1;
+	pthread_mutex_unlock(&sampler->mutex);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+int CommEvTCPInfoSamplerDumpSlowest(CommEvTCPInfoSampler *sampler, MemBuffer *json_mb, int max_count)
+{
+	CommEvStatistics **slowest_arr;
+	CommEvStatistics *statistics;
+	DLinkedListNode *node;
+	char peer_str[128];
+	int slowest_count;
+	int i;
+
+	/* Sanity check */
+	if ((!sampler) || (!json_mb) || (max_count <= 0))
+		return 0;
+
+	BRB_CALLOC(slowest_arr, max_count, sizeof(CommEvStatistics *));
+	slowest_count	= 0;
+
+	/* Failed allocating ranking table */
+	if (!slowest_arr)
+		return 0;
+
+	pthread_mutex_lock(&sampler->mutex);
+
+	/* Keep top MAX_COUNT by RTT, sorted by insertion - N is small, list may be huge */
+	for (node = sampler->stats_list.head; node; node = node->next)
+	{
+		statistics = node->data;
+
+		/* Not sampled yet */
+		if (0 == statistics->tcp_info.sample_ts)
+			continue;
+
+		/* Table full and not slower than fastest kept entry, skip it */
+		if ((slowest_count == max_count) && (statistics->tcp_info.rtt_us <= slowest_arr[slowest_count - 1]->tcp_info.rtt_us))
+			continue;
+
+		i = ((slowest_count < max_count) ? slowest_count++ : (max_count - 1));
+
+		for (; (i > 0) && (slowest_arr[i - 1]->tcp_info.rtt_us < statistics->tcp_info.rtt_us); i--)
+			slowest_arr[i] = slowest_arr[i - 1];
+
+		slowest_arr[i] = statistics;
+		continue;
+	}
+
+	MEMBUFFER_JSON_BEGIN_OBJECT(json_mb);
+	MEMBUFFER_JSON_ADD_ULONG(json_mb, "registered", sampler->stats_list.size);
+	MEMBUFFER_JSON_ADD_COMMA(json_mb);
+	MEMBUFFER_JSON_ADD_ULONG(json_mb, "rounds", sampler->stats.rounds);
+	MEMBUFFER_JSON_ADD_COMMA(json_mb);
+	MEMBUFFER_JSON_ADD_ULONG(json_mb, "sampled", sampler->stats.sampled);
+	MEMBUFFER_JSON_ADD_COMMA(json_mb);
+	MEMBUFFER_JSON_ADD_ULONG(json_mb, "failed", sampler->stats.failed);
+	MEMBUFFER_JSON_ADD_COMMA(json_mb);
+	MEMBUFFER_JSON_BEGIN_ARRAY_KEY(json_mb, "slowest");
+
+	for (i = 0; i < slowest_count; i++)
+	{
+		statistics = slowest_arr[i];
+		CommEvTCPInfoSamplerPeerStr(statistics, (char*)&peer_str, sizeof(peer_str));
+
+		if (i > 0)
+			MEMBUFFER_JSON_ADD_COMMA(json_mb);
+
+		MemBufferPrintf(json_mb, "{\"peer\": \"%s\", \"label\": \"%s\", \"fd\": %d, \"rtt_us\": %u, \"rttvar_us\": %u, \"cwnd_bytes\": %u, "
+				"\"retransmits\": %u, \"unacked_bytes\": %u, \"sample_ts\": %lu}",
+				peer_str, (statistics->tcp_info.label_str ? statistics->tcp_info.label_str : ""), statistics->tcp_info.socket_fd,
+				statistics->tcp_info.rtt_us, statistics->tcp_info.rttvar_us, statistics->tcp_info.cwnd_bytes,
+				statistics->tcp_info.retransmits, statistics->tcp_info.unacked_bytes, statistics->tcp_info.sample_ts);
+	}
+
+	MEMBUFFER_JSON_FINISH_ARRAY(json_mb);
+	MEMBUFFER_JSON_FINISH_OBJECT(json_mb);
+
+	pthread_mutex_unlock(&sampler->mutex);
+	BRB_FREE(slowest_arr);
+
+	return slowest_count;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static int CommEvTCPInfoSamplerTimer(int fd, int data_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvTCPInfoSampler *sampler	= cb_data;
+	EvKQBase *ev_base				= base_ptr;
+	CommEvStatistics *statistics;
+	unsigned long sample_count;
+	int i;
+
+	pthread_mutex_lock(&sampler->mutex);
+
+	sample_count = ((sampler->stats_list.size < sampler->batch_max) ? sampler->stats_list.size : sampler->batch_max);
+
+	/* Sample from head and rotate to tail, so large lists are covered across consecutive rounds */
+	for (i = 0; i < sample_count; i++)
+	{
+		statistics = sampler->stats_list.head->data;
+
+		if (CommEvStatisticsTCPInfoSample(statistics, statistics->tcp_info.socket_fd, ev_base->stats.cur_invoke_ts_sec))
+			sampler->stats.sampled++;
+		else
+			sampler->stats.failed++;
+
+		DLinkedListMoveToTail(&sampler->stats_list, &statistics->tcp_info.node);
+		continue;
+	}
+
+	sampler->stats.rounds++;
+	pthread_mutex_unlock(&sampler->mutex);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPInfoSamplerPeerStr(CommEvStatistics *statistics, char *ret_buf, int ret_buf_maxsz)
+{
+	struct sockaddr_storage *peer_addr = statistics->tcp_info.peer_addr;
+	char ip_str[64];
+
+	ret_buf[0] = '\0';
+
+	/* Sanity check */
+	if (!peer_addr)
+		return;
+
+	switch (peer_addr->ss_family)
+	{
+	case AF_INET6:
+		inet_ntop(AF_INET6, &satosin6(peer_addr)->sin6_addr, (char*)&ip_str, sizeof(ip_str));
+		snprintf(ret_buf, ret_buf_maxsz, "[%s]:%d", ip_str, ntohs(satosin6(peer_addr)->sin6_port));
+		break;
+
+	case AF_INET:
+		inet_ntop(AF_INET, &satosin(peer_addr)->sin_addr, (char*)&ip_str, sizeof(ip_str));
+		snprintf(ret_buf, ret_buf_maxsz, "%s:%d", ip_str, ntohs(satosin(peer_addr)->sin_port));
+		break;
+
+	default:
+		break;
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
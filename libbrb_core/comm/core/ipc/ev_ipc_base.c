@@ -691,39 +691,28 @@ static int EvICPBaseEventRead(int fd, int read_sz, int thrd_id, void *cb_data, v
 static int EvICPBaseEventWrite(int fd, int can_write_sz, int thrd_id, void *cb_data, void *base_ptr)
 {
 	EvAIOReq *cur_aio_req;
-
-	char *data_ptr;
-	int still_can_write_sz;
-	unsigned long wanted_write_sz;
-	int wrote_sz;
-	int total_wrote_sz = 0;
+	long wrote_sz;
 
 	EvKQBase *ev_base				= base_ptr;
 	EvIPCBase *ipc_base				= cb_data;
-
-	/* Label used to write multiple aio_reqs in the same write_window, if possible */
-	write_again:
-
-	/* Grab aio_req unit */
-	cur_aio_req			= EvAIOReqQueueDequeue(&ipc_base->write_queue);
+	int total_wrote_sz				= 0;
 
 	/* Nothing to write, bail out */
-	if (!cur_aio_req)
+	if (EvAIOReqQueueIsEmpty(&ipc_base->write_queue))
 		return total_wrote_sz;
 
-	/* Calculate current data size and offset */
-	wanted_write_sz	= cur_aio_req->data.size	- cur_aio_req->data.offset;
-	data_ptr		= cur_aio_req->data.ptr		+ cur_aio_req->data.offset;
+	/* Kernel did not tell us how much we can write, offer the whole batch and let non-blocking pipe take what it can */
+	if (can_write_sz <= 0)
+		can_write_sz = INT_MAX;
 
-	/* Issue write call - Either what we want to write, if possible. Otherwise, write what kernel tells us we can */
-	wrote_sz = write(fd, data_ptr, (can_write_sz < wanted_write_sz) ? can_write_sz : wanted_write_sz);
+	/* Issue a single gather write for as many queued AIO_REQs as kernel allow us to - WRITEV updates each AIO_REQ offset */
+	wrote_sz = EvAIOReqQueueWriteVectored(&ipc_base->write_queue, fd, can_write_sz);
 
 	/* The write was interrupted by a signal or we were not able to write any data to it, reschedule and return. */
 	if (wrote_sz == -1)
 	{
-		/* RENQUEUE AIO_REQ, either for destruction or for another write attempt */
-		EvAIOReqQueueEnqueueHead(&ipc_base->write_queue, cur_aio_req);
-		cur_aio_req->err = errno;
+		cur_aio_req			= EvAIOReqQueuePointToHead(&ipc_base->write_queue);
+		cur_aio_req->err	= errno;
 
 		if (errno == EINTR || errno == EAGAIN)
 		{
@@ -737,15 +726,16 @@ static int EvICPBaseEventWrite(int fd, int can_write_sz, int thrd_id, void *cb_d
 		return total_wrote_sz;
 	}
 
-	/* Write_ok, update offset and counter */
-	cur_aio_req->data.offset	+= wrote_sz;
-	total_wrote_sz				+= wrote_sz;
+	total_wrote_sz = wrote_sz;
 
-	/* Write is complete */
-	if (cur_aio_req->data.offset >= cur_aio_req->data.size)
+	/* Finish every AIO_REQ at HEAD that has been fully written */
+	while ((cur_aio_req = EvAIOReqQueuePointToHead(&ipc_base->write_queue)) && (EvAIOReqGetMissingSize(cur_aio_req) <= 0))
 	{
-		//KQBASE_LOG_PRINTF(ipc_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - FULL write of [%d] bytes - Wanted [%lu] - Offset is now [%lu] on THREAD [%d]\n",
-		//						fd, wrote_sz, wanted_write_sz, cur_aio_req->write_offset, thrd_id);
+		KQBASE_LOG_PRINTF(ipc_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - FULL write - Offset is now [%lu] on THREAD [%d]\n",
+				fd, cur_aio_req->data.offset, thrd_id);
+
+		/* Remove from WRITE_QUEUE */
+		EvAIOReqQueueDequeue(&ipc_base->write_queue);
 
 		/* Dispatch write finish event, if there is anyone interested */
 		if (cur_aio_req->finish_cb)
@@ -753,48 +743,18 @@ static int EvICPBaseEventWrite(int fd, int can_write_sz, int thrd_id, void *cb_d
 
 		/* Destroy current aio_req */
 		EvAIOReqDestroy(cur_aio_req);
-
-		/* Next aio_req exists, loop writing some more or reschedule write event */
-		if (!EvAIOReqQueueIsEmpty(&ipc_base->write_queue))
-		{
-			DLinkedList *aio_req_list = &ipc_base->write_queue.aio_req_list;
-
-			/* Get a reference to next element */
-			cur_aio_req = (EvAIOReq*)aio_req_list->head->data;
-
-			/* Calculate wanted data size and how many bytes we have left to write */
-			wanted_write_sz		= cur_aio_req->data.size - cur_aio_req->data.offset;
-			still_can_write_sz	= can_write_sz - total_wrote_sz;
-
-			/* Keep writing as many aio_reqs the kernel allow us to */
-			if (wanted_write_sz <= still_can_write_sz)
-			{
-				KQBASE_LOG_PRINTF(ipc_base->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - We can still write [%d] bytes qnd next aio_req wants [%d] bytes, loop to grab it\n",
-						fd, still_can_write_sz, wanted_write_sz);
-				goto write_again;
-			}
-			/* No more room to write, reschedule write event */
-			else
-			{
-				KQBASE_LOG_PRINTF(ipc_base->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - We can still write [%d] bytes and next aio_req wants [%d] bytes, RESCHEDULE WRITE_EV\n",
-						fd, still_can_write_sz, wanted_write_sz);
-
-				/* Reschedule write event */
-				EvKQBaseSetEvent(ev_base, fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, EvICPBaseEventWrite, ipc_base);
-			}
-		}
 	}
-	else
+
+	/* Partial write, or more AIO_REQs than one WRITEV can take, reschedule write event */
+	if (!EvAIOReqQueueIsEmpty(&ipc_base->write_queue))
 	{
-		KQBASE_LOG_PRINTF(ipc_base->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - PARTIAL write of [%d] bytes - Offset is now [%d]\n", fd, wrote_sz, cur_aio_req->data.offset);
+		KQBASE_LOG_PRINTF(ipc_base->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - Wrote [%d] bytes, [%ld] AIO_REQs left, RESCHEDULE WRITE_EV\n",
+				fd, total_wrote_sz, EvAIOReqQueueGetQueueCount(&ipc_base->write_queue));
 
-		/* REENQUEUE and reschedule write event */
-		EvAIOReqQueueEnqueueHead(&ipc_base->write_queue, cur_aio_req);
 		EvKQBaseSetEvent(ev_base, fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, EvICPBaseEventWrite, ipc_base);
 	}
 
 	return total_wrote_sz;
-
 }
 /**************************************************************************************************************************/
 static int EvICPBaseEventClose(int fd, int read_sz, int thrd_id, void *cb_data, void *base_ptr)
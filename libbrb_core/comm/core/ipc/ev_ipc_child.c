@@ -299,12 +299,12 @@ static int EvICPBaseChildSelfSyncReadBuffer(EvIPCBaseChild *ipc_base_child, int
 {
 	EvKQBase *ev_base			= ipc_base_child->kq_base;
 
-	char *partial_ptr;
 	char *read_buffer_ptr;
 	char *request_str_ptr;
 	int request_str_sz;
 	int remaining_sz;
-	int i, j;
+	long scan_off;
+	long i;
 
 	char *token_str				= (char*)&ipc_base_child->self_sync.token_str_buf;
 	int max_buffer_sz			= ipc_base_child->self_sync.max_buffer_sz;
@@ -329,25 +329,26 @@ static int EvICPBaseChildSelfSyncReadBuffer(EvIPCBaseChild *ipc_base_child, int
 	KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "REQ_SZ [%d] - TOKEN_SZ [%d]\n", request_str_sz, token_sz);
 	//EvKQBaseLogHexDump(request_str_ptr, request_str_sz, 8, 4);
 
-	KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO,  LOGCOLOR_GREEN, "FD [%d] - Searching for token [%u] with [%d] bytes on [%d] bytes\n",
-			0, token_str[0], token_sz, request_str_sz);
+	/* Bytes before SCAN_OFF were already searched on a previous read with no token found, do not search them again */
+	scan_off = (ipc_base_child->self_sync.scan_off <= request_str_sz) ? ipc_base_child->self_sync.scan_off : 0;
 
-	/* Start searching the buffer */
-	for (j = 0, i = (request_str_sz); i >= 0; i--, j++)
-	{
-		/* Found finish of token, compare full token versus buffer */
-		if ( ((j >= token_sz) && (request_str_ptr[i] == token_str[0])) && (!memcmp(&request_str_ptr[i], token_str, token_sz)) )
-		{
-			KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO,  LOGCOLOR_YELLOW, "FD [%d] - Token found at [%d] - Buffer size is [%d]\n", 0, j, request_str_sz);
+	KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO,  LOGCOLOR_GREEN, "FD [%d] - Searching for token [%u] with [%d] bytes on [%d] bytes from offset [%ld]\n",
+			0, token_str[0], token_sz, request_str_sz, scan_off);
 
-			/* Found token */
-			token_found = 1;
-			break;
-		}
+	/* Last token in buffer closes the batch, every complete frame before it goes up in a single READ_EV */
+	i = BrbMemFindLast(request_str_ptr + scan_off, (request_str_sz - scan_off), token_str, token_sz);
+
+	if (i >= 0)
+	{
+		i			+= scan_off;
+		token_found	= 1;
 
-		continue;
+		KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO,  LOGCOLOR_YELLOW, "FD [%d] - Token found at [%ld] - Buffer size is [%d]\n", 0, i, request_str_sz);
 	}
 
+	/* Remember where next search starts, a token may still be completed by next read */
+	ipc_base_child->self_sync.scan_off = token_found ? 0 : (request_str_sz - token_sz + 1);
+
 	/* Token bas been found */
 	if (token_found)
 	{
@@ -381,6 +382,9 @@ static int EvICPBaseChildSelfSyncReadBuffer(EvIPCBaseChild *ipc_base_child, int
 		char *aux_ptr00 = MemBufferDeref(ipc_base_child->read_buffer);
 		char *aux_ptr01 = MemBufferDeref(ipc_base_child->partial_read_buffer);
 
+		/* Upper layers will consume this buffer, search from start next time */
+		ipc_base_child->self_sync.scan_off = 0;
+
 		KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO,  LOGCOLOR_CYAN, "FD [%d] - MAX_BUF [%d] - READ_BUF [%d]-[%s] - PARTIAL [%d]-[%s]\n",
 				0, max_buffer_sz, MemBufferGetSize(ipc_base_child->read_buffer), aux_ptr00 ? aux_ptr00 : "NULL",
 						MemBufferGetSize(ipc_base_child->partial_read_buffer), aux_ptr01 ? aux_ptr01 : "NULL");
@@ -460,39 +464,28 @@ static int EvICPBaseChildEventRead(int fd, int read_sz, int thrd_id, void *cb_da
 static int EvICPBaseChildEventWrite(int fd, int can_write_sz, int thrd_id, void *cb_data, void *base_ptr)
 {
 	EvAIOReq *cur_aio_req;
-
-	char *data_ptr;
-	int still_can_write_sz;
-	unsigned long wanted_write_sz;
-	int wrote_sz;
-	int total_wrote_sz = 0;
+	long wrote_sz;
 
 	EvKQBase *ev_base				= base_ptr;
 	EvIPCBaseChild *ipc_base_child	= cb_data;
-
-	/* Label used to write multiple aio_reqs in the same write_window, if possible */
-	write_again:
-
-	/* Grab aio_req unit */
-	cur_aio_req			= EvAIOReqQueueDequeue(&ipc_base_child->write_queue);
+	int total_wrote_sz				= 0;
 
 	/* Nothing to write, bail out */
-	if (!cur_aio_req)
+	if (EvAIOReqQueueIsEmpty(&ipc_base_child->write_queue))
 		return total_wrote_sz;
 
-	/* Calculate current data size and offset */
-	wanted_write_sz	= cur_aio_req->data.size	- cur_aio_req->data.offset;
-	data_ptr		= cur_aio_req->data.ptr		+ cur_aio_req->data.offset;
+	/* Kernel did not tell us how much we can write, offer the whole batch and let non-blocking pipe take what it can */
+	if (can_write_sz <= 0)
+		can_write_sz = INT_MAX;
 
-	/* Issue write call - Either what we want to write, if possible. Otherwise, write what kernel tells us we can */
-	wrote_sz = write(fd, data_ptr, (can_write_sz < wanted_write_sz) ? can_write_sz : wanted_write_sz);
+	/* Issue a single gather write for as many queued AIO_REQs as kernel allow us to - WRITEV updates each AIO_REQ offset */
+	wrote_sz = EvAIOReqQueueWriteVectored(&ipc_base_child->write_queue, fd, can_write_sz);
 
 	/* The write was interrupted by a signal or we were not able to write any data to it, reschedule and return. */
 	if (wrote_sz == -1)
 	{
-		/* RENQUEUE AIO_REQ, either for destruction or for another write attempt */
-		EvAIOReqQueueEnqueueHead(&ipc_base_child->write_queue, cur_aio_req);
-		cur_aio_req->err = errno;
+		cur_aio_req			= EvAIOReqQueuePointToHead(&ipc_base_child->write_queue);
+		cur_aio_req->err	= errno;
 
 		if (errno == EINTR || errno == EAGAIN)
 		{
@@ -506,15 +499,16 @@ static int EvICPBaseChildEventWrite(int fd, int can_write_sz, int thrd_id, void
 		return total_wrote_sz;
 	}
 
-	/* Write_ok, update offset and counter */
-	cur_aio_req->data.offset	+= wrote_sz;
-	total_wrote_sz				+= wrote_sz;
+	total_wrote_sz = wrote_sz;
 
-	/* Write is complete */
-	if (cur_aio_req->data.offset >= cur_aio_req->data.size)
+	/* Finish every AIO_REQ at HEAD that has been fully written */
+	while ((cur_aio_req = EvAIOReqQueuePointToHead(&ipc_base_child->write_queue)) && (EvAIOReqGetMissingSize(cur_aio_req) <= 0))
 	{
-		KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO, LOGCOLOR_RED, "FD [%d] - FULL write of [%d] bytes - Wanted [%lu] - Offset is now [%lu] on THREAD [%d]\n",
-				fd, wrote_sz, wanted_write_sz, cur_aio_req->data.offset, thrd_id);
+		KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO, LOGCOLOR_RED, "FD [%d] - FULL write - Offset is now [%lu] on THREAD [%d]\n",
+				fd, cur_aio_req->data.offset, thrd_id);
+
+		/* Remove from WRITE_QUEUE */
+		EvAIOReqQueueDequeue(&ipc_base_child->write_queue);
 
 		/* Dispatch write finish event, if there is anyone interested */
 		if (cur_aio_req->finish_cb)
@@ -522,48 +516,18 @@ static int EvICPBaseChildEventWrite(int fd, int can_write_sz, int thrd_id, void
 
 		/* Destroy current aio_req */
 		EvAIOReqDestroy(cur_aio_req);
-
-		/* Next aio_req exists, loop writing some more or reschedule write event */
-		if (!EvAIOReqQueueIsEmpty(&ipc_base_child->write_queue))
-		{
-			DLinkedList *aio_req_list = &ipc_base_child->write_queue.aio_req_list;
-
-			/* Get a reference to next element */
-			cur_aio_req = (EvAIOReq*)aio_req_list->head->data;
-
-			/* Calculate wanted data size and how many bytes we have left to write */
-			wanted_write_sz		= cur_aio_req->data.size - cur_aio_req->data.offset;
-			still_can_write_sz	= can_write_sz - total_wrote_sz;
-
-			/* Keep writing as many aio_reqs the kernel allow us to */
-			if (wanted_write_sz <= still_can_write_sz)
-			{
-				KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO, LOGCOLOR_RED, "FD [%d] - We can still write [%d] bytes qnd next aio_req wants [%d] bytes, loop to grab it\n",
-						fd, still_can_write_sz, wanted_write_sz);
-				goto write_again;
-			}
-			/* No more room to write, reschedule write event */
-			else
-			{
-				KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO, LOGCOLOR_RED, "FD [%d] - We can still write [%d] bytes qnd next aio_req wants [%d] bytes, reeschedule WRITE_EV\n",
-						fd, still_can_write_sz, wanted_write_sz);
-
-				/* Reschedule write event */
-				EvKQBaseSetEvent(ev_base, fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, EvICPBaseChildEventWrite, ipc_base_child);
-			}
-		}
 	}
-	else
+
+	/* Partial write, or more AIO_REQs than one WRITEV can take, reschedule write event */
+	if (!EvAIOReqQueueIsEmpty(&ipc_base_child->write_queue))
 	{
-		KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO, LOGCOLOR_RED, "FD [%d] - PARTIAL write of [%d] bytes - Offset is now [%d]\n", fd, wrote_sz, cur_aio_req->data.offset);
+		KQBASE_LOG_PRINTF(ipc_base_child->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - Wrote [%d] bytes, [%ld] AIO_REQs left, RESCHEDULE WRITE_EV\n",
+				fd, total_wrote_sz, EvAIOReqQueueGetQueueCount(&ipc_base_child->write_queue));
 
-		/* REENQUEUE and reschedule write event */
-		EvAIOReqQueueEnqueueHead(&ipc_base_child->write_queue, cur_aio_req);
 		EvKQBaseSetEvent(ev_base, fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, EvICPBaseChildEventWrite, ipc_base_child);
 	}
 
 	return total_wrote_sz;
-
 }
 /**************************************************************************************************************************/
 static int EvICPBaseChildEventClose(int fd, int read_sz, int thrd_id, void *cb_data, void *base_ptr)
@@ -37,19 +37,17 @@ int CommEvTCPAIOWrite(struct _EvKQBase *ev_base, struct _EvKQBaseLogBase *log_ba
 		int can_write_sz, int invoke_cb)
 {
 	EvBaseKQFileDesc *kq_fd;
-	EvAIOReq *aio_req_deq;
 	EvAIOReq *aio_req;
-	long wanted_write_sz;
-	long possible_write_sz;
-	int wrote_sz;
-	char *data_ptr;
+	long wrote_sz;
+	int fd;
 
 	/* Initialize IO_RESULT */
 	ioret->aio_total_sz = 0;
 	ioret->aio_count	= 0;
 
+	/* Kernel did not tell us how much we can write, offer the whole batch and let non-blocking socket take what it can */
 	if (can_write_sz <= 0)
-		can_write_sz 	= 8096;
+		can_write_sz 	= INT_MAX;
 
 	/* Grab HEAD AIO request */
 	write_again:
@@ -60,23 +58,11 @@ int CommEvTCPAIOWrite(struct _EvKQBase *ev_base, struct _EvKQBaseLogBase *log_ba
 		return COMM_TCP_AIO_WRITE_FINISHED;
 
 	/* Grab AIO_REQ FD underneath KQ_FD */
-	kq_fd				= EvKQBaseFDGrabFromArena(ev_base, aio_req->fd);
-
-	/* Calculate current data size and offset */
-	wanted_write_sz		= EvAIOReqGetMissingSize(aio_req);
-	data_ptr			= EvAIOReqGetDataPtr(aio_req);
-	possible_write_sz	= ((can_write_sz < wanted_write_sz) ? can_write_sz : wanted_write_sz);
+	fd					= aio_req->fd;
+	kq_fd				= EvKQBaseFDGrabFromArena(ev_base, fd);
 
-	/* This AIO_REQ wants to write zero bytes. Just dequeue */
-	if (0 == possible_write_sz)
-	{
-		KQBASE_LOG_PRINTF(log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - AIO_ID [%d] - CAN [%d] - WANT [%d] - POSSIBLE [%d] - POS [%ld / %ld] - Zero Possible!\n",
-				aio_req->fd, aio_req->id, can_write_sz, wanted_write_sz, possible_write_sz, aio_req->data.offset, aio_req->data.size);
-		goto finished;
-	}
-
-	/* Issue write call - Either what we want to write, if possible. Otherwise, write what kernel tells us we can */
-	wrote_sz			= write(aio_req->fd, data_ptr, possible_write_sz);
+	/* Issue a single gather write for as many consecutive AIO_REQs as we can, kernel may take only part of it */
+	wrote_sz			= EvAIOReqQueueWriteVectored(&iodata->write_queue, fd, can_write_sz);
 
 	/* The write was interrupted by a signal or we were not able to write any data to it, reschedule and return. */
 	if (-1 == wrote_sz)
@@ -87,14 +73,14 @@ int CommEvTCPAIOWrite(struct _EvKQBase *ev_base, struct _EvKQBaseLogBase *log_ba
 		/* NON_FATAL error */
 		if ((!kq_fd->flags.so_write_eof) && (errno == EINTR || errno == EAGAIN))
 		{
-			KQBASE_LOG_PRINTF(log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - AIO_ID [%d] - Non fatal write error - [%s] - CAN [%d] - TRIED [%d] - TOTAL [%d]\n",
-					aio_req->fd, aio_req->id, (errno == EINTR ? "EINTR" : "EAGAIN"), can_write_sz, possible_write_sz, ioret->aio_total_sz);
+			KQBASE_LOG_PRINTF(log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - AIO_ID [%d] - Non fatal write error - [%s] - CAN [%d] - TOTAL [%d]\n",
+					fd, aio_req->id, (errno == EINTR ? "EINTR" : "EAGAIN"), can_write_sz, ioret->aio_total_sz);
 			return COMM_TCP_AIO_WRITE_NEEDED;
 		}
 
 		/* FATAL write error */
-		KQBASE_LOG_PRINTF(log_base, LOGTYPE_DEBUG, LOGCOLOR_RED, "FD [%d] - AIO_ID [%d] - Fatal write error - CAN [%d] - TRIED [%d] - TOTAL [%d] - ERR [%d]\n",
-				aio_req->fd, aio_req->id, can_write_sz, possible_write_sz, ioret->aio_total_sz, aio_req->err);
+		KQBASE_LOG_PRINTF(log_base, LOGTYPE_DEBUG, LOGCOLOR_RED, "FD [%d] - AIO_ID [%d] - Fatal write error - CAN [%d] - TOTAL [%d] - ERR [%d]\n",
+				fd, aio_req->id, can_write_sz, ioret->aio_total_sz, aio_req->err);
 
 		/* Remove AIO_REQ from WRITE_QUEUE */
 		EvAIOReqQueueDequeue(&iodata->write_queue);
@@ -103,8 +89,8 @@ int CommEvTCPAIOWrite(struct _EvKQBase *ev_base, struct _EvKQBaseLogBase *log_ba
 		if (invoke_cb)
 		{
 			KQBASE_LOG_PRINTF(log_base, LOGTYPE_DEBUG, LOGCOLOR_GREEN, "FD [%d] - AIO_ID [%d] - Will invoke CB_FUNC at [%p / %p]\n",
-					aio_req->fd, aio_req->id, aio_req->finish_cb, aio_req->finish_cbdata);
-			EvAIOReqInvokeCallBacks(aio_req, 1, aio_req->fd, -1, -1, parent);
+					fd, aio_req->id, aio_req->finish_cb, aio_req->finish_cbdata);
+			EvAIOReqInvokeCallBacks(aio_req, 1, fd, -1, -1, parent);
 		}
 
 		/* Destroy AIO_REQ */
@@ -114,36 +100,39 @@ int CommEvTCPAIOWrite(struct _EvKQBase *ev_base, struct _EvKQBaseLogBase *log_ba
 	/* This should not happen */
 	else if (0 == wrote_sz)
 	{
-		KQBASE_LOG_PRINTF(log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - AIO_ID [%d] - TRIED [%d] - POS [%ld / %ld] - Syscall write returned ZERO\n",
-				aio_req->fd, aio_req->id, possible_write_sz, aio_req->data.offset, aio_req->data.size);
+		KQBASE_LOG_PRINTF(log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - AIO_ID [%d] - CAN [%d] - POS [%ld / %ld] - Syscall writev returned ZERO\n",
+				fd, aio_req->id, can_write_sz, aio_req->data.offset, aio_req->data.size);
 	}
+	else
+	{
+		/* TOUCH statistics - Owner may not keep any */
+		if (stats)
+		{
+			stats->total[COMM_CURRENT].byte_tx		+= wrote_sz;
+			stats->total[COMM_CURRENT].packet_tx	+= 1;
+		}
 
-	/* TOUCH statistics */
-	stats->total[COMM_CURRENT].byte_tx		+= wrote_sz;
-	stats->total[COMM_CURRENT].packet_tx	+= 1;
-
-	/* Write_ok, update offset and counter */
-	aio_req->data.offset					+= wrote_sz;
-	ioret->aio_total_sz						+= wrote_sz;
-	can_write_sz							-= wrote_sz;
+		/* Write_ok, update counter - WRITEV already updated offset of each AIO_REQ */
+		ioret->aio_total_sz						+= wrote_sz;
+		can_write_sz							-= wrote_sz;
+	}
 
-	/* Write is complete */
-	if (aio_req->data.offset >= aio_req->data.size)
+	/* Finish every AIO_REQ at HEAD that has been fully written */
+	while ((aio_req = EvAIOReqQueuePointToHead(&iodata->write_queue)) && (aio_req->fd == fd) && (EvAIOReqGetMissingSize(aio_req) <= 0))
 	{
-		finished:
-
-		KQBASE_LOG_PRINTF(log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - AIO_ID [%d] - Finished writing [%d] bytes - Wanted [%ld] - Offset is now [%ld]\n",
-				aio_req->fd, aio_req->id, wrote_sz, wanted_write_sz, aio_req->data.offset);
+		KQBASE_LOG_PRINTF(log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - AIO_ID [%d] - Finished writing - Offset is now [%ld]\n",
+				fd, aio_req->id, aio_req->data.offset);
 
 		/* Remove AIO_REQ from WRITE_QUEUE */
 		EvAIOReqQueueDequeue(&iodata->write_queue);
+		ioret->aio_count++;
 
 		/* Invoke WRITE_CB if set to do it */
 		if (invoke_cb)
 		{
 			KQBASE_LOG_PRINTF(log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - AIO_ID [%d] - Will invoke CB_FUNC at [%p / %p]\n",
-					aio_req->fd, aio_req->id, aio_req->finish_cb, aio_req->finish_cbdata);
-			EvAIOReqInvokeCallBacks(aio_req, 1, aio_req->fd, aio_req->data.offset, -1, parent);
+					fd, aio_req->id, aio_req->finish_cb, aio_req->finish_cbdata);
+			EvAIOReqInvokeCallBacks(aio_req, 1, fd, aio_req->data.offset, -1, parent);
 		}
 
 		/* Destroy AIO_REQ */
@@ -152,20 +141,18 @@ int CommEvTCPAIOWrite(struct _EvKQBase *ev_base, struct _EvKQBaseLogBase *log_ba
 		/* Closed flag set, we are already destroyed, just bail out */
 		if ((kq_fd->flags.closed) || (kq_fd->flags.closing))
 			return COMM_TCP_AIO_WRITE_FINISHED;
+	}
 
-		/* Still can write some more bytes */
-		if (can_write_sz > 0)
-			goto write_again;
-
-		/* If there are no AIO_REQ left, reply finished. Otherwise, NEEDED */
-		if (EvAIOReqQueueIsEmpty(&iodata->write_queue))
-			return COMM_TCP_AIO_WRITE_FINISHED;
+	/* If there are no AIO_REQ left, reply finished */
+	if (EvAIOReqQueueIsEmpty(&iodata->write_queue))
+		return COMM_TCP_AIO_WRITE_FINISHED;
 
-		return COMM_TCP_AIO_WRITE_NEEDED;
-	}
+	/* Untouched AIO_REQ at HEAD means kernel took the whole batch. Still can write some more bytes, so gather next one */
+	if ((wrote_sz > 0) && (can_write_sz > 0) && (0 == EvAIOReqQueuePointToHead(&iodata->write_queue)->data.offset))
+		goto write_again;
 
-	KQBASE_LOG_PRINTF(log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - AIO_ID [%d] - CAN [%d] - Wrote [%d] bytes - POS [%ld / %ld]\n",
-			aio_req->fd, aio_req->id, can_write_sz, wrote_sz, aio_req->data.offset, aio_req->data.size);
+	KQBASE_LOG_PRINTF(log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - CAN [%d] - Wrote [%ld] bytes - Partial write, reschedule\n",
+			fd, can_write_sz, wrote_sz);
 
 	return COMM_TCP_AIO_WRITE_NEEDED;
 }
@@ -50,6 +50,11 @@ static int CommEvTCPClientBindSource(CommEvTCPClient *ev_tcpclient);
 
 static EvBaseKQObjDestroyCBH CommEvTCPClientObjectDestroyCBH;
 
+/* Write queue backpressure */
+static EvAIOReqQueueWatermarkCBH CommEvTCPClientWriteQueueWatermarkCB;
+static CommEvBackpressureReadCtlCBH CommEvTCPClientBackpressureReadCtl;
+static EvBaseKQJobCBH CommEvTCPClientBackpressureJob;
+
 /**************************************************************************************************************************/
 CommEvTCPClient *CommEvTCPClientNew(EvKQBase *kq_base)
 {
@@ -102,6 +107,7 @@ int CommEvTCPClientInit(EvKQBase *kq_base, CommEvTCPClient *ev_tcpclient, int cl
 
 	ev_tcpclient->dnsdata.req_id						= -1;
 	ev_tcpclient->ssldata.shutdown_jobid		= -1;
+	ev_tcpclient->backpressure_jobid			= -1;
 
 	/* Initialize all timers */
 	ev_tcpclient->timers.reconnect_id			= -1;
@@ -140,6 +146,10 @@ int CommEvTCPClientInit(EvKQBase *kq_base, CommEvTCPClient *ev_tcpclient, int cl
 	EvAIOReqQueueInit(ev_tcpclient->kq_base, &ev_tcpclient->iodata.write_queue, 4096,
 			(ev_tcpclient->kq_base->flags.mt_engine ? AIOREQ_QUEUE_MT_SAFE : AIOREQ_QUEUE_MT_UNSAFE), AIOREQ_QUEUE_SIMPLE);
 
+	/* Start unpaired and without watermarks, callback is always there as SHED may come from an account */
+	CommEvBackpressureInit(&ev_tcpclient->backpressure, ev_tcpclient, CommEvTCPClientBackpressureReadCtl);
+	CommEvTCPClientWatermarkSet(ev_tcpclient, 0, 0);
+
 	KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_DEBUG, LOGCOLOR_RED, "FD [%d] - Init at [%p]\n", ev_tcpclient->socket_fd, ev_tcpclient);
 
 	return COMM_CLIENT_INIT_OK;
@@ -183,6 +193,9 @@ void CommEvTCPClientShutdown(CommEvTCPClient *ev_tcpclient)
 	EvKQJobsCtl(ev_tcpclient->kq_base, JOB_ACTION_DELETE, ev_tcpclient->ssldata.shutdown_jobid);
 	ev_tcpclient->ssldata.shutdown_jobid = -1;
 
+	/* Leave aggregate account, memory is about to go away */
+	EvAIOReqQueueAccountUnlink(&ev_tcpclient->iodata.write_queue);
+
 	/* Cancel any possible timer or events */
 	CommEvTCPClientTimersCancelAll(ev_tcpclient);
 	CommEvTCPClientEventCancelAll(ev_tcpclient);
@@ -258,6 +271,7 @@ int CommEvTCPClientConnect(CommEvTCPClient *ev_tcpclient, CommEvTCPClientConf *e
 	ev_tcpclient->flags.calculate_datarate					= ev_tcpclient_conf->flags.calculate_datarate;
 	ev_tcpclient->flags.ssl_null_cypher						= ev_tcpclient_conf->flags.ssl_null_cypher;
 	ev_tcpclient->flags.bindany_active						= ev_tcpclient_conf->flags.bindany_active;
+	ev_tcpclient->flags.read_edge							= ev_tcpclient_conf->flags.read_edge;
 
 	/* Load timeout information */
 	ev_tcpclient->timeout.connect_ms						= ev_tcpclient_conf->timeout.connect_ms;
@@ -731,8 +745,9 @@ void CommEvTCPClientEventSet(CommEvTCPClient *ev_tcpclient, CommEvTCPClientEvent
 
 	/* Reschedule READ EVENT if EV_READ has been activated */
 	if (COMM_CLIENT_EVENT_READ == ev_type)
-		EvKQBaseSetEvent(ev_tcpclient->kq_base, ev_tcpclient->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE,
-				((COMM_CLIENTPROTO_SSL == ev_tcpclient->cli_proto) ? CommEvTCPClientEventSSLRead : CommEvTCPClientEventRead), ev_tcpclient);
+	{
+		CommEvTCPClientReadReschedule(ev_tcpclient);
+	}
 
 	return;
 }
@@ -814,6 +829,41 @@ int CommEvTCPClientRatesCalculateSchedule(CommEvTCPClient *ev_tcpclient, int sch
 	return ev_tcpclient->timers.calculate_datarate_id;
 }
 /**************************************************************************************************************************/
+void CommEvTCPClientTCPInfoSamplerSet(CommEvTCPClient *ev_tcpclient, CommEvTCPInfoSampler *sampler)
+{
+	/* Takes effect on next connect, NULL stops registering */
+	ev_tcpclient->tcp_info_sampler = sampler;
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvTCPClientWatermarkSet(CommEvTCPClient *ev_tcpclient, unsigned long high_sz, unsigned long low_sz)
+{
+	/* Survives reconnects, write queue keeps it across CLEAN/INIT */
+	EvAIOReqQueueWatermarkSet(&ev_tcpclient->iodata.write_queue, high_sz, low_sz, CommEvTCPClientWriteQueueWatermarkCB, ev_tcpclient);
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvTCPClientWriteAccountSet(CommEvTCPClient *ev_tcpclient, EvAIOReqQueueAccount *account)
+{
+	/* NULL leaves current account */
+	if (account)
+		EvAIOReqQueueAccountLink(&ev_tcpclient->iodata.write_queue, account);
+	else
+		EvAIOReqQueueAccountUnlink(&ev_tcpclient->iodata.write_queue);
+
+	return;
+}
+/**************************************************************************************************************************/
+int CommEvTCPClientReadPause(CommEvTCPClient *ev_tcpclient)
+{
+	return CommEvBackpressureReadPause(&ev_tcpclient->backpressure);
+}
+/**************************************************************************************************************************/
+int CommEvTCPClientReadResume(CommEvTCPClient *ev_tcpclient)
+{
+	return CommEvBackpressureReadResume(&ev_tcpclient->backpressure);
+}
+/**************************************************************************************************************************/
 void CommEvTCPClientAddrInit(CommEvTCPClient *ev_tcpclient, char *host, unsigned short port)
 {
 	struct sockaddr_in *ipv4_addr;
@@ -951,6 +1001,10 @@ void CommEvTCPClientEventDispatchInternal(CommEvTCPClient *ev_tcpclient, int dat
 		return;
 	}
 
+	/* Feed parent pool health with replies and failures */
+	if (ev_tcpclient->parent_pool)
+		CommEvTCPClientPoolClientEventNotify(ev_tcpclient->parent_pool, ev_tcpclient, ev_type);
+
 	/* Grab callback_ptr */
 	cb_handler	= ev_tcpclient->events[ev_type].cb_handler_ptr;
 
@@ -977,6 +1031,19 @@ void CommEvTCPClientEventDispatchInternal(CommEvTCPClient *ev_tcpclient, int dat
 /**************************************************************************************************************************/
 void CommEvTCPClientDestroyConnReadAndWriteBuffers(CommEvTCPClient *ev_tcpclient)
 {
+	/* Cancel any pending WRITE_DRAIN or SHED job */
+	if (ev_tcpclient->backpressure_jobid > -1)
+	{
+		EvKQJobsCtl(ev_tcpclient->kq_base, JOB_ACTION_DELETE, ev_tcpclient->backpressure_jobid);
+		ev_tcpclient->backpressure_jobid = -1;
+	}
+
+	/* Leave backpressure pairing, peer we paused reads again. We are going down, so do not resume ourselves */
+	ev_tcpclient->backpressure.flags.read_paused		= 0;
+	ev_tcpclient->flags.write_drain_pending				= 0;
+	ev_tcpclient->flags.write_shed_pending				= 0;
+	CommEvBackpressureUnlink(&ev_tcpclient->backpressure);
+
 	/* Destroy any pending write event */
 	EvAIOReqQueueClean(&ev_tcpclient->iodata.write_queue);
 
@@ -992,11 +1059,17 @@ void CommEvTCPClientDestroyConnReadAndWriteBuffers(CommEvTCPClient *ev_tcpclient
 	if (ev_tcpclient->iodata.partial_read_buffer)
 		MemBufferDestroy(ev_tcpclient->iodata.partial_read_buffer);
 
+	/* Give pooled chunks back, slices duplicated by upper layers keep theirs alive */
+	MemSliceRelease(&ev_tcpclient->iodata.read_slice);
+	MemChainDestroy(ev_tcpclient->iodata.read_chain);
+
+	ev_tcpclient->iodata.read_chain = NULL;
 	ev_tcpclient->iodata.read_stream = NULL;
 	ev_tcpclient->iodata.read_buffer = NULL;
 
 	ev_tcpclient->iodata.partial_read_stream = NULL;
 	ev_tcpclient->iodata.partial_read_buffer = NULL;
+	ev_tcpclient->iodata.sync_scan_off = 0;
 
 	return;
 }
@@ -1047,7 +1120,7 @@ int CommEvTCPClientEventConnect(int fd, int data_sz, int thrd_id, void *cb_data,
 	{
 		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - Connected!\n", ev_tcpclient->socket_fd);
 
-		EvKQBaseSetEvent(ev_tcpclient->kq_base, ev_tcpclient->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPClientEventRead, ev_tcpclient);
+		CommEvTCPClientReadSchedule(ev_tcpclient, 0);
 		EvKQBaseSetEvent(ev_tcpclient->kq_base, ev_tcpclient->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPClientEventEof, ev_tcpclient);
 
 		/* Initialize WRITE_QUEUE if its not already initialized */
@@ -1066,6 +1139,11 @@ int CommEvTCPClientEventConnect(int fd, int data_sz, int thrd_id, void *cb_data,
 		}
 		else
 			ev_tcpclient->timers.calculate_datarate_id = -1;
+
+		/* Kernel TCP_INFO telemetry, sampled in batches by a single timer */
+		if (ev_tcpclient->tcp_info_sampler)
+			CommEvTCPInfoSamplerAdd(ev_tcpclient->tcp_info_sampler, &ev_tcpclient->statistics, ev_tcpclient->socket_fd, &ev_tcpclient->dst_addr,
+					(char*)&ev_tcpclient->cfg.hostname);
 	}
 
 	/* Dispatch the internal event - This could destroy EV_TCPCLIENT under our feet */
@@ -1280,6 +1358,9 @@ void CommEvTCPClientInternalDisconnect(CommEvTCPClient *ev_tcpclient)
 {
 	KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - Clean up - STATE [%d]\n", ev_tcpclient->socket_fd, ev_tcpclient->socket_state);
 
+	/* Leave TCP_INFO sampler before socket is closed, timers are only canceled below */
+	CommEvTCPInfoSamplerDel(&ev_tcpclient->statistics);
+
 	/* Will close socket and cancel any pending events of socket_fd, including the close event */
 	if (ev_tcpclient->socket_fd >= 0)
 	{
@@ -1487,6 +1568,9 @@ static int CommEvTCPClientTimersCancelAll(CommEvTCPClient *ev_tcpclient)
 	ev_tcpclient->timers.reconnect_id			= -1;
 	ev_tcpclient->timers.calculate_datarate_id	= -1;
 
+	/* Leave TCP_INFO sampler before socket is closed */
+	CommEvTCPInfoSamplerDel(&ev_tcpclient->statistics);
+
 	return 1;
 }
 /**************************************************************************************************************************/
@@ -1521,3 +1605,92 @@ static int CommEvTCPClientBindSource(CommEvTCPClient *ev_tcpclient)
 	return 0;
 }
 /**************************************************************************************************************************/
+static void CommEvTCPClientWriteQueueWatermarkCB(EvAIOReqQueue *aio_req_queue, int wm_code, void *cb_data)
+{
+	CommEvTCPClient *ev_tcpclient = cb_data;
+
+	switch (wm_code)
+	{
+	/* Remote is not keeping up with paired peer, stop reading from peer */
+	case AIOREQ_QUEUE_WATERMARK_HIGH:
+	{
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - Write queue above HIGH mark [%lu / %lu] - Pausing peer\n",
+				ev_tcpclient->socket_fd, aio_req_queue->stats.queue_sz, aio_req_queue->watermark.high_sz);
+
+		CommEvBackpressurePeerPause(&ev_tcpclient->backpressure);
+		return;
+	}
+	/* Drained, peer can read again. Upper layers are told on a JOB, as we may be deep inside WRITE_EV */
+	case AIOREQ_QUEUE_WATERMARK_LOW:
+	{
+		CommEvBackpressurePeerResume(&ev_tcpclient->backpressure);
+		ev_tcpclient->flags.write_drain_pending = 1;
+		break;
+	}
+	/* Aggregate memory cap reached and we hold the largest queue of this thread, drop us */
+	case AIOREQ_QUEUE_WATERMARK_SHED:
+	{
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Write queue of [%lu] bytes shed by memory cap\n",
+				ev_tcpclient->socket_fd, aio_req_queue->stats.queue_sz);
+
+		ev_tcpclient->flags.write_shed_pending = 1;
+		break;
+	}
+	default:
+		return;
+	}
+
+	/* Already scheduled */
+	if (ev_tcpclient->backpressure_jobid > -1)
+		return;
+
+	ev_tcpclient->backpressure_jobid = EvKQJobsAdd(ev_tcpclient->kq_base, JOB_ACTION_ADD_VOLATILE, 0, CommEvTCPClientBackpressureJob, ev_tcpclient);
+	return;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPClientBackpressureReadCtl(void *owner_ptr, int pause)
+{
+	CommEvTCPClient *ev_tcpclient = owner_ptr;
+
+	/* Not connected or going down, leave READ_EV alone */
+	if ((ev_tcpclient->socket_state != COMM_CLIENT_STATE_CONNECTED) || (ev_tcpclient->flags.close_request) || (ev_tcpclient->flags.ssl_shuting_down))
+		return 0;
+
+	/* Drop READ_EV, read handlers will not reschedule it while paused */
+	if (pause)
+	{
+		EvKQBaseSetEvent(ev_tcpclient->kq_base, ev_tcpclient->socket_fd, COMM_EV_READ, COMM_ACTION_DELETE, NULL, NULL);
+		return 1;
+	}
+
+	CommEvTCPClientReadReschedule(ev_tcpclient);
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPClientBackpressureJob(void *job, void *cbdata_ptr)
+{
+	CommEvTCPClient *ev_tcpclient = cbdata_ptr;
+
+	/* Reset JOB_ID */
+	ev_tcpclient->backpressure_jobid = -1;
+
+	/* Shed wins over drain, destroy or disconnect as requested by operator flags */
+	if (ev_tcpclient->flags.write_shed_pending)
+	{
+		ev_tcpclient->flags.write_shed_pending	= 0;
+		ev_tcpclient->flags.write_drain_pending	= 0;
+
+		COMM_EV_TCP_CLIENT_INTERNAL_FINISH(ev_tcpclient);
+		return 1;
+	}
+
+	/* Tell upper layers they can produce again */
+	if (ev_tcpclient->flags.write_drain_pending)
+	{
+		ev_tcpclient->flags.write_drain_pending = 0;
+		CommEvTCPClientEventDispatchInternal(ev_tcpclient, ev_tcpclient->iodata.write_queue.stats.queue_sz, KQEV_THRD_ID(ev_tcpclient->kq_base), COMM_CLIENT_EVENT_WRITE_DRAIN);
+	}
+
+	return 1;
+}
+/**************************************************************************************************************************/
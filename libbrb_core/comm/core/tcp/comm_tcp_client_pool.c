@@ -35,6 +35,13 @@
 #include "../include/libbrb_core.h"
 
 static EvBaseKQObjDestroyCBH CommEvTCPClientPoolObjectDestroyCBH;
+static EvBaseKQCBH CommEvTCPClientPoolHealthTimer;
+
+static int CommEvTCPClientPoolClientCanSelect(CommEvTCPClientPool *tcp_clientpool, CommEvTCPClient *ev_tcpclient, int select_connected);
+static long CommEvTCPClientPoolClientLoad(CommEvTCPClientPool *tcp_clientpool, CommEvTCPClient *ev_tcpclient);
+static int CommEvTCPClientPoolHealthyOthers(CommEvTCPClientPool *tcp_clientpool, int cli_id);
+static int CommEvTCPClientPoolGrow(CommEvTCPClientPool *tcp_clientpool);
+static int CommEvTCPClientPoolShrink(CommEvTCPClientPool *tcp_clientpool);
 
 /**************************************************************************************************************************/
 CommEvTCPClientPool *CommEvTCPClientPoolNew(struct _EvKQBase *kq_base, CommEvTCPClientPoolConf *tcp_clientpool_conf)
@@ -55,10 +62,26 @@ CommEvTCPClientPool *CommEvTCPClientPoolNew(struct _EvKQBase *kq_base, CommEvTCP
 	/* Register KQ_OBJECT */
 	EvKQBaseObjectRegister(kq_base, &tcp_clientpool->kq_obj);
 
+	tcp_clientpool->kq_base						= kq_base;
+	tcp_clientpool->health.timer_id				= -1;
+
 	/* Adjust POOL MAX SIZE */
+	if (tcp_clientpool_conf->cli_count_init > COMM_TCP_CLIENT_POOL_MAX)
+		tcp_clientpool_conf->cli_count_init = COMM_TCP_CLIENT_POOL_MAX;
+
 	if (tcp_clientpool_conf->cli_count_max > COMM_TCP_CLIENT_POOL_MAX)
 		tcp_clientpool_conf->cli_count_max = COMM_TCP_CLIENT_POOL_MAX;
 
+	if (tcp_clientpool_conf->cli_count_max < tcp_clientpool_conf->cli_count_init)
+		tcp_clientpool_conf->cli_count_max = tcp_clientpool_conf->cli_count_init;
+
+	/* Adjust POOL MIN SIZE, default is to never shrink below initial size */
+	if ((tcp_clientpool_conf->cli_count_min <= 0) || (tcp_clientpool_conf->cli_count_min > tcp_clientpool_conf->cli_count_init))
+		tcp_clientpool_conf->cli_count_min = tcp_clientpool_conf->cli_count_init;
+
+	if (tcp_clientpool_conf->health_check_ms <= 0)
+		tcp_clientpool_conf->health_check_ms = COMM_POOL_HEALTH_CHECK_MS;
+
 	/* Copy TCP client pool configuration to control structure */
 	memcpy(&tcp_clientpool->pool_conf, tcp_clientpool_conf, sizeof(CommEvTCPClientPoolConf));
 
@@ -83,11 +106,16 @@ CommEvTCPClientPool *CommEvTCPClientPoolNew(struct _EvKQBase *kq_base, CommEvTCP
 
 		/* Increment client count */
 		tcp_clientpool->client.count_init++;
+		tcp_clientpool->client.count_alloc++;
 
 		KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "TCP_CLI [%d] with socket FD [%d]\n", i, ev_tcpclient->socket_fd);
 		continue;
 	}
 
+	/* Health timer drives reply timeouts, slow client ejection and pool resizing - Always on, so unanswered writes do not pile up as load */
+	tcp_clientpool->health.timer_id = EvKQBaseTimerAdd(kq_base, COMM_ACTION_ADD_PERSIST, tcp_clientpool->pool_conf.health_check_ms,
+			CommEvTCPClientPoolHealthTimer, tcp_clientpool);
+
 	return tcp_clientpool;
 }
 /**************************************************************************************************************************/
@@ -100,6 +128,12 @@ int CommEvTCPClientPoolDestroy(CommEvTCPClientPool *tcp_clientpool)
 	if (!tcp_clientpool)
 		return 0;
 
+	/* Stop health timer */
+	if (tcp_clientpool->health.timer_id > -1)
+		EvKQBaseTimerCtl(tcp_clientpool->kq_base, tcp_clientpool->health.timer_id, COMM_ACTION_DELETE);
+
+	tcp_clientpool->health.timer_id = -1;
+
 	/* Cleanup individual TCP_CLIENTs from pool */
 	for (i = 0; i < tcp_clientpool->client.count_init; i++)
 	{
@@ -110,6 +144,10 @@ int CommEvTCPClientPoolDestroy(CommEvTCPClientPool *tcp_clientpool)
 
 	/* Clean MEM_SLOT_BASE of TCP_CLIENT pool */
 	MemSlotBaseClean(&tcp_clientpool->client.memslot);
+
+	/* Destroy per destination SSL sessions */
+	AssocArrayDestroy(tcp_clientpool->ssldata.dest_table);
+	tcp_clientpool->ssldata.dest_table = NULL;
 	tcp_clientpool = NULL;
 
 	return 1;
@@ -122,6 +160,7 @@ int CommEvTCPClientPoolConnect(CommEvTCPClientPool *tcp_clientpool, CommEvTCPCli
 
 	/* Copy TCP client pool configuration to control structure */
 	memcpy(&tcp_clientpool->cli_conf, ev_tcpclient_conf, sizeof(CommEvTCPClientConf));
+	tcp_clientpool->flags.conf_set = 1;
 
 	/* Cleanup individual TCP_CLIENTs from pool */
 	for (i = 0; i < tcp_clientpool->client.count_init; i++)
@@ -185,6 +224,8 @@ CommEvTCPClient *CommEvTCPClientPoolClientSelect(CommEvTCPClientPool *tcp_client
 	{
 	case COMM_POOL_SELECT_ROUND_ROBIN:	ev_tcpclient = CommEvTCPClientPoolClientSelectRoundRobin(tcp_clientpool, select_connected);	break;
 	case COMM_POOL_SELECT_LEAST_LOAD:	ev_tcpclient = CommEvTCPClientPoolClientSelectLeastLoad(tcp_clientpool, select_connected);	break;
+	case COMM_POOL_SELECT_POWER_OF_TWO:	ev_tcpclient = CommEvTCPClientPoolClientSelectPowerOfTwo(tcp_clientpool, select_connected);	break;
+	case COMM_POOL_SELECT_LEAST_LATENCY:	ev_tcpclient = CommEvTCPClientPoolClientSelectLeastLatency(tcp_clientpool, select_connected);	break;
 	}
 
 	return ev_tcpclient;
@@ -236,8 +277,8 @@ CommEvTCPClient *CommEvTCPClientPoolClientSelectLeastLoad(CommEvTCPClientPool *t
 //				ev_tcpclient_cur->socket_fd, ev_tcpclient_cur->cli_id_onpool, tcp_clientpool->client.count_init,
 //				ev_tcpclient_cur->iodata.write_queue.stats.queue_sz, ev_tcpclient_cur->statistics.last_write_ts, ev_tcpclient_cur->socket_state);
 
-		/* This client is disconnected, and we just want connected clients, ignore it */
-		if ((select_connected == COMM_CLIENT_STATE_CONNECTED) && (ev_tcpclient_cur->socket_state != COMM_CLIENT_STATE_CONNECTED))
+		/* This client is disconnected or ejected, and we just want connected clients, ignore it */
+		if (!CommEvTCPClientPoolClientCanSelect(tcp_clientpool, ev_tcpclient_cur, select_connected))
 			continue;
 
 		/* Use enqueued bytes for writing as a load reference */
@@ -278,12 +319,12 @@ CommEvTCPClient *CommEvTCPClientPoolClientSelectRoundRobin(CommEvTCPClientPool *
 	/* Walk clients RR */
 	for (i = 0; i < tcp_clientpool->client.count_init; i++)
 	{
-		/* Grab TCP_CLIENT and point to NEXT client in RR */
-		ev_tcpclient = MemSlotBaseSlotGrabByID(&tcp_clientpool->client.memslot, tcp_clientpool->client.rr_current);
-		tcp_clientpool->client.rr_current = ((tcp_clientpool->client.rr_current + 1) % tcp_clientpool->pool_conf.cli_count_max);
+		/* Grab TCP_CLIENT and point to NEXT client in RR - Wrap on active clients, pool may have shrunk */
+		ev_tcpclient = MemSlotBaseSlotGrabByID(&tcp_clientpool->client.memslot, (tcp_clientpool->client.rr_current % tcp_clientpool->client.count_init));
+		tcp_clientpool->client.rr_current = ((tcp_clientpool->client.rr_current + 1) % tcp_clientpool->client.count_init);
 
-		/* This client is disconnected, and we just want connected clients, ignore it */
-		if ((select_connected == COMM_CLIENT_STATE_CONNECTED) && (ev_tcpclient->socket_state != COMM_CLIENT_STATE_CONNECTED))
+		/* This client is disconnected or ejected, and we just want connected clients, ignore it */
+		if (!CommEvTCPClientPoolClientCanSelect(tcp_clientpool, ev_tcpclient, select_connected))
 			continue;
 
 		KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Selected TCP_CLIENT ID [%d]\n", ev_tcpclient->cli_id_onpool);
@@ -295,6 +336,130 @@ CommEvTCPClient *CommEvTCPClientPoolClientSelectRoundRobin(CommEvTCPClientPool *
 	return NULL;
 }
 /**************************************************************************************************************************/
+CommEvTCPClient *CommEvTCPClientPoolClientSelectPowerOfTwo(CommEvTCPClientPool *tcp_clientpool, int select_connected)
+{
+	CommEvTCPClient *ev_tcpclient_a;
+	CommEvTCPClient *ev_tcpclient_b;
+	int i;
+
+	/* Sanity check */
+	if (tcp_clientpool->client.count_init <= 0)
+		return NULL;
+
+	/* Draw two random clients and keep the less loaded one, a few draws before giving up on luck */
+	for (i = 0; i < COMM_POOL_POWER_OF_TWO_TRIES; i++)
+	{
+		ev_tcpclient_a = MemSlotBaseSlotGrabByID(&tcp_clientpool->client.memslot, (arc4random() % tcp_clientpool->client.count_init));
+		ev_tcpclient_b = MemSlotBaseSlotGrabByID(&tcp_clientpool->client.memslot, (arc4random() % tcp_clientpool->client.count_init));
+
+		if (!CommEvTCPClientPoolClientCanSelect(tcp_clientpool, ev_tcpclient_a, select_connected))
+			ev_tcpclient_a = NULL;
+
+		if (!CommEvTCPClientPoolClientCanSelect(tcp_clientpool, ev_tcpclient_b, select_connected))
+			ev_tcpclient_b = NULL;
+
+		/* Neither can be used, draw again */
+		if (!ev_tcpclient_a && !ev_tcpclient_b)
+			continue;
+
+		if (!ev_tcpclient_a)
+			ev_tcpclient_a = ev_tcpclient_b;
+		else if (ev_tcpclient_b && (CommEvTCPClientPoolClientLoad(tcp_clientpool, ev_tcpclient_b) < CommEvTCPClientPoolClientLoad(tcp_clientpool, ev_tcpclient_a)))
+			ev_tcpclient_a = ev_tcpclient_b;
+
+		KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Selected TCP_CLIENT ID [%d] with LOAD [%ld]\n",
+				ev_tcpclient_a->cli_id_onpool, CommEvTCPClientPoolClientLoad(tcp_clientpool, ev_tcpclient_a));
+
+		return ev_tcpclient_a;
+	}
+
+	/* Most of the pool is unusable, walk it all */
+	return CommEvTCPClientPoolClientSelectLeastLoad(tcp_clientpool, select_connected);
+}
+/**************************************************************************************************************************/
+CommEvTCPClient *CommEvTCPClientPoolClientSelectLeastLatency(CommEvTCPClientPool *tcp_clientpool, int select_connected)
+{
+	CommEvTCPClient *ev_tcpclient_cur 		= NULL;
+	CommEvTCPClient *ev_tcpclient_selected 	= NULL;
+	unsigned long cost_selected				= 0;
+	unsigned long cost_cur;
+	int i;
+
+	for (i = 0; i < tcp_clientpool->client.count_init; i++)
+	{
+		/* Grab the TCP client */
+		ev_tcpclient_cur 			= MemSlotBaseSlotGrabByID(&tcp_clientpool->client.memslot, i);
+
+		/* This client is disconnected or ejected, and we just want connected clients, ignore it */
+		if (!CommEvTCPClientPoolClientCanSelect(tcp_clientpool, ev_tcpclient_cur, select_connected))
+			continue;
+
+		/* EWMA latency weighted by queue depth */
+		cost_cur					= CommEvPoolHealthCost(&tcp_clientpool->health.arr[i], ev_tcpclient_cur->iodata.write_queue.stats.queue_sz);
+
+		if ((!ev_tcpclient_selected) || (cost_cur < cost_selected))
+		{
+			ev_tcpclient_selected	= ev_tcpclient_cur;
+			cost_selected			= cost_cur;
+		}
+
+		continue;
+	}
+
+	/* Found client, return */
+	if (ev_tcpclient_selected)
+	{
+		KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Selected TCP_CLIENT ID [%d] with LATENCY [%lu] us - COST [%lu]\n",
+				ev_tcpclient_selected->cli_id_onpool, tcp_clientpool->health.arr[ev_tcpclient_selected->cli_id_onpool].latency_ewma_us, cost_selected);
+
+		return ev_tcpclient_selected;
+	}
+
+	KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "No TCP client found - CLI_COUNT [%d]\n", tcp_clientpool->client.count_init);
+	return NULL;
+}
+/**************************************************************************************************************************/
+void CommEvTCPClientPoolClientEventNotify(CommEvTCPClientPool *tcp_clientpool, CommEvTCPClient *ev_tcpclient, int ev_type)
+{
+	CommEvPoolHealth *health;
+	struct timeval *now_tv;
+	int ejected;
+
+	/* Sanity check */
+	if ((ev_tcpclient->cli_id_onpool < 0) || (ev_tcpclient->cli_id_onpool >= COMM_TCP_CLIENT_POOL_MAX))
+		return;
+
+	health	= &tcp_clientpool->health.arr[ev_tcpclient->cli_id_onpool];
+	now_tv	= &ev_tcpclient->kq_base->stats.cur_invoke_tv;
+	ejected	= 0;
+
+	switch (ev_type)
+	{
+	/* Data back from peer answers the oldest pool write, feed latency EWMA */
+	case COMM_CLIENT_EVENT_READ:
+		CommEvPoolHealthReplyMark(health, now_tv, 1);
+		break;
+
+	/* Peer closing an idle connection is normal, only writes left unanswered count as failure */
+	case COMM_CLIENT_EVENT_CLOSE:
+		if (health->pending_count > 0)
+			ejected = CommEvPoolHealthFailMark(health, now_tv, (CommEvTCPClientPoolHealthyOthers(tcp_clientpool, ev_tcpclient->cli_id_onpool) > 0));
+		break;
+
+	/* Only failed connects count, a good one is judged by its replies */
+	case COMM_CLIENT_EVENT_CONNECT:
+		if (ev_tcpclient->socket_state != COMM_CLIENT_STATE_CONNECTED)
+			ejected = CommEvPoolHealthFailMark(health, now_tv, (CommEvTCPClientPoolHealthyOthers(tcp_clientpool, ev_tcpclient->cli_id_onpool) > 0));
+		break;
+	}
+
+	if (ejected)
+		KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "TCP_CLIENT ID [%d] ejected for [%d] ms - FAILS [%d]\n",
+				ev_tcpclient->cli_id_onpool, health->eject_ms, health->fail_count);
+
+	return;
+}
+/**************************************************************************************************************************/
 int CommEvTCPClientPoolHasConnected(CommEvTCPClientPool *tcp_clientpool)
 {
 	CommEvTCPClient *ev_tcpclient;
@@ -333,6 +498,10 @@ int CommEvTCPClientPoolEventSet(CommEvTCPClientPool *tcp_clientpool, CommEvTCPCl
 		continue;
 	}
 
+	/* Save it so clients added by pool growth get the same events */
+	tcp_clientpool->events[ev_type].cb_handler_ptr	= cb_handler;
+	tcp_clientpool->events[ev_type].cb_data_ptr		= cb_data;
+
 	KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "Event [%d] set for [%d] clients on pool\n", ev_type, i);
 	return 1;
 }
@@ -352,6 +521,9 @@ int CommEvTCPClientPoolEventCancel(CommEvTCPClientPool *tcp_clientpool, CommEvTC
 		continue;
 	}
 
+	tcp_clientpool->events[ev_type].cb_handler_ptr	= NULL;
+	tcp_clientpool->events[ev_type].cb_data_ptr		= NULL;
+
 	return 1;
 }
 /**************************************************************************************************************************/
@@ -370,6 +542,8 @@ int CommEvTCPClientPoolEventCancelAll(CommEvTCPClientPool *tcp_clientpool)
 		continue;
 	}
 
+	memset(&tcp_clientpool->events, 0, sizeof(tcp_clientpool->events));
+
 	return 1;
 }
 /**************************************************************************************************************************/
@@ -394,6 +568,10 @@ int CommEvTCPClientPoolAIOWrite(CommEvTCPClientPool *tcp_clientpool, int select_
 	/* Schedule write */
 	write_id = CommEvTCPClientAIOWrite(ev_tcpclient, data, data_sz, finish_cb, finish_cbdata);
 
+	/* Start latency clock, next READ on this client is taken as the reply */
+	if (write_id > 0)
+		CommEvPoolHealthWriteMark(&tcp_clientpool->health.arr[ev_tcpclient->cli_id_onpool], &tcp_clientpool->kq_base->stats.cur_invoke_tv);
+
 	return write_id;
 }
 /**************************************************************************************************************************/
@@ -413,3 +591,226 @@ static int CommEvTCPClientPoolObjectDestroyCBH(void *kq_obj_ptr, void *cb_data)
 	return 1;
 }
 /**************************************************************************************************************************/
+static int CommEvTCPClientPoolHealthTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvTCPClientPool *tcp_clientpool		= cb_data;
+	EvKQBase *kq_base						= base_ptr;
+	struct timeval *now_tv					= &kq_base->stats.cur_invoke_tv;
+	CommEvTCPClient *ev_tcpclient;
+	CommEvPoolHealth *health;
+	unsigned long ewma_total				= 0;
+	long load_total							= 0;
+	int ewma_count							= 0;
+	int healthy_count						= 0;
+	int was_ejected;
+	int i;
+
+	tcp_clientpool->client.count_online		= 0;
+
+	/* Walk active clients, collect load and pool latency reference */
+	for (i = 0; i < tcp_clientpool->client.count_init; i++)
+	{
+		ev_tcpclient	= MemSlotBaseSlotGrabByID(&tcp_clientpool->client.memslot, i);
+		health			= &tcp_clientpool->health.arr[i];
+		load_total		+= CommEvTCPClientPoolClientLoad(tcp_clientpool, ev_tcpclient);
+
+		if (ev_tcpclient->socket_state != COMM_CLIENT_STATE_CONNECTED)
+			continue;
+
+		tcp_clientpool->client.count_online++;
+
+		if (health->flags.ejected)
+			continue;
+
+		healthy_count++;
+
+		if (health->sample_count > 0)
+		{
+			ewma_total += health->latency_ewma_us;
+			ewma_count++;
+		}
+
+		continue;
+	}
+
+	tcp_clientpool->health.latency_ewma_us = ((ewma_count > 0) ? (ewma_total / ewma_count) : 0);
+
+	/* Reply timeouts and latency outliers - Never eject the last healthy client */
+	if (tcp_clientpool->pool_conf.flags.eject_slow)
+	{
+		for (i = 0; i < tcp_clientpool->client.count_init; i++)
+		{
+			health		= &tcp_clientpool->health.arr[i];
+			was_ejected	= health->flags.ejected;
+
+			CommEvPoolHealthCheck(health, now_tv, tcp_clientpool->health.latency_ewma_us, (healthy_count > 1));
+
+			if (!was_ejected && health->flags.ejected)
+			{
+				KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "TCP_CLIENT ID [%d] ejected for [%d] ms - LATENCY [%lu] us - POOL [%lu] us\n",
+						i, health->eject_ms, health->latency_ewma_us, tcp_clientpool->health.latency_ewma_us);
+
+				healthy_count--;
+			}
+
+			continue;
+		}
+	}
+	/* No ejection, just stop counting writes the peer never answered */
+	else
+	{
+		for (i = 0; i < tcp_clientpool->client.count_init; i++)
+			CommEvPoolHealthPendingExpire(&tcp_clientpool->health.arr[i], now_tv);
+	}
+
+	/* Resize between MIN and MAX */
+	if (tcp_clientpool->pool_conf.flags.auto_resize)
+	{
+		/* Hot pool, average load on online clients too high, add one */
+		if ((tcp_clientpool->client.count_online > 0) && ((load_total / tcp_clientpool->client.count_online) >= COMM_POOL_RESIZE_GROW_LOAD) &&
+				(tcp_clientpool->client.count_init < tcp_clientpool->pool_conf.cli_count_max))
+		{
+			tcp_clientpool->health.idle_ticks = 0;
+			CommEvTCPClientPoolGrow(tcp_clientpool);
+		}
+		/* Idle long enough, drop one */
+		else if (0 == load_total)
+		{
+			if ((++tcp_clientpool->health.idle_ticks >= COMM_POOL_RESIZE_SHRINK_TICKS) && (tcp_clientpool->client.count_init > tcp_clientpool->pool_conf.cli_count_min))
+			{
+				tcp_clientpool->health.idle_ticks = 0;
+				CommEvTCPClientPoolShrink(tcp_clientpool);
+			}
+		}
+		else
+			tcp_clientpool->health.idle_ticks = 0;
+	}
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPClientPoolClientCanSelect(CommEvTCPClientPool *tcp_clientpool, CommEvTCPClient *ev_tcpclient, int select_connected)
+{
+	/* Caller will take anyone */
+	if (select_connected != COMM_CLIENT_STATE_CONNECTED)
+		return 1;
+
+	if (ev_tcpclient->socket_state != COMM_CLIENT_STATE_CONNECTED)
+		return 0;
+
+	/* Ejected clients come back only as a probe, after their back-off */
+	return CommEvPoolHealthCanSelect(&tcp_clientpool->health.arr[ev_tcpclient->cli_id_onpool], &tcp_clientpool->kq_base->stats.cur_invoke_tv);
+}
+/**************************************************************************************************************************/
+static long CommEvTCPClientPoolClientLoad(CommEvTCPClientPool *tcp_clientpool, CommEvTCPClient *ev_tcpclient)
+{
+	/* Enqueued writes plus writes still waiting for reply */
+	return (ev_tcpclient->iodata.write_queue.stats.queue_sz + tcp_clientpool->health.arr[ev_tcpclient->cli_id_onpool].pending_count);
+}
+/**************************************************************************************************************************/
+static int CommEvTCPClientPoolHealthyOthers(CommEvTCPClientPool *tcp_clientpool, int cli_id)
+{
+	CommEvTCPClient *ev_tcpclient;
+	int healthy_count;
+	int i;
+
+	/* Connected and not ejected clients, other than CLI_ID */
+	for (healthy_count = 0, i = 0; i < tcp_clientpool->client.count_init; i++)
+	{
+		if (i == cli_id)
+			continue;
+
+		ev_tcpclient = MemSlotBaseSlotGrabByID(&tcp_clientpool->client.memslot, i);
+
+		if ((ev_tcpclient->socket_state == COMM_CLIENT_STATE_CONNECTED) && (!tcp_clientpool->health.arr[i].flags.ejected))
+			healthy_count++;
+
+		continue;
+	}
+
+	return healthy_count;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPClientPoolGrow(CommEvTCPClientPool *tcp_clientpool)
+{
+	CommEvTCPClient *ev_tcpclient;
+	int cli_id;
+	int op_status;
+	int i;
+
+	cli_id = tcp_clientpool->client.count_init;
+
+	/* Reuse slot left behind by a shrink, or grab a NEW one from MEM_SLOT */
+	if (cli_id < tcp_clientpool->client.count_alloc)
+		ev_tcpclient = MemSlotBaseSlotGrabByID(&tcp_clientpool->client.memslot, cli_id);
+	else
+	{
+		ev_tcpclient = MemSlotBaseSlotGrab(&tcp_clientpool->client.memslot);
+
+		/* Out of slots */
+		if (!ev_tcpclient)
+			return 0;
+
+		tcp_clientpool->client.count_alloc++;
+	}
+
+	memset(ev_tcpclient, 0, sizeof(CommEvTCPClient));
+	ev_tcpclient->parent_pool	= tcp_clientpool;
+
+	/* Common client initialization (cli_id will be client_id on pool) */
+	op_status					= CommEvTCPClientInit(tcp_clientpool->kq_base, ev_tcpclient, cli_id);
+
+	if (COMM_CLIENT_INIT_OK != op_status)
+		return 0;
+
+	CommEvPoolHealthClean(&tcp_clientpool->health.arr[cli_id]);
+	tcp_clientpool->client.count_init++;
+
+	/* Replay events set on pool */
+	for (i = 0; i < COMM_CLIENT_EVENT_LASTITEM; i++)
+	{
+		if (!tcp_clientpool->events[i].cb_handler_ptr)
+			continue;
+
+		CommEvTCPClientEventSet(ev_tcpclient, i, tcp_clientpool->events[i].cb_handler_ptr,
+				(NULL == tcp_clientpool->events[i].cb_data_ptr ? ev_tcpclient : tcp_clientpool->events[i].cb_data_ptr));
+	}
+
+	/* Pool already connected, bring new client up too */
+	if (tcp_clientpool->flags.conf_set)
+	{
+		ev_tcpclient->log_base = tcp_clientpool->cli_conf.log_base;
+		CommEvTCPClientConnect(ev_tcpclient, &tcp_clientpool->cli_conf);
+	}
+
+	KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "Pool grow - TCP_CLIENT ID [%d] - CLI_COUNT [%d/%d]\n",
+			cli_id, tcp_clientpool->client.count_init, tcp_clientpool->pool_conf.cli_count_max);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPClientPoolShrink(CommEvTCPClientPool *tcp_clientpool)
+{
+	CommEvTCPClient *ev_tcpclient;
+	int cli_id;
+
+	/* Always drop the highest ID, so active clients stay at [0, count_init) */
+	cli_id			= (tcp_clientpool->client.count_init - 1);
+	ev_tcpclient	= MemSlotBaseSlotGrabByID(&tcp_clientpool->client.memslot, cli_id);
+
+	/* Never drop a client with work in flight */
+	if (CommEvTCPClientPoolClientLoad(tcp_clientpool, ev_tcpclient) > 0)
+		return 0;
+
+	tcp_clientpool->client.count_init--;
+
+	/* Slot stays grabbed, GROW will reuse it */
+	CommEvTCPClientShutdown(ev_tcpclient);
+	CommEvPoolHealthClean(&tcp_clientpool->health.arr[cli_id]);
+
+	KQBASE_LOG_PRINTF(tcp_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "Pool shrink - TCP_CLIENT ID [%d] - CLI_COUNT [%d/%d]\n",
+			cli_id, tcp_clientpool->client.count_init, tcp_clientpool->pool_conf.cli_count_min);
+
+	return 1;
+}
+/**************************************************************************************************************************/
@@ -35,6 +35,7 @@
 #include "../include/libbrb_core.h"
 
 static int CommEvTCPClientSelfSyncReadBuffer(CommEvTCPClient *ev_tcpclient, int orig_read_sz, int thrd_id);
+static int CommEvTCPClientSelfSyncReadChain(CommEvTCPClient *ev_tcpclient, int new_data_sz, int thrd_id);
 
 /**************************************************************************************************************************/
 int CommEvTCPClientEventRead(int fd, int read_sz, int thrd_id, void *cb_data, void *base_ptr)
@@ -43,7 +44,11 @@ int CommEvTCPClientEventRead(int fd, int read_sz, int thrd_id, void *cb_data, vo
 	CommEvTCPClient *ev_tcpclient				= cb_data;
 	EvBaseKQFileDesc *kq_fd						= EvKQBaseFDGrabFromArena(ev_base, fd);
 	CommEvTCPClientEventPrototype *ev_proto		= &ev_tcpclient->events[COMM_CLIENT_EVENT_READ];
+	int read_pending							= 0;
 	int data_read								= 0;
+	int drain_count;
+	int pending_sz;
+	int drain_sz;
 
 	KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - Read event of [%d] bytes\n", fd, read_sz);
 
@@ -59,6 +64,9 @@ int CommEvTCPClientEventRead(int fd, int read_sz, int thrd_id, void *cb_data, vo
 		/* Jump into HOOK code */
 		data_read = ev_proto->cb_hook_ptr(fd, read_sz, thrd_id, cb_data, base_ptr);
 
+		/* HOOK code may leave bytes behind, so do not rely on edge triggered READ_EV */
+		read_pending = 1;
+
 		/* We are CLOSED, bail out */
 		if ((kq_fd->flags.closed) || (kq_fd->flags.closing))
 			return data_read;
@@ -69,8 +77,39 @@ int CommEvTCPClientEventRead(int fd, int read_sz, int thrd_id, void *cb_data, vo
 	}
 	/* Read buffer and invoke CBH - WARNING: This may destroy TCPCLIENT under our feet */
 	else
+	{
 		data_read = CommEvTCPClientProcessBuffer(ev_tcpclient, read_sz, thrd_id, NULL, 0);
 
+		/* Edge triggered READ_EV will not fire again for bytes already sitting in kernel, so drain socket until EAGAIN */
+		if ((data_read > 0) && (kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.edge) && (!ev_tcpclient->flags.peek_on_read))
+		{
+			for (drain_count = 0; drain_count < COMM_TCP_READ_EDGE_DRAIN_MAX; drain_count++)
+			{
+				/* Closed beneath our feet or paired peer is full */
+				if ((kq_fd->flags.closed) || (kq_fd->flags.closing) || (ev_tcpclient->socket_state != COMM_CLIENT_STATE_CONNECTED) || (ev_tcpclient->backpressure.flags.read_paused))
+					break;
+
+				/* Nothing left on kernel buffer */
+				pending_sz = EvKQBaseSocketBufferReadPendingGet(ev_base, fd);
+
+				if (pending_sz <= 0)
+					break;
+
+				/* Process what arrived in the meantime */
+				drain_sz = CommEvTCPClientProcessBuffer(ev_tcpclient, pending_sz, thrd_id, NULL, 0);
+
+				if (drain_sz <= 0)
+					break;
+
+				data_read += drain_sz;
+				continue;
+			}
+
+			/* Hit drain limit, let IO loop serve other FDs and come back to this one */
+			read_pending = (drain_count >= COMM_TCP_READ_EDGE_DRAIN_MAX);
+		}
+	}
+
 	/* We are CLOSED, bail out */
 	if ((kq_fd->flags.closed) || (kq_fd->flags.closing))
 		return data_read;
@@ -90,11 +129,41 @@ int CommEvTCPClientEventRead(int fd, int read_sz, int thrd_id, void *cb_data, vo
 
 	/* Reschedule read event - Upper layers could have closed this socket, so just RESCHEDULE READ if we are still ONLINE */
 	if (ev_tcpclient->socket_state == COMM_CLIENT_STATE_CONNECTED)
-		EvKQBaseSetEvent(ev_tcpclient->kq_base, ev_tcpclient->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPClientEventRead, ev_tcpclient);
+		CommEvTCPClientReadSchedule(ev_tcpclient, read_pending);
 
 	return data_read;
 }
 /**************************************************************************************************************************/
+int CommEvTCPClientReadSchedule(CommEvTCPClient *ev_tcpclient, int read_pending)
+{
+	/* Paused by backpressure, READ_EV is armed again on resume */
+	if (ev_tcpclient->backpressure.flags.read_paused)
+		return 0;
+
+	/* Keep a persistent EV_CLEAR READ_EV, armed once and only touched again if interest changes. PEEK never drains socket, so it can not use it */
+	if ((ev_tcpclient->flags.read_edge) && (!ev_tcpclient->flags.peek_on_read) && (!read_pending))
+		EvKQBaseSetEvent(ev_tcpclient->kq_base, ev_tcpclient->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_TRANSITION, CommEvTCPClientEventRead, ev_tcpclient);
+	else
+		EvKQBaseSetEvent(ev_tcpclient->kq_base, ev_tcpclient->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPClientEventRead, ev_tcpclient);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+int CommEvTCPClientReadReschedule(CommEvTCPClient *ev_tcpclient)
+{
+	/* Paused by backpressure, resume will reschedule */
+	if (ev_tcpclient->backpressure.flags.read_paused)
+		return 0;
+
+	/* We are running SSL, read accordingly */
+	if (COMM_CLIENTPROTO_SSL == ev_tcpclient->cli_proto)
+		EvKQBaseSetEvent(ev_tcpclient->kq_base, ev_tcpclient->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPClientEventSSLRead, ev_tcpclient);
+	else
+		CommEvTCPClientReadSchedule(ev_tcpclient, 0);
+
+	return 1;
+}
+/**************************************************************************************************************************/
 int CommEvTCPClientEventEof(int fd, int buf_read_sz, int thrd_id, void *cb_data, void *base_ptr)
 {
 	CommEvTCPClient *ev_tcpclient	= cb_data;
@@ -146,6 +215,34 @@ int CommEvTCPClientProcessBuffer(CommEvTCPClient *ev_tcpclient, int read_sz, int
 	switch (ev_tcpclient->read_mthd)
 	{
 	/*********************************************************************/
+	case COMM_CLIENT_READ_MEMCHAIN:
+	{
+		/* Create a new read_chain object, it holds no memory while empty */
+		if (!ev_tcpclient->iodata.read_chain)
+			ev_tcpclient->iodata.read_chain = MemChainNew();
+
+		/* SSL path already decrypted READ_BUF_SZ bytes into chain tail */
+		if (read_buf_sz > 0)
+		{
+			data_read_cur	= MemChainGetSize(ev_tcpclient->iodata.read_chain) - read_buf_sz;
+			data_read		= read_buf_sz;
+		}
+		/* Grab data from FD directly into pooled chunks, zero-copy */
+		else
+		{
+			data_read_cur	= MemChainGetSize(ev_tcpclient->iodata.read_chain);
+			data_read		= MemChainAppendFromFD(ev_tcpclient->iodata.read_chain, read_sz, ev_tcpclient->socket_fd, (ev_tcpclient->flags.peek_on_read ? MSG_PEEK : 0));
+
+			/* Failed reading FD */
+			if (data_read <= 0)
+				return -1;
+		}
+
+		/* Allow upper layers to perform data transformation over new bytes */
+		EvAIOReqTransform_ReadChain(&ev_tcpclient->transform, ev_tcpclient->iodata.read_chain, data_read_cur);
+		break;
+	}
+	/*********************************************************************/
 	case COMM_CLIENT_READ_MEMBUFFER:
 	{
 		/* Create a new read_buffer object */
@@ -264,7 +361,11 @@ int CommEvTCPClientProcessBuffer(CommEvTCPClient *ev_tcpclient, int read_sz, int
 	if (ev_tcpclient->cfg.flags.self_sync)
 	{
 		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - SELF_SYNC with [%d] bytes\n", ev_tcpclient->socket_fd, read_sz);
-		CommEvTCPClientSelfSyncReadBuffer(ev_tcpclient, read_sz, thrd_id);
+
+		if (COMM_CLIENT_READ_MEMCHAIN == ev_tcpclient->read_mthd)
+			CommEvTCPClientSelfSyncReadChain(ev_tcpclient, data_read, thrd_id);
+		else
+			CommEvTCPClientSelfSyncReadBuffer(ev_tcpclient, read_sz, thrd_id);
 	}
 	/* Dispatch event - This upper layer event can make conn_hnd->socket_fd get disconnected, and destroy IO buffers beneath our feet */
 	else
@@ -283,12 +384,12 @@ static int CommEvTCPClientSelfSyncReadBuffer(CommEvTCPClient *ev_tcpclient, int
 {
 	EvKQBase *ev_base			= ev_tcpclient->kq_base;
 
-	char *partial_ptr;
 	char *read_buffer_ptr;
 	char *request_str_ptr;
 	int request_str_sz;
 	int remaining_sz;
-	int i, j;
+	long scan_off;
+	long i;
 
 	char *token_str				= (char*)&ev_tcpclient->cfg.self_sync.token_str_buf;
 	int max_buffer_sz			= ev_tcpclient->cfg.self_sync.max_buffer_sz;
@@ -313,26 +414,27 @@ static int CommEvTCPClientSelfSyncReadBuffer(CommEvTCPClient *ev_tcpclient, int
 	//printf("CommEvTCPClientSelfSyncReadBuffer - REQ_SZ [%d] - TOKEN_SZ [%d]\n", request_str_sz, token_sz);
 	//EvKQBaseLogHexDump(request_str_ptr, request_str_sz, 8, 4);
 
-	KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO,  LOGCOLOR_GREEN, "FD [%d] - Searching for token [%u] with [%d] bytes\n",
-			ev_tcpclient->socket_fd, token_str[0], token_sz);
+	/* Bytes before SCAN_OFF were already searched on a previous read with no token found, do not search them again */
+	scan_off = (ev_tcpclient->iodata.sync_scan_off <= request_str_sz) ? ev_tcpclient->iodata.sync_scan_off : 0;
 
-	/* Start searching the buffer */
-	for (j = 0, i = (request_str_sz); i >= 0; i--, j++)
-	{
-		/* Found finish of token, compare full token versus buffer */
-		if ( ((j >= token_sz) && (request_str_ptr[i] == token_str[0])) && (!memcmp(&request_str_ptr[i], token_str, token_sz)) )
-		{
-			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO,  LOGCOLOR_YELLOW, "FD [%d] - Token found at [%d] - Buffer size is [%d]\n",
-					ev_tcpclient->socket_fd, j, request_str_sz);
+	KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO,  LOGCOLOR_GREEN, "FD [%d] - Searching for token [%u] with [%d] bytes from offset [%ld]\n",
+			ev_tcpclient->socket_fd, token_str[0], token_sz, scan_off);
 
-			/* Found token */
-			token_found = 1;
-			break;
-		}
+	/* Last token in buffer closes the batch, every complete frame before it goes up in a single READ_EV */
+	i = BrbMemFindLast(request_str_ptr + scan_off, (request_str_sz - scan_off), token_str, token_sz);
 
-		continue;
+	if (i >= 0)
+	{
+		i			+= scan_off;
+		token_found	= 1;
+
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO,  LOGCOLOR_YELLOW, "FD [%d] - Token found at [%ld] - Buffer size is [%d]\n",
+				ev_tcpclient->socket_fd, i, request_str_sz);
 	}
 
+	/* Remember where next search starts, a token may still be completed by next read */
+	ev_tcpclient->iodata.sync_scan_off = token_found ? 0 : (request_str_sz - token_sz + 1);
+
 	/* Token bas been found */
 	if (token_found)
 	{
@@ -366,6 +468,9 @@ static int CommEvTCPClientSelfSyncReadBuffer(CommEvTCPClient *ev_tcpclient, int
 		char *aux_ptr00 = MemBufferDeref(ev_tcpclient->iodata.read_buffer);
 		char *aux_ptr01 = MemBufferDeref(ev_tcpclient->iodata.partial_read_buffer);
 
+		/* Upper layers will consume this buffer, search from start next time */
+		ev_tcpclient->iodata.sync_scan_off = 0;
+
 		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO,  LOGCOLOR_CYAN, "FD [%d] - MAX_BUF [%d] - READ_BUF [%d]-[%s] - PARTIAL [%d]-[%s]\n",
 				ev_tcpclient->socket_fd, max_buffer_sz, MemBufferGetSize(ev_tcpclient->iodata.read_buffer), aux_ptr00 ? aux_ptr00 : "NULL",
 						MemBufferGetSize(ev_tcpclient->iodata.partial_read_buffer), aux_ptr01 ? aux_ptr01 : "NULL");
@@ -382,3 +487,65 @@ static int CommEvTCPClientSelfSyncReadBuffer(CommEvTCPClient *ev_tcpclient, int
 	return 1;
 }
 /**************************************************************************************************************************/
+static int CommEvTCPClientSelfSyncReadChain(CommEvTCPClient *ev_tcpclient, int new_data_sz, int thrd_id)
+{
+	EvKQBase *ev_base			= ev_tcpclient->kq_base;
+	EvBaseKQFileDesc *kq_fd		= EvKQBaseFDGrabFromArena(ev_base, ev_tcpclient->socket_fd);
+	MemChain *read_chain		= ev_tcpclient->iodata.read_chain;
+	char *token_str				= (char*)&ev_tcpclient->cfg.self_sync.token_str_buf;
+	int max_buffer_sz			= ev_tcpclient->cfg.self_sync.max_buffer_sz;
+	int token_sz				= ev_tcpclient->cfg.self_sync.token_str_sz;
+	int frame_count				= 0;
+	unsigned long scan_off;
+	unsigned long frame_sz;
+	long token_off;
+
+	/* Flag not set, or chain is empty, bail out */
+	if ((!ev_tcpclient->cfg.flags.self_sync) || (!read_chain) || (token_sz <= 0))
+		return 0;
+
+	/* Bytes before this read were already scanned, only look where a token could have been completed */
+	scan_off = MemChainGetSize(read_chain) - ((new_data_sz > 0) ? new_data_sz : 0);
+	scan_off = (scan_off > (token_sz - 1)) ? (scan_off - (token_sz - 1)) : 0;
+
+	frame_sz = 0;
+
+	/* Walk every token in new bytes, batch ends right past the last one */
+	while ((token_off = MemChainFind(read_chain, scan_off, token_str, token_sz)) >= 0)
+	{
+		frame_sz = (token_off + token_sz);
+		scan_off = frame_sz;
+		frame_count++;
+	}
+
+	/* No token, but we reached our maximum allowed buffer size, flush all of it */
+	if ((0 == frame_sz) && (max_buffer_sz > 0) && (MemChainGetSize(read_chain) >= max_buffer_sz))
+		frame_sz = MemChainGetSize(read_chain);
+
+	/* Hand every complete frame to upper layers in one slice of chain memory */
+	if (frame_sz > 0)
+	{
+		/* Slice points into chunk memory when batch does not cross a chunk boundary, chain no longer holds these bytes */
+		MemChainSlicePop(read_chain, frame_sz, &ev_tcpclient->iodata.read_slice);
+
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO,  LOGCOLOR_CYAN, "FD [%d] - Dispatching READ of [%lu] bytes with [%d] frames - HEAP [%d]\n",
+				ev_tcpclient->socket_fd, frame_sz, frame_count, ev_tcpclient->iodata.read_slice.flags.heap);
+
+		/* Dispatch internal event - Upper layers must MemSliceDup it to keep data past this call */
+		CommEvTCPClientEventDispatchInternal(ev_tcpclient, frame_sz, thrd_id, COMM_CLIENT_EVENT_READ);
+
+		/* Closed flag set, slice was released with IO data, just bail out */
+		if ((kq_fd->flags.closed) || (kq_fd->flags.closing) || (!ev_tcpclient->iodata.read_chain))
+			return frame_count;
+
+		MemSliceRelease(&ev_tcpclient->iodata.read_slice);
+	}
+	else
+	{
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO,  LOGCOLOR_YELLOW, "FD [%d] - READ_CHAIN [%lu] bytes - TOKEN NOT FOUND, WILL NOT DISPATCH NOW\n",
+				ev_tcpclient->socket_fd, MemChainGetSize(read_chain));
+	}
+
+	return frame_count;
+}
+/**************************************************************************************************************************/
@@ -35,6 +35,23 @@
 #include "../include/libbrb_core.h"
 
 static EvBaseKQJobCBH CommEvTCPClientSSLShutdownJob;
+static int CommEvTCPClientSSLSessionNewCB(SSL *ssl_handle, SSL_SESSION *ssl_session);
+static SSL_SESSION *CommEvTCPClientSSLSessionLookup(CommEvTCPClient *ev_tcpclient);
+static void CommEvTCPClientSSLSessionForget(CommEvTCPClient *ev_tcpclient);
+static CommEvTCPClientSSLDest *CommEvTCPClientSSLDestGrab(CommEvTCPClient *ev_tcpclient, int create);
+static CommEvTCPClientSSLContext *CommEvTCPClientSSLContextAcquire(CommEvTCPClient *ev_tcpclient, int *ret_status);
+static void CommEvTCPClientSSLContextRelease(CommEvTCPClientSSLContext *ssl_ctxref);
+static int CommEvTCPClientSSLContextSetup(CommEvTCPClient *ev_tcpclient, SSL_CTX *ssl_context);
+static void CommEvTCPClientSSLContextKeyGen(CommEvTCPClient *ev_tcpclient, char *ret_buf);
+
+/* Contexts are shared by every client with same SSL configuration, process wide */
+static struct
+{
+	pthread_mutex_t mutex;
+	AssocArray *table;
+	DLinkedList list;
+	unsigned long generation;
+} glob_tcpclient_sslctx = { (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER, NULL, { 0 }, 1 };
 
 /**************************************************************************************************************************/
 int CommEvTCPClientSSLShutdownBegin(CommEvTCPClient *ev_tcpclient)
@@ -54,85 +71,44 @@ int CommEvTCPClientSSLShutdownBegin(CommEvTCPClient *ev_tcpclient)
 /**************************************************************************************************************************/
 int CommEvTCPClientSSLDataInit(CommEvTCPClient *ev_tcpclient)
 {
+	SSL_SESSION *ssl_session;
 	int op_status;
 
 	if (COMM_CLIENTPROTO_SSL != ev_tcpclient->cli_proto)
 		return COMM_CLIENT_INIT_OK;
 
-	/* TODO: User MUST can set client method */
-	if (!ev_tcpclient->ssldata.ssl_context)
-		ev_tcpclient->ssldata.ssl_context	= SSL_CTX_new(SSLv23_client_method());
-
-	/* Failed creating SSL context */
-	if (!ev_tcpclient->ssldata.ssl_context)
+	/* Certificates were reloaded since we took our context, move to a new one on this connect */
+	if ((ev_tcpclient->ssl_shared_ctx) && (ev_tcpclient->ssl_shared_ctx->generation != glob_tcpclient_sslctx.generation))
 	{
-		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Failed creating SSL_CONTEXT\n", ev_tcpclient->socket_fd);
-		return COMM_CLIENT_FAILURE_SSL_CONTEXT;
-	}
-
-	/* NULL CYPHER asked */
-	if (ev_tcpclient->flags.ssl_null_cypher)
-	{
-		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_GREEN, "FD [%d] - Using NULL CYPHER SSL\n", ev_tcpclient->socket_fd);
-
-		if (!SSL_CTX_set_cipher_list(ev_tcpclient->ssldata.ssl_context, "aNULL"))
-		{
-			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Failed setting NULL CIPHER\n", ev_tcpclient->socket_fd);
-			return COMM_CLIENT_FAILURE_SSL_CIPHER;
-		}
-	}
-
-	/* Has configuration, need to be done after context and before new */
-	/* Use client certificate */
-	if (ev_tcpclient->cfg.ssl.path_crt[0] != '\0' && ev_tcpclient->cfg.ssl.path_key[0] != '\0')
-	{
-		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_DEBUG, LOGCOLOR_BLUE, "FD [%d] - LOAD CERT [%s]-[%s]\n", ev_tcpclient->socket_fd,
-				(char *)&ev_tcpclient->cfg.ssl.path_crt, (char *)&ev_tcpclient->cfg.ssl.path_key);
-
-		/* Load the CERTIFICATE FILE into the SSL_CTX structure */
-		op_status 		= SSL_CTX_use_certificate_file(ev_tcpclient->ssldata.ssl_context, (char *)&ev_tcpclient->cfg.ssl.path_crt, SSL_FILETYPE_PEM);
-
-		if (op_status <= 0)
-		{
-			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Failure to use certificate [%s]\n", ev_tcpclient->socket_fd, (char *)&ev_tcpclient->cfg.ssl.path_crt);
-			return COMM_CLIENT_FAILURE_SSL_CERT;
-		}
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - SSL_CONTEXT reloaded, switching\n", ev_tcpclient->socket_fd);
 
-		/* Load the KEY FILE into the SSL_CTX structure */
-		op_status 		= SSL_CTX_use_PrivateKey_file(ev_tcpclient->ssldata.ssl_context, (char *)&ev_tcpclient->cfg.ssl.path_key, SSL_FILETYPE_PEM);
-
-		if (op_status <= 0)
+		if (ev_tcpclient->ssldata.ssl_handle)
 		{
-			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Failure to use private [%s]\n", ev_tcpclient->socket_fd, (char *)&ev_tcpclient->cfg.ssl.path_key);
-			return COMM_CLIENT_FAILURE_SSL_KEY;
+			SSL_free(ev_tcpclient->ssldata.ssl_handle);
+			ev_tcpclient->ssldata.ssl_handle = NULL;
 		}
 
-		/* Check private key consistency */
-		op_status 		= SSL_CTX_check_private_key(ev_tcpclient->ssldata.ssl_context);
-
-		if (!op_status)
-		{
-			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Private key does not match the public certificate\n", ev_tcpclient->socket_fd);
-			return COMM_CLIENT_FAILURE_SSL_MATCH;
-		}
+		CommEvTCPClientSSLContextRelease(ev_tcpclient->ssl_shared_ctx);
+		ev_tcpclient->ssl_shared_ctx		= NULL;
+		ev_tcpclient->ssldata.ssl_context	= NULL;
 	}
 
-	if (ev_tcpclient->cfg.ssl.path_ca[0] != '\0')
+	/* Grab a context shared by all clients with same SSL configuration */
+	if (!ev_tcpclient->ssldata.ssl_context)
 	{
-		/* Load CA certificate */
-		op_status 		= SSL_CTX_load_verify_locations(ev_tcpclient->ssldata.ssl_context, (char *)&ev_tcpclient->cfg.ssl.path_ca, NULL);
+		ev_tcpclient->ssl_shared_ctx = CommEvTCPClientSSLContextAcquire(ev_tcpclient, &op_status);
 
-		if (!op_status)
-		{
-			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - verify location Failed - OP [%d]\n", ev_tcpclient->socket_fd, op_status);
-			return COMM_CLIENT_FAILURE_SSL_CA;
-		}
+		/* Failed creating SSL context */
+		if (!ev_tcpclient->ssl_shared_ctx)
+			return op_status;
 
-		/* Require verification of the server's certificate by the client */
-		SSL_CTX_set_verify(ev_tcpclient->ssldata.ssl_context, SSL_VERIFY_PEER, NULL);
+		ev_tcpclient->ssldata.ssl_context = ev_tcpclient->ssl_shared_ctx->ssl_context;
 	}
 
-	if (!ev_tcpclient->ssldata.ssl_handle)
+	/* Handle used by a previous connection, clear it so it can negotiate again */
+	if (ev_tcpclient->ssldata.ssl_handle)
+		SSL_clear(ev_tcpclient->ssldata.ssl_handle);
+	else
 		ev_tcpclient->ssldata.ssl_handle	= SSL_new(ev_tcpclient->ssldata.ssl_context);
 
 	/* Failed creating SSL HANDLE */
@@ -149,6 +125,15 @@ int CommEvTCPClientSSLDataInit(CommEvTCPClient *ev_tcpclient)
 		SSL_set_tlsext_host_name(ev_tcpclient->ssldata.ssl_handle, (char*)&ev_tcpclient->cfg.sni_hostname);
 	}
 
+	/* Session callback finds us through APP_DATA */
+	SSL_set_app_data(ev_tcpclient->ssldata.ssl_handle, ev_tcpclient);
+
+	/* Offer last session we have for this destination, if still valid */
+	ssl_session = CommEvTCPClientSSLSessionLookup(ev_tcpclient);
+
+	if (ssl_session)
+		SSL_set_session(ev_tcpclient->ssldata.ssl_handle, ssl_session);
+
 	/* Attach to SOCKET_FD */
 	SSL_set_fd(ev_tcpclient->ssldata.ssl_handle, ev_tcpclient->socket_fd);
 	ev_tcpclient->ssldata.ssl_negotiatie_trycount	= 0;
@@ -170,7 +155,14 @@ int CommEvTCPClientSSLDataClean(CommEvTCPClient *ev_tcpclient)
 		ev_tcpclient->ssldata.ssl_handle = NULL;
 	}
 
-	if (ev_tcpclient->ssldata.ssl_context)
+	/* Drop our reference to shared context, or free a private one */
+	if (ev_tcpclient->ssl_shared_ctx)
+	{
+		CommEvTCPClientSSLContextRelease(ev_tcpclient->ssl_shared_ctx);
+		ev_tcpclient->ssl_shared_ctx		= NULL;
+		ev_tcpclient->ssldata.ssl_context	= NULL;
+	}
+	else if (ev_tcpclient->ssldata.ssl_context)
 	{
 		SSL_CTX_free (ev_tcpclient->ssldata.ssl_context);
 		ev_tcpclient->ssldata.ssl_context = NULL;
@@ -182,6 +174,12 @@ int CommEvTCPClientSSLDataClean(CommEvTCPClient *ev_tcpclient)
 		ev_tcpclient->ssldata.x509_cert = NULL;
 	}
 
+	if (ev_tcpclient->ssldata.ssl_session)
+	{
+		SSL_SESSION_free(ev_tcpclient->ssldata.ssl_session);
+		ev_tcpclient->ssldata.ssl_session = NULL;
+	}
+
 	return COMM_CLIENT_INIT_OK;
 }
 /**************************************************************************************************************************/
@@ -263,6 +261,7 @@ int CommEvTCPClientEventSSLNegotiate(int fd, int data_sz, int thrd_id, void *cb_
 	EvKQBase *ev_base				= base_ptr;
 	CommEvTCPClient *ev_tcpclient	= cb_data;
 	EvBaseKQFileDesc *kq_fd			= EvKQBaseFDGrabFromArena(ev_base, fd);
+	CommEvTCPClientSSLDest *ssl_dest;
 	int op_status;
 
 	KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - SSL_HANDSHAKE try [%d]\n",
@@ -322,7 +321,26 @@ int CommEvTCPClientEventSSLNegotiate(int fd, int data_sz, int thrd_id, void *cb_
 	/* SSL connected OK */
 	else
 	{
-		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - SSL handshake OK\n", ev_tcpclient->socket_fd);
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - SSL handshake OK - RESUMED [%d]\n",
+				ev_tcpclient->socket_fd, SSL_session_reused(ev_tcpclient->ssldata.ssl_handle));
+
+		ssl_dest = CommEvTCPClientSSLDestGrab(ev_tcpclient, 0);
+
+		/* Account resumed versus full handshakes */
+		if (SSL_session_reused(ev_tcpclient->ssldata.ssl_handle))
+		{
+			ev_tcpclient->ssldata.handshake.resumed++;
+
+			if (ssl_dest)
+				ssl_dest->stats.resumed++;
+		}
+		else
+		{
+			ev_tcpclient->ssldata.handshake.full++;
+
+			if (ssl_dest)
+				ssl_dest->stats.full++;
+		}
 
 		/* Set state as CONNECTED and grab PEER certificate information */
 		ev_tcpclient->socket_state		= COMM_CLIENT_STATE_CONNECTED;
@@ -355,6 +373,9 @@ int CommEvTCPClientEventSSLNegotiate(int fd, int data_sz, int thrd_id, void *cb_
 	/* Mark fail state and close socket */
 	ev_tcpclient->socket_state = COMM_CLIENT_STATE_CONNECT_FAILED_NEGOTIATING_SSL;
 
+	/* Do not offer a session that may have caused this failure again */
+	CommEvTCPClientSSLSessionForget(ev_tcpclient);
+
 	/* Dispatch the internal event */
 	KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d / %d] - FLAGS [%d / %d] - SSL_NEG_FAIL dispatch CONNECT [%s]\n",
 			ev_tcpclient->socket_fd, kq_fd->fd.num, ev_tcpclient->flags.destroy_after_connect_fail, ev_tcpclient->flags.reconnect_on_fail, ev_tcpclient->cfg.hostname);
@@ -524,6 +545,9 @@ int CommEvTCPClientEventSSLRead(int fd, int can_read_sz, int thrd_id, void *cb_d
 	EvBaseKQFileDesc *kq_fd			= EvKQBaseFDGrabFromArena(ev_base, ev_tcpclient->socket_fd);
 
 	char read_buf[COMM_TCP_SSL_READ_BUFFER_SZ];
+	unsigned long chain_space_sz;
+	char *read_ptr;
+	int read_ptr_sz;
 	int ssl_bytes_read;
 	int data_read;
 	int ssl_error;
@@ -532,9 +556,26 @@ int CommEvTCPClientEventSSLRead(int fd, int can_read_sz, int thrd_id, void *cb_d
 	if (0 == can_read_sz)
 		return 0;
 
+	read_ptr	= (char *)&read_buf;
+	read_ptr_sz	= sizeof(read_buf) - 1;
+
+	/* Decrypt straight into pooled chain tail, saving the copy from stack buffer */
+	if (COMM_CLIENT_READ_MEMCHAIN == ev_tcpclient->read_mthd)
+	{
+		if (!ev_tcpclient->iodata.read_chain)
+			ev_tcpclient->iodata.read_chain = MemChainNew();
+
+		read_ptr	= MemChainWriteReserve(ev_tcpclient->iodata.read_chain, &chain_space_sz);
+		read_ptr_sz	= chain_space_sz;
+	}
+
 	/* Clear libSSL errors and read from SSL tunnel */
 	ERR_clear_error();
-	ssl_bytes_read = SSL_read(ev_tcpclient->ssldata.ssl_handle, &read_buf, sizeof(read_buf) - 1);
+	ssl_bytes_read = SSL_read(ev_tcpclient->ssldata.ssl_handle, read_ptr, read_ptr_sz);
+
+	/* Commit what landed on chain, an empty reservation is released here */
+	if (COMM_CLIENT_READ_MEMCHAIN == ev_tcpclient->read_mthd)
+		MemChainWriteCommit(ev_tcpclient->iodata.read_chain, ((ssl_bytes_read > 0) ? ssl_bytes_read : 0));
 
 	/* Touch RAW-SIDE statistics */
 	ev_tcpclient->statistics.total[COMM_CURRENT].packet_rx	+= 1;
@@ -602,7 +643,7 @@ int CommEvTCPClientEventSSLRead(int fd, int can_read_sz, int thrd_id, void *cb_d
 		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - SUCCESS READING [%d] bytes - SZ [%d]\n",
 				ev_tcpclient->socket_fd, ssl_bytes_read, can_read_sz);
 
-		data_read = CommEvTCPClientProcessBuffer(ev_tcpclient, can_read_sz, thrd_id,  (char *)&read_buf, ssl_bytes_read);
+		data_read = CommEvTCPClientProcessBuffer(ev_tcpclient, can_read_sz, thrd_id, ((COMM_CLIENT_READ_MEMCHAIN == ev_tcpclient->read_mthd) ? NULL : read_ptr), ssl_bytes_read);
 
 		/* We are CLOSED, bail out */
 		if ((kq_fd->flags.closed) || (kq_fd->flags.closing))
@@ -622,8 +663,8 @@ int CommEvTCPClientEventSSLRead(int fd, int can_read_sz, int thrd_id, void *cb_d
 		}
 	}
 
-	/* Reschedule read event - Upper layers could have closed this socket, so just RESCHEDULE READ if we are still ONLINE */
-	if ( ((!kq_fd->flags.closed) && (!kq_fd->flags.closing)) && (ev_tcpclient->socket_state == COMM_CLIENT_STATE_CONNECTED))
+	/* Reschedule read event - Upper layers could have closed this socket, so just RESCHEDULE READ if we are still ONLINE and not paused */
+	if ( ((!kq_fd->flags.closed) && (!kq_fd->flags.closing)) && (ev_tcpclient->socket_state == COMM_CLIENT_STATE_CONNECTED) && (!ev_tcpclient->backpressure.flags.read_paused))
 		EvKQBaseSetEvent(ev_tcpclient->kq_base, ev_tcpclient->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPClientEventSSLRead, ev_tcpclient);
 
 	/* SSL read must return zero so lower layers do not get tricked by missing bytes in kernel */
@@ -760,6 +801,360 @@ int CommEvTCPClientEventSSLWrite(int fd, int can_write_sz, int thrd_id, void *cb
 
 	return can_write_sz;
 }
+void CommEvTCPClientSSLDestDestroy(CommEvTCPClientSSLDest *ssl_dest)
+{
+	/* Sanity check */
+	if (!ssl_dest)
+		return;
+
+	if (ssl_dest->ssl_session)
+		SSL_SESSION_free(ssl_dest->ssl_session);
+
+	free(ssl_dest);
+	return;
+}
+/**************************************************************************************************************************/
+unsigned long CommEvTCPClientSSLContextReload(void)
+{
+	CommEvTCPClientSSLContext *ssl_ctxref;
+	unsigned long generation;
+
+	pthread_mutex_lock(&glob_tcpclient_sslctx.mutex);
+
+	/* Bump generation, clients move to a new context on their next connect */
+	generation = ++glob_tcpclient_sslctx.generation;
+
+	/* Unlink current contexts so new connects build fresh ones, users keep theirs until they release */
+	while ((glob_tcpclient_sslctx.table) && (ssl_ctxref = DLinkedListPopHead(&glob_tcpclient_sslctx.list)))
+	{
+		AssocArrayDelete(glob_tcpclient_sslctx.table, ssl_ctxref->key_str);
+		ssl_ctxref->flags.linked = 0;
+		continue;
+	}
+
+	pthread_mutex_unlock(&glob_tcpclient_sslctx.mutex);
+
+	return generation;
+}
+/**************************************************************************************************************************/
+int CommEvTCPClientSSLContextCount(void)
+{
+	int ctx_count;
+
+	pthread_mutex_lock(&glob_tcpclient_sslctx.mutex);
+	ctx_count = (glob_tcpclient_sslctx.table ? glob_tcpclient_sslctx.list.size : 0);
+	pthread_mutex_unlock(&glob_tcpclient_sslctx.mutex);
+
+	return ctx_count;
+}
+/**************************************************************************************************************************/
+/**/
+/**************************************************************************************************************************/
+static int CommEvTCPClientSSLSessionNewCB(SSL *ssl_handle, SSL_SESSION *ssl_session)
+{
+	CommEvTCPClient *ev_tcpclient	= SSL_get_app_data(ssl_handle);
+	CommEvTCPClientSSLDest *ssl_dest;
+
+	/* Not one of our clients, let OpenSSL drop it */
+	if (!ev_tcpclient)
+		return 0;
+
+	/* Keep our own copy for CommEvTCPClientReconnect - It takes the reference OpenSSL gave us */
+	if (ev_tcpclient->ssldata.ssl_session)
+		SSL_SESSION_free(ev_tcpclient->ssldata.ssl_session);
+
+	ev_tcpclient->ssldata.ssl_session = ssl_session;
+
+	/* Share it with other pool clients going to same destination */
+	ssl_dest = CommEvTCPClientSSLDestGrab(ev_tcpclient, 1);
+
+	if (ssl_dest)
+	{
+		if (ssl_dest->ssl_session)
+			SSL_SESSION_free(ssl_dest->ssl_session);
+
+		CommEvSSLUtils_SessionRefCountInc(ssl_session, 1);
+		ssl_dest->ssl_session = ssl_session;
+		ssl_dest->stats.stored++;
+	}
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static SSL_SESSION *CommEvTCPClientSSLSessionLookup(CommEvTCPClient *ev_tcpclient)
+{
+	CommEvTCPClientSSLDest *ssl_dest = CommEvTCPClientSSLDestGrab(ev_tcpclient, 0);
+
+	/* Pool has a fresher session, negotiated by any of its clients */
+	if ((ssl_dest) && (CommEvSSLUtils_SessionIsValid(ssl_dest->ssl_session)))
+	{
+		ssl_dest->stats.offered++;
+		return ssl_dest->ssl_session;
+	}
+
+	/* Fall back to our own last session */
+	if (CommEvSSLUtils_SessionIsValid(ev_tcpclient->ssldata.ssl_session))
+		return ev_tcpclient->ssldata.ssl_session;
+
+	return NULL;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPClientSSLSessionForget(CommEvTCPClient *ev_tcpclient)
+{
+	CommEvTCPClientSSLDest *ssl_dest;
+	SSL_SESSION *ssl_session;
+
+	/* Nothing offered on this handshake */
+	if ((!ev_tcpclient->ssldata.ssl_handle) || (!(ssl_session = SSL_get_session(ev_tcpclient->ssldata.ssl_handle))))
+		return;
+
+	ssl_dest = CommEvTCPClientSSLDestGrab(ev_tcpclient, 0);
+
+	if ((ssl_dest) && (ssl_dest->ssl_session == ssl_session))
+	{
+		SSL_SESSION_free(ssl_dest->ssl_session);
+		ssl_dest->ssl_session = NULL;
+	}
+
+	if (ev_tcpclient->ssldata.ssl_session == ssl_session)
+	{
+		SSL_SESSION_free(ev_tcpclient->ssldata.ssl_session);
+		ev_tcpclient->ssldata.ssl_session = NULL;
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static CommEvTCPClientSSLDest *CommEvTCPClientSSLDestGrab(CommEvTCPClient *ev_tcpclient, int create)
+{
+	CommEvTCPClientPool *tcp_clientpool = ev_tcpclient->parent_pool;
+	CommEvTCPClientSSLDest *ssl_dest;
+	char key_str[COMM_TCP_CLIENT_SSL_DEST_KEYSZ];
+
+	/* Only pools share sessions among clients */
+	if (!tcp_clientpool)
+		return NULL;
+
+	/* Destination is the name we present on SNI, or the host we connect to, and port */
+	snprintf((char*)&key_str, sizeof(key_str), "%s:%d", ((ev_tcpclient->cfg.sni_hostname[0] != '\0') ? ev_tcpclient->cfg.sni_hostname : ev_tcpclient->cfg.hostname),
+			ev_tcpclient->cfg.port);
+
+	ssl_dest = (tcp_clientpool->ssldata.dest_table ? AssocArrayLookup(tcp_clientpool->ssldata.dest_table, (char*)&key_str) : NULL);
+
+	/* Found, or not asked to create */
+	if ((ssl_dest) || (!create))
+		return ssl_dest;
+
+	/* Destination table not initialized, initialize now */
+	if (!tcp_clientpool->ssldata.dest_table)
+		tcp_clientpool->ssldata.dest_table = AssocArrayNew(BRBDATA_THREAD_UNSAFE, 64, (ASSOCITEM_DESTROYFUNC*)CommEvTCPClientSSLDestDestroy);
+
+	ssl_dest = calloc(1, sizeof(CommEvTCPClientSSLDest));
+	strlcpy((char*)&ssl_dest->key_str, (char*)&key_str, sizeof(ssl_dest->key_str));
+	AssocArrayAdd(tcp_clientpool->ssldata.dest_table, (char*)&key_str, ssl_dest);
+
+	return ssl_dest;
+}
+/**************************************************************************************************************************/
+static CommEvTCPClientSSLContext *CommEvTCPClientSSLContextAcquire(CommEvTCPClient *ev_tcpclient, int *ret_status)
+{
+	CommEvTCPClientSSLContext *ssl_ctxref;
+	char key_str[(EVP_MAX_MD_SIZE * 2) + 1];
+	int op_status;
+
+	CommEvTCPClientSSLContextKeyGen(ev_tcpclient, (char*)&key_str);
+
+	pthread_mutex_lock(&glob_tcpclient_sslctx.mutex);
+
+	/* Registry not initialized, initialize now */
+	if (!glob_tcpclient_sslctx.table)
+	{
+		glob_tcpclient_sslctx.table = AssocArrayNew(BRBDATA_THREAD_UNSAFE, 256, NULL);
+		DLinkedListInit(&glob_tcpclient_sslctx.list, BRBDATA_THREAD_UNSAFE);
+	}
+
+	ssl_ctxref = AssocArrayLookup(glob_tcpclient_sslctx.table, (char*)&key_str);
+
+	/* Someone already built this context, share it */
+	if (ssl_ctxref)
+	{
+		ssl_ctxref->ref_count++;
+		pthread_mutex_unlock(&glob_tcpclient_sslctx.mutex);
+
+		*ret_status = COMM_CLIENT_INIT_OK;
+		return ssl_ctxref;
+	}
+
+	/* Build it once - Loading CA store and keys happens under lock, so concurrent connects do not load it twice */
+	ssl_ctxref					= calloc(1, sizeof(CommEvTCPClientSSLContext));
+	ssl_ctxref->ssl_context		= SSL_CTX_new(SSLv23_client_method());
+	ssl_ctxref->generation		= glob_tcpclient_sslctx.generation;
+	ssl_ctxref->ref_count		= 1;
+	strlcpy((char*)&ssl_ctxref->key_str, (char*)&key_str, sizeof(ssl_ctxref->key_str));
+
+	/* Failed creating SSL context */
+	if (!ssl_ctxref->ssl_context)
+	{
+		pthread_mutex_unlock(&glob_tcpclient_sslctx.mutex);
+
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Failed creating SSL_CONTEXT\n", ev_tcpclient->socket_fd);
+		free(ssl_ctxref);
+
+		*ret_status = COMM_CLIENT_FAILURE_SSL_CONTEXT;
+		return NULL;
+	}
+
+	op_status = CommEvTCPClientSSLContextSetup(ev_tcpclient, ssl_ctxref->ssl_context);
+
+	/* Failed loading configuration, do not register it */
+	if (COMM_CLIENT_INIT_OK != op_status)
+	{
+		pthread_mutex_unlock(&glob_tcpclient_sslctx.mutex);
+
+		SSL_CTX_free(ssl_ctxref->ssl_context);
+		free(ssl_ctxref);
+
+		*ret_status = op_status;
+		return NULL;
+	}
+
+	AssocArrayAdd(glob_tcpclient_sslctx.table, (char*)&ssl_ctxref->key_str, ssl_ctxref);
+	DLinkedListAdd(&glob_tcpclient_sslctx.list, &ssl_ctxref->node, ssl_ctxref);
+	ssl_ctxref->flags.linked = 1;
+
+	pthread_mutex_unlock(&glob_tcpclient_sslctx.mutex);
+
+	*ret_status = COMM_CLIENT_INIT_OK;
+	return ssl_ctxref;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPClientSSLContextRelease(CommEvTCPClientSSLContext *ssl_ctxref)
+{
+	pthread_mutex_lock(&glob_tcpclient_sslctx.mutex);
+
+	/* Still in use */
+	if (--ssl_ctxref->ref_count > 0)
+	{
+		pthread_mutex_unlock(&glob_tcpclient_sslctx.mutex);
+		return;
+	}
+
+	/* Last user gone, unlink from registry if reload did not already */
+	if (ssl_ctxref->flags.linked)
+	{
+		AssocArrayDelete(glob_tcpclient_sslctx.table, ssl_ctxref->key_str);
+		DLinkedListDelete(&glob_tcpclient_sslctx.list, &ssl_ctxref->node);
+	}
+
+	pthread_mutex_unlock(&glob_tcpclient_sslctx.mutex);
+
+	SSL_CTX_free(ssl_ctxref->ssl_context);
+	free(ssl_ctxref);
+
+	return;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPClientSSLContextSetup(CommEvTCPClient *ev_tcpclient, SSL_CTX *ssl_context)
+{
+	int op_status;
+
+	/* Sessions are kept by us, per destination, so reconnects can resume them */
+	SSL_CTX_set_session_cache_mode(ssl_context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(ssl_context, CommEvTCPClientSSLSessionNewCB);
+
+	/* NULL CYPHER asked */
+	if (ev_tcpclient->flags.ssl_null_cypher)
+	{
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_GREEN, "FD [%d] - Using NULL CYPHER SSL\n", ev_tcpclient->socket_fd);
+
+		if (!SSL_CTX_set_cipher_list(ssl_context, "aNULL"))
+		{
+			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Failed setting NULL CIPHER\n", ev_tcpclient->socket_fd);
+			return COMM_CLIENT_FAILURE_SSL_CIPHER;
+		}
+	}
+
+	/* Has configuration, need to be done after context and before new */
+	/* Use client certificate */
+	if (ev_tcpclient->cfg.ssl.path_crt[0] != '\0' && ev_tcpclient->cfg.ssl.path_key[0] != '\0')
+	{
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_DEBUG, LOGCOLOR_BLUE, "FD [%d] - LOAD CERT [%s]-[%s]\n", ev_tcpclient->socket_fd,
+				(char *)&ev_tcpclient->cfg.ssl.path_crt, (char *)&ev_tcpclient->cfg.ssl.path_key);
+
+		/* Load the CERTIFICATE FILE into the SSL_CTX structure */
+		op_status 		= SSL_CTX_use_certificate_file(ssl_context, (char *)&ev_tcpclient->cfg.ssl.path_crt, SSL_FILETYPE_PEM);
+
+		if (op_status <= 0)
+		{
+			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Failure to use certificate [%s]\n", ev_tcpclient->socket_fd, (char *)&ev_tcpclient->cfg.ssl.path_crt);
+			return COMM_CLIENT_FAILURE_SSL_CERT;
+		}
+
+		/* Load the KEY FILE into the SSL_CTX structure */
+		op_status 		= SSL_CTX_use_PrivateKey_file(ssl_context, (char *)&ev_tcpclient->cfg.ssl.path_key, SSL_FILETYPE_PEM);
+
+		if (op_status <= 0)
+		{
+			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Failure to use private [%s]\n", ev_tcpclient->socket_fd, (char *)&ev_tcpclient->cfg.ssl.path_key);
+			return COMM_CLIENT_FAILURE_SSL_KEY;
+		}
+
+		/* Check private key consistency */
+		op_status 		= SSL_CTX_check_private_key(ssl_context);
+
+		if (!op_status)
+		{
+			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Private key does not match the public certificate\n", ev_tcpclient->socket_fd);
+			return COMM_CLIENT_FAILURE_SSL_MATCH;
+		}
+	}
+
+	if (ev_tcpclient->cfg.ssl.path_ca[0] != '\0')
+	{
+		/* Load CA certificate */
+		op_status 		= SSL_CTX_load_verify_locations(ssl_context, (char *)&ev_tcpclient->cfg.ssl.path_ca, NULL);
+
+		if (!op_status)
+		{
+			KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - verify location Failed - OP [%d]\n", ev_tcpclient->socket_fd, op_status);
+			return COMM_CLIENT_FAILURE_SSL_CA;
+		}
+
+		/* Require verification of the server's certificate by the client */
+		SSL_CTX_set_verify(ssl_context, SSL_VERIFY_PEER, NULL);
+	}
+
+	return COMM_CLIENT_INIT_OK;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPClientSSLContextKeyGen(CommEvTCPClient *ev_tcpclient, char *ret_buf)
+{
+	static const char hex_chars[] = "0123456789abcdef";
+	unsigned char digest_buf[EVP_MAX_MD_SIZE];
+	unsigned int digest_sz = 0;
+	char key_buf[4352];
+	int key_sz;
+	int i;
+
+	/* Everything that changes what we load into context - Verify mode, cipher list, CA, client certificate and SNI */
+	key_sz = snprintf((char*)&key_buf, sizeof(key_buf), "V%d|C%d|%s|%s|%s|%s", ((ev_tcpclient->cfg.ssl.path_ca[0] != '\0') ? SSL_VERIFY_PEER : SSL_VERIFY_NONE),
+			ev_tcpclient->flags.ssl_null_cypher, ev_tcpclient->cfg.ssl.path_ca, ev_tcpclient->cfg.ssl.path_crt, ev_tcpclient->cfg.ssl.path_key, ev_tcpclient->cfg.sni_hostname);
+
+	if (key_sz >= sizeof(key_buf))
+		key_sz = sizeof(key_buf) - 1;
+
+	/* Hash it down to a fixed size key */
+	EVP_Digest(key_buf, key_sz, (unsigned char*)&digest_buf, &digest_sz, EVP_sha256(), NULL);
+
+	for (i = 0; i < digest_sz; i++)
+	{
+		ret_buf[(i * 2)]		= hex_chars[(digest_buf[i] >> 4)];
+		ret_buf[(i * 2) + 1]	= hex_chars[(digest_buf[i] & 0x0F)];
+	}
+
+	ret_buf[(i * 2)] = '\0';
+	return;
+}
 /**************************************************************************************************************************/
 /**/
 /**************************************************************************************************************************/
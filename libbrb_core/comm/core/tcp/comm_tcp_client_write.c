@@ -376,6 +376,16 @@ static void CommEvTCPClientEnqueueAndKickWriteQueue(CommEvTCPClient *ev_tcpclien
 		return;
 	}
 
+	/* Aggregate memory cap reached, refuse */
+	if (!EvAIOReqQueueCanEnqueue(&ev_tcpclient->iodata.write_queue, aio_req->data.size))
+	{
+		KQBASE_LOG_PRINTF(ev_tcpclient->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - Cannot enqueue - Memory cap reached\n", ev_tcpclient->socket_fd);
+
+		EvAIOReqInvokeCallBacks(aio_req, 1, aio_req->fd, -1, -1, aio_req->parent_ptr);
+		EvAIOReqDestroy(aio_req);
+		return;
+	}
+
 	/* Allow upper layers to transform data */
 	EvAIOReqTransform_WriteData(&ev_tcpclient->transform, &ev_tcpclient->iodata.write_queue, aio_req);
 
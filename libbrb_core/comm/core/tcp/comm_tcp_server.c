@@ -57,6 +57,10 @@ static EvBaseKQCBH CommEvTCPServerEventClose;
 
 static EvBaseKQCBH CommEvTCPServerConnRatesCalculateTimer;
 
+/* Multi-threaded listener jobs, run on worker INBOX */
+static EvBaseKQCBH CommEvTCPServerListenerThreadInit;
+static EvBaseKQCBH CommEvTCPServerListenerThreadClose;
+
 /* PLAINTEXT IO events */
 static EvBaseKQCBH CommEvTCPServerEventWrite;
 static EvBaseKQCBH CommEvTCPServerEventRead;
@@ -69,12 +73,15 @@ static EvBaseKQCBH CommEvTCPServerEventSSLRead;
 static EvBaseKQCBH CommEvTCPServerEventSSLWrite;
 
 static int CommEvTCPServerListenerTCPInit(CommEvTCPServer *srv_ptr, CommEvTCPServerConf *server_conf, CommEvTCPServerListener *listener);
+static void CommEvTCPServerListenerThreadsShutdown(CommEvTCPServer *srv_ptr, CommEvTCPServerListener *listener);
 static int CommEvTCPServerListenInet(CommEvTCPServer *srv_ptr, int slot_id);
 static int CommEvTCPServerListenUnix(CommEvTCPServer *srv_ptr, int listener_id, char *path_str);
 static void CommEvTCPServerDispatchEvent(CommEvTCPServer *srv_ptr, CommEvTCPServerConn *conn_hnd, int data_sz, int thrd_id, int ev_type);
 static int CommEvTCPServerSelfSyncReadBuffer(CommEvTCPServerConn *conn_hnd, int orig_read_sz, int thrd_id);
+static int CommEvTCPServerSelfSyncReadChain(CommEvTCPServerConn *conn_hnd, int new_data_sz, int thrd_id);
 static int CommEvTCPServerEventProcessBuffer(CommEvTCPServerConn *conn_hnd, int read_sz, int thrd_id, char *read_buf, int read_buf_sz);
-static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, CommEvTCPServerListener *listener, int conn_fd, int accept_queue_sz, int thrd_id);
+static void CommEvTCPServerEventReadSchedule(CommEvTCPServerConn *conn_hnd, int read_pending);
+static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, EvKQBase *ev_base, CommEvTCPServerListener *listener, int conn_fd, struct sockaddr_storage *peer_addr, int accept_queue_sz, int thrd_id);
 
 static EvBaseKQObjDestroyCBH CommEvTCPServerObjectDestroyCBH;
 
@@ -86,6 +93,34 @@ static CommEvUNIXGenericCBH CommEvTCPServerUNIXEventClose;
 static int CommEvTCPServerDoDestroy(CommEvTCPServer *srv_ptr);
 static int CommEvTCPServerDoDestroy_SSLCleanup(CommEvTCPServer *srv_ptr, CommEvTCPServerListener *listener);
 
+static CommEvTCPServerCertificate *CommEvTCPServerSSLCertCacheEntryAdd(CommEvTCPServer *srv_ptr, char *key_str, X509 *x509_cert, SSL_CTX *ssl_context);
+static CommEvTCPServerCertificate *CommEvTCPServerSSLCertCacheEntryLookup(CommEvTCPServer *srv_ptr, char *dnsname_str);
+static void CommEvTCPServerSSLCertCacheEntryEvict(CommEvTCPServer *srv_ptr, CommEvTCPServerCertificate *cert_info);
+static SSL_CTX *CommEvTCPServerSSLCertContextNew(X509 *x509_cert, EVP_PKEY *key_private);
+static ThreadInstanceJobCB_RetPTR CommEvTCPServerSSLCertForgeJob;
+static ThreadInstanceJobFinishCB CommEvTCPServerSSLCertForgeFinish;
+static void CommEvTCPServerSSLCertForgeDestroy(CommEvTCPServerCertForge *cert_forge);
+static void CommEvTCPServerSSLCertForgeRelease(CommEvTCPServerCertForge *cert_forge);
+static EvBaseKQCBH CommEvTCPServerSSLCertForgeWakeJob;
+static CommEvTCPServerSSLSession *CommEvTCPServerSSLSessionCacheEntryLookup(CommEvTCPServer *srv_ptr, char *sessid_str);
+static void CommEvTCPServerSSLSessionCacheEntryEvict(CommEvTCPServer *srv_ptr, CommEvTCPServerSSLSession *ssl_sess);
+static void CommEvTCPServerSSLSessionIDToStr(const unsigned char *sessid_ptr, unsigned int sessid_sz, char *ret_buf);
+static int CommEvTCPServerSSLSessionNewCB(SSL *ssl_handle, SSL_SESSION *ssl_session);
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+static SSL_SESSION *CommEvTCPServerSSLSessionGetCB(SSL *ssl_handle, unsigned char *sessid_ptr, int sessid_sz, int *copy);
+#else
+static SSL_SESSION *CommEvTCPServerSSLSessionGetCB(SSL *ssl_handle, const unsigned char *sessid_ptr, int sessid_sz, int *copy);
+#endif
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+static int CommEvTCPServerSSLTicketKeyCB(SSL *ssl_handle, unsigned char *key_name, unsigned char *iv, EVP_CIPHER_CTX *cipher_ctx, EVP_MAC_CTX *mac_ctx, int enc);
+static int CommEvTCPServerSSLTicketMACInit(EVP_MAC_CTX *mac_ctx, unsigned char *hmac_key);
+#else
+static int CommEvTCPServerSSLTicketKeyCB(SSL *ssl_handle, unsigned char *key_name, unsigned char *iv, EVP_CIPHER_CTX *cipher_ctx, HMAC_CTX *mac_ctx, int enc);
+static int CommEvTCPServerSSLTicketMACInit(HMAC_CTX *mac_ctx, unsigned char *hmac_key);
+#endif
+static int CommEvTCPServerSSLTicketKeyGet(CommEvTCPServer *srv_ptr, unsigned char *key_name, CommEvTCPServerSSLTicketKey *ret_key);
+static int CommEvTCPServerSSLTicketKeyRotateLocked(CommEvTCPServer *srv_ptr);
+
 /**************************************************************************************************************************/
 CommEvTCPServer *CommEvTCPServerNew(EvKQBase *kq_base)
 {
@@ -96,6 +131,9 @@ CommEvTCPServer *CommEvTCPServerNew(EvKQBase *kq_base)
 	srv_ptr->kq_base					= kq_base;
 	srv_ptr->transfer.gc_timerid		= -1;
 
+	/* Worker threads add to TRANSFER list while GC timer walks it on THRD_ID zero */
+	DLinkedListInit(&srv_ptr->transfer.list, (kq_base->flags.mt_engine ? BRBDATA_THREAD_SAFE : BRBDATA_THREAD_UNSAFE));
+
 	/* Populate KQ_BASE object structure */
 	srv_ptr->kq_obj.code				= EV_OBJ_TCP_SERVER;
 	srv_ptr->kq_obj.obj.ptr				= srv_ptr;
@@ -111,6 +149,17 @@ CommEvTCPServer *CommEvTCPServerNew(EvKQBase *kq_base)
 	/* Create CONN_FD arena */
 	CommEvTCPServerConnArenaNew(srv_ptr);
 
+	/* SSL session resumption defaults - Cache and ticket keys are shared by all listeners */
+	srv_ptr->ssldata.session_cache.max_entries	= COMM_TCP_SERVER_SSL_SESSION_CACHE_MAX;
+	srv_ptr->ssldata.session_cache.timeout_sec	= COMM_TCP_SERVER_SSL_SESSION_TIMEOUT_SEC;
+	srv_ptr->ssldata.ticket.rotate_sec			= COMM_TCP_SERVER_SSL_TICKET_ROTATE_SEC;
+	pthread_mutex_init(&srv_ptr->ssldata.ticket.mutex, 0);
+
+	/* Certificate cache, pending forges and session cache are shared by all worker threads */
+	pthread_mutex_init(&srv_ptr->ssldata.cert_cache.mutex, 0);
+	pthread_mutex_init(&srv_ptr->ssldata.cert_forge.mutex, 0);
+	pthread_mutex_init(&srv_ptr->ssldata.session_cache.mutex, 0);
+
 	/* INIT MT_SAFE MUTEXES */
 	//COMM_SERVER_CONN_TABLE_MUTEX_INIT(srv_ptr);
 
@@ -244,6 +293,9 @@ int CommEvTCPServerListenerDel(CommEvTCPServer *srv_ptr, int listener_id)
 	EvKQBaseFDDescriptionClearByFD(srv_ptr->kq_base, listener->socket_fd);
 	memset(&listener->flags, 0, sizeof(listener->flags));
 
+	/* Shutdown worker sockets, if sharded */
+	CommEvTCPServerListenerThreadsShutdown(srv_ptr, listener);
+
 	/* Shutdown main socket */
 	EvKQBaseSocketClose(srv_ptr->kq_base, listener->socket_fd);
 	listener->socket_fd		= -1;
@@ -261,6 +313,7 @@ int CommEvTCPServerListenerAdd(CommEvTCPServer *srv_ptr, CommEvTCPServerConf *se
 
 	int reuseaddr_on	= 1;
 	int op_status		= 0;
+	int thrd_count		= EvKQBaseThreadCountGet(srv_ptr->kq_base);
 
 	/* Sanity check */
 	if ((!srv_ptr) || (!server_conf))
@@ -293,6 +346,10 @@ int CommEvTCPServerListenerAdd(CommEvTCPServer *srv_ptr, CommEvTCPServerConf *se
 	listener->unix_lid				= -1;
 	listener->ssldata.ssl_context	= server_conf->ssl.ssl_context;
 
+	/* No worker sockets yet */
+	for (i = 0; i < COMM_TCP_SERVER_MAX_THREADS; i++)
+		listener->thrd_socket_fd[i]	= -1;
+
 	/* Copy common configuration information */
 	srv_ptr->cfg[slot_id].bind_method				= server_conf->bind_method;
 	srv_ptr->cfg[slot_id].read_mthd					= server_conf->read_mthd;
@@ -300,11 +357,20 @@ int CommEvTCPServerListenerAdd(CommEvTCPServer *srv_ptr, CommEvTCPServerConf *se
 	srv_ptr->cfg[slot_id].srv_type					= server_conf->srv_type;
 	srv_ptr->cfg[slot_id].port						= server_conf->port;
 	srv_ptr->cfg[slot_id].cli_queue_max				= server_conf->limits.cli_queue_max;
+	srv_ptr->cfg[slot_id].cli_queue_high_sz			= server_conf->limits.cli_queue_high_sz;
+	srv_ptr->cfg[slot_id].cli_queue_low_sz			= server_conf->limits.cli_queue_low_sz;
+	srv_ptr->cfg[slot_id].write_account				= server_conf->limits.write_account;
 	srv_ptr->cfg[slot_id].timeout.autodetect_ms		= server_conf->timeout.autodetect_ms;
 	srv_ptr->cfg[slot_id].timeout.transfer_ms		= server_conf->timeout.transfer_ms;
 	srv_ptr->cfg[slot_id].timeout.inactive_ms		= server_conf->timeout.inactive_ms;
 	srv_ptr->cfg[slot_id].flags.reuse_addr			= server_conf->flags.reuse_addr;
 	srv_ptr->cfg[slot_id].flags.reuse_port			= server_conf->flags.reuse_port;
+	srv_ptr->cfg[slot_id].flags.read_edge			= server_conf->flags.read_edge;
+	srv_ptr->cfg[slot_id].flags.defer_accept		= server_conf->flags.defer_accept;
+	srv_ptr->cfg[slot_id].flags.calculate_datarate	= server_conf->flags.calculate_datarate;
+
+	/* Running multi-threaded, shard INET listener among threads, each one with its own SO_REUSEPORT socket */
+	srv_ptr->cfg[slot_id].flags.thrd_shard			= ((thrd_count > 1) && (listener->port > 0) && (!server_conf->unix_server.path_str || !server_conf->unix_server.no_brb_proto));
 
 	/* Set default IO events */
 	for (i = 0; i < COMM_SERVER_EVENT_LASTITEM; i++)
@@ -327,11 +393,16 @@ int CommEvTCPServerListenerAdd(CommEvTCPServer *srv_ptr, CommEvTCPServerConf *se
 	if (listener->port > 0 || (server_conf->unix_server.path_str && server_conf->unix_server.no_brb_proto))
 	{
 		/* Initialize TCP side of this server */
-		CommEvTCPServerListenerTCPInit(srv_ptr, server_conf, listener);
+		op_status = CommEvTCPServerListenerTCPInit(srv_ptr, server_conf, listener);
+
+		/* Failed, there is no socket to shard among threads */
+		if (op_status <= 0)
+			srv_ptr->cfg[slot_id].flags.thrd_shard = 0;
 
 		/* Set volatile read event for accepting new connections - Will be rescheduled by internal accept event */
 		EvKQBaseSetEvent(srv_ptr->kq_base, listener->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_PERSIST, CommEvTCPServerEventAccept, listener);
 		EvKQBaseSetEvent(srv_ptr->kq_base, listener->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventListenerClose, listener);
+		listener->thrd_socket_fd[0] = listener->socket_fd;
 	}
 
 	/* Fire UP UNIX_SERVER side of this TCP_SERVER if upper layers set a path */
@@ -374,6 +445,13 @@ int CommEvTCPServerListenerAdd(CommEvTCPServer *srv_ptr, CommEvTCPServerConf *se
 	DLinkedListAdd(&srv_ptr->listener.list, &listener->node, listener);
 	listener->flags.active = 1;
 
+	/* Ask each worker to open its own socket for this listener, connections will stay pinned to the accepting thread */
+	if (srv_ptr->cfg[slot_id].flags.thrd_shard)
+	{
+		for (i = 1; ((i < thrd_count) && (i < COMM_TCP_SERVER_MAX_THREADS)); i++)
+			EvKQBaseThreadJobSend(srv_ptr->kq_base, i, CommEvTCPServerListenerThreadInit, listener);
+	}
+
 	KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - Added LISTENER_ID [%d]\n", listener->socket_fd, listener->slot_id);
 	return slot_id;
 }
@@ -408,8 +486,8 @@ int CommEvTCPServerSwitchConnProto(CommEvTCPServerConn *conn_hnd, int proto)
 		CommEvTCPServerConnSetDefaultEvents(conn_hnd->parent_srv, conn_hnd);
 
 		/* Set disconnect and read internal events for newly connected socket */
-		EvKQBaseSetEvent(parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventClose, conn_hnd);
-		EvKQBaseSetEvent(parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventRead, conn_hnd);
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventClose, conn_hnd);
+		CommEvTCPServerEventReadSchedule(conn_hnd, 0);
 
 		break;
 	}
@@ -423,11 +501,15 @@ int CommEvTCPServerSwitchConnProto(CommEvTCPServerConn *conn_hnd, int proto)
 /**************************************************************************************************************************/
 int CommEvTCPServerConnReadReschedule(CommEvTCPServerConn *conn_hnd)
 {
+	/* Paused by backpressure, resume will reschedule */
+	if (conn_hnd->backpressure.flags.read_paused)
+		return 0;
+
 	/* We are running SSL, read accordingly */
 	if (conn_hnd->flags.ssl_enabled)
-		EvKQBaseSetEvent(conn_hnd->parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventSSLRead, conn_hnd);
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventSSLRead, conn_hnd);
 	else
-		EvKQBaseSetEvent(conn_hnd->parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventRead, conn_hnd);
+		CommEvTCPServerEventReadSchedule(conn_hnd, 0);
 
 	return 1;
 }
@@ -463,25 +545,24 @@ int CommEvTCPServerKickConnFromAcceptDefer(CommEvTCPServerConn *conn_hnd)
 	KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - Back from SSL_DEFER_HANDSHAKE\n", conn_hnd->socket_fd);
 
 	/* Cancel PERSISTENT read event */
-	EvKQBaseSetEvent(srv_ptr->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_DELETE, NULL, NULL);
+	EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_DELETE, NULL, NULL);
 
 	/* Create a new SSL conn_client context if needed and begin SSL handshake */
 	CommEvTCPServerConnSSLSessionInit(conn_hnd);
-	CommEvTCPServerEventSSLAccept(conn_hnd->socket_fd, 0, -1, conn_hnd, srv_ptr->kq_base);
+	CommEvTCPServerEventSSLAccept(conn_hnd->socket_fd, 0, conn_hnd->thrd_id, conn_hnd, conn_hnd->kq_base);
 
 	return 1;
 }
 /**************************************************************************************************************************/
 void CommEvTCPServerKickConnWriteQueue(CommEvTCPServerConn *conn_hnd)
 {
-	CommEvTCPServer *srv_ptr	= conn_hnd->parent_srv;
 	int listener_id				= conn_hnd->listener->slot_id;
 
 
 	/* If there is ENQUEUED data, schedule WRITE event and LEAVE, as we need to PRESERVE WRITE ORDER */
 	if (conn_hnd->flags.pending_write)
 	{
-		EvKQBaseSetEvent(srv_ptr->kq_base, conn_hnd->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE,
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE,
 				conn_hnd->flags.ssl_enabled ? CommEvTCPServerEventSSLWrite : CommEvTCPServerEventWrite, conn_hnd);
 		return;
 	}
@@ -489,9 +570,9 @@ void CommEvTCPServerKickConnWriteQueue(CommEvTCPServerConn *conn_hnd)
 	else
 	{
 		if (conn_hnd->flags.ssl_enabled)
-			CommEvTCPServerEventSSLWrite(conn_hnd->socket_fd, 8092, -1, conn_hnd, srv_ptr->kq_base);
+			CommEvTCPServerEventSSLWrite(conn_hnd->socket_fd, 8092, conn_hnd->thrd_id, conn_hnd, conn_hnd->kq_base);
 		else
-			CommEvTCPServerEventWrite(conn_hnd->socket_fd, 8092, -1, conn_hnd, srv_ptr->kq_base);
+			CommEvTCPServerEventWrite(conn_hnd->socket_fd, 8092, conn_hnd->thrd_id, conn_hnd, conn_hnd->kq_base);
 
 		return;
 	}
@@ -508,6 +589,10 @@ void CommEvTCPServerSSLCertCacheDestroy(CommEvTCPServerCertificate *cert_info)
 	if (!cert_info)
 		return;
 
+	/* Connections already using this context hold their own reference */
+	if (cert_info->ssl_context)
+		SSL_CTX_free(cert_info->ssl_context);
+
 	X509_free(cert_info->x509_cert);
 	free(cert_info);
 
@@ -520,6 +605,7 @@ int CommEvTCPServerSSLCertCacheInsert(CommEvTCPServer *srv_ptr, char *dnsname_st
 	char wildcard_str[512];
 	int wildcardable;
 	int dnsname_strsz;
+	int op_status;
 
 	/* Sanity check */
 	if (!dnsname_str)
@@ -532,93 +618,994 @@ int CommEvTCPServerSSLCertCacheInsert(CommEvTCPServer *srv_ptr, char *dnsname_st
 	if (dnsname_strsz < 3)
 		return 0;
 
-	/* Cache arena not initialized, initialize now */
-	if (!srv_ptr->ssldata.cert_cache.table)
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_cache.mutex);
+
+	/* Already cached, bail out */
+	if ((srv_ptr->ssldata.cert_cache.table) && (AssocArrayLookup(srv_ptr->ssldata.cert_cache.table, dnsname_str)))
+	{
+		pthread_mutex_unlock(&srv_ptr->ssldata.cert_cache.mutex);
+		return 0;
+	}
+
+	/* Generate WILDCARD for this domain */
+	wildcardable	= CommEvSSLUtils_GenerateWildCardFromDomain(dnsname_str, (char*)&wildcard_str, (sizeof(wildcard_str)));
+
+	/* Add into internal cache */
+	cert_info		= CommEvTCPServerSSLCertCacheEntryAdd(srv_ptr, (wildcardable ? wildcard_str : dnsname_str), x509_cert, NULL);
+	op_status		= ((cert_info) && (cert_info->x509_cert == x509_cert));
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_cache.mutex);
+
+	/* Someone else cached this WILDCARD before us */
+	return op_status;
+}
+/**************************************************************************************************************************/
+X509 *CommEvTCPServerSSLCertCacheLookupByConnHnd(CommEvTCPServerConn *conn_hnd)
+{
+	char wildcard_str[512];
+	int wildcardable;
+
+	/* Try to find a CACHE_CERT for this SNI - Reference is taken under cache lock, as LRU may evict it on another thread */
+	conn_hnd->ssldata.x509_cert			= CommEvTCPServerSSLCertCacheLookupRef(conn_hnd->parent_srv, CommEvTCPServerConnSSLDataGetSNIStr(conn_hnd));
+	conn_hnd->ssldata.sni_host_tldpos	= CommEvSSLUtils_GenerateWildCardFromDomain(CommEvTCPServerConnSSLDataGetSNIStr(conn_hnd), (char*)&wildcard_str, (sizeof(wildcard_str)));
+
+	if (conn_hnd->ssldata.sni_host_tldpos > 0)
+		conn_hnd->ssldata.sni_host_tldpos++;
+
+	/* We are using a cached certificate, save flags */
+	if (conn_hnd->ssldata.x509_cert)
+	{
+		conn_hnd->flags.ssl_cert_cached				= 1;
+		conn_hnd->flags.ssl_cert_destroy_onclose	= 1;
+	}
+
+	/* Send back what we got */
+	return conn_hnd->ssldata.x509_cert;
+}
+/**************************************************************************************************************************/
+X509 *CommEvTCPServerSSLCertCacheLookup(CommEvTCPServer *srv_ptr, char *dnsname_str)
+{
+	CommEvTCPServerCertificate *cert_info;
+	X509 *x509_cert = NULL;
+
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_cache.mutex);
+
+	/* Try to find directly, then via WILDCARD */
+	cert_info = (srv_ptr->ssldata.cert_cache.table ? CommEvTCPServerSSLCertCacheEntryLookup(srv_ptr, dnsname_str) : NULL);
+
+	/* Found, count hit or miss */
+	if (cert_info)
+	{
+		x509_cert = cert_info->x509_cert;
+		srv_ptr->ssldata.cert_cache.stats.hit++;
+	}
+	else
+		srv_ptr->ssldata.cert_cache.stats.miss++;
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_cache.mutex);
+
+	/* Pointer is borrowed - Multi threaded servers must use CommEvTCPServerSSLCertCacheLookupRef */
+	return x509_cert;
+}
+/**************************************************************************************************************************/
+X509 *CommEvTCPServerSSLCertCacheLookupRef(CommEvTCPServer *srv_ptr, char *dnsname_str)
+{
+	CommEvTCPServerCertificate *cert_info;
+	X509 *x509_cert = NULL;
+
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_cache.mutex);
+
+	/* Try to find directly, then via WILDCARD */
+	cert_info = (srv_ptr->ssldata.cert_cache.table ? CommEvTCPServerSSLCertCacheEntryLookup(srv_ptr, dnsname_str) : NULL);
+
+	/* Found, caller gets its own reference */
+	if (cert_info)
+	{
+		x509_cert = cert_info->x509_cert;
+		CommEvSSLUtils_X509CertRefCountInc(x509_cert, 1);
+		srv_ptr->ssldata.cert_cache.stats.hit++;
+	}
+	else
+		srv_ptr->ssldata.cert_cache.stats.miss++;
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_cache.mutex);
+	return x509_cert;
+}
+/**************************************************************************************************************************/
+void CommEvTCPServerSSLCertCacheSetMax(CommEvTCPServer *srv_ptr, int max_entries)
+{
+	CommEvTCPServerCertificate *cert_info;
+
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_cache.mutex);
+
+	srv_ptr->ssldata.cert_cache.max_entries = ((max_entries > 0) ? max_entries : COMM_TCP_SERVER_CERT_CACHE_MAX);
+
+	/* Evict least recently used entries above new limit, if cache is initialized */
+	while ((srv_ptr->ssldata.cert_cache.table) && (srv_ptr->ssldata.cert_cache.list.size > srv_ptr->ssldata.cert_cache.max_entries))
+	{
+		cert_info = srv_ptr->ssldata.cert_cache.list.tail->data;
+		CommEvTCPServerSSLCertCacheEntryEvict(srv_ptr, cert_info);
+		continue;
+	}
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_cache.mutex);
+	return;
+}
+/**************************************************************************************************************************/
+SSL_CTX *CommEvTCPServerSSLCertCacheContextGet(CommEvTCPServer *srv_ptr, char *dnsname_str, X509 *x509_cert)
+{
+	CommEvTCPServerCertificate *cert_info;
+	SSL_CTX *ssl_context = NULL;
+
+	/* Sanity check */
+	if (!x509_cert)
+		return NULL;
+
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_cache.mutex);
+
+	/* Cache arena not initialized */
+	if (!srv_ptr->ssldata.cert_cache.table)
+		goto leave;
+
+	cert_info = CommEvTCPServerSSLCertCacheEntryLookup(srv_ptr, dnsname_str);
+
+	/* Not cached, or upper layers picked another certificate for this host */
+	if ((!cert_info) || (cert_info->x509_cert != x509_cert))
+		goto leave;
+
+	/* Context already built, reuse it */
+	if (cert_info->ssl_context)
+	{
+		srv_ptr->ssldata.cert_cache.stats.ctx_reuse++;
+	}
+	/* First use of this certificate, build context once */
+	else
+	{
+		cert_info->ssl_context = CommEvTCPServerSSLCertContextNew(x509_cert, srv_ptr->ssldata.main_key);
+
+		if (cert_info->ssl_context)
+		{
+			CommEvTCPServerSSLSessionContextInit(srv_ptr, cert_info->ssl_context, cert_info->dnsname_str);
+			srv_ptr->ssldata.cert_cache.stats.ctx_new++;
+		}
+	}
+
+	/* Caller gets its own reference, so an eviction on another thread only drops the cache one - Release with SSL_CTX_free */
+	ssl_context = cert_info->ssl_context;
+
+	if (ssl_context)
+		CommEvSSLUtils_ContextRefCountInc(ssl_context, 1);
+
+	/* TAG to leave with cache unlocked */
+	leave:
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_cache.mutex);
+	return ssl_context;
+}
+/**************************************************************************************************************************/
+int CommEvTCPServerSSLCertForge(CommEvTCPServerConn *conn_hnd, ThreadPoolBase *thrd_pool, int valid_sec, int wildcard)
+{
+	ThreadPoolJobProto job_proto;
+	CommEvTCPServerCertificate *cert_info;
+	CommEvTCPServerCertificate *ca_certinfo;
+	CommEvTCPServerCertForge *cert_forge;
+	CommEvTCPServer *srv_ptr = conn_hnd->parent_srv;
+	X509 *forged_cert;
+	char wildcard_str[512];
+	char *forge_name_str;
+	char *sni_str;
+
+	/* Grab CA certificate from our listener */
+	ca_certinfo	= &srv_ptr->cfg[conn_hnd->listener->slot_id].ssl.ca_cert;
+	sni_str		= CommEvTCPServerConnSSLDataGetSNIStr(conn_hnd);
+
+	/* Nothing to forge with, or for */
+	if ((!ca_certinfo->x509_cert) || (!ca_certinfo->key_private) || (!srv_ptr->ssldata.main_key) || (strlen(sni_str) < 3))
+		return -1;
+
+	/* Cached, handshake can go on right away */
+	if (CommEvTCPServerSSLCertCacheLookupByConnHnd(conn_hnd))
+		return 1;
+
+	/* Decide name we will forge for */
+	forge_name_str	= ((wildcard && (CommEvSSLUtils_GenerateWildCardFromDomain(sni_str, (char*)&wildcard_str, (sizeof(wildcard_str))) > 0)) ? wildcard_str : sni_str);
+
+	/* No THREAD_POOL, forge on this thread */
+	if (!thrd_pool)
+		goto forge_sync;
+
+	/* Forge table, waiter lists and FORGE FINISH are serialized by this lock, as connections come from all threads */
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_forge.mutex);
+
+	/* Forge table not initialized, initialize now */
+	if (!srv_ptr->ssldata.cert_forge.table)
+	{
+		srv_ptr->ssldata.cert_forge.table = AssocArrayNew(BRBDATA_THREAD_UNSAFE, 1024, NULL);
+		DLinkedListInit(&srv_ptr->ssldata.cert_forge.list, BRBDATA_THREAD_UNSAFE);
+	}
+
+	cert_forge = AssocArrayLookup(srv_ptr->ssldata.cert_forge.table, forge_name_str);
+
+	/* Same host already being forged, just wait for it */
+	if (cert_forge)
+	{
+		srv_ptr->ssldata.cert_forge.stats.coalesced++;
+		goto defer;
+	}
+
+	/* Create a new FORGE request, referencing keys so it survives server destruction - JOB holds first reference */
+	cert_forge				= calloc(1, sizeof(CommEvTCPServerCertForge));
+	cert_forge->parent_srv	= srv_ptr;
+	cert_forge->valid_sec	= valid_sec;
+	cert_forge->ref_count	= 1;
+	cert_forge->ca_cert		= ca_certinfo->x509_cert;
+	cert_forge->ca_key		= ca_certinfo->key_private;
+	cert_forge->main_key	= srv_ptr->ssldata.main_key;
+	strlcpy((char*)&cert_forge->dnsname_str, forge_name_str, sizeof(cert_forge->dnsname_str));
+	gettimeofday(&cert_forge->begin_tv, NULL);
+	DLinkedListInit(&cert_forge->waiter_list, BRBDATA_THREAD_UNSAFE);
+	pthread_mutex_init(&cert_forge->mutex, 0);
+
+	CommEvSSLUtils_X509CertRefCountInc(cert_forge->ca_cert, 1);
+	CommEvSSLUtils_X509PrivateKeyRefCountInc(cert_forge->ca_key, 1);
+	CommEvSSLUtils_X509PrivateKeyRefCountInc(cert_forge->main_key, 1);
+
+	/* Publish before enqueueing, FINISH may run on another thread as soon as JOB is in */
+	AssocArrayAdd(srv_ptr->ssldata.cert_forge.table, forge_name_str, cert_forge);
+	DLinkedListAdd(&srv_ptr->ssldata.cert_forge.list, &cert_forge->node, cert_forge);
+
+	/* Sign on a worker THREAD */
+	memset(&job_proto, 0, sizeof(ThreadPoolJobProto));
+	job_proto.job_cbh_ptr			= (ThreadInstanceJobCB_Generic*)CommEvTCPServerSSLCertForgeJob;
+	job_proto.job_cbdata			= cert_forge;
+	job_proto.retval_type			= THREAD_JOB_RETVAL_PTR;
+	job_proto.job_finish_cbh_ptr	= CommEvTCPServerSSLCertForgeFinish;
+	job_proto.job_finish_cbdata		= cert_forge;
+
+	cert_forge->job_id = ThreadPoolJobEnqueue(thrd_pool, &job_proto);
+
+	/* THREAD_POOL is full, forge on this thread */
+	if (cert_forge->job_id < 0)
+	{
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Failed enqueueing FORGE JOB for [%s], forging in place\n",
+				conn_hnd->socket_fd, forge_name_str);
+
+		AssocArrayDelete(srv_ptr->ssldata.cert_forge.table, forge_name_str);
+		DLinkedListDelete(&srv_ptr->ssldata.cert_forge.list, &cert_forge->node);
+		pthread_mutex_unlock(&srv_ptr->ssldata.cert_forge.mutex);
+
+		CommEvTCPServerSSLCertForgeDestroy(cert_forge);
+		goto forge_sync;
+	}
+
+	/* Tag to wait for FORGE JOB */
+	defer:
+
+	pthread_mutex_lock(&cert_forge->mutex);
+	DLinkedListAdd(&cert_forge->waiter_list, &conn_hnd->cert_forge.node, conn_hnd);
+	pthread_mutex_unlock(&cert_forge->mutex);
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_forge.mutex);
+
+	conn_hnd->cert_forge.forge_ptr		= cert_forge;
+	conn_hnd->flags.ssl_handshake_defer	= 1;
+
+	return 0;
+
+	/* Tag to forge on this thread */
+	forge_sync:
+
+	forged_cert = CommEvSSLUtils_X509ForgeAndSignFromParams(ca_certinfo->x509_cert, ca_certinfo->key_private, srv_ptr->ssldata.main_key, forge_name_str, valid_sec);
+
+	/* Failed forging */
+	if (!forged_cert)
+	{
+		pthread_mutex_lock(&srv_ptr->ssldata.cert_forge.mutex);
+		srv_ptr->ssldata.cert_forge.stats.failed++;
+		pthread_mutex_unlock(&srv_ptr->ssldata.cert_forge.mutex);
+		return -1;
+	}
+
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_forge.mutex);
+	srv_ptr->ssldata.cert_forge.stats.sync++;
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_forge.mutex);
+
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_cache.mutex);
+	cert_info = CommEvTCPServerSSLCertCacheEntryAdd(srv_ptr, forge_name_str, forged_cert, NULL);
+
+	/* Cache took our reference, grab one for connection */
+	if ((cert_info) && (cert_info->x509_cert == forged_cert))
+		CommEvSSLUtils_X509CertRefCountInc(forged_cert, 1);
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_cache.mutex);
+
+	conn_hnd->ssldata.x509_cert					= forged_cert;
+	conn_hnd->flags.ssl_cert_destroy_onclose	= 1;
+
+	return 1;
+}
+/**************************************************************************************************************************/
+void CommEvTCPServerSSLSessionContextInit(CommEvTCPServer *srv_ptr, SSL_CTX *ssl_context, char *sid_ctx_str)
+{
+	unsigned char sid_ctx[EVP_MAX_MD_SIZE];
+	unsigned int sid_ctx_sz = 0;
+
+	/* Sanity check */
+	if ((!ssl_context) || (!sid_ctx_str))
+		return;
+
+	/* Sessions only resume on the context, listener or certificate, that created them */
+	EVP_Digest(sid_ctx_str, strlen(sid_ctx_str), (unsigned char*)&sid_ctx, &sid_ctx_sz, EVP_sha256(), NULL);
+	SSL_CTX_set_session_id_context(ssl_context, (unsigned char*)&sid_ctx, ((sid_ctx_sz > SSL_MAX_SID_CTX_LENGTH) ? SSL_MAX_SID_CTX_LENGTH : sid_ctx_sz));
+
+	/* Session IDs live in our own cache, so all contexts of this server share it */
+	SSL_CTX_set_session_cache_mode(ssl_context, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL | SSL_SESS_CACHE_NO_AUTO_CLEAR);
+	SSL_CTX_set_timeout(ssl_context, srv_ptr->ssldata.session_cache.timeout_sec);
+	SSL_CTX_sess_set_new_cb(ssl_context, CommEvTCPServerSSLSessionNewCB);
+	SSL_CTX_sess_set_get_cb(ssl_context, CommEvTCPServerSSLSessionGetCB);
+
+	/* Stateless tickets, encrypted with server wide rotating keys */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	SSL_CTX_set_tlsext_ticket_key_evp_cb(ssl_context, CommEvTCPServerSSLTicketKeyCB);
+#else
+	SSL_CTX_set_tlsext_ticket_key_cb(ssl_context, CommEvTCPServerSSLTicketKeyCB);
+#endif
+
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvTCPServerSSLSessionCacheSetMax(CommEvTCPServer *srv_ptr, int max_entries)
+{
+	pthread_mutex_lock(&srv_ptr->ssldata.session_cache.mutex);
+
+	srv_ptr->ssldata.session_cache.max_entries = ((max_entries > 0) ? max_entries : COMM_TCP_SERVER_SSL_SESSION_CACHE_MAX);
+
+	/* Evict least recently used entries above new limit, if cache is initialized */
+	while ((srv_ptr->ssldata.session_cache.table) && (srv_ptr->ssldata.session_cache.list.size > srv_ptr->ssldata.session_cache.max_entries))
+		CommEvTCPServerSSLSessionCacheEntryEvict(srv_ptr, srv_ptr->ssldata.session_cache.list.tail->data);
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.session_cache.mutex);
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvTCPServerSSLSessionCacheDestroy(CommEvTCPServerSSLSession *ssl_sess)
+{
+	/* Sanity check */
+	if (!ssl_sess)
+		return;
+
+	SSL_SESSION_free(ssl_sess->ssl_session);
+	free(ssl_sess);
+
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvTCPServerSSLTicketKeySetRotate(CommEvTCPServer *srv_ptr, long rotate_sec)
+{
+	srv_ptr->ssldata.ticket.rotate_sec = ((rotate_sec > 0) ? rotate_sec : COMM_TCP_SERVER_SSL_TICKET_ROTATE_SEC);
+	return;
+}
+/**************************************************************************************************************************/
+int CommEvTCPServerSSLTicketKeyRotate(CommEvTCPServer *srv_ptr)
+{
+	int op_status;
+
+	pthread_mutex_lock(&srv_ptr->ssldata.ticket.mutex);
+	op_status = CommEvTCPServerSSLTicketKeyRotateLocked(srv_ptr);
+	pthread_mutex_unlock(&srv_ptr->ssldata.ticket.mutex);
+
+	return op_status;
+}
+/**************************************************************************************************************************/
+void CommEvTCPServerTCPInfoSamplerSet(CommEvTCPServer *srv_ptr, CommEvTCPInfoSampler *sampler)
+{
+	/* Connections accepted from now on register on it, NULL stops registering new ones */
+	srv_ptr->tcp_info_sampler = sampler;
+	return;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static CommEvTCPServerCertificate *CommEvTCPServerSSLCertCacheEntryAdd(CommEvTCPServer *srv_ptr, char *key_str, X509 *x509_cert, SSL_CTX *ssl_context)
+{
+	CommEvTCPServerCertificate *cert_info;
+
+	/* Cache arena not initialized, initialize now - Callers of ENTRY_ADD, ENTRY_LOOKUP and ENTRY_EVICT hold CERT_CACHE MUTEX, so no inner locks */
+	if (!srv_ptr->ssldata.cert_cache.table)
+	{
+		srv_ptr->ssldata.cert_cache.table = AssocArrayNew(BRBDATA_THREAD_UNSAFE, 7951, (ASSOCITEM_DESTROYFUNC*)CommEvTCPServerSSLCertCacheDestroy);
+		DLinkedListInit(&srv_ptr->ssldata.cert_cache.list, BRBDATA_THREAD_UNSAFE);
+
+		if (srv_ptr->ssldata.cert_cache.max_entries <= 0)
+			srv_ptr->ssldata.cert_cache.max_entries = COMM_TCP_SERVER_CERT_CACHE_MAX;
+	}
+
+	cert_info = AssocArrayLookup(srv_ptr->ssldata.cert_cache.table, key_str);
+
+	/* Already cached, caller keeps ownership of what it gave us */
+	if (cert_info)
+		return cert_info;
+
+	/* Create a new certificate node */
+	cert_info				= calloc(1, sizeof(CommEvTCPServerCertificate));
+	cert_info->x509_cert	= x509_cert;
+	cert_info->ssl_context	= ssl_context;
+	strlcpy((char*)&cert_info->dnsname_str, key_str, sizeof(cert_info->dnsname_str));
+
+	AssocArrayAdd(srv_ptr->ssldata.cert_cache.table, key_str, cert_info);
+	DLinkedListAddHead(&srv_ptr->ssldata.cert_cache.list, &cert_info->node, cert_info);
+
+	/* Keep cache bounded, evict from LRU tail */
+	while (srv_ptr->ssldata.cert_cache.list.size > srv_ptr->ssldata.cert_cache.max_entries)
+		CommEvTCPServerSSLCertCacheEntryEvict(srv_ptr, srv_ptr->ssldata.cert_cache.list.tail->data);
+
+	return cert_info;
+}
+/**************************************************************************************************************************/
+static CommEvTCPServerCertificate *CommEvTCPServerSSLCertCacheEntryLookup(CommEvTCPServer *srv_ptr, char *dnsname_str)
+{
+	CommEvTCPServerCertificate *cert_info;
+	char wildcard_str[512];
+
+	/* Try to find directly */
+	cert_info = AssocArrayLookup(srv_ptr->ssldata.cert_cache.table, dnsname_str);
+
+	/* Generate WILDCARD for this domain and try it */
+	if ((!cert_info) && (CommEvSSLUtils_GenerateWildCardFromDomain(dnsname_str, (char*)&wildcard_str, (sizeof(wildcard_str)))))
+		cert_info = AssocArrayLookup(srv_ptr->ssldata.cert_cache.table, wildcard_str);
+
+	/* Touch LRU */
+	if (cert_info)
+		DLinkedListMoveToHead(&srv_ptr->ssldata.cert_cache.list, &cert_info->node);
+
+	return cert_info;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPServerSSLCertCacheEntryEvict(CommEvTCPServer *srv_ptr, CommEvTCPServerCertificate *cert_info)
+{
+	char key_str[COMM_SSL_SNI_MAXSZ];
+
+	/* Key lives inside entry, which is released by ASSOC_ARRAY destroy function */
+	strlcpy((char*)&key_str, cert_info->dnsname_str, sizeof(key_str));
+
+	DLinkedListDelete(&srv_ptr->ssldata.cert_cache.list, &cert_info->node);
+	AssocArrayDelete(srv_ptr->ssldata.cert_cache.table, (char*)&key_str);
+
+	srv_ptr->ssldata.cert_cache.stats.evicted++;
+	return;
+}
+/**************************************************************************************************************************/
+static SSL_CTX *CommEvTCPServerSSLCertContextNew(X509 *x509_cert, EVP_PKEY *key_private)
+{
+	SSL_CTX *ssl_context = SSL_CTX_new(SSLv23_server_method());
+
+	/* Failed creating context */
+	if (!ssl_context)
+		return NULL;
+
+	/* Bind certificate and private key used for forging */
+	if ((!SSL_CTX_use_certificate(ssl_context, x509_cert)) || (!SSL_CTX_use_PrivateKey(ssl_context, key_private)))
+	{
+		SSL_CTX_free(ssl_context);
+		return NULL;
+	}
+
+	return ssl_context;
+}
+/**************************************************************************************************************************/
+static void *CommEvTCPServerSSLCertForgeJob(void *thread_job_ptr, void *cert_forge_ptr)
+{
+	CommEvTCPServerCertForge *cert_forge = cert_forge_ptr;
+
+	/* Running on worker THREAD - Only touch FORGE private data */
+	cert_forge->x509_cert = CommEvSSLUtils_X509ForgeAndSignFromParams(cert_forge->ca_cert, cert_forge->ca_key, cert_forge->main_key, cert_forge->dnsname_str, cert_forge->valid_sec);
+
+	/* Build context here too, it is the other expensive part */
+	if (cert_forge->x509_cert)
+		cert_forge->ssl_context = CommEvTCPServerSSLCertContextNew(cert_forge->x509_cert, cert_forge->main_key);
+
+	return cert_forge->x509_cert;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPServerSSLCertForgeFinish(void *thread_job_ptr, void *cert_forge_ptr)
+{
+	CommEvTCPServerCertForge *cert_forge	= cert_forge_ptr;
+	CommEvTCPServerCertificate *cert_info;
+	CommEvTCPServerConn *conn_hnd;
+	CommEvTCPServer *srv_ptr;
+	DLinkedListNode *node;
+	struct timeval finish_tv;
+	unsigned long latency_ms;
+	char thrd_seen[KQEV_THREAD_MAX + 1];
+
+	/* Server destroy orphans us under FORGE lock */
+	pthread_mutex_lock(&cert_forge->mutex);
+	srv_ptr = cert_forge->parent_srv;
+	pthread_mutex_unlock(&cert_forge->mutex);
+
+	/* Server went away while we were forging */
+	if (!srv_ptr)
+	{
+		CommEvTCPServerSSLCertForgeRelease(cert_forge);
+		return 1;
+	}
+
+	/* Calculate latency, including time spent enqueued */
+	gettimeofday(&finish_tv, NULL);
+	latency_ms = (((finish_tv.tv_sec - cert_forge->begin_tv.tv_sec) * 1000) + ((finish_tv.tv_usec - cert_forge->begin_tv.tv_usec) / 1000));
+
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_forge.mutex);
+
+	srv_ptr->ssldata.cert_forge.stats.latency_last_ms	= latency_ms;
+	srv_ptr->ssldata.cert_forge.stats.latency_total_ms	+= latency_ms;
+
+	if (latency_ms > srv_ptr->ssldata.cert_forge.stats.latency_max_ms)
+		srv_ptr->ssldata.cert_forge.stats.latency_max_ms = latency_ms;
+
+	if (cert_forge->x509_cert)
+		srv_ptr->ssldata.cert_forge.stats.forged++;
+	else
+		srv_ptr->ssldata.cert_forge.stats.failed++;
+
+	/* No longer pending, new connections for this host will hit cache or start a new FORGE */
+	AssocArrayDelete(srv_ptr->ssldata.cert_forge.table, cert_forge->dnsname_str);
+	DLinkedListDelete(&srv_ptr->ssldata.cert_forge.list, &cert_forge->node);
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_forge.mutex);
+
+	/* Forged, move it into cache */
+	if (cert_forge->x509_cert)
+	{
+		/* Worker built context, plug session resumption before anyone else can see it */
+		if (cert_forge->ssl_context)
+			CommEvTCPServerSSLSessionContextInit(srv_ptr, cert_forge->ssl_context, cert_forge->dnsname_str);
+
+		pthread_mutex_lock(&srv_ptr->ssldata.cert_cache.mutex);
+
+		cert_info = CommEvTCPServerSSLCertCacheEntryAdd(srv_ptr, cert_forge->dnsname_str, cert_forge->x509_cert, cert_forge->ssl_context);
+
+		/* Cache took ownership */
+		if (cert_info->x509_cert == cert_forge->x509_cert)
+		{
+			cert_forge->x509_cert	= NULL;
+			cert_forge->ssl_context	= NULL;
+		}
+
+		/* Keep our own reference for waiters, cache may evict it before they wake up */
+		cert_forge->waiter_cert = cert_info->x509_cert;
+		CommEvSSLUtils_X509CertRefCountInc(cert_forge->waiter_cert, 1);
+
+		pthread_mutex_unlock(&srv_ptr->ssldata.cert_cache.mutex);
+	}
+	else
+	{
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "Failed forging certificate for [%s]\n", cert_forge->dnsname_str);
+	}
+
+	/* Waiting connections belong to the thread that accepted them, wake each thread once and let it pick its own */
+	memset(&thrd_seen, 0, sizeof(thrd_seen));
+	pthread_mutex_lock(&cert_forge->mutex);
+
+	for (node = cert_forge->waiter_list.head; node; node = node->next)
+	{
+		conn_hnd = node->data;
+
+		/* Already scheduled this thread */
+		if (thrd_seen[conn_hnd->thrd_id])
+			continue;
+
+		thrd_seen[conn_hnd->thrd_id] = 1;
+
+		/* Each WAKE_JOB holds a reference */
+		if (EvKQBaseThreadJobSend(srv_ptr->kq_base, conn_hnd->thrd_id, CommEvTCPServerSSLCertForgeWakeJob, cert_forge))
+			cert_forge->ref_count++;
+	}
+
+	pthread_mutex_unlock(&cert_forge->mutex);
+
+	/* Drop reference held by THREAD_POOL JOB */
+	CommEvTCPServerSSLCertForgeRelease(cert_forge);
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPServerSSLCertForgeWakeJob(int unused_fd, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvTCPServerCertForge *cert_forge	= cb_data;
+	EvKQBase *ev_base						= base_ptr;
+	CommEvTCPServerConn *conn_hnd;
+	DLinkedListNode *node;
+	DLinkedList wake_list;
+
+	DLinkedListInit(&wake_list, BRBDATA_THREAD_UNSAFE);
+
+	/* Move connections owned by this thread out of waiter list - Closing ones already left it under the same lock */
+	pthread_mutex_lock(&cert_forge->mutex);
+
+	for (node = cert_forge->waiter_list.head; node; )
+	{
+		conn_hnd	= node->data;
+		node		= node->next;
+
+		/* Owned by another thread, it has its own job */
+		if (conn_hnd->kq_base != ev_base)
+			continue;
+
+		DLinkedListDelete(&cert_forge->waiter_list, &conn_hnd->cert_forge.node);
+		DLinkedListAdd(&wake_list, &conn_hnd->cert_forge.node, conn_hnd);
+		continue;
+	}
+
+	pthread_mutex_unlock(&cert_forge->mutex);
+
+	/* Now, on owner thread, resume or drop them */
+	while ((conn_hnd = DLinkedListPopHead(&wake_list)))
+	{
+		conn_hnd->cert_forge.forge_ptr = NULL;
+
+		/* Nothing to handshake with */
+		if (!cert_forge->waiter_cert)
+		{
+			CommEvTCPServerConnClose(conn_hnd);
+			continue;
+		}
+
+		CommEvSSLUtils_X509CertRefCountInc(cert_forge->waiter_cert, 1);
+		conn_hnd->ssldata.x509_cert				= cert_forge->waiter_cert;
+		conn_hnd->flags.ssl_cert_cached				= 1;
+		conn_hnd->flags.ssl_cert_destroy_onclose	= 1;
+
+		CommEvTCPServerKickConnFromAcceptDefer(conn_hnd);
+		continue;
+	}
+
+	CommEvTCPServerSSLCertForgeRelease(cert_forge);
+	return 1;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPServerSSLCertForgeDestroy(CommEvTCPServerCertForge *cert_forge)
+{
+	X509_free(cert_forge->ca_cert);
+	EVP_PKEY_free(cert_forge->ca_key);
+	EVP_PKEY_free(cert_forge->main_key);
+
+	if (cert_forge->x509_cert)
+		X509_free(cert_forge->x509_cert);
+
+	if (cert_forge->waiter_cert)
+		X509_free(cert_forge->waiter_cert);
+
+	if (cert_forge->ssl_context)
+		SSL_CTX_free(cert_forge->ssl_context);
+
+	pthread_mutex_destroy(&cert_forge->mutex);
+	free(cert_forge);
+	return;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPServerSSLCertForgeRelease(CommEvTCPServerCertForge *cert_forge)
+{
+	int ref_count;
+
+	pthread_mutex_lock(&cert_forge->mutex);
+	ref_count = --cert_forge->ref_count;
+	pthread_mutex_unlock(&cert_forge->mutex);
+
+	/* Still referenced by a pending JOB */
+	if (ref_count > 0)
+		return;
+
+	CommEvTCPServerSSLCertForgeDestroy(cert_forge);
+	return;
+}
+/**************************************************************************************************************************/
+static CommEvTCPServerSSLSession *CommEvTCPServerSSLSessionCacheEntryLookup(CommEvTCPServer *srv_ptr, char *sessid_str)
+{
+	CommEvTCPServerSSLSession *ssl_sess;
+
+	/* Caller holds SESSION_CACHE MUTEX, as does caller of ENTRY_EVICT - Cache not initialized */
+	if (!srv_ptr->ssldata.session_cache.table)
+		return NULL;
+
+	ssl_sess = AssocArrayLookup(srv_ptr->ssldata.session_cache.table, sessid_str);
+
+	/* Touch LRU */
+	if (ssl_sess)
+		DLinkedListMoveToHead(&srv_ptr->ssldata.session_cache.list, &ssl_sess->node);
+
+	return ssl_sess;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPServerSSLSessionCacheEntryEvict(CommEvTCPServer *srv_ptr, CommEvTCPServerSSLSession *ssl_sess)
+{
+	char key_str[(SSL_MAX_SSL_SESSION_ID_LENGTH * 2) + 1];
+
+	/* Key lives inside entry, which is released by ASSOC_ARRAY destroy function */
+	strlcpy((char*)&key_str, ssl_sess->sessid_str, sizeof(key_str));
+
+	DLinkedListDelete(&srv_ptr->ssldata.session_cache.list, &ssl_sess->node);
+	AssocArrayDelete(srv_ptr->ssldata.session_cache.table, (char*)&key_str);
+
+	srv_ptr->ssldata.session_cache.stats.evicted++;
+	return;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPServerSSLSessionIDToStr(const unsigned char *sessid_ptr, unsigned int sessid_sz, char *ret_buf)
+{
+	static const char hex_chars[] = "0123456789abcdef";
+	int i;
+
+	if (sessid_sz > SSL_MAX_SSL_SESSION_ID_LENGTH)
+		sessid_sz = SSL_MAX_SSL_SESSION_ID_LENGTH;
+
+	for (i = 0; i < sessid_sz; i++)
+	{
+		ret_buf[(i * 2)]		= hex_chars[(sessid_ptr[i] >> 4)];
+		ret_buf[(i * 2) + 1]	= hex_chars[(sessid_ptr[i] & 0x0F)];
+	}
+
+	ret_buf[(i * 2)] = '\0';
+	return;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPServerSSLSessionNewCB(SSL *ssl_handle, SSL_SESSION *ssl_session)
+{
+	CommEvTCPServerConn *conn_hnd	= SSL_get_app_data(ssl_handle);
+	CommEvTCPServerSSLSession *ssl_sess;
+	CommEvTCPServer *srv_ptr;
+	const unsigned char *sessid_ptr;
+	unsigned int sessid_sz;
+	char sessid_str[(SSL_MAX_SSL_SESSION_ID_LENGTH * 2) + 1];
+
+	/* Not one of our connections, let OpenSSL drop it */
+	if (!conn_hnd)
+		return 0;
+
+	srv_ptr		= conn_hnd->parent_srv;
+	sessid_ptr	= SSL_SESSION_get_id(ssl_session, &sessid_sz);
+
+	/* Ticket only session, nothing to index */
+	if (0 == sessid_sz)
+		return 0;
+
+	CommEvTCPServerSSLSessionIDToStr(sessid_ptr, sessid_sz, (char*)&sessid_str);
+
+	/* Handshakes finish on all IO threads, table, LRU and stats are guarded by SESSION_CACHE MUTEX */
+	pthread_mutex_lock(&srv_ptr->ssldata.session_cache.mutex);
+
+	/* Cache arena not initialized, initialize now */
+	if (!srv_ptr->ssldata.session_cache.table)
+	{
+		srv_ptr->ssldata.session_cache.table = AssocArrayNew(BRBDATA_THREAD_UNSAFE, 8191, (ASSOCITEM_DESTROYFUNC*)CommEvTCPServerSSLSessionCacheDestroy);
+		DLinkedListInit(&srv_ptr->ssldata.session_cache.list, BRBDATA_THREAD_UNSAFE);
+	}
+
+	/* Already cached */
+	if (AssocArrayLookup(srv_ptr->ssldata.session_cache.table, (char*)&sessid_str))
+	{
+		pthread_mutex_unlock(&srv_ptr->ssldata.session_cache.mutex);
+		return 0;
+	}
+
+	/* Create a new session node, it takes the reference OpenSSL gave us */
+	ssl_sess				= calloc(1, sizeof(CommEvTCPServerSSLSession));
+	ssl_sess->ssl_session	= ssl_session;
+	strlcpy((char*)&ssl_sess->sessid_str, (char*)&sessid_str, sizeof(ssl_sess->sessid_str));
+
+	AssocArrayAdd(srv_ptr->ssldata.session_cache.table, (char*)&sessid_str, ssl_sess);
+	DLinkedListAddHead(&srv_ptr->ssldata.session_cache.list, &ssl_sess->node, ssl_sess);
+	srv_ptr->ssldata.session_cache.stats.stored++;
+
+	/* Keep cache bounded, evict from LRU tail */
+	while (srv_ptr->ssldata.session_cache.list.size > srv_ptr->ssldata.session_cache.max_entries)
+		CommEvTCPServerSSLSessionCacheEntryEvict(srv_ptr, srv_ptr->ssldata.session_cache.list.tail->data);
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.session_cache.mutex);
+	return 1;
+}
+/**************************************************************************************************************************/
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+static SSL_SESSION *CommEvTCPServerSSLSessionGetCB(SSL *ssl_handle, unsigned char *sessid_ptr, int sessid_sz, int *copy)
+#else
+static SSL_SESSION *CommEvTCPServerSSLSessionGetCB(SSL *ssl_handle, const unsigned char *sessid_ptr, int sessid_sz, int *copy)
+#endif
+{
+	CommEvTCPServerConn *conn_hnd	= SSL_get_app_data(ssl_handle);
+	CommEvTCPServerSSLSession *ssl_sess;
+	CommEvTCPServer *srv_ptr;
+	SSL_SESSION *ssl_session;
+	char sessid_str[(SSL_MAX_SSL_SESSION_ID_LENGTH * 2) + 1];
+
+	/* We hand back a reference of our own, taken under lock, so OpenSSL must not take another */
+	*copy = 0;
+
+	/* Not one of our connections */
+	if ((!conn_hnd) || (sessid_sz <= 0))
+		return NULL;
+
+	srv_ptr = conn_hnd->parent_srv;
+	CommEvTCPServerSSLSessionIDToStr(sessid_ptr, sessid_sz, (char*)&sessid_str);
+
+	/* Lookup, LRU touch and eviction on another thread must not interleave with us */
+	pthread_mutex_lock(&srv_ptr->ssldata.session_cache.mutex);
+
+	ssl_sess = CommEvTCPServerSSLSessionCacheEntryLookup(srv_ptr, (char*)&sessid_str);
+
+	/* Not found, client will do a full handshake */
+	if (!ssl_sess)
+	{
+		srv_ptr->ssldata.session_cache.stats.miss++;
+		pthread_mutex_unlock(&srv_ptr->ssldata.session_cache.mutex);
+		return NULL;
+	}
+
+	/* Expired, drop it */
+	if ((SSL_SESSION_get_time(ssl_sess->ssl_session) + SSL_SESSION_get_timeout(ssl_sess->ssl_session)) <= time(NULL))
+	{
+		srv_ptr->ssldata.session_cache.stats.expired++;
+		CommEvTCPServerSSLSessionCacheEntryEvict(srv_ptr, ssl_sess);
+		pthread_mutex_unlock(&srv_ptr->ssldata.session_cache.mutex);
+		return NULL;
+	}
+
+	/* Reference is taken while entry can not be evicted beneath us */
+	ssl_session = ssl_sess->ssl_session;
+	CommEvSSLUtils_SessionRefCountInc(ssl_session, 1);
+	srv_ptr->ssldata.session_cache.stats.hit++;
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.session_cache.mutex);
+	return ssl_session;
+}
+/**************************************************************************************************************************/
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+static int CommEvTCPServerSSLTicketKeyCB(SSL *ssl_handle, unsigned char *key_name, unsigned char *iv, EVP_CIPHER_CTX *cipher_ctx, EVP_MAC_CTX *mac_ctx, int enc)
+#else
+static int CommEvTCPServerSSLTicketKeyCB(SSL *ssl_handle, unsigned char *key_name, unsigned char *iv, EVP_CIPHER_CTX *cipher_ctx, HMAC_CTX *mac_ctx, int enc)
+#endif
+{
+	CommEvTCPServerConn *conn_hnd	= SSL_get_app_data(ssl_handle);
+	CommEvTCPServerSSLTicketKey ticket_key;
+	CommEvTCPServer *srv_ptr;
+	int key_idx;
+
+	/* Not one of our connections */
+	if (!conn_hnd)
+		return -1;
+
+	srv_ptr = conn_hnd->parent_srv;
+
+	/* Issuing a new ticket - Encrypt it with current key */
+	if (enc)
 	{
-		srv_ptr->ssldata.cert_cache.table = AssocArrayNew(BRBDATA_THREAD_UNSAFE, 7951, (ASSOCITEM_DESTROYFUNC*)CommEvTCPServerSSLCertCacheDestroy);
-		DLinkedListInit(&srv_ptr->ssldata.cert_cache.list, BRBDATA_THREAD_UNSAFE);
+		if ((CommEvTCPServerSSLTicketKeyGet(srv_ptr, NULL, &ticket_key) < 0) || (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) <= 0))
+			return -1;
+
+		memcpy(key_name, &ticket_key.name, sizeof(ticket_key.name));
+
+		if ((!EVP_EncryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), NULL, (unsigned char*)&ticket_key.aes_key, iv)) ||
+				(!CommEvTCPServerSSLTicketMACInit(mac_ctx, (unsigned char*)&ticket_key.hmac_key)))
+			return -1;
+
+		srv_ptr->ssldata.ticket.stats.issued++;
+		return 1;
 	}
 
-	cert_info = (CommEvTCPServerCertificate*)AssocArrayLookup(srv_ptr->ssldata.cert_cache.table, dnsname_str);
+	/* Client presented a ticket - Find key by name, it may be current or an older one */
+	key_idx = CommEvTCPServerSSLTicketKeyGet(srv_ptr, key_name, &ticket_key);
 
-	/* Already cached, bail out */
-	if (cert_info)
+	/* Unknown or too old key, fall back to full handshake */
+	if (key_idx < 0)
+	{
+		srv_ptr->ssldata.ticket.stats.unknown_key++;
 		return 0;
+	}
 
-	/* Create a new certificate node */
-	cert_info				= calloc(1, sizeof(CommEvTCPServerCertificate));
-	cert_info->x509_cert	= x509_cert;
+	if ((!CommEvTCPServerSSLTicketMACInit(mac_ctx, (unsigned char*)&ticket_key.hmac_key)) ||
+			(!EVP_DecryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), NULL, (unsigned char*)&ticket_key.aes_key, iv)))
+		return -1;
 
-	/* Generate WILDCARD for this domain */
-	wildcardable = CommEvSSLUtils_GenerateWildCardFromDomain(dnsname_str, (char*)&wildcard_str, (sizeof(wildcard_str)));
+	srv_ptr->ssldata.ticket.stats.decrypted++;
 
-	/* Add into internal cache */
-	AssocArrayAdd(srv_ptr->ssldata.cert_cache.table, (wildcardable ? wildcard_str : dnsname_str), cert_info);
+	/* Issued with an older key, ask OpenSSL to renew it */
+	if (key_idx > 0)
+	{
+		srv_ptr->ssldata.ticket.stats.renewed++;
+		return 2;
+	}
 
 	return 1;
 }
 /**************************************************************************************************************************/
-X509 *CommEvTCPServerSSLCertCacheLookupByConnHnd(CommEvTCPServerConn *conn_hnd)
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+static int CommEvTCPServerSSLTicketMACInit(EVP_MAC_CTX *mac_ctx, unsigned char *hmac_key)
 {
-	char wildcard_str[512];
-	int wildcardable;
-
-	/* Try to find a CACHE_CERT for this SNI */
-	conn_hnd->ssldata.x509_cert			= CommEvTCPServerSSLCertCacheLookup(conn_hnd->parent_srv, CommEvTCPServerConnSSLDataGetSNIStr(conn_hnd));
-	conn_hnd->ssldata.sni_host_tldpos	= CommEvSSLUtils_GenerateWildCardFromDomain(CommEvTCPServerConnSSLDataGetSNIStr(conn_hnd), (char*)&wildcard_str, (sizeof(wildcard_str)));
-
-	if (conn_hnd->ssldata.sni_host_tldpos > 0)
-		conn_hnd->ssldata.sni_host_tldpos++;
+	OSSL_PARAM mac_params[2];
 
-	/* We are using a cached certificate, save flags */
-	if (conn_hnd->ssldata.x509_cert)
-		conn_hnd->flags.ssl_cert_cached = 1;
+	mac_params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "SHA256", 0);
+	mac_params[1] = OSSL_PARAM_construct_end();
 
-	/* Send back what we got */
-	return conn_hnd->ssldata.x509_cert;
+	return EVP_MAC_init(mac_ctx, hmac_key, 32, mac_params);
 }
+#else
+static int CommEvTCPServerSSLTicketMACInit(HMAC_CTX *mac_ctx, unsigned char *hmac_key)
+{
+	return HMAC_Init_ex(mac_ctx, hmac_key, 32, EVP_sha256(), NULL);
+}
+#endif
 /**************************************************************************************************************************/
-X509 *CommEvTCPServerSSLCertCacheLookup(CommEvTCPServer *srv_ptr, char *dnsname_str)
+static int CommEvTCPServerSSLTicketKeyGet(CommEvTCPServer *srv_ptr, unsigned char *key_name, CommEvTCPServerSSLTicketKey *ret_key)
 {
-	CommEvTCPServerCertificate *cert_info;
-	char wildcard_str[512];
-	int wildcardable;
-
-	/* Cache arena not initialized, bail out */
-	if (!srv_ptr->ssldata.cert_cache.table)
-		return NULL;
+	CommEvTCPServerSSLTicketKey *ticket_key;
+	time_t now_ts	= time(NULL);
+	int key_idx		= -1;
+	int i;
 
-	/* Try to find directly */
-	cert_info = (CommEvTCPServerCertificate*)AssocArrayLookup(srv_ptr->ssldata.cert_cache.table, dnsname_str);
+	pthread_mutex_lock(&srv_ptr->ssldata.ticket.mutex);
 
-	/* Found, return X509 certificate */
-	if (cert_info)
+	/* No key yet, or current one is too old to encrypt with */
+	if ((0 == srv_ptr->ssldata.ticket.key_arr[0].created_ts) ||
+			((!key_name) && ((now_ts - srv_ptr->ssldata.ticket.key_arr[0].created_ts) >= srv_ptr->ssldata.ticket.rotate_sec)))
 	{
-		//printf("CommEvTCPServerSSLCertCacheLookup - Found NON_WILDCARD_CERT [%p] for DNS [%s]\n", cert_info, dnsname_str);
-		return cert_info->x509_cert;
+		if (!CommEvTCPServerSSLTicketKeyRotateLocked(srv_ptr))
+			goto leave;
 	}
 
-	/* Generate WILDCARD for this domain */
-	wildcardable = CommEvSSLUtils_GenerateWildCardFromDomain(dnsname_str, (char*)&wildcard_str, (sizeof(wildcard_str)));
+	/* Encrypting, use current key */
+	if (!key_name)
+	{
+		key_idx = 0;
+		goto leave;
+	}
 
-	/* Generated WILDCARD, try to lookup */
-	if (wildcardable)
+	/* Decrypting, search by name */
+	for (i = 0; i < COMM_TCP_SERVER_SSL_TICKET_KEY_COUNT; i++)
 	{
-		/* Try to find via WILDCARD */
-		cert_info = (CommEvTCPServerCertificate*)AssocArrayLookup(srv_ptr->ssldata.cert_cache.table, wildcard_str);
+		ticket_key = &srv_ptr->ssldata.ticket.key_arr[i];
+
+		/* Empty slot, or older than its whole valid window */
+		if ((0 == ticket_key->created_ts) || ((now_ts - ticket_key->created_ts) >= (srv_ptr->ssldata.ticket.rotate_sec * COMM_TCP_SERVER_SSL_TICKET_KEY_COUNT)))
+			continue;
 
-		/* Found, return X509 certificate */
-		if (cert_info)
+		if (!memcmp(ticket_key->name, key_name, sizeof(ticket_key->name)))
 		{
-			//printf("CommEvTCPServerSSLCertCacheLookup - Found WILDCARD_CERT [%p] for DNS [%s] from DNS_NAME [%s]\n", cert_info, wildcard_str, dnsname_str);
-			return cert_info->x509_cert;
+			key_idx = i;
+			break;
 		}
+
+		continue;
+	}
+
+	leave:
+
+	/* Hand back a copy, so rotation can happen beneath caller */
+	if (key_idx >= 0)
+		memcpy(ret_key, &srv_ptr->ssldata.ticket.key_arr[key_idx], sizeof(CommEvTCPServerSSLTicketKey));
+
+	pthread_mutex_unlock(&srv_ptr->ssldata.ticket.mutex);
+
+	return key_idx;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPServerSSLTicketKeyRotateLocked(CommEvTCPServer *srv_ptr)
+{
+	CommEvTCPServerSSLTicketKey new_key;
+
+	/* Generate new random key material */
+	if ((RAND_bytes((unsigned char*)&new_key.name, sizeof(new_key.name)) <= 0) || (RAND_bytes((unsigned char*)&new_key.aes_key, sizeof(new_key.aes_key)) <= 0) ||
+			(RAND_bytes((unsigned char*)&new_key.hmac_key, sizeof(new_key.hmac_key)) <= 0))
+	{
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "Failed generating TLS ticket key\n");
+		return 0;
 	}
 
-	//printf("CommEvTCPServerSSLCertCacheLookup - NOT FOUND for DNS [%s] nor WILDCARD [%s]\n", dnsname_str, wildcard_str);
+	new_key.created_ts = time(NULL);
 
-	/* Not found, NULL */
-	return NULL;
+	/* Shift older keys down, so tickets they issued can still be decrypted */
+	memmove(&srv_ptr->ssldata.ticket.key_arr[1], &srv_ptr->ssldata.ticket.key_arr[0], (sizeof(CommEvTCPServerSSLTicketKey) * (COMM_TCP_SERVER_SSL_TICKET_KEY_COUNT - 1)));
+	memcpy(&srv_ptr->ssldata.ticket.key_arr[0], &new_key, sizeof(CommEvTCPServerSSLTicketKey));
+	srv_ptr->ssldata.ticket.stats.rotated++;
+
+	return 1;
 }
 /**************************************************************************************************************************/
 /**/
@@ -629,6 +1616,7 @@ X509 *CommEvTCPServerSSLCertCacheLookup(CommEvTCPServer *srv_ptr, char *dnsname_
 static int CommEvTCPServerListenerTCPInit(CommEvTCPServer *srv_ptr, CommEvTCPServerConf *server_conf, CommEvTCPServerListener *listener)
 {
 	EvBaseKQFileDesc *kq_fd;
+	char sid_ctx_str[64];
 	int op_status;
 
 	int slot_id = listener->slot_id;
@@ -661,8 +1649,14 @@ static int CommEvTCPServerListenerTCPInit(CommEvTCPServer *srv_ptr, CommEvTCPSer
 		return (- COMM_SERVER_FAILURE_REUSEADDR);
 	}
 
-	/* Set SOCKOPT SO_REUSEPORT */
-	if ((srv_ptr->cfg[slot_id].flags.reuse_port) && (EvKQBaseSocketSetReusePort(srv_ptr->kq_base, listener->socket_fd) == -1))
+	/* Set SOCKOPT SO_REUSEPORT - Balanced flavor if we are sharding this listener among threads */
+	if ((srv_ptr->cfg[slot_id].flags.thrd_shard) && (EvKQBaseSocketSetReusePortLB(srv_ptr->kq_base, listener->socket_fd) == -1))
+	{
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - LISTENER_ID [%d] - COMM_SERVER_FAILURE_REUSEPORT\n", listener->socket_fd, slot_id);
+		SlotQueueFree(&srv_ptr->listener.slot, slot_id);
+		return (- COMM_SERVER_FAILURE_REUSEPORT);
+	}
+	else if ((!srv_ptr->cfg[slot_id].flags.thrd_shard) && (srv_ptr->cfg[slot_id].flags.reuse_port) && (EvKQBaseSocketSetReusePort(srv_ptr->kq_base, listener->socket_fd) == -1))
 	{
 		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - LISTENER_ID [%d] - COMM_SERVER_FAILURE_REUSEPORT\n", listener->socket_fd, slot_id);
 		SlotQueueFree(&srv_ptr->listener.slot, slot_id);
@@ -726,6 +1720,10 @@ static int CommEvTCPServerListenerTCPInit(CommEvTCPServer *srv_ptr, CommEvTCPSer
 			return (- COMM_SERVER_FAILURE_SSL_CONTEXT);
 		}
 
+		/* Plug server wide session cache and ticket keys */
+		snprintf((char*)&sid_ctx_str, sizeof(sid_ctx_str), "LISTENER:%d:%d", slot_id, listener->port);
+		CommEvTCPServerSSLSessionContextInit(srv_ptr, listener->ssldata.ssl_context, (char*)&sid_ctx_str);
+
 		/* Load the CERTIFICATE FILE into the SSL_CTX structure */
 		if (srv_ptr->cfg[slot_id].ssl.ca_cert_path[0] != '\0')
 		{
@@ -808,6 +1806,10 @@ static int CommEvTCPServerListenInet(CommEvTCPServer *srv_ptr, int listener_id)
 		return COMM_SERVER_FAILURE_LISTEN;
 	}
 
+	/* Deferred accept is an optimization, keep going without it if kernel refuses */
+	if ((srv_ptr->cfg[listener_id].flags.defer_accept) && (EvKQBaseSocketSetDeferAccept(srv_ptr->kq_base, listener->socket_fd, COMM_TCP_DEFER_ACCEPT_SEC) == -1))
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_YELLOW, "Failed DEFER_ACCEPT on socket [%d] - ERRNO [%d]\n", listener->socket_fd, errno);
+
 	return COMM_SERVER_INIT_OK;
 }
 /**************************************************************************************************************************/
@@ -857,6 +1859,33 @@ static int CommEvTCPServerListenUnix(CommEvTCPServer *srv_ptr, int listener_id,
 	return COMM_SERVER_INIT_OK;
 }
 /**************************************************************************************************************************/
+static void CommEvTCPServerListenerThreadsShutdown(CommEvTCPServer *srv_ptr, CommEvTCPServerListener *listener)
+{
+	EvKQBase *worker_base;
+	int i;
+
+	/* THRD_ID zero socket is closed by caller, walk workers */
+	for (i = 1; i < COMM_TCP_SERVER_MAX_THREADS; i++)
+	{
+		/* No socket on this worker */
+		if (listener->thrd_socket_fd[i] < 0)
+			continue;
+
+		worker_base = EvKQBaseThreadBaseGetByID(srv_ptr->kq_base, i);
+
+		/* Worker already stopped, we can close it from here, otherwise ask worker to close it */
+		if ((worker_base) && (worker_base->kq_thread.stop_request))
+			CommEvTCPServerListenerThreadClose(i, 0, i, (void*)(long)listener->thrd_socket_fd[i], worker_base);
+		else
+			EvKQBaseThreadJobSend(srv_ptr->kq_base, i, CommEvTCPServerListenerThreadClose, (void*)(long)listener->thrd_socket_fd[i]);
+
+		listener->thrd_socket_fd[i] = -1;
+		continue;
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
 static void CommEvTCPServerDispatchEvent(CommEvTCPServer *srv_ptr, CommEvTCPServerConn *conn_hnd, int data_sz, int thrd_id, int ev_type)
 {
 	CommEvTCPServerListener *listener;
@@ -912,7 +1941,7 @@ static int CommEvTCPServerEventProtocolIdentifyTimeout(int fd, int read_sz, int
 
 	/* Set disconnect and read internal events for newly connected socket */
 	EvKQBaseSetEvent(ev_base, conn_hnd->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventClose, conn_hnd);
-	EvKQBaseSetEvent(ev_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventRead, conn_hnd);
+	CommEvTCPServerEventReadSchedule(conn_hnd, 0);
 
 	/* Fire up data rate calculation timer if flag is set */
 	COMM_EV_STATS_CONN_HND_FIRE_TIMER(conn_hnd);
@@ -988,7 +2017,7 @@ static int CommEvTCPServerEventProtocolIdentify(int fd, int read_sz, int thrd_id
 
 	/* Set disconnect and read internal events for newly connected socket */
 	EvKQBaseSetEvent(ev_base, conn_hnd->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventClose, conn_hnd);
-	EvKQBaseSetEvent(ev_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventRead, conn_hnd);
+	CommEvTCPServerEventReadSchedule(conn_hnd, 0);
 
 	/* Dispatch a read event for this pending bytes on FD buffer */
 	CommEvTCPServerEventRead(conn_hnd->socket_fd, read_sz, thrd_id, conn_hnd, ev_base);
@@ -1063,7 +2092,7 @@ static int CommEvTCPServerEventSNIPeek(int fd, int read_sz, int thrd_id, void *c
 	/* SNI host found, set flags */
 	if (conn_hnd->ssldata.sni_host_strsz > 0)
 	{
-		//KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - Parsed TLS/VHOST is [%s]\n", fd, conn_hnd->ssldata.sni_host_str);
+		//KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - Parsed TLS/VHOST is [%s]\n", fd, conn_hnd->ssldata.sni_host_ptr);
 
 		/* We have SNI information on this connection */
 		conn_hnd->flags.tls_has_sni = 1;
@@ -1136,6 +2165,85 @@ static int CommEvTCPServerEventSNIPeek(int fd, int read_sz, int thrd_id, void *c
 	return 0;
 }
 /**************************************************************************************************************************/
+static int CommEvTCPServerListenerThreadInit(int fd, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	EvBaseKQFileDesc *kq_fd;
+	int socket_fd;
+	int socket_sz;
+
+	EvKQBase *ev_base					= base_ptr;
+	CommEvTCPServerListener *listener	= cb_data;
+	CommEvTCPServer *srv_ptr			= listener->parent_srv;
+	int slot_id							= listener->slot_id;
+	int inet6							= ((COMM_SERVER_TYPE_INET6 == srv_ptr->cfg[slot_id].srv_type) ? 1 : 0);
+
+	/* Listener deleted before we got here, bail out */
+	if (!listener->flags.active)
+		return 0;
+
+	/* Create socket on this worker */
+	socket_fd = (inet6 ? EvKQBaseSocketTCPv6New(ev_base) : EvKQBaseSocketTCPNew(ev_base));
+	socket_sz = (inet6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in));
+
+	/* Check if created socket is ok */
+	if (socket_fd < 0)
+	{
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "THRD [%d] - LISTENER_ID [%d] - COMM_SERVER_FAILURE_SOCKET\n", thrd_id, slot_id);
+		return 0;
+	}
+
+	/* Same options and address of THRD_ID zero socket, so kernel balances incoming connections among all of them */
+	if (srv_ptr->cfg[slot_id].flags.reuse_addr)
+		EvKQBaseSocketSetReuseAddr(ev_base, socket_fd);
+
+	if ((EvKQBaseSocketSetReusePortLB(ev_base, socket_fd) == -1) ||
+			(bind(socket_fd, (struct sockaddr *)&srv_ptr->cfg[slot_id].bind_addr, socket_sz) < 0) ||
+			(listen(socket_fd, COMM_TCP_ACCEPT_QUEUE) < 0))
+	{
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - THRD [%d] - LISTENER_ID [%d] - Failed sharding listener - ERRNO [%d]\n",
+				socket_fd, thrd_id, slot_id, errno);
+
+		EvKQBaseSocketClose(ev_base, socket_fd);
+		return 0;
+	}
+
+	/* Same deferred accept behavior of THRD_ID zero socket */
+	if ((srv_ptr->cfg[slot_id].flags.defer_accept) && (EvKQBaseSocketSetDeferAccept(ev_base, socket_fd, COMM_TCP_DEFER_ACCEPT_SEC) == -1))
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_YELLOW, "FD [%d] - THRD [%d] - Failed DEFER_ACCEPT - ERRNO [%d]\n", socket_fd, thrd_id, errno);
+
+	/* Grab FD from reference table and mark listening socket flags */
+	kq_fd 	= EvKQBaseFDGrabFromArena(ev_base, socket_fd);
+	kq_fd->flags.so_listen = 1;
+
+	/* Set humanized description of this socket */
+	EvKQBaseFDDescriptionSet(kq_fd, "EV_TCPSERVER [%s:%d] - LID/FD [%d/%d] - THRD [%d]", (COMM_SERVERPROTO_SSL == srv_ptr->cfg[slot_id].srv_proto ? "SSL" : "PLAIN"),
+			listener->port, slot_id, socket_fd, thrd_id);
+
+	/* Make it non-blocking and no-delay */
+	EvKQBaseSocketSetNonBlock(ev_base, socket_fd);
+	EvKQBaseSocketSetNoDelay(ev_base, socket_fd);
+
+	/* Save it and begin accepting on this thread */
+	listener->thrd_socket_fd[thrd_id] = socket_fd;
+	EvKQBaseSetEvent(ev_base, socket_fd, COMM_EV_READ, COMM_ACTION_ADD_PERSIST, CommEvTCPServerEventAccept, listener);
+	EvKQBaseSetEvent(ev_base, socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventListenerClose, listener);
+
+	KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - THRD [%d] - Sharded LISTENER_ID [%d]\n", socket_fd, thrd_id, slot_id);
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPServerListenerThreadClose(int fd, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	EvKQBase *ev_base	= base_ptr;
+	int socket_fd		= (long)cb_data;
+
+	/* Clear description and close the socket, cancelling any pending events */
+	EvKQBaseFDDescriptionClearByFD(ev_base, socket_fd);
+	EvKQBaseSocketClose(ev_base, socket_fd);
+
+	return 1;
+}
+/**************************************************************************************************************************/
 static int CommEvTCPServerEventListenerClose(int fd, int accept_queue_sz, int thrd_id, void *cb_data, void *base_ptr)
 {
 
@@ -1148,16 +2256,16 @@ static int CommEvTCPServerEventAccept(int fd, int accept_queue_sz, int thrd_id,
 {
 	CommEvTCPServerConn *conn_hnd;
 	EvBaseKQFileDesc *kq_fd;
-	struct sockaddr_in clientaddr;
+	struct sockaddr_storage clientaddr;
+	socklen_t sockaddr_sz;
 	int conn_fd;
 
 	EvKQBase *ev_base					= base_ptr;
 	CommEvTCPServerListener *listener	= cb_data;
 	CommEvTCPServer *srv_ptr			= listener->parent_srv;
-	unsigned int sockaddr_sz			= sizeof(struct sockaddr_in);
 	int listener_id						= listener->slot_id;
 	int accept_count					= 0;
-	int accept_max						= COMM_TCP_ACCEPT_QUEUE;
+	int accept_max;
 
 	CommEvTCPServerCBH *cb_handler		= NULL;
 	void *cb_handler_data				= NULL;
@@ -1172,11 +2280,21 @@ static int CommEvTCPServerEventAccept(int fd, int accept_queue_sz, int thrd_id,
 	if (cb_handler)
 		cb_handler(listener->socket_fd, accept_queue_sz, thrd_id, cb_handler_data, srv_ptr);
 
+	/* Batch follows backlog reported by kernel, with some slack for connections arriving while we drain it. Persistent event fires again for leftovers */
+	accept_max = (accept_queue_sz < COMM_TCP_ACCEPT_BATCH_MIN) ? COMM_TCP_ACCEPT_BATCH_MIN : (accept_queue_sz + (accept_queue_sz / 4));
+	accept_max = (accept_max > COMM_TCP_ACCEPT_QUEUE) ? COMM_TCP_ACCEPT_QUEUE : accept_max;
+
 	/* Accept as many connections as we can in the same IO loop */
-	while ((accept_count < accept_queue_sz) && (accept_count < accept_max))
+	while (accept_count < accept_max)
 	{
-		/* Accept the connection */
+		sockaddr_sz = sizeof(clientaddr);
+
+		/* Accept the connection - Where supported, kernel sets non-blocking and close-on-exec in the same syscall */
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+		conn_fd = accept4(fd, (struct sockaddr *)&clientaddr, &sockaddr_sz, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
 		conn_fd = accept(fd, (struct sockaddr *)&clientaddr, &sockaddr_sz);
+#endif
 
 		/* Check if succeeded accepting connection */
 		if (conn_fd > 0)
@@ -1196,12 +2314,22 @@ static int CommEvTCPServerEventAccept(int fd, int accept_queue_sz, int thrd_id,
 			KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - Accepted NEW_FD on CONN_FD [%d]\n", fd, conn_fd);
 
 			/* Common POST_ACCEPT initialization procedure and set a CLOSE event */
-			CommEvTCPServerAcceptPostInit(srv_ptr, listener, conn_fd, accept_queue_sz, thrd_id);
+			CommEvTCPServerAcceptPostInit(srv_ptr, ev_base, listener, conn_fd, &clientaddr, accept_queue_sz, thrd_id);
 			EvKQBaseSetEvent(ev_base, conn_hnd->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventClose, conn_hnd);
 
 			/* Increment accept count */
 			accept_count++;
 		}
+		/* Backlog drained before batch limit, nothing wrong */
+		else if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+		{
+			break;
+		}
+		/* Peer gave up while on queue, try next one */
+		else if ((ECONNABORTED == errno) || (EINTR == errno))
+		{
+			continue;
+		}
 		else
 		{
 			KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Accept failed on LID [%d] - ERR [%d] - ERRNO [%d]\n", fd, listener_id, conn_fd, errno);
@@ -1279,7 +2407,14 @@ static int CommEvTCPServerEventSSLAccept(int fd, int read_sz, int thrd_id, void
 	/* SSL connected OK */
 	else
 	{
-		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - LID [%d] - SSL Handshake OK\n", conn_hnd->socket_fd, conn_hnd->listener->slot_id);
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - LID [%d] - SSL Handshake OK - RESUMED [%d]\n",
+				conn_hnd->socket_fd, conn_hnd->listener->slot_id, SSL_session_reused(conn_hnd->ssldata.ssl_handle));
+
+		/* Account resumed versus full handshakes - Handshakes finish on all IO threads */
+		if (SSL_session_reused(conn_hnd->ssldata.ssl_handle))
+			__atomic_add_fetch(&srv_ptr->ssldata.session_cache.stats.resumed, 1, __ATOMIC_RELAXED);
+		else
+			__atomic_add_fetch(&srv_ptr->ssldata.session_cache.stats.full, 1, __ATOMIC_RELAXED);
 
 		/* Reset HANDHSAKE defer flag */
 		conn_hnd->flags.ssl_handshake_defer		= 0;
@@ -1333,7 +2468,7 @@ static int CommEvTCPServerEventWrite(int fd, int can_write_sz, int thrd_id, void
 	int op_status;
 
 	/* Invoke IO mechanism to write data */
-	op_status = CommEvTCPAIOWrite(ev_base, srv_ptr->log_base, &conn_hnd->statistics, &conn_hnd->iodata, &ioret, srv_ptr, can_write_sz,
+	op_status = CommEvTCPAIOWrite(ev_base, srv_ptr->log_base, conn_hnd->statistics, &conn_hnd->iodata, &ioret, srv_ptr, can_write_sz,
 			(!conn_hnd->flags.close_request));
 
 	/* Closed flag set, we are already destroyed, just bail out */
@@ -1401,7 +2536,11 @@ static int CommEvTCPServerEventRead(int fd, int can_read_sz, int thrd_id, void *
 	CommEvTCPServer *tcp_srv		= conn_hnd->parent_srv;
 	EvBaseKQFileDesc *kq_fd			= EvKQBaseFDGrabFromArena(ev_base, fd);
 	int listener_id					= conn_hnd->listener->slot_id;
+	int read_pending				= 0;
 	int data_read					= 0;
+	int drain_count;
+	int pending_sz;
+	int drain_sz;
 
 	KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - CLOSED [%d] - ADDR [%s] - [%d] bytes buffered to read\n",
 			fd, kq_fd->flags.closed, conn_hnd->string_ip, can_read_sz);
@@ -1420,17 +2559,47 @@ static int CommEvTCPServerEventRead(int fd, int can_read_sz, int thrd_id, void *
 	/* Process the READ BUFFER */
 	data_read = CommEvTCPServerEventProcessBuffer(conn_hnd, can_read_sz, thrd_id, NULL, 0);
 
+	/* Edge triggered READ_EV will not fire again for bytes already sitting in kernel, so drain socket until EAGAIN */
+	if ((data_read > 0) && (kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.edge) && (!conn_hnd->flags.peek_on_read))
+	{
+		for (drain_count = 0; drain_count < COMM_TCP_READ_EDGE_DRAIN_MAX; drain_count++)
+		{
+			/* Closed beneath our feet, upper layers dropped READ_EV or paired peer is full */
+			if ((kq_fd->flags.closed) || (kq_fd->flags.closing) || (!conn_hnd->events[CONN_EVENT_READ].cb_handler_ptr) || (conn_hnd->backpressure.flags.read_paused))
+				break;
+
+			/* Nothing left on kernel buffer */
+			pending_sz = EvKQBaseSocketBufferReadPendingGet(ev_base, fd);
+
+			if (pending_sz <= 0)
+				break;
+
+			/* Process what arrived in the meantime */
+			drain_sz = CommEvTCPServerEventProcessBuffer(conn_hnd, pending_sz, thrd_id, NULL, 0);
+
+			if (drain_sz <= 0)
+				break;
+
+			data_read += drain_sz;
+			continue;
+		}
+
+		/* Hit drain limit, let IO loop serve other FDs and come back to this one */
+		read_pending = (drain_count >= COMM_TCP_READ_EDGE_DRAIN_MAX);
+	}
+
 	/* Reschedule read if we have not been closed and if there is a data event for this FD */
 	if ((!kq_fd->flags.closed && !kq_fd->flags.closing) && (conn_hnd->events[CONN_EVENT_READ].cb_handler_ptr))
 	{
-		/* Touch statistics */
-		if (data_read > 0)
+		/* Touch statistics, if anyone asked for them */
+		if ((data_read > 0) && (conn_hnd->statistics))
 		{
-			conn_hnd->statistics.total[COMM_CURRENT].byte_rx			+= data_read;
-			conn_hnd->statistics.total[COMM_CURRENT].packet_rx			+= 1;
+			conn_hnd->statistics->total[COMM_CURRENT].byte_rx			+= data_read;
+			conn_hnd->statistics->total[COMM_CURRENT].packet_rx			+= 1;
 		}
 
-		EvKQBaseSetEvent(ev_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventRead, conn_hnd);
+		/* Edge triggered READ_EV is already armed in kernel, this will not touch change list */
+		CommEvTCPServerEventReadSchedule(conn_hnd, read_pending);
 
 		KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - CLOSED [%d] - EV_PTR [%p] - Reschedule READ_EV\n",
 				fd, kq_fd->flags.closed, conn_hnd->events[CONN_EVENT_READ].cb_handler_ptr);
@@ -1444,6 +2613,24 @@ static int CommEvTCPServerEventRead(int fd, int can_read_sz, int thrd_id, void *
 	return data_read;
 }
 /**************************************************************************************************************************/
+static void CommEvTCPServerEventReadSchedule(CommEvTCPServerConn *conn_hnd, int read_pending)
+{
+	CommEvTCPServer *tcp_srv	= conn_hnd->parent_srv;
+	int listener_id				= conn_hnd->listener->slot_id;
+
+	/* Paused by backpressure, READ_EV is armed again on resume */
+	if (conn_hnd->backpressure.flags.read_paused)
+		return;
+
+	/* Keep a persistent EV_CLEAR READ_EV, armed once and only touched again if interest changes. PEEK never drains socket, so it can not use it */
+	if ((tcp_srv->cfg[listener_id].flags.read_edge) && (!conn_hnd->flags.peek_on_read) && (!read_pending))
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_TRANSITION, CommEvTCPServerEventRead, conn_hnd);
+	else
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventRead, conn_hnd);
+
+	return;
+}
+/**************************************************************************************************************************/
 /**/
 /**/
 /**************************************************************************************************************************/
@@ -1480,7 +2667,8 @@ static int CommEvTCPServerEventSSLWrite(int fd, int can_write_sz, int thrd_id, v
 	}
 
 	/* Touch statistics */
-	conn_hnd->statistics.total[COMM_CURRENT].packet_tx		+= 1;
+	if (conn_hnd->statistics)
+		conn_hnd->statistics->total[COMM_CURRENT].packet_tx		+= 1;
 
 	/* Clear libSSL errors and write it to SSL tunnel */
 	ERR_clear_error();
@@ -1532,11 +2720,15 @@ static int CommEvTCPServerEventSSLWrite(int fd, int can_write_sz, int thrd_id, v
 	}
 
 	cur_aio_req->data.offset								+= ssl_bytes_written;
-	/* Touch statistics */
-	conn_hnd->statistics.total[COMM_CURRENT].byte_tx		+= cur_aio_req->data.size;
-	conn_hnd->statistics.total[COMM_CURRENT].ssl_byte_tx	+= ssl_bytes_written;
 	total_ssl_bytes_written									+= ssl_bytes_written;
 
+	/* Touch statistics */
+	if (conn_hnd->statistics)
+	{
+		conn_hnd->statistics->total[COMM_CURRENT].byte_tx		+= cur_aio_req->data.size;
+		conn_hnd->statistics->total[COMM_CURRENT].ssl_byte_tx	+= ssl_bytes_written;
+	}
+
 	/* Invoke notification CALLBACKS if not CLOSE_REQUEST and then destroy AIO REQ */
 	if (!conn_hnd->flags.close_request)
 		EvAIOReqInvokeCallBacks(cur_aio_req, 1, fd, cur_aio_req->data.offset, thrd_id, conn_hnd->parent_srv);
@@ -1576,6 +2768,9 @@ static int CommEvTCPServerEventSSLRead(int fd, int can_read_sz, int thrd_id, voi
 	int listener_id					= conn_hnd->listener->slot_id;
 
 	char read_buf[COMM_TCP_SSL_READ_BUFFER_SZ];
+	unsigned long chain_space_sz;
+	char *read_ptr;
+	int read_ptr_sz;
 	int ssl_bytes_read;
 	int ssl_error;
 
@@ -1585,14 +2780,32 @@ static int CommEvTCPServerEventSSLRead(int fd, int can_read_sz, int thrd_id, voi
 
 	assert(conn_hnd->ssldata.ssl_handle);
 
+	read_ptr	= (char *)&read_buf;
+	read_ptr_sz	= sizeof(read_buf) - 1;
+
+	/* Decrypt straight into pooled chain tail, saving the copy from stack buffer */
+	if (COMM_SERVER_READ_MEMCHAIN == tcp_srv->cfg[listener_id].read_mthd)
+	{
+		if (!conn_hnd->iodata.read_chain)
+			conn_hnd->iodata.read_chain = MemChainNew();
+
+		read_ptr	= MemChainWriteReserve(conn_hnd->iodata.read_chain, &chain_space_sz);
+		read_ptr_sz	= chain_space_sz;
+	}
+
 	/* Clear libSSL errors and read from SSL tunnel */
 	ERR_clear_error();
-	ssl_bytes_read = SSL_read(conn_hnd->ssldata.ssl_handle, &read_buf, sizeof(read_buf) - 1);
+	ssl_bytes_read = SSL_read(conn_hnd->ssldata.ssl_handle, read_ptr, read_ptr_sz);
+
+	/* Commit what landed on chain, an empty reservation is released here */
+	if (COMM_SERVER_READ_MEMCHAIN == tcp_srv->cfg[listener_id].read_mthd)
+		MemChainWriteCommit(conn_hnd->iodata.read_chain, ((ssl_bytes_read > 0) ? ssl_bytes_read : 0));
 
 	//KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - SIZE [%d] - READ [%d]\n", fd, read_sz, bytes_read);
 
 	/* Account for RAW DATA bytes */
-	conn_hnd->statistics.total[COMM_CURRENT].packet_rx			+= 1;
+	if (conn_hnd->statistics)
+		conn_hnd->statistics->total[COMM_CURRENT].packet_rx		+= 1;
 
 	/* Check errors */
 	if (ssl_bytes_read <= 0)
@@ -1640,15 +2853,18 @@ static int CommEvTCPServerEventSSLRead(int fd, int can_read_sz, int thrd_id, voi
 	else
 	{
 		//KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "SUCCESS READING [%d] bytes - SZ [%d]\n", bytes_read, read_sz);
-		CommEvTCPServerEventProcessBuffer(conn_hnd, can_read_sz, thrd_id, (char *)&read_buf, ssl_bytes_read);
+		CommEvTCPServerEventProcessBuffer(conn_hnd, can_read_sz, thrd_id, ((COMM_SERVER_READ_MEMCHAIN == tcp_srv->cfg[listener_id].read_mthd) ? NULL : read_ptr), ssl_bytes_read);
 
-		/* Touch SSL-side statistics */
-		conn_hnd->statistics.total[COMM_CURRENT].ssl_byte_rx	+= ssl_bytes_read;
-		conn_hnd->statistics.total[COMM_CURRENT].byte_rx		+= ssl_bytes_read;
+		/* Touch SSL-side statistics - Upper layers may have closed us, and statistics are gone with it */
+		if (conn_hnd->statistics)
+		{
+			conn_hnd->statistics->total[COMM_CURRENT].ssl_byte_rx	+= ssl_bytes_read;
+			conn_hnd->statistics->total[COMM_CURRENT].byte_rx		+= ssl_bytes_read;
+		}
 	}
 
-	/* Reschedule READ event */
-	if ((!kq_fd->flags.closed && !kq_fd->flags.closing) && (conn_hnd->events[CONN_EVENT_READ].cb_handler_ptr))
+	/* Reschedule READ event, unless paired peer asked us to hold */
+	if ((!kq_fd->flags.closed && !kq_fd->flags.closing) && (conn_hnd->events[CONN_EVENT_READ].cb_handler_ptr) && (!conn_hnd->backpressure.flags.read_paused))
 		EvKQBaseSetEvent(ev_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventSSLRead, conn_hnd);
 
 	/* SSL read must return zero so lower layers do not get tricked by missing bytes in kernel */
@@ -1707,7 +2923,7 @@ static int CommEvTCPServerEventClose(int fd, int read_sz, int thrd_id, void *cb_
 static int CommEvTCPServerEventProcessBuffer(CommEvTCPServerConn *conn_hnd, int read_sz, int thrd_id, char *read_buf, int read_buf_sz)
 {
 	CommEvTCPServer *tcp_srv		= conn_hnd->parent_srv;
-	EvKQBase *ev_base				= tcp_srv->kq_base;
+	EvKQBase *ev_base				= conn_hnd->kq_base;
 	MemBuffer *transformed_mb		= NULL;
 	EvBaseKQFileDesc *kq_fd			= EvKQBaseFDGrabFromArena(ev_base, conn_hnd->socket_fd);
 	int listener_id					= conn_hnd->listener->slot_id;
@@ -1719,6 +2935,34 @@ static int CommEvTCPServerEventProcessBuffer(CommEvTCPServerConn *conn_hnd, int
 	switch (tcp_srv->cfg[listener_id].read_mthd)
 	{
 	/*********************************************************************/
+	case COMM_SERVER_READ_MEMCHAIN:
+	{
+		/* Create a new read_chain object, it holds no memory while empty */
+		if (!conn_hnd->iodata.read_chain)
+			conn_hnd->iodata.read_chain = MemChainNew();
+
+		/* SSL path already decrypted READ_BUF_SZ bytes into chain tail */
+		if (read_buf_sz > 0)
+		{
+			data_read_cur	= MemChainGetSize(conn_hnd->iodata.read_chain) - read_buf_sz;
+			data_read		= read_buf_sz;
+		}
+		/* Grab data from FD directly into pooled chunks, zero-copy */
+		else
+		{
+			data_read_cur	= MemChainGetSize(conn_hnd->iodata.read_chain);
+			data_read		= MemChainAppendFromFD(conn_hnd->iodata.read_chain, read_sz, conn_hnd->socket_fd, (conn_hnd->flags.peek_on_read ? MSG_PEEK : 0));
+
+			/* Failed reading FD */
+			if (data_read <= 0)
+				return -1;
+		}
+
+		/* Allow upper layers to perform data transformation over new bytes */
+		EvAIOReqTransform_ReadChain(conn_hnd->transform, conn_hnd->iodata.read_chain, data_read_cur);
+		break;
+	}
+	/*********************************************************************/
 	case COMM_SERVER_READ_MEMBUFFER:
 	{
 		/* Create a new read_buffer object */
@@ -1746,7 +2990,7 @@ static int CommEvTCPServerEventProcessBuffer(CommEvTCPServerConn *conn_hnd, int
 		if (read_buf_sz > 0)
 		{
 			/* Allow upper layers to perform data transformation */
-			transformed_mb		= EvAIOReqTransform_ReadData(&conn_hnd->transform, read_buf, read_buf_sz);
+			transformed_mb		= EvAIOReqTransform_ReadData(conn_hnd->transform, read_buf, read_buf_sz);
 
 			/* No transformed MB, append read_buf */
 			if (!transformed_mb)
@@ -1770,7 +3014,7 @@ static int CommEvTCPServerEventProcessBuffer(CommEvTCPServerConn *conn_hnd, int
 				transform_ptr 	= transform_ptr + data_read_cur;
 
 				/* Allow upper layers to perform data transformation */
-				transformed_mb	= EvAIOReqTransform_ReadData(&conn_hnd->transform, transform_ptr, data_read);
+				transformed_mb	= EvAIOReqTransform_ReadData(conn_hnd->transform, transform_ptr, data_read);
 
 				/* Correct size to add transformed MB */
 				if (transformed_mb)
@@ -1835,7 +3079,10 @@ static int CommEvTCPServerEventProcessBuffer(CommEvTCPServerConn *conn_hnd, int
 				conn_hnd->socket_fd, conn_hnd->string_ip, read_sz);
 
 		/* Jump into SELF_SYNC code - This will dispatch READ_EV to upper layers when needed */
-		CommEvTCPServerSelfSyncReadBuffer(conn_hnd, read_sz, thrd_id);
+		if (COMM_SERVER_READ_MEMCHAIN == tcp_srv->cfg[listener_id].read_mthd)
+			CommEvTCPServerSelfSyncReadChain(conn_hnd, data_read, thrd_id);
+		else
+			CommEvTCPServerSelfSyncReadBuffer(conn_hnd, read_sz, thrd_id);
 	}
 	/* Dispatch event - This upper layer event can make conn_hnd->socket_fd get disconnected, and destroy IO buffers beneath our feet */
 	else
@@ -1852,15 +3099,15 @@ static int CommEvTCPServerEventProcessBuffer(CommEvTCPServerConn *conn_hnd, int
 /**************************************************************************************************************************/
 static int CommEvTCPServerSelfSyncReadBuffer(CommEvTCPServerConn *conn_hnd, int orig_read_sz, int thrd_id)
 {
-	char *partial_ptr;
 	char *read_buffer_ptr;
 	char *request_str_ptr;
 	int request_str_sz;
 	int remaining_sz;
-	int i, j;
+	long scan_off;
+	long i;
 
 	CommEvTCPServer *tcp_srv	= conn_hnd->parent_srv;
-	EvKQBase *ev_base			= tcp_srv->kq_base;
+	EvKQBase *ev_base			= conn_hnd->kq_base;
 	int listener_id				= conn_hnd->listener->slot_id;
 	char *token_str				= conn_hnd->self_sync.token_str;
 	int max_buffer_sz			= conn_hnd->self_sync.max_buffer_sz;
@@ -1888,28 +3135,29 @@ static int CommEvTCPServerSelfSyncReadBuffer(CommEvTCPServerConn *conn_hnd, int
 		return 0;
 	}
 
-	KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - IP [%s] - REQ_SZ [%d] - TOKEN_SZ [%d] - Processing request\n",
-			conn_hnd->socket_fd, conn_hnd->string_ip, request_str_sz, token_sz);
+	/* Bytes before SCAN_OFF were already searched on a previous read with no token found, do not search them again */
+	scan_off = (conn_hnd->iodata.sync_scan_off <= request_str_sz) ? conn_hnd->iodata.sync_scan_off : 0;
+
+	KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - IP [%s] - REQ_SZ [%d] - TOKEN_SZ [%d] - SCAN_OFF [%ld] - Processing request\n",
+			conn_hnd->socket_fd, conn_hnd->string_ip, request_str_sz, token_sz, scan_off);
 
 	//EvKQBaseLogHexDump(request_str_ptr, request_str_sz, 8, 4);
 
-	/* Start searching the buffer */
-	for (j = 0, i = (request_str_sz); i >= 0; i--, j++)
-	{
-		/* Found finish of token, compare full token versus buffer */
-		if ( ((j >= token_sz) && (request_str_ptr[i] == token_str[0])) && (!memcmp(&request_str_ptr[i], token_str, token_sz)) )
-		{
-			KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - IP [%s] - Token found at [%d] - Buffer size is [%d]\n",
-					conn_hnd->socket_fd, conn_hnd->string_ip, j, request_str_sz);
+	/* Last token in buffer closes the batch, every complete frame before it goes up in a single READ_EV */
+	i = BrbMemFindLast(request_str_ptr + scan_off, (request_str_sz - scan_off), token_str, token_sz);
 
-			/* Found token */
-			token_found = 1;
-			break;
-		}
+	if (i >= 0)
+	{
+		i			+= scan_off;
+		token_found	= 1;
 
-		continue;
+		KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - IP [%s] - Token found at [%ld] - Buffer size is [%d]\n",
+				conn_hnd->socket_fd, conn_hnd->string_ip, i, request_str_sz);
 	}
 
+	/* Remember where next search starts, a token may still be completed by next read */
+	conn_hnd->iodata.sync_scan_off = token_found ? 0 : (request_str_sz - token_sz + 1);
+
 	/* Token bas been found */
 	if (token_found)
 	{
@@ -1944,6 +3192,9 @@ static int CommEvTCPServerSelfSyncReadBuffer(CommEvTCPServerConn *conn_hnd, int
 	/* Dispatch upper layer read event if token has been found or if we reached our maximum allowed buffer size */
 	if ( (token_found) || ((max_buffer_sz > 0) && (request_str_sz >= max_buffer_sz)) )
 	{
+		/* Upper layers will consume this buffer, search from start next time */
+		conn_hnd->iodata.sync_scan_off = 0;
+
 		/* Dispatch SYNCED read event to listener */
 		CommEvTCPServerConnDispatchEventByFD(conn_hnd->parent_srv, conn_hnd->socket_fd, orig_read_sz, thrd_id, CONN_EVENT_READ);
 
@@ -1960,14 +3211,79 @@ static int CommEvTCPServerSelfSyncReadBuffer(CommEvTCPServerConn *conn_hnd, int
 
 }
 /**************************************************************************************************************************/
-static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, CommEvTCPServerListener *listener, int conn_fd, int accept_queue_sz, int thrd_id)
+static int CommEvTCPServerSelfSyncReadChain(CommEvTCPServerConn *conn_hnd, int new_data_sz, int thrd_id)
+{
+	CommEvTCPServer *tcp_srv	= conn_hnd->parent_srv;
+	EvKQBase *ev_base			= conn_hnd->kq_base;
+	EvBaseKQFileDesc *kq_fd		= EvKQBaseFDGrabFromArena(ev_base, conn_hnd->socket_fd);
+	MemChain *read_chain		= conn_hnd->iodata.read_chain;
+	char *token_str				= conn_hnd->self_sync.token_str;
+	int max_buffer_sz			= conn_hnd->self_sync.max_buffer_sz;
+	int token_sz				= conn_hnd->self_sync.token_str ? strlen(conn_hnd->self_sync.token_str) : 0;
+	int frame_count				= 0;
+	unsigned long scan_off;
+	unsigned long frame_sz;
+	long token_off;
+
+	/* Flag not set, or chain is empty, bail out */
+	if ((!conn_hnd->flags.self_sync) || (!read_chain) || (token_sz <= 0))
+	{
+		KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - IP [%s] - Invalid SELF_SYNC condition!\n", conn_hnd->socket_fd, conn_hnd->string_ip);
+		return 0;
+	}
+
+	/* Bytes before this read were already scanned, only look where a token could have been completed */
+	scan_off = MemChainGetSize(read_chain) - ((new_data_sz > 0) ? new_data_sz : 0);
+	scan_off = (scan_off > (token_sz - 1)) ? (scan_off - (token_sz - 1)) : 0;
+
+	frame_sz = 0;
+
+	/* Walk every token in new bytes, batch ends right past the last one */
+	while ((token_off = MemChainFind(read_chain, scan_off, token_str, token_sz)) >= 0)
+	{
+		frame_sz = (token_off + token_sz);
+		scan_off = frame_sz;
+		frame_count++;
+	}
+
+	/* No token, but we reached our maximum allowed buffer size, flush all of it */
+	if ((0 == frame_sz) && (max_buffer_sz > 0) && (MemChainGetSize(read_chain) >= max_buffer_sz))
+		frame_sz = MemChainGetSize(read_chain);
+
+	/* Hand every complete frame to upper layers in one slice of chain memory */
+	if (frame_sz > 0)
+	{
+		/* Slice points into chunk memory when batch does not cross a chunk boundary, chain no longer holds these bytes */
+		MemChainSlicePop(read_chain, frame_sz, &conn_hnd->iodata.read_slice);
+
+		KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - IP [%s] - Dispatching READ_EV of [%lu] bytes with [%d] frames - HEAP [%d]\n",
+				conn_hnd->socket_fd, conn_hnd->string_ip, frame_sz, frame_count, conn_hnd->iodata.read_slice.flags.heap);
+
+		/* Dispatch SYNCED read event to listener - Upper layers must MemSliceDup it to keep data past this call */
+		CommEvTCPServerConnDispatchEventByFD(conn_hnd->parent_srv, conn_hnd->socket_fd, frame_sz, thrd_id, CONN_EVENT_READ);
+
+		/* Closed flag set, slice was released with IO data, just bail out */
+		if ((kq_fd->flags.closed) || (kq_fd->flags.closing) || (!conn_hnd->iodata.read_chain))
+			return frame_count;
+
+		MemSliceRelease(&conn_hnd->iodata.read_slice);
+	}
+	else
+	{
+		KQBASE_LOG_PRINTF(tcp_srv->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - IP [%s] - READ_EV not dispatched - [%lu] bytes PENDING\n",
+				conn_hnd->socket_fd, conn_hnd->string_ip, MemChainGetSize(read_chain));
+	}
+
+	return frame_count;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, EvKQBase *ev_base, CommEvTCPServerListener *listener, int conn_fd, struct sockaddr_storage *peer_addr, int accept_queue_sz, int thrd_id)
 {
 	CommEvTCPServerConn *conn_hnd;
 	int recv_unix;
 
-	EvKQBase *ev_base			= srv_ptr->kq_base;
 	int listener_id				= listener->slot_id;
-	unsigned int sockaddr_sz	= srv_ptr->cfg[listener_id].srv_type == COMM_SERVER_TYPE_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+	socklen_t sockaddr_sz		= srv_ptr->cfg[listener_id].srv_type == COMM_SERVER_TYPE_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
 
 	/* Invalid descriptor */
 	if (conn_fd < 0)
@@ -1977,20 +3293,22 @@ static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, CommEvTCPServ
 	conn_hnd	= CommEvTCPServerConnArenaGrab(srv_ptr, conn_fd);
 	recv_unix	= conn_hnd->flags.conn_recvd_from_unixsrv;
 
-	/* Clean all flags and statistics */
+	/* Clean all flags and give back any cold state left by previous user of this slot */
 	memset(&conn_hnd->flags, 0, sizeof(conn_hnd->flags));
-	memset(&conn_hnd->statistics, 0, sizeof(conn_hnd->statistics));
-	memset(&conn_hnd->transform, 0, sizeof(conn_hnd->transform));
+	CommEvTCPServerConnColdRelease(conn_hnd);
 
 	/* Populate CONN_HANDLER structure associated with this FD */
 	conn_hnd->socket_fd						= conn_fd;
 	conn_hnd->parent_srv					= srv_ptr;
 	conn_hnd->listener						= listener;
+	conn_hnd->kq_base						= ev_base;
 	conn_hnd->iodata.read_stream			= NULL;
 	conn_hnd->iodata.read_buffer			= NULL;
 	conn_hnd->iodata.partial_read_buffer	= NULL;
 	conn_hnd->iodata.partial_read_stream	= NULL;
-	conn_hnd->ssldata.sni_host_ptr			= NULL;
+	conn_hnd->iodata.read_chain				= NULL;
+	conn_hnd->iodata.sync_scan_off			= 0;
+	memset(&conn_hnd->iodata.read_slice, 0, sizeof(MemSlice));
 	conn_hnd->flags.conn_hnd_inuse			= 1;
 	conn_hnd->flags.conn_recvd_from_unixsrv	= recv_unix;
 
@@ -2000,17 +3318,37 @@ static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, CommEvTCPServ
 	conn_hnd->self_sync.max_buffer_sz		= srv_ptr->cfg[listener_id].self_sync.max_buffer_sz;
 	conn_hnd->flags.self_sync				= srv_ptr->cfg[listener_id].flags.self_sync;
 
-	/* Initialize timer IDs and JOB_IDs */
+	/* Initialize timer IDs and JOB_IDs, CONN_HND is pinned to the thread of EV_BASE from now on */
 	conn_hnd->timers.calculate_datarate_id	= -1;
 	conn_hnd->ssldata.shutdown_jobid		= -1;
-	conn_hnd->thrd_id						= -1;
+	conn_hnd->thrd_id						= KQEV_THRD_ID(ev_base);
+
+	/* Accepted from our own listener - TCP_NODELAY is inherited from it and peer address came with ACCEPT */
+	if (peer_addr)
+	{
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+		/* ACCEPT4 already did it, just sync flags */
+		EvBaseKQFileDesc *kq_fd			= EvKQBaseFDGrabFromArena(ev_base, conn_hnd->socket_fd);
+
+		kq_fd->flags.so_nonblocking		= 1;
+		kq_fd->flags.so_closeonexec		= 1;
+#else
+		EvKQBaseSocketSetNonBlock(ev_base, conn_hnd->socket_fd);
+#endif
+		memcpy(&conn_hnd->conn_addr, peer_addr, sizeof(conn_hnd->conn_addr));
+	}
+	/* Descriptor came from somewhere else, set it all up */
+	else
+	{
+		/* Make it non-blocking */
+		EvKQBaseSocketSetNonBlock(ev_base, conn_hnd->socket_fd);
+		EvKQBaseSocketSetNoDelay(ev_base, conn_hnd->socket_fd);
 
-	/* Make it non-blocking */
-	EvKQBaseSocketSetNonBlock(ev_base, conn_hnd->socket_fd);
-	EvKQBaseSocketSetNoDelay(ev_base, conn_hnd->socket_fd);
+		/* Grab remote address */
+		getpeername(conn_hnd->socket_fd, (struct sockaddr*)&conn_hnd->conn_addr, &sockaddr_sz);
+	}
 
-	/* Grab local and remote address - LOCAL Will be remote if connection is locally intercepted */
-	getpeername(conn_hnd->socket_fd, (struct sockaddr*)&conn_hnd->conn_addr, &sockaddr_sz);
+	/* Grab local address - Will be remote if connection is locally intercepted */
 	getsockname(conn_hnd->socket_fd, (struct sockaddr*)&conn_hnd->local_addr, &sockaddr_sz);
 
 	/* Generate a string representation of binary IP */
@@ -2031,7 +3369,8 @@ static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, CommEvTCPServ
 
 	/* Set all TIMEOUT stuff to UNINITIALIZED, intiialize WRITE_REQ_QUEUE and set DESCRIPTION */
 	EvKQBaseTimeoutInitAllByFD(ev_base, conn_hnd->socket_fd);
-	EvAIOReqQueueInit(srv_ptr->kq_base, &conn_hnd->iodata.write_queue, 4096, (srv_ptr->kq_base->flags.mt_engine ? AIOREQ_QUEUE_MT_SAFE : AIOREQ_QUEUE_MT_UNSAFE), AIOREQ_QUEUE_SIMPLE);
+	EvAIOReqQueueInit(conn_hnd->kq_base, &conn_hnd->iodata.write_queue, 4096, (conn_hnd->kq_base->flags.mt_engine ? AIOREQ_QUEUE_MT_SAFE : AIOREQ_QUEUE_MT_UNSAFE), AIOREQ_QUEUE_SIMPLE);
+	CommEvTCPServerConnBackpressureInit(conn_hnd);
 
 	/* Set humanized description of this socket */
 	EvKQBaseFDDescriptionSetByFD(ev_base, conn_hnd->socket_fd, "SRV FD/PORT [%d/%d] - CONN - FD/IP:PORT [%d / %s:%d]",
@@ -2042,6 +3381,17 @@ static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, CommEvTCPServ
 	/* Add client to active client LIST */
 	DLinkedListAdd(&srv_ptr->conn.list, &conn_hnd->conn_node, conn_hnd);
 
+	/* Kernel TCP_INFO telemetry, sampled in batches by a single timer */
+	if (srv_ptr->tcp_info_sampler)
+		CommEvTCPInfoSamplerAdd(srv_ptr->tcp_info_sampler, CommEvTCPServerConnStatisticsGrab(conn_hnd), conn_hnd->socket_fd, &conn_hnd->conn_addr, NULL);
+
+	/* Listener wants datarate - Grab statistics now so counters and rates baseline start at ACCEPT */
+	if (srv_ptr->cfg[listener_id].flags.calculate_datarate)
+	{
+		conn_hnd->flags.calculate_datarate = 1;
+		COMM_EV_STATS_CONN_HND_FIRE_TIMER(conn_hnd);
+	}
+
 	/* Set default READ and CLOSE events to this conn_fd, if any is defined in server */
 	CommEvTCPServerConnSetDefaultEvents(srv_ptr, conn_hnd);
 
@@ -2069,7 +3419,7 @@ static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, CommEvTCPServ
 	/* Try to auto detect what protocol the client is speaking */
 	case COMM_SERVERPROTO_AUTODETECT:
 	{
-		/* Mark SSL as enabled */
+		/* SSL is enabled only if protocol turns out to be SSL */
 		conn_hnd->flags.ssl_enabled				= 0;
 		conn_hnd->ssldata.sni_parse_trycount	= 0;
 
@@ -2104,7 +3454,7 @@ static int CommEvTCPServerAcceptPostInit(CommEvTCPServer *srv_ptr, CommEvTCPServ
 
 		/* Set read internal event for newly connected socket if we have an upper layer event defined */
 		if (conn_hnd->events[CONN_EVENT_READ].cb_handler_ptr)
-			EvKQBaseSetEvent(ev_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventRead, conn_hnd);
+			CommEvTCPServerEventReadSchedule(conn_hnd, 0);
 
 		break;
 	}
@@ -2124,13 +3474,13 @@ static int CommEvTCPServerConnRatesCalculateTimer(int fd, int data_sz, int thrd_
 	/* Calculate read rates */
 	if (conn_hnd->flags.calculate_datarate)
 	{
-		CommEvStatisticsRateCalculate(conn_hnd->parent_srv->kq_base, &conn_hnd->statistics, conn_hnd->socket_fd, COMM_RATES_READ);
-		CommEvStatisticsRateCalculate(conn_hnd->parent_srv->kq_base, &conn_hnd->statistics, conn_hnd->socket_fd, COMM_RATES_WRITE);
-		CommEvStatisticsRateCalculate(conn_hnd->parent_srv->kq_base, &conn_hnd->statistics, conn_hnd->socket_fd, COMM_RATES_USER);
+		CommEvStatisticsRateCalculate(conn_hnd->kq_base, CommEvTCPServerConnStatisticsGrab(conn_hnd), conn_hnd->socket_fd, COMM_RATES_READ);
+		CommEvStatisticsRateCalculate(conn_hnd->kq_base, conn_hnd->statistics, conn_hnd->socket_fd, COMM_RATES_WRITE);
+		CommEvStatisticsRateCalculate(conn_hnd->kq_base, conn_hnd->statistics, conn_hnd->socket_fd, COMM_RATES_USER);
 
 		/* Reschedule DATARATE CALCULATE TIMER timer */
 		conn_hnd->timers.calculate_datarate_id =
-				EvKQBaseTimerAdd(conn_hnd->parent_srv->kq_base, COMM_ACTION_ADD_VOLATILE, 1000, CommEvTCPServerConnRatesCalculateTimer, conn_hnd);
+				EvKQBaseTimerAdd(conn_hnd->kq_base, COMM_ACTION_ADD_VOLATILE, 1000, CommEvTCPServerConnRatesCalculateTimer, conn_hnd);
 	}
 	else
 		conn_hnd->timers.calculate_datarate_id = -1;
@@ -2240,18 +3590,30 @@ static int CommEvTCPServerUNIXEventBrbProtoRead(int fd, int to_read_sz, int thrd
 	tcp_conn_hnd->flags.conn_recvd_from_unixsrv = 1;
 
 	/* Invoke common POST_ACCEPT initialization procedure and set a CLOSE event handler */
-	CommEvTCPServerAcceptPostInit(tcp_server, tcp_listener, recv_fd, 0, thrd_id);
+	CommEvTCPServerAcceptPostInit(tcp_server, ev_base, tcp_listener, recv_fd, NULL, 0, thrd_id);
 	EvKQBaseSetEvent(ev_base, tcp_conn_hnd->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerEventClose, tcp_conn_hnd);
 
 	/* If there is PAYLOAD, add it inside read buffer */
 	if (payload_sz > 0)
 	{
-		/* Create a new read buffer to hold PAYLOAD data */
-		if (!tcp_conn_hnd->iodata.read_buffer)
-			tcp_conn_hnd->iodata.read_buffer = MemBufferNew((ev_base->flags.mt_engine ? BRBDATA_THREAD_SAFE : BRBDATA_THREAD_UNSAFE), (payload_sz + 1));
+		/* Listener reads into pooled chain, keep PAYLOAD there */
+		if (COMM_SERVER_READ_MEMCHAIN == tcp_server->cfg[tcp_listener_id].read_mthd)
+		{
+			if (!tcp_conn_hnd->iodata.read_chain)
+				tcp_conn_hnd->iodata.read_chain = MemChainNew();
+
+			MemChainAdd(tcp_conn_hnd->iodata.read_chain, payload_ptr, payload_sz);
+		}
+		else
+		{
+			/* Create a new read buffer to hold PAYLOAD data */
+			if (!tcp_conn_hnd->iodata.read_buffer)
+				tcp_conn_hnd->iodata.read_buffer = MemBufferNew((ev_base->flags.mt_engine ? BRBDATA_THREAD_SAFE : BRBDATA_THREAD_UNSAFE), (payload_sz + 1));
+
+			MemBufferAdd(tcp_conn_hnd->iodata.read_buffer, payload_ptr, payload_sz);
+		}
 
-		/* Add data to READ_BUF and dispatch READ_EV directly for this lower event */
-		MemBufferAdd(tcp_conn_hnd->iodata.read_buffer, payload_ptr, payload_sz);
+		/* Dispatch READ_EV directly for this lower event */
 		CommEvTCPServerConnDispatchEventByFD(tcp_server, tcp_conn_hnd->socket_fd, payload_sz, thrd_id, CONN_EVENT_READ);
 	}
 
@@ -2298,6 +3660,7 @@ static int CommEvTCPServerObjectDestroyCBH(void *kq_obj_ptr, void *cb_data)
 /**************************************************************************************************************************/
 static int CommEvTCPServerDoDestroy(CommEvTCPServer *srv_ptr)
 {
+	CommEvTCPServerCertForge *cert_forge;
 	CommEvTCPServerListener *listener;
 	CommEvTCPServerConn *conn_hnd;
 	DLinkedListNode *node;
@@ -2326,6 +3689,9 @@ static int CommEvTCPServerDoDestroy(CommEvTCPServer *srv_ptr)
 		EvKQBaseFDDescriptionClearByFD(srv_ptr->kq_base, listener->socket_fd);
 		memset(&listener->flags, 0, sizeof(listener->flags));
 
+		/* Shutdown worker sockets, if sharded */
+		CommEvTCPServerListenerThreadsShutdown(srv_ptr, listener);
+
 		/* Close the socket and cancel any pending events */
 		EvKQBaseSocketClose(srv_ptr->kq_base, listener->socket_fd);
 		listener->socket_fd = -1;
@@ -2344,8 +3710,42 @@ static int CommEvTCPServerDoDestroy(CommEvTCPServer *srv_ptr)
 	CommEvUNIXServerDestroy(srv_ptr->unix_server);
 
 	/* Destroy X.509 certificate cache table */
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_cache.mutex);
 	AssocArrayDestroy(srv_ptr->ssldata.cert_cache.table);
 	srv_ptr->ssldata.cert_cache.table = NULL;
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_cache.mutex);
+
+	/* Orphan pending FORGE JOBs, they will release themselves when finished */
+	pthread_mutex_lock(&srv_ptr->ssldata.cert_forge.mutex);
+
+	while ((cert_forge = DLinkedListPopHead(&srv_ptr->ssldata.cert_forge.list)))
+	{
+		pthread_mutex_lock(&cert_forge->mutex);
+
+		while ((conn_hnd = DLinkedListPopHead(&cert_forge->waiter_list)))
+			conn_hnd->cert_forge.forge_ptr = NULL;
+
+		cert_forge->parent_srv = NULL;
+		pthread_mutex_unlock(&cert_forge->mutex);
+		continue;
+	}
+
+	AssocArrayDestroy(srv_ptr->ssldata.cert_forge.table);
+	srv_ptr->ssldata.cert_forge.table = NULL;
+	pthread_mutex_unlock(&srv_ptr->ssldata.cert_forge.mutex);
+
+	pthread_mutex_destroy(&srv_ptr->ssldata.cert_cache.mutex);
+	pthread_mutex_destroy(&srv_ptr->ssldata.cert_forge.mutex);
+
+	/* Destroy SSL session cache and wipe ticket keys */
+	pthread_mutex_lock(&srv_ptr->ssldata.session_cache.mutex);
+	AssocArrayDestroy(srv_ptr->ssldata.session_cache.table);
+	srv_ptr->ssldata.session_cache.table = NULL;
+	pthread_mutex_unlock(&srv_ptr->ssldata.session_cache.mutex);
+	pthread_mutex_destroy(&srv_ptr->ssldata.session_cache.mutex);
+
+	OPENSSL_cleanse(&srv_ptr->ssldata.ticket.key_arr, sizeof(srv_ptr->ssldata.ticket.key_arr));
+	pthread_mutex_destroy(&srv_ptr->ssldata.ticket.mutex);
 
 	/* Destroy LISTENER SLOTs */
 	SlotQueueDestroy(&srv_ptr->listener.slot);
@@ -42,12 +42,56 @@ static EvBaseKQCBH CommEvTCPServerConnSSLShutdown;
 static CommEvUNIXGenericCBH CommEvTCPServerConnTransferFinishEvent;
 static CommEvUNIXACKCBH CommEvTCPServerConnTransferACKEvent;
 static EvBaseKQCBH CommEvTCPServerConnTransferGCTimer;
+static EvBaseKQCBH CommEvTCPServerConnTransferGCArmJob;
+static EvBaseKQCBH CommEvTCPServerConnTransferGCShutdownJob;
+static void CommEvTCPServerConnTransferRelease(CommEvTCPServerConn *conn_hnd);
+
+static EvAIOReqQueueWatermarkCBH CommEvTCPServerConnWriteQueueWatermarkCB;
+static CommEvBackpressureReadCtlCBH CommEvTCPServerConnBackpressureReadCtl;
+static EvBaseKQJobCBH CommEvTCPServerConnBackpressureJob;
+
+static void *CommEvTCPServerConnColdAlloc(int cold_type);
+static void CommEvTCPServerConnColdFree(void *cold_ptr, int cold_type);
+
+static const unsigned long conn_cold_size[COMM_TCP_SERVER_CONN_COLD_LASTITEM] =
+{
+	sizeof(CommEvContentTransformerInfo),
+	sizeof(CommEvStatistics),
+	sizeof(CommEvTCPServerConnTransfer),
+};
+
+/* Per-thread cache of free cold blocks, one list per cold type */
+static MemFreeCache conn_cold_cache = MEMFREECACHE_INITIALIZER(COMM_TCP_SERVER_CONN_COLD_LASTITEM, COMM_TCP_SERVER_CONN_COLD_CACHE_MAX);
 
 /**************************************************************************************************************************/
 int CommEvTCPServerConnTransferViaUnixClientPool(CommEvTCPServerConn *conn_hnd, CommEvUNIXClientPool *unix_client_pool)
 {
+	MemBuffer *payload_mb;
+	unsigned long chain_off;
+	unsigned long chain_sz;
+	unsigned long seg_sz;
+	char *seg_ptr;
 	int write_slot_id;
 
+	chain_sz = MemChainGetSize(conn_hnd->iodata.read_chain);
+
+	/* Pending data lives on pooled chain, flatten it into a temporary payload */
+	if (chain_sz > 0)
+	{
+		payload_mb = MemBufferNew(BRBDATA_THREAD_UNSAFE, (chain_sz + 1));
+
+		for (chain_off = 0; chain_off < chain_sz; chain_off += seg_sz)
+		{
+			seg_ptr = MemChainOffsetDeref(conn_hnd->iodata.read_chain, chain_off, &seg_sz);
+			MemBufferAdd(payload_mb, seg_ptr, seg_sz);
+		}
+
+		write_slot_id = CommEvTCPServerConnTransferViaUnixClientPoolWithMB(conn_hnd, unix_client_pool, payload_mb);
+		MemBufferDestroy(payload_mb);
+
+		return write_slot_id;
+	}
+
 	/* Write and return */
 	write_slot_id = CommEvTCPServerConnTransferViaUnixClientPoolWithMB(conn_hnd, unix_client_pool, conn_hnd->iodata.read_buffer);
 	return write_slot_id;
@@ -59,7 +103,7 @@ int CommEvTCPServerConnTransferViaUnixClientPoolWithMB(CommEvTCPServerConn *conn
 	int write_slot_id;
 
 	CommEvTCPServer *tcp_srv	= conn_hnd->parent_srv;
-	EvKQBase *ev_base			= tcp_srv->kq_base;
+	EvKQBase *ev_base			= conn_hnd->kq_base;
 	EvBaseKQFileDesc *kq_fd		= EvKQBaseFDGrabFromArena(ev_base, conn_hnd->socket_fd);
 	int listener_id				= conn_hnd->listener->slot_id;
 	int transfer_ms				= tcp_srv->cfg[listener_id].timeout.transfer_ms;
@@ -115,22 +159,31 @@ int CommEvTCPServerConnTransferViaUnixClientPoolWithMB(CommEvTCPServerConn *conn
 	CommEvTCPServerConnTimersCancelAll(conn_hnd);
 	CommEvTCPServerConnCancelEvents(conn_hnd);
 
+	/* Transfer state is only needed while in flight, grab it now */
+	if (!conn_hnd->transfer)
+		conn_hnd->transfer = CommEvTCPServerConnColdAlloc(COMM_TCP_SERVER_CONN_COLD_TRANSFER);
+
 	/* Add to transfer LIST, save TV, IO_N and set flags we are TRANSFERING this CONN_HND to another PROCESS */
-	DLinkedListAdd(&tcp_srv->transfer.list, &conn_hnd->transfer.node, conn_hnd);
-	memcpy(&conn_hnd->transfer.tv, &ev_base->stats.cur_invoke_tv, sizeof(struct timeval));
-	conn_hnd->transfer.io_loop				= ev_base->stats.kq_invoke_count;
+	DLinkedListAdd(&tcp_srv->transfer.list, &conn_hnd->transfer->node, conn_hnd);
+	memcpy(&conn_hnd->transfer->tv, &ev_base->stats.cur_invoke_tv, sizeof(struct timeval));
+	conn_hnd->transfer->io_loop				= ev_base->stats.kq_invoke_count;
 	conn_hnd->flags.conn_hnd_in_transfer	= 1;
 
-	/* Fire up the garbage collector TIMER, if there is none */
+	/* Fire up the garbage collector TIMER, if there is none. It lives on server KQ_BASE, so workers ask THRD_ID zero to arm it */
 	if ((transfer_ms > 0) && (tcp_srv->transfer.gc_timerid < 0))
-		tcp_srv->transfer.gc_timerid = EvKQBaseTimerAdd(ev_base, COMM_ACTION_ADD_VOLATILE, 1000, CommEvTCPServerConnTransferGCTimer, tcp_srv);
+	{
+		if (ev_base == tcp_srv->kq_base)
+			CommEvTCPServerConnTransferGCArmJob(-1, 0, KQEV_THRD_ID(ev_base), tcp_srv, ev_base);
+		else
+			EvKQBaseThreadJobSend(ev_base, KQEV_THRD_ID(tcp_srv->kq_base), CommEvTCPServerConnTransferGCArmJob, tcp_srv);
+	}
 
 	return write_slot_id;
 }
 /**************************************************************************************************************************/
 void CommEvTCPServerConnCloseRequest(CommEvTCPServerConn *conn_hnd)
 {
-	EvKQBase *ev_base							= conn_hnd->parent_srv->kq_base;
+	EvKQBase *ev_base							= conn_hnd->kq_base;
 	EvBaseKQFileDesc *kq_fd						= EvKQBaseFDGrabFromArena(ev_base, conn_hnd->socket_fd);
 	EvBaseKQGenericEventPrototype *write_proto	= kq_fd ? &kq_fd->cb_handler[KQ_CB_HANDLER_WRITE] : NULL;
 
@@ -198,10 +251,14 @@ int CommEvTCPServerConnTimersCancelAll(CommEvTCPServerConn *conn_hnd)
 {
 	/* DELETE all pending timers */
 	if (conn_hnd->timers.calculate_datarate_id > -1)
-		EvKQBaseTimerCtl(conn_hnd->parent_srv->kq_base, conn_hnd->timers.calculate_datarate_id, COMM_ACTION_DELETE);
+		EvKQBaseTimerCtl(conn_hnd->kq_base, conn_hnd->timers.calculate_datarate_id, COMM_ACTION_DELETE);
 
 	conn_hnd->timers.calculate_datarate_id		= -1;
 
+	/* Leave TCP_INFO sampler before socket is closed */
+	if (conn_hnd->statistics)
+		CommEvTCPInfoSamplerDel(conn_hnd->statistics);
+
 	return 1;
 }
 /**************************************************************************************************************************/
@@ -473,8 +530,6 @@ int CommEvTCPServerConnAIOWrite(CommEvTCPServerConn *conn_hnd, char *data, unsig
 /**************************************************************************************************************************/
 int CommEvTCPServerConnSSLShutdownBegin(CommEvTCPServerConn *conn_hnd)
 {
-	CommEvTCPServer *parent_srv = conn_hnd->parent_srv;
-
 	/* Already shutting down, bail out */
 	if (conn_hnd->flags.ssl_shuting_down)
 		return 0;
@@ -483,7 +538,7 @@ int CommEvTCPServerConnSSLShutdownBegin(CommEvTCPServerConn *conn_hnd)
 	conn_hnd->flags.ssl_shuting_down = 1;
 
 	/* Schedule SSL shutdown JOB for NEXT IO LOOP */
-	conn_hnd->ssldata.shutdown_jobid = EvKQJobsAdd(parent_srv->kq_base, JOB_ACTION_ADD_VOLATILE, 0, CommEvTCPServerConnSSLShutdownJob, conn_hnd);
+	conn_hnd->ssldata.shutdown_jobid = EvKQJobsAdd(conn_hnd->kq_base, JOB_ACTION_ADD_VOLATILE, 0, CommEvTCPServerConnSSLShutdownJob, conn_hnd);
 
 	return 1;
 }
@@ -502,9 +557,20 @@ int CommEvTCPServerConnInternalShutdown(CommEvTCPServerConn *conn_hnd)
 		return 0;
 
 	/* Cancel any pending SSL SHUTDOWN JOB */
-	EvKQJobsCtl(srv_ptr->kq_base, JOB_ACTION_DELETE, conn_hnd->ssldata.shutdown_jobid);
+	EvKQJobsCtl(conn_hnd->kq_base, JOB_ACTION_DELETE, conn_hnd->ssldata.shutdown_jobid);
 	conn_hnd->ssldata.shutdown_jobid = -1;
 
+	/* Cancel any pending WRITE_DRAIN or SHED job */
+	if (conn_hnd->backpressure_jobid > -1)
+	{
+		EvKQJobsCtl(conn_hnd->kq_base, JOB_ACTION_DELETE, conn_hnd->backpressure_jobid);
+		conn_hnd->backpressure_jobid = -1;
+	}
+
+	/* Leave backpressure pairing, peer we paused reads again. We are going down, so do not resume ourselves */
+	conn_hnd->backpressure.flags.read_paused = 0;
+	CommEvBackpressureUnlink(&conn_hnd->backpressure);
+
 	/* Delete client from ACTIVE list */
 	DLinkedListDelete(&srv_ptr->conn.list, &conn_hnd->conn_node);
 
@@ -515,13 +581,13 @@ int CommEvTCPServerConnInternalShutdown(CommEvTCPServerConn *conn_hnd)
 	CommEvTCPServerConnSSLSessionDestroy(conn_hnd);
 
 	/* Close socket and set to -1 */
-	EvKQBaseSocketClose(srv_ptr->kq_base, conn_hnd->socket_fd);
+	EvKQBaseSocketClose(conn_hnd->kq_base, conn_hnd->socket_fd);
 	conn_hnd->socket_fd = -1;
 
-	/*  Reset shutdown retry count and flags */
-	conn_hnd->ssldata.ssl_shutdown_trycount = 0;
+	/*  Reset flags and give cold state back, an idle slot keeps just its hot header */
 	conn_hnd->flags.ssl_shuting_down 		= 0;
 	conn_hnd->flags.conn_hnd_inuse			= 0;
+	CommEvTCPServerConnColdRelease(conn_hnd);
 
 	/* Release CONN_HND from ARENA */
 	MemArenaReleaseByID(srv_ptr->conn.arena, socket_fd);
@@ -555,7 +621,7 @@ void CommEvTCPServerConnEventCancel(CommEvTCPServerConn *conn_hnd, CommEvTCPServ
 
 	/* Update underlying event */
 	if (CONN_EVENT_READ == ev_type)
-		EvKQBaseSetEvent(conn_hnd->parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_DELETE, NULL, NULL);
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_DELETE, NULL, NULL);
 
 	return;
 }
@@ -632,7 +698,7 @@ void CommEvTCPServerConnDispatchEvent(CommEvTCPServerConn *conn_hnd, int data_sz
 
 	/* Grab callback_ptr */
 	cb_handler = conn_hnd->events[ev_type].cb_handler_ptr;
-	memcpy(&conn_hnd->events[ev_type].last_tv, &conn_hnd->parent_srv->kq_base->stats.cur_invoke_tv, sizeof(struct timeval));
+	memcpy(&conn_hnd->events[ev_type].last_tv, &conn_hnd->kq_base->stats.cur_invoke_tv, sizeof(struct timeval));
 
 	/* There is a handler for this event. Invoke the damn thing */
 	if (cb_handler)
@@ -673,9 +739,10 @@ void CommEvTCPServerConnArenaNew(CommEvTCPServer *srv_ptr)
 
 	BRB_ASSERT (ev_base, (!srv_ptr->conn.arena), "Trying to REINIT CONN_HND arena!\n");
 
-	/* Initialize CONN_HND arena and list */
-	srv_ptr->conn.arena = MemArenaNew(1024, (sizeof(CommEvTCPServerConn) + 1), 128, BRBDATA_THREAD_UNSAFE);
-	DLinkedListInit(&srv_ptr->conn.list, BRBDATA_THREAD_UNSAFE);
+	/* Initialize CONN_HND arena and list, shared by all threads when running multi-threaded. FD is the ID, so IO threads
+	 * touch disjoint slots and the arena can run lock free */
+	srv_ptr->conn.arena = MemArenaNew(1024, (sizeof(CommEvTCPServerConn) + 1), 128, (ev_base->flags.mt_engine ? MEMARENA_MT_CONCURRENT : BRBDATA_THREAD_UNSAFE));
+	DLinkedListInit(&srv_ptr->conn.list, (ev_base->flags.mt_engine ? BRBDATA_THREAD_SAFE : BRBDATA_THREAD_UNSAFE));
 	return;
 }
 /**************************************************************************************************************************/
@@ -701,6 +768,7 @@ void CommEvTCPServerConnSSLSessionInit(CommEvTCPServerConn *ret_conn)
 	CommEvTCPServer *srv_ptr			= ret_conn->parent_srv;
 	CommEvTCPServerListener *listener	= ret_conn->listener;
 	int listener_id						= listener->slot_id;
+	SSL_CTX *shared_context;
 	int sign_status;
 
 	if (!ret_conn)
@@ -713,8 +781,17 @@ void CommEvTCPServerConnSSLSessionInit(CommEvTCPServerConn *ret_conn)
 	/* Mark INIT */
 	ret_conn->flags.ssl_init 					= 1;
 
+	/* Upper layers generated a custom certificate for this connection, and it is cached with a ready context - Just SSL_new */
+	if ((ret_conn->ssldata.x509_cert) && (shared_context = CommEvTCPServerSSLCertCacheContextGet(srv_ptr, CommEvTCPServerConnSSLDataGetSNIStr(ret_conn), ret_conn->ssldata.x509_cert)))
+	{
+		ret_conn->ssldata.ssl_handle	= SSL_new(shared_context);
+		ret_conn->flags.ssl_cert_custom = 1;
+
+		/* SSL_new took its own reference, drop the one cache gave us */
+		SSL_CTX_free(shared_context);
+	}
 	/* Upper layers generated a custom certificate for this connection, use it */
-	if (ret_conn->ssldata.x509_cert)
+	else if (ret_conn->ssldata.x509_cert)
 	{
 		ret_conn->ssldata.ssl_context	= SSL_CTX_new(SSLv23_server_method());
 
@@ -741,6 +818,9 @@ void CommEvTCPServerConnSSLSessionInit(CommEvTCPServerConn *ret_conn)
 		/* Set private key to be used with this fake certificate */
 		SSL_CTX_use_PrivateKey(ret_conn->ssldata.ssl_context, srv_ptr->ssldata.main_key);
 
+		/* Plug server wide session cache and ticket keys */
+		CommEvTCPServerSSLSessionContextInit(srv_ptr, ret_conn->ssldata.ssl_context, CommEvTCPServerConnSSLDataGetSNIStr(ret_conn));
+
 		/* Create context and set flags */
 		ret_conn->ssldata.ssl_handle	= SSL_new(ret_conn->ssldata.ssl_context);
 		ret_conn->flags.ssl_cert_custom = 1;
@@ -756,9 +836,12 @@ void CommEvTCPServerConnSSLSessionInit(CommEvTCPServerConn *ret_conn)
 
 	ret_conn->ssldata.ssl_negotiatie_trycount	= 0;
 
-	/* Bind FD to SSL context */
+	/* Bind FD to SSL context - Session and ticket callbacks find their server through APP_DATA */
 	if (ret_conn->ssldata.ssl_handle)
+	{
 		SSL_set_fd(ret_conn->ssldata.ssl_handle, ret_conn->socket_fd);
+		SSL_set_app_data(ret_conn->ssldata.ssl_handle, ret_conn);
+	}
 
 	return;
 
@@ -774,6 +857,20 @@ void CommEvTCPServerConnSSLSessionDestroy(CommEvTCPServerConn *ret_conn)
 
 	srv_ptr = ret_conn->parent_srv;
 
+	/* Mark NOT INIT */
+	ret_conn->flags.ssl_init = 0;
+
+	/* Still waiting for a forged certificate, leave waiter list */
+	if (ret_conn->cert_forge.forge_ptr)
+	{
+		/* FORGE FINISH walks this list from another thread, so leave it under FORGE lock */
+		pthread_mutex_lock(&ret_conn->cert_forge.forge_ptr->mutex);
+		DLinkedListDelete(&ret_conn->cert_forge.forge_ptr->waiter_list, &ret_conn->cert_forge.node);
+		pthread_mutex_unlock(&ret_conn->cert_forge.forge_ptr->mutex);
+
+		ret_conn->cert_forge.forge_ptr = NULL;
+	}
+
 	/* Clean up X509 certificate data */
 	if (ret_conn->ssldata.x509_cert)
 	{
@@ -802,9 +899,6 @@ void CommEvTCPServerConnSSLSessionDestroy(CommEvTCPServerConn *ret_conn)
 		ret_conn->ssldata.sni_host_ptr = NULL;
 	}
 
-	/* Mark NOT INIT */
-	ret_conn->flags.ssl_init = 0;
-
 	return;
 }
 /**************************************************************************************************************************/
@@ -820,6 +914,89 @@ char *CommEvTCPServerConnSSLDataGetSNIStr(CommEvTCPServerConn *conn_hnd)
 /**/
 /**/
 /**************************************************************************************************************************/
+/* Cold state functions - Kept out of ARENA slot, so idle CONN_HND costs just its hot header
+/**************************************************************************************************************************/
+CommEvStatistics *CommEvTCPServerConnStatisticsGrab(CommEvTCPServerConn *conn_hnd)
+{
+	/* Already there */
+	if (conn_hnd->statistics)
+		return conn_hnd->statistics;
+
+	/* Counters are accounted from now on */
+	conn_hnd->statistics = CommEvTCPServerConnColdAlloc(COMM_TCP_SERVER_CONN_COLD_STATISTICS);
+	return conn_hnd->statistics;
+}
+/**************************************************************************************************************************/
+CommEvContentTransformerInfo *CommEvTCPServerConnTransformGrab(CommEvTCPServerConn *conn_hnd)
+{
+	/* Already there */
+	if (conn_hnd->transform)
+		return conn_hnd->transform;
+
+	conn_hnd->transform = CommEvTCPServerConnColdAlloc(COMM_TCP_SERVER_CONN_COLD_TRANSFORM);
+	return conn_hnd->transform;
+}
+/**************************************************************************************************************************/
+void CommEvTCPServerConnColdRelease(CommEvTCPServerConn *conn_hnd)
+{
+	/* Still linked into TRANSFER list */
+	if (conn_hnd->transfer)
+		CommEvTCPServerConnTransferRelease(conn_hnd);
+
+	/* Make sure sampler no longer references it */
+	if (conn_hnd->statistics)
+		CommEvTCPInfoSamplerDel(conn_hnd->statistics);
+
+	CommEvTCPServerConnColdFree(conn_hnd->transform, COMM_TCP_SERVER_CONN_COLD_TRANSFORM);
+	CommEvTCPServerConnColdFree(conn_hnd->statistics, COMM_TCP_SERVER_CONN_COLD_STATISTICS);
+
+	conn_hnd->transform		= NULL;
+	conn_hnd->statistics	= NULL;
+
+	return;
+}
+/**************************************************************************************************************************/
+/* Write queue backpressure
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+void CommEvTCPServerConnBackpressureInit(CommEvTCPServerConn *conn_hnd)
+{
+	CommEvTCPServer *srv_ptr	= conn_hnd->parent_srv;
+	int listener_id				= conn_hnd->listener->slot_id;
+
+	/* Slot may carry state from previous user, start unpaired */
+	CommEvBackpressureInit(&conn_hnd->backpressure, conn_hnd, CommEvTCPServerConnBackpressureReadCtl);
+	conn_hnd->backpressure_jobid = -1;
+
+	/* Load listener watermarks and bind write queue to aggregate account, if any */
+	CommEvTCPServerConnWatermarkSet(conn_hnd, srv_ptr->cfg[listener_id].cli_queue_high_sz, srv_ptr->cfg[listener_id].cli_queue_low_sz);
+	EvAIOReqQueueAccountLink(&conn_hnd->iodata.write_queue, srv_ptr->cfg[listener_id].write_account);
+
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvTCPServerConnWatermarkSet(CommEvTCPServerConn *conn_hnd, unsigned long high_sz, unsigned long low_sz)
+{
+	/* Callback is always installed, as SHED may come from account even without watermarks */
+	EvAIOReqQueueWatermarkSet(&conn_hnd->iodata.write_queue, high_sz, low_sz, CommEvTCPServerConnWriteQueueWatermarkCB, conn_hnd);
+	return;
+}
+/**************************************************************************************************************************/
+int CommEvTCPServerConnReadPause(CommEvTCPServerConn *conn_hnd)
+{
+	return CommEvBackpressureReadPause(&conn_hnd->backpressure);
+}
+/**************************************************************************************************************************/
+int CommEvTCPServerConnReadResume(CommEvTCPServerConn *conn_hnd)
+{
+	return CommEvBackpressureReadResume(&conn_hnd->backpressure);
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
 int CommEvTCPServerConnIODataLock(CommEvTCPServerConn *conn_hnd)
 {
 	/* Sanity check */
@@ -876,29 +1053,28 @@ int CommEvTCPServerConnIODataDestroy(CommEvTCPServerConn *conn_hnd)
 static int CommEvTCPServerConnSSLShutdownJob(void *job, void *cbdata_ptr)
 {
 	CommEvTCPServerConn *conn_hnd	= cbdata_ptr;
-	CommEvTCPServer *parent_srv		= conn_hnd->parent_srv;
 
 	/* Reset JOB_ID */
 	conn_hnd->ssldata.shutdown_jobid = -1;
 
 	/* Clean any pending TIMEOUT */
-	EvKQBaseTimeoutClearAll(parent_srv->kq_base, conn_hnd->socket_fd);
+	EvKQBaseTimeoutClearAll(conn_hnd->kq_base, conn_hnd->socket_fd);
 
 	/* Now remove any READ/WRITE events, then remove DEFER and only then restore READ/WRITE events. This will avoid wandering events from being dispatched to SSL_SHUTDOWN */
-	EvKQBaseSetEvent(parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_DELETE, NULL, NULL);
-	EvKQBaseSetEvent(parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_WRITE, COMM_ACTION_DELETE, NULL, NULL);
+	EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_DELETE, NULL, NULL);
+	EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_WRITE, COMM_ACTION_DELETE, NULL, NULL);
 
 	/* Cancel LOWER LEVEL DEFER_READ and DEFER_WRITE events */
-	EvKQBaseSetEvent(parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_DEFER_CHECK_READ, COMM_ACTION_DELETE, NULL, NULL);
-	EvKQBaseSetEvent(parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_DEFER_CHECK_WRITE, COMM_ACTION_DELETE, NULL, NULL);
+	EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_DEFER_CHECK_READ, COMM_ACTION_DELETE, NULL, NULL);
+	EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_DEFER_CHECK_WRITE, COMM_ACTION_DELETE, NULL, NULL);
 
 	/* Redirect READ/WRITE events to SSL_SHUTDOWN */
-	EvKQBaseSetEvent(parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
-	EvKQBaseSetEvent(parent_srv->kq_base, conn_hnd->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
+	EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
+	EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_EOF, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
 
 	/* Fire up SSL_shutdown sequence */
 	conn_hnd->ssldata.ssl_shutdown_trycount = 0;
-	CommEvTCPServerConnSSLShutdown(conn_hnd->socket_fd, 0, -1, conn_hnd, parent_srv->kq_base);
+	CommEvTCPServerConnSSLShutdown(conn_hnd->socket_fd, 0, conn_hnd->thrd_id, conn_hnd, conn_hnd->kq_base);
 
 	return 1;
 }
@@ -929,7 +1105,7 @@ static void CommEvTCPServerConnEnqueueAndKickQueue(CommEvTCPServerConn *conn_hnd
 	}
 
 	/* Allow upper layers to transform data */
-	EvAIOReqTransform_WriteData(&conn_hnd->transform, write_queue, aio_req);
+	EvAIOReqTransform_WriteData(conn_hnd->transform, write_queue, aio_req);
 
 	/* Enqueue it in conn_queue */
 	EvAIOReqQueueEnqueue(write_queue, aio_req);
@@ -958,10 +1134,16 @@ static void CommEvTCPServerConnIODoDataDestroy(CommEvTCPServerConn *conn_hnd)
 	if (conn_hnd->iodata.partial_read_buffer)
 		MemBufferDestroy(conn_hnd->iodata.partial_read_buffer);
 
+	/* Give pooled chunks back, slices duplicated by upper layers keep theirs alive */
+	MemSliceRelease(&conn_hnd->iodata.read_slice);
+	MemChainDestroy(conn_hnd->iodata.read_chain);
+
+	conn_hnd->iodata.read_chain				= NULL;
 	conn_hnd->iodata.read_stream			= NULL;
 	conn_hnd->iodata.read_buffer			= NULL;
 	conn_hnd->iodata.partial_read_buffer	= NULL;
 	conn_hnd->iodata.partial_read_stream	= NULL;
+	conn_hnd->iodata.sync_scan_off			= 0;
 
 	return;
 }
@@ -1037,19 +1219,19 @@ static int CommEvTCPServerConnSSLShutdown(int fd, int can_data_sz, int thrd_id,
 	{
 		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - SSL_ERROR_WANT_READ\n", conn_hnd->socket_fd);
 
-		EvKQBaseSetEvent(srv_ptr->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
 		return 0;
 	}
 	case SSL_ERROR_WANT_WRITE:
 	{
 		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - SSL_ERROR_WANT_WRITE\n", conn_hnd->socket_fd);
-		EvKQBaseSetEvent(srv_ptr->kq_base, conn_hnd->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
 		return 0;
 	}
 	case SSL_ERROR_ZERO_RETURN:
 	{
 		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "FD [%d] - SSL_ERROR_ZERO_RETURN\n", conn_hnd->socket_fd);
-		EvKQBaseSetEvent(srv_ptr->kq_base, conn_hnd->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_WRITE, COMM_ACTION_ADD_VOLATILE, CommEvTCPServerConnSSLShutdown, conn_hnd);
 		return 0;
 	}
 
@@ -1098,10 +1280,7 @@ static int CommEvTCPServerConnTransferFinishEvent(int fd, int write_sz, int thre
 		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - UNIX_TRANSFER failed on WRITE_SLOT [%d]\n", conn_hnd->socket_fd, write_req->req_id);
 
 		/* Clean up from TRANSFER data */
-		DLinkedListDelete(&srv_ptr->transfer.list, &conn_hnd->transfer.node);
-		memset(&conn_hnd->transfer.tv, 0, sizeof(struct timeval));
-		conn_hnd->transfer.io_loop				= -1;
-		conn_hnd->flags.conn_hnd_in_transfer	= 0;
+		CommEvTCPServerConnTransferRelease(conn_hnd);
 
 		/* Invoke internal shutdown to clean up CONN_HND */
 		CommEvTCPServerConnInternalShutdown(conn_hnd);
@@ -1133,10 +1312,7 @@ static int CommEvTCPServerConnTransferACKEvent(int ack_code, void *pend_req_ptr,
 	BRB_ASSERT_FMT(srv_ptr->kq_base, (conn_hnd->flags.conn_hnd_in_transfer), "Received ACK for CONN_HND [%d] - Not in transfer\n", conn_hnd->socket_fd);
 
 	/* Clean up from TRANSFER data */
-	DLinkedListDelete(&srv_ptr->transfer.list, &conn_hnd->transfer.node);
-	memset(&conn_hnd->transfer.tv, 0, sizeof(struct timeval));
-	conn_hnd->transfer.io_loop				= -1;
-	conn_hnd->flags.conn_hnd_in_transfer	= 0;
+	CommEvTCPServerConnTransferRelease(conn_hnd);
 
 	/* Invoke internal shutdown to clean up CONN_HND */
 	CommEvTCPServerConnInternalShutdown(conn_hnd);
@@ -1146,12 +1322,12 @@ static int CommEvTCPServerConnTransferACKEvent(int ack_code, void *pend_req_ptr,
 static int CommEvTCPServerConnTransferGCTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
 {
 	CommEvTCPServerConn *conn_hnd;
+	DLinkedListNode *node;
 	int listener_id;
 	int timeout_ms;
 
 	CommEvTCPServer *srv_ptr			= cb_data;
 	EvKQBase *ev_base					= srv_ptr->kq_base;
-	DLinkedListNode *node				= srv_ptr->transfer.list.head;
 	int timeout_count					= 0;
 	int delta_ms						= 0;
 
@@ -1162,48 +1338,212 @@ static int CommEvTCPServerConnTransferGCTimer(int timer_id, int unused, int thrd
 	if (DLINKED_LIST_ISEMPTY(srv_ptr->transfer.list))
 		return 0;
 
+	/* Workers add and remove from this list, hold it while we walk */
+	if (srv_ptr->transfer.list.flags.thread_safe)
+		MUTEX_LOCK(srv_ptr->transfer.list.mutex, "TRANSFER_LIST");
+
 	/* Walk list of PENDING TRANSFER of CONN_HND */
-	while (1)
+	for (node = srv_ptr->transfer.list.head; node; node = node->next)
 	{
-		/* No node, stop */
-		if (!node)
-			break;
-
-		/* Grab CONN_HND and point to next node */
-		conn_hnd		= node->data;
-		node			= node->next;
-
-		BRB_ASSERT(ev_base, (conn_hnd->flags.conn_hnd_in_transfer), "CONN_HND not in transfer being processed in TRANSFER_GC\n");
-
 		/* Grab CONN_HND specific DATA */
+		conn_hnd		= node->data;
 		listener_id		= conn_hnd->listener->slot_id;
 		timeout_ms		= srv_ptr->cfg[listener_id].timeout.transfer_ms;
-		delta_ms		= EvKQBaseTimeValSubMsec(&conn_hnd->transfer.tv, &ev_base->stats.cur_invoke_tv);
+		delta_ms		= EvKQBaseTimeValSubMsec(&conn_hnd->transfer->tv, &ev_base->stats.cur_invoke_tv);
 
-		/* Entry TIMEDOUT */
-		if (delta_ms >= timeout_ms)
-		{
-			KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - UNIX_TRANSFER timed out with delta [%d / %d]\n",
-					conn_hnd->socket_fd, delta_ms, timeout_ms);
-
-			/* Clean up from TRANSFER data */
-			DLinkedListDelete(&srv_ptr->transfer.list, &conn_hnd->transfer.node);
-			memset(&conn_hnd->transfer.tv, 0, sizeof(struct timeval));
-			conn_hnd->transfer.io_loop				= -1;
-			conn_hnd->flags.conn_hnd_in_transfer	= 0;
-
-			/* Invoke internal shutdown to clean up CONN_HND */
-			CommEvTCPServerConnInternalShutdown(conn_hnd);
-			timeout_count++;
+		/* Not TIMEDOUT yet */
+		if (delta_ms < timeout_ms)
 			continue;
-		}
 
-		continue;
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - UNIX_TRANSFER timed out with delta [%d / %d]\n",
+				conn_hnd->socket_fd, delta_ms, timeout_ms);
+
+		/* CONN_HND belongs to the thread that accepted it, so ask that thread to shut it down */
+		EvKQBaseThreadJobSend(ev_base, conn_hnd->thrd_id, CommEvTCPServerConnTransferGCShutdownJob, conn_hnd);
+		timeout_count++;
 	}
 
+	if (srv_ptr->transfer.list.flags.thread_safe)
+		MUTEX_UNLOCK(srv_ptr->transfer.list.mutex, "TRANSFER_LIST");
+
 	/* Reschedule timer ID */
 	srv_ptr->transfer.gc_timerid = EvKQBaseTimerAdd(ev_base, COMM_ACTION_ADD_VOLATILE, 1000, CommEvTCPServerConnTransferGCTimer, srv_ptr);
 	return 1;
 }
 /**************************************************************************************************************************/
+static int CommEvTCPServerConnTransferGCArmJob(int unused_fd, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvTCPServer *srv_ptr = cb_data;
+
+	/* Someone else armed it already */
+	if (srv_ptr->transfer.gc_timerid >= 0)
+		return 0;
+
+	srv_ptr->transfer.gc_timerid = EvKQBaseTimerAdd(srv_ptr->kq_base, COMM_ACTION_ADD_VOLATILE, 1000, CommEvTCPServerConnTransferGCTimer, srv_ptr);
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPServerConnTransferGCShutdownJob(int unused_fd, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvTCPServerConn *conn_hnd	= cb_data;
+	EvKQBase *ev_base				= base_ptr;
+	CommEvTCPServer *srv_ptr		= conn_hnd->parent_srv;
+	int listener_id;
+	int delta_ms;
+
+	/* ACK arrived while this job was in flight, nothing to do */
+	if ((!conn_hnd->flags.conn_hnd_in_transfer) || (!conn_hnd->transfer))
+		return 0;
+
+	/* Slot got reused by a newer transfer, check its own timeout again */
+	listener_id	= conn_hnd->listener->slot_id;
+	delta_ms	= EvKQBaseTimeValSubMsec(&conn_hnd->transfer->tv, &ev_base->stats.cur_invoke_tv);
+
+	if (delta_ms < srv_ptr->cfg[listener_id].timeout.transfer_ms)
+		return 0;
+
+	/* Clean up from TRANSFER data */
+	CommEvTCPServerConnTransferRelease(conn_hnd);
+
+	/* Invoke internal shutdown to clean up CONN_HND */
+	CommEvTCPServerConnInternalShutdown(conn_hnd);
+	return 1;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPServerConnTransferRelease(CommEvTCPServerConn *conn_hnd)
+{
+	CommEvTCPServer *srv_ptr = conn_hnd->parent_srv;
+
+	conn_hnd->flags.conn_hnd_in_transfer = 0;
+
+	/* Sanity check */
+	if (!conn_hnd->transfer)
+		return;
+
+	/* Leave TRANSFER list and give state back */
+	DLinkedListDelete(&srv_ptr->transfer.list, &conn_hnd->transfer->node);
+	CommEvTCPServerConnColdFree(conn_hnd->transfer, COMM_TCP_SERVER_CONN_COLD_TRANSFER);
+	conn_hnd->transfer = NULL;
+
+	return;
+}
+/**************************************************************************************************************************/
+static void *CommEvTCPServerConnColdAlloc(int cold_type)
+{
+	void *cold_ptr;
+
+	cold_ptr = MemFreeCachePop(&conn_cold_cache, cold_type);
+
+	/* Nothing cached for this type, go to HEAP */
+	if (!cold_ptr)
+	{
+		BRB_CALLOC(cold_ptr, 1, conn_cold_size[cold_type]);
+		return cold_ptr;
+	}
+
+	/* Upper layers expect clean memory, as if it came from CALLOC */
+	memset(cold_ptr, 0, conn_cold_size[cold_type]);
+	return cold_ptr;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPServerConnColdFree(void *cold_ptr, int cold_type)
+{
+	/* Cache it for this thread, or release it if type list is full */
+	MemFreeCachePush(&conn_cold_cache, cold_type, cold_ptr);
+	return;
+}
+/**************************************************************************************************************************/
+static void CommEvTCPServerConnWriteQueueWatermarkCB(EvAIOReqQueue *aio_req_queue, int wm_code, void *cb_data)
+{
+	CommEvTCPServerConn *conn_hnd	= cb_data;
+	CommEvTCPServer *srv_ptr		= conn_hnd->parent_srv;
+
+	switch (wm_code)
+	{
+	/* Client is not keeping up with paired peer, stop reading from peer */
+	case AIOREQ_QUEUE_WATERMARK_HIGH:
+	{
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - Write queue above HIGH mark [%lu / %lu] - Pausing peer\n",
+				conn_hnd->socket_fd, aio_req_queue->stats.queue_sz, aio_req_queue->watermark.high_sz);
+
+		CommEvBackpressurePeerPause(&conn_hnd->backpressure);
+		return;
+	}
+	/* Drained, peer can read again. Upper layers are told on a JOB, as we may be deep inside WRITE_EV */
+	case AIOREQ_QUEUE_WATERMARK_LOW:
+	{
+		CommEvBackpressurePeerResume(&conn_hnd->backpressure);
+		conn_hnd->flags.write_drain_pending = 1;
+		break;
+	}
+	/* Aggregate memory cap reached and we hold the largest queue of this thread, drop us */
+	case AIOREQ_QUEUE_WATERMARK_SHED:
+	{
+		KQBASE_LOG_PRINTF(srv_ptr->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Write queue of [%lu] bytes shed by memory cap\n",
+				conn_hnd->socket_fd, aio_req_queue->stats.queue_sz);
+
+		conn_hnd->flags.write_shed_pending = 1;
+		break;
+	}
+	default:
+		return;
+	}
+
+	/* Already scheduled */
+	if (conn_hnd->backpressure_jobid > -1)
+		return;
+
+	conn_hnd->backpressure_jobid = EvKQJobsAdd(conn_hnd->kq_base, JOB_ACTION_ADD_VOLATILE, 0, CommEvTCPServerConnBackpressureJob, conn_hnd);
+	return;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPServerConnBackpressureReadCtl(void *owner_ptr, int pause)
+{
+	CommEvTCPServerConn *conn_hnd = owner_ptr;
+
+	/* Closed, closing or still negotiating, leave READ_EV alone */
+	if ((conn_hnd->socket_fd < 0) || (conn_hnd->flags.close_request) || (conn_hnd->flags.ssl_handshake_ongoing) || (conn_hnd->flags.ssl_shuting_down))
+		return 0;
 
+	/* Drop READ_EV, read handlers will not reschedule it while paused */
+	if (pause)
+	{
+		EvKQBaseSetEvent(conn_hnd->kq_base, conn_hnd->socket_fd, COMM_EV_READ, COMM_ACTION_DELETE, NULL, NULL);
+		return 1;
+	}
+
+	/* Upper layers no longer want to read */
+	if (!conn_hnd->events[CONN_EVENT_READ].cb_handler_ptr)
+		return 0;
+
+	CommEvTCPServerConnReadReschedule(conn_hnd);
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvTCPServerConnBackpressureJob(void *job, void *cbdata_ptr)
+{
+	CommEvTCPServerConn *conn_hnd = cbdata_ptr;
+
+	/* Reset JOB_ID */
+	conn_hnd->backpressure_jobid = -1;
+
+	/* Shed wins over drain, connection is going away */
+	if (conn_hnd->flags.write_shed_pending)
+	{
+		conn_hnd->flags.write_shed_pending	= 0;
+		conn_hnd->flags.write_drain_pending	= 0;
+
+		CommEvTCPServerConnClose(conn_hnd);
+		return 1;
+	}
+
+	/* Tell upper layers they can produce again */
+	if (conn_hnd->flags.write_drain_pending)
+	{
+		conn_hnd->flags.write_drain_pending = 0;
+		CommEvTCPServerConnDispatchEvent(conn_hnd, conn_hnd->iodata.write_queue.stats.queue_sz, conn_hnd->thrd_id, CONN_EVENT_WRITE_DRAIN);
+	}
+
+	return 1;
+}
+/**************************************************************************************************************************/
@@ -871,6 +871,10 @@ static int CommEvUNIXClientEventBrbProtoRead(int fd, int can_read_sz, int thrd_i
 		reply_count = CommEvUNIXIOControlDataProcess(ev_base, iodata, control_data, read_bytes);
 		ev_unixclient->counters.reply_ack += reply_count;
 
+		/* Feed parent pool health with ACK latency */
+		if (ev_unixclient->parent_pool && (reply_count > 0))
+			CommEvUNIXClientPoolClientReplyNotify(ev_unixclient->parent_pool, ev_unixclient, reply_count);
+
 		/* Calculate reply count */
 		KQBASE_LOG_PRINTF(ev_unixclient->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - Flag REPLY set for ID [%d] - [%d] Processed replies - [%d] Missing ACKs\n",
 				fd, control_data->req_id, reply_count, ev_unixclient->counters.req_sent_with_ack - ev_unixclient->counters.reply_ack);
@@ -1491,6 +1495,10 @@ static void CommEvUNIXClientEventDispatchInternal(CommEvUNIXClient *ev_unixclien
 
 	KQBASE_LOG_PRINTF(ev_unixclient->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - EV_ID [%d] - with [%d] bytes\n", ev_unixclient->socket_fd, ev_type, data_sz);
 
+	/* Feed parent pool health with failures */
+	if (ev_unixclient->parent_pool)
+		CommEvUNIXClientPoolClientEventNotify(ev_unixclient->parent_pool, ev_unixclient, ev_type);
+
 	/* Grab callback_ptr */
 	cb_handler	= ev_unixclient->events[ev_type].cb_handler_ptr;
 
@@ -35,6 +35,13 @@
 #include "../include/libbrb_core.h"
 
 static EvBaseKQObjDestroyCBH CommEvUNIXClientPoolObjectDestroyCBH;
+static EvBaseKQCBH CommEvUNIXClientPoolHealthTimer;
+
+static int CommEvUNIXClientPoolClientCanSelect(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClient *ev_unixclient, int select_connected);
+static long CommEvUNIXClientPoolClientLoad(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClient *ev_unixclient);
+static int CommEvUNIXClientPoolHealthyOthers(CommEvUNIXClientPool *unix_clientpool, int cli_id);
+static int CommEvUNIXClientPoolGrow(CommEvUNIXClientPool *unix_clientpool);
+static int CommEvUNIXClientPoolShrink(CommEvUNIXClientPool *unix_clientpool);
 
 /**************************************************************************************************************************/
 CommEvUNIXClientPool *CommEvUNIXClientPoolNew(EvKQBase *kq_base, CommEvUNIXClientPoolConf *unix_clientpool_conf)
@@ -55,10 +62,26 @@ CommEvUNIXClientPool *CommEvUNIXClientPoolNew(EvKQBase *kq_base, CommEvUNIXClien
 	/* Register KQ_OBJECT */
 	EvKQBaseObjectRegister(kq_base, &unix_clientpool->kq_obj);
 
+	unix_clientpool->kq_base					= kq_base;
+	unix_clientpool->health.timer_id			= -1;
+
 	/* Adjust POOL MAX SIZE */
+	if (unix_clientpool_conf->cli_count_init > COMM_UNIX_CLIENT_POOL_MAX)
+		unix_clientpool_conf->cli_count_init = COMM_UNIX_CLIENT_POOL_MAX;
+
 	if (unix_clientpool_conf->cli_count_max > COMM_UNIX_CLIENT_POOL_MAX)
 		unix_clientpool_conf->cli_count_max = COMM_UNIX_CLIENT_POOL_MAX;
 
+	if (unix_clientpool_conf->cli_count_max < unix_clientpool_conf->cli_count_init)
+		unix_clientpool_conf->cli_count_max = unix_clientpool_conf->cli_count_init;
+
+	/* Adjust POOL MIN SIZE, default is to never shrink below initial size */
+	if ((unix_clientpool_conf->cli_count_min <= 0) || (unix_clientpool_conf->cli_count_min > unix_clientpool_conf->cli_count_init))
+		unix_clientpool_conf->cli_count_min = unix_clientpool_conf->cli_count_init;
+
+	if (unix_clientpool_conf->health_check_ms <= 0)
+		unix_clientpool_conf->health_check_ms = COMM_POOL_HEALTH_CHECK_MS;
+
 	/* Copy UNIX client pool configuration to control structure */
 	memcpy(&unix_clientpool->pool_conf, unix_clientpool_conf, sizeof(CommEvUNIXClientPoolConf));
 
@@ -84,11 +107,16 @@ CommEvUNIXClientPool *CommEvUNIXClientPoolNew(EvKQBase *kq_base, CommEvUNIXClien
 		/* Common client initialization (i will be client_id on pool) */
 		CommEvUNIXClientInit(kq_base, ev_unixclient, socket_fd, i);
 		unix_clientpool->client.count_init++;
+		unix_clientpool->client.count_alloc++;
 
 		KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "UNIX_CLI [%d] with socket FD [%d]\n", i, ev_unixclient->socket_fd);
 		continue;
 	}
 
+	/* Health timer drives ACK timeouts, slow client ejection and pool resizing - Always on, so unanswered writes do not pile up as load */
+	unix_clientpool->health.timer_id = EvKQBaseTimerAdd(kq_base, COMM_ACTION_ADD_PERSIST, unix_clientpool->pool_conf.health_check_ms,
+			CommEvUNIXClientPoolHealthTimer, unix_clientpool);
+
 	return unix_clientpool;
 }
 /**************************************************************************************************************************/
@@ -101,6 +129,12 @@ int CommEvUNIXClientPoolDestroy(CommEvUNIXClientPool *unix_clientpool)
 	if (!unix_clientpool)
 		return 0;
 
+	/* Stop health timer */
+	if (unix_clientpool->health.timer_id > -1)
+		EvKQBaseTimerCtl(unix_clientpool->kq_base, unix_clientpool->health.timer_id, COMM_ACTION_DELETE);
+
+	unix_clientpool->health.timer_id = -1;
+
 	/* Cleanup individual UNIX_CLIENTs from pool */
 	for (i = 0; i < unix_clientpool->client.count_init; i++)
 	{
@@ -122,6 +156,7 @@ int CommEvUNIXClientPoolConnect(CommEvUNIXClientPool *unix_clientpool, CommEvUNI
 
 	/* Copy UNIX client pool configuration to control structure */
 	memcpy(&unix_clientpool->cli_conf, ev_unixclient_conf, sizeof(CommEvUNIXClientConf));
+	unix_clientpool->flags.conf_set = 1;
 
 	/* Cleanup individual UNIX_CLIENTs from pool */
 	for (i = 0; i < unix_clientpool->client.count_init; i++)
@@ -146,6 +181,8 @@ CommEvUNIXClient *CommEvUNIXClientPoolClientSelect(CommEvUNIXClientPool *unix_cl
 	{
 	case COMM_UNIX_SELECT_ROUND_ROBIN:	ev_unixclient = CommEvUNIXClientPoolClientSelectRoundRobin(unix_clientpool, select_connected);	break;
 	case COMM_UNIX_SELECT_LEAST_LOAD:	ev_unixclient = CommEvUNIXClientPoolClientSelectLeastLoad(unix_clientpool, select_connected);	break;
+	case COMM_UNIX_SELECT_POWER_OF_TWO:	ev_unixclient = CommEvUNIXClientPoolClientSelectPowerOfTwo(unix_clientpool, select_connected);	break;
+	case COMM_UNIX_SELECT_LEAST_LATENCY:	ev_unixclient = CommEvUNIXClientPoolClientSelectLeastLatency(unix_clientpool, select_connected);	break;
 	}
 
 	return ev_unixclient;
@@ -170,8 +207,8 @@ CommEvUNIXClient *CommEvUNIXClientPoolClientSelectLeastLoad(CommEvUNIXClientPool
 		/* Grab the UNIX client */
 		ev_unixclient = (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, i);
 
-		/* This client is disconnected, and we just want connected clients, ignore it */
-		if ((select_connected == COMM_UNIX_SELECT_CONNECTED) && (ev_unixclient->socket_state != COMM_CLIENT_STATE_CONNECTED))
+		/* This client is disconnected or ejected, and we just want connected clients, ignore it */
+		if (!CommEvUNIXClientPoolClientCanSelect(unix_clientpool, ev_unixclient, select_connected))
 			continue;
 
 		/* Grab QUEUED request size */
@@ -218,12 +255,12 @@ CommEvUNIXClient *CommEvUNIXClientPoolClientSelectRoundRobin(CommEvUNIXClientPoo
 	/* Walk clients RR */
 	for (i = 0; i < unix_clientpool->client.count_init; i++)
 	{
-		/* Grab UNIX_CLIENT and point to NEXT client in RR */
-		ev_unixclient = (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, unix_clientpool->client.rr_current);
-		unix_clientpool->client.rr_current = ((unix_clientpool->client.rr_current + 1) % unix_clientpool->pool_conf.cli_count_max);
+		/* Grab UNIX_CLIENT and point to NEXT client in RR - Wrap on active clients, pool may have shrunk */
+		ev_unixclient = (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, (unix_clientpool->client.rr_current % unix_clientpool->client.count_init));
+		unix_clientpool->client.rr_current = ((unix_clientpool->client.rr_current + 1) % unix_clientpool->client.count_init);
 
-		/* This client is disconnected, and we just want connected clients, ignore it */
-		if ((select_connected == COMM_UNIX_SELECT_CONNECTED) && (ev_unixclient->socket_state != COMM_CLIENT_STATE_CONNECTED))
+		/* This client is disconnected or ejected, and we just want connected clients, ignore it */
+		if (!CommEvUNIXClientPoolClientCanSelect(unix_clientpool, ev_unixclient, select_connected))
 			continue;
 
 		KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Selected UNIX_CLIENT ID [%d]\n", ev_unixclient->cli_id_onpool);
@@ -235,6 +272,137 @@ CommEvUNIXClient *CommEvUNIXClientPoolClientSelectRoundRobin(CommEvUNIXClientPoo
 	return NULL;
 }
 /**************************************************************************************************************************/
+CommEvUNIXClient *CommEvUNIXClientPoolClientSelectPowerOfTwo(CommEvUNIXClientPool *unix_clientpool, int select_connected)
+{
+	CommEvUNIXClient *ev_unixclient_a;
+	CommEvUNIXClient *ev_unixclient_b;
+	int i;
+
+	/* Sanity check */
+	if (unix_clientpool->client.count_init <= 0)
+		return NULL;
+
+	/* Draw two random clients and keep the less loaded one, a few draws before giving up on luck */
+	for (i = 0; i < COMM_POOL_POWER_OF_TWO_TRIES; i++)
+	{
+		ev_unixclient_a = (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, (arc4random() % unix_clientpool->client.count_init));
+		ev_unixclient_b = (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, (arc4random() % unix_clientpool->client.count_init));
+
+		if (!CommEvUNIXClientPoolClientCanSelect(unix_clientpool, ev_unixclient_a, select_connected))
+			ev_unixclient_a = NULL;
+
+		if (!CommEvUNIXClientPoolClientCanSelect(unix_clientpool, ev_unixclient_b, select_connected))
+			ev_unixclient_b = NULL;
+
+		/* Neither can be used, draw again */
+		if (!ev_unixclient_a && !ev_unixclient_b)
+			continue;
+
+		if (!ev_unixclient_a)
+			ev_unixclient_a = ev_unixclient_b;
+		else if (ev_unixclient_b && (CommEvUNIXClientPoolClientLoad(unix_clientpool, ev_unixclient_b) < CommEvUNIXClientPoolClientLoad(unix_clientpool, ev_unixclient_a)))
+			ev_unixclient_a = ev_unixclient_b;
+
+		KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Selected UNIX_CLIENT ID [%d] with LOAD [%ld]\n",
+				ev_unixclient_a->cli_id_onpool, CommEvUNIXClientPoolClientLoad(unix_clientpool, ev_unixclient_a));
+
+		return ev_unixclient_a;
+	}
+
+	/* Most of the pool is unusable, walk it all */
+	return CommEvUNIXClientPoolClientSelectLeastLoad(unix_clientpool, select_connected);
+}
+/**************************************************************************************************************************/
+CommEvUNIXClient *CommEvUNIXClientPoolClientSelectLeastLatency(CommEvUNIXClientPool *unix_clientpool, int select_connected)
+{
+	CommEvUNIXClient *ev_unixclient_cur		= NULL;
+	CommEvUNIXClient *ev_unixclient_selected	= NULL;
+	unsigned long cost_selected				= 0;
+	unsigned long cost_cur;
+	int i;
+
+	for (i = 0; i < unix_clientpool->client.count_init; i++)
+	{
+		/* Grab the UNIX client */
+		ev_unixclient_cur			= (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, i);
+
+		/* This client is disconnected or ejected, and we just want connected clients, ignore it */
+		if (!CommEvUNIXClientPoolClientCanSelect(unix_clientpool, ev_unixclient_cur, select_connected))
+			continue;
+
+		/* EWMA ACK latency weighted by queue depth - Pending ACKs are already part of health, count only unsent writes */
+		cost_cur					= CommEvPoolHealthCost(&unix_clientpool->health.arr[i],
+				MemSlotBaseSlotListIDSize(&ev_unixclient_cur->iodata.write.req_mem_slot, COMM_UNIX_LIST_PENDING_WRITE));
+
+		if ((!ev_unixclient_selected) || (cost_cur < cost_selected))
+		{
+			ev_unixclient_selected	= ev_unixclient_cur;
+			cost_selected			= cost_cur;
+		}
+
+		continue;
+	}
+
+	/* Found client, return */
+	if (ev_unixclient_selected)
+	{
+		KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Selected UNIX_CLIENT ID [%d] with LATENCY [%lu] us - COST [%lu]\n",
+				ev_unixclient_selected->cli_id_onpool, unix_clientpool->health.arr[ev_unixclient_selected->cli_id_onpool].latency_ewma_us, cost_selected);
+
+		return ev_unixclient_selected;
+	}
+
+	KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "No UNIX client found - CLI_COUNT [%d]\n", unix_clientpool->client.count_init);
+	return NULL;
+}
+/**************************************************************************************************************************/
+void CommEvUNIXClientPoolClientEventNotify(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClient *ev_unixclient, int ev_type)
+{
+	CommEvPoolHealth *health;
+	struct timeval *now_tv;
+	int ejected;
+
+	/* Sanity check */
+	if ((ev_unixclient->cli_id_onpool < 0) || (ev_unixclient->cli_id_onpool >= COMM_UNIX_CLIENT_POOL_MAX))
+		return;
+
+	health	= &unix_clientpool->health.arr[ev_unixclient->cli_id_onpool];
+	now_tv	= &ev_unixclient->kq_base->stats.cur_invoke_tv;
+	ejected	= 0;
+
+	switch (ev_type)
+	{
+	/* Peer closing an idle connection is normal, only requests left without ACK count as failure */
+	case COMM_UNIX_CLIENT_EVENT_CLOSE:
+		if (health->pending_count > 0)
+			ejected = CommEvPoolHealthFailMark(health, now_tv, (CommEvUNIXClientPoolHealthyOthers(unix_clientpool, ev_unixclient->cli_id_onpool) > 0));
+		break;
+
+	/* Only failed connects count, a good one is judged by its ACKs */
+	case COMM_UNIX_CLIENT_EVENT_CONNECT:
+		if (ev_unixclient->socket_state != COMM_CLIENT_STATE_CONNECTED)
+			ejected = CommEvPoolHealthFailMark(health, now_tv, (CommEvUNIXClientPoolHealthyOthers(unix_clientpool, ev_unixclient->cli_id_onpool) > 0));
+		break;
+	}
+
+	if (ejected)
+		KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "UNIX_CLIENT ID [%d] ejected for [%d] ms - FAILS [%d]\n",
+				ev_unixclient->cli_id_onpool, health->eject_ms, health->fail_count);
+
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvUNIXClientPoolClientReplyNotify(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClient *ev_unixclient, int reply_count)
+{
+	/* Sanity check */
+	if ((ev_unixclient->cli_id_onpool < 0) || (ev_unixclient->cli_id_onpool >= COMM_UNIX_CLIENT_POOL_MAX))
+		return;
+
+	/* ACKs answer pool writes in order, feed latency EWMA */
+	CommEvPoolHealthReplyMark(&unix_clientpool->health.arr[ev_unixclient->cli_id_onpool], &ev_unixclient->kq_base->stats.cur_invoke_tv, reply_count);
+	return;
+}
+/**************************************************************************************************************************/
 int CommEvUNIXClientPoolHasConnected(CommEvUNIXClientPool *unix_clientpool)
 {
 	CommEvUNIXClient *ev_unixclient;
@@ -273,6 +441,10 @@ int CommEvUNIXClientPoolEventSet(CommEvUNIXClientPool *unix_clientpool, CommEvUN
 		continue;
 	}
 
+	/* Save it so clients added by pool growth get the same events */
+	unix_clientpool->events[ev_type].cb_handler_ptr	= cb_handler;
+	unix_clientpool->events[ev_type].cb_data_ptr	= cb_data;
+
 	//KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "Event [%d] set for [%d] clients on pool\n", ev_type, i);
 	return 1;
 }
@@ -292,6 +464,9 @@ int CommEvUNIXClientPoolEventCancel(CommEvUNIXClientPool *unix_clientpool, CommE
 		continue;
 	}
 
+	unix_clientpool->events[ev_type].cb_handler_ptr	= NULL;
+	unix_clientpool->events[ev_type].cb_data_ptr	= NULL;
+
 	return 1;
 }
 /**************************************************************************************************************************/
@@ -310,6 +485,8 @@ int CommEvUNIXClientPoolEventCancelAll(CommEvUNIXClientPool *unix_clientpool)
 		continue;
 	}
 
+	memset(&unix_clientpool->events, 0, sizeof(unix_clientpool->events));
+
 	return 1;
 }
 /**************************************************************************************************************************/
@@ -335,6 +512,10 @@ int CommEvUNIXClientPoolAIOWrite(CommEvUNIXClientPool *unix_clientpool, int sele
 	/* Schedule write */
 	write_id 			= CommEvUNIXClientAIOBrbProtoWrite(ev_unixclient, data, data_sz, fd_arr, fd_sz, finish_cb, ack_cb, finish_cbdata, ack_cbdata);
 
+	/* Start latency clock only if peer will ACK this request */
+	if ((write_id > -1) && (ack_cb || ev_unixclient->flags.autoclose_fd_on_ack))
+		CommEvPoolHealthWriteMark(&unix_clientpool->health.arr[ev_unixclient->cli_id_onpool], &unix_clientpool->kq_base->stats.cur_invoke_tv);
+
 	return write_id;
 }
 /**************************************************************************************************************************/
@@ -354,3 +535,234 @@ static int CommEvUNIXClientPoolObjectDestroyCBH(void *kq_obj_ptr, void *cb_data)
 	return 1;
 }
 /**************************************************************************************************************************/
+static int CommEvUNIXClientPoolHealthTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvUNIXClientPool *unix_clientpool	= cb_data;
+	EvKQBase *kq_base						= base_ptr;
+	struct timeval *now_tv					= &kq_base->stats.cur_invoke_tv;
+	CommEvUNIXClient *ev_unixclient;
+	CommEvPoolHealth *health;
+	unsigned long ewma_total				= 0;
+	long load_total							= 0;
+	int ewma_count							= 0;
+	int healthy_count						= 0;
+	int was_ejected;
+	int i;
+
+	unix_clientpool->client.count_online	= 0;
+
+	/* Walk active clients, collect load and pool latency reference */
+	for (i = 0; i < unix_clientpool->client.count_init; i++)
+	{
+		ev_unixclient	= (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, i);
+		health			= &unix_clientpool->health.arr[i];
+		load_total		+= CommEvUNIXClientPoolClientLoad(unix_clientpool, ev_unixclient);
+
+		if (ev_unixclient->socket_state != COMM_CLIENT_STATE_CONNECTED)
+			continue;
+
+		unix_clientpool->client.count_online++;
+
+		if (health->flags.ejected)
+			continue;
+
+		healthy_count++;
+
+		if (health->sample_count > 0)
+		{
+			ewma_total += health->latency_ewma_us;
+			ewma_count++;
+		}
+
+		continue;
+	}
+
+	unix_clientpool->health.latency_ewma_us = ((ewma_count > 0) ? (ewma_total / ewma_count) : 0);
+
+	/* ACK timeouts and latency outliers - Never eject the last healthy client */
+	if (unix_clientpool->pool_conf.flags.eject_slow)
+	{
+		for (i = 0; i < unix_clientpool->client.count_init; i++)
+		{
+			health		= &unix_clientpool->health.arr[i];
+			was_ejected	= health->flags.ejected;
+
+			CommEvPoolHealthCheck(health, now_tv, unix_clientpool->health.latency_ewma_us, (healthy_count > 1));
+
+			if (!was_ejected && health->flags.ejected)
+			{
+				KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "UNIX_CLIENT ID [%d] ejected for [%d] ms - LATENCY [%lu] us - POOL [%lu] us\n",
+						i, health->eject_ms, health->latency_ewma_us, unix_clientpool->health.latency_ewma_us);
+
+				healthy_count--;
+			}
+
+			continue;
+		}
+	}
+	/* No ejection, just stop counting writes the peer never answered */
+	else
+	{
+		for (i = 0; i < unix_clientpool->client.count_init; i++)
+			CommEvPoolHealthPendingExpire(&unix_clientpool->health.arr[i], now_tv);
+	}
+
+	/* Resize between MIN and MAX */
+	if (unix_clientpool->pool_conf.flags.auto_resize)
+	{
+		/* Hot pool, average load on online clients too high, add one */
+		if ((unix_clientpool->client.count_online > 0) && ((load_total / unix_clientpool->client.count_online) >= COMM_POOL_RESIZE_GROW_LOAD) &&
+				(unix_clientpool->client.count_init < unix_clientpool->pool_conf.cli_count_max))
+		{
+			unix_clientpool->health.idle_ticks = 0;
+			CommEvUNIXClientPoolGrow(unix_clientpool);
+		}
+		/* Idle long enough, drop one */
+		else if (0 == load_total)
+		{
+			if ((++unix_clientpool->health.idle_ticks >= COMM_POOL_RESIZE_SHRINK_TICKS) && (unix_clientpool->client.count_init > unix_clientpool->pool_conf.cli_count_min))
+			{
+				unix_clientpool->health.idle_ticks = 0;
+				CommEvUNIXClientPoolShrink(unix_clientpool);
+			}
+		}
+		else
+			unix_clientpool->health.idle_ticks = 0;
+	}
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvUNIXClientPoolClientCanSelect(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClient *ev_unixclient, int select_connected)
+{
+	/* Caller will take anyone */
+	if (select_connected != COMM_UNIX_SELECT_CONNECTED)
+		return 1;
+
+	if (ev_unixclient->socket_state != COMM_CLIENT_STATE_CONNECTED)
+		return 0;
+
+	/* Ejected clients come back only as a probe, after their back-off */
+	return CommEvPoolHealthCanSelect(&unix_clientpool->health.arr[ev_unixclient->cli_id_onpool], &unix_clientpool->kq_base->stats.cur_invoke_tv);
+}
+/**************************************************************************************************************************/
+static long CommEvUNIXClientPoolClientLoad(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClient *ev_unixclient)
+{
+	/* Same load reference as LEAST_LOAD - Requests pending WRITE or ACK, plus ACKs we still have to send */
+	return (MemSlotBaseSlotListIDSize(&ev_unixclient->iodata.write.req_mem_slot, COMM_UNIX_LIST_PENDING_WRITE) +
+			MemSlotBaseSlotListIDSize(&ev_unixclient->iodata.write.req_mem_slot, COMM_UNIX_LIST_PENDING_ACK) +
+			MemSlotBaseSlotListIDSize(&ev_unixclient->iodata.write.ack_mem_slot, COMM_UNIX_LIST_PENDING_WRITE));
+}
+/**************************************************************************************************************************/
+static int CommEvUNIXClientPoolHealthyOthers(CommEvUNIXClientPool *unix_clientpool, int cli_id)
+{
+	CommEvUNIXClient *ev_unixclient;
+	int healthy_count;
+	int i;
+
+	/* Connected and not ejected clients, other than CLI_ID */
+	for (healthy_count = 0, i = 0; i < unix_clientpool->client.count_init; i++)
+	{
+		if (i == cli_id)
+			continue;
+
+		ev_unixclient = (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, i);
+
+		if ((ev_unixclient->socket_state == COMM_CLIENT_STATE_CONNECTED) && (!unix_clientpool->health.arr[i].flags.ejected))
+			healthy_count++;
+
+		continue;
+	}
+
+	return healthy_count;
+}
+/**************************************************************************************************************************/
+static int CommEvUNIXClientPoolGrow(CommEvUNIXClientPool *unix_clientpool)
+{
+	CommEvUNIXClient *ev_unixclient;
+	int socket_fd;
+	int cli_id;
+	int i;
+
+	cli_id = unix_clientpool->client.count_init;
+
+	/* Reuse slot left behind by a shrink, or grab a NEW one from MEM_SLOT */
+	if (cli_id < unix_clientpool->client.count_alloc)
+		ev_unixclient = (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, cli_id);
+	else
+	{
+		ev_unixclient = (CommEvUNIXClient*)MemSlotBaseSlotGrab(&unix_clientpool->client.memslot);
+
+		/* Out of slots */
+		if (!ev_unixclient)
+			return 0;
+
+		unix_clientpool->client.count_alloc++;
+	}
+
+	/* Create socket and set it to non_blocking */
+	socket_fd = EvKQBaseSocketUNIXNew(unix_clientpool->kq_base);
+
+	/* Check if created socket is OK */
+	if (socket_fd < 0)
+		return 0;
+
+	memset(ev_unixclient, 0, sizeof(CommEvUNIXClient));
+	ev_unixclient->parent_pool = unix_clientpool;
+
+	/* Common client initialization (cli_id will be client_id on pool) */
+	CommEvUNIXClientInit(unix_clientpool->kq_base, ev_unixclient, socket_fd, cli_id);
+	CommEvPoolHealthClean(&unix_clientpool->health.arr[cli_id]);
+	unix_clientpool->client.count_init++;
+
+	/* Replay events set on pool */
+	for (i = 0; i < COMM_UNIX_CLIENT_EVENT_LASTITEM; i++)
+	{
+		if (!unix_clientpool->events[i].cb_handler_ptr)
+			continue;
+
+		CommEvUNIXClientEventSet(ev_unixclient, i, unix_clientpool->events[i].cb_handler_ptr,
+				(NULL == unix_clientpool->events[i].cb_data_ptr ? ev_unixclient : unix_clientpool->events[i].cb_data_ptr));
+	}
+
+	/* Pool already connected, bring new client up too */
+	if (unix_clientpool->flags.conf_set)
+	{
+		ev_unixclient->log_base = unix_clientpool->cli_conf.log_base;
+		CommEvUNIXClientConnect(ev_unixclient, &unix_clientpool->cli_conf);
+	}
+
+	KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "Pool grow - UNIX_CLIENT ID [%d] - CLI_COUNT [%d/%d]\n",
+			cli_id, unix_clientpool->client.count_init, unix_clientpool->pool_conf.cli_count_max);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static int CommEvUNIXClientPoolShrink(CommEvUNIXClientPool *unix_clientpool)
+{
+	CommEvUNIXClient *ev_unixclient;
+	int cli_id;
+
+	/* Always drop the highest ID, so active clients stay at [0, count_init) */
+	cli_id			= (unix_clientpool->client.count_init - 1);
+	ev_unixclient	= (CommEvUNIXClient*)MemSlotBaseSlotGrabByID(&unix_clientpool->client.memslot, cli_id);
+
+	/* Never drop a client with work in flight */
+	if (CommEvUNIXClientPoolClientLoad(unix_clientpool, ev_unixclient) > 0)
+		return 0;
+
+	unix_clientpool->client.count_init--;
+
+	/* Slot stays grabbed, GROW will reuse it - INIT registers the object again, so unregister here */
+	if (ev_unixclient->kq_obj.flags.registered)
+		EvKQBaseObjectUnregister(&ev_unixclient->kq_obj);
+
+	CommEvUNIXClientClean(ev_unixclient);
+	CommEvPoolHealthClean(&unix_clientpool->health.arr[cli_id]);
+
+	KQBASE_LOG_PRINTF(unix_clientpool->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "Pool shrink - UNIX_CLIENT ID [%d] - CLI_COUNT [%d/%d]\n",
+			cli_id, unix_clientpool->client.count_init, unix_clientpool->pool_conf.cli_count_min);
+
+	return 1;
+}
+/**************************************************************************************************************************/
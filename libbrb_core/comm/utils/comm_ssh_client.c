@@ -481,6 +481,10 @@ void CommEvSSHClientEventCancel(CommEvSSHClient *ev_sshclient, CommEvTCPClientEv
 	case COMM_CLIENT_EVENT_READ:
 		EvKQBaseSetEvent(ev_sshclient->kq_base, ev_sshclient->socket_fd, COMM_EV_READ, COMM_ACTION_DELETE, NULL, NULL);
 		break;
+
+	/* WRITE, WRITE_DRAIN, CLOSE and CONNECT are dispatched internally, no kqueue event to remove */
+	default:
+		break;
 	}
 
 	return;
@@ -360,6 +360,53 @@ void CommEvSSLUtils_X509CertRefCountInc(X509 *crt, int thread_safe)
 	return;
 }
 /**************************************************************************************************************************/
+void CommEvSSLUtils_SessionRefCountInc(SSL_SESSION *ssl_session, int thread_safe)
+{
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+	if (thread_safe)
+		CRYPTO_add(&ssl_session->references, 1, CRYPTO_LOCK_SSL_SESSION);
+	else
+		ssl_session->references++;
+#else
+	SSL_SESSION_up_ref(ssl_session);
+#endif
+
+	return;
+}
+/**************************************************************************************************************************/
+void CommEvSSLUtils_ContextRefCountInc(SSL_CTX *ssl_context, int thread_safe)
+{
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+	if (thread_safe)
+		CRYPTO_add(&ssl_context->references, 1, CRYPTO_LOCK_SSL_CTX);
+	else
+		ssl_context->references++;
+#else
+	SSL_CTX_up_ref(ssl_context);
+#endif
+
+	return;
+}
+/**************************************************************************************************************************/
+int CommEvSSLUtils_SessionIsValid(SSL_SESSION *ssl_session)
+{
+	/* Sanity check */
+	if (!ssl_session)
+		return 0;
+
+	/* Expired */
+	if ((SSL_SESSION_get_time(ssl_session) + SSL_SESSION_get_timeout(ssl_session)) <= time(NULL))
+		return 0;
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+	/* TLS 1.3 sessions are only resumable after server sent a ticket */
+	if (!SSL_SESSION_is_resumable(ssl_session))
+		return 0;
+#endif
+
+	return 1;
+}
+/**************************************************************************************************************************/
 int CommEvSSLUtils_X509CopyRandom(X509 *dstcrt, X509 *srccrt)
 {
 	ASN1_INTEGER *srcptr, *dstptr;
@@ -0,0 +1,174 @@
+/*
+ * crc32c.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libbrb_data.h"
+
+#if defined(__SSE4_2__) && defined(__x86_64__)
+#include <nmmintrin.h>
+#define BRB_CRC32C_HW		1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define BRB_CRC32C_HW		1
+#endif
+
+/* Castagnoli polynomial, reflected */
+#define BRB_CRC32C_POLY		0x82F63B78
+
+#if !defined(BRB_CRC32C_HW)
+static void BRB_CRC32CTableInit(void);
+
+static pthread_once_t crc32c_table_once = PTHREAD_ONCE_INIT;
+static uint32_t crc32c_table[8][256];
+#endif
+
+/**************************************************************************************************************************/
+uint32_t BRB_CRC32C(const void *buf, unsigned long len)
+{
+	return BRB_CRC32CUpdate(0, buf, len);
+}
+/**************************************************************************************************************************/
+uint32_t BRB_CRC32CUpdate(uint32_t crc, const void *buf, unsigned long len)
+{
+	const unsigned char *cur_ptr = buf;
+
+	/* Chained calls see the finalized value, so undo it */
+	crc = ~crc;
+
+#if defined(__SSE4_2__) && defined(__x86_64__)
+	/* Hardware CRC32C, byte steps until aligned, then 8 bytes per instruction */
+	while ((len > 0) && (((uintptr_t)cur_ptr) & 7))
+	{
+		crc = _mm_crc32_u8(crc, *cur_ptr++);
+		len--;
+	}
+
+	while (len >= 8)
+	{
+		crc			= (uint32_t)_mm_crc32_u64(crc, *(const uint64_t *)cur_ptr);
+		cur_ptr		+= 8;
+		len			-= 8;
+	}
+
+	while (len > 0)
+	{
+		crc = _mm_crc32_u8(crc, *cur_ptr++);
+		len--;
+	}
+#elif defined(__ARM_FEATURE_CRC32)
+	while ((len > 0) && (((uintptr_t)cur_ptr) & 7))
+	{
+		crc = __crc32cb(crc, *cur_ptr++);
+		len--;
+	}
+
+	while (len >= 8)
+	{
+		crc			= __crc32cd(crc, *(const uint64_t *)cur_ptr);
+		cur_ptr		+= 8;
+		len			-= 8;
+	}
+
+	while (len > 0)
+	{
+		crc = __crc32cb(crc, *cur_ptr++);
+		len--;
+	}
+#else
+	uint32_t word_low;
+	uint32_t word_high;
+
+	/* Software slicing by 8 */
+	pthread_once(&crc32c_table_once, BRB_CRC32CTableInit);
+
+	while (len >= 8)
+	{
+		word_low	= ((cur_ptr[0] | (cur_ptr[1] << 8) | (cur_ptr[2] << 16) | ((uint32_t)cur_ptr[3] << 24)) ^ crc);
+		word_high	= (cur_ptr[4] | (cur_ptr[5] << 8) | (cur_ptr[6] << 16) | ((uint32_t)cur_ptr[7] << 24));
+
+		crc			= (crc32c_table[7][word_low & 0xFF] ^ crc32c_table[6][(word_low >> 8) & 0xFF] ^
+				crc32c_table[5][(word_low >> 16) & 0xFF] ^ crc32c_table[4][word_low >> 24] ^
+				crc32c_table[3][word_high & 0xFF] ^ crc32c_table[2][(word_high >> 8) & 0xFF] ^
+				crc32c_table[1][(word_high >> 16) & 0xFF] ^ crc32c_table[0][word_high >> 24]);
+
+		cur_ptr		+= 8;
+		len			-= 8;
+	}
+
+	while (len > 0)
+	{
+		crc = (crc32c_table[0][(crc ^ *cur_ptr++) & 0xFF] ^ (crc >> 8));
+		len--;
+	}
+#endif
+
+	return ~crc;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+#if !defined(BRB_CRC32C_HW)
+static void BRB_CRC32CTableInit(void)
+{
+	uint32_t crc;
+	int i;
+	int j;
+
+	/* Plain byte table */
+	for (i = 0; i < 256; i++)
+	{
+		crc = i;
+
+		for (j = 0; j < 8; j++)
+			crc = ((crc & 1) ? ((crc >> 1) ^ BRB_CRC32C_POLY) : (crc >> 1));
+
+		crc32c_table[0][i] = crc;
+	}
+
+	/* Each slice advances previous one by another zero byte */
+	for (i = 0; i < 256; i++)
+	{
+		crc = crc32c_table[0][i];
+
+		for (j = 1; j < 8; j++)
+		{
+			crc					= (crc32c_table[0][crc & 0xFF] ^ (crc >> 8));
+			crc32c_table[j][i]	= crc;
+		}
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+#endif
@@ -34,7 +34,25 @@
 
 #include "../include/libbrb_core.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Bit N lives in byte N/8, bit N%8. On little endian hosts that is exactly bit N%64 of 64 bit word N/64, so
+ * the on disk byte layout is kept and scanned a word at a time. Big endian hosts swap each word on access */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define DYNBITMAP_WORD_HOST(word)		__builtin_bswap64(word)
+#else
+#define DYNBITMAP_WORD_HOST(word)		(word)
+#endif
+#define DYNBITMAP_WORD_PTR(dyn_bitmap)	((unsigned long long *)(dyn_bitmap)->bitmap.data)
+#define DYNBITMAP_WORD_ALL				(~0ULL)
+
 static int DynBitMapGrowIfNeeded(DynBitMap *dyn_bitmap, long wanted_index);
+static long DynBitMapAllocSize(long capacity);
+static long DynBitMapFindWord(DynBitMap *dyn_bitmap, long index, int want_set);
+static long DynBitMapRangeApply(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish, int set_bits);
+static long DynBitMapPopCountWords(unsigned long long *word_ptr, long word_count);
 
 /**************************************************************************************************************************/
 DynBitMap *DynBitMapNew(LibDataThreadSafeType thrd_type, long grow_rate)
@@ -56,8 +74,8 @@ int DynBitMapInit(DynBitMap *dyn_bitmap, LibDataThreadSafeType thrd_type, long g
 
 	memset(dyn_bitmap, 0, sizeof(DynBitMap));
 
-	/* Initialize bitmap area */
-	dyn_bitmap->bitmap.data			= calloc(1, (grow_rate + 1));
+	/* Initialize bitmap area, always padded to whole words */
+	dyn_bitmap->bitmap.data			= calloc(1, DynBitMapAllocSize(grow_rate));
 
 	/* Initialize PTHREAD MUTEX */
 	dyn_bitmap->mutex				= (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
@@ -187,6 +205,7 @@ int DynBitMapBitClearAll(DynBitMap *dyn_bitmap)
 
 	/* Clean map */
 	memset(dyn_bitmap->bitmap.data, 0, dyn_bitmap->bitmap.capacity);
+	dyn_bitmap->bitmap.bitset_count = 0;
 
 	return 1;
 }
@@ -222,30 +241,22 @@ long DynBitMapGetHigherSeen(DynBitMap *dyn_bitmap)
 /**************************************************************************************************************************/
 int DynBitMapCheckMultiBlocks(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish)
 {
-	long i;
-
 	/* Sanity check */
 	if (!dyn_bitmap)
 		return 0;
 
-	/* Test all BITs */
-	for (i = block_idx_begin; i <= block_idx_finish; i++)
-	{
-		/* BIT failed, give up */
-		if (!DynBitMapBitTest(dyn_bitmap, i))
-			return 0;
-
-		continue;
-	}
+	/* Empty range, nothing can fail */
+	if (block_idx_begin > block_idx_finish)
+		return 1;
 
-	/* ALL OK */
-	return 1;
+	/* First hole must sit after the range. Anything above higher seen is a hole */
+	return (DynBitMapFindWord(dyn_bitmap, block_idx_begin, 0) > block_idx_finish);
 }
 /**************************************************************************************************************************/
 int DynBitMapGetValidBlocks(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish, DynBitMapValidBlockIdx *valid_block_idx)
 {
-	int i;
-	int found_first = 0;
+	long first_idx;
+	long last_idx;
 
 	/* Initialize values */
 	valid_block_idx->first_idx 	= -1;
@@ -263,38 +274,154 @@ int DynBitMapGetValidBlocks(DynBitMap *dyn_bitmap, long block_idx_begin, long bl
 		block_idx_finish = dyn_bitmap->bitmap.higher_seen;
 
 	/* Find first valid block */
-	for (i = block_idx_begin; i <= block_idx_finish; i++)
-	{
-		/* Searching for first valid block */
-		if (!found_first)
-		{
-			/* BIT success, get index and mark flag to search the last valid block */
-			if (DynBitMapBitTest(dyn_bitmap, i))
-			{
-				valid_block_idx->first_idx 	= i;
-				valid_block_idx->last_idx 	= i;
+	first_idx = DynBitMapFindWord(dyn_bitmap, block_idx_begin, 1);
 
-				found_first = 1;
-			}
-		}
-		/* Continue searching until we have valid blocks */
-		else
-		{
-			/* BIT failed, give up */
-			if (!DynBitMapBitTest(dyn_bitmap, i))
-			{
-				valid_block_idx->last_idx	= (i-1);
-				break;
-			}
+	if ((first_idx < 0) || (first_idx > block_idx_finish))
+		return 0;
 
-			valid_block_idx->last_idx		= i;
-		}
+	/* Run goes until the next hole, capped by range */
+	last_idx = (DynBitMapFindWord(dyn_bitmap, first_idx, 0) - 1);
 
-		continue;
+	valid_block_idx->first_idx	= first_idx;
+	valid_block_idx->last_idx	= ((last_idx > block_idx_finish) ? block_idx_finish : last_idx);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+long DynBitMapBitSetRange(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish)
+{
+	long changed_count;
+
+	/* Sanity check */
+	if ((!dyn_bitmap) || (block_idx_begin < 0) || (block_idx_begin > block_idx_finish))
+		return 0;
+
+	/* Running THREAD_SAFE, LOCK MUTEX */
+	if (dyn_bitmap->flags.thread_safe)
+		MUTEX_LOCK(dyn_bitmap->mutex, "DYN_BITMAP");
+
+	/* Update higher seen and grow to fit whole range */
+	if (dyn_bitmap->bitmap.higher_seen < block_idx_finish)
+		dyn_bitmap->bitmap.higher_seen = block_idx_finish;
+
+	DynBitMapGrowIfNeeded(dyn_bitmap, block_idx_finish);
+	changed_count = DynBitMapRangeApply(dyn_bitmap, block_idx_begin, block_idx_finish, 1);
+
+	/* Running THREAD_SAFE, UNLOCK MUTEX */
+	if (dyn_bitmap->flags.thread_safe)
+		MUTEX_UNLOCK(dyn_bitmap->mutex, "DYN_BITMAP");
+
+	return changed_count;
+}
+/**************************************************************************************************************************/
+long DynBitMapBitClearRange(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish)
+{
+	long changed_count;
+
+	/* Sanity check */
+	if ((!dyn_bitmap) || (block_idx_begin < 0) || (block_idx_begin > block_idx_finish))
+		return 0;
+
+	/* Never seen this high */
+	if (dyn_bitmap->bitmap.higher_seen < block_idx_begin)
+		return 0;
+
+	/* Running THREAD_SAFE, LOCK MUTEX */
+	if (dyn_bitmap->flags.thread_safe)
+		MUTEX_LOCK(dyn_bitmap->mutex, "DYN_BITMAP");
+
+	if (block_idx_finish > dyn_bitmap->bitmap.higher_seen)
+		block_idx_finish = dyn_bitmap->bitmap.higher_seen;
+
+	changed_count = DynBitMapRangeApply(dyn_bitmap, block_idx_begin, block_idx_finish, 0);
+
+	/* Running THREAD_SAFE, UNLOCK MUTEX */
+	if (dyn_bitmap->flags.thread_safe)
+		MUTEX_UNLOCK(dyn_bitmap->mutex, "DYN_BITMAP");
+
+	return changed_count;
+}
+/**************************************************************************************************************************/
+long DynBitMapFindNextSet(DynBitMap *dyn_bitmap, long index)
+{
+	/* Sanity check */
+	if (!dyn_bitmap)
+		return -1;
+
+	return DynBitMapFindWord(dyn_bitmap, index, 1);
+}
+/**************************************************************************************************************************/
+long DynBitMapFindNextClear(DynBitMap *dyn_bitmap, long index)
+{
+	/* Sanity check */
+	if (!dyn_bitmap)
+		return -1;
+
+	return DynBitMapFindWord(dyn_bitmap, index, 0);
+}
+/**************************************************************************************************************************/
+long DynBitMapPopCount(DynBitMap *dyn_bitmap)
+{
+	/* Sanity check */
+	if (!dyn_bitmap)
+		return 0;
+
+	return dyn_bitmap->bitmap.bitset_count;
+}
+/**************************************************************************************************************************/
+long DynBitMapPopCountRange(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish)
+{
+	unsigned long long *word_ptr;
+	unsigned long long word_mask;
+	long first_word;
+	long last_word;
+	long bit_count;
+
+	/* Sanity check */
+	if ((!dyn_bitmap) || (block_idx_begin < 0) || (block_idx_begin > block_idx_finish) || (block_idx_begin > dyn_bitmap->bitmap.higher_seen))
+		return 0;
+
+	if (block_idx_finish > dyn_bitmap->bitmap.higher_seen)
+		block_idx_finish = dyn_bitmap->bitmap.higher_seen;
+
+	word_ptr	= DYNBITMAP_WORD_PTR(dyn_bitmap);
+	first_word	= (block_idx_begin >> 6);
+	last_word	= (block_idx_finish >> 6);
+
+	/* Edge words are masked, whole words in between go through bulk count */
+	word_mask	= (DYNBITMAP_WORD_ALL << (block_idx_begin & 63));
+
+	if (first_word == last_word)
+	{
+		word_mask &= (DYNBITMAP_WORD_ALL >> (63 - (block_idx_finish & 63)));
+		return __builtin_popcountll(DYNBITMAP_WORD_HOST(word_ptr[first_word]) & word_mask);
 	}
 
-	/* We found any valid block? */
-	return (valid_block_idx->first_idx < 0 ? 0 : 1);
+	bit_count	= __builtin_popcountll(DYNBITMAP_WORD_HOST(word_ptr[first_word]) & word_mask);
+	bit_count	+= DynBitMapPopCountWords(&word_ptr[first_word + 1], (last_word - first_word - 1));
+	bit_count	+= __builtin_popcountll(DYNBITMAP_WORD_HOST(word_ptr[last_word]) & (DYNBITMAP_WORD_ALL >> (63 - (block_idx_finish & 63))));
+
+	return bit_count;
+}
+/**************************************************************************************************************************/
+int DynBitMapRunNext(DynBitMap *dyn_bitmap, long index, DynBitMapValidBlockIdx *run_idx)
+{
+	/* Initialize values */
+	run_idx->first_idx	= -1;
+	run_idx->last_idx	= -1;
+
+	/* Sanity check */
+	if (!dyn_bitmap)
+		return 0;
+
+	run_idx->first_idx = DynBitMapFindWord(dyn_bitmap, index, 1);
+
+	/* No more runs */
+	if (run_idx->first_idx < 0)
+		return 0;
+
+	run_idx->last_idx = (DynBitMapFindWord(dyn_bitmap, run_idx->first_idx, 0) - 1);
+	return 1;
 }
 /**************************************************************************************************************************/
 int DynBitMapGenerateStringMap(DynBitMap *dyn_bitmap, char *ret_mask, int ret_mask_size)
@@ -377,6 +504,7 @@ int DynBitMapMetaDataUnPack(DynBitMap *dyn_bitmap, MemBuffer *raw_metadata_mb)
 	DynBitMapMetaData *dyn_bitmap_meta;
 	MetaDataItem *meta_item;
 	MetaData metadata;
+	long data_alloc_sz = 0;
 	int op_status;
 	int i;
 
@@ -426,8 +554,9 @@ int DynBitMapMetaDataUnPack(DynBitMap *dyn_bitmap, MemBuffer *raw_metadata_mb)
 
 			//printf("DynBitMapMetaDataUnPack - DATATYPE_DYN_BITMAP_DATA with [%d] bytes\n", meta_item->sz);
 
-			/* Create a new one and copy back BITMAP from METADATA */
-			dyn_bitmap->bitmap.data = calloc(1, (meta_item->sz + 1));
+			/* Create a new one and copy back BITMAP from METADATA, padded to whole words */
+			data_alloc_sz			= DynBitMapAllocSize((meta_item->sz > dyn_bitmap->bitmap.capacity) ? meta_item->sz : dyn_bitmap->bitmap.capacity);
+			dyn_bitmap->bitmap.data = calloc(1, data_alloc_sz);
 			memcpy(dyn_bitmap->bitmap.data, meta_item->ptr, meta_item->sz);
 
 			continue;
@@ -436,6 +565,10 @@ int DynBitMapMetaDataUnPack(DynBitMap *dyn_bitmap, MemBuffer *raw_metadata_mb)
 		continue;
 	}
 
+	/* Recount from data, so counter always matches what was loaded */
+	if (data_alloc_sz > 0)
+		dyn_bitmap->bitmap.bitset_count = DynBitMapPopCountWords(DYNBITMAP_WORD_PTR(dyn_bitmap), (data_alloc_sz / 8));
+
 	/* Clean UP METDATA and leave */
 	MetaDataClean(&metadata);
 	return 1;
@@ -455,7 +588,7 @@ MemBuffer *DynBitMapMetaDataPackToMB(DynBitMap *dyn_bitmap, long item_sub_id)
 
 	/* Pack data into METADATA SERIALIZER and DUMP it into MEMBUFFER */
 	DynBitMapMetaDataPack(dyn_bitmap, &metadata, item_sub_id);
-	MetaDataPack(&metadata, packed_mb);
+	MetaDataPackV2(&metadata, packed_mb, METADATA_CHECKSUM_CRC32C);
 
 	/* Clean UP METDATA and leave */
 	MetaDataClean(&metadata);
@@ -468,6 +601,7 @@ DynBitMap *DynBitMapMetaDataUnPackFromMeta(MetaData *metadata)
 	DynBitMapMetaData *dyn_bitmap_meta;
 	MetaDataItem *meta_item;
 	DynBitMap *dyn_bitmap;
+	long data_alloc_sz = 0;
 	int i;
 
 	/* Create a new bitmap and unpack */
@@ -502,8 +636,9 @@ DynBitMap *DynBitMapMetaDataUnPackFromMeta(MetaData *metadata)
 
 			//	printf("DynBitMapMetaDataUnPackFromMeta - DATATYPE_DYN_BITMAP_DATA with [%d] bytes\n", meta_item->sz);
 
-			/* Create a new one and copy back BITMAP from METADATA */
-			dyn_bitmap->bitmap.data = calloc(1, (meta_item->sz + 1));
+			/* Create a new one and copy back BITMAP from METADATA, padded to whole words */
+			data_alloc_sz			= DynBitMapAllocSize((meta_item->sz > dyn_bitmap->bitmap.capacity) ? meta_item->sz : dyn_bitmap->bitmap.capacity);
+			dyn_bitmap->bitmap.data = calloc(1, data_alloc_sz);
 			memcpy(dyn_bitmap->bitmap.data, meta_item->ptr, meta_item->sz);
 
 			continue;
@@ -512,6 +647,10 @@ DynBitMap *DynBitMapMetaDataUnPackFromMeta(MetaData *metadata)
 		continue;
 	}
 
+	/* Recount from data, so counter always matches what was loaded */
+	if (data_alloc_sz > 0)
+		dyn_bitmap->bitmap.bitset_count = DynBitMapPopCountWords(DYNBITMAP_WORD_PTR(dyn_bitmap), (data_alloc_sz / 8));
+
 	return dyn_bitmap;
 }
 /**************************************************************************************************************************/
@@ -549,9 +688,9 @@ static int DynBitMapGrowIfNeeded(DynBitMap *dyn_bitmap, long wanted_index)
 	{
 		//printf("DynBitMapGrowIfNeeded - Will grow - CAP [%ld] - WANTED [%ld]\n", dyn_bitmap->bitmap.capacity, wanted_offset);
 
-		/* REALLOC and initialize */
-		dyn_bitmap->bitmap.data = realloc(dyn_bitmap->bitmap.data, new_size);
-		memset(&dyn_bitmap->bitmap.data[dyn_bitmap->bitmap.capacity], 0, (new_size - dyn_bitmap->bitmap.capacity));
+		/* REALLOC and initialize, bytes past capacity are always zero so word scans never see garbage */
+		dyn_bitmap->bitmap.data = realloc(dyn_bitmap->bitmap.data, DynBitMapAllocSize(new_size));
+		memset(&dyn_bitmap->bitmap.data[dyn_bitmap->bitmap.capacity], 0, (DynBitMapAllocSize(new_size) - dyn_bitmap->bitmap.capacity));
 
 		/* Update to new size */
 		dyn_bitmap->bitmap.capacity = new_size;
@@ -562,3 +701,150 @@ static int DynBitMapGrowIfNeeded(DynBitMap *dyn_bitmap, long wanted_index)
 	return 0;
 }
 /**************************************************************************************************************************/
+static long DynBitMapAllocSize(long capacity)
+{
+	/* Whole words, with at least one spare word after capacity */
+	return (((capacity / 8) + 2) * 8);
+}
+/**************************************************************************************************************************/
+static long DynBitMapFindWord(DynBitMap *dyn_bitmap, long index, int want_set)
+{
+	unsigned long long *word_ptr;
+	unsigned long long word;
+	long higher_seen;
+	long last_word;
+	long word_idx;
+	long found_idx;
+
+	higher_seen = dyn_bitmap->bitmap.higher_seen;
+
+	if (index < 0)
+		index = 0;
+
+	/* Above higher seen everything is clear */
+	if (index > higher_seen)
+		return (want_set ? -1 : index);
+
+	word_ptr	= DYNBITMAP_WORD_PTR(dyn_bitmap);
+	last_word	= (higher_seen >> 6);
+	word_idx	= (index >> 6);
+
+	/* Looking for a clear bit is looking for a set bit on inverted words */
+	word		= DYNBITMAP_WORD_HOST(word_ptr[word_idx]);
+	word		= ((want_set ? word : ~word) & (DYNBITMAP_WORD_ALL << (index & 63)));
+
+	while (1)
+	{
+		if (word)
+		{
+			found_idx = ((word_idx << 6) + __builtin_ctzll(word));
+
+			if (found_idx <= higher_seen)
+				return found_idx;
+
+			break;
+		}
+
+		if (++word_idx > last_word)
+			break;
+
+#if defined(__AVX2__)
+		/* Skip whole 256 bit blocks that are all zero, or all one when searching holes */
+		{
+			__m256i ones_vec = _mm256_set1_epi64x(-1);
+			__m256i block_vec;
+
+			for (; (word_idx + 4) <= (last_word + 1); word_idx += 4)
+			{
+				block_vec = _mm256_loadu_si256((const __m256i *)&word_ptr[word_idx]);
+
+				if (want_set ? (!_mm256_testz_si256(block_vec, block_vec)) : (!_mm256_testc_si256(block_vec, ones_vec)))
+					break;
+			}
+
+			if (word_idx > last_word)
+				break;
+		}
+#endif
+
+		word = DYNBITMAP_WORD_HOST(word_ptr[word_idx]);
+		word = (want_set ? word : ~word);
+		continue;
+	}
+
+	/* Nothing set up to higher seen, first hole is right after it */
+	return (want_set ? -1 : (higher_seen + 1));
+}
+/**************************************************************************************************************************/
+static long DynBitMapRangeApply(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish, int set_bits)
+{
+	unsigned long long *word_ptr;
+	unsigned long long word_mask;
+	unsigned long long old_word;
+	unsigned long long new_word;
+	long first_word;
+	long last_word;
+	long changed_count;
+	long i;
+
+	word_ptr		= DYNBITMAP_WORD_PTR(dyn_bitmap);
+	first_word		= (block_idx_begin >> 6);
+	last_word		= (block_idx_finish >> 6);
+	changed_count	= 0;
+
+	for (i = first_word; i <= last_word; i++)
+	{
+		word_mask = DYNBITMAP_WORD_ALL;
+
+		/* Trim edge words to range */
+		if (i == first_word)
+			word_mask &= (DYNBITMAP_WORD_ALL << (block_idx_begin & 63));
+
+		if (i == last_word)
+			word_mask &= (DYNBITMAP_WORD_ALL >> (63 - (block_idx_finish & 63)));
+
+		old_word		= DYNBITMAP_WORD_HOST(word_ptr[i]);
+		new_word		= (set_bits ? (old_word | word_mask) : (old_word & ~word_mask));
+		changed_count	+= __builtin_popcountll(old_word ^ new_word);
+		word_ptr[i]		= DYNBITMAP_WORD_HOST(new_word);
+	}
+
+	/* Keep counter in sync with flipped bits */
+	dyn_bitmap->bitmap.bitset_count += (set_bits ? changed_count : -changed_count);
+
+	return changed_count;
+}
+/**************************************************************************************************************************/
+static long DynBitMapPopCountWords(unsigned long long *word_ptr, long word_count)
+{
+	long bit_count = 0;
+	long i = 0;
+
+#if defined(__AVX2__)
+	/* Nibble lookup popcount, 256 bits per round, byte counts summed into 64 bit lanes */
+	{
+		__m256i lookup_vec	= _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+		__m256i nibble_vec	= _mm256_set1_epi8(0x0F);
+		__m256i acc_vec		= _mm256_setzero_si256();
+		__m256i block_vec;
+		__m256i count_vec;
+
+		for (; (i + 4) <= word_count; i += 4)
+		{
+			block_vec	= _mm256_loadu_si256((const __m256i *)&word_ptr[i]);
+			count_vec	= _mm256_add_epi8(_mm256_shuffle_epi8(lookup_vec, _mm256_and_si256(block_vec, nibble_vec)),
+					_mm256_shuffle_epi8(lookup_vec, _mm256_and_si256(_mm256_srli_epi16(block_vec, 4), nibble_vec)));
+			acc_vec		= _mm256_add_epi64(acc_vec, _mm256_sad_epu8(count_vec, _mm256_setzero_si256()));
+		}
+
+		bit_count += (_mm256_extract_epi64(acc_vec, 0) + _mm256_extract_epi64(acc_vec, 1) + _mm256_extract_epi64(acc_vec, 2) + _mm256_extract_epi64(acc_vec, 3));
+	}
+#endif
+
+	/* Scalar tail, or whole span when there is no SIMD */
+	for (; i < word_count; i++)
+		bit_count += __builtin_popcountll(word_ptr[i]);
+
+	return bit_count;
+}
+/**************************************************************************************************************************/
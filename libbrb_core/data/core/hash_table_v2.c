@@ -7,14 +7,38 @@
 
 #include "../include/libbrb_core.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /* Private internal functions */
 static void HashTableV2HashDecide(HashTableV2 *hash_table, HashTableConfig *config);
 static HashTableV2Item *HashTableV2BucketWalk(HashTableV2 *hash_table, HashTableBucket *bucket_ptr, char *key_ptr, int key_sz);
 
+/* SWISS mode private functions */
+static void HashTableV2SwissInit(HashTableV2 *hash_table, HashTableConfig *config);
+static void HashTableV2SwissDestroy(HashTableV2 *hash_table);
+static int HashTableV2SwissItemAdd(HashTableV2 *hash_table, HashTableV2Item *hash_item);
+static int HashTableV2SwissItemDel(HashTableV2 *hash_table, HashTableV2Item *hash_item);
+static HashTableV2Item *HashTableV2SwissItemFind(HashTableV2 *hash_table, char *key_ptr, int key_sz);
+static HashTableV2Shard *HashTableV2SwissShardLock(HashTableV2 *hash_table, unsigned int hash_val);
+static void HashTableV2SwissShardUnlock(HashTableV2 *hash_table, HashTableV2Shard *shard_ptr);
+static unsigned int HashTableV2SwissHashCalc(HashTableV2 *hash_table, char *key_ptr, int key_sz);
+static int HashTableV2SwissTableInit(HashTableV2SwissTable *table_ptr, unsigned int group_count);
+static void HashTableV2SwissTableFree(HashTableV2SwissTable *table_ptr);
+static HashTableV2Item *HashTableV2SwissTableFind(HashTableV2 *hash_table, HashTableV2SwissTable *table_ptr, unsigned int hash_val, char *key_ptr, int key_sz);
+static int HashTableV2SwissTableSlotFind(HashTableV2SwissTable *table_ptr, HashTableV2Item *hash_item);
+static int HashTableV2SwissTableInsert(HashTableV2SwissTable *table_ptr, HashTableV2Item *hash_item);
+static void HashTableV2SwissTableSlotErase(HashTableV2SwissTable *table_ptr, int slot_id);
+static int HashTableV2SwissGrowBegin(HashTableV2Shard *shard_ptr);
+static int HashTableV2SwissMigrateStep(HashTableV2Shard *shard_ptr, unsigned int group_count);
+static unsigned int HashTableV2SwissGroupMatch(signed char *ctrl_ptr, signed char tag);
+static unsigned int HashTableV2SwissGroupMatchFree(signed char *ctrl_ptr);
+
 /* Default private HASH and KEY CMP functions */
 static HashTableV2HashFunc HashTableV2HashFuncDefault;
 static HashTableV2HashFunc HashTableV2HashFuncMurMur;
+static uint32_t HashTableV2HashFuncFMIX32(uint32_t h);
 
 
 static HashTableV2KeyCmpFunc HashTableV2KeyCmpFuncDefault;
@@ -64,6 +88,15 @@ HashTableV2 *HashTableV2New(HashTableConfig *config)
 	hash_table->flags.key_match_sz		= (config ? config->flags.key_match_sz : 0);
 	hash_table->flags.thread_safe		= (config ? config->flags.thread_safe : 0);
 
+	hash_table->config.table_mode		= ((config && (config->table_mode > HASHTABLE_MODE_CHAINED) && (config->table_mode < HASHTABLE_MODE_LASTITEM)) ? config->table_mode : HASHTABLE_MODE_CHAINED);
+
+	/* SWISS mode does not use buckets */
+	if (HASHTABLE_MODE_SWISS == hash_table->config.table_mode)
+	{
+		HashTableV2SwissInit(hash_table, config);
+		return hash_table;
+	}
+
 	/* Finally create the buckets ARENA */
 	hash_table->buckets 		= MemArenaNew(128, (sizeof(HashTableBucket) + 1), 16, (hash_table->flags.thread_safe ? BRBDATA_THREAD_SAFE : BRBDATA_THREAD_UNSAFE));
 
@@ -77,7 +110,11 @@ int HashTableV2Destroy(HashTableV2 *hash_table)
 	if (!hash_table)
 		return 0;
 
-	MemArenaDestroy(hash_table->buckets);
+	if (HASHTABLE_MODE_SWISS == hash_table->config.table_mode)
+		HashTableV2SwissDestroy(hash_table);
+	else
+		MemArenaDestroy(hash_table->buckets);
+
 	free(hash_table);
 
 	return 1;
@@ -93,6 +130,16 @@ int HashTableV2ItemAdd(HashTableV2 *hash_table, HashTableV2Item *hash_item, void
 	if ((!hash_table) || (!hash_item))
 		return 0;
 
+	/* SWISS mode */
+	if (HASHTABLE_MODE_SWISS == hash_table->config.table_mode)
+	{
+		hash_item->data_ptr = data_ptr;
+		hash_item->key.ptr	= key_ptr;
+		hash_item->key.sz	= key_sz;
+
+		return HashTableV2SwissItemAdd(hash_table, hash_item);
+	}
+
 	/* Calculate the bucket ID and grab it from arena */
 	bucket_id	= (hash_table->func.hash(key_ptr, key_sz, 12345, hash_table->config.max_buckets)
 			% hash_table->config.max_buckets);
@@ -123,18 +170,25 @@ int HashTableV2ItemAdd(HashTableV2 *hash_table, HashTableV2Item *hash_item, void
 	hash_item->data_ptr = data_ptr;
 	hash_item->key.ptr	= key_ptr;
 	hash_item->key.sz	= key_sz;
+	hash_table->item_count++;
 
 	return 1;
 }
 /**************************************************************************************************************************/
 int HashTableV2ItemDel(HashTableV2 *hash_table, HashTableV2Item *hash_item)
 {
-	HashTableBucket *bucket = hash_item->bucket;
+	HashTableBucket *bucket;
 
 	/* Sanity check */
 	if ((!hash_table) || (!hash_item))
 		return 0;
 
+	/* SWISS mode */
+	if (HASHTABLE_MODE_SWISS == hash_table->config.table_mode)
+		return HashTableV2SwissItemDel(hash_table, hash_item);
+
+	bucket = hash_item->bucket;
+
 	/* Not on hash */
 	if (!hash_item->bucket)
 		return 0;
@@ -151,6 +205,7 @@ int HashTableV2ItemDel(HashTableV2 *hash_table, HashTableV2Item *hash_item)
 	if (!bucket->list.head)
 		MemArenaReleaseByID(hash_table->buckets, bucket->id);
 
+	hash_table->item_count--;
 	return 1;
 }
 /**************************************************************************************************************************/
@@ -164,6 +219,10 @@ HashTableV2Item *HashTableV2ItemFind(HashTableV2 *hash_table, char *key_ptr, int
 	if ((!hash_table) || (!key_ptr))
 		return NULL;
 
+	/* SWISS mode */
+	if (HASHTABLE_MODE_SWISS == hash_table->config.table_mode)
+		return HashTableV2SwissItemFind(hash_table, key_ptr, key_sz);
+
 	/* Calculate the bucket ID and grab it from arena */
 	bucket_id	= (hash_table->func.hash(key_ptr, key_sz, 12345, hash_table->config.max_buckets)
 			% hash_table->config.max_buckets);
@@ -180,6 +239,30 @@ HashTableV2Item *HashTableV2ItemFind(HashTableV2 *hash_table, char *key_ptr, int
 	return hash_item;
 }
 /**************************************************************************************************************************/
+unsigned long HashTableV2ItemCount(HashTableV2 *hash_table)
+{
+	HashTableV2Shard *shard_ptr;
+	unsigned long item_count;
+	int i;
+
+	/* Sanity check */
+	if (!hash_table)
+		return 0;
+
+	/* CHAINED mode */
+	if (HASHTABLE_MODE_SWISS != hash_table->config.table_mode)
+		return hash_table->item_count;
+
+	/* Sum all shards, without locking - Its a snapshot anyway */
+	for (item_count = 0, i = 0; i < hash_table->swiss.shard_count; i++)
+	{
+		shard_ptr	= &hash_table->swiss.shard_arr[i];
+		item_count	+= (shard_ptr->cur.item_count + shard_ptr->old.item_count);
+	}
+
+	return item_count;
+}
+/**************************************************************************************************************************/
 /**/
 /**/
 /**************************************************************************************************************************/
@@ -245,6 +328,467 @@ static HashTableV2Item *HashTableV2BucketWalk(HashTableV2 *hash_table, HashTable
 /**/
 /**/
 /**************************************************************************************************************************/
+static void HashTableV2SwissInit(HashTableV2 *hash_table, HashTableConfig *config)
+{
+	HashTableV2Shard *shard_ptr;
+	unsigned int shard_count;
+	unsigned int group_count;
+	unsigned int group_min;
+	int i;
+
+	/* Thread safe tables are sharded by default, so threads working on different keys do not fight for one MUTEX */
+	shard_count = ((config && (config->shard_count > 0)) ? config->shard_count : (hash_table->flags.thread_safe ? HASHTABLE_V2_SHARD_DEFAULT : 1));
+	shard_count = ((shard_count > HASHTABLE_V2_SHARD_MAX) ? HASHTABLE_V2_SHARD_MAX : shard_count);
+
+	/* Round up to a power of two */
+	for (hash_table->swiss.shard_count = 1, hash_table->swiss.shard_bits = 0; hash_table->swiss.shard_count < shard_count; hash_table->swiss.shard_bits++)
+		hash_table->swiss.shard_count <<= 1;
+
+	/* MAX_BUCKETS, when given, is used as an initial capacity hint split across shards */
+	group_min = ((config && (config->max_buckets > 0)) ? (config->max_buckets / hash_table->swiss.shard_count / HASHTABLE_V2_SWISS_GROUP_SZ) : 0);
+
+	for (group_count = HASHTABLE_V2_SWISS_GROUPS_MIN; group_count < group_min; group_count <<= 1)
+		continue;
+
+	hash_table->swiss.shard_arr = calloc(hash_table->swiss.shard_count, sizeof(HashTableV2Shard));
+
+	/* Initialize shards */
+	for (i = 0; i < hash_table->swiss.shard_count; i++)
+	{
+		shard_ptr = &hash_table->swiss.shard_arr[i];
+
+		pthread_mutex_init(&shard_ptr->mutex, NULL);
+		HashTableV2SwissTableInit(&shard_ptr->cur, group_count);
+		continue;
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void HashTableV2SwissDestroy(HashTableV2 *hash_table)
+{
+	HashTableV2Shard *shard_ptr;
+	int i;
+
+	/* Release shards */
+	for (i = 0; i < hash_table->swiss.shard_count; i++)
+	{
+		shard_ptr = &hash_table->swiss.shard_arr[i];
+
+		HashTableV2SwissTableFree(&shard_ptr->cur);
+		HashTableV2SwissTableFree(&shard_ptr->old);
+		pthread_mutex_destroy(&shard_ptr->mutex);
+		continue;
+	}
+
+	free(hash_table->swiss.shard_arr);
+	hash_table->swiss.shard_arr		= NULL;
+	hash_table->swiss.shard_count	= 0;
+
+	return;
+}
+/**************************************************************************************************************************/
+static int HashTableV2SwissItemAdd(HashTableV2 *hash_table, HashTableV2Item *hash_item)
+{
+	HashTableV2Shard *shard_ptr;
+
+	/* Already on a table */
+	if (hash_item->flags.active)
+		return 0;
+
+	hash_item->hash_val	= HashTableV2SwissHashCalc(hash_table, hash_item->key.ptr, hash_item->key.sz);
+	shard_ptr			= HashTableV2SwissShardLock(hash_table, hash_item->hash_val);
+
+	/* Check for duplicates on both tables */
+	if ((hash_table->flags.item_check_dup) &&
+			((HashTableV2SwissTableFind(hash_table, &shard_ptr->cur, hash_item->hash_val, hash_item->key.ptr, hash_item->key.sz)) ||
+					(HashTableV2SwissTableFind(hash_table, &shard_ptr->old, hash_item->hash_val, hash_item->key.ptr, hash_item->key.sz))))
+	{
+		HashTableV2SwissShardUnlock(hash_table, shard_ptr);
+		return 0;
+	}
+
+	/* Out of room, start growing - OLD will be drained a few groups per operation */
+	if (shard_ptr->cur.growth_left == 0)
+		HashTableV2SwissGrowBegin(shard_ptr);
+
+	/* No free slot left and growing failed, refuse item */
+	if (HashTableV2SwissTableInsert(&shard_ptr->cur, hash_item) < 0)
+	{
+		HashTableV2SwissShardUnlock(hash_table, shard_ptr);
+		return 0;
+	}
+
+	hash_item->flags.active = 1;
+
+	HashTableV2SwissShardUnlock(hash_table, shard_ptr);
+	return 1;
+}
+/**************************************************************************************************************************/
+static int HashTableV2SwissItemDel(HashTableV2 *hash_table, HashTableV2Item *hash_item)
+{
+	HashTableV2Shard *shard_ptr;
+	int slot_id;
+
+	/* Not on hash */
+	if (!hash_item->flags.active)
+		return 0;
+
+	shard_ptr = HashTableV2SwissShardLock(hash_table, hash_item->hash_val);
+
+	/* Item may be on either table while migrating */
+	if ((slot_id = HashTableV2SwissTableSlotFind(&shard_ptr->cur, hash_item)) >= 0)
+		HashTableV2SwissTableSlotErase(&shard_ptr->cur, slot_id);
+	else if ((slot_id = HashTableV2SwissTableSlotFind(&shard_ptr->old, hash_item)) >= 0)
+		HashTableV2SwissTableSlotErase(&shard_ptr->old, slot_id);
+
+	HashTableV2SwissShardUnlock(hash_table, shard_ptr);
+
+	/* Reset pointers */
+	hash_item->key.ptr		= NULL;
+	hash_item->key.sz		= 0;
+	hash_item->flags.active	= 0;
+
+	return ((slot_id >= 0) ? 1 : 0);
+}
+/**************************************************************************************************************************/
+static HashTableV2Item *HashTableV2SwissItemFind(HashTableV2 *hash_table, char *key_ptr, int key_sz)
+{
+	HashTableV2Shard *shard_ptr;
+	HashTableV2Item *hash_item;
+	unsigned int hash_val;
+
+	hash_val	= HashTableV2SwissHashCalc(hash_table, key_ptr, key_sz);
+	shard_ptr	= HashTableV2SwissShardLock(hash_table, hash_val);
+
+	/* Look on CUR first, then on OLD if still migrating */
+	hash_item	= HashTableV2SwissTableFind(hash_table, &shard_ptr->cur, hash_val, key_ptr, key_sz);
+
+	if ((!hash_item) && (shard_ptr->old.ctrl_arr))
+		hash_item = HashTableV2SwissTableFind(hash_table, &shard_ptr->old, hash_val, key_ptr, key_sz);
+
+	HashTableV2SwissShardUnlock(hash_table, shard_ptr);
+	return hash_item;
+}
+/**************************************************************************************************************************/
+static HashTableV2Shard *HashTableV2SwissShardLock(HashTableV2 *hash_table, unsigned int hash_val)
+{
+	HashTableV2Shard *shard_ptr;
+
+	/* Shard on upper bits of a multiplicative mix, so it does not correlate with TAG or GROUP bits */
+	shard_ptr = &hash_table->swiss.shard_arr[(hash_table->swiss.shard_bits ? ((hash_val * 0x9E3779B1U) >> (32 - hash_table->swiss.shard_bits)) : 0)];
+
+	if (hash_table->flags.thread_safe)
+		pthread_mutex_lock(&shard_ptr->mutex);
+
+	/* Drain a few groups of OLD table on every operation */
+	if (shard_ptr->old.ctrl_arr)
+		HashTableV2SwissMigrateStep(shard_ptr, HASHTABLE_V2_SWISS_MIGRATE_GROUPS);
+
+	return shard_ptr;
+}
+/**************************************************************************************************************************/
+static void HashTableV2SwissShardUnlock(HashTableV2 *hash_table, HashTableV2Shard *shard_ptr)
+{
+	if (hash_table->flags.thread_safe)
+		pthread_mutex_unlock(&shard_ptr->mutex);
+
+	return;
+}
+/**************************************************************************************************************************/
+static unsigned int HashTableV2SwissHashCalc(HashTableV2 *hash_table, char *key_ptr, int key_sz)
+{
+	/* Ask for full range and mix it, lower 7 bits become the TAG and upper bits the GROUP */
+	return HashTableV2HashFuncFMIX32(hash_table->func.hash(key_ptr, key_sz, 12345, 0x7FFFFFFF));
+}
+/**************************************************************************************************************************/
+static int HashTableV2SwissTableInit(HashTableV2SwissTable *table_ptr, unsigned int group_count)
+{
+	unsigned int slot_count = (group_count * HASHTABLE_V2_SWISS_GROUP_SZ);
+
+	table_ptr->ctrl_arr		= malloc(slot_count);
+	table_ptr->slot_arr		= calloc(slot_count, sizeof(HashTableV2Item*));
+
+	/* Failed allocating */
+	if ((!table_ptr->ctrl_arr) || (!table_ptr->slot_arr))
+	{
+		HashTableV2SwissTableFree(table_ptr);
+		return 0;
+	}
+
+	/* Keep load factor at 7/8 */
+	memset(table_ptr->ctrl_arr, HASHTABLE_V2_SWISS_CTRL_EMPTY, slot_count);
+	table_ptr->group_mask	= (group_count - 1);
+	table_ptr->item_count	= 0;
+	table_ptr->growth_left	= (slot_count - (slot_count / 8));
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static void HashTableV2SwissTableFree(HashTableV2SwissTable *table_ptr)
+{
+	free(table_ptr->ctrl_arr);
+	free(table_ptr->slot_arr);
+	memset(table_ptr, 0, sizeof(HashTableV2SwissTable));
+
+	return;
+}
+/**************************************************************************************************************************/
+static HashTableV2Item *HashTableV2SwissTableFind(HashTableV2 *hash_table, HashTableV2SwissTable *table_ptr, unsigned int hash_val, char *key_ptr, int key_sz)
+{
+	HashTableV2Item *hash_item;
+	signed char *ctrl_ptr;
+	unsigned int group_id;
+	unsigned int match_mask;
+	unsigned int bit_id;
+	unsigned int i;
+
+	/* Table not allocated */
+	if (!table_ptr->ctrl_arr)
+		return NULL;
+
+	/* Triangular probing over groups visits every group once when group count is a power of two */
+	for (group_id = ((hash_val >> 7) & table_ptr->group_mask), i = 0; i <= table_ptr->group_mask; i++, group_id = ((group_id + i) & table_ptr->group_mask))
+	{
+		ctrl_ptr	= &table_ptr->ctrl_arr[group_id * HASHTABLE_V2_SWISS_GROUP_SZ];
+		match_mask	= HashTableV2SwissGroupMatch(ctrl_ptr, (hash_val & 0x7F));
+
+		/* Walk matching TAGs */
+		while (match_mask)
+		{
+			bit_id		= __builtin_ctz(match_mask);
+			match_mask	&= (match_mask - 1);
+			hash_item	= table_ptr->slot_arr[(group_id * HASHTABLE_V2_SWISS_GROUP_SZ) + bit_id];
+
+			/* Full hash differs, ignore */
+			if (hash_item->hash_val != hash_val)
+				continue;
+
+			/* Key size differs, ignore */
+			if ((hash_table->flags.key_match_sz) && (hash_item->key.sz != key_sz))
+				continue;
+
+			/* Item found */
+			if (hash_table->func.key_cmp(hash_item, key_ptr, key_sz))
+				return hash_item;
+
+			continue;
+		}
+
+		/* A group with an EMPTY slot ends the probe sequence */
+		if (HashTableV2SwissGroupMatch(ctrl_ptr, HASHTABLE_V2_SWISS_CTRL_EMPTY))
+			break;
+
+		continue;
+	}
+
+	return NULL;
+}
+/**************************************************************************************************************************/
+static int HashTableV2SwissTableSlotFind(HashTableV2SwissTable *table_ptr, HashTableV2Item *hash_item)
+{
+	signed char *ctrl_ptr;
+	unsigned int group_id;
+	unsigned int match_mask;
+	unsigned int slot_id;
+	unsigned int i;
+
+	/* Table not allocated */
+	if (!table_ptr->ctrl_arr)
+		return -1;
+
+	/* Same probe sequence as FIND, but matching by item pointer */
+	for (group_id = ((hash_item->hash_val >> 7) & table_ptr->group_mask), i = 0; i <= table_ptr->group_mask; i++, group_id = ((group_id + i) & table_ptr->group_mask))
+	{
+		ctrl_ptr	= &table_ptr->ctrl_arr[group_id * HASHTABLE_V2_SWISS_GROUP_SZ];
+		match_mask	= HashTableV2SwissGroupMatch(ctrl_ptr, (hash_item->hash_val & 0x7F));
+
+		while (match_mask)
+		{
+			slot_id		= ((group_id * HASHTABLE_V2_SWISS_GROUP_SZ) + __builtin_ctz(match_mask));
+			match_mask	&= (match_mask - 1);
+
+			if (table_ptr->slot_arr[slot_id] == hash_item)
+				return slot_id;
+
+			continue;
+		}
+
+		/* A group with an EMPTY slot ends the probe sequence */
+		if (HashTableV2SwissGroupMatch(ctrl_ptr, HASHTABLE_V2_SWISS_CTRL_EMPTY))
+			break;
+
+		continue;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+static int HashTableV2SwissTableInsert(HashTableV2SwissTable *table_ptr, HashTableV2Item *hash_item)
+{
+	signed char *ctrl_ptr;
+	unsigned int group_id;
+	unsigned int free_mask;
+	unsigned int slot_id;
+	unsigned int i;
+
+	/* Table not allocated */
+	if (!table_ptr->ctrl_arr)
+		return -1;
+
+	/* Take first EMPTY or DELETED slot on probe sequence */
+	for (group_id = ((hash_item->hash_val >> 7) & table_ptr->group_mask), i = 0; i <= table_ptr->group_mask; i++, group_id = ((group_id + i) & table_ptr->group_mask))
+	{
+		ctrl_ptr	= &table_ptr->ctrl_arr[group_id * HASHTABLE_V2_SWISS_GROUP_SZ];
+		free_mask	= HashTableV2SwissGroupMatchFree(ctrl_ptr);
+
+		/* Group is full, probe next */
+		if (!free_mask)
+			continue;
+
+		slot_id = ((group_id * HASHTABLE_V2_SWISS_GROUP_SZ) + __builtin_ctz(free_mask));
+
+		/* Reusing a DELETED slot does not consume growth */
+		if ((HASHTABLE_V2_SWISS_CTRL_EMPTY == table_ptr->ctrl_arr[slot_id]) && (table_ptr->growth_left > 0))
+			table_ptr->growth_left--;
+
+		table_ptr->ctrl_arr[slot_id] = (hash_item->hash_val & 0x7F);
+		table_ptr->slot_arr[slot_id] = hash_item;
+		table_ptr->item_count++;
+		return slot_id;
+	}
+
+	/* Every slot is taken */
+	return -1;
+}
+/**************************************************************************************************************************/
+static void HashTableV2SwissTableSlotErase(HashTableV2SwissTable *table_ptr, int slot_id)
+{
+	signed char *ctrl_ptr = &table_ptr->ctrl_arr[slot_id & ~(HASHTABLE_V2_SWISS_GROUP_SZ - 1)];
+
+	/* If group still has an EMPTY, no probe sequence goes through it, so slot can go back to EMPTY */
+	if (HashTableV2SwissGroupMatch(ctrl_ptr, HASHTABLE_V2_SWISS_CTRL_EMPTY))
+	{
+		table_ptr->ctrl_arr[slot_id] = HASHTABLE_V2_SWISS_CTRL_EMPTY;
+		table_ptr->growth_left++;
+	}
+	else
+		table_ptr->ctrl_arr[slot_id] = HASHTABLE_V2_SWISS_CTRL_DELETED;
+
+	table_ptr->slot_arr[slot_id] = NULL;
+	table_ptr->item_count--;
+
+	return;
+}
+/**************************************************************************************************************************/
+static int HashTableV2SwissGrowBegin(HashTableV2Shard *shard_ptr)
+{
+	unsigned int slot_count;
+	unsigned int group_count;
+
+	/* Previous migration still running, finish it now - If CUR can not take it all, OLD must stay */
+	if ((shard_ptr->old.ctrl_arr) && (!HashTableV2SwissMigrateStep(shard_ptr, (shard_ptr->old.group_mask + 1))))
+		return 0;
+
+	slot_count	= ((shard_ptr->cur.group_mask + 1) * HASHTABLE_V2_SWISS_GROUP_SZ);
+	group_count	= (shard_ptr->cur.group_mask + 1);
+
+	/* Mostly tombstones, rehash at same size. Otherwise double it */
+	if (shard_ptr->cur.item_count >= (slot_count / 2))
+		group_count <<= 1;
+
+	/* Current table becomes OLD */
+	memcpy(&shard_ptr->old, &shard_ptr->cur, sizeof(HashTableV2SwissTable));
+	shard_ptr->migrate_group = 0;
+
+	/* Failed allocating new table, keep using OLD one and let it overflow into DELETED slots */
+	if (!HashTableV2SwissTableInit(&shard_ptr->cur, group_count))
+	{
+		memcpy(&shard_ptr->cur, &shard_ptr->old, sizeof(HashTableV2SwissTable));
+		memset(&shard_ptr->old, 0, sizeof(HashTableV2SwissTable));
+		return 0;
+	}
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static int HashTableV2SwissMigrateStep(HashTableV2Shard *shard_ptr, unsigned int group_count)
+{
+	HashTableV2SwissTable *old_table = &shard_ptr->old;
+	unsigned int slot_id;
+	unsigned int i;
+
+	/* Move every live slot of next GROUP_COUNT groups into CUR */
+	for (; (group_count > 0) && (shard_ptr->migrate_group <= old_table->group_mask) && (old_table->item_count > 0); group_count--, shard_ptr->migrate_group++)
+	{
+		for (i = 0; i < HASHTABLE_V2_SWISS_GROUP_SZ; i++)
+		{
+			slot_id = ((shard_ptr->migrate_group * HASHTABLE_V2_SWISS_GROUP_SZ) + i);
+
+			/* Not a live slot */
+			if (old_table->ctrl_arr[slot_id] < 0)
+				continue;
+
+			/* CUR is full, leave item on OLD and retry on a later step */
+			if (HashTableV2SwissTableInsert(&shard_ptr->cur, old_table->slot_arr[slot_id]) < 0)
+				return 0;
+
+			old_table->ctrl_arr[slot_id] = HASHTABLE_V2_SWISS_CTRL_DELETED;
+			old_table->slot_arr[slot_id] = NULL;
+			old_table->item_count--;
+			continue;
+		}
+
+		continue;
+	}
+
+	/* OLD drained, release it */
+	if ((old_table->item_count == 0) || (shard_ptr->migrate_group > old_table->group_mask))
+	{
+		HashTableV2SwissTableFree(old_table);
+		shard_ptr->migrate_group = 0;
+	}
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static unsigned int HashTableV2SwissGroupMatch(signed char *ctrl_ptr, signed char tag)
+{
+#if defined(__SSE2__)
+	/* Compare all 16 TAGs at once */
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)ctrl_ptr), _mm_set1_epi8(tag)));
+#else
+	unsigned int match_mask = 0;
+	int i;
+
+	for (i = 0; i < HASHTABLE_V2_SWISS_GROUP_SZ; i++)
+		if (ctrl_ptr[i] == tag)
+			match_mask |= (1U << i);
+
+	return match_mask;
+#endif
+}
+/**************************************************************************************************************************/
+static unsigned int HashTableV2SwissGroupMatchFree(signed char *ctrl_ptr)
+{
+#if defined(__SSE2__)
+	/* EMPTY and DELETED are the only control bytes below -1 */
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), _mm_loadu_si128((const __m128i *)ctrl_ptr)));
+#else
+	unsigned int match_mask = 0;
+	int i;
+
+	for (i = 0; i < HASHTABLE_V2_SWISS_GROUP_SZ; i++)
+		if (ctrl_ptr[i] < -1)
+			match_mask |= (1U << i);
+
+	return match_mask;
+#endif
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
 static unsigned int HashTableV2KeyCmpFuncDefault(void *hash_item_ptr, char *key_ptr, int key_sz)
 {
 	HashTableV2Item *hash_item = hash_item_ptr;
@@ -36,6 +36,13 @@
 
 static void MemArenaSlotHeaderInit(MemArena *mem_arena, MemArenaSlotHeader *header, long slot_id);
 static void MemArenaSlotHeaderClean(MemArenaSlotHeader *header);
+static MemArenaSlotHeader *MemArenaConcurrentPageGrab(MemArena *mem_arena, long arena_id, int create);
+static void *MemArenaConcurrentSlotPtr(MemArena *mem_arena, MemArenaSlotHeader *header, long slot_offset);
+static void *MemArenaConcurrentFindByID(MemArena *mem_arena, long id);
+static void *MemArenaConcurrentGrabByID(MemArena *mem_arena, long id);
+static void MemArenaConcurrentReleaseByID(MemArena *mem_arena, long id);
+static void MemArenaConcurrentClean(MemArena *mem_arena);
+static void MemArenaConcurrentDestroy(MemArena *mem_arena);
 
 /**************************************************************************************************************************/
 /* Context arena control functions
@@ -43,9 +50,10 @@ static void MemArenaSlotHeaderClean(MemArenaSlotHeader *header);
 MemArena *MemArenaNew(long arena_size, long slot_size, long slot_count, int type)
 {
 	MemArena *mem_arena = calloc(1, sizeof(MemArena));
+	int i;
 
-	/* Initialize data arena */
-	mem_arena->data							= calloc(arena_size + 1, sizeof(void*));
+	/* Initialize data arena, concurrent mode uses chunked directory instead of a flat page table */
+	mem_arena->data							= ((MEMARENA_MT_CONCURRENT == type) ? NULL : calloc(arena_size + 1, sizeof(void*)));
 	mem_arena->mutex						= (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
 
 	mem_arena->size[MEMARENA_SIZE_CAPACITY]	= arena_size;
@@ -59,6 +67,20 @@ MemArena *MemArenaNew(long arena_size, long slot_size, long slot_count, int type
 	if (BRBDATA_THREAD_SAFE == type)
 		mem_arena->flags.thread_safe = 1;
 
+	/* Running CONCURRENT, no mutex at all. Pages are published with CAS and never move */
+	else if (MEMARENA_MT_CONCURRENT == type)
+	{
+		mem_arena->flags.concurrent				= 1;
+		mem_arena->concurrent.dir				= calloc(MEMARENA_DIR_CHUNK_MAX, sizeof(char **));
+		mem_arena->concurrent.magazine_arr		= calloc(MEMARENA_MAGAZINE_MAX, sizeof(MemArenaMagazine));
+
+		for (i = 0; i < MEMARENA_MAGAZINE_MAX; i++)
+		{
+			mem_arena->concurrent.magazine_arr[i].local_head	= -1;
+			mem_arena->concurrent.magazine_arr[i].remote_head	= -1;
+		}
+	}
+
 	return mem_arena;
 }
 /**************************************************************************************************************************/
@@ -72,6 +94,13 @@ void MemArenaClean(MemArena *mem_arena)
 	if (!mem_arena)
 		return;
 
+	/* Running CONCURRENT, walk page directory */
+	if (mem_arena->flags.concurrent)
+	{
+		MemArenaConcurrentClean(mem_arena);
+		return;
+	}
+
 	/* Running THREAD_SAFE, LOCK MUTEX */
 	if (mem_arena->flags.thread_safe)
 		MUTEX_LOCK(mem_arena->mutex, "MEM_ARENA");
@@ -108,6 +137,13 @@ void MemArenaDestroy(MemArena *mem_arena)
 	if (!mem_arena)
 		return;
 
+	/* Running CONCURRENT, walk page directory */
+	if (mem_arena->flags.concurrent)
+	{
+		MemArenaConcurrentDestroy(mem_arena);
+		return;
+	}
+
 	/* Free all arenas */
 	for (i = 0; i < mem_arena->size[MEMARENA_SIZE_CAPACITY]; i++)
 	{
@@ -149,6 +185,10 @@ void *MemArenaFindByID(MemArena *mem_arena, long id)
 	if (!mem_arena)
 		return NULL;
 
+	/* Running CONCURRENT, lock free path */
+	if (mem_arena->flags.concurrent)
+		return MemArenaConcurrentFindByID(mem_arena, id);
+
 	/* Running THREAD_SAFE, LOCK MUTEX */
 	if (mem_arena->flags.thread_safe)
 		MUTEX_LOCK(mem_arena->mutex, "MEM_ARENA");
@@ -206,6 +246,10 @@ void *MemArenaGrabByID(MemArena *mem_arena, long id)
 	if (!mem_arena)
 		return NULL;
 
+	/* Running CONCURRENT, lock free path */
+	if (mem_arena->flags.concurrent)
+		return MemArenaConcurrentGrabByID(mem_arena, id);
+
 	/* Running THREAD_SAFE, LOCK MUTEX */
 	if (mem_arena->flags.thread_safe)
 		MUTEX_LOCK(mem_arena->mutex, "MEM_ARENA");
@@ -278,6 +322,13 @@ void MemArenaReleaseByID(MemArena *mem_arena, long id)
 	if (!mem_arena)
 		return;
 
+	/* Running CONCURRENT, lock free path */
+	if (mem_arena->flags.concurrent)
+	{
+		MemArenaConcurrentReleaseByID(mem_arena, id);
+		return;
+	}
+
 	/* Running THREAD_SAFE, LOCK MUTEX */
 	if (mem_arena->flags.thread_safe)
 		MUTEX_LOCK(mem_arena->mutex, "MEM_ARENA");
@@ -314,18 +365,31 @@ void MemArenaReleaseByID(MemArena *mem_arena, long id)
 	return;
 }
 /**************************************************************************************************************************/
-void MemArenaLockByID(MemArena *mem_arena, long id)
+int MemArenaLockByID(MemArena *mem_arena, long id)
 {
 	MemArenaSlotHeader *header;
 	long arena_id;
 
 	/* Sanity check */
 	if (id < 0)
-		return;
+		return 0;
 
 	/* Sanity check */
 	if (!mem_arena)
-		return;
+		return 0;
+
+	/* Running CONCURRENT, pages are never freed, just account */
+	if (mem_arena->flags.concurrent)
+	{
+		header = MemArenaConcurrentPageGrab(mem_arena, (id / mem_arena->slot[MEMARENA_SLOT_COUNT]), 0);
+
+		/* Page never created, nothing to lock */
+		if (!header)
+			return -1;
+
+		__atomic_add_fetch(&header->busy_count, 1, __ATOMIC_ACQ_REL);
+		return 1;
+	}
 
 	/* Running THREAD_SAFE, LOCK MUTEX */
 	if (mem_arena->flags.thread_safe)
@@ -347,7 +411,7 @@ void MemArenaLockByID(MemArena *mem_arena, long id)
 	if (mem_arena->flags.thread_safe)
 		MUTEX_UNLOCK(mem_arena->mutex, "MEM_ARENA");
 
-	return;
+	return 1;
 }
 /**************************************************************************************************************************/
 int MemArenaToJsonMemBuffer(MemArena *mem_arena, MemBuffer *json_reply_mb)
@@ -386,6 +450,19 @@ int MemArenaUnlockByID(MemArena *mem_arena, long id)
 	if (!mem_arena)
 		return 0;
 
+	/* Running CONCURRENT, pages stay resident so bucket is never destroyed */
+	if (mem_arena->flags.concurrent)
+	{
+		header = MemArenaConcurrentPageGrab(mem_arena, (id / mem_arena->slot[MEMARENA_SLOT_COUNT]), 0);
+
+		/* Page never created, nothing to unlock */
+		if (!header)
+			return -1;
+
+		__atomic_sub_fetch(&header->busy_count, 1, __ATOMIC_ACQ_REL);
+		return 0;
+	}
+
 	/* Running THREAD_SAFE, LOCK MUTEX */
 	if (mem_arena->flags.thread_safe)
 		MUTEX_LOCK(mem_arena->mutex, "MEM_ARENA");
@@ -508,6 +585,140 @@ long MemArenaGetSlotActiveCount(MemArena *mem_arena)
 	return result;
 }
 /**************************************************************************************************************************/
+/* Concurrent mode ID allocation - per thread magazines
+/**************************************************************************************************************************/
+int MemArenaMagazineRegister(MemArena *mem_arena)
+{
+	int expected;
+	int i;
+
+	/* Sanity check */
+	if ((!mem_arena) || (!mem_arena->flags.concurrent))
+		return -1;
+
+	/* Free IDs left by previous owner stay on the magazine and get reused */
+	for (i = 0; i < MEMARENA_MAGAZINE_MAX; i++)
+	{
+		expected = 0;
+
+		if (__atomic_compare_exchange_n(&mem_arena->concurrent.magazine_arr[i].in_use, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+			return i;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+void MemArenaMagazineUnregister(MemArena *mem_arena, int magazine_id)
+{
+	/* Sanity check */
+	if ((!mem_arena) || (!mem_arena->flags.concurrent) || (magazine_id < 0) || (magazine_id >= MEMARENA_MAGAZINE_MAX))
+		return;
+
+	__atomic_store_n(&mem_arena->concurrent.magazine_arr[magazine_id].in_use, 0, __ATOMIC_RELEASE);
+	return;
+}
+/**************************************************************************************************************************/
+void *MemArenaSlotGrab(MemArena *mem_arena, int magazine_id, long *ret_id)
+{
+	MemArenaSlotHeader *header;
+	MemArenaMagazine *magazine;
+	void *ret_ptr;
+	long slot_offset;
+	long id;
+
+	/* Sanity check */
+	if ((!mem_arena) || (!mem_arena->flags.concurrent) || (magazine_id < 0) || (magazine_id >= MEMARENA_MAGAZINE_MAX))
+		return NULL;
+
+	magazine	= &mem_arena->concurrent.magazine_arr[magazine_id];
+	id			= magazine->local_head;
+
+	/* Local list empty, take everything other threads gave back to us in one shot */
+	if (id < 0)
+	{
+		id						= __atomic_exchange_n(&magazine->remote_head, -1, __ATOMIC_ACQUIRE);
+		magazine->local_head	= id;
+	}
+
+	/* Pop from local list, page is resident since this ID was grabbed before */
+	if (id >= 0)
+	{
+		header					= MemArenaConcurrentPageGrab(mem_arena, (id / mem_arena->slot[MEMARENA_SLOT_COUNT]), 0);
+		slot_offset				= (id % mem_arena->slot[MEMARENA_SLOT_COUNT]);
+		magazine->local_head	= header->free_link[slot_offset];
+	}
+	/* Nothing to reuse, carve a batch of never used IDs */
+	else
+	{
+		if (magazine->fresh_next >= magazine->fresh_last)
+		{
+			magazine->fresh_next	= __atomic_fetch_add(&mem_arena->concurrent.id_next, MEMARENA_ID_BATCH_SZ, __ATOMIC_RELAXED);
+			magazine->fresh_last	= (magazine->fresh_next + MEMARENA_ID_BATCH_SZ);
+		}
+
+		id = magazine->fresh_next++;
+	}
+
+	ret_ptr = MemArenaConcurrentGrabByID(mem_arena, id);
+
+	/* Directory exhausted */
+	if (!ret_ptr)
+		return NULL;
+
+	/* Remember who owns this ID, remote frees are handed back to this magazine */
+	header			= MemArenaConcurrentPageGrab(mem_arena, (id / mem_arena->slot[MEMARENA_SLOT_COUNT]), 0);
+	slot_offset		= (id % mem_arena->slot[MEMARENA_SLOT_COUNT]);
+	header->free_owner[slot_offset] = magazine_id;
+
+	if (ret_id)
+		*ret_id = id;
+
+	return ret_ptr;
+}
+/**************************************************************************************************************************/
+void MemArenaSlotRelease(MemArena *mem_arena, int magazine_id, long id)
+{
+	MemArenaSlotHeader *header;
+	MemArenaMagazine *owner_magazine;
+	long slot_offset;
+	long remote_head;
+	int owner_id;
+
+	/* Sanity check */
+	if ((!mem_arena) || (!mem_arena->flags.concurrent) || (id < 0))
+		return;
+
+	header			= MemArenaConcurrentPageGrab(mem_arena, (id / mem_arena->slot[MEMARENA_SLOT_COUNT]), 0);
+
+	/* Page never created, this ID was never grabbed */
+	if (!header)
+		return;
+
+	MemArenaConcurrentReleaseByID(mem_arena, id);
+
+	slot_offset		= (id % mem_arena->slot[MEMARENA_SLOT_COUNT]);
+	owner_id		= header->free_owner[slot_offset];
+	owner_magazine	= &mem_arena->concurrent.magazine_arr[owner_id];
+
+	/* Local free, no atomics */
+	if (owner_id == magazine_id)
+	{
+		header->free_link[slot_offset]	= owner_magazine->local_head;
+		owner_magazine->local_head		= id;
+		return;
+	}
+
+	/* Remote free, push into owner stack. Owner only ever takes the whole stack, so there is no ABA */
+	remote_head = __atomic_load_n(&owner_magazine->remote_head, __ATOMIC_RELAXED);
+
+	do
+	{
+		header->free_link[slot_offset] = remote_head;
+	} while (!__atomic_compare_exchange_n(&owner_magazine->remote_head, &remote_head, id, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	return;
+}
+/**************************************************************************************************************************/
 /**/
 /**/
 /**************************************************************************************************************************/
@@ -542,5 +753,228 @@ static void MemArenaSlotHeaderClean(MemArenaSlotHeader *header)
 	return;
 }
 /**************************************************************************************************************************/
+static MemArenaSlotHeader *MemArenaConcurrentPageGrab(MemArena *mem_arena, long arena_id, int create)
+{
+	MemArenaSlotHeader *header;
+	char **chunk_ptr;
+	char **new_chunk;
+	char *page_ptr;
+	char *expected_page;
+	char **expected_chunk;
+	long chunk_idx;
+	long page_idx;
+	long slot_count;
+	long area_cap;
+	long bits_off;
+	long link_off;
+	long owner_off;
+	long capacity;
+
+	chunk_idx	= (arena_id / MEMARENA_DIR_CHUNK_SZ);
+	page_idx	= (arena_id % MEMARENA_DIR_CHUNK_SZ);
+
+	/* Sanity check */
+	if ((arena_id < 0) || (chunk_idx >= MEMARENA_DIR_CHUNK_MAX))
+		return NULL;
+
+	chunk_ptr = __atomic_load_n(&mem_arena->concurrent.dir[chunk_idx], __ATOMIC_ACQUIRE);
+
+	/* Publish a new chunk of page pointers, loser of the race drops its copy */
+	if (!chunk_ptr)
+	{
+		if (!create)
+			return NULL;
+
+		new_chunk		= calloc(MEMARENA_DIR_CHUNK_SZ, sizeof(char *));
+		expected_chunk	= NULL;
+
+		if (__atomic_compare_exchange_n(&mem_arena->concurrent.dir[chunk_idx], &expected_chunk, new_chunk, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			chunk_ptr = new_chunk;
+		else
+		{
+			free(new_chunk);
+			chunk_ptr = expected_chunk;
+		}
+	}
+
+	page_ptr = __atomic_load_n(&chunk_ptr[page_idx], __ATOMIC_ACQUIRE);
+
+	if (page_ptr)
+		return (MemArenaSlotHeader *)page_ptr;
+
+	if (!create)
+		return NULL;
+
+	/* Same slot area as locked mode, then busy bitmap, free links and owners */
+	slot_count	= mem_arena->slot[MEMARENA_SLOT_COUNT];
+	area_cap	= (sizeof(MemArenaSlotHeader) + ((slot_count + 1) * (mem_arena->slot[MEMARENA_SLOT_SIZE] + 1)));
+	bits_off	= ((area_cap + 7) & ~7L);
+	link_off	= (bits_off + (((slot_count + 63) / 64) * sizeof(unsigned long)));
+	owner_off	= (link_off + (slot_count * sizeof(long)));
+	page_ptr	= calloc(1, (owner_off + (slot_count * sizeof(int))));
+
+	header				= (MemArenaSlotHeader *)page_ptr;
+	header->mem_arena	= mem_arena;
+	header->slot_id		= arena_id;
+	header->busy_bits	= (unsigned long *)(page_ptr + bits_off);
+	header->free_link	= (long *)(page_ptr + link_off);
+	header->free_owner	= (int *)(page_ptr + owner_off);
+	header->canary00	= 0xDE;
+	header->canary01	= 0xAD;
+	expected_page		= NULL;
+
+	if (!__atomic_compare_exchange_n(&chunk_ptr[page_idx], &expected_page, page_ptr, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	{
+		free(page_ptr);
+		return (MemArenaSlotHeader *)expected_page;
+	}
 
+	/* Account, capacity only moves forward */
+	__atomic_add_fetch(&mem_arena->size[MEMARENA_SIZE_CURRENT], 1, __ATOMIC_RELAXED);
+	capacity = __atomic_load_n(&mem_arena->size[MEMARENA_SIZE_CAPACITY], __ATOMIC_RELAXED);
 
+	while ((arena_id + 1) > capacity)
+	{
+		if (__atomic_compare_exchange_n(&mem_arena->size[MEMARENA_SIZE_CAPACITY], &capacity, (arena_id + 1), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+	}
+
+	return header;
+}
+/**************************************************************************************************************************/
+static void *MemArenaConcurrentSlotPtr(MemArena *mem_arena, MemArenaSlotHeader *header, long slot_offset)
+{
+	char *ret_ptr;
+
+	ret_ptr = (char *)header;
+	ret_ptr += (sizeof(MemArenaSlotHeader) + (slot_offset * mem_arena->slot[MEMARENA_SLOT_SIZE]));
+
+	return ret_ptr;
+}
+/**************************************************************************************************************************/
+static void *MemArenaConcurrentFindByID(MemArena *mem_arena, long id)
+{
+	MemArenaSlotHeader *header;
+	unsigned long busy_word;
+	long slot_offset;
+
+	header = MemArenaConcurrentPageGrab(mem_arena, (id / mem_arena->slot[MEMARENA_SLOT_COUNT]), 0);
+
+	/* Page never created */
+	if (!header)
+		return NULL;
+
+	slot_offset	= (id % mem_arena->slot[MEMARENA_SLOT_COUNT]);
+	busy_word	= __atomic_load_n(&header->busy_bits[slot_offset / 64], __ATOMIC_ACQUIRE);
+
+	/* Not in use, bail out */
+	if (!(busy_word & (1UL << (slot_offset % 64))))
+		return NULL;
+
+	return MemArenaConcurrentSlotPtr(mem_arena, header, slot_offset);
+}
+/**************************************************************************************************************************/
+static void *MemArenaConcurrentGrabByID(MemArena *mem_arena, long id)
+{
+	MemArenaSlotHeader *header;
+	unsigned long busy_word;
+	unsigned long busy_bit;
+	long slot_offset;
+
+	header = MemArenaConcurrentPageGrab(mem_arena, (id / mem_arena->slot[MEMARENA_SLOT_COUNT]), 1);
+
+	/* Directory exhausted */
+	if (!header)
+		return NULL;
+
+	/* Make sure canaries are OK */
+	assert(0xDE == header->canary00);
+	assert(0xAD == header->canary01);
+
+	slot_offset	= (id % mem_arena->slot[MEMARENA_SLOT_COUNT]);
+	busy_bit	= (1UL << (slot_offset % 64));
+	busy_word	= __atomic_fetch_or(&header->busy_bits[slot_offset / 64], busy_bit, __ATOMIC_ACQ_REL);
+
+	/* Was not in use, increment busy count */
+	if (!(busy_word & busy_bit))
+		__atomic_add_fetch(&header->busy_count, 1, __ATOMIC_ACQ_REL);
+
+	return MemArenaConcurrentSlotPtr(mem_arena, header, slot_offset);
+}
+/**************************************************************************************************************************/
+static void MemArenaConcurrentReleaseByID(MemArena *mem_arena, long id)
+{
+	MemArenaSlotHeader *header;
+	unsigned long busy_word;
+	unsigned long busy_bit;
+	long slot_offset;
+
+	header = MemArenaConcurrentPageGrab(mem_arena, (id / mem_arena->slot[MEMARENA_SLOT_COUNT]), 0);
+
+	/* Make sure this arena is ACTIVE and canaries are OK */
+	assert(header);
+	assert(0xDE == header->canary00);
+	assert(0xAD == header->canary01);
+
+	slot_offset	= (id % mem_arena->slot[MEMARENA_SLOT_COUNT]);
+	busy_bit	= (1UL << (slot_offset % 64));
+	busy_word	= __atomic_fetch_and(&header->busy_bits[slot_offset / 64], ~busy_bit, __ATOMIC_ACQ_REL);
+
+	/* Make sure this SLOT was in use. Page stays resident, readers may still hold pointers into it */
+	assert(busy_word & busy_bit);
+	__atomic_sub_fetch(&header->busy_count, 1, __ATOMIC_ACQ_REL);
+
+	return;
+}
+/**************************************************************************************************************************/
+static void MemArenaConcurrentClean(MemArena *mem_arena)
+{
+	char **chunk_ptr;
+	long area_cap;
+	long i, j;
+
+	area_cap = ((mem_arena->slot[MEMARENA_SLOT_COUNT] + 1) * (mem_arena->slot[MEMARENA_SLOT_SIZE] + 1));
+
+	/* Clean slot data only, busy bits and free lists are kept */
+	for (i = 0; i < MEMARENA_DIR_CHUNK_MAX; i++)
+	{
+		chunk_ptr = __atomic_load_n(&mem_arena->concurrent.dir[i], __ATOMIC_ACQUIRE);
+
+		if (!chunk_ptr)
+			continue;
+
+		for (j = 0; j < MEMARENA_DIR_CHUNK_SZ; j++)
+		{
+			if (chunk_ptr[j])
+				memset((chunk_ptr[j] + sizeof(MemArenaSlotHeader)), 0, area_cap);
+		}
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void MemArenaConcurrentDestroy(MemArena *mem_arena)
+{
+	char **chunk_ptr;
+	long i, j;
+
+	for (i = 0; i < MEMARENA_DIR_CHUNK_MAX; i++)
+	{
+		chunk_ptr = mem_arena->concurrent.dir[i];
+
+		if (!chunk_ptr)
+			continue;
+
+		for (j = 0; j < MEMARENA_DIR_CHUNK_SZ; j++)
+			free(chunk_ptr[j]);
+
+		free(chunk_ptr);
+	}
+
+	free(mem_arena->concurrent.dir);
+	free(mem_arena->concurrent.magazine_arr);
+	free(mem_arena);
+
+	return;
+}
+/**************************************************************************************************************************/
@@ -35,8 +35,17 @@
 #include "../include/libbrb_core.h"
 
 static void MemBufferCheckForGrow(MemBuffer *mb_ptr, unsigned long new_data_sz);
+static unsigned long MemBufferGrowCapacityCalc(MemBuffer *mb_ptr, unsigned long new_data_sz);
+static int MemBufferDataResize(MemBuffer *mb_ptr, unsigned long new_capacity);
 static int MemBufferDoDestroy(MemBuffer *mb_ptr);
 
+static int MemBufferSlabClassGet(unsigned long data_sz);
+static void *MemBufferSlabAlloc(int slab_class);
+static void MemBufferSlabFree(void *data_ptr, int slab_class);
+
+/* Per-thread cache of free small blocks, one list per size class */
+static MemFreeCache mb_slab_cache = MEMFREECACHE_INITIALIZER(MEMBUFFER_SLAB_CLASS_COUNT, MEMBUFFER_SLAB_CACHE_MAX);
+
 /**************************************************************************************************************************/
 MemBuffer *MemBufferNew(LibDataThreadSafeType mb_type, int grow_rate)
 {
@@ -70,6 +79,9 @@ MemBuffer *MemBufferNew(LibDataThreadSafeType mb_type, int grow_rate)
 	else
 		mb_ptr->grow_rate = grow_rate;
 
+	/* Grow geometrically unless upper layers ask otherwise */
+	mb_ptr->grow_policy = MEMBUFFER_GROW_GEOMETRIC;
+
 	return mb_ptr;
 
 }
@@ -125,30 +137,57 @@ int MemBufferShrink(MemBuffer *mb_ptr)
 	if (!mb_ptr)
 		return 0;
 
-	/* Better safe than sorry */
-	MemBufferPutNULLTerminator(mb_ptr);
-
 	if (mb_ptr->size <= 1)
 		return 0;
 
 	/* Shrink buffer size to smallest possible */
-	BRB_REALLOC(mb_ptr->data, mb_ptr->data, (mb_ptr->size + 1) * sizeof(char));
+	return MemBufferShrinkToFit(mb_ptr);
+}
+/**************************************************************************************************************************/
+int MemBufferShrinkToFit(MemBuffer *mb_ptr)
+{
+	unsigned long fit_sz;
+	int op_status = 0;
 
-	/* Set new capacity */
-	mb_ptr->capacity = mb_ptr->size;
+	/* Sanity checks */
+	if (!mb_ptr)
+		return 0;
 
-	/* Remove from COREDUMPs */
-	if (mb_ptr->flags.no_core)
-		MemBufferNoCoreOnCrash(mb_ptr);
+	/* Never resize memory we do not own */
+	if ((mb_ptr->flags.mmaped) || (mb_ptr->flags.readonly) || (mb_ptr->capacity == 0))
+		return 0;
 
-	/* RESET WIRE_MEM if WIRED */
-	if (mb_ptr->flags.wired)
-	{
-		/* Reset WIRE for pages */
-		MemBufferUnwirePages(mb_ptr);
-		MemBufferWirePages(mb_ptr);
-	}
+	/* CRITICAL SECTION - BEGIN */
+	if (mb_ptr->mb_type == BRBDATA_THREAD_SAFE)
+		_MemBufferEnterCritical(mb_ptr);
+
+	/* Keep room for NULL terminator */
+	fit_sz = (mb_ptr->size + 1);
+
+	/* Already tight, or would land on the same SLAB class */
+	if ((fit_sz >= mb_ptr->capacity) || ((mb_ptr->flags.slab) && (MemBufferSlabClassGet(fit_sz) == MemBufferSlabClassGet(mb_ptr->capacity))))
+		goto leave;
+
+	/* Resize and better safe than sorry, NULL terminate */
+	op_status = MemBufferDataResize(mb_ptr, fit_sz);
+	((char*)mb_ptr->data)[mb_ptr->size] = '\0';
+
+	leave:
+
+	/* CRITICAL SECTION - END */
+	if (mb_ptr->mb_type == BRBDATA_THREAD_SAFE)
+		_MemBufferLeaveCritical(mb_ptr);
 
+	return op_status;
+}
+/**************************************************************************************************************************/
+int MemBufferGrowPolicySet(MemBuffer *mb_ptr, MemBufferGrowPolicy grow_policy)
+{
+	/* Sanity checks */
+	if ((!mb_ptr) || (grow_policy < 0) || (grow_policy >= MEMBUFFER_GROW_LASTITEM))
+		return 0;
+
+	mb_ptr->grow_policy = grow_policy;
 	return 1;
 }
 /**************************************************************************************************************************/
@@ -1224,30 +1263,32 @@ long MemBufferReadFromFD(MemBuffer *mb_ptr, unsigned long data_sz, int fd)
 long MemBufferAppendFromFD(MemBuffer *mb_ptr, unsigned long data_sz, int fd, int flags)
 {
 	long bytes_read = -1;
-	char *read_buffer;
+	char *base_ptr;
 
 	/* Sanity check */
-	if (!mb_ptr)
+	if ((!mb_ptr) || (mb_ptr->flags.readonly))
 		return 0;
 
-	/* Alloc space for raw file content */
-	BRB_CALLOC(read_buffer,  (data_sz + 1), sizeof(char) );
+	/* CRITICAL SECTION - BEGIN */
+	if (mb_ptr->mb_type == BRBDATA_THREAD_SAFE)
+		_MemBufferEnterCritical(mb_ptr);
 
-	/* Read the buffer from the file descriptor, and then close it down */
-	bytes_read = recv(fd, read_buffer, data_sz, flags);
+	/* Make room for data plus NULL terminator and read straight into it, no temporary buffer */
+	MemBufferCheckForGrow(mb_ptr, data_sz + 1);
 
-	/* Error reading */
-	if (bytes_read <= 0)
+	base_ptr	= ((char*)mb_ptr->data + mb_ptr->size);
+	bytes_read	= recv(fd, base_ptr, data_sz, flags);
+
+	/* Read OK, update size */
+	if (bytes_read > 0)
 	{
-		/* Free resources and return */
-		BRB_FREE(read_buffer);
-		return bytes_read;
+		mb_ptr->size		+= bytes_read;
+		base_ptr[bytes_read] = '\0';
 	}
 
-	/* Add data to mem_buf */
-	MemBufferAdd(mb_ptr, read_buffer, bytes_read);
-
-	BRB_FREE(read_buffer);
+	/* CRITICAL SECTION - END */
+	if (mb_ptr->mb_type == BRBDATA_THREAD_SAFE)
+		_MemBufferLeaveCritical(mb_ptr);
 
 	return bytes_read;
 
@@ -1782,7 +1823,7 @@ MemBuffer *MemBufferMetaDataPackToMB(MemBuffer *mb_ptr, unsigned long item_sub_i
 
 	/* Pack data into METADATA SERIALIZER and DUMP it into MEMBUFFER */
 	MemBufferMetaDataPack(mb_ptr, &metadata, item_sub_id);
-	MetaDataPack(&metadata, packed_mb);
+	MetaDataPackV2(&metadata, packed_mb, METADATA_CHECKSUM_CRC32C);
 
 	/* Clean UP METDATA and leave */
 	MetaDataClean(&metadata);
@@ -1933,63 +1974,100 @@ int MemBufferGzipInflate(MemBuffer *in_mb, int in_offset, MemBuffer *out_mb)
 /**************************************************************************************************************************/
 static void MemBufferCheckForGrow(MemBuffer *mb_ptr, unsigned long new_data_sz)
 {
-	void *base_ptr = NULL;
-	unsigned long need_mem = 0;
+	/* Still fits, nothing to do */
+	if ((mb_ptr->capacity > 0) && (mb_ptr->capacity > (mb_ptr->size + new_data_sz)))
+		return;
 
-	/* Calculate needed memory */
-	need_mem = (mb_ptr->grow_rate + new_data_sz);
+	MemBufferDataResize(mb_ptr, MemBufferGrowCapacityCalc(mb_ptr, new_data_sz));
+	return;
+}
+/**************************************************************************************************************************/
+static unsigned long MemBufferGrowCapacityCalc(MemBuffer *mb_ptr, unsigned long new_data_sz)
+{
+	unsigned long need_mem	= (mb_ptr->grow_rate + new_data_sz);
+	unsigned long grow_step;
 
-	/* Check if its the first element. If true, alloc. Else realloc */
-	if (mb_ptr->capacity == 0)
-	{
-		BRB_CALLOC(mb_ptr->data, need_mem, sizeof(char));
+	/* First allocation, or LINEAR policy - Grow by GROW_RATE plus what we have been asked for */
+	if ((mb_ptr->capacity == 0) || (MEMBUFFER_GROW_LINEAR == mb_ptr->grow_policy))
+		return (mb_ptr->capacity + need_mem);
 
-		/* Update capacity */
-		mb_ptr->capacity += need_mem;
+	/* GEOMETRIC policy - Double capacity, but never grow more than STEP_MAX at once */
+	grow_step = (mb_ptr->capacity > MEMBUFFER_GROW_GEOMETRIC_STEP_MAX) ? MEMBUFFER_GROW_GEOMETRIC_STEP_MAX : mb_ptr->capacity;
 
-		/* First WIRE */
-		if (mb_ptr->flags.wired)
-		{
-			/* Little hack for first WIRE */
-			mb_ptr->flags.wired = 0;
-			MemBufferWirePages(mb_ptr);
-		}
+	/* Doubling is not enough for this write, grow just what we need */
+	if (grow_step < need_mem)
+		grow_step = need_mem;
+
+	return (mb_ptr->capacity + grow_step);
+}
+/**************************************************************************************************************************/
+static int MemBufferDataResize(MemBuffer *mb_ptr, unsigned long new_capacity)
+{
+	void *new_data;
+	int new_class;
+	int old_class;
 
-		/* Remove from COREDUMPs */
-		if (mb_ptr->flags.no_core)
-			MemBufferNoCoreOnCrash(mb_ptr);
+	int was_wired		= mb_ptr->flags.wired;
 
-	}
+	/* Buffers that fit a SLAB class are served from current thread cache */
+	new_class = (mb_ptr->flags.mmaped) ? -1 : MemBufferSlabClassGet(new_capacity);
+	old_class = (mb_ptr->flags.slab) ? MemBufferSlabClassGet(mb_ptr->capacity) : -1;
+
+	/* Release WIRE of old pages, or little hack for first WIRE */
+	if (mb_ptr->capacity > 0)
+		MemBufferUnwirePages(mb_ptr);
+	else
+		mb_ptr->flags.wired = 0;
 
-	/* Time to grow up the buffer */
-	else if ( mb_ptr->capacity <= (mb_ptr->size + new_data_sz))
+	/* Move into a SLAB block, from HEAP or from another SLAB class */
+	if (new_class >= 0)
 	{
-		BRB_REALLOC(mb_ptr->data, mb_ptr->data, ((mb_ptr->capacity + need_mem) * sizeof(char)));
+		new_data		= MemBufferSlabAlloc(new_class);
+		new_capacity	= (MEMBUFFER_SLAB_CLASS_MIN << new_class);
 
-		/* RESET WIRE_MEM if WIRED */
-		if (mb_ptr->flags.wired)
-		{
-			/* Reset WIRE for pages */
-			MemBufferUnwirePages(mb_ptr);
-			MemBufferWirePages(mb_ptr);
-		}
+		/* Copy what fits and release old block */
+		if (mb_ptr->data)
+			memcpy(new_data, mb_ptr->data, ((mb_ptr->capacity < new_capacity) ? mb_ptr->capacity : new_capacity));
+
+		if (old_class >= 0)
+			MemBufferSlabFree(mb_ptr->data, old_class);
+		else
+			BRB_FREE(mb_ptr->data);
 
-		/* Remove from COREDUMPs */
-		if (mb_ptr->flags.no_core)
-			MemBufferNoCoreOnCrash(mb_ptr);
+		mb_ptr->flags.slab = 1;
+	}
+	/* Leaving SLAB for HEAP */
+	else if (old_class >= 0)
+	{
+		BRB_CALLOC(new_data, new_capacity, sizeof(char));
+		memcpy(new_data, mb_ptr->data, mb_ptr->capacity);
+		MemBufferSlabFree(mb_ptr->data, old_class);
 
-		/* Calculate base MemBuffer_ptr */
-		base_ptr = ((char*)mb_ptr->data + mb_ptr->capacity);
+		mb_ptr->flags.slab = 0;
+	}
+	/* HEAP to HEAP */
+	else
+	{
+		BRB_REALLOC(new_data, mb_ptr->data, (new_capacity * sizeof(char)));
 
 		/* Clean buffer received by realloc */
-		memset( base_ptr, 0, (need_mem * sizeof(char)));
+		if (new_capacity > mb_ptr->capacity)
+			memset(((char*)new_data + mb_ptr->capacity), 0, (new_capacity - mb_ptr->capacity));
+	}
 
-		/* Update capacity */
-		mb_ptr->capacity += need_mem;
+	/* Update data and capacity */
+	mb_ptr->data		= new_data;
+	mb_ptr->capacity	= new_capacity;
 
-	}
+	/* RESET WIRE_MEM if WIRED */
+	if (was_wired)
+		MemBufferWirePages(mb_ptr);
 
-	return;
+	/* Remove from COREDUMPs */
+	if (mb_ptr->flags.no_core)
+		MemBufferNoCoreOnCrash(mb_ptr);
+
+	return 1;
 }
 /**************************************************************************************************************************/
 static int MemBufferDoDestroy(MemBuffer *mb_ptr)
@@ -2006,6 +2084,10 @@ static int MemBufferDoDestroy(MemBuffer *mb_ptr)
 		munmap(mb_ptr->data, mb_ptr->capacity);
 		close(mb_ptr->mmap_fd);
 	}
+	else if (mb_ptr->flags.slab)
+	{
+		MemBufferSlabFree(mb_ptr->data, MemBufferSlabClassGet(mb_ptr->capacity));
+	}
 	else
 	{
 		BRB_FREE(mb_ptr->data);
@@ -2016,4 +2098,53 @@ static int MemBufferDoDestroy(MemBuffer *mb_ptr)
 	return 1;
 }
 /**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static int MemBufferSlabClassGet(unsigned long data_sz)
+{
+	unsigned long class_sz	= MEMBUFFER_SLAB_CLASS_MIN;
+	int slab_class			= 0;
+
+	/* Too big for SLAB */
+	if (data_sz > MEMBUFFER_SLAB_CLASS_MAX)
+		return -1;
+
+	/* Find smallest class that fits */
+	while (class_sz < data_sz)
+	{
+		class_sz <<= 1;
+		slab_class++;
+	}
+
+	return slab_class;
+}
+/**************************************************************************************************************************/
+static void *MemBufferSlabAlloc(int slab_class)
+{
+	void *data_ptr;
+
+	unsigned long class_sz = (MEMBUFFER_SLAB_CLASS_MIN << slab_class);
+
+	data_ptr = MemFreeCachePop(&mb_slab_cache, slab_class);
+
+	/* Nothing cached for this class, go to HEAP */
+	if (!data_ptr)
+	{
+		BRB_CALLOC(data_ptr, 1, class_sz);
+		return data_ptr;
+	}
+
+	/* Upper layers expect clean memory, as if it came from CALLOC */
+	memset(data_ptr, 0, class_sz);
+	return data_ptr;
+}
+/**************************************************************************************************************************/
+static void MemBufferSlabFree(void *data_ptr, int slab_class)
+{
+	/* Cache it for this thread, or release it if class list is full */
+	MemFreeCachePush(&mb_slab_cache, slab_class, data_ptr);
+	return;
+}
+/**************************************************************************************************************************/
 
@@ -0,0 +1,668 @@
+/*
+ * mem_chain.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2012 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../include/libbrb_core.h"
+
+/* A MemChain is a FIFO of fixed size chunks. Socket reads land straight into the tail chunk, and upper layers pop
+ * frames from head as MemSlices that point into chunk memory and hold a reference to it. Chunks go back to a per-thread
+ * free list once the chain and every slice released them, and an empty chain holds no chunk at all, so memory follows
+ * bytes in flight instead of each connection high water mark */
+
+static MemChunk *MemChainChunkAppend(MemChain *mem_chain);
+static void MemChainChunkPopHead(MemChain *mem_chain);
+static void MemChainReleaseIfEmpty(MemChain *mem_chain);
+static int MemChainMatch(MemChunk *chunk, unsigned long chunk_off, const char *token_str, int token_sz);
+
+/* Per-thread cache of free chunks, single class chained through chunk next pointer */
+static MemFreeCache mc_chunk_cache = MEMFREECACHE_INITIALIZER(1, MEMCHAIN_CHUNK_CACHE_MAX);
+
+/**************************************************************************************************************************/
+MemChunk *MemChunkNew(void)
+{
+	MemChunk *chunk;
+
+	/* Pop a cached chunk, or go to HEAP - Payload is not cleared, it is always written before being read */
+	chunk = MemFreeCachePop(&mc_chunk_cache, 0);
+
+	if (!chunk)
+	{
+		chunk = malloc(sizeof(MemChunk));
+
+		if (!chunk)
+			return NULL;
+	}
+
+	chunk->next			= NULL;
+	chunk->size			= 0;
+	chunk->ref_count	= 1;
+
+	return chunk;
+}
+/**************************************************************************************************************************/
+void MemChunkRetain(MemChunk *chunk)
+{
+	/* Slices may be handed to other threads, keep it atomic */
+	__sync_add_and_fetch(&chunk->ref_count, 1);
+	return;
+}
+/**************************************************************************************************************************/
+void MemChunkRelease(MemChunk *chunk)
+{
+	/* Sanity check */
+	if (!chunk)
+		return;
+
+	/* Still referenced by chain or by some slice */
+	if (__sync_sub_and_fetch(&chunk->ref_count, 1) > 0)
+		return;
+
+	/* Cache it for this thread, or release it if cache is full */
+	MemFreeCachePush(&mc_chunk_cache, 0, chunk);
+
+	return;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+MemChain *MemChainNew(void)
+{
+	MemChain *mem_chain;
+
+	BRB_CALLOC(mem_chain, 1, sizeof(MemChain));
+	return mem_chain;
+}
+/**************************************************************************************************************************/
+void MemChainDestroy(MemChain *mem_chain)
+{
+	/* Sanity check */
+	if (!mem_chain)
+		return;
+
+	MemChainClean(mem_chain);
+	BRB_FREE(mem_chain);
+
+	return;
+}
+/**************************************************************************************************************************/
+void MemChainClean(MemChain *mem_chain)
+{
+	/* Drop our reference to every chunk, slices still pointing into them keep them alive */
+	while (mem_chain->head)
+		MemChainChunkPopHead(mem_chain);
+
+	mem_chain->head_off	= 0;
+	mem_chain->size		= 0;
+
+	return;
+}
+/**************************************************************************************************************************/
+unsigned long MemChainGetSize(MemChain *mem_chain)
+{
+	return (mem_chain ? mem_chain->size : 0);
+}
+/**************************************************************************************************************************/
+long MemChainAppendFromFD(MemChain *mem_chain, unsigned long data_sz, int fd, int flags)
+{
+	struct iovec iov_arr[MEMCHAIN_READ_IOVEC_MAX];
+	MemChunk *spare_arr[MEMCHAIN_READ_IOVEC_MAX];
+	struct msghdr msg_hdr;
+	unsigned long remaining_sz;
+	unsigned long tail_sz;
+	unsigned long fill_sz;
+	long bytes_read;
+	int spare_count;
+	int iov_count;
+	int i;
+
+	/* Sanity check */
+	if ((!mem_chain) || (data_sz <= 0))
+		return 0;
+
+	remaining_sz	= data_sz;
+	tail_sz			= 0;
+	spare_count		= 0;
+	iov_count		= 0;
+
+	/* Fill what is left on tail chunk first */
+	if ((mem_chain->tail) && (mem_chain->tail->size < MEMCHAIN_CHUNK_SZ))
+	{
+		tail_sz								= MEMCHAIN_CHUNK_SZ - mem_chain->tail->size;
+		tail_sz								= (tail_sz > remaining_sz) ? remaining_sz : tail_sz;
+		iov_arr[iov_count].iov_base			= mem_chain->tail->data + mem_chain->tail->size;
+		iov_arr[iov_count].iov_len			= tail_sz;
+		remaining_sz						-= tail_sz;
+		iov_count++;
+	}
+
+	/* Then spread remaining over fresh chunks, they only get linked if kernel actually fills them */
+	while ((remaining_sz > 0) && (iov_count < MEMCHAIN_READ_IOVEC_MAX))
+	{
+		spare_arr[spare_count] = MemChunkNew();
+
+		if (!spare_arr[spare_count])
+			break;
+
+		fill_sz								= (remaining_sz > MEMCHAIN_CHUNK_SZ) ? MEMCHAIN_CHUNK_SZ : remaining_sz;
+		iov_arr[iov_count].iov_base			= spare_arr[spare_count]->data;
+		iov_arr[iov_count].iov_len			= fill_sz;
+		remaining_sz						-= fill_sz;
+		spare_count++;
+		iov_count++;
+	}
+
+	/* Socket flags such as MSG_PEEK need RECVMSG, plain READV works on any descriptor */
+	if (flags)
+	{
+		memset(&msg_hdr, 0, sizeof(struct msghdr));
+		msg_hdr.msg_iov		= (struct iovec *)&iov_arr;
+		msg_hdr.msg_iovlen	= iov_count;
+		bytes_read			= recvmsg(fd, &msg_hdr, flags);
+	}
+	else
+		bytes_read			= readv(fd, (struct iovec *)&iov_arr, iov_count);
+
+	/* Nothing read, give spare chunks back */
+	if (bytes_read <= 0)
+	{
+		for (i = 0; i < spare_count; i++)
+			MemChunkRelease(spare_arr[i]);
+
+		return bytes_read;
+	}
+
+	mem_chain->size	+= bytes_read;
+	remaining_sz	= bytes_read;
+
+	/* Account bytes that landed on tail */
+	if (tail_sz > 0)
+	{
+		fill_sz						= (remaining_sz > tail_sz) ? tail_sz : remaining_sz;
+		mem_chain->tail->size		+= fill_sz;
+		remaining_sz				-= fill_sz;
+	}
+
+	/* Link spare chunks that got data, release the others */
+	for (i = 0; i < spare_count; i++)
+	{
+		if (remaining_sz <= 0)
+		{
+			MemChunkRelease(spare_arr[i]);
+			continue;
+		}
+
+		fill_sz					= (remaining_sz > MEMCHAIN_CHUNK_SZ) ? MEMCHAIN_CHUNK_SZ : remaining_sz;
+		spare_arr[i]->size		= fill_sz;
+		remaining_sz			-= fill_sz;
+
+		/* Link at tail */
+		if (mem_chain->tail)
+			mem_chain->tail->next	= spare_arr[i];
+		else
+			mem_chain->head			= spare_arr[i];
+
+		mem_chain->tail = spare_arr[i];
+		mem_chain->chunk_count++;
+		continue;
+	}
+
+	return bytes_read;
+}
+/**************************************************************************************************************************/
+unsigned long MemChainAdd(MemChain *mem_chain, const void *new_data, unsigned long new_data_sz)
+{
+	const char *data_ptr = new_data;
+	unsigned long space_sz;
+	char *base_ptr;
+
+	/* Sanity check */
+	if (!mem_chain)
+		return 0;
+
+	while (new_data_sz > 0)
+	{
+		base_ptr = MemChainWriteReserve(mem_chain, &space_sz);
+
+		/* Out of memory */
+		if (!base_ptr)
+			break;
+
+		space_sz = (space_sz > new_data_sz) ? new_data_sz : space_sz;
+		memcpy(base_ptr, data_ptr, space_sz);
+		MemChainWriteCommit(mem_chain, space_sz);
+
+		data_ptr	+= space_sz;
+		new_data_sz	-= space_sz;
+		continue;
+	}
+
+	return mem_chain->size;
+}
+/**************************************************************************************************************************/
+char *MemChainWriteReserve(MemChain *mem_chain, unsigned long *ret_space_sz)
+{
+	/* Tail is full or chain is empty, link a fresh chunk */
+	if ((!mem_chain->tail) || (mem_chain->tail->size >= MEMCHAIN_CHUNK_SZ))
+	{
+		if (!MemChainChunkAppend(mem_chain))
+		{
+			*ret_space_sz = 0;
+			return NULL;
+		}
+	}
+
+	*ret_space_sz = MEMCHAIN_CHUNK_SZ - mem_chain->tail->size;
+	return (mem_chain->tail->data + mem_chain->tail->size);
+}
+/**************************************************************************************************************************/
+void MemChainWriteCommit(MemChain *mem_chain, unsigned long data_sz)
+{
+	/* Sanity check */
+	if (!mem_chain->tail)
+		return;
+
+	mem_chain->tail->size	+= data_sz;
+	mem_chain->size			+= data_sz;
+
+	/* Reserved but nothing written, do not keep an idle chunk around */
+	MemChainReleaseIfEmpty(mem_chain);
+	return;
+}
+/**************************************************************************************************************************/
+char *MemChainOffsetDeref(MemChain *mem_chain, unsigned long offset, unsigned long *ret_contig_sz)
+{
+	MemChunk *chunk;
+	unsigned long chunk_off;
+
+	/* Sanity check */
+	if ((!mem_chain) || (offset >= mem_chain->size))
+	{
+		if (ret_contig_sz)
+			*ret_contig_sz = 0;
+
+		return NULL;
+	}
+
+	/* Walk to chunk holding offset */
+	for (chunk = mem_chain->head, chunk_off = (mem_chain->head_off + offset); chunk_off >= chunk->size; chunk = chunk->next)
+		chunk_off -= chunk->size;
+
+	if (ret_contig_sz)
+		*ret_contig_sz = (chunk->size - chunk_off);
+
+	return (chunk->data + chunk_off);
+}
+/**************************************************************************************************************************/
+long MemChainFind(MemChain *mem_chain, unsigned long offset, const char *token_str, int token_sz)
+{
+	MemChunk *chunk;
+	unsigned long chunk_off;
+	unsigned long cur_off;
+	unsigned long seg_sz;
+	unsigned long hit_sz;
+	long hit_off;
+	char *seg_ptr;
+
+	/* Sanity check */
+	if ((!mem_chain) || (token_sz <= 0) || ((offset + token_sz) > mem_chain->size))
+		return -1;
+
+	/* Walk to chunk holding offset */
+	for (chunk = mem_chain->head, chunk_off = (mem_chain->head_off + offset); chunk_off >= chunk->size; chunk = chunk->next)
+		chunk_off -= chunk->size;
+
+	cur_off = offset;
+
+	/* Scan each chunk with SIMD helper, then check positions where token may cross into next chunks */
+	for (; chunk; chunk = chunk->next, chunk_off = 0)
+	{
+		seg_ptr	= chunk->data + chunk_off;
+		seg_sz	= chunk->size - chunk_off;
+
+		/* Token fully inside this segment */
+		hit_off = BrbMemFind(seg_ptr, seg_sz, token_str, token_sz);
+
+		if (hit_off >= 0)
+			return (cur_off + hit_off);
+
+		/* Candidates on last TOKEN_SZ - 1 bytes continue on next chunk */
+		for (hit_sz = ((seg_sz > (token_sz - 1)) ? (seg_sz - (token_sz - 1)) : 0); hit_sz < seg_sz; hit_sz++)
+		{
+			/* Not enough data left for a full token */
+			if ((cur_off + hit_sz + token_sz) > mem_chain->size)
+				return -1;
+
+			if ((seg_ptr[hit_sz] == token_str[0]) && (MemChainMatch(chunk, (chunk_off + hit_sz), token_str, token_sz)))
+				return (cur_off + hit_sz);
+
+			continue;
+		}
+
+		cur_off += seg_sz;
+		continue;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+unsigned long MemChainPeek(MemChain *mem_chain, unsigned long offset, void *ret_buf, unsigned long data_sz)
+{
+	char *dst_ptr = ret_buf;
+	unsigned long copy_total;
+	unsigned long chunk_off;
+	unsigned long copy_sz;
+	MemChunk *chunk;
+
+	/* Sanity check */
+	if ((!mem_chain) || (offset >= mem_chain->size))
+		return 0;
+
+	data_sz		= (data_sz > (mem_chain->size - offset)) ? (mem_chain->size - offset) : data_sz;
+	copy_total	= 0;
+
+	/* Walk to chunk holding offset */
+	for (chunk = mem_chain->head, chunk_off = (mem_chain->head_off + offset); chunk_off >= chunk->size; chunk = chunk->next)
+		chunk_off -= chunk->size;
+
+	/* Copy out without consuming */
+	for (; (chunk) && (copy_total < data_sz); chunk = chunk->next, chunk_off = 0)
+	{
+		copy_sz = (chunk->size - chunk_off);
+		copy_sz = (copy_sz > (data_sz - copy_total)) ? (data_sz - copy_total) : copy_sz;
+
+		memcpy(dst_ptr + copy_total, chunk->data + chunk_off, copy_sz);
+		copy_total += copy_sz;
+	}
+
+	return copy_total;
+}
+/**************************************************************************************************************************/
+unsigned long MemChainDrain(MemChain *mem_chain, unsigned long data_sz)
+{
+	unsigned long drained_sz;
+	unsigned long avail_sz;
+
+	/* Sanity check */
+	if (!mem_chain)
+		return 0;
+
+	data_sz		= (data_sz > mem_chain->size) ? mem_chain->size : data_sz;
+	drained_sz	= data_sz;
+
+	while (data_sz > 0)
+	{
+		avail_sz = (mem_chain->head->size - mem_chain->head_off);
+
+		/* Partially consume head */
+		if (data_sz < avail_sz)
+		{
+			mem_chain->head_off	+= data_sz;
+			mem_chain->size		-= data_sz;
+			break;
+		}
+
+		/* Head fully consumed, drop it */
+		mem_chain->size	-= avail_sz;
+		data_sz			-= avail_sz;
+
+		MemChainChunkPopHead(mem_chain);
+		continue;
+	}
+
+	MemChainReleaseIfEmpty(mem_chain);
+	return drained_sz;
+}
+/**************************************************************************************************************************/
+void MemChainTruncate(MemChain *mem_chain, unsigned long new_sz)
+{
+	MemChunk *chunk;
+	MemChunk *next_chunk;
+	unsigned long chunk_off;
+	int chunk_count;
+
+	/* Sanity check */
+	if ((!mem_chain) || (new_sz >= mem_chain->size))
+		return;
+
+	/* Nothing left */
+	if (0 == new_sz)
+	{
+		MemChainClean(mem_chain);
+		return;
+	}
+
+	/* Walk to chunk holding last byte we keep */
+	for (chunk = mem_chain->head, chunk_off = (mem_chain->head_off + new_sz), chunk_count = 1; chunk_off > chunk->size; chunk = chunk->next, chunk_count++)
+		chunk_off -= chunk->size;
+
+	/* Cut everything past it - Bytes beyond unconsumed size are never referenced by a slice */
+	next_chunk				= chunk->next;
+	chunk->size				= chunk_off;
+	chunk->next				= NULL;
+	mem_chain->tail			= chunk;
+	mem_chain->chunk_count	= chunk_count;
+	mem_chain->size			= new_sz;
+
+	while (next_chunk)
+	{
+		chunk		= next_chunk;
+		next_chunk	= chunk->next;
+		MemChunkRelease(chunk);
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+int MemChainSlicePop(MemChain *mem_chain, unsigned long slice_sz, MemSlice *ret_slice)
+{
+	MemChunk *chunk;
+
+	memset(ret_slice, 0, sizeof(MemSlice));
+
+	/* Sanity check */
+	if ((!mem_chain) || (slice_sz <= 0) || (slice_sz > mem_chain->size))
+		return 0;
+
+	/* Whole slice sits on head chunk, just point into it - Zero copy */
+	if ((mem_chain->head->size - mem_chain->head_off) >= slice_sz)
+	{
+		ret_slice->chunk	= mem_chain->head;
+		ret_slice->data		= mem_chain->head->data + mem_chain->head_off;
+		ret_slice->size		= slice_sz;
+
+		MemChunkRetain(mem_chain->head);
+	}
+	/* Slice crosses chunk boundary but fits a chunk, coalesce it into a private pooled chunk */
+	else if (slice_sz <= MEMCHAIN_CHUNK_SZ)
+	{
+		chunk = MemChunkNew();
+
+		if (!chunk)
+			return 0;
+
+		chunk->size			= MemChainPeek(mem_chain, 0, chunk->data, slice_sz);
+		ret_slice->chunk	= chunk;
+		ret_slice->data		= chunk->data;
+		ret_slice->size		= slice_sz;
+	}
+	/* Bigger than a chunk, go to HEAP */
+	else
+	{
+		ret_slice->data = malloc(slice_sz + 1);
+
+		if (!ret_slice->data)
+			return 0;
+
+		MemChainPeek(mem_chain, 0, ret_slice->data, slice_sz);
+		ret_slice->data[slice_sz]	= '\0';
+		ret_slice->size				= slice_sz;
+		ret_slice->flags.heap		= 1;
+	}
+
+	/* Consume it from chain */
+	MemChainDrain(mem_chain, slice_sz);
+	return 1;
+}
+/**************************************************************************************************************************/
+void MemSliceDup(MemSlice *src_slice, MemSlice *dst_slice)
+{
+	memcpy(dst_slice, src_slice, sizeof(MemSlice));
+
+	/* HEAP slices are owned by a single holder, copy it */
+	if (src_slice->flags.heap)
+	{
+		dst_slice->data = malloc(src_slice->size + 1);
+
+		if (!dst_slice->data)
+		{
+			memset(dst_slice, 0, sizeof(MemSlice));
+			return;
+		}
+
+		memcpy(dst_slice->data, src_slice->data, src_slice->size);
+		dst_slice->data[src_slice->size] = '\0';
+	}
+	/* Chunk slices just take another reference */
+	else if (src_slice->chunk)
+		MemChunkRetain(src_slice->chunk);
+
+	return;
+}
+/**************************************************************************************************************************/
+void MemSliceRelease(MemSlice *mem_slice)
+{
+	/* Sanity check */
+	if (!mem_slice)
+		return;
+
+	/* BRB_FREE is a bare IF, keep it braced so ELSE binds here */
+	if (mem_slice->flags.heap)
+	{
+		BRB_FREE(mem_slice->data);
+	}
+	else if (mem_slice->chunk)
+		MemChunkRelease(mem_slice->chunk);
+
+	memset(mem_slice, 0, sizeof(MemSlice));
+	return;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static MemChunk *MemChainChunkAppend(MemChain *mem_chain)
+{
+	MemChunk *chunk;
+
+	chunk = MemChunkNew();
+
+	/* Out of memory */
+	if (!chunk)
+		return NULL;
+
+	/* Link at tail */
+	if (mem_chain->tail)
+		mem_chain->tail->next	= chunk;
+	else
+		mem_chain->head			= chunk;
+
+	mem_chain->tail = chunk;
+	mem_chain->chunk_count++;
+
+	return chunk;
+}
+/**************************************************************************************************************************/
+static void MemChainChunkPopHead(MemChain *mem_chain)
+{
+	MemChunk *chunk = mem_chain->head;
+
+	/* Unlink head */
+	mem_chain->head		= chunk->next;
+	mem_chain->head_off	= 0;
+	mem_chain->chunk_count--;
+
+	if (!mem_chain->head)
+		mem_chain->tail = NULL;
+
+	MemChunkRelease(chunk);
+	return;
+}
+/**************************************************************************************************************************/
+static void MemChainReleaseIfEmpty(MemChain *mem_chain)
+{
+	/* Chain has pending bytes, keep chunks */
+	if (mem_chain->size > 0)
+		return;
+
+	/* Idle chain holds no memory */
+	while (mem_chain->head)
+		MemChainChunkPopHead(mem_chain);
+
+	return;
+}
+/**************************************************************************************************************************/
+static int MemChainMatch(MemChunk *chunk, unsigned long chunk_off, const char *token_str, int token_sz)
+{
+	unsigned long cmp_sz;
+
+	/* Compare token against chain bytes, crossing chunk boundaries as needed */
+	while (token_sz > 0)
+	{
+		/* This chunk is over, move to next one */
+		if (chunk_off >= chunk->size)
+		{
+			chunk		= chunk->next;
+			chunk_off	= 0;
+
+			if (!chunk)
+				return 0;
+
+			continue;
+		}
+
+		cmp_sz = (chunk->size - chunk_off);
+		cmp_sz = (cmp_sz > token_sz) ? token_sz : cmp_sz;
+
+		if (memcmp(chunk->data + chunk_off, token_str, cmp_sz))
+			return 0;
+
+		chunk_off	+= cmp_sz;
+		token_str	+= cmp_sz;
+		token_sz	-= cmp_sz;
+		continue;
+	}
+
+	return 1;
+}
+/**************************************************************************************************************************/
@@ -0,0 +1,150 @@
+/*
+ * mem_free_cache.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../include/libbrb_core.h"
+
+/* A MemFreeCache keeps released blocks of a few fixed size classes on per-thread lists, chained through the first
+ * pointer of each block, so hot allocators skip HEAP without any locking. Owners decide how a miss is served and
+ * whether a recycled block must be cleared, the cache only holds blocks and releases them when full or on thread exit */
+
+static MemFreeCacheThread *MemFreeCacheThreadGrab(MemFreeCache *free_cache, int create);
+static void MemFreeCacheThreadDestroy(void *thread_cache_ptr);
+
+/**************************************************************************************************************************/
+void *MemFreeCachePop(MemFreeCache *free_cache, int class_id)
+{
+	MemFreeCacheThread *thread_cache;
+	void *block_ptr;
+
+	/* Sanity check */
+	if ((class_id < 0) || (class_id >= free_cache->class_count))
+		return NULL;
+
+	thread_cache = MemFreeCacheThreadGrab(free_cache, 0);
+
+	/* Nothing cached for this class */
+	if ((!thread_cache) || (!thread_cache->free_head[class_id]))
+		return NULL;
+
+	/* Pop head block */
+	block_ptr							= thread_cache->free_head[class_id];
+	thread_cache->free_head[class_id]	= *(void**)block_ptr;
+	thread_cache->free_count[class_id]--;
+
+	return block_ptr;
+}
+/**************************************************************************************************************************/
+void MemFreeCachePush(MemFreeCache *free_cache, int class_id, void *block_ptr)
+{
+	MemFreeCacheThread *thread_cache;
+
+	/* Sanity check */
+	if (!block_ptr)
+		return;
+
+	thread_cache = (((class_id >= 0) && (class_id < free_cache->class_count)) ? MemFreeCacheThreadGrab(free_cache, 1) : NULL);
+
+	/* Unknown class, no memory for cache or class list is full, release block */
+	if ((!thread_cache) || (thread_cache->free_count[class_id] >= free_cache->cache_max))
+	{
+		free(block_ptr);
+		return;
+	}
+
+	/* Push block on class list */
+	*(void**)block_ptr					= thread_cache->free_head[class_id];
+	thread_cache->free_head[class_id]	= block_ptr;
+	thread_cache->free_count[class_id]++;
+
+	return;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static MemFreeCacheThread *MemFreeCacheThreadGrab(MemFreeCache *free_cache, int create)
+{
+	MemFreeCacheThread *thread_cache;
+
+	/* Key is created once per cache, first thread to get here does it */
+	if (!__atomic_load_n(&free_cache->key_ready, __ATOMIC_ACQUIRE))
+	{
+		MUTEX_LOCK(free_cache->key_mutex, "MEM_FREE_CACHE");
+
+		if ((!free_cache->key_ready) && (0 == pthread_key_create(&free_cache->key, MemFreeCacheThreadDestroy)))
+			__atomic_store_n(&free_cache->key_ready, 1, __ATOMIC_RELEASE);
+
+		MUTEX_UNLOCK(free_cache->key_mutex, "MEM_FREE_CACHE");
+
+		/* Out of keys, run uncached */
+		if (!free_cache->key_ready)
+			return NULL;
+	}
+
+	thread_cache = pthread_getspecific(free_cache->key);
+
+	/* Create it on first release */
+	if ((!thread_cache) && (create))
+	{
+		BRB_CALLOC(thread_cache, 1, sizeof(MemFreeCacheThread));
+
+		if (!thread_cache)
+			return NULL;
+
+		pthread_setspecific(free_cache->key, thread_cache);
+	}
+
+	return thread_cache;
+}
+/**************************************************************************************************************************/
+static void MemFreeCacheThreadDestroy(void *thread_cache_ptr)
+{
+	MemFreeCacheThread *thread_cache = thread_cache_ptr;
+	void *block_ptr;
+	int i;
+
+	/* Thread is leaving, release every cached block */
+	for (i = 0; i < MEMFREECACHE_CLASS_MAX; i++)
+	{
+		while ((block_ptr = thread_cache->free_head[i]))
+		{
+			thread_cache->free_head[i] = *(void**)block_ptr;
+			free(block_ptr);
+		}
+	}
+
+	free(thread_cache);
+	return;
+}
+/**************************************************************************************************************************/
@@ -0,0 +1,643 @@
+/*
+ * radix_lpm.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../include/libbrb_core.h"
+
+/* Read optimized longest prefix match compiled from a RadixTree. Writers rebuild a whole snapshot and publish it
+ * with a single pointer swap. Readers never lock, they only announce quiescent states from time to time (once per
+ * event loop iteration is enough), and retired snapshots are freed after every registered reader moved past them.
+ * Lookups hand back the RadixNode data pointer, so data must outlive any snapshot still referencing it */
+
+typedef struct _RadixLPMItem
+{
+	RadixPrefix *prefix;
+	void *data;
+} RadixLPMItem;
+
+static int RadixLPMItemCompare(const void *item_a, const void *item_b);
+static RadixLPMSnapshot *RadixLPMSnapshotBuild(RadixTree *radix);
+static void RadixLPMSnapshotDestroy(RadixLPMSnapshot *snapshot);
+static int RadixLPMSnapshotV4Add(RadixLPMSnapshot *snapshot, RadixPrefix *prefix, unsigned int data_idx);
+static int RadixLPMSnapshotV6Add(RadixLPMSnapshot *snapshot, RadixPrefix *prefix, unsigned int data_idx);
+static int RadixLPMSnapshotGroupNew(unsigned int **group_arr_ptr, int *group_count_ptr, int *group_capacity_ptr, unsigned int fill_entry);
+static void RadixLPMSnapshotV6Fill(RadixLPMSnapshot *snapshot, unsigned int *entry_ptr, unsigned int data_idx);
+static unsigned int RadixLPMSnapshotV6Resolve(RadixLPMSnapshot *snapshot, unsigned char *addr);
+
+/**************************************************************************************************************************/
+RadixLPM *RadixLPMNew(RadixTree *radix)
+{
+	RadixLPM *lpm;
+
+	/* Sanity check */
+	if (!radix)
+		return NULL;
+
+	lpm = calloc(1, sizeof(RadixLPM));
+
+	if (!lpm)
+		return NULL;
+
+	pthread_mutex_init(&lpm->mutex, NULL);
+	lpm->radix = radix;
+	lpm->epoch = 1;
+
+	return lpm;
+}
+/**************************************************************************************************************************/
+void RadixLPMDestroy(RadixLPM *lpm)
+{
+	RadixLPMSnapshot *snapshot;
+
+	/* Sanity check */
+	if (!lpm)
+		return;
+
+	/* Caller guarantees no reader is left, drop everything */
+	while (lpm->retire_list)
+	{
+		snapshot			= lpm->retire_list;
+		lpm->retire_list	= snapshot->retire_next;
+		RadixLPMSnapshotDestroy(snapshot);
+	}
+
+	RadixLPMSnapshotDestroy(lpm->current);
+	pthread_mutex_destroy(&lpm->mutex);
+	free(lpm);
+
+	return;
+}
+/**************************************************************************************************************************/
+int RadixLPMPublish(RadixLPM *lpm)
+{
+	RadixLPMSnapshot *new_snapshot;
+	RadixLPMSnapshot *old_snapshot;
+
+	/* Sanity check */
+	if (!lpm)
+		return -1;
+
+	pthread_mutex_lock(&lpm->mutex);
+
+	/* Build outside readers view, radix tree must not be modified while we walk it */
+	new_snapshot = RadixLPMSnapshotBuild(lpm->radix);
+
+	if (!new_snapshot)
+	{
+		pthread_mutex_unlock(&lpm->mutex);
+		return -1;
+	}
+
+	/* Swap and stamp old snapshot with the epoch readers must reach before it can go away */
+	old_snapshot = __atomic_exchange_n(&lpm->current, new_snapshot, __ATOMIC_SEQ_CST);
+
+	if (old_snapshot)
+	{
+		old_snapshot->retire_epoch	= __atomic_add_fetch(&lpm->epoch, 1, __ATOMIC_SEQ_CST);
+		old_snapshot->retire_next	= lpm->retire_list;
+		lpm->retire_list			= old_snapshot;
+	}
+
+	pthread_mutex_unlock(&lpm->mutex);
+
+	RadixLPMReclaim(lpm);
+	return new_snapshot->data_count;
+}
+/**************************************************************************************************************************/
+int RadixLPMReclaim(RadixLPM *lpm)
+{
+	RadixLPMSnapshot **snapshot_ptr;
+	RadixLPMSnapshot *snapshot;
+	unsigned long min_epoch;
+	unsigned long reader_epoch;
+	int reclaim_count;
+	int i;
+
+	/* Sanity check */
+	if (!lpm)
+		return 0;
+
+	pthread_mutex_lock(&lpm->mutex);
+
+	/* Oldest epoch any registered reader may still be reading from */
+	for (min_epoch = ULONG_MAX, i = 0; i < RADIX_LPM_READER_MAX; i++)
+	{
+		if (!__atomic_load_n(&lpm->reader_arr[i].in_use, __ATOMIC_ACQUIRE))
+			continue;
+
+		reader_epoch	= __atomic_load_n(&lpm->reader_arr[i].epoch, __ATOMIC_ACQUIRE);
+		min_epoch		= ((reader_epoch < min_epoch) ? reader_epoch : min_epoch);
+	}
+
+	for (reclaim_count = 0, snapshot_ptr = &lpm->retire_list; *snapshot_ptr; )
+	{
+		snapshot = *snapshot_ptr;
+
+		if (snapshot->retire_epoch <= min_epoch)
+		{
+			*snapshot_ptr = snapshot->retire_next;
+			RadixLPMSnapshotDestroy(snapshot);
+			reclaim_count++;
+			continue;
+		}
+
+		snapshot_ptr = &snapshot->retire_next;
+	}
+
+	pthread_mutex_unlock(&lpm->mutex);
+	return reclaim_count;
+}
+/**************************************************************************************************************************/
+int RadixLPMReaderRegister(RadixLPM *lpm)
+{
+	int expected;
+	int i;
+
+	/* Sanity check */
+	if (!lpm)
+		return -1;
+
+	for (i = 0; i < RADIX_LPM_READER_MAX; i++)
+	{
+		expected = 0;
+
+		if (!__atomic_compare_exchange_n(&lpm->reader_arr[i].in_use, &expected, 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+			continue;
+
+		/* Nothing was read yet, so a stale epoch seen by reclaim in between is harmless */
+		__atomic_store_n(&lpm->reader_arr[i].epoch, __atomic_load_n(&lpm->epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+		return i;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+void RadixLPMReaderUnregister(RadixLPM *lpm, int reader_id)
+{
+	/* Sanity check */
+	if ((!lpm) || (reader_id < 0) || (reader_id >= RADIX_LPM_READER_MAX))
+		return;
+
+	__atomic_store_n(&lpm->reader_arr[reader_id].in_use, 0, __ATOMIC_RELEASE);
+	return;
+}
+/**************************************************************************************************************************/
+void RadixLPMReaderQuiescent(RadixLPM *lpm, int reader_id)
+{
+	/* Sanity check */
+	if ((!lpm) || (reader_id < 0) || (reader_id >= RADIX_LPM_READER_MAX))
+		return;
+
+	/* Reader holds no snapshot pointer here, anything retired up to current epoch is free to go */
+	__atomic_store_n(&lpm->reader_arr[reader_id].epoch, __atomic_load_n(&lpm->epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+	return;
+}
+/**************************************************************************************************************************/
+void *RadixLPMLookupV4(RadixLPM *lpm, struct in_addr *addr)
+{
+	RadixLPMSnapshot *snapshot;
+	unsigned int host_addr;
+	unsigned int entry;
+
+	snapshot = __atomic_load_n(&lpm->current, __ATOMIC_ACQUIRE);
+
+	/* Sanity check */
+	if ((!snapshot) || (!snapshot->tbl24))
+		return NULL;
+
+	host_addr	= ntohl(addr->s_addr);
+	entry		= snapshot->tbl24[host_addr >> 8];
+
+	if (entry & RADIX_LPM_ENTRY_EXT)
+		entry = snapshot->tbl8[((entry & RADIX_LPM_ENTRY_MASK) * RADIX_LPM_GROUP_SZ) + (host_addr & 0xFF)];
+
+	return snapshot->data_arr[entry];
+}
+/**************************************************************************************************************************/
+void *RadixLPMLookupV6(RadixLPM *lpm, struct in6_addr *addr)
+{
+	RadixLPMSnapshot *snapshot;
+
+	snapshot = __atomic_load_n(&lpm->current, __ATOMIC_ACQUIRE);
+
+	/* Sanity check */
+	if ((!snapshot) || (!snapshot->v6_root))
+		return NULL;
+
+	return snapshot->data_arr[RadixLPMSnapshotV6Resolve(snapshot, (unsigned char *)addr)];
+}
+/**************************************************************************************************************************/
+int RadixLPMLookupV4Batch(RadixLPM *lpm, struct in_addr *addr_arr, void **data_arr, int addr_count)
+{
+	RadixLPMSnapshot *snapshot;
+	unsigned int host_arr[RADIX_LPM_BATCH_PREFETCH];
+	unsigned int entry;
+	int chunk_count;
+	int hit_count;
+	int i, j;
+
+	snapshot = __atomic_load_n(&lpm->current, __ATOMIC_ACQUIRE);
+
+	/* Sanity check */
+	if ((!snapshot) || (!snapshot->tbl24))
+	{
+		memset(data_arr, 0, (addr_count * sizeof(void *)));
+		return 0;
+	}
+
+	for (hit_count = 0, i = 0; i < addr_count; i += chunk_count)
+	{
+		chunk_count = (((addr_count - i) > RADIX_LPM_BATCH_PREFETCH) ? RADIX_LPM_BATCH_PREFETCH : (addr_count - i));
+
+		/* First pass issues all tbl24 loads, so misses overlap instead of serializing */
+		for (j = 0; j < chunk_count; j++)
+		{
+			host_arr[j] = ntohl(addr_arr[i + j].s_addr);
+			__builtin_prefetch(&snapshot->tbl24[host_arr[j] >> 8]);
+		}
+
+		for (j = 0; j < chunk_count; j++)
+		{
+			entry = snapshot->tbl24[host_arr[j] >> 8];
+
+			if (entry & RADIX_LPM_ENTRY_EXT)
+				entry = snapshot->tbl8[((entry & RADIX_LPM_ENTRY_MASK) * RADIX_LPM_GROUP_SZ) + (host_arr[j] & 0xFF)];
+
+			data_arr[i + j]	= snapshot->data_arr[entry];
+			hit_count		+= (entry ? 1 : 0);
+		}
+	}
+
+	return hit_count;
+}
+/**************************************************************************************************************************/
+int RadixLPMLookupV6Batch(RadixLPM *lpm, struct in6_addr *addr_arr, void **data_arr, int addr_count)
+{
+	RadixLPMSnapshot *snapshot;
+	unsigned char *addr_ptr;
+	unsigned int entry;
+	int chunk_count;
+	int hit_count;
+	int i, j;
+
+	snapshot = __atomic_load_n(&lpm->current, __ATOMIC_ACQUIRE);
+
+	/* Sanity check */
+	if ((!snapshot) || (!snapshot->v6_root))
+	{
+		memset(data_arr, 0, (addr_count * sizeof(void *)));
+		return 0;
+	}
+
+	for (hit_count = 0, i = 0; i < addr_count; i += chunk_count)
+	{
+		chunk_count = (((addr_count - i) > RADIX_LPM_BATCH_PREFETCH) ? RADIX_LPM_BATCH_PREFETCH : (addr_count - i));
+
+		/* Prefetch root slots, deeper levels are usually shared and already cached */
+		for (j = 0; j < chunk_count; j++)
+		{
+			addr_ptr = (unsigned char *)&addr_arr[i + j];
+			__builtin_prefetch(&snapshot->v6_root[(addr_ptr[0] << 8) | addr_ptr[1]]);
+		}
+
+		for (j = 0; j < chunk_count; j++)
+		{
+			entry			= RadixLPMSnapshotV6Resolve(snapshot, (unsigned char *)&addr_arr[i + j]);
+			data_arr[i + j]	= snapshot->data_arr[entry];
+			hit_count		+= (entry ? 1 : 0);
+		}
+	}
+
+	return hit_count;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static int RadixLPMItemCompare(const void *item_a, const void *item_b)
+{
+	const RadixLPMItem *a = item_a;
+	const RadixLPMItem *b = item_b;
+
+	return ((int)a->prefix->bitlen - (int)b->prefix->bitlen);
+}
+/**************************************************************************************************************************/
+static RadixLPMSnapshot *RadixLPMSnapshotBuild(RadixTree *radix)
+{
+	RadixLPMSnapshot *snapshot;
+	RadixLPMItem *item_arr;
+	RadixNode *node;
+	int item_count;
+	int v4_count;
+	int v6_count;
+	int i;
+
+	/* Count prefixes per family */
+	item_count	= 0;
+	v4_count	= 0;
+	v6_count	= 0;
+
+	RADIX_WALK(radix->head, node)
+	{
+		if (AF_INET == node->prefix->family)
+			v4_count++;
+		else if (AF_INET6 == node->prefix->family)
+			v6_count++;
+	} RADIX_WALK_END;
+
+	snapshot	= calloc(1, sizeof(RadixLPMSnapshot));
+	item_arr	= calloc((v4_count + v6_count + 1), sizeof(RadixLPMItem));
+
+	if ((!snapshot) || (!item_arr))
+		goto build_failed;
+
+	snapshot->data_arr = calloc((v4_count + v6_count + 1), sizeof(void *));
+
+	if (!snapshot->data_arr)
+		goto build_failed;
+
+	RADIX_WALK(radix->head, node)
+	{
+		if ((AF_INET == node->prefix->family) || (AF_INET6 == node->prefix->family))
+		{
+			item_arr[item_count].prefix	= node->prefix;
+			item_arr[item_count].data	= node->data;
+			item_count++;
+		}
+	} RADIX_WALK_END;
+
+	/* Paint shorter prefixes first, longer ones override them */
+	qsort(item_arr, item_count, sizeof(RadixLPMItem), RadixLPMItemCompare);
+
+	if ((v4_count > 0) && (!(snapshot->tbl24 = calloc(RADIX_LPM_TBL24_SZ, sizeof(unsigned int)))))
+		goto build_failed;
+
+	if ((v6_count > 0) && (!(snapshot->v6_root = calloc(RADIX_LPM_V6_ROOT_SZ, sizeof(unsigned int)))))
+		goto build_failed;
+
+	/* Result index zero is reserved for no match */
+	for (snapshot->data_count = 1, i = 0; i < item_count; i++)
+	{
+		snapshot->data_arr[snapshot->data_count] = item_arr[i].data;
+
+		if (AF_INET == item_arr[i].prefix->family)
+		{
+			if (RadixLPMSnapshotV4Add(snapshot, item_arr[i].prefix, snapshot->data_count) < 0)
+				goto build_failed;
+		}
+		else if (RadixLPMSnapshotV6Add(snapshot, item_arr[i].prefix, snapshot->data_count) < 0)
+			goto build_failed;
+
+		snapshot->data_count++;
+	}
+
+	free(item_arr);
+	return snapshot;
+
+	build_failed:
+
+	free(item_arr);
+	RadixLPMSnapshotDestroy(snapshot);
+	return NULL;
+}
+/**************************************************************************************************************************/
+static void RadixLPMSnapshotDestroy(RadixLPMSnapshot *snapshot)
+{
+	/* Sanity check */
+	if (!snapshot)
+		return;
+
+	free(snapshot->tbl24);
+	free(snapshot->tbl8);
+	free(snapshot->v6_root);
+	free(snapshot->v6_node);
+	free(snapshot->data_arr);
+	free(snapshot);
+
+	return;
+}
+/**************************************************************************************************************************/
+static int RadixLPMSnapshotV4Add(RadixLPMSnapshot *snapshot, RadixPrefix *prefix, unsigned int data_idx)
+{
+	unsigned int host_addr;
+	unsigned int bitlen;
+	unsigned int first_idx;
+	unsigned int last_idx;
+	unsigned int entry;
+	unsigned int *group_ptr;
+	int group_idx;
+	unsigned int i, j;
+
+	bitlen		= ((prefix->bitlen > 32) ? 32 : prefix->bitlen);
+	host_addr	= ntohl(prefix->add.sin.s_addr);
+	host_addr	= (bitlen ? (host_addr & (0xFFFFFFFFU << (32 - bitlen))) : 0);
+
+	/* Up to /24, paint a span of tbl24 */
+	if (bitlen <= 24)
+	{
+		first_idx	= (host_addr >> 8);
+		last_idx	= (first_idx + (1U << (24 - bitlen)));
+
+		for (i = first_idx; i < last_idx; i++)
+		{
+			entry = snapshot->tbl24[i];
+
+			/* Ascending order means groups only come from longer prefixes, still keep them consistent */
+			if (entry & RADIX_LPM_ENTRY_EXT)
+			{
+				group_ptr = &snapshot->tbl8[(entry & RADIX_LPM_ENTRY_MASK) * RADIX_LPM_GROUP_SZ];
+
+				for (j = 0; j < RADIX_LPM_GROUP_SZ; j++)
+					group_ptr[j] = data_idx;
+
+				continue;
+			}
+
+			snapshot->tbl24[i] = data_idx;
+		}
+
+		return 0;
+	}
+
+	/* Longer than /24, expand slot into a tbl8 group inheriting what was there */
+	entry = snapshot->tbl24[host_addr >> 8];
+
+	if (!(entry & RADIX_LPM_ENTRY_EXT))
+	{
+		group_idx = RadixLPMSnapshotGroupNew(&snapshot->tbl8, &snapshot->tbl8_group_count, &snapshot->tbl8_group_capacity, entry);
+
+		if (group_idx < 0)
+			return -1;
+
+		entry = (RADIX_LPM_ENTRY_EXT | group_idx);
+		snapshot->tbl24[host_addr >> 8] = entry;
+	}
+
+	group_ptr	= &snapshot->tbl8[(entry & RADIX_LPM_ENTRY_MASK) * RADIX_LPM_GROUP_SZ];
+	first_idx	= (host_addr & 0xFF);
+	last_idx	= (first_idx + (1U << (32 - bitlen)));
+
+	for (i = first_idx; i < last_idx; i++)
+		group_ptr[i] = data_idx;
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static int RadixLPMSnapshotV6Add(RadixLPMSnapshot *snapshot, RadixPrefix *prefix, unsigned int data_idx)
+{
+	unsigned char addr[16];
+	unsigned int *level_ptr;
+	unsigned int level_bits;
+	unsigned int entry;
+	unsigned int slot_idx;
+	unsigned int span_count;
+	unsigned int bitlen;
+	unsigned int depth;
+	unsigned int i;
+	int level_idx;
+	int node_idx;
+
+	bitlen = ((prefix->bitlen > 128) ? 128 : prefix->bitlen);
+	memcpy(addr, &prefix->add.sin6, sizeof(addr));
+
+	/* Clear host bits so spans start aligned */
+	for (i = 0; i < 16; i++)
+	{
+		if ((i * 8) >= bitlen)
+			addr[i] = 0;
+		else if (((i + 1) * 8) > bitlen)
+			addr[i] &= (0xFF << (((i + 1) * 8) - bitlen));
+	}
+
+	/* Root consumes 16 bits, every level below consumes 8. Node array may realloc, so hold indexes only */
+	level_idx	= -1;
+	level_bits	= 16;
+	slot_idx	= ((addr[0] << 8) | addr[1]);
+	depth		= 2;
+
+	while (bitlen > level_bits)
+	{
+		entry = ((level_idx < 0) ? snapshot->v6_root[slot_idx] : snapshot->v6_node[(level_idx * RADIX_LPM_GROUP_SZ) + slot_idx]);
+
+		if (!(entry & RADIX_LPM_ENTRY_EXT))
+		{
+			node_idx = RadixLPMSnapshotGroupNew(&snapshot->v6_node, &snapshot->v6_node_count, &snapshot->v6_node_capacity, entry);
+
+			if (node_idx < 0)
+				return -1;
+
+			entry = (RADIX_LPM_ENTRY_EXT | node_idx);
+
+			if (level_idx < 0)
+				snapshot->v6_root[slot_idx] = entry;
+			else
+				snapshot->v6_node[(level_idx * RADIX_LPM_GROUP_SZ) + slot_idx] = entry;
+		}
+
+		level_idx	= (entry & RADIX_LPM_ENTRY_MASK);
+		level_bits	+= 8;
+		slot_idx	= addr[depth++];
+	}
+
+	level_ptr = ((level_idx < 0) ? snapshot->v6_root : &snapshot->v6_node[level_idx * RADIX_LPM_GROUP_SZ]);
+
+	/* Paint every slot covered by the prefix on this level */
+	span_count = (1U << (level_bits - bitlen));
+
+	for (i = 0; i < span_count; i++)
+		RadixLPMSnapshotV6Fill(snapshot, &level_ptr[slot_idx + i], data_idx);
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static int RadixLPMSnapshotGroupNew(unsigned int **group_arr_ptr, int *group_count_ptr, int *group_capacity_ptr, unsigned int fill_entry)
+{
+	unsigned int *new_arr;
+	int new_capacity;
+	int group_idx;
+	int i;
+
+	if (*group_count_ptr >= *group_capacity_ptr)
+	{
+		new_capacity	= ((*group_capacity_ptr > 0) ? (*group_capacity_ptr * 2) : 256);
+		new_arr			= realloc(*group_arr_ptr, ((size_t)new_capacity * RADIX_LPM_GROUP_SZ * sizeof(unsigned int)));
+
+		if (!new_arr)
+			return -1;
+
+		*group_arr_ptr		= new_arr;
+		*group_capacity_ptr	= new_capacity;
+	}
+
+	group_idx = (*group_count_ptr)++;
+
+	for (i = 0; i < RADIX_LPM_GROUP_SZ; i++)
+		(*group_arr_ptr)[(group_idx * RADIX_LPM_GROUP_SZ) + i] = fill_entry;
+
+	return group_idx;
+}
+/**************************************************************************************************************************/
+static void RadixLPMSnapshotV6Fill(RadixLPMSnapshot *snapshot, unsigned int *entry_ptr, unsigned int data_idx)
+{
+	unsigned int *node_ptr;
+	int i;
+
+	if (!(*entry_ptr & RADIX_LPM_ENTRY_EXT))
+	{
+		*entry_ptr = data_idx;
+		return;
+	}
+
+	/* Push down into an already expanded child */
+	node_ptr = &snapshot->v6_node[(*entry_ptr & RADIX_LPM_ENTRY_MASK) * RADIX_LPM_GROUP_SZ];
+
+	for (i = 0; i < RADIX_LPM_GROUP_SZ; i++)
+		RadixLPMSnapshotV6Fill(snapshot, &node_ptr[i], data_idx);
+
+	return;
+}
+/**************************************************************************************************************************/
+static unsigned int RadixLPMSnapshotV6Resolve(RadixLPMSnapshot *snapshot, unsigned char *addr)
+{
+	unsigned int entry;
+	int depth;
+
+	entry = snapshot->v6_root[(addr[0] << 8) | addr[1]];
+
+	/* Leaves at the deepest level are never expanded, so this ends by byte 16 */
+	for (depth = 2; (entry & RADIX_LPM_ENTRY_EXT); depth++)
+		entry = snapshot->v6_node[((entry & RADIX_LPM_ENTRY_MASK) * RADIX_LPM_GROUP_SZ) + addr[depth]];
+
+	return entry;
+}
+/**************************************************************************************************************************/
@@ -830,7 +830,7 @@ MemBuffer *MemBufferMappedMetaDataPackToMB(MemBufferMapped *mapped_mb, long item
 
 	/* Pack data into METADATA SERIALIZER and DUMP it into MEMBUFFER */
 	MemBufferMappedMetaDataPack(mapped_mb, &metadata, item_sub_id);
-	MetaDataPack(&metadata, packed_mb);
+	MetaDataPackV2(&metadata, packed_mb, METADATA_CHECKSUM_CRC32C);
 
 	/* Clean UP METDATA and leave */
 	MetaDataClean(&metadata);
@@ -36,6 +36,11 @@
 #include "../include/libbrb_core.h"
 
 static int MetaDataHeaderLoadData(MetaData *meta_data, MetaDataHeader *meta_data_hdr);
+static int MetaDataUnpackV2(MetaData *meta_data, MemBuffer *meta_data_mb, MetaDataUnpackerInfo *unpacker_info);
+static int MetaDataChecksumCalc(unsigned int checksum_type, char *data_ptr, unsigned long data_sz, char *ret_digest);
+static unsigned long MetaDataIndexHash(unsigned long item_id, unsigned long item_sub_id);
+
+#define METADATA_V2_ALIGN_SZ(sz)	(((sz) + (METADATA_V2_ALIGN - 1)) & ~((unsigned long)(METADATA_V2_ALIGN - 1)))
 
 /**************************************************************************************************************************/
 MetaData *MetaDataNew(void)
@@ -81,6 +86,7 @@ int MetaDataReset(MetaData *meta_data)
 
 	meta_data->items.count	= 0;
 	meta_data->raw_data		= NULL;
+	memset(&meta_data->view, 0, sizeof(MetaDataView));
 
 	return 1;
 }
@@ -96,8 +102,10 @@ int MetaDataClean(MetaData *meta_data)
 
 	/* Reset DATA */
 	meta_data->items.arena			= NULL;
+	meta_data->items.count			= 0;
 	meta_data->raw_data				= NULL;
 	meta_data->flags.initialized	= 0;
+	memset(&meta_data->view, 0, sizeof(MetaDataView));
 	return 1;
 }
 /**************************************************************************************************************************/
@@ -142,6 +150,98 @@ int MetaDataPack(MetaData *meta_data, MemBuffer *meta_data_mb)
 	return 1;
 }
 /**************************************************************************************************************************/
+int MetaDataPackV2(MetaData *meta_data, MemBuffer *meta_data_mb, MetaDataChecksumType checksum_type)
+{
+	MetaDataHeader meta_data_hdr;
+	MetaDataHeader *packed_hdr;
+	MetaDataIndexItem index_item;
+	MetaDataItem *meta_item;
+	char pad_arr[METADATA_V2_ALIGN];
+	unsigned int *bucket_arr;
+	unsigned long bucket_sz;
+	unsigned long base_offset;
+	unsigned long data_offset;
+	unsigned long bucket_idx;
+	int bucket_count;
+	int i;
+
+	/* Sanity check */
+	if ((!meta_data) || (!meta_data_mb) || (checksum_type >= METADATA_CHECKSUM_LASTITEM))
+		return 0;
+
+	/* Bucket table at least twice the item count, power of two, so probing always meets an empty slot */
+	for (bucket_count = ((meta_data->items.count > 0) ? 8 : 0); bucket_count < (meta_data->items.count * 2); bucket_count <<= 1);
+
+	bucket_sz	= (bucket_count * sizeof(unsigned int));
+	data_offset	= (sizeof(MetaDataHeader) + (meta_data->items.count * sizeof(MetaDataIndexItem)) + METADATA_V2_ALIGN_SZ(bucket_sz));
+	base_offset	= meta_data_mb->size;
+
+	/* Clean up stack and write HEADER, SIZE and DIGEST are patched once body is in place */
+	memset(&meta_data_hdr, 0, sizeof(MetaDataHeader));
+	memset(&pad_arr, 0, sizeof(pad_arr));
+	memcpy(&meta_data_hdr.str, METADATA_MAGIC_HEADER, METADATA_MAGIC_HEADER_SZ);
+
+	meta_data_hdr.version		= METADATA_VERSION_V2;
+	meta_data_hdr.item_count	= meta_data->items.count;
+	meta_data_hdr.checksum_type	= checksum_type;
+	meta_data_hdr.bucket_count	= bucket_count;
+	MemBufferAdd(meta_data_mb, &meta_data_hdr, sizeof(MetaDataHeader));
+
+	/* Index keeps insertion order, so IDX here is the same IDX the unpacker will use on its arena */
+	for (i = 0; i < meta_data->items.count; i++)
+	{
+		meta_item = MemArenaGrabByID(meta_data->items.arena, i);
+
+		index_item.item_id		= meta_item->item_id;
+		index_item.item_sub_id	= meta_item->item_sub_id;
+		index_item.offset		= data_offset;
+		index_item.sz			= meta_item->sz;
+		MemBufferAdd(meta_data_mb, &index_item, sizeof(MetaDataIndexItem));
+
+		data_offset += METADATA_V2_ALIGN_SZ(meta_item->sz);
+		continue;
+	}
+
+	/* Build open addressing buckets holding (IDX + 1), first inserted wins on duplicated IDs */
+	if (bucket_count > 0)
+	{
+		bucket_arr = calloc(bucket_count, sizeof(unsigned int));
+
+		for (i = 0; i < meta_data->items.count; i++)
+		{
+			meta_item	= MemArenaGrabByID(meta_data->items.arena, i);
+			bucket_idx	= (MetaDataIndexHash(meta_item->item_id, meta_item->item_sub_id) & (bucket_count - 1));
+
+			while (METADATA_V2_BUCKET_EMPTY != bucket_arr[bucket_idx])
+				bucket_idx = ((bucket_idx + 1) & (bucket_count - 1));
+
+			bucket_arr[bucket_idx] = (i + 1);
+			continue;
+		}
+
+		MemBufferAdd(meta_data_mb, bucket_arr, bucket_sz);
+		MemBufferAdd(meta_data_mb, &pad_arr, (METADATA_V2_ALIGN_SZ(bucket_sz) - bucket_sz));
+		free(bucket_arr);
+	}
+
+	/* Now DATA, each item aligned */
+	for (i = 0; i < meta_data->items.count; i++)
+	{
+		meta_item = MemArenaGrabByID(meta_data->items.arena, i);
+
+		MemBufferAdd(meta_data_mb, meta_item->ptr, meta_item->sz);
+		MemBufferAdd(meta_data_mb, &pad_arr, (METADATA_V2_ALIGN_SZ(meta_item->sz) - meta_item->sz));
+		continue;
+	}
+
+	/* MB may have moved while growing, grab HEADER back and seal it */
+	packed_hdr			= (MetaDataHeader *)(meta_data_mb->data + base_offset);
+	packed_hdr->size	= (data_offset - sizeof(MetaDataHeader));
+
+	MetaDataChecksumCalc(checksum_type, ((char *)packed_hdr + sizeof(MetaDataHeader)), packed_hdr->size, (char *)&packed_hdr->digest);
+	return 1;
+}
+/**************************************************************************************************************************/
 int MetaDataUnpack(MetaData *meta_data, MemBuffer *meta_data_mb, MetaDataUnpackerInfo *unpacker_info)
 {
 	MetaDataHeader *meta_data_hdr;
@@ -191,6 +291,13 @@ int MetaDataUnpack(MetaData *meta_data, MemBuffer *meta_data_mb, MetaDataUnpacke
 		goto error;
 	}
 
+	/* Indexed layout, read it in place */
+	if (METADATA_VERSION_V2 == meta_data_hdr->version)
+		return MetaDataUnpackV2(meta_data, meta_data_mb, unpacker_info);
+
+	/* Legacy stream has no index, drop any left from a previous V2 unpack */
+	memset(&meta_data->view, 0, sizeof(MetaDataView));
+
 	/* Set offset to bypass HEADER */
 	MemBufferOffsetIncrement(meta_data->raw_data, (sizeof(MetaDataHeader)));
 	cur_offset += sizeof(MetaDataHeader);
@@ -354,10 +461,25 @@ int MetaDataItemAdd(MetaData *meta_data, unsigned long item_id, unsigned long it
 MetaDataItem *MetaDataItemGrabMetaByID(MetaData *meta_data, unsigned long item_id, unsigned long item_sub_id)
 {
 	MetaDataItem *meta_item;
+	long view_idx;
 	int i;
 
+	i = meta_data->item_offset;
+
+	/* Unpacked from V2, items that came from it are found by hashed index */
+	if ((meta_data->view.header) && (0 == meta_data->item_offset))
+	{
+		view_idx = MetaDataViewFindIdx(&meta_data->view, item_id, item_sub_id);
+
+		if (view_idx >= 0)
+			return MemArenaGrabByID(meta_data->items.arena, view_idx);
+
+		/* Only items added after unpack are left to walk */
+		i = meta_data->view.item_count;
+	}
+
 	/* Now walk all items */
-	for (i = meta_data->item_offset; i < meta_data->items.count; i++)
+	for (; i < meta_data->items.count; i++)
 	{
 		meta_item = MemArenaGrabByID(meta_data->items.arena, i);
 
@@ -374,21 +496,243 @@ MetaDataItem *MetaDataItemGrabMetaByID(MetaData *meta_data, unsigned long item_i
 void *MetaDataItemFindByID(MetaData *meta_data, unsigned long item_id, unsigned long item_sub_id)
 {
 	MetaDataItem *meta_item;
-	int i;
 
-	/* Now walk all items */
-	for (i = meta_data->item_offset; i < meta_data->items.count; i++)
+	meta_item = MetaDataItemGrabMetaByID(meta_data, item_id, item_sub_id);
+	return (meta_item ? meta_item->ptr : NULL);
+}
+/**************************************************************************************************************************/
+int MetaDataViewOpen(MetaDataView *meta_view, void *data_ptr, unsigned long data_sz, int verify)
+{
+	MetaDataHeader *meta_data_hdr;
+	char digest_arr[16];
+	unsigned long index_sz;
+	unsigned long bucket_sz;
+
+	/* Clean up view */
+	memset(meta_view, 0, sizeof(MetaDataView));
+
+	/* Sanity check */
+	if (!data_ptr)
+		return METADATA_UNPACK_FAILED_NO_RAWDATA;
+
+	if (data_sz < sizeof(MetaDataHeader))
+		return METADATA_UNPACK_FAILED_NEED_MORE_DATA_METAITEM;
+
+	meta_data_hdr = data_ptr;
+
+	/* METADATA string DO NOT MATCH, bail out */
+	if (memcmp(&meta_data_hdr->str, METADATA_MAGIC_HEADER, METADATA_MAGIC_HEADER_SZ))
+		return METADATA_UNPACK_FAILED_INVALID_HEADER_MAGIC;
+
+	/* Only V2 can be read in place, V1 must go through MetaDataUnpack */
+	if ((METADATA_VERSION_V2 != meta_data_hdr->version) || (meta_data_hdr->checksum_type >= METADATA_CHECKSUM_LASTITEM))
+		return METADATA_UNPACK_FAILED_INVALID_VERSION;
+
+	if (meta_data_hdr->size > (data_sz - sizeof(MetaDataHeader)))
+		return METADATA_UNPACK_FAILED_NEED_MORE_DATA_OBJECT;
+
+	/* Index and buckets must fit in body, and buckets must be a power of two bigger than item count */
+	if ((meta_data_hdr->item_count < 0) || (meta_data_hdr->item_count > (meta_data_hdr->size / sizeof(MetaDataIndexItem))))
+		return METADATA_UNPACK_FAILED_CORRUPTED_INDEX;
+
+	if ((meta_data_hdr->item_count > 0) && ((meta_data_hdr->bucket_count <= meta_data_hdr->item_count) || (meta_data_hdr->bucket_count & (meta_data_hdr->bucket_count - 1))))
+		return METADATA_UNPACK_FAILED_CORRUPTED_INDEX;
+
+	index_sz	= (meta_data_hdr->item_count * sizeof(MetaDataIndexItem));
+	bucket_sz	= (meta_data_hdr->bucket_count * sizeof(unsigned int));
+
+	if ((meta_data_hdr->bucket_count > (meta_data_hdr->size / sizeof(unsigned int))) || ((index_sz + bucket_sz) > meta_data_hdr->size))
+		return METADATA_UNPACK_FAILED_CORRUPTED_INDEX;
+
+	/* Digest whole body, can be skipped by callers that trust the source */
+	if (verify)
 	{
-		meta_item = MemArenaGrabByID(meta_data->items.arena, i);
+		memset(&digest_arr, 0, sizeof(digest_arr));
+		MetaDataChecksumCalc(meta_data_hdr->checksum_type, ((char *)data_ptr + sizeof(MetaDataHeader)), meta_data_hdr->size, (char *)&digest_arr);
 
-		/* DYN_BITMAP METADATA, populate back */
-		if ((item_id == meta_item->item_id) && (item_sub_id == meta_item->item_sub_id))
-			return meta_item->ptr;
+		if (memcmp(&digest_arr, &meta_data_hdr->digest, sizeof(digest_arr)))
+			return METADATA_UNPACK_FAILED_DIGEST_INVALID;
+	}
+
+	/* Point into data, nothing is copied */
+	meta_view->header		= meta_data_hdr;
+	meta_view->base_ptr		= data_ptr;
+	meta_view->base_sz		= data_sz;
+	meta_view->item_count	= meta_data_hdr->item_count;
+	meta_view->index_arr	= (MetaDataIndexItem *)((char *)data_ptr + sizeof(MetaDataHeader));
+	meta_view->bucket_arr	= (unsigned int *)((char *)meta_view->index_arr + index_sz);
+
+	return METADATA_UNPACK_SUCCESS;
+}
+/**************************************************************************************************************************/
+int MetaDataViewOpenFile(MetaDataView *meta_view, char *file_path, int verify)
+{
+	struct stat file_stat;
+	void *mmap_ptr;
+	int op_status;
+	int fd;
+
+	/* Clean up view */
+	memset(meta_view, 0, sizeof(MetaDataView));
+
+	/* Sanity check */
+	if (!file_path)
+		return METADATA_UNPACK_FAILED_NO_RAWDATA;
+
+	fd = open(file_path, O_RDONLY);
+
+	/* Failed opening file */
+	if (fd < 0)
+		return METADATA_UNPACK_FAILED_NO_RAWDATA;
+
+	/* Acquire file status information */
+	op_status = fstat(fd, &file_stat);
+
+	/* Too small to even hold a HEADER */
+	if ((op_status < 0) || (file_stat.st_size < sizeof(MetaDataHeader)))
+	{
+		close(fd);
+		return METADATA_UNPACK_FAILED_NEED_MORE_DATA_METAITEM;
+	}
+
+	/* Map read only and let pages fault in as the index is touched */
+	mmap_ptr = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	if (MAP_FAILED == mmap_ptr)
+	{
+		close(fd);
+		return METADATA_UNPACK_FAILED_NO_RAWDATA;
+	}
+
+	op_status = MetaDataViewOpen(meta_view, mmap_ptr, file_stat.st_size, verify);
+
+	/* Failed validating, unmap and leave */
+	if (METADATA_UNPACK_SUCCESS != op_status)
+	{
+		munmap(mmap_ptr, file_stat.st_size);
+		close(fd);
+		return op_status;
+	}
+
+	meta_view->mmap_fd		= fd;
+	meta_view->flags.mapped	= 1;
+
+	return METADATA_UNPACK_SUCCESS;
+}
+/**************************************************************************************************************************/
+int MetaDataViewClose(MetaDataView *meta_view)
+{
+	/* Sanity check */
+	if (!meta_view)
+		return 0;
+
+	/* We own the mapping, release it */
+	if (meta_view->flags.mapped)
+	{
+		munmap(meta_view->base_ptr, meta_view->base_sz);
+		close(meta_view->mmap_fd);
+	}
+
+	memset(meta_view, 0, sizeof(MetaDataView));
+	return 1;
+}
+/**************************************************************************************************************************/
+int MetaDataViewGetCount(MetaDataView *meta_view)
+{
+	/* Sanity check */
+	if ((!meta_view) || (!meta_view->header))
+		return 0;
+
+	return meta_view->item_count;
+}
+/**************************************************************************************************************************/
+long MetaDataViewFindIdx(MetaDataView *meta_view, unsigned long item_id, unsigned long item_sub_id)
+{
+	MetaDataIndexItem *index_item;
+	unsigned long bucket_mask;
+	unsigned long bucket_idx;
+	unsigned int bucket_value;
+	unsigned int probe_count;
+
+	/* Sanity check */
+	if ((!meta_view) || (!meta_view->header) || (meta_view->item_count <= 0))
+		return -1;
+
+	bucket_mask	= (meta_view->header->bucket_count - 1);
+	bucket_idx	= (MetaDataIndexHash(item_id, item_sub_id) & bucket_mask);
+
+	/* Linear probing until an empty bucket. Bounded, so a corrupted table can not loop us */
+	for (probe_count = 0; probe_count < meta_view->header->bucket_count; probe_count++)
+	{
+		bucket_value = meta_view->bucket_arr[bucket_idx];
+
+		if ((METADATA_V2_BUCKET_EMPTY == bucket_value) || (bucket_value > meta_view->item_count))
+			return -1;
 
+		index_item = &meta_view->index_arr[bucket_value - 1];
+
+		/* Found it */
+		if ((item_id == index_item->item_id) && (item_sub_id == index_item->item_sub_id))
+			return (bucket_value - 1);
+
+		bucket_idx = ((bucket_idx + 1) & bucket_mask);
 		continue;
 	}
 
-	return NULL;
+	return -1;
+}
+/**************************************************************************************************************************/
+MetaDataIndexItem *MetaDataViewGrabByIdx(MetaDataView *meta_view, int item_idx)
+{
+	/* Sanity check */
+	if ((!meta_view) || (!meta_view->header) || (item_idx < 0) || (item_idx >= meta_view->item_count))
+		return NULL;
+
+	return &meta_view->index_arr[item_idx];
+}
+/**************************************************************************************************************************/
+MetaDataIndexItem *MetaDataViewGrabByID(MetaDataView *meta_view, unsigned long item_id, unsigned long item_sub_id)
+{
+	long item_idx;
+
+	item_idx = MetaDataViewFindIdx(meta_view, item_id, item_sub_id);
+
+	/* Not found */
+	if (item_idx < 0)
+		return NULL;
+
+	return &meta_view->index_arr[item_idx];
+}
+/**************************************************************************************************************************/
+void *MetaDataViewFindByID(MetaDataView *meta_view, unsigned long item_id, unsigned long item_sub_id, unsigned long *ret_sz)
+{
+	MetaDataIndexItem *index_item;
+	void *data_ptr;
+
+	index_item	= MetaDataViewGrabByID(meta_view, item_id, item_sub_id);
+	data_ptr	= MetaDataViewItemDeref(meta_view, index_item);
+
+	if (ret_sz)
+		*ret_sz = (data_ptr ? index_item->sz : 0);
+
+	return data_ptr;
+}
+/**************************************************************************************************************************/
+void *MetaDataViewItemDeref(MetaDataView *meta_view, MetaDataIndexItem *index_item)
+{
+	unsigned long total_sz;
+
+	/* Sanity check */
+	if ((!meta_view) || (!meta_view->header) || (!index_item))
+		return NULL;
+
+	total_sz = (sizeof(MetaDataHeader) + meta_view->header->size);
+
+	/* Entries are checked on access, so opening stays O(1) even for huge unverified files */
+	if ((index_item->offset < sizeof(MetaDataHeader)) || (index_item->offset > total_sz) || (index_item->sz > (total_sz - index_item->offset)))
+		return NULL;
+
+	return (meta_view->base_ptr + index_item->offset);
 }
 /**************************************************************************************************************************/
 /**/
@@ -436,3 +780,114 @@ static int MetaDataHeaderLoadData(MetaData *meta_data, MetaDataHeader *meta_data
 	return 1;
 }
 /**************************************************************************************************************************/
+static int MetaDataUnpackV2(MetaData *meta_data, MemBuffer *meta_data_mb, MetaDataUnpackerInfo *unpacker_info)
+{
+	MetaDataIndexItem *index_item;
+	MetaDataHeader *meta_data_hdr;
+	void *data_ptr;
+	int view_status;
+	int i;
+
+	unsigned long cur_remaining		= MemBufferGetSize(meta_data_mb);
+	unsigned long cur_offset		= MemBufferOffsetGet(meta_data_mb);
+	unsigned long cur_needed		= 0;
+	int item_base					= meta_data->items.count;
+
+	meta_data_hdr	= MemBufferDeref(meta_data_mb);
+	view_status		= MetaDataViewOpen(&meta_data->view, meta_data_hdr, cur_remaining, 1);
+
+	if (METADATA_UNPACK_SUCCESS != view_status)
+	{
+		/* Calculate needed bytes */
+		if (METADATA_UNPACK_FAILED_NEED_MORE_DATA_OBJECT == view_status)
+			cur_needed = ((sizeof(MetaDataHeader) + meta_data_hdr->size) - cur_remaining);
+
+		goto leave;
+	}
+
+	/* Items point straight into RAW_DATA, nothing is copied */
+	for (i = 0; i < meta_data->view.item_count; i++)
+	{
+		index_item	= MetaDataViewGrabByIdx(&meta_data->view, i);
+		data_ptr	= MetaDataViewItemDeref(&meta_data->view, index_item);
+
+		/* Entry points outside of body */
+		if (!data_ptr)
+		{
+			view_status = METADATA_UNPACK_FAILED_CORRUPTED_INDEX;
+			goto leave;
+		}
+
+		MetaDataItemAdd(meta_data, index_item->item_id, index_item->item_sub_id, data_ptr, index_item->sz);
+		continue;
+	}
+
+	/* Recalculate CUR_OFFSET and CUR_REMAINING data */
+	cur_offset		+= (sizeof(MetaDataHeader) + meta_data_hdr->size);
+	cur_remaining	-= (sizeof(MetaDataHeader) + meta_data_hdr->size);
+
+	/* Index IDX only maps to arena IDX if we started empty */
+	if (item_base > 0)
+		memset(&meta_data->view, 0, sizeof(MetaDataView));
+
+	/* TAG to fill in results */
+	leave:
+
+	if (METADATA_UNPACK_SUCCESS != view_status)
+		memset(&meta_data->view, 0, sizeof(MetaDataView));
+
+	/* Fill in UNPACKER_INFO information */
+	if (unpacker_info)
+	{
+		unpacker_info->error_code		= view_status;
+		unpacker_info->cur_offset		= cur_offset;
+		unpacker_info->cur_remaining	= cur_remaining;
+		unpacker_info->cur_needed		= cur_needed;
+	}
+
+	return view_status;
+}
+/**************************************************************************************************************************/
+static int MetaDataChecksumCalc(unsigned int checksum_type, char *data_ptr, unsigned long data_sz, char *ret_digest)
+{
+	BRB_MD5_CTX md5_digest;
+	uint32_t crc_value;
+
+	/* Clean up digest, CRC32C only fills first four bytes */
+	memset(ret_digest, 0, 16);
+
+	switch (checksum_type)
+	{
+	case METADATA_CHECKSUM_CRC32C:
+		crc_value = BRB_CRC32C(data_ptr, data_sz);
+		memcpy(ret_digest, &crc_value, sizeof(uint32_t));
+		return 1;
+
+	case METADATA_CHECKSUM_MD5:
+		memset(&md5_digest, 0, sizeof(BRB_MD5_CTX));
+		BRB_MD5Init(&md5_digest);
+		BRB_MD5UpdateBig(&md5_digest, data_ptr, data_sz);
+		BRB_MD5Final(&md5_digest);
+		memcpy(ret_digest, &md5_digest.digest, 16);
+		return 1;
+
+	default:
+		return 0;
+	}
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static unsigned long MetaDataIndexHash(unsigned long item_id, unsigned long item_sub_id)
+{
+	unsigned long long hash_value;
+
+	/* Mix both IDs, then a 64 bit finalizer so sequential IDs spread over buckets */
+	hash_value	= (((unsigned long long)item_id * 0x9E3779B97F4A7C15ULL) ^ ((unsigned long long)item_sub_id * 0xC2B2AE3D27D4EB4FULL));
+	hash_value	^= (hash_value >> 32);
+	hash_value	*= 0xD6E8FEB86659FD93ULL;
+	hash_value	^= (hash_value >> 32);
+
+	return (unsigned long)hash_value;
+}
+/**************************************************************************************************************************/
@@ -0,0 +1,823 @@
+/*
+ * speed_regex_set.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../include/libbrb_core.h"
+
+/* Many wildcard patterns compiled into a single Aho-Corasick automaton over their literal fragments. Every
+ * pattern keeps a greedy ordered cursor, advanced when its next fragment ends after the previous one. Fragments
+ * shared by many patterns are stored once, so a single pass over data reports all matching pattern IDs */
+
+static int SpeedRegExSetArrayGrow(void **arr_ptr, int *capacity_ptr, int need_count, int elem_sz);
+static int SpeedRegExSetNodeNew(SpeedRegExSet *spdreg_set, int label);
+static int SpeedRegExSetChildGrab(SpeedRegExSet *spdreg_set, int parent_id, int label);
+static int SpeedRegExSetRefAdd(SpeedRegExSet *spdreg_set, int node_id, int pattern_idx, int frag_idx);
+static int SpeedRegExSetGoto(SpeedRegExSet *spdreg_set, int state_id, int label);
+static int SpeedRegExSetScratchNew(SpeedRegExSet *spdreg_set);
+static void SpeedRegExSetAutomatonClean(SpeedRegExSet *spdreg_set);
+static int SpeedRegExSetLoadChunk(char **cur_ptr, unsigned long *remain_ptr, void **dst_ptr, unsigned long chunk_sz);
+static int SpeedRegExSetLoadValidate(SpeedRegExSet *spdreg_set);
+
+/**************************************************************************************************************************/
+SpeedRegExSet *SpeedRegExSetNew(SpeedRegexType type)
+{
+	SpeedRegExSet *spdreg_set;
+
+	spdreg_set = calloc(1, sizeof(SpeedRegExSet));
+
+	/* Sanity check */
+	if (!spdreg_set)
+		return NULL;
+
+	spdreg_set->spdreg_type	= type;
+	spdreg_set->scratch.gen	= 1;
+
+	if (SPDREGEX_MT_SAFE == type)
+		pthread_mutex_init(&spdreg_set->mutex, NULL);
+
+	/* Create root node */
+	if (SpeedRegExSetNodeNew(spdreg_set, -1) < 0)
+	{
+		SpeedRegExSetDestroy(spdreg_set);
+		return NULL;
+	}
+
+	return spdreg_set;
+}
+/**************************************************************************************************************************/
+void SpeedRegExSetDestroy(SpeedRegExSet *spdreg_set)
+{
+	/* Sanity check */
+	if (!spdreg_set)
+		return;
+
+	SpeedRegExSetAutomatonClean(spdreg_set);
+
+	free(spdreg_set->pattern.arr);
+	free(spdreg_set->build.node_arr);
+	free(spdreg_set->build.ref_arr);
+
+	if (SPDREGEX_MT_SAFE == spdreg_set->spdreg_type)
+		pthread_mutex_destroy(&spdreg_set->mutex);
+
+	free(spdreg_set);
+	return;
+}
+/**************************************************************************************************************************/
+int SpeedRegExSetAdd(SpeedRegExSet *spdreg_set, char *speed_regex, int pattern_id)
+{
+	SpeedRegExSetPattern *pattern;
+	StringArray *frag_arr;
+	char *frag_str;
+	int frag_count;
+	int pattern_idx;
+	int elem_count;
+	int node_id;
+	int frag_sz;
+	int i;
+
+	/* Sanity check */
+	if ((!spdreg_set) || (!speed_regex))
+		return -1;
+
+	/* Loaded sets have no build trie to extend */
+	if (spdreg_set->flags.loaded)
+		return -1;
+
+	if (SpeedRegExSetArrayGrow((void **)&spdreg_set->pattern.arr, &spdreg_set->pattern.capacity, (spdreg_set->pattern.count + 1), sizeof(SpeedRegExSetPattern)) < 0)
+		return -1;
+
+	/* Same fragment split as SpeedRegExCompile */
+	frag_arr	= StringArrayExplodeStr(speed_regex, "*", "\\", NULL);
+	elem_count	= (frag_arr ? StringArrayGetElemCount(frag_arr) : 0);
+	pattern_idx	= spdreg_set->pattern.count;
+	pattern		= &spdreg_set->pattern.arr[pattern_idx];
+
+	memset(pattern, 0, sizeof(SpeedRegExSetPattern));
+	pattern->pattern_id = pattern_id;
+
+	/* No wildcard at all, data must be exactly this string */
+	if (elem_count <= 1)
+		pattern->anchor_flags = (SPDREGEX_SET_ANCHOR_BEGIN | SPDREGEX_SET_ANCHOR_FINISH);
+	else
+	{
+		if (StringArrayGetDataSizeByPos(frag_arr, 0) > 0)
+			pattern->anchor_flags |= SPDREGEX_SET_ANCHOR_BEGIN;
+
+		if (StringArrayGetDataSizeByPos(frag_arr, (elem_count - 1)) > 0)
+			pattern->anchor_flags |= SPDREGEX_SET_ANCHOR_FINISH;
+	}
+
+	/* Insert every non empty fragment in trie, empty ones come from consecutive wildcards */
+	for (frag_count = 0, i = 0; i < elem_count; i++)
+	{
+		frag_str	= StringArrayGetDataByPos(frag_arr, i);
+		frag_sz		= StringArrayGetDataSizeByPos(frag_arr, i);
+
+		if ((!frag_str) || (frag_sz <= 0))
+			continue;
+
+		for (node_id = 0; frag_sz > 0; frag_str++, frag_sz--)
+		{
+			node_id = SpeedRegExSetChildGrab(spdreg_set, node_id, (unsigned char)*frag_str);
+
+			if (node_id < 0)
+				goto add_failed;
+		}
+
+		if (SpeedRegExSetRefAdd(spdreg_set, node_id, pattern_idx, frag_count) < 0)
+			goto add_failed;
+
+		frag_count++;
+	}
+
+	StringArrayDestroy(frag_arr);
+
+	pattern->frag_count			= frag_count;
+	spdreg_set->pattern.count++;
+	spdreg_set->flags.compiled	= 0;
+
+	return pattern_idx;
+
+	add_failed:
+
+	/* Drop refs already pushed for this pattern, trie nodes are harmless */
+	while ((spdreg_set->build.ref_count > 0) && (spdreg_set->build.ref_arr[spdreg_set->build.ref_count - 1].pattern_idx == pattern_idx))
+		spdreg_set->build.ref_count--;
+
+	StringArrayDestroy(frag_arr);
+	return -1;
+}
+/**************************************************************************************************************************/
+int SpeedRegExSetCompile(SpeedRegExSet *spdreg_set)
+{
+	SpeedRegExSetTrieNode *node;
+	SpeedRegExSetRef *ref;
+	int *queue_arr;
+	int queue_head;
+	int queue_tail;
+	int node_count;
+	int edge_idx;
+	int child_id;
+	int fail_id;
+	int node_id;
+	int next_id;
+	int i;
+
+	/* Sanity check */
+	if (!spdreg_set)
+		return -1;
+
+	/* Loaded sets are already compiled */
+	if (spdreg_set->flags.loaded)
+		return 0;
+
+	SpeedRegExSetAutomatonClean(spdreg_set);
+
+	node_count								= spdreg_set->build.node_count;
+	spdreg_set->automaton.node_count		= node_count;
+	spdreg_set->automaton.ref_count			= spdreg_set->build.ref_count;
+	spdreg_set->automaton.edge_off			= calloc((node_count + 1), sizeof(int));
+	spdreg_set->automaton.edge_label		= calloc((node_count + 1), sizeof(unsigned char));
+	spdreg_set->automaton.edge_target		= calloc((node_count + 1), sizeof(int));
+	spdreg_set->automaton.fail				= calloc(node_count, sizeof(int));
+	spdreg_set->automaton.dict				= calloc(node_count, sizeof(int));
+	spdreg_set->automaton.depth				= calloc(node_count, sizeof(int));
+	spdreg_set->automaton.ref_off			= calloc((node_count + 1), sizeof(int));
+	spdreg_set->automaton.ref_arr			= calloc((spdreg_set->build.ref_count + 1), sizeof(SpeedRegExSetRef));
+	spdreg_set->automaton.always_arr		= calloc((spdreg_set->pattern.count + 1), sizeof(int));
+	queue_arr								= calloc(node_count, sizeof(int));
+
+	if ((!spdreg_set->automaton.edge_off) || (!spdreg_set->automaton.edge_label) || (!spdreg_set->automaton.edge_target) ||
+			(!spdreg_set->automaton.fail) || (!spdreg_set->automaton.dict) || (!spdreg_set->automaton.depth) ||
+			(!spdreg_set->automaton.ref_off) || (!spdreg_set->automaton.ref_arr) || (!spdreg_set->automaton.always_arr) || (!queue_arr))
+		goto compile_failed;
+
+	/* Flatten sibling lists into sorted edge arrays */
+	for (edge_idx = 0, node_id = 0; node_id < node_count; node_id++)
+	{
+		spdreg_set->automaton.edge_off[node_id] = edge_idx;
+
+		for (child_id = spdreg_set->build.node_arr[node_id].first_child; child_id >= 0; child_id = spdreg_set->build.node_arr[child_id].next_sibling)
+		{
+			spdreg_set->automaton.edge_label[edge_idx]	= spdreg_set->build.node_arr[child_id].label;
+			spdreg_set->automaton.edge_target[edge_idx]	= child_id;
+			edge_idx++;
+		}
+	}
+	spdreg_set->automaton.edge_off[node_count] = edge_idx;
+
+	/* Bucket refs by node, keeping insert order so fragment indexes stay ascending inside each bucket */
+	for (i = 0; i < spdreg_set->build.ref_count; i++)
+		spdreg_set->automaton.ref_off[spdreg_set->build.ref_arr[i].node_id + 1]++;
+
+	for (i = 0; i < node_count; i++)
+		spdreg_set->automaton.ref_off[i + 1] += spdreg_set->automaton.ref_off[i];
+
+	for (i = 0; i < spdreg_set->build.ref_count; i++)
+	{
+		ref = &spdreg_set->build.ref_arr[i];
+		spdreg_set->automaton.ref_arr[spdreg_set->automaton.ref_off[ref->node_id] + spdreg_set->automaton.depth[ref->node_id]++] = *ref;
+	}
+
+	/* Patterns without fragments never reach automaton output */
+	for (i = 0; i < spdreg_set->pattern.count; i++)
+	{
+		if (0 == spdreg_set->pattern.arr[i].frag_count)
+			spdreg_set->automaton.always_arr[spdreg_set->automaton.always_count++] = i;
+	}
+
+	/* Depth was borrowed as bucket cursor above, compute real depth and failure links with a BFS */
+	memset(spdreg_set->automaton.depth, 0, (node_count * sizeof(int)));
+	memset(spdreg_set->automaton.root_next, 0, sizeof(spdreg_set->automaton.root_next));
+	queue_head = 0;
+	queue_tail = 0;
+
+	for (child_id = spdreg_set->build.node_arr[0].first_child; child_id >= 0; child_id = spdreg_set->build.node_arr[child_id].next_sibling)
+	{
+		node = &spdreg_set->build.node_arr[child_id];
+
+		spdreg_set->automaton.root_next[node->label]	= child_id;
+		spdreg_set->automaton.depth[child_id]			= 1;
+		spdreg_set->automaton.fail[child_id]			= 0;
+		spdreg_set->automaton.dict[child_id]			= 0;
+		queue_arr[queue_tail++]							= child_id;
+	}
+
+	while (queue_head < queue_tail)
+	{
+		node_id = queue_arr[queue_head++];
+
+		for (child_id = spdreg_set->build.node_arr[node_id].first_child; child_id >= 0; child_id = spdreg_set->build.node_arr[child_id].next_sibling)
+		{
+			node	= &spdreg_set->build.node_arr[child_id];
+			fail_id	= spdreg_set->automaton.fail[node_id];
+
+			/* Walk failure chain of parent until someone has an edge with our label */
+			while (1)
+			{
+				next_id = (fail_id ? SpeedRegExSetGoto(spdreg_set, fail_id, node->label) : spdreg_set->automaton.root_next[node->label]);
+
+				if ((next_id > 0) || (0 == fail_id))
+					break;
+
+				fail_id = spdreg_set->automaton.fail[fail_id];
+			}
+
+			next_id = ((next_id > 0) ? next_id : 0);
+
+			spdreg_set->automaton.depth[child_id]	= (spdreg_set->automaton.depth[node_id] + 1);
+			spdreg_set->automaton.fail[child_id]	= next_id;
+
+			/* Dictionary link points to nearest suffix state that ends some fragment */
+			if (spdreg_set->automaton.ref_off[next_id + 1] > spdreg_set->automaton.ref_off[next_id])
+				spdreg_set->automaton.dict[child_id] = next_id;
+			else
+				spdreg_set->automaton.dict[child_id] = spdreg_set->automaton.dict[next_id];
+
+			queue_arr[queue_tail++] = child_id;
+		}
+	}
+
+	free(queue_arr);
+
+	if (SpeedRegExSetScratchNew(spdreg_set) < 0)
+	{
+		SpeedRegExSetAutomatonClean(spdreg_set);
+		return -1;
+	}
+
+	spdreg_set->flags.compiled = 1;
+	return node_count;
+
+	compile_failed:
+
+	free(queue_arr);
+	SpeedRegExSetAutomatonClean(spdreg_set);
+	return -1;
+}
+/**************************************************************************************************************************/
+int SpeedRegExSetExecute(SpeedRegExSet *spdreg_set, char *data, int data_sz, int *match_arr, int match_max)
+{
+	SpeedRegExSetPattern *pattern;
+	SpeedRegExSetRef *ref;
+	unsigned char *data_ptr;
+	unsigned int gen;
+	int match_count;
+	int state_id;
+	int next_id;
+	int out_id;
+	int begin_off;
+	int ref_idx;
+	int p_idx;
+	int i;
+
+	/* Sanity check */
+	if ((!spdreg_set) || (!data) || (!spdreg_set->flags.compiled))
+		return -1;
+
+	if (data_sz < 0)
+		data_sz = strlen(data);
+
+	if (SPDREGEX_MT_SAFE == spdreg_set->spdreg_type)
+		pthread_mutex_lock(&spdreg_set->mutex);
+
+	/* Bump generation, stale per pattern cursors are reset lazily when touched */
+	gen = ++spdreg_set->scratch.gen;
+
+	if (0 == gen)
+	{
+		memset(spdreg_set->scratch.gen_arr, 0, (spdreg_set->pattern.count * sizeof(unsigned int)));
+		gen = spdreg_set->scratch.gen = 1;
+	}
+
+	match_count = 0;
+
+	/* Fragment free patterns, either a bare wildcard or an empty exact string */
+	for (i = 0; (i < spdreg_set->automaton.always_count) && (match_count < match_max); i++)
+	{
+		pattern = &spdreg_set->pattern.arr[spdreg_set->automaton.always_arr[i]];
+
+		if ((!(pattern->anchor_flags & SPDREGEX_SET_ANCHOR_BEGIN)) || (0 == data_sz))
+			match_arr[match_count++] = pattern->pattern_id;
+	}
+
+	data_ptr = (unsigned char *)data;
+
+	for (state_id = 0, i = 0; (i < data_sz) && (match_count < match_max); i++)
+	{
+		/* Follow goto, falling back through failure links */
+		while (1)
+		{
+			if (0 == state_id)
+			{
+				state_id = spdreg_set->automaton.root_next[data_ptr[i]];
+				break;
+			}
+
+			next_id = SpeedRegExSetGoto(spdreg_set, state_id, data_ptr[i]);
+
+			if (next_id > 0)
+			{
+				state_id = next_id;
+				break;
+			}
+
+			state_id = spdreg_set->automaton.fail[state_id];
+		}
+
+		/* Walk every fragment ending here */
+		out_id = ((spdreg_set->automaton.ref_off[state_id + 1] > spdreg_set->automaton.ref_off[state_id]) ? state_id : spdreg_set->automaton.dict[state_id]);
+
+		for (; out_id > 0; out_id = spdreg_set->automaton.dict[out_id])
+		{
+			begin_off = (i - spdreg_set->automaton.depth[out_id] + 1);
+
+			for (ref_idx = spdreg_set->automaton.ref_off[out_id]; ref_idx < spdreg_set->automaton.ref_off[out_id + 1]; ref_idx++)
+			{
+				ref		= &spdreg_set->automaton.ref_arr[ref_idx];
+				p_idx	= ref->pattern_idx;
+				pattern	= &spdreg_set->pattern.arr[p_idx];
+
+				/* First touch on this execution */
+				if (spdreg_set->scratch.gen_arr[p_idx] != gen)
+				{
+					spdreg_set->scratch.gen_arr[p_idx]			= gen;
+					spdreg_set->scratch.next_arr[p_idx]			= 0;
+					spdreg_set->scratch.min_start_arr[p_idx]	= 0;
+				}
+
+				/* Not the fragment this pattern waits for, or overlapping the previous one */
+				if ((spdreg_set->scratch.next_arr[p_idx] != ref->frag_idx) || (begin_off < spdreg_set->scratch.min_start_arr[p_idx]))
+					continue;
+
+				/* Anchored edges must sit on data boundaries */
+				if ((0 == ref->frag_idx) && (pattern->anchor_flags & SPDREGEX_SET_ANCHOR_BEGIN) && (begin_off != 0))
+					continue;
+
+				if (((pattern->frag_count - 1) == ref->frag_idx) && (pattern->anchor_flags & SPDREGEX_SET_ANCHOR_FINISH) && (i != (data_sz - 1)))
+					continue;
+
+				/* Earliest ending occurrence leaves most room for the rest, so greedy advance is exact */
+				spdreg_set->scratch.next_arr[p_idx]			= (ref->frag_idx + 1);
+				spdreg_set->scratch.min_start_arr[p_idx]	= (i + 1);
+
+				if (pattern->frag_count == spdreg_set->scratch.next_arr[p_idx])
+				{
+					match_arr[match_count++] = pattern->pattern_id;
+
+					if (match_count >= match_max)
+						break;
+				}
+
+				continue;
+			}
+
+			if (match_count >= match_max)
+				break;
+		}
+
+		continue;
+	}
+
+	if (SPDREGEX_MT_SAFE == spdreg_set->spdreg_type)
+		pthread_mutex_unlock(&spdreg_set->mutex);
+
+	return match_count;
+}
+/**************************************************************************************************************************/
+int SpeedRegExSetGetCount(SpeedRegExSet *spdreg_set)
+{
+	/* Sanity check */
+	if (!spdreg_set)
+		return 0;
+
+	return spdreg_set->pattern.count;
+}
+/**************************************************************************************************************************/
+int SpeedRegExSetSerialize(SpeedRegExSet *spdreg_set, MemBuffer *dump_mb)
+{
+	SpeedRegExSetHeader set_header;
+	int node_count;
+	int label_pad;
+	int pad_zero = 0;
+
+	/* Sanity check */
+	if ((!spdreg_set) || (!dump_mb) || (!spdreg_set->flags.compiled))
+		return -1;
+
+	node_count = spdreg_set->automaton.node_count;
+	memset(&set_header, 0, sizeof(SpeedRegExSetHeader));
+
+	set_header.magic			= SPDREGEX_SET_MAGIC;
+	set_header.version			= SPDREGEX_SET_VERSION;
+	set_header.pattern_count	= spdreg_set->pattern.count;
+	set_header.node_count		= node_count;
+	set_header.ref_count		= spdreg_set->automaton.ref_count;
+	set_header.always_count		= spdreg_set->automaton.always_count;
+
+	/* Raw arrays in native byte order, load side copies them back verbatim */
+	MemBufferAdd(dump_mb, &set_header, sizeof(SpeedRegExSetHeader));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.root_next, sizeof(spdreg_set->automaton.root_next));
+	MemBufferAdd(dump_mb, spdreg_set->pattern.arr, (spdreg_set->pattern.count * sizeof(SpeedRegExSetPattern)));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.edge_off, ((node_count + 1) * sizeof(int)));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.edge_target, (node_count * sizeof(int)));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.fail, (node_count * sizeof(int)));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.dict, (node_count * sizeof(int)));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.depth, (node_count * sizeof(int)));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.ref_off, ((node_count + 1) * sizeof(int)));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.ref_arr, (spdreg_set->automaton.ref_count * sizeof(SpeedRegExSetRef)));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.always_arr, (spdreg_set->automaton.always_count * sizeof(int)));
+	MemBufferAdd(dump_mb, spdreg_set->automaton.edge_label, node_count);
+
+	/* Keep total size aligned to int */
+	label_pad = ((sizeof(int) - (node_count % sizeof(int))) % sizeof(int));
+
+	if (label_pad > 0)
+		MemBufferAdd(dump_mb, &pad_zero, label_pad);
+
+	return 0;
+}
+/**************************************************************************************************************************/
+SpeedRegExSet *SpeedRegExSetLoad(char *data, unsigned long data_sz, SpeedRegexType type)
+{
+	SpeedRegExSetHeader set_header;
+	SpeedRegExSet *spdreg_set;
+	unsigned long remain_sz;
+	unsigned long node_count;
+	char *cur_ptr;
+
+	/* Sanity check */
+	if ((!data) || (data_sz < sizeof(SpeedRegExSetHeader)))
+		return NULL;
+
+	memcpy(&set_header, data, sizeof(SpeedRegExSetHeader));
+
+	if ((SPDREGEX_SET_MAGIC != set_header.magic) || (SPDREGEX_SET_VERSION != set_header.version) || (set_header.node_count < 1) ||
+			(set_header.node_count > INT_MAX) || (set_header.pattern_count > INT_MAX) || (set_header.ref_count > INT_MAX) ||
+			(set_header.always_count > set_header.pattern_count))
+		return NULL;
+
+	spdreg_set = SpeedRegExSetNew(type);
+
+	if (!spdreg_set)
+		return NULL;
+
+	node_count	= set_header.node_count;
+	cur_ptr		= (data + sizeof(SpeedRegExSetHeader));
+	remain_sz	= (data_sz - sizeof(SpeedRegExSetHeader));
+
+	/* Root table is embedded, copy it in place */
+	if (remain_sz < sizeof(spdreg_set->automaton.root_next))
+		goto load_failed;
+
+	memcpy(spdreg_set->automaton.root_next, cur_ptr, sizeof(spdreg_set->automaton.root_next));
+	cur_ptr		+= sizeof(spdreg_set->automaton.root_next);
+	remain_sz	-= sizeof(spdreg_set->automaton.root_next);
+
+	spdreg_set->pattern.count				= set_header.pattern_count;
+	spdreg_set->pattern.capacity			= set_header.pattern_count;
+	spdreg_set->automaton.node_count		= node_count;
+	spdreg_set->automaton.ref_count			= set_header.ref_count;
+	spdreg_set->automaton.always_count		= set_header.always_count;
+
+	if ((SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->pattern.arr, (set_header.pattern_count * sizeof(SpeedRegExSetPattern))) < 0) ||
+			(SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->automaton.edge_off, ((node_count + 1) * sizeof(int))) < 0) ||
+			(SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->automaton.edge_target, (node_count * sizeof(int))) < 0) ||
+			(SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->automaton.fail, (node_count * sizeof(int))) < 0) ||
+			(SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->automaton.dict, (node_count * sizeof(int))) < 0) ||
+			(SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->automaton.depth, (node_count * sizeof(int))) < 0) ||
+			(SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->automaton.ref_off, ((node_count + 1) * sizeof(int))) < 0) ||
+			(SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->automaton.ref_arr, (set_header.ref_count * sizeof(SpeedRegExSetRef))) < 0) ||
+			(SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->automaton.always_arr, (set_header.always_count * sizeof(int))) < 0) ||
+			(SpeedRegExSetLoadChunk(&cur_ptr, &remain_sz, (void **)&spdreg_set->automaton.edge_label, node_count) < 0))
+		goto load_failed;
+
+	/* Never trust offsets coming from disk */
+	if (SpeedRegExSetLoadValidate(spdreg_set) < 0)
+		goto load_failed;
+
+	if (SpeedRegExSetScratchNew(spdreg_set) < 0)
+		goto load_failed;
+
+	spdreg_set->flags.loaded	= 1;
+	spdreg_set->flags.compiled	= 1;
+
+	return spdreg_set;
+
+	load_failed:
+
+	SpeedRegExSetDestroy(spdreg_set);
+	return NULL;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static int SpeedRegExSetArrayGrow(void **arr_ptr, int *capacity_ptr, int need_count, int elem_sz)
+{
+	void *new_arr;
+	int new_capacity;
+
+	if (need_count <= *capacity_ptr)
+		return 0;
+
+	new_capacity	= ((*capacity_ptr > 0) ? (*capacity_ptr * 2) : 64);
+	new_capacity	= ((new_capacity < need_count) ? need_count : new_capacity);
+	new_arr			= realloc(*arr_ptr, ((size_t)new_capacity * elem_sz));
+
+	if (!new_arr)
+		return -1;
+
+	*arr_ptr		= new_arr;
+	*capacity_ptr	= new_capacity;
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static int SpeedRegExSetNodeNew(SpeedRegExSet *spdreg_set, int label)
+{
+	SpeedRegExSetTrieNode *node;
+	int node_id;
+
+	if (SpeedRegExSetArrayGrow((void **)&spdreg_set->build.node_arr, &spdreg_set->build.node_capacity, (spdreg_set->build.node_count + 1), sizeof(SpeedRegExSetTrieNode)) < 0)
+		return -1;
+
+	node_id				= spdreg_set->build.node_count++;
+	node				= &spdreg_set->build.node_arr[node_id];
+	node->first_child	= -1;
+	node->next_sibling	= -1;
+	node->label			= label;
+
+	return node_id;
+}
+/**************************************************************************************************************************/
+static int SpeedRegExSetChildGrab(SpeedRegExSet *spdreg_set, int parent_id, int label)
+{
+	int child_id;
+	int prev_id;
+	int new_id;
+
+	/* Sibling list is sorted by label */
+	for (prev_id = -1, child_id = spdreg_set->build.node_arr[parent_id].first_child; child_id >= 0; child_id = spdreg_set->build.node_arr[child_id].next_sibling)
+	{
+		if (spdreg_set->build.node_arr[child_id].label >= label)
+			break;
+
+		prev_id = child_id;
+	}
+
+	if ((child_id >= 0) && (spdreg_set->build.node_arr[child_id].label == label))
+		return child_id;
+
+	/* May realloc node_arr, so only indexes are held across this call */
+	new_id = SpeedRegExSetNodeNew(spdreg_set, label);
+
+	if (new_id < 0)
+		return -1;
+
+	spdreg_set->build.node_arr[new_id].next_sibling = child_id;
+
+	if (prev_id < 0)
+		spdreg_set->build.node_arr[parent_id].first_child = new_id;
+	else
+		spdreg_set->build.node_arr[prev_id].next_sibling = new_id;
+
+	return new_id;
+}
+/**************************************************************************************************************************/
+static int SpeedRegExSetRefAdd(SpeedRegExSet *spdreg_set, int node_id, int pattern_idx, int frag_idx)
+{
+	SpeedRegExSetRef *ref;
+
+	if (SpeedRegExSetArrayGrow((void **)&spdreg_set->build.ref_arr, &spdreg_set->build.ref_capacity, (spdreg_set->build.ref_count + 1), sizeof(SpeedRegExSetRef)) < 0)
+		return -1;
+
+	ref					= &spdreg_set->build.ref_arr[spdreg_set->build.ref_count++];
+	ref->node_id		= node_id;
+	ref->pattern_idx	= pattern_idx;
+	ref->frag_idx		= frag_idx;
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static int SpeedRegExSetGoto(SpeedRegExSet *spdreg_set, int state_id, int label)
+{
+	unsigned char *label_arr = spdreg_set->automaton.edge_label;
+	int low_idx = spdreg_set->automaton.edge_off[state_id];
+	int high_idx = (spdreg_set->automaton.edge_off[state_id + 1] - 1);
+	int mid_idx;
+
+	/* Binary search on sorted edge labels of this state */
+	while (low_idx <= high_idx)
+	{
+		mid_idx = ((low_idx + high_idx) >> 1);
+
+		if (label_arr[mid_idx] == label)
+			return spdreg_set->automaton.edge_target[mid_idx];
+		else if (label_arr[mid_idx] < label)
+			low_idx = (mid_idx + 1);
+		else
+			high_idx = (mid_idx - 1);
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+static int SpeedRegExSetScratchNew(SpeedRegExSet *spdreg_set)
+{
+	int pattern_count = (spdreg_set->pattern.count + 1);
+
+	spdreg_set->scratch.gen_arr			= calloc(pattern_count, sizeof(unsigned int));
+	spdreg_set->scratch.next_arr		= calloc(pattern_count, sizeof(int));
+	spdreg_set->scratch.min_start_arr	= calloc(pattern_count, sizeof(int));
+	spdreg_set->scratch.gen				= 1;
+
+	if ((!spdreg_set->scratch.gen_arr) || (!spdreg_set->scratch.next_arr) || (!spdreg_set->scratch.min_start_arr))
+		return -1;
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static void SpeedRegExSetAutomatonClean(SpeedRegExSet *spdreg_set)
+{
+	free(spdreg_set->automaton.edge_off);
+	free(spdreg_set->automaton.edge_label);
+	free(spdreg_set->automaton.edge_target);
+	free(spdreg_set->automaton.fail);
+	free(spdreg_set->automaton.dict);
+	free(spdreg_set->automaton.depth);
+	free(spdreg_set->automaton.ref_off);
+	free(spdreg_set->automaton.ref_arr);
+	free(spdreg_set->automaton.always_arr);
+	free(spdreg_set->scratch.gen_arr);
+	free(spdreg_set->scratch.next_arr);
+	free(spdreg_set->scratch.min_start_arr);
+
+	spdreg_set->automaton.edge_off			= NULL;
+	spdreg_set->automaton.edge_label		= NULL;
+	spdreg_set->automaton.edge_target		= NULL;
+	spdreg_set->automaton.fail				= NULL;
+	spdreg_set->automaton.dict				= NULL;
+	spdreg_set->automaton.depth				= NULL;
+	spdreg_set->automaton.ref_off			= NULL;
+	spdreg_set->automaton.ref_arr			= NULL;
+	spdreg_set->automaton.always_arr		= NULL;
+	spdreg_set->automaton.always_count		= 0;
+	spdreg_set->scratch.gen_arr				= NULL;
+	spdreg_set->scratch.next_arr			= NULL;
+	spdreg_set->scratch.min_start_arr		= NULL;
+	spdreg_set->flags.compiled				= 0;
+
+	return;
+}
+/**************************************************************************************************************************/
+static int SpeedRegExSetLoadChunk(char **cur_ptr, unsigned long *remain_ptr, void **dst_ptr, unsigned long chunk_sz)
+{
+	/* Sanity check */
+	if (chunk_sz > *remain_ptr)
+		return -1;
+
+	/* Always hand back a valid pointer, even for empty chunks */
+	*dst_ptr = malloc(chunk_sz + sizeof(int));
+
+	if (!*dst_ptr)
+		return -1;
+
+	memcpy(*dst_ptr, *cur_ptr, chunk_sz);
+
+	*cur_ptr	+= chunk_sz;
+	*remain_ptr	-= chunk_sz;
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static int SpeedRegExSetLoadValidate(SpeedRegExSet *spdreg_set)
+{
+	SpeedRegExSetPattern *pattern;
+	SpeedRegExSetRef *ref;
+	int node_count = spdreg_set->automaton.node_count;
+	int i;
+
+	for (i = 0; i < 256; i++)
+	{
+		if ((spdreg_set->automaton.root_next[i] < 0) || (spdreg_set->automaton.root_next[i] >= node_count))
+			return -1;
+	}
+
+	if ((spdreg_set->automaton.edge_off[0] != 0) || (spdreg_set->automaton.ref_off[0] != 0) ||
+			(spdreg_set->automaton.edge_off[node_count] > node_count) || (spdreg_set->automaton.ref_off[node_count] != spdreg_set->automaton.ref_count))
+		return -1;
+
+	for (i = 0; i < node_count; i++)
+	{
+		if ((spdreg_set->automaton.edge_off[i] > spdreg_set->automaton.edge_off[i + 1]) || (spdreg_set->automaton.ref_off[i] > spdreg_set->automaton.ref_off[i + 1]))
+			return -1;
+
+		if ((spdreg_set->automaton.edge_target[i] < 0) || (spdreg_set->automaton.edge_target[i] >= node_count) ||
+				(spdreg_set->automaton.fail[i] < 0) || (spdreg_set->automaton.fail[i] >= node_count) ||
+				(spdreg_set->automaton.dict[i] < 0) || (spdreg_set->automaton.dict[i] >= node_count) ||
+				(spdreg_set->automaton.depth[i] < 0))
+			return -1;
+
+		/* Failure and dictionary links always point to shallower states, so walks terminate */
+		if ((i > 0) && ((spdreg_set->automaton.depth[spdreg_set->automaton.fail[i]] >= spdreg_set->automaton.depth[i]) ||
+				(spdreg_set->automaton.depth[spdreg_set->automaton.dict[i]] >= spdreg_set->automaton.depth[i])))
+			return -1;
+	}
+
+	for (i = 0; i < spdreg_set->automaton.ref_count; i++)
+	{
+		ref = &spdreg_set->automaton.ref_arr[i];
+
+		if ((ref->pattern_idx < 0) || (ref->pattern_idx >= spdreg_set->pattern.count))
+			return -1;
+	}
+
+	for (i = 0; i < spdreg_set->automaton.always_count; i++)
+	{
+		if ((spdreg_set->automaton.always_arr[i] < 0) || (spdreg_set->automaton.always_arr[i] >= spdreg_set->pattern.count))
+			return -1;
+	}
+
+	for (i = 0; i < spdreg_set->pattern.count; i++)
+	{
+		pattern = &spdreg_set->pattern.arr[i];
+
+		if (pattern->frag_count < 0)
+			return -1;
+	}
+
+	return 0;
+}
+/**************************************************************************************************************************/
@@ -34,6 +34,12 @@
 
 #include "../include/libbrb_core.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define INT_VALUE(c) ((c) - '0')
 
 /**************************************************************************************************************************/
@@ -499,6 +505,148 @@ int BrbStrFindSubStrReverse(char *buffer_str, int buffer_sz, char *substring_str
 	return -1;
 }
 /**************************************************************************************************************************/
+long BrbMemFind(const char *buffer_ptr, long buffer_sz, const char *token_str, int token_sz)
+{
+	unsigned int hit_mask;
+	long last_pos;
+	long i;
+	int bit;
+
+	/* Sanity check */
+	if ((token_sz <= 0) || (buffer_sz < token_sz))
+		return -1;
+
+	/* Last offset where a full token still fits */
+	last_pos	= (buffer_sz - token_sz);
+	i			= 0;
+
+	/* Compare token first and last bytes against a whole block at once, only verify middle bytes on blocks that hit both */
+#if defined(__AVX2__)
+	{
+		__m256i first_vec	= _mm256_set1_epi8(token_str[0]);
+		__m256i last_vec	= _mm256_set1_epi8(token_str[token_sz - 1]);
+
+		for (; (i + 32) <= (last_pos + 1); i += 32)
+		{
+			hit_mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first_vec, _mm256_loadu_si256((const __m256i *)(buffer_ptr + i))),
+					_mm256_cmpeq_epi8(last_vec, _mm256_loadu_si256((const __m256i *)(buffer_ptr + i + token_sz - 1)))));
+
+			while (hit_mask)
+			{
+				bit = __builtin_ctz(hit_mask);
+
+				if ((token_sz <= 2) || (!memcmp(buffer_ptr + i + bit + 1, token_str + 1, token_sz - 2)))
+					return (i + bit);
+
+				hit_mask &= (hit_mask - 1);
+			}
+		}
+	}
+#elif defined(__SSE2__)
+	{
+		__m128i first_vec	= _mm_set1_epi8(token_str[0]);
+		__m128i last_vec	= _mm_set1_epi8(token_str[token_sz - 1]);
+
+		for (; (i + 16) <= (last_pos + 1); i += 16)
+		{
+			hit_mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_vec, _mm_loadu_si128((const __m128i *)(buffer_ptr + i))),
+					_mm_cmpeq_epi8(last_vec, _mm_loadu_si128((const __m128i *)(buffer_ptr + i + token_sz - 1)))));
+
+			while (hit_mask)
+			{
+				bit = __builtin_ctz(hit_mask);
+
+				if ((token_sz <= 2) || (!memcmp(buffer_ptr + i + bit + 1, token_str + 1, token_sz - 2)))
+					return (i + bit);
+
+				hit_mask &= (hit_mask - 1);
+			}
+		}
+	}
+#endif
+
+	/* Scalar tail, or whole buffer when there is no SIMD */
+	for (; i <= last_pos; i++)
+	{
+		if ((buffer_ptr[i] == token_str[0]) && (!memcmp(buffer_ptr + i, token_str, token_sz)))
+			return i;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+long BrbMemFindLast(const char *buffer_ptr, long buffer_sz, const char *token_str, int token_sz)
+{
+	unsigned int hit_mask;
+	long base;
+	long i;
+	int bit;
+
+	/* Sanity check */
+	if ((token_sz <= 0) || (buffer_sz < token_sz))
+		return -1;
+
+	/* Walk backwards from one past last offset where a full token still fits */
+	i = (buffer_sz - token_sz + 1);
+
+#if defined(__AVX2__)
+	{
+		__m256i first_vec	= _mm256_set1_epi8(token_str[0]);
+		__m256i last_vec	= _mm256_set1_epi8(token_str[token_sz - 1]);
+
+		for (; i >= 32; i -= 32)
+		{
+			base		= (i - 32);
+			hit_mask	= _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first_vec, _mm256_loadu_si256((const __m256i *)(buffer_ptr + base))),
+					_mm256_cmpeq_epi8(last_vec, _mm256_loadu_si256((const __m256i *)(buffer_ptr + base + token_sz - 1)))));
+
+			/* Highest hit first */
+			while (hit_mask)
+			{
+				bit = (31 - __builtin_clz(hit_mask));
+
+				if ((token_sz <= 2) || (!memcmp(buffer_ptr + base + bit + 1, token_str + 1, token_sz - 2)))
+					return (base + bit);
+
+				hit_mask &= ~(1U << bit);
+			}
+		}
+	}
+#elif defined(__SSE2__)
+	{
+		__m128i first_vec	= _mm_set1_epi8(token_str[0]);
+		__m128i last_vec	= _mm_set1_epi8(token_str[token_sz - 1]);
+
+		for (; i >= 16; i -= 16)
+		{
+			base		= (i - 16);
+			hit_mask	= _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_vec, _mm_loadu_si128((const __m128i *)(buffer_ptr + base))),
+					_mm_cmpeq_epi8(last_vec, _mm_loadu_si128((const __m128i *)(buffer_ptr + base + token_sz - 1)))));
+
+			/* Highest hit first */
+			while (hit_mask)
+			{
+				bit = (31 - __builtin_clz(hit_mask));
+
+				if ((token_sz <= 2) || (!memcmp(buffer_ptr + base + bit + 1, token_str + 1, token_sz - 2)))
+					return (base + bit);
+
+				hit_mask &= ~(1U << bit);
+			}
+		}
+	}
+#endif
+
+	/* Scalar head, or whole buffer when there is no SIMD */
+	for (i = (i - 1); i >= 0; i--)
+	{
+		if ((buffer_ptr[i] == token_str[0]) && (!memcmp(buffer_ptr + i, token_str, token_sz)))
+			return i;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
 char *BrbStrGetKeyByValue(BrbKeyValue val_key[], int k_value)
 {
 	int i;
@@ -35,6 +35,11 @@
 #include "../include/libbrb_core.h"
 
 static int EvAIOReqDoDestroy(EvAIOReq *aio_req);
+static int EvAIOReqQueueWatermarkTouch(EvAIOReqQueue *aio_req_queue, long delta_sz);
+static void EvAIOReqQueueWatermarkDispatch(EvAIOReqQueue *aio_req_queue, int wm_code);
+static void EvAIOReqQueueAccountListAdd(EvAIOReqQueue *aio_req_queue);
+static void EvAIOReqQueueAccountListDel(EvAIOReqQueue *aio_req_queue);
+static EvAIOReqQueue *EvAIOReqQueueAccountShedVictimGrab(EvAIOReqQueueAccount *account, EvAIOReqQueue *aio_req_queue);
 
 /**************************************************************************************************************************/
 EvAIOReqQueue *EvAIOReqQueueNew(EvKQBase *ev_base, int max_slots, int queue_mt, int queue_type)
@@ -71,6 +76,10 @@ void EvAIOReqQueueInit(EvKQBase *ev_base, EvAIOReqQueue *aio_req_queue, int max_
 
 	AIOREQ_QUEUE_MUTEX_INIT(aio_req_queue);
 
+	/* Queue survived a CLEAN still bound to an account (reconnecting client), get back into its list */
+	if (aio_req_queue->watermark.account)
+		EvAIOReqQueueAccountListAdd(aio_req_queue);
+
 	return;
 }
 /**************************************************************************************************************************/
@@ -83,6 +92,7 @@ void EvAIOReqQueueDestroy(EvAIOReqQueue *aio_req_queue)
 
 	/* Invoke common clean */
 	EvAIOReqQueueClean(aio_req_queue);
+	EvAIOReqQueueAccountUnlink(aio_req_queue);
 	AIOREQ_QUEUE_MUTEX_DESTROY(aio_req_queue);
 
 	free(aio_req_queue);
@@ -116,10 +126,16 @@ void EvAIOReqQueueClean(EvAIOReqQueue *aio_req_queue)
 		continue;
 	}
 
+	/* Give back whatever was still accounted, no watermark event is fired for a dying queue */
+	EvAIOReqQueueWatermarkTouch(aio_req_queue, -((long)aio_req_queue->stats.queue_sz));
+	EvAIOReqQueueAccountListDel(aio_req_queue);
+
 	aio_req_queue->stats.queue_sz 		= 0;
 	aio_req_queue->aio_req_list.head	= NULL;
 	aio_req_queue->aio_req_list.tail	= NULL;
 	aio_req_queue->flags.queue_init		= 0;
+	aio_req_queue->flags.above_high		= 0;
+	aio_req_queue->flags.shed_pending	= 0;
 
 	/* Clean up memory slot arena */
 	if (aio_req_queue->flags.queue_slotted)
@@ -142,6 +158,7 @@ long EvAIOReqQueueGetQueueCount(EvAIOReqQueue *aio_req_queue)
 /**************************************************************************************************************************/
 void EvAIOReqQueueEnqueueHead(EvAIOReqQueue *aio_req_queue, EvAIOReq *aio_req)
 {
+	int wm_code;
 
 	AIOREQ_QUEUE_MUTEX_LOCK(aio_req_queue);
 
@@ -160,14 +177,19 @@ void EvAIOReqQueueEnqueueHead(EvAIOReqQueue *aio_req_queue, EvAIOReq *aio_req)
 	/* Add to internal list HEAD and touch QUEUE_SZ */
 	DLinkedListAdd(&aio_req_queue->aio_req_list, &aio_req->node, aio_req);
 	aio_req_queue->stats.queue_sz += ((aio_req->data.size > 0) ? aio_req->data.size : 0);
+	wm_code = EvAIOReqQueueWatermarkTouch(aio_req_queue, ((aio_req->data.size > 0) ? aio_req->data.size : 0));
 
 	AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
 
+	/* Crossed a watermark, tell upper layers outside lock */
+	EvAIOReqQueueWatermarkDispatch(aio_req_queue, wm_code);
+
 	return;
 }
 /**************************************************************************************************************************/
 void EvAIOReqQueueEnqueue(EvAIOReqQueue *aio_req_queue, EvAIOReq *aio_req)
 {
+	int wm_code;
 
 	AIOREQ_QUEUE_MUTEX_LOCK(aio_req_queue);
 
@@ -187,23 +209,32 @@ void EvAIOReqQueueEnqueue(EvAIOReqQueue *aio_req_queue, EvAIOReq *aio_req)
 	DLinkedListAddTail(&aio_req_queue->aio_req_list, &aio_req->node, aio_req);
 	aio_req_queue->stats.queue_sz += ((aio_req->data.size > 0) ? aio_req->data.size : 0);
 	aio_req_queue->stats.total_sz += ((aio_req->data.size > 0) ? aio_req->data.size : 0);
+	wm_code = EvAIOReqQueueWatermarkTouch(aio_req_queue, ((aio_req->data.size > 0) ? aio_req->data.size : 0));
 
 	AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
 
+	/* Crossed a watermark, tell upper layers outside lock */
+	EvAIOReqQueueWatermarkDispatch(aio_req_queue, wm_code);
+
 	return;
 }
 /**************************************************************************************************************************/
 void EvAIOReqQueueRemoveItem(EvAIOReqQueue *aio_req_queue, EvAIOReq *aio_req)
 {
+	int wm_code;
 
 	AIOREQ_QUEUE_MUTEX_LOCK(aio_req_queue);
 
 	/* Add to internal list TAIL and touch QUEUE_SZ */
 	DLinkedListDelete(&aio_req_queue->aio_req_list, &aio_req->node);
 	aio_req_queue->stats.queue_sz -= ((aio_req->data.size > 0) ? aio_req->data.size : 0);
+	wm_code = EvAIOReqQueueWatermarkTouch(aio_req_queue, -((aio_req->data.size > 0) ? aio_req->data.size : 0));
 
 	AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
 
+	/* Drained below LOW mark, tell upper layers outside lock */
+	EvAIOReqQueueWatermarkDispatch(aio_req_queue, wm_code);
+
 	return;
 }
 /**************************************************************************************************************************/
@@ -230,6 +261,7 @@ EvAIOReq *EvAIOReqQueuePointToHead(EvAIOReqQueue *aio_req_queue)
 EvAIOReq *EvAIOReqQueueDequeue(EvAIOReqQueue *aio_req_queue)
 {
 	EvAIOReq *aio_req;
+	int wm_code;
 
 	/* Nothing to check for, bail out */
 	AIOREQ_QUEUE_MUTEX_LOCK(aio_req_queue);
@@ -243,12 +275,89 @@ EvAIOReq *EvAIOReqQueueDequeue(EvAIOReqQueue *aio_req_queue)
 	/* Remove from list HEAD and touch QUEUE_SZ */
 	aio_req = DLinkedListPopHead(&aio_req_queue->aio_req_list);
 	aio_req_queue->stats.queue_sz -= ((aio_req->data.size > 0) ? aio_req->data.size : 0);
+	wm_code = EvAIOReqQueueWatermarkTouch(aio_req_queue, -((aio_req->data.size > 0) ? aio_req->data.size : 0));
 
 	AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
 
+	/* Drained below LOW mark, tell upper layers outside lock */
+	EvAIOReqQueueWatermarkDispatch(aio_req_queue, wm_code);
+
 	return aio_req;
 }
 /**************************************************************************************************************************/
+long EvAIOReqQueueWriteVectored(EvAIOReqQueue *aio_req_queue, int fd, long max_write_sz)
+{
+	struct iovec iov_arr[AIOREQ_QUEUE_WRITEV_MAX_IOV];
+	DLinkedListNode *node;
+	EvAIOReq *aio_req;
+	long wanted_write_sz;
+	long total_sz;
+	long wrote_sz;
+	long left_sz;
+	int iov_count;
+
+	AIOREQ_QUEUE_MUTEX_LOCK(aio_req_queue);
+
+	/* Gather AIO_REQs from HEAD, until IOV or MAX_WRITE_SZ limit is reached - A write queue belongs to a single descriptor, so AIO_REQ FD is not
+	 * checked here: IPC creates them with FD -1 before the pipe even exists */
+	for (node = aio_req_queue->aio_req_list.head, iov_count = 0, total_sz = 0; ((node) && (iov_count < AIOREQ_QUEUE_WRITEV_MAX_IOV) && (total_sz < max_write_sz)); node = node->next)
+	{
+		aio_req			= node->data;
+		wanted_write_sz	= EvAIOReqGetMissingSize(aio_req);
+
+		/* Nothing left on this one, will be finished by caller */
+		if (wanted_write_sz <= 0)
+			continue;
+
+		/* Do not go beyond what kernel told us we can write */
+		if ((total_sz + wanted_write_sz) > max_write_sz)
+			wanted_write_sz = (max_write_sz - total_sz);
+
+		iov_arr[iov_count].iov_base	= EvAIOReqGetDataPtr(aio_req);
+		iov_arr[iov_count].iov_len	= wanted_write_sz;
+		total_sz				   += wanted_write_sz;
+		iov_count++;
+	}
+
+	/* Nothing to write */
+	if (0 == iov_count)
+	{
+		AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
+		return 0;
+	}
+
+	/* Issue a single gather write for all of them */
+	wrote_sz = writev(fd, iov_arr, iov_count);
+
+	/* Failed writing, leave ERRNO for caller */
+	if (wrote_sz < 0)
+	{
+		AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
+		return -1;
+	}
+
+	/* Walk again from HEAD spreading written bytes into each AIO_REQ offset, last one may be partial */
+	for (node = aio_req_queue->aio_req_list.head, left_sz = wrote_sz; ((node) && (left_sz > 0)); node = node->next)
+	{
+		aio_req			= node->data;
+		wanted_write_sz	= EvAIOReqGetMissingSize(aio_req);
+
+		/* Partially written */
+		if (wanted_write_sz > left_sz)
+		{
+			aio_req->data.offset += left_sz;
+			break;
+		}
+
+		aio_req->data.offset	+= wanted_write_sz;
+		left_sz					-= wanted_write_sz;
+	}
+
+	AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
+
+	return wrote_sz;
+}
+/**************************************************************************************************************************/
 int EvAIOReqQueueIsEmpty(EvAIOReqQueue *aio_req_queue)
 {
 	if (DLINKED_LIST_ISEMPTY(aio_req_queue->aio_req_list))
@@ -257,6 +366,164 @@ int EvAIOReqQueueIsEmpty(EvAIOReqQueue *aio_req_queue)
 	return 0;
 }
 /**************************************************************************************************************************/
+void EvAIOReqQueueWatermarkSet(EvAIOReqQueue *aio_req_queue, unsigned long high_sz, unsigned long low_sz, EvAIOReqQueueWatermarkCBH *cb_handler, void *cb_data)
+{
+	/* Sanity check */
+	if (!aio_req_queue)
+		return;
+
+	AIOREQ_QUEUE_MUTEX_LOCK(aio_req_queue);
+
+	/* LOW mark must sit below HIGH mark, or we would flap on every single write */
+	aio_req_queue->watermark.high_sz		= high_sz;
+	aio_req_queue->watermark.low_sz			= ((low_sz < high_sz) ? low_sz : (high_sz / 2));
+	aio_req_queue->watermark.cb_handler_ptr	= cb_handler;
+	aio_req_queue->watermark.cb_data_ptr	= cb_data;
+	aio_req_queue->flags.above_high			= 0;
+
+	AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
+
+	return;
+}
+/**************************************************************************************************************************/
+int EvAIOReqQueueCanEnqueue(EvAIOReqQueue *aio_req_queue, unsigned long data_sz)
+{
+	EvAIOReqQueueAccount *account = aio_req_queue->watermark.account;
+	EvAIOReqQueue *victim_queue;
+	unsigned long victim_sz;
+
+	/* Not accounted or unlimited, always fits */
+	if ((!account) || (0 == account->max_sz))
+		return 1;
+
+	/* Fits under global memory cap */
+	if ((__atomic_load_n(&account->stats.queue_sz, __ATOMIC_RELAXED) + data_sz) <= account->max_sz)
+		return 1;
+
+	/* Over global cap - Shed the largest queue of this IO loop and check again. Owners usually drop the victim from a
+	 * JOB, so its bytes are not back yet and this enqueue is refused - Writes that come after the JOB will fit */
+	if (AIOREQ_ACCOUNT_SHED_LARGEST == account->shed_policy)
+	{
+		victim_queue = EvAIOReqQueueAccountShedVictimGrab(account, aio_req_queue);
+
+		if (victim_queue)
+		{
+			victim_sz							= victim_queue->stats.queue_sz;
+			victim_queue->flags.shed_pending	= 1;
+
+			__atomic_add_fetch(&account->stats.shed_count, 1, __ATOMIC_RELAXED);
+			__atomic_add_fetch(&account->stats.shed_sz, victim_sz, __ATOMIC_RELAXED);
+
+			KQBASE_LOG_PRINTF(aio_req_queue->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "Account over cap [%lu / %lu] - Shedding queue holding [%lu] bytes\n",
+					account->stats.queue_sz, account->max_sz, victim_sz);
+
+			/* Upper layers should drop the owner of victim queue, releasing its bytes */
+			EvAIOReqQueueWatermarkDispatch(victim_queue, AIOREQ_QUEUE_WATERMARK_SHED);
+
+			if ((__atomic_load_n(&account->stats.queue_sz, __ATOMIC_RELAXED) + data_sz) <= account->max_sz)
+				return 1;
+		}
+	}
+
+	/* Refuse enqueue */
+	__atomic_add_fetch(&account->stats.refuse_count, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+/**************************************************************************************************************************/
+EvAIOReqQueueAccount *EvAIOReqQueueAccountNew(unsigned long max_sz, int shed_policy)
+{
+	EvAIOReqQueueAccount *account = calloc(1, sizeof(EvAIOReqQueueAccount));
+
+	/* Account may be shared among queues of many IO threads, so always carry a MUTEX for its list */
+	account->max_sz			= max_sz;
+	account->shed_policy	= ((shed_policy < AIOREQ_ACCOUNT_SHED_LASTITEM) ? shed_policy : AIOREQ_ACCOUNT_SHED_REFUSE);
+	pthread_mutex_init(&account->mutex, 0);
+
+	return account;
+}
+/**************************************************************************************************************************/
+void EvAIOReqQueueAccountDestroy(EvAIOReqQueueAccount *account)
+{
+	EvAIOReqQueue *aio_req_queue;
+
+	/* Sanity check */
+	if (!account)
+		return;
+
+	pthread_mutex_lock(&account->mutex);
+
+	/* Detach all queues still bound to this account */
+	while ((aio_req_queue = DLinkedListPopHead(&account->queue_list)))
+	{
+		aio_req_queue->watermark.account = NULL;
+		continue;
+	}
+
+	pthread_mutex_unlock(&account->mutex);
+	pthread_mutex_destroy(&account->mutex);
+
+	free(account);
+	return;
+}
+/**************************************************************************************************************************/
+unsigned long EvAIOReqQueueAccountGetSize(EvAIOReqQueueAccount *account)
+{
+	return __atomic_load_n(&account->stats.queue_sz, __ATOMIC_RELAXED);
+}
+/**************************************************************************************************************************/
+void EvAIOReqQueueAccountLink(EvAIOReqQueue *aio_req_queue, EvAIOReqQueueAccount *account)
+{
+	/* Sanity check */
+	if (!aio_req_queue)
+		return;
+
+	/* Already there */
+	if (aio_req_queue->watermark.account == account)
+		return;
+
+	/* Leave previous account, if any */
+	EvAIOReqQueueAccountUnlink(aio_req_queue);
+
+	/* Nothing to link to */
+	if (!account)
+		return;
+
+	AIOREQ_QUEUE_MUTEX_LOCK(aio_req_queue);
+
+	/* Bring along bytes already enqueued */
+	aio_req_queue->watermark.account = account;
+	__atomic_add_fetch(&account->stats.queue_sz, aio_req_queue->stats.queue_sz, __ATOMIC_RELAXED);
+
+	/* Only live queues are shed candidates */
+	if (aio_req_queue->flags.queue_init)
+		EvAIOReqQueueAccountListAdd(aio_req_queue);
+
+	AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
+
+	return;
+}
+/**************************************************************************************************************************/
+void EvAIOReqQueueAccountUnlink(EvAIOReqQueue *aio_req_queue)
+{
+	EvAIOReqQueueAccount *account;
+
+	/* Sanity check */
+	if ((!aio_req_queue) || (!aio_req_queue->watermark.account))
+		return;
+
+	AIOREQ_QUEUE_MUTEX_LOCK(aio_req_queue);
+
+	/* Leave list and give back enqueued bytes */
+	account = aio_req_queue->watermark.account;
+	EvAIOReqQueueAccountListDel(aio_req_queue);
+	__atomic_sub_fetch(&account->stats.queue_sz, aio_req_queue->stats.queue_sz, __ATOMIC_RELAXED);
+	aio_req_queue->watermark.account = NULL;
+
+	AIOREQ_QUEUE_MUTEX_UNLOCK(aio_req_queue);
+
+	return;
+}
+/**************************************************************************************************************************/
 int EvAIOReqQueueCancelAllByFD(EvAIOReqQueue *aio_req_queue, int target_fd)
 {
 	DLinkedListNode *node;
@@ -490,4 +757,115 @@ static int EvAIOReqDoDestroy(EvAIOReq *aio_req)
 	return 1;
 }
 /**************************************************************************************************************************/
+/**************************************************************************************************************************/
+static int EvAIOReqQueueWatermarkTouch(EvAIOReqQueue *aio_req_queue, long delta_sz)
+{
+	EvAIOReqQueueAccount *account = aio_req_queue->watermark.account;
+
+	/* Aggregate accounting, account may be shared with queues of other threads */
+	if ((account) && (delta_sz > 0))
+		__atomic_add_fetch(&account->stats.queue_sz, delta_sz, __ATOMIC_RELAXED);
+	else if ((account) && (delta_sz < 0))
+		__atomic_sub_fetch(&account->stats.queue_sz, -delta_sz, __ATOMIC_RELAXED);
+
+	/* No watermarks set */
+	if (0 == aio_req_queue->watermark.high_sz)
+		return -1;
+
+	/* Crossed HIGH mark going up */
+	if ((!aio_req_queue->flags.above_high) && (aio_req_queue->stats.queue_sz >= aio_req_queue->watermark.high_sz))
+	{
+		aio_req_queue->flags.above_high = 1;
+		return AIOREQ_QUEUE_WATERMARK_HIGH;
+	}
+
+	/* Drained down to LOW mark */
+	if ((aio_req_queue->flags.above_high) && (aio_req_queue->stats.queue_sz <= aio_req_queue->watermark.low_sz))
+	{
+		aio_req_queue->flags.above_high = 0;
+		return AIOREQ_QUEUE_WATERMARK_LOW;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+static void EvAIOReqQueueWatermarkDispatch(EvAIOReqQueue *aio_req_queue, int wm_code)
+{
+	EvAIOReqQueueWatermarkCBH *cb_handler = aio_req_queue->watermark.cb_handler_ptr;
+
+	/* Nothing crossed or nobody listening */
+	if ((wm_code < 0) || (!cb_handler))
+		return;
+
+	cb_handler(aio_req_queue, wm_code, aio_req_queue->watermark.cb_data_ptr);
+	return;
+}
+/**************************************************************************************************************************/
+static void EvAIOReqQueueAccountListAdd(EvAIOReqQueue *aio_req_queue)
+{
+	EvAIOReqQueueAccount *account = aio_req_queue->watermark.account;
+
+	/* Already listed */
+	if (aio_req_queue->flags.account_listed)
+		return;
+
+	pthread_mutex_lock(&account->mutex);
+	DLinkedListAdd(&account->queue_list, &aio_req_queue->watermark.account_node, aio_req_queue);
+	pthread_mutex_unlock(&account->mutex);
+
+	aio_req_queue->flags.account_listed = 1;
+	return;
+}
+/**************************************************************************************************************************/
+static void EvAIOReqQueueAccountListDel(EvAIOReqQueue *aio_req_queue)
+{
+	EvAIOReqQueueAccount *account = aio_req_queue->watermark.account;
+
+	/* Not listed */
+	if ((!account) || (!aio_req_queue->flags.account_listed))
+		return;
+
+	pthread_mutex_lock(&account->mutex);
+	DLinkedListDelete(&account->queue_list, &aio_req_queue->watermark.account_node);
+	pthread_mutex_unlock(&account->mutex);
+
+	aio_req_queue->flags.account_listed = 0;
+	return;
+}
+/**************************************************************************************************************************/
+static EvAIOReqQueue *EvAIOReqQueueAccountShedVictimGrab(EvAIOReqQueueAccount *account, EvAIOReqQueue *aio_req_queue)
+{
+	EvAIOReqQueue *victim_queue = NULL;
+	EvAIOReqQueue *cur_queue;
+	DLinkedListNode *node;
+
+	pthread_mutex_lock(&account->mutex);
+
+	/* Only queues owned by this IO loop can be shed from here, others belong to different threads */
+	for (node = account->queue_list.head; node; node = node->next)
+	{
+		cur_queue = node->data;
+
+		if ((cur_queue == aio_req_queue) || (cur_queue->ev_base != aio_req_queue->ev_base) || (!cur_queue->watermark.cb_handler_ptr))
+			continue;
+
+		/* Already told to go away, shedding it again would only inflate stats */
+		if (cur_queue->flags.shed_pending)
+			continue;
+
+		if ((!victim_queue) || (cur_queue->stats.queue_sz > victim_queue->stats.queue_sz))
+			victim_queue = cur_queue;
+
+		continue;
+	}
+
+	pthread_mutex_unlock(&account->mutex);
+
+	/* Shedding an empty queue gives nothing back */
+	if ((victim_queue) && (0 == victim_queue->stats.queue_sz))
+		return NULL;
+
+	return victim_queue;
+}
+/**************************************************************************************************************************/
 
@@ -41,7 +41,10 @@ static MemBuffer *EvAIOReqTransform_CryptoAIOReq(CommEvContentTransformerInfo *t
 int EvAIOReqTransform_WriteData(void *transform_info_ptr, EvAIOReqQueue *aio_req_queue, EvAIOReq *aio_req)
 {
 	CommEvContentTransformerInfo *transform_info	= transform_info_ptr;
-	CommEvCryptoInfo *crypto						= &transform_info->crypto;
+
+	/* No transformer attached, leave request untouched */
+	if (!transform_info)
+		return 0;
 
 	/* Perform data TRANSFORMATIONS */
 	aio_req->transformed_mb = EvAIOReqTransform_CryptoAIOReq(transform_info, aio_req);
@@ -63,15 +66,63 @@ int EvAIOReqTransform_WriteData(void *transform_info_ptr, EvAIOReqQueue *aio_req
 MemBuffer *EvAIOReqTransform_ReadData(void *transform_info_ptr, char *in_data_ptr, long data_sz)
 {
 	CommEvContentTransformerInfo *transform_info	= transform_info_ptr;
-	CommEvCryptoInfo *crypto						= &transform_info->crypto;
 	MemBuffer *transformed_mb						= NULL;
 
+	/* No transformer attached, nothing to do */
+	if (!transform_info)
+		return NULL;
+
 	/* Perform data TRANSFORMATIONS */
 	transformed_mb = EvAIOReqTransform_CryptoRaw(transform_info, in_data_ptr, data_sz, CRYPTO_OPERATION_READ);
 
 	return transformed_mb;
 }
 /**************************************************************************************************************************/
+int EvAIOReqTransform_ReadChain(void *transform_info_ptr, MemChain *mem_chain, unsigned long offset)
+{
+	CommEvContentTransformerInfo *transform_info	= transform_info_ptr;
+	MemBuffer *transformed_mb						= NULL;
+	char *flat_ptr									= NULL;
+	unsigned long contig_sz;
+	unsigned long data_sz;
+	char *data_ptr;
+
+	/* Nothing to transform, leave chain untouched */
+	if ((!transform_info) || (!transform_info->crypto.flags.enabled) || (!mem_chain) || (offset >= MemChainGetSize(mem_chain)))
+		return 0;
+
+	data_sz		= (MemChainGetSize(mem_chain) - offset);
+	data_ptr	= MemChainOffsetDeref(mem_chain, offset, &contig_sz);
+
+	/* New data crossed a chunk boundary, flatten it so transform sees same single run it would see on a plain read */
+	if (contig_sz < data_sz)
+	{
+		flat_ptr = malloc(data_sz);
+
+		if (!flat_ptr)
+			return 0;
+
+		MemChainPeek(mem_chain, offset, flat_ptr, data_sz);
+		data_ptr = flat_ptr;
+	}
+
+	transformed_mb = EvAIOReqTransform_ReadData(transform_info_ptr, data_ptr, data_sz);
+
+	if (flat_ptr)
+		free(flat_ptr);
+
+	/* Not transformed */
+	if (!transformed_mb)
+		return 0;
+
+	/* Replace raw bytes with transformed ones */
+	MemChainTruncate(mem_chain, offset);
+	MemChainAdd(mem_chain, MemBufferDeref(transformed_mb), MemBufferGetSize(transformed_mb));
+	MemBufferDestroy(transformed_mb);
+
+	return 1;
+}
+/**************************************************************************************************************************/
 int EvAIOReqTransform_CryptoEnable(void *transform_info_ptr, int algo_code, char *key_ptr, int key_sz)
 {
 	CommEvContentTransformerInfo *transform_info	= transform_info_ptr;
@@ -110,7 +161,13 @@ int EvAIOReqTransform_CryptoEnable(void *transform_info_ptr, int algo_code, char
 int EvAIOReqTransform_CryptoDisable(void *transform_info_ptr)
 {
 	CommEvContentTransformerInfo *transform_info	= transform_info_ptr;
-	CommEvCryptoInfo *crypto						= &transform_info->crypto;
+	CommEvCryptoInfo *crypto;
+
+	/* No transformer attached, nothing to disable */
+	if (!transform_info)
+		return 0;
+
+	crypto = &transform_info->crypto;
 
 	/* DISABLE CRYPTO */
 	crypto->algo_code		= COMM_CRYPTO_FUNC_NONE;
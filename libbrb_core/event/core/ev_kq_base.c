@@ -95,6 +95,7 @@ EvKQBase *EvKQBaseNew(EvKQBaseConf *kq_conf)
 	kq_base->flags.mt_engine					= ((kq_conf && KQ_BASE_MULTI_THREADED_ENGINE == kq_conf->engine_type) ? 1 : 0);
 	kq_base->defer.interval_check_ms			= 200;
 	kq_base->skew_min_detect_sec				= 30;
+	kq_base->kq_thread.thrd_id					= (kq_base->flags.mt_engine ? 0 : -1);
 
 	/* Timeout timers */
 	kq_base->timeout.tv_nsec					= KQEV_IOLOOP_MAXINTERVAL_NS;
@@ -129,10 +130,17 @@ EvKQBase *EvKQBaseNew(EvKQBaseConf *kq_conf)
 	DLinkedListInit(&kq_base->defer.write_list, BRBDATA_THREAD_UNSAFE);
 	DLinkedListInit(&kq_base->reg_obj.list, BRBDATA_THREAD_UNSAFE);
 
+	/* Initialize thread INBOX, other threads post jobs here */
+	DLinkedListInit(&kq_base->kq_thread.inbox, BRBDATA_THREAD_SAFE);
+	EvKQBaseThreadWakeupInit(kq_base);
+
 	/* Initialize TIMER and FD arenas */
 	EvKQBaseTimerArenaNew(kq_base, kq_base->kq_conf.arena.timer_max);
 	EvKQBaseFDArenaNew(kq_base);
 
+	/* Initialize FD timeout wheel */
+	EvKQBaseTimeoutWheelInit(kq_base);
+
 	/* Initialize JOB engine */
 	EvKQJobsEngineInit(kq_base, kq_base->kq_conf.job.max_slots);
 
@@ -140,6 +148,10 @@ EvKQBase *EvKQBaseNew(EvKQBaseConf *kq_conf)
 	EvAIOReqQueueInit(kq_base, &kq_base->aio.queue, (kq_conf ? kq_conf->aio.max_slots : 1024),
 			(kq_base->flags.mt_engine ? BRBDATA_THREAD_SAFE : BRBDATA_THREAD_UNSAFE), AIOREQ_QUEUE_SLOTTED);
 
+	/* Running multi-threaded, spawn worker bases */
+	if (kq_base->flags.mt_engine)
+		EvKQBaseThreadEngineInit(kq_base);
+
 	return kq_base;
 }
 /**************************************************************************************************************************/
@@ -148,13 +160,18 @@ void EvKQBaseDestroy(EvKQBase *kq_base)
 	if (!kq_base)
 		return;
 
-	/* Destroy all upper layer objects */
+	/* Stop worker threads, so upper layer objects can be safely destroyed from here */
+	EvKQBaseThreadEngineStop(kq_base);
+
+	/* Destroy all upper layer objects, then worker bases */
 	EvKQBaseObjectDestroyAll(kq_base);
+	EvKQBaseThreadEngineDestroy(kq_base);
 
 	/* Destroy pending JOBs */
 	EvKQJobsEngineDestroy(kq_base);
 
-	/* Destroy FD and timer ARENA */
+	/* Destroy FD timeout wheel, then FD and timer ARENA */
+	EvKQBaseTimeoutWheelDestroy(kq_base);
 	EvKQBaseFDArenaDestroy(kq_base);
 
 	/* IMPORTANT - IMPORTANT - IMPORTANT */
@@ -236,7 +253,7 @@ int EvKQBaseDispatchOnce(EvKQBase *kq_base, int timeout_ms)
 
 
 		/* Dispatch internal event */
-		EvKQBaseInternalEventDispatch(kq_base, 0, -1, KQ_BASE_INTERNAL_EVENT_KEVENT_TIMEOUT);
+		EvKQBaseInternalEventDispatch(kq_base, 0, KQEV_THRD_ID(kq_base), KQ_BASE_INTERNAL_EVENT_KEVENT_TIMEOUT);
 
 		/* INC timeout_count and RESET ERR_COUNT */
 		kq_base->stats.cur_timeout_count++;
@@ -260,7 +277,7 @@ int EvKQBaseDispatchOnce(EvKQBase *kq_base, int timeout_ms)
 				kq_base->stats.cur_error_count, kq_base->kq_conf.error_count_max);
 
 		/* Dispatch internal event */
-		EvKQBaseInternalEventDispatch(kq_base, 0, -1, KQ_BASE_INTERNAL_EVENT_KEVENT_ERROR);
+		EvKQBaseInternalEventDispatch(kq_base, 0, KQEV_THRD_ID(kq_base), KQ_BASE_INTERNAL_EVENT_KEVENT_ERROR);
 
 		/* Too many errors, shutdown this KQ_BASE */
 		if (kq_base->stats.cur_error_count >= kq_base->kq_conf.error_count_max)
@@ -331,10 +348,14 @@ int EvKQInvokeKQueueOnce(EvKQBase *kq_base, int timeout_ms)
 	/* Detect time skew just before updating internal SEC and USEC from TV and then SYNC with TS_SEC and TS_USEC */
 	EvKQBaseTimeSkewDetect(kq_base, timeout_ms);
 
-	/* Dispatch QUEUED jobs and DEFER list */
+	/* Dispatch QUEUED jobs, jobs sent by other threads and DEFER list */
 	EvKQJobsDispatch(kq_base);
+	EvKQBaseThreadInboxDispatch(kq_base);
 	EvKQBaseDeferDispatch(kq_base);
 
+	/* Expire FD timeouts and trim KEVENT wait up to next armed one */
+	EvKQBaseTimeoutWheelDispatch(kq_base);
+
 	/* Invoke the KERNEL KEVENT MECHANISM to retrieve active events */
 	EvKQBaseKEventInvoke(kq_base);
 
@@ -474,12 +495,12 @@ void EvKQBaseAdjustIOLoopTimeout(EvKQBase *kq_base, int interval_ms)
 /**************************************************************************************************************************/
 int EvKQBaseDispatchEventWrite(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int data_size)
 {
-	return EvKQBaseFDEventInvoke(kq_base, kq_fd, KQ_CB_HANDLER_WRITE, data_size, -1, kq_base);
+	return EvKQBaseFDEventInvoke(kq_base, kq_fd, KQ_CB_HANDLER_WRITE, data_size, KQEV_THRD_ID(kq_base), kq_base);
 }
 /**************************************************************************************************************************/
 int EvKQBaseDispatchEventRead(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int data_size)
 {
-	return EvKQBaseFDEventInvoke(kq_base, kq_fd, KQ_CB_HANDLER_READ, data_size, -1, kq_base);
+	return EvKQBaseFDEventInvoke(kq_base, kq_fd, KQ_CB_HANDLER_READ, data_size, KQEV_THRD_ID(kq_base), kq_base);
 }
 /**************************************************************************************************************************/
 int EvKQBaseDispatchEventWriteEOF(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int data_size)
@@ -496,12 +517,12 @@ int EvKQBaseDispatchEventWriteEOF(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, in
 /**************************************************************************************************************************/
 int EvKQBaseDispatchEventReadEOF(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int data_size)
 {
-	return EvKQBaseFDEventInvoke(kq_base, kq_fd, KQ_CB_HANDLER_EOF, data_size, -1, kq_base);
+	return EvKQBaseFDEventInvoke(kq_base, kq_fd, KQ_CB_HANDLER_EOF, data_size, KQEV_THRD_ID(kq_base), kq_base);
 }
 /**************************************************************************************************************************/
 int EvKQBaseDispatchEventReadError(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int data_size)
 {
-	return EvKQBaseFDEventInvoke(kq_base, kq_fd, KQ_CB_HANDLER_READ_ERROR, data_size, -1, kq_base);
+	return EvKQBaseFDEventInvoke(kq_base, kq_fd, KQ_CB_HANDLER_READ_ERROR, data_size, KQEV_THRD_ID(kq_base), kq_base);
 }
 /**************************************************************************************************************************/
 int EvKQBaseAssert(EvKQBase *kq_base, const char *func_str, char *file_str, int line, char *msg, ...)
@@ -600,8 +621,8 @@ static int EvKQInvokeKQFDCallbacks(EvKQBase *kq_base, long invoke_ts)
 		target_fflags	= (int)	kev_ptr[i].fflags;
 		target_filter	= (int) kev_ptr[i].filter;
 
-		/* Signal and timer events wont use FD */
-		if ((EVFILT_SIGNAL != target_filter) && (EVFILT_TIMER != target_filter) && (EVFILT_AIO != target_filter))
+		/* Signal, timer and user events wont use FD */
+		if ((EVFILT_SIGNAL != target_filter) && (EVFILT_TIMER != target_filter) && (EVFILT_AIO != target_filter) && (EVFILT_USER != target_filter))
 		{
 			/* Grab KQ_FD from internal arena and LOCK it, while we process the CB functions */
 			kq_fd				= EvKQBaseFDGrabFromArena(kq_base, target_fd);
@@ -732,7 +753,7 @@ static int EvKQInvokeKQFDCallbacks(EvKQBase *kq_base, long invoke_ts)
 			}
 
 			if (filemon_cb_handler)
-				filemon_cb_handler(target_fd, target_fflags, -1, filemon_cb_data, kq_base);
+				filemon_cb_handler(target_fd, target_fflags, KQEV_THRD_ID(kq_base), filemon_cb_data, kq_base);
 
 			break;
 		}
@@ -762,7 +783,7 @@ static int EvKQInvokeKQFDCallbacks(EvKQBase *kq_base, long invoke_ts)
 			}
 
 			if (filemon_cb_handler)
-				filemon_cb_handler(target_fd, target_fflags, -1, filemon_cb_data, kq_base);
+				filemon_cb_handler(target_fd, target_fflags, KQEV_THRD_ID(kq_base), filemon_cb_data, kq_base);
 
 			break;
 		}
@@ -788,7 +809,7 @@ static int EvKQInvokeKQFDCallbacks(EvKQBase *kq_base, long invoke_ts)
 
 			/* Invoke the CALLBACK handler */
 			if (signal_cb_handler)
-				signal_cb_handler(target_fd, target_int_data, -1, signal_cb_data, kq_base);
+				signal_cb_handler(target_fd, target_int_data, KQEV_THRD_ID(kq_base), signal_cb_data, kq_base);
 
 			break;
 		}
@@ -825,6 +846,15 @@ static int EvKQInvokeKQFDCallbacks(EvKQBase *kq_base, long invoke_ts)
 
 		}
 		/******************************************************************/
+		case EVFILT_USER:
+		{
+			/* Another thread posted into our INBOX and woke us up, drain it now instead of waiting next IO loop */
+			if (KQEV_THREAD_WAKEUP_IDENT == target_fd)
+				EvKQBaseThreadInboxDispatch(kq_base);
+
+			break;
+		}
+		/******************************************************************/
 		default:
 		{
 			KQBASE_LOG_PRINTF(kq_base->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "FD [%d] - Unexpected event: [%d]\n", target_fd, kev_ptr[i].filter);
@@ -834,7 +864,7 @@ static int EvKQInvokeKQFDCallbacks(EvKQBase *kq_base, long invoke_ts)
 		} /* SWITCH CASE EVENT */
 
 		/* Unlock the arena where this FD lives in */
-		if ((EVFILT_SIGNAL != target_filter) && (EVFILT_TIMER != target_filter) && (EVFILT_AIO != target_filter))
+		if ((EVFILT_SIGNAL != target_filter) && (EVFILT_TIMER != target_filter) && (EVFILT_AIO != target_filter) && (EVFILT_USER != target_filter))
 			MemArenaUnlockByID(kq_base->fd.arena, kq_fd->fd.num);
 		continue;
 	}
@@ -1080,6 +1110,10 @@ static void EvKQBaseUpdateReadEvent(EvKQBase *kq_base, int fd, int action, EvBas
 		/* We have a valid cb_handler pointer. Fill in FD call_backs - If FD is being DEFERED, do not ALLOW ADD and ENABLE events to be ADDED */
 		if (cb_handler)
 		{
+			/* Switching from a PERSIST registration, kernel will not change EV_CLEAR / EV_ONESHOT of an existing event, so DELETE it first */
+			if ((kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.enabled) && (kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.persist))
+				EvKQBaseEnqueueEvChg(kq_base, fd, COMM_EV_READ, COMM_ACTION_DELETE, kq_base);
+
 			/* Grab cb_handler and cb_data */
 			kq_fd->cb_handler[KQ_CB_HANDLER_READ].cb_handler_ptr	= cb_handler;
 			kq_fd->cb_handler[KQ_CB_HANDLER_READ].cb_data_ptr		= cb_data;
@@ -1089,6 +1123,7 @@ static void EvKQBaseUpdateReadEvent(EvKQBase *kq_base, int fd, int action, EvBas
 
 			/* Volatile event */
 			kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.persist		= 0;
+			kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.edge		= 0;
 
 			/* Enqueue event change - Send kq_base as user_data */
 			EvKQBaseEnqueueEvChg(kq_base, fd, COMM_EV_READ, action, kq_base);
@@ -1105,14 +1140,28 @@ static void EvKQBaseUpdateReadEvent(EvKQBase *kq_base, int fd, int action, EvBas
 		/* We have a valid cb_handler pointer. Fill in FD call_backs */
 		if (cb_handler)
 		{
+			/* Already registered in kernel with same trigger mode, just switch call_backs and leave change list alone */
+			if ((kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.enabled) && (kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.persist) &&
+					(kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.edge == (COMM_ACTION_ADD_TRANSITION == action)))
+			{
+				kq_fd->cb_handler[KQ_CB_HANDLER_READ].cb_handler_ptr	= cb_handler;
+				kq_fd->cb_handler[KQ_CB_HANDLER_READ].cb_data_ptr		= cb_data;
+				break;
+			}
+
+			/* Switching trigger mode of an existing registration, kernel will not change EV_CLEAR / EV_ONESHOT of it, so DELETE it first */
+			if (kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.enabled)
+				EvKQBaseEnqueueEvChg(kq_base, fd, COMM_EV_READ, COMM_ACTION_DELETE, kq_base);
+
 			kq_fd->cb_handler[KQ_CB_HANDLER_READ].cb_handler_ptr	= cb_handler;
 			kq_fd->cb_handler[KQ_CB_HANDLER_READ].cb_data_ptr		= cb_data;
 
 			/* Mark new state */
 			kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.enabled	 	= 1;
 
-			/* Persistent event */
+			/* Persistent event, edge triggered if TRANSITION (EV_CLEAR) */
 			kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.persist		= 1;
+			kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.edge		= (COMM_ACTION_ADD_TRANSITION == action);
 
 			/* Enqueue event change - Send kq_base as user_data */
 			EvKQBaseEnqueueEvChg(kq_base, fd, COMM_EV_READ, action, kq_base);
@@ -1138,6 +1187,7 @@ static void EvKQBaseUpdateReadEvent(EvKQBase *kq_base, int fd, int action, EvBas
 		/* Mark new state */
 		kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.enabled	 	= 0;
 		kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.persist		= 0;
+		kq_fd->cb_handler[KQ_CB_HANDLER_READ].flags.edge		= 0;
 
 		break;
 
@@ -1909,6 +1959,10 @@ static void EvKQBaseKEventInvoke(EvKQBase *kq_base)
 	/* Get change list A back into index 0 */
 	kq_base->ke_chg.chg_arr_off = 0;
 
+	/* Account KEVENT changes the FD timeout wheel saved on this IO loop */
+	kq_base->stats.timeout_wheel.kchg_saved_last	= kq_base->stats.timeout_wheel.kchg_saved_cur;
+	kq_base->stats.timeout_wheel.kchg_saved_cur		= 0;
+
 	/* Update invoke count */
 	kq_base->stats.kq_invoke_count++;
 
@@ -1940,7 +1994,7 @@ static int EvKQBaseTimeSkewDetect(EvKQBase *kq_base, int timeout_ms)
 	if ((delta_sec < 0) || (delta_sec > kq_base->skew_min_detect_sec))
 	{
 		/* Dispatch internal event */
-		EvKQBaseInternalEventDispatch(kq_base, delta_sec, -1, KQ_BASE_INTERNAL_EVENT_TIMESKEW);
+		EvKQBaseInternalEventDispatch(kq_base, delta_sec, KQEV_THRD_ID(kq_base), KQ_BASE_INTERNAL_EVENT_TIMESKEW);
 
 		/* Grab a copy of local_invoke_ts safely out of ev_base and sync base stamps */
 		kq_base->stats.cur_invoke_ts_sec	= kq_base->stats.cur_invoke_tv.tv_sec;
@@ -131,7 +131,7 @@ int EvKQBaseDeferReadCheckByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int
 
 	/* Invoke the defer check call_back handler */
 	if (defer_read_cb_handler)
-		defer_read = defer_read_cb_handler(kq_fd->fd.num, event_sz, -1, defer_read_cb_data, kq_base);
+		defer_read = defer_read_cb_handler(kq_fd->fd.num, event_sz, KQEV_THRD_ID(kq_base), defer_read_cb_data, kq_base);
 
 	/* OK, upper layers asked for a READ_DEFER, honor it - Will be disabled by CHECK_DEFER */
 	if (defer_read)
@@ -238,7 +238,7 @@ int EvKQBaseDeferWriteCheckByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, in
 	KQBASE_LOG_PRINTF(kq_base->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "FD [%d] - CHECKING DEFER - PERSIST [%d]\n", kq_fd->fd.num, ev_proto->flags.persist);
 
 	/* Invoke the defer check call_back handler */
-	defer_write = defer_write_cb_handler(kq_fd->fd.num, event_sz, -1, defer_write_cb_data, kq_base);
+	defer_write = defer_write_cb_handler(kq_fd->fd.num, event_sz, KQEV_THRD_ID(kq_base), defer_write_cb_data, kq_base);
 
 	/* OK, upper layers asked for a WRITE_DEFER, honor it - Will be disabled by CHECK_DEFER */
 	if (defer_write)
@@ -390,7 +390,7 @@ static void EvKQBaseDeferBeginCheck(EvKQBase *kq_base)
 
 		/* Invoke the defer check call_back handler */
 		if (defer_read_cb_handler)
-			defer_read = defer_read_cb_handler(kq_fd->fd.num, kq_fd->defer.read.pending_bytes, -1, defer_read_cb_data, kq_base);
+			defer_read = defer_read_cb_handler(kq_fd->fd.num, kq_fd->defer.read.pending_bytes, KQEV_THRD_ID(kq_base), defer_read_cb_data, kq_base);
 
 		/* Keep DEFER_READ on this FD */
 		if (defer_read)
@@ -431,7 +431,7 @@ static void EvKQBaseDeferBeginCheck(EvKQBase *kq_base)
 
 		/* Invoke the defer check call_back handler */
 		if (defer_write_cb_handler)
-			defer_write = defer_write_cb_handler(kq_fd->fd.num, kq_fd->defer.write.pending_bytes, -1, defer_write_cb_data, kq_base);
+			defer_write = defer_write_cb_handler(kq_fd->fd.num, kq_fd->defer.write.pending_bytes, KQEV_THRD_ID(kq_base), defer_write_cb_data, kq_base);
 
 		/* Keep DEFER_WRITE on this FD */
 		if (defer_write)
@@ -69,7 +69,6 @@ void EvKQBaseFDArenaDestroy(EvKQBase *kq_base)
 EvBaseKQFileDesc *EvKQBaseFDGrabFromArena(EvKQBase *kq_base, int fd)
 {
 	EvBaseKQFileDesc *kq_fd;
-	int i;
 
 	BRB_ASSERT(kq_base, (kq_base->fd.arena), "Trying to grab from NULL FD arena\n");
 
@@ -91,18 +90,7 @@ EvBaseKQFileDesc *EvKQBaseFDGrabFromArena(EvKQBase *kq_base, int fd)
 		kq_fd->fd.num					= fd;
 
 		/* Clean all timeout info */
-		for (i = 0; i < KQ_CB_TIMEOUT_LASTITEM; i++)
-		{
-			/* Touch cb_ptr and cb_data */
-			kq_fd->timeout[i].cb_handler_ptr	= NULL;
-			kq_fd->timeout[i].cb_data_ptr		= NULL;
-
-			/* Set it to disabled */
-			kq_fd->timeout[i].when_ts			= -1;
-			kq_fd->timeout[i].timeout_ms		= -1;
-			kq_fd->timeout[i].timer_id 			= -1;
-			continue;
-		}
+		EvKQBaseTimeoutInitAllByKQFD(kq_base, kq_fd);
 	}
 
 	return kq_fd;
@@ -157,7 +145,7 @@ int EvKQBaseFDEventInvoke(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int ev_cod
 	}
 
 	/* Jump into event handler */
-	ev_return = cb_handler(kq_fd->fd.num, ev_sz, -1, cb_data, kq_base);
+	ev_return = cb_handler(kq_fd->fd.num, ev_sz, KQEV_THRD_ID(kq_base), cb_data, kq_base);
 
 	return ev_return;
 }
@@ -734,6 +722,25 @@ int EvKQBaseSocketBufferWriteSizeGet(EvKQBase *kq_base, int fd)
 	return buffer_ret;
 }
 /**************************************************************************************************************************/
+int EvKQBaseSocketBufferReadPendingGet(EvKQBase *kq_base, int fd)
+{
+	int pending_bytes	= 0;
+	int op_status;
+
+	/* Sanity check */
+	if (fd < 0)
+		return 0;
+
+	/* Ask kernel how many bytes are waiting on receive buffer */
+	op_status = ioctl(fd, FIONREAD, &pending_bytes);
+
+	/* Failed querying */
+	if (op_status < 0)
+		return -1;
+
+	return pending_bytes;
+}
+/**************************************************************************************************************************/
 int EvKQBaseSocketSetNoDelay(EvKQBase *kq_base, int fd)
 {
 	EvBaseKQFileDesc *kq_fd;
@@ -1145,6 +1152,66 @@ int EvKQBaseSocketSetReusePort(EvKQBase *kq_base, int fd)
 	return 0;
 }
 /**************************************************************************************************************************/
+int EvKQBaseSocketSetReusePortLB(EvKQBase *kq_base, int fd)
+{
+	EvBaseKQFileDesc *kq_fd;
+	int reuseport_on = 1;
+
+	/* Do not allow invalid FDs in this routine */
+	if (fd < 0)
+		return 0;
+
+	/* Grab FD from reference table */
+	kq_fd = EvKQBaseFDGrabFromArena(kq_base, fd);
+
+	/* We should be active if operator is trying to control this FD */
+	kq_fd->flags.active		= 1;
+	kq_fd->flags.closed 	= 0;
+	kq_fd->flags.closing	= 0;
+
+	/* Set sockopt SO_REUSEPORT_LB where plain SO_REUSEPORT does not balance incoming connections */
+#ifdef SO_REUSEPORT_LB
+	if ( setsockopt(fd, SOL_SOCKET, SO_REUSEPORT_LB, &reuseport_on, sizeof(reuseport_on)) == -1)
+		return -1;
+#else
+	if ( setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &reuseport_on, sizeof(reuseport_on)) == -1)
+		return -1;
+#endif
+
+	/* Set flags */
+	kq_fd->flags.so_reuse_port = 1;
+
+	return 0;
+}
+/**************************************************************************************************************************/
+int EvKQBaseSocketSetDeferAccept(EvKQBase *kq_base, int fd, int defer_sec)
+{
+#if defined(SO_ACCEPTFILTER)
+	struct accept_filter_arg accept_filter;
+#endif
+
+	/* Do not allow invalid FDs in this routine */
+	if (fd < 0)
+		return 0;
+
+	/* Must be called after LISTEN. Kernel holds connection on queue until first data arrives, so ACCEPT never sees idle peers */
+#if defined(SO_ACCEPTFILTER)
+	memset(&accept_filter, 0, sizeof(accept_filter));
+	strncpy((char*)&accept_filter.af_name, "dataready", sizeof(accept_filter.af_name) - 1);
+
+	/* Needs ACCF_DATA kernel module loaded */
+	if ( setsockopt(fd, SOL_SOCKET, SO_ACCEPTFILTER, &accept_filter, sizeof(accept_filter)) == -1)
+		return -1;
+#elif defined(TCP_DEFER_ACCEPT)
+	if ( setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &defer_sec, sizeof(defer_sec)) == -1)
+		return -1;
+#else
+	return -1;
+#endif
+
+	return 0;
+}
+/**************************************************************************************************************************/
 int EvKQBaseSocketSetTCPBufferSize(EvKQBase *kq_base, int fd, int size)
 {
 	EvBaseKQFileDesc *kq_fd;
@@ -0,0 +1,282 @@
+/*
+ * ev_kq_thread.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2012 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Multi-threaded engine. The EvKQBase created by the upper layer runs as THRD_ID zero on the calling thread, and
+ * spawns (kq_thread.count_start - 1) worker bases, each one with its own KQUEUE, event array, FD arena and timers,
+ * dispatched by its own thread. A worker base is only touched by its own thread, so anything another thread wants
+ * it to do must be sent to its INBOX with EvKQBaseThreadJobSend, which wakes the worker up through an EVFILT_USER event.
+ */
+
+#include "../include/libbrb_ev_kq.h"
+
+static void *EvKQBaseThreadWorkerLoop(void *worker_ptr);
+static void EvKQBaseThreadWorkerBlockSignals(void);
+
+/**************************************************************************************************************************/
+int EvKQBaseThreadEngineInit(EvKQBase *kq_base)
+{
+	EvKQBaseConf worker_conf;
+	EvKQBase *worker_base;
+	int worker_count;
+	int op_status;
+	int i;
+
+	/* Not running multi-threaded, or already initialized */
+	if ((!kq_base->flags.mt_engine) || (kq_base->kq_thread.worker_arr))
+		return 0;
+
+	/* Calling thread is THRD_ID zero, so spawn the remaining ones */
+	worker_count = (kq_base->kq_conf.kq_thread.count_start > KQEV_THREAD_MAX) ? KQEV_THREAD_MAX : kq_base->kq_conf.kq_thread.count_start;
+	worker_count = (worker_count - 1);
+
+	/* Nothing to spawn */
+	if (worker_count <= 0)
+		return 0;
+
+	/* Workers inherit our configuration, but never spawn workers of their own */
+	memcpy(&worker_conf, &kq_base->kq_conf, sizeof(EvKQBaseConf));
+	worker_conf.engine_type				= KQ_BASE_SERIAL_ENGINE;
+
+	/* Create worker arrays */
+	kq_base->kq_thread.worker_arr		= calloc(worker_count, sizeof(EvKQBase*));
+	kq_base->kq_thread.worker_thrd_arr	= calloc(worker_count, sizeof(pthread_t));
+
+	for (i = 0; i < worker_count; i++)
+	{
+		/* Create worker KQ_BASE */
+		worker_base = EvKQBaseNew(&worker_conf);
+
+		/* Failed creating worker, stop here */
+		if (!worker_base)
+			break;
+
+		/* Link it back to us, and mark as part of a MT engine so upper layers create locked structures */
+		worker_base->flags.mt_engine			= 1;
+		worker_base->kq_thread.parent_base		= kq_base;
+		worker_base->kq_thread.thrd_id			= (i + 1);
+
+		/* Launch thread */
+		op_status = pthread_create(&kq_base->kq_thread.worker_thrd_arr[i], NULL, EvKQBaseThreadWorkerLoop, worker_base);
+
+		/* Thread launch failed, stop here */
+		if (op_status != 0)
+		{
+			EvKQBaseDestroy(worker_base);
+			break;
+		}
+
+		/* Save worker */
+		kq_base->kq_thread.worker_arr[i] = worker_base;
+		kq_base->kq_thread.worker_count++;
+		continue;
+	}
+
+	KQBASE_LOG_PRINTF(kq_base->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "EV_BASE [%p] - Started [%d] of [%d] worker threads\n",
+			kq_base, kq_base->kq_thread.worker_count, worker_count);
+
+	return kq_base->kq_thread.worker_count;
+}
+/**************************************************************************************************************************/
+void EvKQBaseThreadEngineStop(EvKQBase *kq_base)
+{
+	int i;
+
+	/* Ask all workers to leave IO loop, and wake them up so they do not sit on KEVENT until timeout */
+	for (i = 0; i < kq_base->kq_thread.worker_count; i++)
+	{
+		kq_base->kq_thread.worker_arr[i]->kq_thread.stop_request = 1;
+		EvKQBaseThreadWakeup(kq_base->kq_thread.worker_arr[i]);
+	}
+
+	/* Wait for them to finish current IO loop */
+	for (i = 0; i < kq_base->kq_thread.worker_count; i++)
+		pthread_join(kq_base->kq_thread.worker_thrd_arr[i], NULL);
+
+	return;
+}
+/**************************************************************************************************************************/
+void EvKQBaseThreadEngineDestroy(EvKQBase *kq_base)
+{
+	EvKQBaseThreadJob *thrd_job;
+	int i;
+
+	/* Destroy worker bases, threads MUST have been stopped already */
+	for (i = 0; i < kq_base->kq_thread.worker_count; i++)
+		EvKQBaseDestroy(kq_base->kq_thread.worker_arr[i]);
+
+	/* Release worker arrays */
+	free(kq_base->kq_thread.worker_arr);
+	free(kq_base->kq_thread.worker_thrd_arr);
+
+	kq_base->kq_thread.worker_arr		= NULL;
+	kq_base->kq_thread.worker_thrd_arr	= NULL;
+	kq_base->kq_thread.worker_count		= 0;
+
+	/* Drop any job left on INBOX without invoking it */
+	while ((thrd_job = DLinkedListPopHead(&kq_base->kq_thread.inbox)))
+		free(thrd_job);
+
+	return;
+}
+/**************************************************************************************************************************/
+int EvKQBaseThreadCountGet(EvKQBase *kq_base)
+{
+	EvKQBase *parent_base = (kq_base->kq_thread.parent_base ? kq_base->kq_thread.parent_base : kq_base);
+
+	/* Serial engine runs on a single thread */
+	if (!parent_base->flags.mt_engine)
+		return 1;
+
+	return (parent_base->kq_thread.worker_count + 1);
+}
+/**************************************************************************************************************************/
+EvKQBase *EvKQBaseThreadBaseGetByID(EvKQBase *kq_base, int thrd_id)
+{
+	EvKQBase *parent_base = (kq_base->kq_thread.parent_base ? kq_base->kq_thread.parent_base : kq_base);
+
+	/* THRD_ID zero, or serial engine, is the parent itself */
+	if (thrd_id <= 0)
+		return parent_base;
+
+	/* No such worker */
+	if (thrd_id > parent_base->kq_thread.worker_count)
+		return NULL;
+
+	return parent_base->kq_thread.worker_arr[thrd_id - 1];
+}
+/**************************************************************************************************************************/
+int EvKQBaseThreadJobSend(EvKQBase *kq_base, int thrd_id, EvBaseKQCBH *cb_handler, void *cb_data)
+{
+	EvKQBaseThreadJob *thrd_job;
+	EvKQBase *target_base = EvKQBaseThreadBaseGetByID(kq_base, thrd_id);
+
+	/* Sanity check */
+	if ((!target_base) || (!cb_handler))
+		return 0;
+
+	/* Create a new job */
+	thrd_job				= calloc(1, sizeof(EvKQBaseThreadJob));
+	thrd_job->cb_handler	= cb_handler;
+	thrd_job->cb_data		= cb_data;
+
+	/* Enqueue it into target INBOX and wake target up, so job does not wait for KEVENT timeout */
+	DLinkedListAdd(&target_base->kq_thread.inbox, &thrd_job->node, thrd_job);
+	EvKQBaseThreadWakeup(target_base);
+	return 1;
+}
+/**************************************************************************************************************************/
+int EvKQBaseThreadWakeupInit(EvKQBase *kq_base)
+{
+	struct kevent kev;
+
+	/* Register USER event used by other threads to break us out of KEVENT */
+	EV_SET(&kev, KQEV_THREAD_WAKEUP_IDENT, EVFILT_USER, (EV_ADD | EV_CLEAR), 0, 0, NULL);
+
+	/* Apply right now, we are still being created and CHG_ARR belongs to IO loop */
+	if (kevent(kq_base->kq_base, &kev, 1, NULL, 0, NULL) < 0)
+		return 0;
+
+	return 1;
+}
+/**************************************************************************************************************************/
+int EvKQBaseThreadWakeup(EvKQBase *kq_base)
+{
+	struct kevent kev;
+
+	/* Trigger USER event on target KQUEUE. This is a direct syscall, so it is safe from any thread */
+	EV_SET(&kev, KQEV_THREAD_WAKEUP_IDENT, EVFILT_USER, 0, NOTE_TRIGGER, 0, NULL);
+
+	if (kevent(kq_base->kq_base, &kev, 1, NULL, 0, NULL) < 0)
+		return 0;
+
+	return 1;
+}
+/**************************************************************************************************************************/
+int EvKQBaseThreadInboxDispatch(EvKQBase *kq_base)
+{
+	EvKQBaseThreadJob *thrd_job;
+	int job_count = 0;
+
+	/* Nothing on INBOX, leave without touching MUTEX */
+	if (kq_base->kq_thread.inbox.size <= 0)
+		return 0;
+
+	/* Pop and invoke jobs one by one, so senders are never blocked while a job runs */
+	while ((thrd_job = DLinkedListPopHead(&kq_base->kq_thread.inbox)))
+	{
+		thrd_job->cb_handler(KQEV_THRD_ID(kq_base), 0, KQEV_THRD_ID(kq_base), thrd_job->cb_data, kq_base);
+		free(thrd_job);
+
+		job_count++;
+		continue;
+	}
+
+	return job_count;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static void *EvKQBaseThreadWorkerLoop(void *worker_ptr)
+{
+	EvKQBase *kq_base = worker_ptr;
+
+	/* Signals are handled by THRD_ID zero */
+	EvKQBaseThreadWorkerBlockSignals();
+	kq_base->kq_thrd_id = pthread_self();
+
+	/* Loop until parent asks us to stop */
+	while (!kq_base->kq_thread.stop_request)
+	{
+		/* If dispatch ONE returns 0, its time to break IO loop */
+		if (!EvKQBaseDispatchOnce(kq_base, KQ_BASE_TIMEOUT_AUTO))
+			break;
+
+		continue;
+	}
+
+	return NULL;
+}
+/**************************************************************************************************************************/
+static void EvKQBaseThreadWorkerBlockSignals(void)
+{
+	sigset_t new;
+
+	sigfillset(&new);
+	pthread_sigmask(SIG_BLOCK, &new, NULL);
+
+	return;
+}
+/**************************************************************************************************************************/
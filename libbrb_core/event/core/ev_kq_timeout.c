@@ -33,15 +33,25 @@
  */
 
 /*
- * Timeout events will be invoked from a kqueue_timer created at EvKQBaseNew.
+ * Timeout events are kept on a userland hierarchical timing wheel owned by EvKQBase, so arming and
+ * canceling a FD timeout never touches the KEVENT change list. The wheel is advanced once per IO loop
+ * from EvKQInvokeKQueueOnce, using the monotonic clock, and its resolution is the minimum KEVENT wait.
  *
- * It will be invoked either serially or into multiple thread contexts, depending
- * on the kind of engine initialized on EvKQBaseNew.
+ * Level zero has KQEV_TIMEOUT_WHEEL_L0_SLOTS slots of one tick each. Every upper level has KQEV_TIMEOUT_WHEEL_LN_SLOTS
+ * slots, each covering a full turn of the level below it. Items on upper levels are cascaded down when the lower level wraps.
  */
 
 #include "../include/libbrb_ev_kq.h"
 
-static EvBaseKQCBH EvKQBaseTimeoutInternalEvent;
+static void EvKQBaseTimeoutWheelArm(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int timeout_type, int timeout_ms);
+static void EvKQBaseTimeoutWheelCancel(EvKQBase *kq_base, EvBaseKQGenericTimeoutPrototype *timeout_proto);
+static void EvKQBaseTimeoutWheelSlotAdd(EvKQBaseTimeoutWheel *wheel, EvBaseKQFileDesc *kq_fd, EvBaseKQGenericTimeoutPrototype *timeout_proto);
+static void EvKQBaseTimeoutWheelSlotDel(EvKQBaseTimeoutWheel *wheel, EvBaseKQGenericTimeoutPrototype *timeout_proto);
+static int EvKQBaseTimeoutWheelCascade(EvKQBaseTimeoutWheel *wheel, int level, int slot_idx);
+static int EvKQBaseTimeoutWheelExpireSlot(EvKQBase *kq_base, DLinkedList *slot_list);
+static int EvKQBaseTimeoutWheelNextTicks(EvKQBaseTimeoutWheel *wheel);
+static int EvKQBaseTimeoutWheelTypeByNode(EvBaseKQFileDesc *kq_fd, DLinkedListNode *node);
+static unsigned long EvKQBaseTimeoutWheelNowMsec(void);
 
 /**************************************************************************************************************************/
 /* Public event set interface
@@ -65,8 +75,8 @@ void EvKQBaseTimeoutSet(EvKQBase *kq_base, int fd, int timeout_type, int timeout
 	/* Grab FD from reference table */
 	kq_fd = EvKQBaseFDGrabFromArena(kq_base, fd);
 
-	/* Timer already set, bail out */
-	if (kq_fd->timeout[timeout_type].timer_id > -1)
+	/* Timeout already armed, bail out */
+	if (kq_fd->timeout[timeout_type].wheel.slot_list)
 		return;
 
 	//KQBASE_LOG_PRINTF(kq_base->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - TIMEOUT_MS [%d] - TIMEOUT_TYPE [%d]\n", fd, timeout_ms, timeout_type);
@@ -82,18 +92,12 @@ void EvKQBaseTimeoutSet(EvKQBase *kq_base, int fd, int timeout_type, int timeout
 		kq_fd->timeout[timeout_type].when_ts			= local_cur_invoke_ts + (timeout_ms * 1000);
 		kq_fd->timeout[timeout_type].timeout_ms			= timeout_ms;
 
-		/* Add a timeout timer for this FD */
-		kq_fd->timeout[timeout_type].timer_id			= EvKQBaseTimerAdd(kq_base, COMM_ACTION_ADD_VOLATILE, timeout_ms, EvKQBaseTimeoutInternalEvent, kq_fd);
-
-
+		/* Arm this FD timeout into the wheel */
+		EvKQBaseTimeoutWheelArm(kq_base, kq_fd, timeout_type, timeout_ms);
 	}
 	/* Caller sent a NULL cb_handler pointer. Remove the event */
 	else
 	{
-		/* Delete timeout timer for this FD */
-		if (kq_fd->timeout[timeout_type].timer_id > -1)
-			EvKQBaseTimerCtl(kq_base, kq_fd->timeout[timeout_type].timer_id, COMM_ACTION_DELETE);
-
 		/* Touch cb_ptr and cb_data */
 		kq_fd->timeout[timeout_type].cb_handler_ptr		= cb_handler;
 		kq_fd->timeout[timeout_type].cb_data_ptr		= cb_data;
@@ -101,7 +105,6 @@ void EvKQBaseTimeoutSet(EvKQBase *kq_base, int fd, int timeout_type, int timeout
 		/* Touch TIMESTAMPS */
 		kq_fd->timeout[timeout_type].when_ts			= -1;
 		kq_fd->timeout[timeout_type].timeout_ms			= -1;
-		kq_fd->timeout[timeout_type].timer_id 			= -1;
 	}
 
 	return;
@@ -136,10 +139,17 @@ int EvKQBaseTimeoutInitAllByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd)
 	/* Set all to UNINITIALIZED */
 	for (i = 0; i < KQ_CB_TIMEOUT_LASTITEM; i++)
 	{
+		/* Still linked into the wheel, unlink it before losing track of it */
+		if (kq_fd->timeout[i].wheel.slot_list)
+			EvKQBaseTimeoutWheelCancel(kq_base, &kq_fd->timeout[i]);
+
+		/* Touch cb_ptr and cb_data */
+		kq_fd->timeout[i].cb_handler_ptr	= NULL;
+		kq_fd->timeout[i].cb_data_ptr		= NULL;
+
 		/* Set it to disabled */
-		kq_fd->timeout[i].when_ts		= -1;
-		kq_fd->timeout[i].timeout_ms	= -1;
-		kq_fd->timeout[i].timer_id 		= -1;
+		kq_fd->timeout[i].when_ts			= -1;
+		kq_fd->timeout[i].timeout_ms		= -1;
 
 		continue;
 	}
@@ -157,14 +167,14 @@ int EvKQBaseTimeoutClearByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int t
 	if (timeout_type >= KQ_CB_TIMEOUT_LASTITEM)
 		return 0;
 
-	/* No active timer, bail out */
-	if (kq_fd->timeout[timeout_type].timer_id < 0)
+	/* No armed timeout, bail out */
+	if (!kq_fd->timeout[timeout_type].wheel.slot_list)
 		return 0;
 
 	//KQBASE_LOG_PRINTF(kq_base->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "FD [%d] - TIMEOUT TYPE [%d]\n", kq_fd->fd_num, timeout_type);
 
-	/* Delete timeout timer for this FD */
-	EvKQBaseTimerCtl(kq_base, kq_fd->timeout[timeout_type].timer_id, COMM_ACTION_DELETE);
+	/* Remove timeout from wheel */
+	EvKQBaseTimeoutWheelCancel(kq_base, &kq_fd->timeout[timeout_type]);
 
 	/* Touch cb_ptr and cb_data */
 	kq_fd->timeout[timeout_type].cb_handler_ptr		= NULL;
@@ -173,7 +183,6 @@ int EvKQBaseTimeoutClearByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int t
 	/* Set it to disabled */
 	kq_fd->timeout[timeout_type].when_ts		= -1;
 	kq_fd->timeout[timeout_type].timeout_ms		= -1;
-	kq_fd->timeout[timeout_type].timer_id 		= -1;
 
 	return 1;
 }
@@ -215,57 +224,364 @@ int EvKQBaseTimeoutClearAll(EvKQBase *kq_base, int fd)
 	return 1;
 }
 /**************************************************************************************************************************/
-static int EvKQBaseTimeoutInternalEvent(int timer_id, int not_used, int thrd_id, void *cb_data, void *base_ptr)
+/* Timeout wheel interface
+/**************************************************************************************************************************/
+void EvKQBaseTimeoutWheelInit(EvKQBase *kq_base)
 {
+	EvKQBaseTimeoutWheel *wheel = &kq_base->timeout_fd.wheel;
 	int i;
+	int j;
 
-	EvKQBase *kq_base 		= base_ptr;
-	EvBaseKQFileDesc *kq_fd = cb_data;
-	int timeout_type		= -1;
+	/* Clean up wheel */
+	memset(wheel, 0, sizeof(EvKQBaseTimeoutWheel));
 
-	EvBaseKQCBH *user_cb_handler	= NULL;
-	void *user_cb_data				= NULL;
+	/* Initialize level zero slots */
+	for (i = 0; i < KQEV_TIMEOUT_WHEEL_L0_SLOTS; i++)
+		DLinkedListInit(&wheel->level_zero[i], BRBDATA_THREAD_UNSAFE);
 
-	/* Search what timer we are hitting now */
-	for (i = 0; i < KQ_CB_TIMEOUT_LASTITEM; i++)
+	/* Initialize upper level slots */
+	for (i = 0; i < (KQEV_TIMEOUT_WHEEL_LEVELS - 1); i++)
+		for (j = 0; j < KQEV_TIMEOUT_WHEEL_LN_SLOTS; j++)
+			DLinkedListInit(&wheel->level_upper[i][j], BRBDATA_THREAD_UNSAFE);
+
+	/* Wheel TICK zero is NOW */
+	wheel->base_ms	= EvKQBaseTimeoutWheelNowMsec();
+	wheel->cur_tick	= 0;
+
+	return;
+}
+/**************************************************************************************************************************/
+void EvKQBaseTimeoutWheelDestroy(EvKQBase *kq_base)
+{
+	EvKQBaseTimeoutWheel *wheel = &kq_base->timeout_fd.wheel;
+	DLinkedListNode *node;
+	EvBaseKQFileDesc *kq_fd;
+	int timeout_type;
+	int i;
+	int j;
+
+	/* Orphanize any armed timeout still on level zero */
+	for (i = 0; i < KQEV_TIMEOUT_WHEEL_L0_SLOTS; i++)
 	{
-		/* Found timer ID */
-		if (kq_fd->timeout[i].timer_id == timer_id)
+		while ((node = wheel->level_zero[i].head))
 		{
-			timeout_type = i;
-			break;
+			kq_fd			= node->data;
+			timeout_type	= EvKQBaseTimeoutWheelTypeByNode(kq_fd, node);
+			EvKQBaseTimeoutWheelSlotDel(wheel, &kq_fd->timeout[timeout_type]);
+		}
+	}
+
+	/* Orphanize any armed timeout still on upper levels */
+	for (i = 0; i < (KQEV_TIMEOUT_WHEEL_LEVELS - 1); i++)
+	{
+		for (j = 0; j < KQEV_TIMEOUT_WHEEL_LN_SLOTS; j++)
+		{
+			while ((node = wheel->level_upper[i][j].head))
+			{
+				kq_fd			= node->data;
+				timeout_type	= EvKQBaseTimeoutWheelTypeByNode(kq_fd, node);
+				EvKQBaseTimeoutWheelSlotDel(wheel, &kq_fd->timeout[timeout_type]);
+			}
 		}
 	}
 
-	/* WARNING, unexpected timer tick - This should not happen */
-	if (timeout_type < 0)
+	wheel->armed_count = 0;
+	return;
+}
+/**************************************************************************************************************************/
+int EvKQBaseTimeoutWheelDispatch(EvKQBase *kq_base)
+{
+	EvKQBaseTimeoutWheel *wheel = &kq_base->timeout_fd.wheel;
+	unsigned long target_tick;
+	unsigned long now_ms;
+	int cur_timeout_ms;
+	int next_ms;
+	int slot_idx;
+	int level;
+
+	int expired_count	= 0;
+
+	/* Calculate which TICK the wheel should be at from the MONOTONIC clock sampled for this IO loop */
+	now_ms		= (kq_base->stats.monotonic_tp.tv_sec * 1000) + (kq_base->stats.monotonic_tp.tv_nsec / 1000000);
+	target_tick	= ((now_ms > wheel->base_ms) ? ((now_ms - wheel->base_ms) / KQEV_TIMEOUT_WHEEL_TICK_MS) : 0);
+
+	/* Nothing armed, just move the wheel forward */
+	if (0 == wheel->armed_count)
+	{
+		wheel->cur_tick = ((target_tick > wheel->cur_tick) ? target_tick : wheel->cur_tick);
 		return 0;
+	}
 
-	/* WARNING, unexpected timer tick - This should not happen */
-	assert(timeout_type >= 0);
+	/* Walk all TICKs elapsed since last IO loop, expiring in batch */
+	while (wheel->cur_tick < target_tick)
+	{
+		wheel->cur_tick++;
+		slot_idx = (wheel->cur_tick & KQEV_TIMEOUT_WHEEL_L0_MASK);
 
-	/* Grab pointers to cb_handler and data */
-	user_cb_handler	= kq_fd->timeout[timeout_type].cb_handler_ptr;
-	user_cb_data	= kq_fd->timeout[timeout_type].cb_data_ptr;
+		/* Level zero wrapped, cascade upper levels down */
+		if (0 == slot_idx)
+		{
+			for (level = 0; level < (KQEV_TIMEOUT_WHEEL_LEVELS - 1); level++)
+			{
+				/* Cascade this level and stop unless it also wrapped */
+				if (EvKQBaseTimeoutWheelCascade(wheel, level, ((wheel->cur_tick >> (KQEV_TIMEOUT_WHEEL_L0_BITS + (level * KQEV_TIMEOUT_WHEEL_LN_BITS)))
+						& KQEV_TIMEOUT_WHEEL_LN_MASK)))
+					break;
+			}
+		}
 
-	/* Touch cb_ptr and cb_data */
-	kq_fd->timeout[timeout_type].cb_handler_ptr		= NULL;
-	kq_fd->timeout[timeout_type].cb_data_ptr		= NULL;
+		/* Expire every timeout in this slot */
+		expired_count += EvKQBaseTimeoutWheelExpireSlot(kq_base, &wheel->level_zero[slot_idx]);
 
-	/* Set it to disabled */
-	kq_fd->timeout[timeout_type].when_ts		= -1;
-	kq_fd->timeout[timeout_type].timeout_ms		= -1;
-	kq_fd->timeout[timeout_type].timer_id 		= -1;
+		/* Wheel is empty, jump straight to target */
+		if (0 == wheel->armed_count)
+		{
+			wheel->cur_tick = target_tick;
+			break;
+		}
+	}
 
-	/* Lock the arena where this FD lives in */
-	MemArenaLockByID(kq_base->fd.arena, kq_fd->fd.num);
+	/* There are still armed timeouts, make sure KEVENT does not sleep past the next one */
+	if (wheel->armed_count > 0)
+	{
+		next_ms			= (EvKQBaseTimeoutWheelNextTicks(wheel) * KQEV_TIMEOUT_WHEEL_TICK_MS);
+		cur_timeout_ms	= ((kq_base->timeout.tv_sec * 1000) + (kq_base->timeout.tv_nsec / 1000000));
 
-	/* Invoke the callback_handler */
-	if (user_cb_handler)
-		user_cb_handler(kq_fd->fd.num, timeout_type, -1, user_cb_data, kq_base);
+		if (next_ms < cur_timeout_ms)
+			EvKQBaseAdjustIOLoopTimeout(kq_base, next_ms);
+	}
 
-	/* Unlock the arena where this FD lives in */
-	MemArenaUnlockByID(kq_base->fd.arena, kq_fd->fd.num);
-	return 1;
+	return expired_count;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static void EvKQBaseTimeoutWheelArm(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int timeout_type, int timeout_ms)
+{
+	EvKQBaseTimeoutWheel *wheel						= &kq_base->timeout_fd.wheel;
+	EvBaseKQGenericTimeoutPrototype *timeout_proto	= &kq_fd->timeout[timeout_type];
+	unsigned long now_ms							= EvKQBaseTimeoutWheelNowMsec();
+	unsigned long now_tick;
+	unsigned long ticks;
+
+	/* Round up to wheel resolution, at least one TICK ahead */
+	ticks		= ((timeout_ms > 0) ? ((timeout_ms + KQEV_TIMEOUT_WHEEL_TICK_MS - 1) / KQEV_TIMEOUT_WHEEL_TICK_MS) : 1);
+	ticks		= ((ticks > KQEV_TIMEOUT_WHEEL_MAX_TICKS) ? KQEV_TIMEOUT_WHEEL_MAX_TICKS : ticks);
+
+	/* Count from NOW, not from the beginning of this IO loop */
+	now_tick	= ((now_ms > wheel->base_ms) ? ((now_ms - wheel->base_ms) / KQEV_TIMEOUT_WHEEL_TICK_MS) : 0);
+	now_tick	= ((now_tick > wheel->cur_tick) ? now_tick : wheel->cur_tick);
+
+	/* Link it into wheel */
+	timeout_proto->wheel.expire_tick = now_tick + ticks;
+	EvKQBaseTimeoutWheelSlotAdd(wheel, kq_fd, timeout_proto);
+	wheel->armed_count++;
+
+	/* A KEVENT EV_ADD saved */
+	kq_base->stats.timeout_wheel.armed_total++;
+	kq_base->stats.timeout_wheel.kchg_saved_cur++;
+	kq_base->stats.timeout_wheel.kchg_saved_total++;
+	return;
+}
+/**************************************************************************************************************************/
+static void EvKQBaseTimeoutWheelCancel(EvKQBase *kq_base, EvBaseKQGenericTimeoutPrototype *timeout_proto)
+{
+	EvKQBaseTimeoutWheel *wheel = &kq_base->timeout_fd.wheel;
+
+	/* Unlink it from wheel */
+	EvKQBaseTimeoutWheelSlotDel(wheel, timeout_proto);
+	wheel->armed_count--;
+
+	/* A KEVENT EV_DELETE saved */
+	kq_base->stats.timeout_wheel.canceled_total++;
+	kq_base->stats.timeout_wheel.kchg_saved_cur++;
+	kq_base->stats.timeout_wheel.kchg_saved_total++;
+	return;
+}
+/**************************************************************************************************************************/
+static void EvKQBaseTimeoutWheelSlotAdd(EvKQBaseTimeoutWheel *wheel, EvBaseKQFileDesc *kq_fd, EvBaseKQGenericTimeoutPrototype *timeout_proto)
+{
+	unsigned long expire_tick	= timeout_proto->wheel.expire_tick;
+	unsigned long delta			= ((expire_tick > wheel->cur_tick) ? (expire_tick - wheel->cur_tick) : 0);
+	DLinkedList *slot_list;
+	int slot_idx;
+	int level;
+
+	/* Fits into level zero */
+	if (delta < KQEV_TIMEOUT_WHEEL_L0_SLOTS)
+	{
+		slot_idx	= (expire_tick & KQEV_TIMEOUT_WHEEL_L0_MASK);
+		slot_list	= &wheel->level_zero[slot_idx];
+
+		/* Mark slot as busy */
+		wheel->level_zero_map[slot_idx >> 6] |= (1ULL << (slot_idx & 63));
+	}
+	/* Find the first upper level able to hold it */
+	else
+	{
+		for (level = 0; level < (KQEV_TIMEOUT_WHEEL_LEVELS - 2); level++)
+		{
+			if (delta < (1UL << (KQEV_TIMEOUT_WHEEL_L0_BITS + ((level + 1) * KQEV_TIMEOUT_WHEEL_LN_BITS))))
+				break;
+		}
+
+		slot_idx	= ((expire_tick >> (KQEV_TIMEOUT_WHEEL_L0_BITS + (level * KQEV_TIMEOUT_WHEEL_LN_BITS))) & KQEV_TIMEOUT_WHEEL_LN_MASK);
+		slot_list	= &wheel->level_upper[level][slot_idx];
+	}
+
+	DLinkedListAddTail(slot_list, &timeout_proto->wheel.node, kq_fd);
+	timeout_proto->wheel.slot_list = slot_list;
+	return;
+}
+/**************************************************************************************************************************/
+static void EvKQBaseTimeoutWheelSlotDel(EvKQBaseTimeoutWheel *wheel, EvBaseKQGenericTimeoutPrototype *timeout_proto)
+{
+	DLinkedList *slot_list = timeout_proto->wheel.slot_list;
+	int slot_idx;
+
+	DLinkedListDelete(slot_list, &timeout_proto->wheel.node);
+	timeout_proto->wheel.slot_list = NULL;
+
+	/* Level zero slot became empty, mark it as free */
+	if ((slot_list >= &wheel->level_zero[0]) && (slot_list < &wheel->level_zero[KQEV_TIMEOUT_WHEEL_L0_SLOTS]) && (0 == slot_list->size))
+	{
+		slot_idx = (slot_list - &wheel->level_zero[0]);
+		wheel->level_zero_map[slot_idx >> 6] &= ~(1ULL << (slot_idx & 63));
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static int EvKQBaseTimeoutWheelCascade(EvKQBaseTimeoutWheel *wheel, int level, int slot_idx)
+{
+	EvBaseKQGenericTimeoutPrototype *timeout_proto;
+	DLinkedList *slot_list = &wheel->level_upper[level][slot_idx];
+	DLinkedList cascade_list;
+	DLinkedListNode *node;
+	EvBaseKQFileDesc *kq_fd;
+
+	/* Detach the whole slot, so items landing on this same slot again are not walked twice */
+	DLinkedListInit(&cascade_list, BRBDATA_THREAD_UNSAFE);
+	cascade_list.head	= slot_list->head;
+	cascade_list.tail	= slot_list->tail;
+	cascade_list.size	= slot_list->size;
+	slot_list->head		= NULL;
+	slot_list->tail		= NULL;
+	slot_list->size		= 0;
+
+	/* Re-insert each item relative to current TICK */
+	while ((node = cascade_list.head))
+	{
+		kq_fd			= node->data;
+		timeout_proto	= &kq_fd->timeout[EvKQBaseTimeoutWheelTypeByNode(kq_fd, node)];
+
+		DLinkedListDelete(&cascade_list, node);
+		EvKQBaseTimeoutWheelSlotAdd(wheel, kq_fd, timeout_proto);
+		continue;
+	}
+
+	return slot_idx;
+}
+/**************************************************************************************************************************/
+static int EvKQBaseTimeoutWheelExpireSlot(EvKQBase *kq_base, DLinkedList *slot_list)
+{
+	EvKQBaseTimeoutWheel *wheel = &kq_base->timeout_fd.wheel;
+	EvBaseKQGenericTimeoutPrototype *timeout_proto;
+	EvBaseKQCBH *user_cb_handler;
+	DLinkedListNode *node;
+	EvBaseKQFileDesc *kq_fd;
+	void *user_cb_data;
+	int timeout_type;
+
+	int expired_count = 0;
+
+	/* Always pick up HEAD, as CB_HANDLERs may cancel other timeouts living in this same slot */
+	while ((node = slot_list->head))
+	{
+		kq_fd			= node->data;
+		timeout_type	= EvKQBaseTimeoutWheelTypeByNode(kq_fd, node);
+		timeout_proto	= &kq_fd->timeout[timeout_type];
+
+		/* Unlink it from wheel */
+		EvKQBaseTimeoutWheelSlotDel(wheel, timeout_proto);
+		wheel->armed_count--;
+
+		/* Grab pointers to cb_handler and data */
+		user_cb_handler	= timeout_proto->cb_handler_ptr;
+		user_cb_data	= timeout_proto->cb_data_ptr;
+
+		/* Touch cb_ptr and cb_data */
+		timeout_proto->cb_handler_ptr	= NULL;
+		timeout_proto->cb_data_ptr		= NULL;
+
+		/* Set it to disabled */
+		timeout_proto->when_ts			= -1;
+		timeout_proto->timeout_ms		= -1;
+
+		kq_base->stats.timeout_wheel.expired_total++;
+		expired_count++;
+
+		/* Lock the arena where this FD lives in */
+		MemArenaLockByID(kq_base->fd.arena, kq_fd->fd.num);
+
+		/* Invoke the callback_handler */
+		if (user_cb_handler)
+			user_cb_handler(kq_fd->fd.num, timeout_type, KQEV_THRD_ID(kq_base), user_cb_data, kq_base);
+
+		/* Unlock the arena where this FD lives in */
+		MemArenaUnlockByID(kq_base->fd.arena, kq_fd->fd.num);
+		continue;
+	}
+
+	return expired_count;
+}
+/**************************************************************************************************************************/
+static int EvKQBaseTimeoutWheelNextTicks(EvKQBaseTimeoutWheel *wheel)
+{
+	unsigned long long slot_map;
+	int cur_idx		= (wheel->cur_tick & KQEV_TIMEOUT_WHEEL_L0_MASK);
+	int start_idx	= cur_idx + 1;
+	int word_idx;
+
+	/* Search busy level zero slots ahead of current one, up to next wrap */
+	for (word_idx = (start_idx >> 6); word_idx < (KQEV_TIMEOUT_WHEEL_L0_SLOTS / 64); word_idx++)
+	{
+		slot_map = wheel->level_zero_map[word_idx];
+
+		/* Mask out slots behind us on the first word */
+		if (word_idx == (start_idx >> 6))
+			slot_map &= (~0ULL << (start_idx & 63));
+
+		if (slot_map)
+			return (((word_idx * 64) + __builtin_ctzll(slot_map)) - cur_idx);
+	}
+
+	/* Nothing ahead on level zero, next thing to happen is the wrap and its cascade */
+	return (KQEV_TIMEOUT_WHEEL_L0_SLOTS - cur_idx);
+}
+/**************************************************************************************************************************/
+static int EvKQBaseTimeoutWheelTypeByNode(EvBaseKQFileDesc *kq_fd, DLinkedListNode *node)
+{
+	int i;
+
+	/* Search what timeout this node belongs to */
+	for (i = 0; i < KQ_CB_TIMEOUT_LASTITEM; i++)
+	{
+		if (&kq_fd->timeout[i].wheel.node == node)
+			return i;
+	}
+
+	/* WARNING, unexpected wheel node - This should not happen */
+	assert(0);
+	return -1;
+}
+/**************************************************************************************************************************/
+static unsigned long EvKQBaseTimeoutWheelNowMsec(void)
+{
+	struct timespec now_tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &now_tp);
+	return ((now_tp.tv_sec * 1000) + (now_tp.tv_nsec / 1000000));
 }
 /**************************************************************************************************************************/
@@ -264,7 +264,7 @@ int EvKQBaseTimerDispatch(EvKQBase *kq_base, int timer_id, int int_data)
 
 	/* Invoke the CALLBACK handler */
 	if (timer_cb_handler)
-		timer_cb_handler(timer_id, int_data, -1, timer_cb_data, kq_base);
+		timer_cb_handler(timer_id, int_data, KQEV_THRD_ID(kq_base), timer_cb_data, kq_base);
 
 	return 1;
 }
@@ -2491,7 +2491,7 @@ static int EvKQFileMappedMetaDataRawUpdate(EvKQFileMapped *file_mapped)
 	/* Pack data into METADATA SERIALIZER and DUMP it into MEMBUFFER */
 	MetaDataItemAdd(&metadata, FILEMAPPED_META_MAIN, 0, &file_mapped_meta, sizeof(EvKQFileMappedMetaData));
 	DynBitMapMetaDataPack(file_mapped->meta.bitmap, &metadata, FILEMAPPED_META_DYN_BITMAP);
-	MetaDataPack(&metadata, packed_mb);
+	MetaDataPackV2(&metadata, packed_mb, METADATA_CHECKSUM_CRC32C);
 
 	/* Clean UP METDATA - Data is already serialized on MB */
 	MetaDataClean(&metadata);
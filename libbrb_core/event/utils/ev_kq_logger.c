@@ -40,6 +40,16 @@ static int EvKQBaseLogBaseMemEnforceLimit(EvKQBaseLogBase *log_base);
 static int EvKQBaseLogBaseDoWrite(EvKQBaseLogBase *log_base, char *color_str, char *line_str, int line_sz);
 static int EvKQBaseLogBaseDoDestroy(EvKQBaseLogBase *log_base);
 static void EvKQBaseLoggerAddDontLock(EvKQBaseLogBase *log_base, int type, int color, const char *file, const char *func, const int line, const char *message, ...);
+static int EvKQBaseLogBaseTimeStrFill(EvKQBaseLogBase *log_base, EvKQBaseLogTimeCache *time_cache, char *time_buf, int time_buf_sz);
+static char *EvKQBaseLogBaseColorStrGet(int color);
+
+static int EvKQBaseLogBaseAsyncStart(EvKQBaseLogBase *log_base);
+static int EvKQBaseLogBaseAsyncStop(EvKQBaseLogBase *log_base);
+static int EvKQBaseLogBaseAsyncAdd(EvKQBaseLogBase *log_base, EvKQBaseLogTypeCodes type, int color, const char *file, const char *func, const int line, const char *message, va_list args);
+static int EvKQBaseLogBaseAsyncDrain(EvKQBaseLogBase *log_base, int try_lock);
+static EvKQBaseLogAsyncRing *EvKQBaseLogBaseAsyncRingGet(EvKQBaseLogBase *log_base);
+static void EvKQBaseLogBaseAsyncRingOrphan(void *ring_ptr);
+static void *EvKQBaseLogBaseAsyncWriterLoop(void *log_base_ptr);
 static EvBaseKQCBH EvKQBaseLoggerTimerEvent;
 static EvBaseKQCBH EvKQBaseLogBaseFileMonCB;
 
@@ -113,6 +123,13 @@ EvKQBaseLogBase *EvKQBaseLogBaseNew(EvKQBase *ev_base, EvKQBaseLogBaseConf *log_
 		log_base->fileout			= NULL;
 	}
 
+	/* Upper layers want lines written by a background thread - ASYNC lines never touch LASTMSG state, so no AUTOHASH */
+	if (log_conf->flags.async_write)
+	{
+		log_base->flags.async_write			= EvKQBaseLogBaseAsyncStart(log_base);
+		log_base->flags.autohash_disable	|= log_base->flags.async_write;
+	}
+
 	return log_base;
 }
 /**************************************************************************************************************************/
@@ -120,11 +137,18 @@ static int EvKQBaseLogBaseFileMonCB(int fd, int action, int thrd_id, void *cb_da
 {
 	EvKQBaseLogBase *log_base 	= cb_data;
 
+	/* ASYNC writer may be using FILEOUT */
+	if (log_base->async.running)
+		MUTEX_LOCK(log_base->mutex, "LOG_BASE");
+
 	if (log_base->fileout)
 		fclose(log_base->fileout);
 
 	log_base->fileout			= fopen(log_base->fileout_pathstr, "a+");
 
+	if (log_base->async.running)
+		MUTEX_UNLOCK(log_base->mutex, "LOG_BASE");
+
 	/* Unable to open for writing */
 	if (log_base->fileout == NULL)
 	{
@@ -154,6 +178,9 @@ int EvKQBaseLogBaseDestroy(EvKQBaseLogBase *log_base)
 	if (log_base->ref_count-- > 0)
 		return log_base->ref_count;
 
+	/* Stop ASYNC writer, it will flush pending lines before FILEOUT goes away */
+	EvKQBaseLogBaseAsyncStop(log_base);
+
 	if (log_base->fileout)
 	{
 #ifdef IS_LINUX
@@ -394,6 +421,21 @@ char *EvKQBaseLoggerAdd(EvKQBaseLogBase *log_base, int force, EvKQBaseLogTypeCod
 			return NULL;
 	}
 
+	va_list args						= {0};
+	int op_status;
+
+	/* ASYNC writer running and line does not need LOG_BASE state, format straight into this thread RING without locking */
+	if ((log_base->flags.async_write) && (log_base->async.running) && (!log_base->flags.mem_only_logs))
+	{
+		va_start(args, message);
+		op_status = EvKQBaseLogBaseAsyncAdd(log_base, type, color, file, func, line, message, args);
+		va_end(args);
+
+		/* Done, otherwise RING is full or line is too long, fall back to synchronous write */
+		if (op_status)
+			return (char*)message;
+	}
+
 	/* Running THREAD_SAFE, LOCK MUTEX */
 	if (log_base->flags.thread_safe)
 		MUTEX_LOCK(log_base->mutex, "LOG_BASE");
@@ -401,13 +443,8 @@ char *EvKQBaseLoggerAdd(EvKQBaseLogBase *log_base, int force, EvKQBaseLogTypeCod
 	/* Set up STACK */
 	EvKQBase *ev_base					= log_base->ev_base;
 	EvKQBaseLogBase *_log_base			= ev_base->log_base;
-	struct timeval *first_tv			= (struct timeval *)&ev_base->stats.first_invoke_tv;
 	struct timeval *cur_tv				= (struct timeval *)&ev_base->stats.cur_invoke_tv;
-	struct timeval uninit_tv 			= {0};
-	struct tm *tm						= NULL;
-	struct tm tm_tmp 					= {0};
-	va_list args						= {0};
-	static char time_buf[128] 			= {0};
+	char time_buf[128] 					= {0};
 	char fmt_buf[MEMBUFFER_MAX_PRINTF]	= {0};
 	char lastmsg_buf[1024] 				= {0};
 	char *buf_ptr						= (char*)&fmt_buf;
@@ -418,7 +455,7 @@ char *EvKQBaseLoggerAdd(EvKQBaseLogBase *log_base, int force, EvKQBaseLogTypeCod
 	unsigned int lastmsg_hash 			= 0;
 	int timer_id 						= log_base->lastmsg.timer_id;
 	int msg_len 						= 0;
-	int time_offset						= 0;
+	int prefix_len						= 0;
 	int lastmsg_offset					= 0;
 	int offset							= 0;
 	int msg_malloc						= 0;
@@ -427,72 +464,37 @@ char *EvKQBaseLoggerAdd(EvKQBaseLogBase *log_base, int force, EvKQBaseLogTypeCod
 	/* Detach LOG_BASE from EV_BASE to avoid recursively looping on functions that use LogAdd */
 	ev_base->log_base = NULL;
 
-	/* Initialize CUR_TV */
-	if (cur_tv->tv_sec == 0)
-	{
-		/* Touch time_stamps */
-		gettimeofday(&uninit_tv, NULL);
-
-		cur_tv	= &uninit_tv;
-		tm		= localtime_r((const time_t*)&cur_tv->tv_sec, &tm_tmp);
-	}
-	/* Already initialized, grab from EV_BASE */
-	else
-		tm		= localtime_r((const time_t*)&ev_base->stats.cur_invoke_ts_sec, &tm_tmp);
-
-	/* Generate TIME string */
-//	time_offset = strftime(time_buf, (sizeof(time_buf) - 1), "%Y-%m-%d %H:%M:%S.", tm);
-	time_offset = snprintf((char *)&time_buf, sizeof(time_buf) - 1, "%04d-%02d-%02d %02d:%02d:%02d.",
-			tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec);
-
-	if (log_base->flags.thread_safe)
-	{
-#ifdef IS_LINUX
-		snprintf((time_buf_ptr + time_offset), sizeof(time_buf), "%06ld - %06ld - %02X]", cur_tv->tv_usec, log_base->ev_base->stats.kq_invoke_count, 0);
-#else
-		snprintf((time_buf_ptr + time_offset), sizeof(time_buf), "%06ld - %06ld - %02X]", cur_tv->tv_usec, log_base->ev_base->stats.kq_invoke_count, pthread_getthreadid_np());
-#endif
-	}
-	else
-		snprintf((time_buf_ptr + time_offset), sizeof(time_buf), "%06ld - %06ld]", cur_tv->tv_usec, log_base->ev_base->stats.kq_invoke_count);
+	/* Generate TIME string, DATE part is cached per second */
+	EvKQBaseLogBaseTimeStrFill(log_base, &log_base->time_cache, time_buf_ptr, sizeof(time_buf));
 
 	/* Select COLOR */
-	switch(color)
-	{
-	case LOGCOLOR_RED:		color_str = COLOR_FOREGROUND_LIGHTRED;		break;
-	case LOGCOLOR_GREEN:	color_str = COLOR_FOREGROUND_LIGHTGREEN;	break;
-	case LOGCOLOR_YELLOW:	color_str = COLOR_FOREGROUND_LIGHTYELLOW;	break;
-	case LOGCOLOR_BLUE:		color_str = COLOR_FOREGROUND_LIGHTBLUE;		break;
-	case LOGCOLOR_PURPLE:	color_str = COLOR_FOREGROUND_LIGHTPURPLE;	break;
-	case LOGCOLOR_CYAN:		color_str = COLOR_FOREGROUND_LIGHTCYAN;		break;
-	case LOGCOLOR_ORANGE:	color_str = COLOR_FOREGROUND_ORANGE;		break;
+	color_str = EvKQBaseLogBaseColorStrGet(color);
 
-	default:				color_str = COLOR_FOREGROUND_DEFAULT;		break;
-	}
+	/* Create main MSG on local stack */
+	prefix_len = snprintf(buf_ptr, (alloc_sz - 1), "[%s-[%s]-[%s:%d]-[%s] - ", time_buf_ptr, evkq_glob_logtype_str[type], file, line, func);
 
-	/* Create main MSG */
 	va_start(args, message);
-	msg_len 		= vsnprintf(NULL, 0, message, args);
+	msg_len = vsnprintf((buf_ptr + prefix_len), ((alloc_sz - 1) - prefix_len), message, args);
 	va_end(args);
 
-	/* Too big to fit on local stack, use heap */
-	if (msg_len > (MEMBUFFER_MAX_PRINTF - 16))
+	/* Too big to fit on local stack, use heap and print again */
+	if ((prefix_len + msg_len) > (MEMBUFFER_MAX_PRINTF - 16))
 	{
 		/* Set new alloc size to replace default */
-		alloc_sz	= (msg_len + 16);
+		alloc_sz	= (prefix_len + msg_len + 16);
 		buf_ptr		= malloc(alloc_sz);
 		msg_malloc	= 1;
+
+		memcpy(buf_ptr, &fmt_buf, prefix_len);
+
+		va_start(args, message);
+		vsnprintf((buf_ptr + prefix_len), ((alloc_sz - 1) - prefix_len), message, args);
+		va_end(args);
 	}
 
-	/* Initialize VA ARGs */
-	va_start(args, message);
-	offset = snprintf(buf_ptr, (alloc_sz - 1), "[%s-[%s]-[%s:%d]-[%s] - ", time_buf_ptr, evkq_glob_logtype_str[type], file, line, func);
-	offset += vsnprintf((buf_ptr + offset), ((alloc_sz - 1) - offset), message, args);
+	offset = (prefix_len + msg_len);
 	buf_ptr[offset] = '\0';
 
-	/* Finish with VA ARGs list */
-	va_end(args);
-
 	/* AutoHash is not disabled, do it - Just hash what will be written */
 	if (!log_base->flags.autohash_disable)
 	{
@@ -582,6 +584,10 @@ int EvKQBaseLoggerMemDumpOnCrash(EvKQBaseLogBase *log_base)
 	if (!log_base)
 		return 0;
 
+	/* Best effort to get lines still sitting on ASYNC RINGs out, never block here */
+	if (log_base->async.running)
+		EvKQBaseLogBaseAsyncDrain(log_base, 1);
+
 	//	printf("DUMPING CRASH - DUMP ON SIGNAL [%d]\n", log_base->flags.dump_on_signal);
 
 	/* Do not want to DUMP on signal */
@@ -695,6 +701,15 @@ int EvKQBaseLoggerMemDump(EvKQBaseLogBase *log_base)
 	return line_count;
 }
 /**************************************************************************************************************************/
+int EvKQBaseLoggerAsyncFlush(EvKQBaseLogBase *log_base)
+{
+	/* Sanity check */
+	if ((!log_base) || (!log_base->async.running))
+		return 0;
+
+	return EvKQBaseLogBaseAsyncDrain(log_base, 0);
+}
+/**************************************************************************************************************************/
 /**/
 /**/
 /**************************************************************************************************************************/
@@ -953,6 +968,9 @@ static int EvKQBaseLogBaseDoDestroy(EvKQBaseLogBase *log_base)
 	/* There should be no locks here */
 	assert(-1 == log_base->ref_count);
 
+	/* Stop ASYNC writer, if not stopped yet */
+	EvKQBaseLogBaseAsyncStop(log_base);
+
 	/* Delete and RESET timer ID */
 	if (log_base->lastmsg.timer_id > -1)
 		EvKQBaseTimerCtl(log_base->ev_base, log_base->lastmsg.timer_id, COMM_ACTION_DELETE);
@@ -1094,3 +1112,378 @@ static int EvKQBaseLoggerTimerEvent(int timer_id, int unused, int thrd_id, void
 	log_base->lastmsg.timer_id = EvKQBaseTimerAdd(log_base->ev_base, COMM_ACTION_ADD_VOLATILE, 1000, EvKQBaseLoggerTimerEvent, log_base);
 	return 1;
 }
+/**/
+/**/
+/**************************************************************************************************************************/
+static int EvKQBaseLogBaseTimeStrFill(EvKQBaseLogBase *log_base, EvKQBaseLogTimeCache *time_cache, char *time_buf, int time_buf_sz)
+{
+	struct timeval uninit_tv;
+	struct tm tm_tmp;
+	struct tm *tm;
+
+	EvKQBase *ev_base		= log_base->ev_base;
+	struct timeval *cur_tv	= (struct timeval *)&ev_base->stats.cur_invoke_tv;
+
+	/* Initialize CUR_TV */
+	if (cur_tv->tv_sec == 0)
+	{
+		/* Touch time_stamps */
+		gettimeofday(&uninit_tv, NULL);
+		cur_tv = &uninit_tv;
+	}
+
+	/* Second changed, generate DATE string again */
+	if (time_cache->sec != cur_tv->tv_sec)
+	{
+		tm					= localtime_r((const time_t*)&cur_tv->tv_sec, &tm_tmp);
+		time_cache->len		= snprintf((char *)&time_cache->str, sizeof(time_cache->str), "%04d-%02d-%02d %02d:%02d:%02d.",
+				tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec);
+		time_cache->sec		= cur_tv->tv_sec;
+	}
+
+	memcpy(time_buf, &time_cache->str, time_cache->len);
+
+	if (log_base->flags.thread_safe)
+	{
+#ifdef IS_LINUX
+		return (time_cache->len + snprintf((time_buf + time_cache->len), (time_buf_sz - time_cache->len), "%06ld - %06ld - %02X]", cur_tv->tv_usec, ev_base->stats.kq_invoke_count, 0));
+#else
+		return (time_cache->len + snprintf((time_buf + time_cache->len), (time_buf_sz - time_cache->len), "%06ld - %06ld - %02X]", cur_tv->tv_usec, ev_base->stats.kq_invoke_count, pthread_getthreadid_np()));
+#endif
+	}
+
+	return (time_cache->len + snprintf((time_buf + time_cache->len), (time_buf_sz - time_cache->len), "%06ld - %06ld]", cur_tv->tv_usec, ev_base->stats.kq_invoke_count));
+}
+/**************************************************************************************************************************/
+static char *EvKQBaseLogBaseColorStrGet(int color)
+{
+	switch(color)
+	{
+	case LOGCOLOR_RED:		return COLOR_FOREGROUND_LIGHTRED;
+	case LOGCOLOR_GREEN:	return COLOR_FOREGROUND_LIGHTGREEN;
+	case LOGCOLOR_YELLOW:	return COLOR_FOREGROUND_LIGHTYELLOW;
+	case LOGCOLOR_BLUE:		return COLOR_FOREGROUND_LIGHTBLUE;
+	case LOGCOLOR_PURPLE:	return COLOR_FOREGROUND_LIGHTPURPLE;
+	case LOGCOLOR_CYAN:		return COLOR_FOREGROUND_LIGHTCYAN;
+	case LOGCOLOR_ORANGE:	return COLOR_FOREGROUND_ORANGE;
+	}
+
+	return COLOR_FOREGROUND_DEFAULT;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static int EvKQBaseLogBaseAsyncStart(EvKQBaseLogBase *log_base)
+{
+	/* Already running */
+	if (log_base->async.running)
+		return 0;
+
+	/* Each thread finds its own RING through this KEY */
+	if (pthread_key_create(&log_base->async.ring_key, EvKQBaseLogBaseAsyncRingOrphan) != 0)
+		return 0;
+
+	/* Launch writer thread */
+	log_base->async.stop_request = 0;
+
+	if (pthread_create(&log_base->async.writer_thrd, NULL, EvKQBaseLogBaseAsyncWriterLoop, log_base) != 0)
+	{
+		pthread_key_delete(log_base->async.ring_key);
+		return 0;
+	}
+
+	log_base->async.running = 1;
+	return 1;
+}
+/**************************************************************************************************************************/
+static int EvKQBaseLogBaseAsyncStop(EvKQBaseLogBase *log_base)
+{
+	int i;
+
+	/* Not running */
+	if (!log_base->async.running)
+		return 0;
+
+	/* Ask writer to leave, it drains all RINGs on its way out */
+	__atomic_store_n(&log_base->async.stop_request, 1, __ATOMIC_RELEASE);
+	pthread_join(log_base->async.writer_thrd, NULL);
+
+	/* From now on, lines are written synchronously */
+	log_base->async.running = 0;
+	pthread_key_delete(log_base->async.ring_key);
+
+	/* Release RINGs */
+	for (i = 0; i < log_base->async.ring_count; i++)
+	{
+		free(log_base->async.ring_arr[i]);
+		log_base->async.ring_arr[i] = NULL;
+	}
+
+	log_base->async.ring_count = 0;
+	return 1;
+}
+/**************************************************************************************************************************/
+static int EvKQBaseLogBaseAsyncAdd(EvKQBaseLogBase *log_base, EvKQBaseLogTypeCodes type, int color, const char *file, const char *func, const int line, const char *message, va_list args)
+{
+	EvKQBaseLogAsyncRing *log_ring;
+	EvKQBaseLogAsyncSlot *log_slot;
+	char time_buf[128];
+	unsigned long head;
+	unsigned long tail;
+	int retry_count;
+	int offset;
+
+	/* Grab this thread RING */
+	log_ring = EvKQBaseLogBaseAsyncRingGet(log_base);
+
+	/* No RING available for this thread */
+	if (!log_ring)
+		return 0;
+
+	/* We are the only producer, TAIL is ours */
+	tail	= log_ring->tail;
+	head	= __atomic_load_n(&log_ring->head, __ATOMIC_ACQUIRE);
+
+	/* RING is full, give writer a chance - Then drop and count, a synchronous write now would jump ahead of queued lines */
+	for (retry_count = 0; ((tail - head) >= KQBASE_LOGGER_ASYNC_SLOT_COUNT); retry_count++)
+	{
+		if (retry_count >= KQBASE_LOGGER_ASYNC_FULL_RETRY)
+		{
+			__atomic_add_fetch(&log_ring->drop_count, 1, __ATOMIC_RELAXED);
+			return 1;
+		}
+
+		sched_yield();
+		head = __atomic_load_n(&log_ring->head, __ATOMIC_ACQUIRE);
+		continue;
+	}
+
+	log_slot = &log_ring->slot_arr[tail & (KQBASE_LOGGER_ASYNC_SLOT_COUNT - 1)];
+
+	/* Format straight into SLOT */
+	EvKQBaseLogBaseTimeStrFill(log_base, &log_ring->time_cache, (char*)&time_buf, sizeof(time_buf));
+	offset  = snprintf((char*)&log_slot->line_str, sizeof(log_slot->line_str), "[%s-[%s]-[%s:%d]-[%s] - ", (char*)&time_buf, evkq_glob_logtype_str[type], file, line, func);
+
+	if (offset < sizeof(log_slot->line_str))
+		offset += vsnprintf(((char*)&log_slot->line_str + offset), (sizeof(log_slot->line_str) - offset), message, args);
+
+	/* Line does not fit SLOT, let queued lines go out first so synchronous write keeps this thread order */
+	if (offset >= sizeof(log_slot->line_str))
+	{
+		for (retry_count = 0; ((retry_count < KQBASE_LOGGER_ASYNC_FULL_RETRY) && (__atomic_load_n(&log_ring->head, __ATOMIC_ACQUIRE) != tail)); retry_count++)
+			sched_yield();
+
+		return 0;
+	}
+
+	log_slot->color_str	= EvKQBaseLogBaseColorStrGet(color);
+	log_slot->line_sz	= offset;
+
+	/* Publish SLOT to writer */
+	__atomic_store_n(&log_ring->tail, (tail + 1), __ATOMIC_RELEASE);
+	return 1;
+}
+/**************************************************************************************************************************/
+static int EvKQBaseLogBaseAsyncDrain(EvKQBaseLogBase *log_base, int try_lock)
+{
+	struct iovec file_iov[(KQBASE_LOGGER_ASYNC_IOV_LINES * 3) + 1];
+	struct iovec err_iov[KQBASE_LOGGER_ASYNC_IOV_LINES * 3];
+	EvKQBaseLogAsyncRing *log_ring;
+	EvKQBaseLogAsyncSlot *log_slot;
+	char drop_buf[128];
+	unsigned long drop_count;
+	unsigned long head;
+	unsigned long tail;
+	int ring_count;
+	int file_iov_count;
+	int err_iov_count;
+	int line_count;
+	int file_fd;
+	int op_status;
+	int i;
+
+	int total_count = 0;
+
+	/* Writer and crash dump may race here, and FILEOUT may be reopened */
+	if (try_lock)
+	{
+		if (pthread_mutex_trylock(&log_base->mutex) != 0)
+			return 0;
+	}
+	else
+		MUTEX_LOCK(log_base->mutex, "LOG_BASE");
+
+	/* Grab where to write */
+#ifdef IS_LINUX
+	file_fd		= (log_base->fileout ? log_base->fileout->_fileno : KQBASE_STDERR);
+#else
+	file_fd		= (log_base->fileout ? log_base->fileout->_file : KQBASE_STDERR);
+#endif
+	ring_count	= __atomic_load_n(&log_base->async.ring_count, __ATOMIC_ACQUIRE);
+
+	for (i = 0; i < ring_count; i++)
+	{
+		log_ring = __atomic_load_n(&log_base->async.ring_arr[i], __ATOMIC_ACQUIRE);
+
+		/* Slot claimed but RING not published yet */
+		if (!log_ring)
+			continue;
+
+		/* TAG to gather another batch from this RING */
+		gather_again:
+
+		head		= log_ring->head;
+		tail		= __atomic_load_n(&log_ring->tail, __ATOMIC_ACQUIRE);
+		drop_count	= __atomic_exchange_n(&log_ring->drop_count, 0, __ATOMIC_ACQ_REL);
+
+		/* Nothing pending on this RING */
+		if ((head == tail) && (0 == drop_count))
+			continue;
+
+		file_iov_count	= 0;
+		err_iov_count	= 0;
+
+		/* Producer dropped lines while RING was full, say so in the stream */
+		if (drop_count > 0)
+		{
+			file_iov[file_iov_count].iov_base	= drop_buf;
+			file_iov[file_iov_count++].iov_len	= snprintf(drop_buf, sizeof(drop_buf), "[ASYNC LOGGER] - [%lu] lines dropped, RING was full\n", drop_count);
+		}
+
+		/* Gather up to IOV_LINES lines */
+		for (line_count = 0; ((head + line_count) != tail) && (line_count < KQBASE_LOGGER_ASYNC_IOV_LINES); line_count++)
+		{
+			log_slot = &log_ring->slot_arr[(head + line_count) & (KQBASE_LOGGER_ASYNC_SLOT_COUNT - 1)];
+
+			/* FILE or STDERR, colors unless disabled for FILE */
+			if ((!log_base->fileout) || (!log_base->flags.disable_colors_onfile))
+			{
+				file_iov[file_iov_count].iov_base	= log_slot->color_str;
+				file_iov[file_iov_count++].iov_len	= strlen(log_slot->color_str);
+			}
+
+			file_iov[file_iov_count].iov_base		= log_slot->line_str;
+			file_iov[file_iov_count++].iov_len		= log_slot->line_sz;
+
+			if ((!log_base->fileout) || (!log_base->flags.disable_colors_onfile))
+			{
+				file_iov[file_iov_count].iov_base	= COLOR_FOREGROUND_DEFAULT;
+				file_iov[file_iov_count++].iov_len	= strlen(COLOR_FOREGROUND_DEFAULT);
+			}
+
+			/* Upper layers has file SET but wants DOUBLE WRITE, write to STDERR too */
+			if ((log_base->fileout) && (log_base->flags.double_write))
+			{
+				err_iov[err_iov_count].iov_base		= log_slot->color_str;
+				err_iov[err_iov_count++].iov_len	= strlen(log_slot->color_str);
+				err_iov[err_iov_count].iov_base		= log_slot->line_str;
+				err_iov[err_iov_count++].iov_len	= log_slot->line_sz;
+				err_iov[err_iov_count].iov_base		= COLOR_FOREGROUND_DEFAULT;
+				err_iov[err_iov_count++].iov_len	= strlen(COLOR_FOREGROUND_DEFAULT);
+			}
+
+			continue;
+		}
+
+		/* Write whole batch at once, lines that did not make it out are reported as dropped on next batch */
+		op_status = writev(file_fd, file_iov, file_iov_count);
+
+		if (op_status < 0)
+			__atomic_add_fetch(&log_ring->drop_count, line_count, __ATOMIC_RELAXED);
+
+		if (err_iov_count > 0)
+			op_status = writev(KQBASE_STDERR, err_iov, err_iov_count);
+
+		/* Give SLOTs back to producer */
+		__atomic_store_n(&log_ring->head, (head + line_count), __ATOMIC_RELEASE);
+		total_count += line_count;
+
+		goto gather_again;
+	}
+
+	MUTEX_UNLOCK(log_base->mutex, "LOG_BASE");
+	return total_count;
+}
+/**************************************************************************************************************************/
+static EvKQBaseLogAsyncRing *EvKQBaseLogBaseAsyncRingGet(EvKQBaseLogBase *log_base)
+{
+	EvKQBaseLogAsyncRing *log_ring;
+	int orphan_flag;
+	int ring_id;
+	int i;
+
+	/* Fast path, this thread already has a RING */
+	if ((log_ring = pthread_getspecific(log_base->async.ring_key)))
+		return log_ring;
+
+	/* Try to adopt a RING left by a thread that is gone */
+	for (i = 0; i < __atomic_load_n(&log_base->async.ring_count, __ATOMIC_ACQUIRE); i++)
+	{
+		log_ring	= __atomic_load_n(&log_base->async.ring_arr[i], __ATOMIC_ACQUIRE);
+		orphan_flag	= 1;
+
+		if ((log_ring) && (__atomic_compare_exchange_n(&log_ring->orphan, &orphan_flag, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)))
+			goto link;
+
+		continue;
+	}
+
+	/* Claim a new RING slot - CAS keeps RING_COUNT within bounds, so readers never index past RING_ARR */
+	ring_id = __atomic_load_n(&log_base->async.ring_count, __ATOMIC_ACQUIRE);
+
+	do
+	{
+		/* Too many threads, this one will write synchronously */
+		if (ring_id >= KQBASE_LOGGER_ASYNC_RING_MAX)
+			return NULL;
+
+	} while (!__atomic_compare_exchange_n(&log_base->async.ring_count, &ring_id, (ring_id + 1), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	/* Create and publish RING */
+	log_ring = calloc(1, sizeof(EvKQBaseLogAsyncRing));
+
+	if (!log_ring)
+		return NULL;
+
+	__atomic_store_n(&log_base->async.ring_arr[ring_id], log_ring, __ATOMIC_RELEASE);
+
+	/* TAG to link RING to this thread */
+	link:
+
+	pthread_setspecific(log_base->async.ring_key, log_ring);
+	return log_ring;
+}
+/**************************************************************************************************************************/
+static void EvKQBaseLogBaseAsyncRingOrphan(void *ring_ptr)
+{
+	EvKQBaseLogAsyncRing *log_ring = ring_ptr;
+
+	/* Thread is leaving, writer keeps draining and a new thread may adopt this RING */
+	__atomic_store_n(&log_ring->orphan, 1, __ATOMIC_RELEASE);
+	return;
+}
+/**************************************************************************************************************************/
+static void *EvKQBaseLogBaseAsyncWriterLoop(void *log_base_ptr)
+{
+	EvKQBaseLogBase *log_base = log_base_ptr;
+	sigset_t new;
+
+	/* Signals are handled by main thread */
+	sigfillset(&new);
+	pthread_sigmask(SIG_BLOCK, &new, NULL);
+
+	/* Drain RINGs, nap when there is nothing to write */
+	while (!__atomic_load_n(&log_base->async.stop_request, __ATOMIC_ACQUIRE))
+	{
+		if (EvKQBaseLogBaseAsyncDrain(log_base, 0) == 0)
+			usleep(KQBASE_LOGGER_ASYNC_IDLE_USEC);
+
+		continue;
+	}
+
+	/* Flush whatever is left */
+	EvKQBaseLogBaseAsyncDrain(log_base, 0);
+	return NULL;
+}
+/**************************************************************************************************************************/
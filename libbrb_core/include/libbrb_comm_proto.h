@@ -44,6 +44,20 @@
 
 #define COMM_SSL_SNI_MAXSZ								256
 
+/* Client pool health - EWMA weight is 1/8, same gain TCP uses for SRTT */
+#define COMM_POOL_HEALTH_EWMA_SHIFT						3
+#define COMM_POOL_HEALTH_CHECK_MS						1000
+#define COMM_POOL_HEALTH_FAIL_MAX						3
+#define COMM_POOL_HEALTH_EJECT_MIN_MS					1000
+#define COMM_POOL_HEALTH_EJECT_MAX_MS					30000
+#define COMM_POOL_HEALTH_REPLY_TIMEOUT_MS				5000
+#define COMM_POOL_HEALTH_SLOW_FACTOR					4
+#define COMM_POOL_HEALTH_SLOW_MIN_US					1000
+#define COMM_POOL_HEALTH_SLOW_MIN_SAMPLES				8
+#define COMM_POOL_RESIZE_GROW_LOAD						4
+#define COMM_POOL_POWER_OF_TWO_TRIES					4
+#define COMM_POOL_RESIZE_SHRINK_TICKS					10
+
 
 #define COMM_SOCK_ADDR_PTR(ptr)	((struct sockaddr *)(ptr))
 #define COMM_SOCK_ADDR_FAMILY(ptr)	COMM_SOCK_ADDR_PTR(ptr)->sa_family
@@ -315,8 +329,64 @@ typedef struct _CommEvStatistics
 		float user03;
 	} rate;
 
+	/* Kernel TCP_INFO, filled by CommEvTCPInfoSampler while registered on it */
+	struct
+	{
+		DLinkedListNode node;
+		struct _CommEvTCPInfoSampler *sampler;
+		struct sockaddr_storage *peer_addr;
+		char *label_str;
+		int socket_fd;
+		unsigned long sample_ts;
+		unsigned int rtt_us;
+		unsigned int rttvar_us;
+		unsigned int cwnd_bytes;
+		unsigned int retransmits;
+		unsigned int unacked_bytes;
+	} tcp_info;
+
 } CommEvStatistics;
 
+typedef struct _CommEvPoolHealth
+{
+	/* Oldest write still waiting for a reply, and when we were ejected */
+	struct timeval pending_tv;
+	struct timeval ejected_tv;
+
+	unsigned long latency_ewma_us;
+	unsigned long latency_last_us;
+	unsigned long sample_count;
+	unsigned long eject_count;
+
+	int pending_count;
+	int fail_count;
+	int eject_ms;
+
+	struct
+	{
+		unsigned int ejected:1;
+		unsigned int probing:1;
+	} flags;
+
+} CommEvPoolHealth;
+
+typedef int CommEvBackpressureReadCtlCBH(void *, int);
+
+typedef struct _CommEvBackpressure
+{
+	/* Connection feeding our write queue, and how to stop/start reading from us */
+	struct _CommEvBackpressure *peer;
+	CommEvBackpressureReadCtlCBH *read_ctl_cbh;
+	void *owner_ptr;
+
+	struct
+	{
+		unsigned int read_paused:1;
+		unsigned int peer_paused:1;
+	} flags;
+
+} CommEvBackpressure;
+
 typedef struct _CommEvTCPIOData
 {
 	pthread_mutex_t mutex;
@@ -324,6 +394,9 @@ typedef struct _CommEvTCPIOData
 	MemBuffer *read_buffer;
 	MemStream *partial_read_stream;
 	MemBuffer *partial_read_buffer;
+	MemChain *read_chain;
+	MemSlice read_slice;
+	unsigned long sync_scan_off;
 	EvAIOReqQueue write_queue;
 	int ref_count;
 } CommEvTCPIOData;
@@ -339,7 +412,6 @@ typedef struct _CommEvTCPSSLData
 	SSL_CTX *ssl_context;
 	SSL *ssl_handle;
 	X509 *x509_cert;
-	char sni_host_str[COMM_SSL_SNI_MAXSZ];
 	char *sni_host_ptr;
 	int ssl_shutdown_trycount;
 	int ssl_negotiatie_trycount;
@@ -348,6 +420,15 @@ typedef struct _CommEvTCPSSLData
 	int sni_host_tldpos;
 	int x509_forge_reqid;
 	int shutdown_jobid;
+
+	/* Last session negotiated with this peer, offered again on reconnect */
+	SSL_SESSION *ssl_session;
+
+	struct
+	{
+		unsigned long full;
+		unsigned long resumed;
+	} handshake;
 } CommEvTCPSSLData;
 
 
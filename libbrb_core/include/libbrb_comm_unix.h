@@ -77,6 +77,9 @@ typedef enum
 	COMM_UNIX_SELECT_LEAST_LOAD,
 	COMM_UNIX_SELECT_CONNECTED,
 	COMM_UNIX_SELECT_ANY,
+	/* Keep CONNECTED and ANY values stable, they are also passed as select_connected */
+	COMM_UNIX_SELECT_POWER_OF_TWO,
+	COMM_UNIX_SELECT_LEAST_LATENCY,
 	COMM_UNIX_SELECT_LASTITEM
 } CommEvUNIXSelectCode;
 
@@ -509,11 +512,15 @@ typedef struct _CommEvUNIXClient
 typedef struct _CommEvUNIXClientPoolConf
 {
 	int cli_count_init;
+	int cli_count_min;
 	int cli_count_max;
+	int health_check_ms;
 
 	struct
 	{
 		unsigned int no_brb_proto:1;
+		unsigned int eject_slow:1;
+		unsigned int auto_resize:1;
 	} flags;
 
 } CommEvUNIXClientPoolConf;
@@ -536,13 +543,29 @@ typedef struct _CommEvUNIXClientPool
 	{
 		MemSlotBase memslot;
 		int count_init;
+		int count_alloc;
 		int count_online;
 		int rr_current;
 	} client;
 
+	struct
+	{
+		CommEvPoolHealth arr[COMM_UNIX_CLIENT_POOL_MAX];
+		unsigned long latency_ewma_us;
+		int idle_ticks;
+		int timer_id;
+	} health;
+
+	struct
+	{
+		CommEvUNIXGenericCBH *cb_handler_ptr;
+		void *cb_data_ptr;
+	} events[COMM_UNIX_CLIENT_EVENT_LASTITEM];
+
 	struct
 	{
 		unsigned int has_error:1;
+		unsigned int conf_set:1;
 	} flags;
 
 } CommEvUNIXClientPool;
@@ -619,6 +642,10 @@ int CommEvUNIXClientPoolConnect(CommEvUNIXClientPool *unix_clientpool, CommEvUNI
 CommEvUNIXClient *CommEvUNIXClientPoolClientSelect(CommEvUNIXClientPool *unix_clientpool, int select_method, int select_connected);
 CommEvUNIXClient *CommEvUNIXClientPoolClientSelectLeastLoad(CommEvUNIXClientPool *unix_clientpool, int select_connected);
 CommEvUNIXClient *CommEvUNIXClientPoolClientSelectRoundRobin(CommEvUNIXClientPool *unix_clientpool, int select_connected);
+CommEvUNIXClient *CommEvUNIXClientPoolClientSelectPowerOfTwo(CommEvUNIXClientPool *unix_clientpool, int select_connected);
+CommEvUNIXClient *CommEvUNIXClientPoolClientSelectLeastLatency(CommEvUNIXClientPool *unix_clientpool, int select_connected);
+void CommEvUNIXClientPoolClientEventNotify(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClient *ev_unixclient, int ev_type);
+void CommEvUNIXClientPoolClientReplyNotify(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClient *ev_unixclient, int reply_count);
 int CommEvUNIXClientPoolHasConnected(CommEvUNIXClientPool *unix_clientpool);
 int CommEvUNIXClientPoolEventSet(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClientEventCodes ev_type, CommEvUNIXGenericCBH *cb_handler, void *cb_data);
 int CommEvUNIXClientPoolEventCancel(CommEvUNIXClientPool *unix_clientpool, CommEvUNIXClientEventCodes ev_type);
@@ -43,6 +43,24 @@
 #define RESOLVER_DNS_MAX_REPLY_COUNT 32
 #define RESOLVER_DNS_QUERY_SZ 512
 
+/* Upstream servers and source sockets */
+#define RESOLVER_DNS_SERVER_MAX 4
+#define RESOLVER_DNS_SOCKET_MAX 8
+#define RESOLVER_DNS_RTT_INIT_MS 50
+#define RESOLVER_DNS_RTT_SAMPLE_COUNT 64
+#define RESOLVER_DNS_HEDGE_PERCENTILE 90
+#define RESOLVER_DNS_HEDGE_MIN_MS 5
+#define RESOLVER_DNS_FAIL_DECAY_MS 30000
+
+/* Answer cache defaults, used when EvDNSResolverConf leaves them zeroed */
+#define RESOLVER_DNS_CACHE_MAX_ENTRIES 4096
+#define RESOLVER_DNS_CACHE_TTL_MIN 5
+#define RESOLVER_DNS_CACHE_TTL_MAX 3600
+#define RESOLVER_DNS_CACHE_NEGATIVE_TTL 30
+#define RESOLVER_DNS_CACHE_STALE_SEC 30
+#define RESOLVER_DNS_CACHE_DISPATCH_MS 1
+#define RESOLVER_DNS_CACHE_KEY_SZ (RFC1035_MAXHOSTNAMESZ + 16)
+
 /* rfc1035 - DNS */
 #define RFC1035_MAXHOSTNAMESZ 256
 #define RFC1035_MAXLABELSZ 63
@@ -69,6 +87,7 @@
 #define RFC1035_TYPE_SRV    33   // Service Locator
 
 #define RFC1035_CLASS_IN 1
+#define RFC1035_RCODE_NXDOMAIN 3
 /*******************************************************/
 typedef void CommEvDNSResolverCBH(void *, void *, void *, int);
 /*******************************************************/
@@ -84,6 +103,7 @@ typedef struct _DNSPendingQuery
 {
 	DLinkedListNode node;
 	int req_count;
+	int hedge_count;
 	int fail_count;
 	int slot_id;
 
@@ -93,6 +113,16 @@ typedef struct _DNSPendingQuery
 	char rfc1035_request[RESOLVER_DNS_QUERY_SZ];
 	unsigned long rfc1035_request_sz;
 
+	struct _DNSCacheEntry *cache_entry;
+
+	struct
+	{
+		struct timeval sent_tv[RESOLVER_DNS_SERVER_MAX];
+		unsigned int sent_mask;
+		int target_idx;
+		int socket_fd;
+	} upstream;
+
 	struct
 	{
 		CommEvDNSResolverCBH *cb_handler;
@@ -105,6 +135,11 @@ typedef struct _DNSPendingQuery
 		unsigned int re_xmit:1;
 		unsigned int waiting_reply:1;
 		unsigned int canceled_req:1;
+		unsigned int cache_hit:1;
+		unsigned int coalesced:1;
+		unsigned int dispatching:1;
+		unsigned int hedged:1;
+		unsigned int hedge_xmit:1;
 	} flags;
 } DNSPendingQuery;
 /*******************************************************/
@@ -129,6 +164,40 @@ typedef struct _DNSAReply
 
 } DNSAReply;
 /*******************************************************/
+typedef struct _DNSCacheEntry
+{
+	DLinkedListNode node;
+	DLinkedList waiter_list;
+	DNSAReply a_reply;
+	char key_str[RESOLVER_DNS_CACHE_KEY_SZ];
+	long expire_ts;
+	long stale_ts;
+	int inflight_id;
+	int ref_count;
+
+	struct
+	{
+		unsigned int valid:1;
+		unsigned int negative:1;
+	} flags;
+} DNSCacheEntry;
+/*******************************************************/
+typedef struct _DNSUpstreamServer
+{
+	struct sockaddr_in addr;
+	int srtt_ms;
+	int rttvar_ms;
+	int fail_count;
+	struct timeval fail_tv;
+
+	struct
+	{
+		long request_sent;
+		long request_timeout;
+		long reply_received;
+	} stats;
+} DNSUpstreamServer;
+/*******************************************************/
 typedef struct _EvDNSResolverConf
 {
 	char *dns_ip_str;
@@ -136,6 +205,24 @@ typedef struct _EvDNSResolverConf
 	int lookup_timeout_ms;
 	int retry_timeout_ms;
 	int retry_count;
+	int socket_count;
+	int hedge_ms;
+
+	struct
+	{
+		int max_entries;
+		int ttl_min;
+		int ttl_max;
+		int negative_ttl;
+		int stale_sec;
+	} cache;
+
+	struct
+	{
+		unsigned int cache_disabled:1;
+		unsigned int hedge_disabled:1;
+		unsigned int parallel_query:1;
+	} flags;
 } EvDNSResolverConf;
 /*******************************************************/
 typedef struct _EvDNSResolverBase
@@ -161,6 +248,41 @@ typedef struct _EvDNSResolverBase
 		DLinkedList reply_list;
 	} pending_req;
 
+	struct
+	{
+		AssocArray *table;
+		DLinkedList lru_list;
+		DLinkedList hit_list;
+		int dispatch_timer_id;
+		int max_entries;
+		int ttl_min;
+		int ttl_max;
+		int negative_ttl;
+		int stale_sec;
+	} cache;
+
+	struct
+	{
+		DNSUpstreamServer arr[RESOLVER_DNS_SERVER_MAX];
+		int count;
+	} server;
+
+	struct
+	{
+		int fd_arr[RESOLVER_DNS_SOCKET_MAX];
+		int count;
+	} socket;
+
+	struct
+	{
+		int sample_arr[RESOLVER_DNS_RTT_SAMPLE_COUNT];
+		int sample_idx;
+		int sample_count;
+		int fixed_ms;
+		int delay_ms;
+		int timer_id;
+	} hedge;
+
 	struct
 	{
 		long request_sent_sched;
@@ -170,11 +292,28 @@ typedef struct _EvDNSResolverBase
 
 		long reply_received_total;
 		long reply_received_valid;
+		long reply_unmatched;
+		long request_hedged;
 
 		long total_bytes_sent;
 		long total_bytes_received;
+
+		long cache_hit;
+		long cache_hit_stale;
+		long cache_hit_negative;
+		long cache_miss;
+		long cache_coalesced;
+		long cache_refresh;
+		long cache_evicted;
 	} stats;
 
+	struct
+	{
+		unsigned int cache_enabled:1;
+		unsigned int hedge_enabled:1;
+		unsigned int parallel_query:1;
+	} flags;
+
 } EvDNSResolverBase;
 /*******************************************************/
 typedef struct _EvDNSReplyHandler
@@ -440,6 +579,7 @@ int CommEvDNSGetHostByNameX(EvDNSResolverBase *resolv_base, char *host, CommEvDN
 int CommEvDNSCheckIfNeedDNSLookup(char *host_ptr);
 int CommEvDNSCancelPendingRequest(EvDNSResolverBase *resolv_base, int req_id);
 int CommEvDNSDataCancelAndClean(EvDNSReplyHandler *dnsdata);
+int CommEvDNSCacheFlush(EvDNSResolverBase *resolv_base);
 
 /******************************************************************************************************/
 /* comm/core/icmp/comm_icmp_base.c */
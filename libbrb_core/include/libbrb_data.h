@@ -295,6 +295,19 @@ typedef void BrbDataDestroyCB(void *);
 #define METADATA_UNIT_SEPARATOR_SZ			1
 
 #define METADATA_ITEM_RAW_SZ				(sizeof(long) * 3)
+
+/* V1 is the legacy stream of ITEM + DATA + CANARY, V2 is indexed and readable in place */
+#define METADATA_VERSION_V1					0
+#define METADATA_VERSION_V2					1
+#define METADATA_V2_ALIGN					8
+#define METADATA_V2_BUCKET_EMPTY			0
+/************************************************************/
+typedef enum
+{
+	METADATA_CHECKSUM_MD5,
+	METADATA_CHECKSUM_CRC32C,
+	METADATA_CHECKSUM_LASTITEM
+} MetaDataChecksumType;
 /************************************************************/
 typedef enum
 {
@@ -305,6 +318,8 @@ typedef enum
 	METADATA_UNPACK_FAILED_DIGEST_INVALID,
 	METADATA_UNPACK_FAILED_NEED_MORE_DATA_METAITEM,
 	METADATA_UNPACK_FAILED_NEED_MORE_DATA_OBJECT,
+	METADATA_UNPACK_FAILED_INVALID_VERSION,
+	METADATA_UNPACK_FAILED_CORRUPTED_INDEX,
 	METADATA_UNPACK_SUCCESS,
 	METADATA_UNPACK_LASTITEM
 } MetaDataUnpackReturnCode;
@@ -326,9 +341,37 @@ typedef struct _MetaDataHeader
 	unsigned long size;
 	char str[8];
 	char digest[16];
-	char reserved[24];
+	unsigned int checksum_type;
+	unsigned int bucket_count;
+	char reserved[16];
 } MetaDataHeader;
 /************************************************************/
+/* WARNING - V2 index entry, read in place from mapped files. OFFSET is counted from the start of META_HEADER */
+typedef struct _MetaDataIndexItem
+{
+	unsigned long item_id;
+	unsigned long item_sub_id;
+	unsigned long offset;
+	unsigned long sz;
+} MetaDataIndexItem;
+/************************************************************/
+typedef struct _MetaDataView
+{
+	MetaDataHeader *header;
+	MetaDataIndexItem *index_arr;
+	unsigned int *bucket_arr;
+	char *base_ptr;
+	unsigned long base_sz;
+	int item_count;
+	int mmap_fd;
+
+	struct
+	{
+		unsigned int mapped:1;
+	} flags;
+
+} MetaDataView;
+/************************************************************/
 typedef struct _MetaDataUnpackerInfo
 {
 	int error_code;
@@ -346,6 +389,7 @@ typedef struct _MetaDataUnpackerInfo
 typedef struct _MetaData
 {
 	struct _MemBuffer *raw_data;
+	MetaDataView view;
 	int item_offset;
 
 	struct
@@ -367,10 +411,21 @@ int MetaDataDestroy(MetaData *meta_data);
 int MetaDataReset(MetaData *meta_data);
 int MetaDataClean(MetaData *meta_data);
 int MetaDataPack(MetaData *meta_data, struct _MemBuffer *meta_data_mb);
+int MetaDataPackV2(MetaData *meta_data, struct _MemBuffer *meta_data_mb, MetaDataChecksumType checksum_type);
 int MetaDataUnpack(MetaData *meta_data, struct _MemBuffer *meta_data_mb, MetaDataUnpackerInfo *unpacker_info);
 int MetaDataItemAdd(MetaData *meta_data, unsigned long item_id, unsigned long item_sub_id, void *data_ptr, unsigned long data_sz);
 MetaDataItem *MetaDataItemGrabMetaByID(MetaData *meta_data, unsigned long item_id, unsigned long item_sub_id);
 void *MetaDataItemFindByID(MetaData *meta_data, unsigned long item_id, unsigned long item_sub_id);
+
+int MetaDataViewOpen(MetaDataView *meta_view, void *data_ptr, unsigned long data_sz, int verify);
+int MetaDataViewOpenFile(MetaDataView *meta_view, char *file_path, int verify);
+int MetaDataViewClose(MetaDataView *meta_view);
+int MetaDataViewGetCount(MetaDataView *meta_view);
+long MetaDataViewFindIdx(MetaDataView *meta_view, unsigned long item_id, unsigned long item_sub_id);
+MetaDataIndexItem *MetaDataViewGrabByIdx(MetaDataView *meta_view, int item_idx);
+MetaDataIndexItem *MetaDataViewGrabByID(MetaDataView *meta_view, unsigned long item_id, unsigned long item_sub_id);
+void *MetaDataViewFindByID(MetaDataView *meta_view, unsigned long item_id, unsigned long item_sub_id, unsigned long *ret_sz);
+void *MetaDataViewItemDeref(MetaDataView *meta_view, MetaDataIndexItem *index_item);
 /**********************************************************************************************************************/
 /* DYNAMIC ARRAY STRUCTURES AND PROTOTYPES */
 /**********************************************************************************************************************/
@@ -531,6 +586,18 @@ void DLinkedListSortMerge(DLinkedList *list, DLinkedListCompareFunc *cmp_func, D
 /* MemBuffer STRUCTURES AND PROTOTYPES */
 /**********************************************************************************************************************/
 #define MEMBUFFER_MAX_PRINTF 65535
+#define MEMBUFFER_GROW_GEOMETRIC_STEP_MAX	(8 * 1024 * 1024)	/* Geometric policy never grows more than this at once */
+#define MEMBUFFER_SLAB_CLASS_MIN			64					/* Smallest slab size class, classes double up to MAX */
+#define MEMBUFFER_SLAB_CLASS_MAX			4096				/* Buffers bigger than this go straight to HEAP */
+#define MEMBUFFER_SLAB_CLASS_COUNT			7					/* 64, 128, 256, 512, 1024, 2048, 4096 */
+#define MEMBUFFER_SLAB_CACHE_MAX			128					/* Free blocks each thread keeps per size class */
+/************************************************************/
+typedef enum
+{
+	MEMBUFFER_GROW_GEOMETRIC,
+	MEMBUFFER_GROW_LINEAR,
+	MEMBUFFER_GROW_LASTITEM
+} MemBufferGrowPolicy;
 /************************************************************/
 typedef struct _MemBufferMetaData
 {
@@ -552,6 +619,7 @@ typedef struct _MemBuffer
 
 	unsigned int mb_type;
 	unsigned int grow_rate;
+	unsigned int grow_policy;
 	unsigned int busy_flags;
 	unsigned int data_type;
 	unsigned int data_state;
@@ -575,6 +643,7 @@ typedef struct _MemBuffer
 		unsigned int mmaped:1;
 		unsigned int wired:1;
 		unsigned int no_core:1;
+		unsigned int slab:1;
 	} flags;
 } MemBuffer;
 /************************************************************/
@@ -603,6 +672,8 @@ MemBuffer *MemBufferNew(LibDataThreadSafeType mb_type, int grow_rate);
 int MemBufferDestroy(MemBuffer *mb_ptr);
 int MemBufferClean(MemBuffer *mb_ptr);
 int MemBufferShrink(MemBuffer *mb_ptr);
+int MemBufferShrinkToFit(MemBuffer *mb_ptr);
+int MemBufferGrowPolicySet(MemBuffer *mb_ptr, MemBufferGrowPolicy grow_policy);
 int MemBufferLock(MemBuffer *mb_ptr);
 int MemBufferUnlock(MemBuffer *mb_ptr);
 unsigned long MemBufferGetSize(MemBuffer *mb_ptr);
@@ -815,6 +886,108 @@ SpeedRegEx *SpeedRegExNew(SpeedRegexType type);
 void SpeedRegExDestroy (SpeedRegEx *speedreg);
 SpeedRegEx *SpeedRegExCompile(char *speed_regex, int order_match, int type);
 int SpeedRegExExecute (SpeedRegEx *speedreg, char *data);
+/************************************************************/
+#define SPDREGEX_SET_MAGIC				0x53525853
+#define SPDREGEX_SET_VERSION			1
+#define SPDREGEX_SET_ANCHOR_BEGIN		0x01
+#define SPDREGEX_SET_ANCHOR_FINISH		0x02
+/************************************************************/
+typedef struct _SpeedRegExSetPattern
+{
+	int pattern_id;
+	int frag_count;
+	int anchor_flags;
+} SpeedRegExSetPattern;
+/************************************************************/
+typedef struct _SpeedRegExSetRef
+{
+	int node_id;
+	int pattern_idx;
+	int frag_idx;
+} SpeedRegExSetRef;
+/************************************************************/
+typedef struct _SpeedRegExSetTrieNode
+{
+	int first_child;
+	int next_sibling;
+	int label;
+} SpeedRegExSetTrieNode;
+/************************************************************/
+typedef struct _SpeedRegExSetHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int pattern_count;
+	unsigned int node_count;
+	unsigned int ref_count;
+	unsigned int always_count;
+} SpeedRegExSetHeader;
+/************************************************************/
+typedef struct _SpeedRegExSet
+{
+	pthread_mutex_t mutex;
+	SpeedRegexType spdreg_type;
+
+	struct
+	{
+		SpeedRegExSetPattern *arr;
+		int count;
+		int capacity;
+	} pattern;
+
+	/* Build time trie, children kept sorted by label on sibling lists */
+	struct
+	{
+		SpeedRegExSetTrieNode *node_arr;
+		SpeedRegExSetRef *ref_arr;
+		int node_count;
+		int node_capacity;
+		int ref_count;
+		int ref_capacity;
+	} build;
+
+	/* Flat Aho-Corasick automaton, one state per trie node, state 0 is root */
+	struct
+	{
+		int root_next[256];
+		int *edge_off;
+		unsigned char *edge_label;
+		int *edge_target;
+		int *fail;
+		int *dict;
+		int *depth;
+		int *ref_off;
+		SpeedRegExSetRef *ref_arr;
+		int *always_arr;
+		int node_count;
+		int ref_count;
+		int always_count;
+	} automaton;
+
+	/* Per pattern progress, generation stamped so execute never walks all patterns */
+	struct
+	{
+		unsigned int *gen_arr;
+		int *next_arr;
+		int *min_start_arr;
+		unsigned int gen;
+	} scratch;
+
+	struct
+	{
+		unsigned int compiled:1;
+		unsigned int loaded:1;
+	} flags;
+} SpeedRegExSet;
+/************************************************************/
+SpeedRegExSet *SpeedRegExSetNew(SpeedRegexType type);
+void SpeedRegExSetDestroy(SpeedRegExSet *spdreg_set);
+int SpeedRegExSetAdd(SpeedRegExSet *spdreg_set, char *speed_regex, int pattern_id);
+int SpeedRegExSetCompile(SpeedRegExSet *spdreg_set);
+int SpeedRegExSetExecute(SpeedRegExSet *spdreg_set, char *data, int data_sz, int *match_arr, int match_max);
+int SpeedRegExSetGetCount(SpeedRegExSet *spdreg_set);
+int SpeedRegExSetSerialize(SpeedRegExSet *spdreg_set, MemBuffer *dump_mb);
+SpeedRegExSet *SpeedRegExSetLoad(char *data, unsigned long data_sz, SpeedRegexType type);
 /**********************************************************************************************************************/
 /**/
 /**/
@@ -871,6 +1044,14 @@ void BRB_MD5ToStr(unsigned char *bin_digest,  unsigned char *ret_buf_str);
 //
 //
 /**********************************************************************************************************************/
+/* CRC32C PROTOTYPES */
+/**********************************************************************************************************************/
+uint32_t BRB_CRC32C(const void *buf, unsigned long len);
+uint32_t BRB_CRC32CUpdate(uint32_t crc, const void *buf, unsigned long len);
+/**********************************************************************************************************************/
+//
+//
+/**********************************************************************************************************************/
 /* BLOWFISH STRUCTURES AND PROTOTYPES */
 /**********************************************************************************************************************/
 typedef struct _BRB_BLOWFISH_CTX {
@@ -902,6 +1083,16 @@ void BRB_RC4_Crypt(BRB_RC4_State *state, const unsigned char *inbuf, unsigned ch
 /* HashTable V2 STRUCTURES AND PROTOTYPES */
 /**********************************************************************************************************************/
 #define HASHTABLE_V2_MAXKEY_SZ 32
+
+/* SWISS mode - Open addressing on groups of 16 control TAGs */
+#define HASHTABLE_V2_SWISS_GROUP_SZ			16
+#define HASHTABLE_V2_SWISS_GROUPS_MIN		8
+#define HASHTABLE_V2_SWISS_MIGRATE_GROUPS	2
+#define HASHTABLE_V2_SWISS_CTRL_EMPTY		-128
+#define HASHTABLE_V2_SWISS_CTRL_DELETED		-2
+#define HASHTABLE_V2_SHARD_DEFAULT			16
+#define HASHTABLE_V2_SHARD_MAX				256
+
 typedef unsigned int HashTableV2HashFunc(char *, int, int, int);   // key, key_sz, key_seed, max_hash_s
 typedef unsigned int HashTableV2KeyCmpFunc(void *, char *, int); // hash_item, key, key_sz
 /************************************************************/
@@ -913,10 +1104,37 @@ typedef enum
 	HASHTABLE_HASHFUNC_LASTITEM
 } HashTableConfigHashFunc;
 /************************************************************/
+typedef enum
+{
+	HASHTABLE_MODE_CHAINED,
+	HASHTABLE_MODE_SWISS,
+	HASHTABLE_MODE_LASTITEM
+} HashTableV2Mode;
+/************************************************************/
+typedef struct _HashTableV2SwissTable
+{
+	signed char *ctrl_arr;
+	struct _HashTableV2Item **slot_arr;
+	unsigned int group_mask;
+	unsigned int item_count;
+	unsigned int growth_left;
+} HashTableV2SwissTable;
+/************************************************************/
+typedef struct _HashTableV2Shard
+{
+	/* While growing, items still on OLD are moved into CUR a few groups at a time */
+	HashTableV2SwissTable cur;
+	HashTableV2SwissTable old;
+	unsigned int migrate_group;
+	pthread_mutex_t mutex;
+} HashTableV2Shard;
+/************************************************************/
 typedef struct _HashTableConfig
 {
 	int hashfunc_code;
 	int max_buckets;
+	int table_mode;
+	int shard_count;
 
 	struct
 	{
@@ -953,8 +1171,19 @@ typedef struct _HashTableV2
 	struct
 	{
 		int max_buckets;
+		int table_mode;
 	} config;
 
+	struct
+	{
+		HashTableV2Shard *shard_arr;
+		unsigned int shard_count;
+		unsigned int shard_bits;
+	} swiss;
+
+	/* CHAINED mode item count, SWISS mode counts per shard */
+	unsigned long item_count;
+
 	struct
 	{
 		/* Match key size before comparing key */
@@ -985,12 +1214,19 @@ typedef struct _HashTableV2Item
 	DLinkedListNode node;
 	struct _HashTableBucket *bucket;
 	void *data_ptr;
+	unsigned int hash_val;
+
 	struct
 	{
 		char *ptr;
 		int sz;
 	} key;
 
+	struct
+	{
+		unsigned int active:1;
+	} flags;
+
 } HashTableV2Item;
 /************************************************************/
 HashTableV2 *HashTableV2New(HashTableConfig *config);
@@ -998,6 +1234,7 @@ int HashTableV2Destroy(HashTableV2 *hash_table);
 int HashTableV2ItemAdd(HashTableV2 *hash_table, HashTableV2Item *hash_item, void *data_ptr, char *key_ptr, int key_sz);
 int HashTableV2ItemDel(HashTableV2 *hash_table, HashTableV2Item *hash_item);
 HashTableV2Item *HashTableV2ItemFind(HashTableV2 *hash_table, char *key_ptr, int key_sz);
+unsigned long HashTableV2ItemCount(HashTableV2 *hash_table);
 
 /**********************************************************************************************************************/
 /* HashTable STRUCTURES AND PROTOTYPES */
@@ -1431,14 +1668,112 @@ void MemStreamBaseDeref(MemStream *mem_stream, MemStreamRef *mem_stream_ref);
 unsigned long MemStreamGetDataSize(MemStream *mem_stream);
 unsigned long MemStreamGetNodeCount(MemStream *mem_stream);
 /**********************************************************************************************************************/
+/* MEM FREE CACHE - Per-thread free lists of fixed size blocks, one list per size class, shared by pooled allocators */
+/************************************************************/
+#define MEMFREECACHE_CLASS_MAX			8			/* Size classes a single cache can hold */
+/************************************************************/
+typedef struct _MemFreeCacheThread
+{
+	void *free_head[MEMFREECACHE_CLASS_MAX];
+	int free_count[MEMFREECACHE_CLASS_MAX];
+} MemFreeCacheThread;
+/************************************************************/
+typedef struct _MemFreeCache
+{
+	pthread_mutex_t key_mutex;
+	pthread_key_t key;
+	int key_ready;
+	int class_count;
+	int cache_max;
+} MemFreeCache;
+/************************************************************/
+#define MEMFREECACHE_INITIALIZER(class_count, cache_max)	{ PTHREAD_MUTEX_INITIALIZER, 0, 0, (class_count), (cache_max) }
+/************************************************************/
+void *MemFreeCachePop(MemFreeCache *free_cache, int class_id);
+void MemFreeCachePush(MemFreeCache *free_cache, int class_id, void *block_ptr);
+/**********************************************************************************************************************/
+/* MEM CHAIN - Chained receive buffer made of pooled, refcounted fixed size chunks */
+/************************************************************/
+#define MEMCHAIN_CHUNK_SZ				16384		/* Payload bytes of each pooled chunk */
+#define MEMCHAIN_CHUNK_CACHE_MAX		256			/* Free chunks each thread keeps before going back to HEAP */
+#define MEMCHAIN_READ_IOVEC_MAX			4			/* Chunks a single read from FD can span */
+/************************************************************/
+typedef struct _MemChunk
+{
+	struct _MemChunk *next;
+	unsigned long size;
+	int ref_count;
+
+	char data[MEMCHAIN_CHUNK_SZ];
+} MemChunk;
+/************************************************************/
+typedef struct _MemSlice
+{
+	MemChunk *chunk;
+	char *data;
+	unsigned long size;
+
+	struct
+	{
+		unsigned int heap:1;
+	} flags;
+} MemSlice;
+/************************************************************/
+typedef struct _MemChain
+{
+	MemChunk *head;
+	MemChunk *tail;
+
+	unsigned long head_off;
+	unsigned long size;
+	int chunk_count;
+} MemChain;
+/************************************************************/
+MemChunk *MemChunkNew(void);
+void MemChunkRetain(MemChunk *chunk);
+void MemChunkRelease(MemChunk *chunk);
+
+MemChain *MemChainNew(void);
+void MemChainDestroy(MemChain *mem_chain);
+void MemChainClean(MemChain *mem_chain);
+unsigned long MemChainGetSize(MemChain *mem_chain);
+long MemChainAppendFromFD(MemChain *mem_chain, unsigned long data_sz, int fd, int flags);
+unsigned long MemChainAdd(MemChain *mem_chain, const void *new_data, unsigned long new_data_sz);
+char *MemChainWriteReserve(MemChain *mem_chain, unsigned long *ret_space_sz);
+void MemChainWriteCommit(MemChain *mem_chain, unsigned long data_sz);
+char *MemChainOffsetDeref(MemChain *mem_chain, unsigned long offset, unsigned long *ret_contig_sz);
+long MemChainFind(MemChain *mem_chain, unsigned long offset, const char *token_str, int token_sz);
+unsigned long MemChainPeek(MemChain *mem_chain, unsigned long offset, void *ret_buf, unsigned long data_sz);
+unsigned long MemChainDrain(MemChain *mem_chain, unsigned long data_sz);
+void MemChainTruncate(MemChain *mem_chain, unsigned long new_sz);
+int MemChainSlicePop(MemChain *mem_chain, unsigned long slice_sz, MemSlice *ret_slice);
+void MemSliceDup(MemSlice *src_slice, MemSlice *dst_slice);
+void MemSliceRelease(MemSlice *mem_slice);
+/**********************************************************************************************************************/
 /* MEM ARENA */
 /************************************************************/
 typedef enum
 {
 	MEMARENA_MT_UNSAFE,
-	MEMARENA_MT_SAFE
+	MEMARENA_MT_SAFE,
+	MEMARENA_MT_CONCURRENT
 } MemArenaTypes;
 /************************************************************/
+#define MEMARENA_DIR_CHUNK_SZ		1024
+#define MEMARENA_DIR_CHUNK_MAX		4096
+#define MEMARENA_MAGAZINE_MAX		64
+#define MEMARENA_ID_BATCH_SZ		32
+/************************************************************/
+typedef struct _MemArenaMagazine
+{
+	long local_head;
+	long remote_head;
+	long fresh_next;
+	long fresh_last;
+	int in_use;
+	char pad[64 - (4 * sizeof(long)) - sizeof(int)];
+} MemArenaMagazine;
+/************************************************************/
 typedef enum
 {
 	MEMARENA_SIZE_CURRENT,
@@ -1462,9 +1797,18 @@ typedef struct _MemArena
 	long slot[MEMARENA_SLOT_LASTITEM];
 	char **data;
 
+	/* Concurrent mode, chunked page directory never moves published pages */
+	struct
+	{
+		char ***dir;
+		MemArenaMagazine *magazine_arr;
+		long id_next;
+	} concurrent;
+
 	struct
 	{
 		unsigned int thread_safe:1;
+		unsigned int concurrent:1;
 	} flags;
 } MemArena;
 /************************************************************/
@@ -1476,6 +1820,9 @@ typedef struct _MemArenaSlotHeader
 	MemArena *mem_arena;
 	long slot_id;
 	long busy_count;
+	unsigned long *busy_bits;
+	long *free_link;
+	int *free_owner;
 	short canary01;
 } MemArenaSlotHeader;
 /************************************************************/
@@ -1485,13 +1832,17 @@ void MemArenaDestroy(MemArena *mem_arena);
 void *MemArenaFindByID(MemArena *mem_arena, long id);
 void *MemArenaGrabByID(MemArena *mem_arena, int long);
 void MemArenaReleaseByID(MemArena *mem_arena, long id);
-void MemArenaLockByID(MemArena *mem_arena, long id);
+int MemArenaLockByID(MemArena *mem_arena, long id);
 int MemArenaToJsonMemBuffer(MemArena *mem_arena, MemBuffer *json_reply_mb);
 int MemArenaUnlockByID(MemArena *mem_arena, long id);
 long MemArenaGetArenaCapacity(MemArena *mem_arena);
 long MemArenaGetSlotSize(MemArena *mem_arena);
 long MemArenaGetSlotCount(MemArena *mem_arena);
 long MemArenaGetSlotActiveCount(MemArena *mem_arena);
+int MemArenaMagazineRegister(MemArena *mem_arena);
+void MemArenaMagazineUnregister(MemArena *mem_arena, int magazine_id);
+void *MemArenaSlotGrab(MemArena *mem_arena, int magazine_id, long *ret_id);
+void MemArenaSlotRelease(MemArena *mem_arena, int magazine_id, long id);
 /**********************************************************************************************************************/
 /* QUEUE */
 /************************************************************/
@@ -1650,6 +2001,67 @@ RadixPrefix *RadixPrefixFromBlob(unsigned char *blob, int len, int prefixlen);
 const char *RadixPrefixAddrNtop(RadixPrefix *prefix, char *buf, size_t len);
 const char *RadixPrefixNtop(RadixPrefix *prefix, char *buf, size_t len);
 /**********************************************************************************************************************/
+/* RADIX LPM - compiled longest prefix match snapshot of a RadixTree */
+/************************************************************/
+#define RADIX_LPM_ENTRY_EXT			0x80000000U
+#define RADIX_LPM_ENTRY_MASK		0x7FFFFFFFU
+#define RADIX_LPM_TBL24_SZ			(1 << 24)
+#define RADIX_LPM_V6_ROOT_SZ		(1 << 16)
+#define RADIX_LPM_GROUP_SZ			256
+#define RADIX_LPM_READER_MAX		64
+#define RADIX_LPM_BATCH_PREFETCH	16
+/************************************************************/
+typedef struct _RadixLPMSnapshot
+{
+	/* DIR-24-8, entry is result index or tbl8 group index when EXT is set */
+	unsigned int *tbl24;
+	unsigned int *tbl8;
+	int tbl8_group_count;
+	int tbl8_group_capacity;
+
+	/* IPv6 multibit trie, 16 bit root then 8 bit strides, leaf pushed */
+	unsigned int *v6_root;
+	unsigned int *v6_node;
+	int v6_node_count;
+	int v6_node_capacity;
+
+	/* Result index to RadixNode data, slot 0 means no match */
+	void **data_arr;
+	int data_count;
+
+	unsigned long retire_epoch;
+	struct _RadixLPMSnapshot *retire_next;
+} RadixLPMSnapshot;
+/************************************************************/
+typedef struct _RadixLPMReader
+{
+	unsigned long epoch;
+	int in_use;
+	char pad[64 - sizeof(unsigned long) - sizeof(int)];
+} RadixLPMReader;
+/************************************************************/
+typedef struct _RadixLPM
+{
+	RadixLPMReader reader_arr[RADIX_LPM_READER_MAX];
+	pthread_mutex_t mutex;
+	RadixTree *radix;
+	RadixLPMSnapshot *current;
+	RadixLPMSnapshot *retire_list;
+	unsigned long epoch;
+} RadixLPM;
+/************************************************************/
+RadixLPM *RadixLPMNew(RadixTree *radix);
+void RadixLPMDestroy(RadixLPM *lpm);
+int RadixLPMPublish(RadixLPM *lpm);
+int RadixLPMReclaim(RadixLPM *lpm);
+int RadixLPMReaderRegister(RadixLPM *lpm);
+void RadixLPMReaderUnregister(RadixLPM *lpm, int reader_id);
+void RadixLPMReaderQuiescent(RadixLPM *lpm, int reader_id);
+void *RadixLPMLookupV4(RadixLPM *lpm, struct in_addr *addr);
+void *RadixLPMLookupV6(RadixLPM *lpm, struct in6_addr *addr);
+int RadixLPMLookupV4Batch(RadixLPM *lpm, struct in_addr *addr_arr, void **data_arr, int addr_count);
+int RadixLPMLookupV6Batch(RadixLPM *lpm, struct in6_addr *addr_arr, void **data_arr, int addr_count);
+/**********************************************************************************************************************/
 /* SLOT QUEUE  */
 /************************************************************/
 typedef struct _SlotQueue
@@ -1895,6 +2307,13 @@ long DynBitMapGetHigherSeen(DynBitMap *dyn_bitmap);
 int DynBitMapCheckMultiBlocks(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish);
 int DynBitMapGetValidBlocks(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish, DynBitMapValidBlockIdx *valid_block_idx);
 int DynBitMapGenerateStringMap(DynBitMap *dyn_bitmap, char *ret_mask, int ret_mask_size);
+long DynBitMapBitSetRange(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish);
+long DynBitMapBitClearRange(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish);
+long DynBitMapFindNextSet(DynBitMap *dyn_bitmap, long index);
+long DynBitMapFindNextClear(DynBitMap *dyn_bitmap, long index);
+long DynBitMapPopCount(DynBitMap *dyn_bitmap);
+long DynBitMapPopCountRange(DynBitMap *dyn_bitmap, long block_idx_begin, long block_idx_finish);
+int DynBitMapRunNext(DynBitMap *dyn_bitmap, long index, DynBitMapValidBlockIdx *run_idx);
 /************************************************************/
 int DynBitMapMetaDataPack(DynBitMap *dyn_bitmap, MetaData *dst_metadata, long item_sub_id);
 int DynBitMapMetaDataUnPack(DynBitMap *dyn_bitmap, MemBuffer *raw_metadata_mb);
@@ -2029,6 +2448,8 @@ int brb_sendfromto(int fd, void *buf, size_t len, int flags, struct sockaddr *fr
 int BrbStrToLower(char *str_ptr);
 int BrbStrCompare(char *strcur, char *strcmp);
 int BrbStrFindSubStrReverse(char *buffer_str, int buffer_sz, char *substring_str, int substring_sz);
+long BrbMemFind(const char *buffer_ptr, long buffer_sz, const char *token_str, int token_sz);
+long BrbMemFindLast(const char *buffer_ptr, long buffer_sz, const char *token_str, int token_sz);
 /************************************************************/
 char *BrbStrGetKeyByValue(BrbKeyValue val_key[], int code);
 int BrbStrGetValueByKey(BrbKeyValue val_key[], char *name_ptr);
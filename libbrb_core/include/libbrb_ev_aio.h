@@ -44,6 +44,13 @@
 #define AIOREQ_QUEUE_MUTEX_TRYLOCK(aioreq_queue, state)		if (aioreq_queue->flags.mt_engine) 	MUTEX_TRYLOCK (aioreq_queue->mutex, "AIOREQ_QUEUE_MUTEX", state)
 #define AIOREQ_QUEUE_MUTEX_UNLOCK(aioreq_queue) 			if (aioreq_queue->flags.mt_engine) MUTEX_UNLOCK (aioreq_queue->mutex, "AIOREQ_QUEUE_MUTEX")
 
+/* Maximum number of queued AIO_REQs gathered into a single WRITEV */
+#ifdef IOV_MAX
+#define AIOREQ_QUEUE_WRITEV_MAX_IOV							IOV_MAX
+#else
+#define AIOREQ_QUEUE_WRITEV_MAX_IOV							1024
+#endif
+
 typedef enum
 {
 	AIOREQ_QUEUE_MT_UNSAFE,
@@ -57,6 +64,21 @@ typedef enum
 	AIOREQ_QUEUE_LASTITEM
 } EvAIOReqQueueType;
 
+typedef enum
+{
+	AIOREQ_QUEUE_WATERMARK_HIGH,
+	AIOREQ_QUEUE_WATERMARK_LOW,
+	AIOREQ_QUEUE_WATERMARK_SHED,
+	AIOREQ_QUEUE_WATERMARK_LASTITEM
+} EvAIOReqQueueWatermarkCode;
+
+typedef enum
+{
+	AIOREQ_ACCOUNT_SHED_REFUSE,
+	AIOREQ_ACCOUNT_SHED_LARGEST,
+	AIOREQ_ACCOUNT_SHED_LASTITEM
+} EvAIOReqQueueAccountShedPolicy;
+
 typedef enum
 {
 	AIOREQ_UNKNWON,
@@ -105,6 +127,8 @@ typedef enum
 
 typedef void EvAIOReqCBH(int, int, int, void*, void*);
 typedef void EvAIOReqDestroyFunc(void*);
+struct _EvAIOReqQueue;
+typedef void EvAIOReqQueueWatermarkCBH(struct _EvAIOReqQueue *, int, void*);
 
 static char *glob_aioreqcode_str[] = {
 		"AIOREQ_OPCODE_NONE",
@@ -222,6 +246,23 @@ typedef struct _EvAIOReq
 
 } EvAIOReq;
 /*****************************************************/
+typedef struct _EvAIOReqQueueAccount
+{
+	DLinkedList queue_list;
+	pthread_mutex_t mutex;
+	unsigned long max_sz;
+	int shed_policy;
+
+	struct
+	{
+		unsigned long queue_sz;
+		unsigned long refuse_count;
+		unsigned long shed_count;
+		unsigned long shed_sz;
+	} stats;
+
+} EvAIOReqQueueAccount;
+/*****************************************************/
 typedef struct _EvAIOReqQueue
 {
 	DLinkedList aio_req_list;
@@ -231,6 +272,16 @@ typedef struct _EvAIOReqQueue
 	pthread_mutex_t mutex;
 	int max_slots;
 
+	struct
+	{
+		EvAIOReqQueueAccount *account;
+		EvAIOReqQueueWatermarkCBH *cb_handler_ptr;
+		void *cb_data_ptr;
+		DLinkedListNode account_node;
+		unsigned long high_sz;
+		unsigned long low_sz;
+	} watermark;
+
 	struct
 	{
 		unsigned long queue_sz;
@@ -244,6 +295,9 @@ typedef struct _EvAIOReqQueue
 		unsigned int queue_init:1;
 		unsigned int queue_slotted:1;
 		unsigned int cancelled:1;
+		unsigned int above_high:1;
+		unsigned int account_listed:1;
+		unsigned int shed_pending:1;
 	} flags;
 
 } EvAIOReqQueue;
@@ -282,6 +336,14 @@ EvAIOReq * EvAIOReqQueueGrabByID(EvAIOReqQueue *aio_req_queue, int aioreq_id);
 void EvAIOReqQueueRemoveItem(EvAIOReqQueue *aio_req_queue, EvAIOReq *aio_req);
 EvAIOReq *EvAIOReqQueuePointToHead(EvAIOReqQueue *aio_req_queue);
 EvAIOReq * EvAIOReqQueueDequeue(EvAIOReqQueue *aio_req_queue);
+long EvAIOReqQueueWriteVectored(EvAIOReqQueue *aio_req_queue, int fd, long max_write_sz);
+void EvAIOReqQueueWatermarkSet(EvAIOReqQueue *aio_req_queue, unsigned long high_sz, unsigned long low_sz, EvAIOReqQueueWatermarkCBH *cb_handler, void *cb_data);
+void EvAIOReqQueueAccountLink(EvAIOReqQueue *aio_req_queue, EvAIOReqQueueAccount *account);
+void EvAIOReqQueueAccountUnlink(EvAIOReqQueue *aio_req_queue);
+int EvAIOReqQueueCanEnqueue(EvAIOReqQueue *aio_req_queue, unsigned long data_sz);
+EvAIOReqQueueAccount *EvAIOReqQueueAccountNew(unsigned long max_sz, int shed_policy);
+void EvAIOReqQueueAccountDestroy(EvAIOReqQueueAccount *account);
+unsigned long EvAIOReqQueueAccountGetSize(EvAIOReqQueueAccount *account);
 EvAIOReq *EvAIOReqNew(EvAIOReqQueue *aio_req_queue, int fd, void *parent_ptr, void *data, long data_sz, long offset, EvAIOReqDestroyFunc *destroy_func,
 		EvAIOReqCBH *finish_cb, void *finish_cbdata);
 long EvAIOReqGetMissingSize(EvAIOReq *aio_req);
@@ -291,6 +353,7 @@ void EvAIOReqInvokeCallBacks(EvAIOReq *aio_req, int delay, int fd, int size, int
 int EvAIOReqDestroy(EvAIOReq *aio_req);
 int EvAIOReqTransform_WriteData(void *transform_info_ptr, EvAIOReqQueue *aio_req_queue, EvAIOReq *aio_req);
 MemBuffer *EvAIOReqTransform_ReadData(void *transform_info_ptr, char *in_data_ptr, long data_sz);
+int EvAIOReqTransform_ReadChain(void *transform_info_ptr, MemChain *mem_chain, unsigned long offset);
 int EvAIOReqTransform_CryptoEnable(void *transform_info_ptr, int algo_code, char *key_ptr, int key_sz);
 int EvAIOReqTransform_CryptoDisable(void *transform_info_ptr);
 char *EvAIOReqTransform_RC4_MD5_DataHashString(MemBuffer *transformed_mb);
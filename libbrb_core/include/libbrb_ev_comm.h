@@ -64,7 +64,19 @@
 #define COMM_TCP_SERVER_SELFSYNC_MAX_TOKEN_SZ 			16
 #define COMM_TCP_SSL_READ_BUFFER_SZ						65535
 #define COMM_TCP_ACCEPT_QUEUE							4096
+#define COMM_TCP_ACCEPT_BATCH_MIN						16
+#define COMM_TCP_DEFER_ACCEPT_SEC						5
+#define COMM_TCP_INFO_SAMPLE_INTERVAL_MS				1000
+#define COMM_TCP_INFO_SAMPLE_BATCH_MAX					256
+#define COMM_TCP_SERVER_CONN_COLD_CACHE_MAX				64				/* Free cold blocks each thread keeps per type */
 #define COMM_TCP_SERVER_MAX_LISTERNERS					32
+#define COMM_TCP_SERVER_MAX_THREADS						64
+#define COMM_TCP_SERVER_CERT_CACHE_MAX					4096
+#define COMM_TCP_SERVER_SSL_SESSION_CACHE_MAX			16384
+#define COMM_TCP_SERVER_SSL_SESSION_TIMEOUT_SEC			3600
+#define COMM_TCP_SERVER_SSL_TICKET_ROTATE_SEC			3600
+#define COMM_TCP_SERVER_SSL_TICKET_KEY_COUNT			2
+#define COMM_TCP_READ_EDGE_DRAIN_MAX						16
 #define CONN_MAXSTRING_WRITESZ							65535
 #define COMM_CLIENT_MAXSTRING_WRITESZ					65535
 
@@ -77,6 +89,7 @@
 #define COMM_TCP_CLIENT_RECONNECT_CLOSE_DEFAULT_MS		1000
 #define COMM_TCP_CLIENT_RECONNECT_FAIL_DEFAULT_MS		1000
 #define COMM_TCP_CLIENT_CALCULATE_DATARATE_DEFAULT_MS	1000
+#define COMM_TCP_CLIENT_SSL_DEST_KEYSZ					(1024 + 16)		/* HOSTNAME plus ":PORT" */
 
 #define COMM_SSH_CLIENT_RECONNECT_TIMEOUT_DEFAULT_MS	1000
 #define COMM_SSH_CLIENT_RECONNECT_CLOSE_DEFAULT_MS		1000
@@ -142,8 +155,8 @@
 #define COMM_EV_STATS_PTR_READ_USER03(statistics) ((statistics->ev_base && (statistics->ev_base->stats.cur_invoke_ts_sec > (statistics->last_user_ts + 1))) ? 0 : statistics->rate.user03)
 
 #define COMM_EV_STATS_CONN_HND_FIRE_TIMER(conn_hnd)	if ((conn_hnd->flags.calculate_datarate) && (conn_hnd->timers.calculate_datarate_id < 0))	\
-		conn_hnd->timers.calculate_datarate_id	= EvKQBaseTimerAdd(conn_hnd->parent_srv->kq_base, COMM_ACTION_ADD_VOLATILE, 1000, \
-				CommEvTCPServerConnRatesCalculateTimer, conn_hnd); \
+		{ CommEvTCPServerConnStatisticsGrab(conn_hnd); conn_hnd->timers.calculate_datarate_id	= EvKQBaseTimerAdd(conn_hnd->kq_base, COMM_ACTION_ADD_VOLATILE, 1000, \
+				CommEvTCPServerConnRatesCalculateTimer, conn_hnd); } \
 				else conn_hnd->timers.calculate_datarate_id	= -1;
 
 #define COMM_EV_TCP_CLIENT_FINISH(client) if (client->flags.destroy_after_close) CommEvTCPClientDestroy(client); else CommEvTCPClientDisconnect(client);
@@ -269,8 +282,9 @@ typedef struct _CommEvContentTransformerInfo
 		conn_hnd->events[CONN_EVENT_SSL_HANDSHAKE_FAIL].cb_handler_ptr	= conn_hnd->parent_srv->events[listener_id][COMM_SERVER_EVENT_ACCEPT_SSL_HANDSHAKE_FAIL].cb_handler_ptr; \
 		conn_hnd->events[CONN_EVENT_SSL_HANDSHAKE_FAIL].cb_data_ptr		= conn_hnd->parent_srv->events[listener_id][COMM_SERVER_EVENT_ACCEPT_SSL_HANDSHAKE_FAIL].cb_data_ptr;
 
-#define COMM_SERVER_CONN_CAN_ENQUEUE(conn_hnd)					(conn_hnd->flags.conn_unlimited_enqueue || (conn_hnd->parent_srv->cfg[conn_hnd->listener->slot_id].cli_queue_max <= 0) ? 1 : \
-		((conn_hnd->iodata.write_queue.stats.queue_sz < conn_hnd->parent_srv->cfg[conn_hnd->listener->slot_id].cli_queue_max) ? 1 : 0))
+#define COMM_SERVER_CONN_CAN_ENQUEUE(conn_hnd)					((EvAIOReqQueueCanEnqueue(&conn_hnd->iodata.write_queue, 0)) && \
+		(conn_hnd->flags.conn_unlimited_enqueue || (conn_hnd->parent_srv->cfg[conn_hnd->listener->slot_id].cli_queue_max <= 0) ? 1 : \
+		((conn_hnd->iodata.write_queue.stats.queue_sz < conn_hnd->parent_srv->cfg[conn_hnd->listener->slot_id].cli_queue_max) ? 1 : 0)))
 
 /*******************************************************/
 typedef void CommEvTCPServerCBH(int, int, int, void*, void*);
@@ -304,6 +318,7 @@ typedef enum
 {
 	COMM_SERVER_READ_MEMBUFFER,
 	COMM_SERVER_READ_MEMSTREAM,
+	COMM_SERVER_READ_MEMCHAIN,
 } CommEvTCPServerReadMethod;
 /*******************************************************/
 typedef enum
@@ -366,6 +381,7 @@ typedef enum
 	CONN_EVENT_CLOSE,
 	CONN_EVENT_WRITE_FINISH,
 	CONN_EVENT_SSL_HANDSHAKE_FAIL,
+	CONN_EVENT_WRITE_DRAIN,
 	CONN_EVENT_LASTITEM
 } CommEvTCPServerConnEventCodes;
 /*******************************************************/
@@ -380,8 +396,53 @@ typedef struct _CommEvTCPServerCertificate
 	X509 *x509_cert;
 	RSA *key_pair;
 	STACK_OF(X509) *cert_chain;
+
+	/* Ready to use context for cached certificates, so a hit costs only SSL_new */
+	SSL_CTX *ssl_context;
 } CommEvTCPServerCertificate;
 /************************************************************/
+typedef struct _CommEvTCPServerCertForge
+{
+	DLinkedListNode node;
+	struct _CommEvTCPServer *parent_srv;
+	char dnsname_str[COMM_SSL_SNI_MAXSZ];
+	struct timeval begin_tv;
+	long valid_sec;
+	int job_id;
+
+	/* Connections deferred waiting for this certificate, they may belong to any thread - Guarded by MUTEX */
+	DLinkedList waiter_list;
+	pthread_mutex_t mutex;
+	int ref_count;
+
+	/* Certificate handed to waiters, referenced until last of them is woken */
+	X509 *waiter_cert;
+
+	/* Referenced while JOB runs, so server can go away beneath us */
+	X509 *ca_cert;
+	EVP_PKEY *ca_key;
+	EVP_PKEY *main_key;
+
+	/* Filled by worker THREAD */
+	X509 *x509_cert;
+	SSL_CTX *ssl_context;
+} CommEvTCPServerCertForge;
+/************************************************************/
+typedef struct _CommEvTCPServerSSLSession
+{
+	DLinkedListNode node;
+	char sessid_str[(SSL_MAX_SSL_SESSION_ID_LENGTH * 2) + 1];
+	SSL_SESSION *ssl_session;
+} CommEvTCPServerSSLSession;
+/************************************************************/
+typedef struct _CommEvTCPServerSSLTicketKey
+{
+	unsigned char name[16];
+	unsigned char aes_key[32];
+	unsigned char hmac_key[32];
+	time_t created_ts;
+} CommEvTCPServerSSLTicketKey;
+/************************************************************/
 typedef struct _CommEvTCPServerConnTransferData
 {
 	int write_pending_bytes;
@@ -425,7 +486,10 @@ typedef struct _CommEvTCPServerConf
 
 	struct
 	{
+		EvAIOReqQueueAccount *write_account;
 		long cli_queue_max;
+		long cli_queue_high_sz;
+		long cli_queue_low_sz;
 	} limits;
 
 	struct
@@ -453,6 +517,9 @@ typedef struct _CommEvTCPServerConf
 	{
 		unsigned int reuse_addr:1;
 		unsigned int reuse_port:1;
+		unsigned int read_edge:1;
+		unsigned int defer_accept:1;	/* Only hand over connections once client sent data - Not for server speaks first protocols */
+		unsigned int calculate_datarate:1;	/* Account statistics and calculate rates for every connection, starting at ACCEPT */
 	} flags;
 
 } CommEvTCPServerConf;
@@ -467,6 +534,9 @@ typedef struct _CommEvTCPServerListener
 	int socket_fd;
 	int port;
 
+	/* Per worker SO_REUSEPORT sockets, indexed by THRD_ID, zero is socket_fd */
+	int thrd_socket_fd[COMM_TCP_SERVER_MAX_THREADS];
+
 	struct
 	{
 		SSL_CTX *ssl_context;
@@ -495,6 +565,24 @@ typedef struct _CommEvTCPServerConnEventPrototype
 
 } CommEvTCPServerConnEventPrototype;
 /************************************************************/
+typedef struct _CommEvTCPInfoSampler
+{
+	struct _EvKQBase *kq_base;
+	pthread_mutex_t mutex;
+	DLinkedList stats_list;
+	int interval_ms;
+	int batch_max;
+	int timer_id;
+
+	struct
+	{
+		unsigned long rounds;
+		unsigned long sampled;
+		unsigned long failed;
+	} stats;
+
+} CommEvTCPInfoSampler;
+/************************************************************/
 typedef struct _CommEvTCPServer
 {
 	EvBaseKQObject kq_obj;
@@ -502,6 +590,7 @@ typedef struct _CommEvTCPServer
 	struct _EvKQBase *kq_base;
 	struct _EvKQBaseLogBase *log_base;
 	struct _CommEvUNIXServer *unix_server;
+	CommEvTCPInfoSampler *tcp_info_sampler;
 	int ref_count;
 
 	struct
@@ -519,7 +608,73 @@ typedef struct _CommEvTCPServer
 		{
 			AssocArray *table;
 			DLinkedList list;
+			pthread_mutex_t mutex;
+			int max_entries;
+
+			struct
+			{
+				unsigned long hit;
+				unsigned long miss;
+				unsigned long evicted;
+				unsigned long ctx_reuse;
+				unsigned long ctx_new;
+			} stats;
 		} cert_cache;
+
+		struct
+		{
+			AssocArray *table;
+			DLinkedList list;
+			pthread_mutex_t mutex;
+
+			struct
+			{
+				unsigned long forged;
+				unsigned long failed;
+				unsigned long coalesced;
+				unsigned long sync;
+				unsigned long latency_last_ms;
+				unsigned long latency_max_ms;
+				unsigned long latency_total_ms;
+			} stats;
+		} cert_forge;
+
+		struct
+		{
+			AssocArray *table;
+			DLinkedList list;
+			pthread_mutex_t mutex;
+			int max_entries;
+			long timeout_sec;
+
+			struct
+			{
+				unsigned long full;
+				unsigned long resumed;
+				unsigned long hit;
+				unsigned long miss;
+				unsigned long stored;
+				unsigned long expired;
+				unsigned long evicted;
+			} stats;
+		} session_cache;
+
+		struct
+		{
+			/* Index zero encrypts new tickets, others still decrypt tickets issued before rotation */
+			CommEvTCPServerSSLTicketKey key_arr[COMM_TCP_SERVER_SSL_TICKET_KEY_COUNT];
+			pthread_mutex_t mutex;
+			long rotate_sec;
+
+			struct
+			{
+				unsigned long issued;
+				unsigned long decrypted;
+				unsigned long renewed;
+				unsigned long unknown_key;
+				unsigned long rotated;
+			} stats;
+		} ticket;
 	} ssldata;
 
 	struct
@@ -548,7 +703,10 @@ typedef struct _CommEvTCPServer
 		CommEvTCPServerType srv_type;
 
 		struct sockaddr_storage bind_addr;
+		EvAIOReqQueueAccount *write_account;
 		long cli_queue_max;
+		long cli_queue_high_sz;
+		long cli_queue_low_sz;
 		int port;
 
 		struct
@@ -577,23 +735,46 @@ typedef struct _CommEvTCPServer
 			unsigned int self_sync:1;
 			unsigned int reuse_addr:1;
 			unsigned int reuse_port:1;
+			unsigned int thrd_shard:1;
+			unsigned int read_edge:1;
+			unsigned int defer_accept:1;
+			unsigned int calculate_datarate:1;
 		} flags;
 
 	} cfg [COMM_TCP_SERVER_MAX_LISTERNERS];
 
 } CommEvTCPServer;
 /************************************************************/
+typedef enum
+{
+	COMM_TCP_SERVER_CONN_COLD_TRANSFORM,
+	COMM_TCP_SERVER_CONN_COLD_STATISTICS,
+	COMM_TCP_SERVER_CONN_COLD_TRANSFER,
+	COMM_TCP_SERVER_CONN_COLD_LASTITEM
+} CommEvTCPServerConnColdCodes;
+/************************************************************/
+typedef struct _CommEvTCPServerConnTransfer
+{
+	DLinkedListNode node;
+	struct timeval tv;
+	unsigned long io_loop;
+} CommEvTCPServerConnTransfer;
+/************************************************************/
 typedef struct _CommEvTCPServerConn
 {
 	DLinkedListNode conn_node;
-	CommEvContentTransformerInfo transform;
-	CommEvStatistics statistics;
 	CommEvTCPIOData iodata;
 	CommEvTCPSSLData ssldata;
 	CommEvTCPServerConnEventPrototype events[CONN_EVENT_LASTITEM];
 
+	/* Cold state - NULL until first use, then grabbed from per-thread caches and given back on shutdown */
+	CommEvContentTransformerInfo *transform;
+	CommEvStatistics *statistics;
+	CommEvTCPServerConnTransfer *transfer;
+
 	struct _CommEvTCPServerListener *listener;
 	struct _CommEvTCPServer *parent_srv;
+	struct _EvKQBase *kq_base;
 
 	struct sockaddr_storage conn_addr;
 	struct sockaddr_storage local_addr;
@@ -617,15 +798,18 @@ typedef struct _CommEvTCPServerConn
 	struct
 	{
 		DLinkedListNode node;
-		struct timeval tv;
-		unsigned long io_loop;
-	} transfer;
+		struct _CommEvTCPServerCertForge *forge_ptr;
+	} cert_forge;
 
 	struct
 	{
 		int calculate_datarate_id;
 	} timers;
 
+	/* Paired connection feeding our write queue, paused while we are above HIGH mark */
+	CommEvBackpressure backpressure;
+	int backpressure_jobid;
+
 	struct
 	{
 		char *token_str;
@@ -659,6 +843,8 @@ typedef struct _CommEvTCPServerConn
 		unsigned int pending_write:1;
 		unsigned int conn_accept_invoked:1;
 		unsigned int peek_on_read:1;
+		unsigned int write_drain_pending:1;
+		unsigned int write_shed_pending:1;
 	} flags;
 
 } CommEvTCPServerConn;
@@ -673,6 +859,7 @@ typedef enum
 	COMM_CLIENT_EVENT_WRITE,
 	COMM_CLIENT_EVENT_CLOSE,
 	COMM_CLIENT_EVENT_CONNECT,
+	COMM_CLIENT_EVENT_WRITE_DRAIN,
 	COMM_CLIENT_EVENT_LASTITEM
 } CommEvTCPClientEventCodes;
 /************************************************************/
@@ -706,6 +893,7 @@ typedef enum
 {
 	COMM_CLIENT_READ_MEMBUFFER,
 	COMM_CLIENT_READ_MEMSTREAM,
+	COMM_CLIENT_READ_MEMCHAIN,
 } CommEvTCPClientReadMethod;
 /************************************************************/
 typedef enum
@@ -723,6 +911,9 @@ typedef enum
 	COMM_POOL_SELECT_LEAST_LOAD,
 	COMM_POOL_SELECT_CONNECTED,
 	COMM_POOL_SELECT_ANY,
+	/* Keep CONNECTED and ANY values stable, they are also passed as select_connected */
+	COMM_POOL_SELECT_POWER_OF_TWO,
+	COMM_POOL_SELECT_LEAST_LATENCY,
 	COMM_POOL_SELECT_LASTITEM
 } CommEvPoolSelectCode;
 /************************************************************/
@@ -799,6 +990,7 @@ typedef struct _CommEvTCPClientConf
 		unsigned int calculate_datarate:1;
 		unsigned int bindany_active:1;
 		unsigned int ssl_null_cypher:1;
+		unsigned int read_edge:1;
 	} flags;
 
 
@@ -821,6 +1013,20 @@ typedef struct _CommEvTCPClientEventPrototype
 
 } CommEvTCPClientEventPrototype;
 /*******************************************************/
+typedef struct _CommEvTCPClientSSLContext
+{
+	DLinkedListNode node;
+	char key_str[(EVP_MAX_MD_SIZE * 2) + 1];
+	SSL_CTX *ssl_context;
+	unsigned long generation;
+	int ref_count;
+
+	struct
+	{
+		unsigned int linked:1;
+	} flags;
+} CommEvTCPClientSSLContext;
+/*******************************************************/
 typedef struct _CommEvTCPClient
 {
 	EvBaseKQObject kq_obj;
@@ -835,6 +1041,10 @@ typedef struct _CommEvTCPClient
 	CommEvTCPSSLData ssldata;
 	EvDNSReplyHandler dnsdata;
 
+	/* Shared context from registry, ssldata.ssl_context points into it */
+	CommEvTCPClientSSLContext *ssl_shared_ctx;
+	CommEvTCPInfoSampler *tcp_info_sampler;
+
 	struct _EvKQBase *kq_base;
 	struct _EvKQBaseLogBase *log_base;
 	struct _CommEvTCPClientPool *parent_pool;
@@ -851,6 +1061,10 @@ typedef struct _CommEvTCPClient
 	int socket_state;
 	int cli_id_onpool;
 
+	/* Paired connection feeding our write queue, paused while we are above HIGH mark */
+	CommEvBackpressure backpressure;
+	int backpressure_jobid;
+
 	struct
 	{
 		int connect_ms;
@@ -926,6 +1140,9 @@ typedef struct _CommEvTCPClient
 		unsigned int pending_write:1;
 		unsigned int socket_in_transfer:1;
 		unsigned int peek_on_read:1;
+		unsigned int read_edge:1;
+		unsigned int write_drain_pending:1;
+		unsigned int write_shed_pending:1;
 	} flags;
 
 } CommEvTCPClient;
@@ -933,15 +1150,32 @@ typedef struct _CommEvTCPClient
 typedef struct _CommEvTCPClientPoolConf
 {
 	int cli_count_init;
+	int cli_count_min;
 	int cli_count_max;
+	int health_check_ms;
 
 	struct
 	{
-		unsigned int foo:1;
+		unsigned int eject_slow:1;
+		unsigned int auto_resize:1;
 	} flags;
 
 } CommEvTCPClientPoolConf;
 
+typedef struct _CommEvTCPClientSSLDest
+{
+	char key_str[COMM_TCP_CLIENT_SSL_DEST_KEYSZ];
+	SSL_SESSION *ssl_session;
+
+	struct
+	{
+		unsigned long stored;
+		unsigned long offered;
+		unsigned long full;
+		unsigned long resumed;
+	} stats;
+} CommEvTCPClientSSLDest;
+
 typedef struct _CommEvTCPClientPool
 {
 	CommEvTCPClientPoolConf pool_conf;
@@ -959,13 +1193,34 @@ typedef struct _CommEvTCPClientPool
 	{
 		MemSlotBase memslot;
 		int count_init;
+		int count_alloc;
 		int count_online;
 		int rr_current;
 	} client;
 
+	struct
+	{
+		CommEvPoolHealth arr[COMM_TCP_CLIENT_POOL_MAX];
+		unsigned long latency_ewma_us;
+		int idle_ticks;
+		int timer_id;
+	} health;
+
+	struct
+	{
+		CommEvTCPClientCBH *cb_handler_ptr;
+		void *cb_data_ptr;
+	} events[COMM_CLIENT_EVENT_LASTITEM];
+
+	struct
+	{
+		AssocArray *dest_table;
+	} ssldata;
+
 	struct
 	{
 		unsigned int has_error:1;
+		unsigned int conf_set:1;
 	} flags;
 
 } CommEvTCPClientPool;
@@ -1259,6 +1514,9 @@ void CommEvSerialPortEventCancel(CommEvSerialPort *serial_port, int ev_type);
 void CommEvSerialPortEventCancelAll(CommEvSerialPort *serial_port);
 
 
+/* Defined in libbrb_thread.h, included after us */
+struct _ThreadPoolBase;
+
 /******************************************************************************************************/
 /* comm/core/tcp/comm_tcp_server.c */
 /******************************************************************************************************/
@@ -1279,6 +1537,16 @@ void CommEvTCPServerSSLCertCacheDestroy(CommEvTCPServerCertificate *cert_info);
 int CommEvTCPServerSSLCertCacheInsert(CommEvTCPServer *srv_ptr, char *dnsname_str, X509 *x509_cert);
 X509 *CommEvTCPServerSSLCertCacheLookupByConnHnd(CommEvTCPServerConn *conn_hnd);
 X509 *CommEvTCPServerSSLCertCacheLookup(CommEvTCPServer *srv_ptr, char *dnsname_str);
+X509 *CommEvTCPServerSSLCertCacheLookupRef(CommEvTCPServer *srv_ptr, char *dnsname_str);
+void CommEvTCPServerSSLCertCacheSetMax(CommEvTCPServer *srv_ptr, int max_entries);
+SSL_CTX *CommEvTCPServerSSLCertCacheContextGet(CommEvTCPServer *srv_ptr, char *dnsname_str, X509 *x509_cert);
+int CommEvTCPServerSSLCertForge(CommEvTCPServerConn *conn_hnd, struct _ThreadPoolBase *thrd_pool, int valid_sec, int wildcard);
+void CommEvTCPServerSSLSessionContextInit(CommEvTCPServer *srv_ptr, SSL_CTX *ssl_context, char *sid_ctx_str);
+void CommEvTCPServerSSLSessionCacheSetMax(CommEvTCPServer *srv_ptr, int max_entries);
+void CommEvTCPServerSSLSessionCacheDestroy(CommEvTCPServerSSLSession *ssl_sess);
+void CommEvTCPServerSSLTicketKeySetRotate(CommEvTCPServer *srv_ptr, long rotate_sec);
+int CommEvTCPServerSSLTicketKeyRotate(CommEvTCPServer *srv_ptr);
+void CommEvTCPServerTCPInfoSamplerSet(CommEvTCPServer *srv_ptr, CommEvTCPInfoSampler *sampler);
 
 /******************************************************************************************************/
 /* comm/core/tcp/comm_tcp_server_conn.c */
@@ -1312,6 +1580,13 @@ int CommEvTCPServerConnIODataDestroy(CommEvTCPServerConn *conn_hnd);
 void CommEvTCPServerConnSSLSessionInit(CommEvTCPServerConn *ret_conn);
 void CommEvTCPServerConnSSLSessionDestroy(CommEvTCPServerConn *ret_conn);
 char *CommEvTCPServerConnSSLDataGetSNIStr(CommEvTCPServerConn *conn_hnd);
+CommEvStatistics *CommEvTCPServerConnStatisticsGrab(CommEvTCPServerConn *conn_hnd);
+CommEvContentTransformerInfo *CommEvTCPServerConnTransformGrab(CommEvTCPServerConn *conn_hnd);
+void CommEvTCPServerConnColdRelease(CommEvTCPServerConn *conn_hnd);
+void CommEvTCPServerConnBackpressureInit(CommEvTCPServerConn *conn_hnd);
+void CommEvTCPServerConnWatermarkSet(CommEvTCPServerConn *conn_hnd, unsigned long high_sz, unsigned long low_sz);
+int CommEvTCPServerConnReadPause(CommEvTCPServerConn *conn_hnd);
+int CommEvTCPServerConnReadResume(CommEvTCPServerConn *conn_hnd);
 
 
 
@@ -1348,8 +1623,15 @@ void CommEvTCPClientAddrInitUnix(CommEvTCPClient *ev_tcpclient, char *unix_path)
 
 int CommEvTCPClientReconnectSchedule(CommEvTCPClient *ev_tcpclient, int schedule_ms);
 int CommEvTCPClientRatesCalculateSchedule(CommEvTCPClient *ev_tcpclient, int schedule_ms);
+void CommEvTCPClientTCPInfoSamplerSet(CommEvTCPClient *ev_tcpclient, CommEvTCPInfoSampler *sampler);
+void CommEvTCPClientWatermarkSet(CommEvTCPClient *ev_tcpclient, unsigned long high_sz, unsigned long low_sz);
+void CommEvTCPClientWriteAccountSet(CommEvTCPClient *ev_tcpclient, EvAIOReqQueueAccount *account);
+int CommEvTCPClientReadPause(CommEvTCPClient *ev_tcpclient);
+int CommEvTCPClientReadResume(CommEvTCPClient *ev_tcpclient);
+int CommEvTCPClientReadReschedule(CommEvTCPClient *ev_tcpclient);
 void CommEvTCPClientEventDispatchInternal(CommEvTCPClient *ev_tcpclient, int data_sz, int thrd_id, int ev_type);
 int CommEvTCPClientProcessBuffer(CommEvTCPClient *ev_tcpclient, int read_sz, int thrd_id, char *read_buf, int read_buf_sz);
+int CommEvTCPClientReadSchedule(CommEvTCPClient *ev_tcpclient, int read_pending);
 /* AIO events */
 EvBaseKQCBH CommEvTCPClientEventConnect;
 EvBaseKQCBH CommEvTCPClientEventEof;
@@ -1366,6 +1648,9 @@ int CommEvTCPClientSSLDataInit(CommEvTCPClient *ev_tcpclient);
 int CommEvTCPClientSSLDataClean(CommEvTCPClient *ev_tcpclient);
 int CommEvTCPClientSSLDataReset(CommEvTCPClient *ev_tcpclient);
 int CommEvTCPClientSSLPeerVerify(CommEvTCPClient *ev_tcpclient);
+void CommEvTCPClientSSLDestDestroy(CommEvTCPClientSSLDest *ssl_dest);
+unsigned long CommEvTCPClientSSLContextReload(void);
+int CommEvTCPClientSSLContextCount(void);
 /******************************************************************************************************/
 /* comm_tcp_client_pool.c */
 /******************************************************************************************************/
@@ -1377,6 +1662,9 @@ int CommEvTCPClientPoolReconnect(CommEvTCPClientPool *tcp_clientpool);
 CommEvTCPClient *CommEvTCPClientPoolClientSelect(CommEvTCPClientPool *tcp_clientpool, int select_method, int select_connected);
 CommEvTCPClient *CommEvTCPClientPoolClientSelectLeastLoad(CommEvTCPClientPool *tcp_clientpool, int select_connected);
 CommEvTCPClient *CommEvTCPClientPoolClientSelectRoundRobin(CommEvTCPClientPool *tcp_clientpool, int select_connected);
+CommEvTCPClient *CommEvTCPClientPoolClientSelectPowerOfTwo(CommEvTCPClientPool *tcp_clientpool, int select_connected);
+CommEvTCPClient *CommEvTCPClientPoolClientSelectLeastLatency(CommEvTCPClientPool *tcp_clientpool, int select_connected);
+void CommEvTCPClientPoolClientEventNotify(CommEvTCPClientPool *tcp_clientpool, CommEvTCPClient *ev_tcpclient, int ev_type);
 int CommEvTCPClientPoolHasConnected(CommEvTCPClientPool *tcp_clientpool);
 int CommEvTCPClientPoolEventSet(CommEvTCPClientPool *tcp_clientpool, CommEvTCPClientEventCodes ev_type, CommEvTCPClientCBH *cb_handler, void *cb_data);
 int CommEvTCPClientPoolEventCancel(CommEvTCPClientPool *tcp_clientpool, CommEvTCPClientEventCodes ev_type);
@@ -1413,6 +1701,9 @@ X509 *CommEvSSLUtils_X509ForgeAndSignFromOrigCert(X509 *ca_cert, EVP_PKEY *cakey
 int CommEvSSLUtils_X509CertSign(X509 *target_cert, EVP_PKEY *cakey);
 
 void CommEvSSLUtils_X509CertRefCountInc(X509 *crt, int thread_safe);
+void CommEvSSLUtils_SessionRefCountInc(SSL_SESSION *ssl_session, int thread_safe);
+void CommEvSSLUtils_ContextRefCountInc(SSL_CTX *ssl_context, int thread_safe);
+int CommEvSSLUtils_SessionIsValid(SSL_SESSION *ssl_session);
 int CommEvSSLUtils_X509CopyRandom(X509 *dstcrt, X509 *srccrt);
 int CommEvSSLUtils_X509V3ExtAdd(X509V3_CTX *ctx, X509 *crt, char *k, char *v);
 int CommEvSSLUtils_X509V3ExtCopyByNID(X509 *crt, X509 *origcrt, int nid);
@@ -1463,6 +1754,34 @@ char *CommEvStatisticsPacketsHumanize(long total_packets, char *buf_ptr, int buf
 char *CommEvStatisticsUptimeHumanize(long total_sec, char *buf_ptr, int buf_maxsz);
 void CommEvStatisticsClean(CommEvStatistics *statistics);
 void CommEvStatisticsRateClean(CommEvStatistics *statistics);
+int CommEvStatisticsTCPInfoSample(CommEvStatistics *statistics, int socket_fd, unsigned long sample_ts);
+
+CommEvTCPInfoSampler *CommEvTCPInfoSamplerNew(struct _EvKQBase *kq_base, int interval_ms, int batch_max);
+void CommEvTCPInfoSamplerDestroy(CommEvTCPInfoSampler *sampler);
+int CommEvTCPInfoSamplerAdd(CommEvTCPInfoSampler *sampler, CommEvStatistics *statistics, int socket_fd, struct sockaddr_storage *peer_addr, char *label_str);
+int CommEvTCPInfoSamplerDel(CommEvStatistics *statistics);
+int CommEvTCPInfoSamplerDumpSlowest(CommEvTCPInfoSampler *sampler, MemBuffer *json_mb, int max_count);
+/******************************************************************************************************/
+/* comm_pool_health.c */
+/******************************************************************************************************/
+void CommEvPoolHealthClean(CommEvPoolHealth *health);
+void CommEvPoolHealthWriteMark(CommEvPoolHealth *health, struct timeval *now_tv);
+int CommEvPoolHealthReplyMark(CommEvPoolHealth *health, struct timeval *now_tv, int reply_count);
+int CommEvPoolHealthFailMark(CommEvPoolHealth *health, struct timeval *now_tv, int can_eject);
+int CommEvPoolHealthPendingExpire(CommEvPoolHealth *health, struct timeval *now_tv);
+int CommEvPoolHealthCanSelect(CommEvPoolHealth *health, struct timeval *now_tv);
+int CommEvPoolHealthCheck(CommEvPoolHealth *health, struct timeval *now_tv, unsigned long pool_ewma_us, int can_eject);
+unsigned long CommEvPoolHealthCost(CommEvPoolHealth *health, long load);
+/******************************************************************************************************/
+/* comm_backpressure.c */
+/******************************************************************************************************/
+void CommEvBackpressureInit(CommEvBackpressure *backpressure, void *owner_ptr, CommEvBackpressureReadCtlCBH *read_ctl_cbh);
+void CommEvBackpressureLink(CommEvBackpressure *backpressure_a, CommEvBackpressure *backpressure_b);
+void CommEvBackpressureUnlink(CommEvBackpressure *backpressure);
+int CommEvBackpressurePeerPause(CommEvBackpressure *backpressure);
+int CommEvBackpressurePeerResume(CommEvBackpressure *backpressure);
+int CommEvBackpressureReadPause(CommEvBackpressure *backpressure);
+int CommEvBackpressureReadResume(CommEvBackpressure *backpressure);
 /******************************************************************************************************/
 /* comm_desc_token.c */
 /******************************************************************************************************/
@@ -221,6 +221,7 @@ typedef struct _EvBaseKQGenericEventPrototype
 	{
 		unsigned int persist:1;
 		unsigned int enabled:1;
+		unsigned int edge:1;
 		unsigned int mutex_init:1;
 	} flags;
 
@@ -233,7 +234,14 @@ typedef struct _EvBaseKQGenericTimeoutPrototype
 	long when_ts;
 
 	int timeout_ms;
-	int timer_id;
+
+	struct
+	{
+		DLinkedListNode node;
+		DLinkedList *slot_list;
+		unsigned long expire_tick;
+	} wheel;
+
 } EvBaseKQGenericTimeoutPrototype;
 /*****************************************************/
 typedef struct _EvBaseKQGenericDeferPrototype
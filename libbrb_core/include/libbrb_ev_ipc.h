@@ -132,6 +132,7 @@ typedef struct _EvIPCBaseChild
 		char token_str_buf[IPC_SELFSYNC_MAX_TOKEN_SZ];
 		int token_str_sz;
 		int max_buffer_sz;
+		unsigned long scan_off;
 	} self_sync;
 
 	struct
@@ -65,6 +65,10 @@
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
 #include <openssl/pkcs12.h>
+#include <openssl/hmac.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
 
 /* OpenSSH */
 #include <libssh2.h>
@@ -95,6 +99,22 @@
 #define KQEV_IOLOOP_MAXINTERVAL_NS		100000  		/* 100ms */
 #define KQEV_IOLOOP_MININTERVAL_NS		3000  			/* 1ms */
 
+/* FD timeout wheel - Tick is the minimum KEVENT wait, 256 slots on level 0 and 64 slots for each upper level */
+#define KQEV_TIMEOUT_WHEEL_TICK_MS		KQEV_IOLOOP_MININTERVAL_MS
+#define KQEV_TIMEOUT_WHEEL_LEVELS		4
+#define KQEV_TIMEOUT_WHEEL_L0_BITS		8
+#define KQEV_TIMEOUT_WHEEL_LN_BITS		6
+#define KQEV_TIMEOUT_WHEEL_L0_SLOTS		(1 << KQEV_TIMEOUT_WHEEL_L0_BITS)
+#define KQEV_TIMEOUT_WHEEL_LN_SLOTS		(1 << KQEV_TIMEOUT_WHEEL_LN_BITS)
+#define KQEV_TIMEOUT_WHEEL_L0_MASK		(KQEV_TIMEOUT_WHEEL_L0_SLOTS - 1)
+#define KQEV_TIMEOUT_WHEEL_LN_MASK		(KQEV_TIMEOUT_WHEEL_LN_SLOTS - 1)
+#define KQEV_TIMEOUT_WHEEL_MAX_TICKS	((1UL << (KQEV_TIMEOUT_WHEEL_L0_BITS + ((KQEV_TIMEOUT_WHEEL_LEVELS - 1) * KQEV_TIMEOUT_WHEEL_LN_BITS))) - 1)
+
+#define KQEV_THREAD_MAX					64
+#define KQEV_THREAD_WAKEUP_IDENT		0xB0B0
+
+#define KQEV_THRD_ID(kq_base)			((kq_base)->kq_thread.thrd_id)
+
 #define KQEV_TIMEVAL_DELTA(when, now) ((now->tv_sec - when->tv_sec) * 1000 + (now->tv_usec - when->tv_usec) / 1000)
 
 //#define EVFILT_READ		(-1)
@@ -258,6 +278,24 @@ typedef struct _EvKQBaseConf
 
 } EvKQBaseConf;
 /*****************************************************/
+typedef struct _EvKQBaseThreadJob
+{
+	DLinkedListNode node;
+	EvBaseKQCBH *cb_handler;
+	void *cb_data;
+} EvKQBaseThreadJob;
+/*****************************************************/
+typedef struct _EvKQBaseTimeoutWheel
+{
+	DLinkedList level_zero[KQEV_TIMEOUT_WHEEL_L0_SLOTS];
+	DLinkedList level_upper[KQEV_TIMEOUT_WHEEL_LEVELS - 1][KQEV_TIMEOUT_WHEEL_LN_SLOTS];
+	unsigned long long level_zero_map[KQEV_TIMEOUT_WHEEL_L0_SLOTS / 64];
+
+	unsigned long base_ms;
+	unsigned long cur_tick;
+	unsigned long armed_count;
+} EvKQBaseTimeoutWheel;
+/*****************************************************/
 typedef struct _EvKQBaseStats
 {
 	struct timeval first_invoke_tv;
@@ -294,6 +332,16 @@ typedef struct _EvKQBaseStats
 		} opcode[AIOREQ_OPCODE_LASTITEM];
 	} aio;
 
+	struct
+	{
+		unsigned long armed_total;
+		unsigned long canceled_total;
+		unsigned long expired_total;
+		unsigned long kchg_saved_total;
+		unsigned long kchg_saved_cur;
+		unsigned long kchg_saved_last;
+	} timeout_wheel;
+
 } EvKQBaseStats;
 
 typedef struct _EvKQBase
@@ -324,6 +372,22 @@ typedef struct _EvKQBase
 		int smallest_interval;
 	} timer;
 
+	struct
+	{
+		EvKQBaseTimeoutWheel wheel;
+	} timeout_fd;
+
+	struct
+	{
+		struct _EvKQBase *parent_base;
+		struct _EvKQBase **worker_arr;
+		pthread_t *worker_thrd_arr;
+		DLinkedList inbox;
+		int worker_count;
+		int thrd_id;
+		volatile int stop_request;
+	} kq_thread;
+
 	struct
 	{
 		MemSlotBase memslot;
@@ -434,6 +498,7 @@ int EvKQBaseFDCleanupByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd);
 int EvKQBaseFDReadBufferDrain(EvKQBase *kq_base, int fd);
 int EvKQBaseSocketBufferReadSizeGet(EvKQBase *kq_base, int fd);
 int EvKQBaseSocketBufferWriteSizeGet(EvKQBase *kq_base, int fd);
+int EvKQBaseSocketBufferReadPendingGet(EvKQBase *kq_base, int fd);
 int EvKQBaseSocketSetNoDelay(EvKQBase *kq_base, int fd);
 int EvKQBaseSocketSetBroadcast(EvKQBase *kq_base, int fd);
 int EvKQBaseSocketSetKeepAlive(EvKQBase *kq_base, int fd);
@@ -450,6 +515,8 @@ int EvKQBaseSocketSetNonBlock(EvKQBase *kq_base, int fd);
 int EvKQBaseSocketSetBlocking(EvKQBase *kq_base, int fd);
 int EvKQBaseSocketSetReuseAddr(EvKQBase *kq_base, int fd);
 int EvKQBaseSocketSetReusePort(EvKQBase *kq_base, int fd);
+int EvKQBaseSocketSetReusePortLB(EvKQBase *kq_base, int fd);
+int EvKQBaseSocketSetDeferAccept(EvKQBase *kq_base, int fd, int defer_sec);
 int EvKQBaseSocketSetTCPBufferSize(EvKQBase *kq_base, int fd, int size);
 int EvKQBaseSocketSetDstAddr(EvKQBase *kq_base, int fd);
 
@@ -472,6 +539,9 @@ int EvKQBaseTimeoutInitAllByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd);
 int EvKQBaseTimeoutClearByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int timeout_type);
 int EvKQBaseTimeoutClear(EvKQBase *kq_base, int fd, int timeout_type);
 int EvKQBaseTimeoutClearAll(EvKQBase *kq_base, int fd);
+void EvKQBaseTimeoutWheelInit(EvKQBase *kq_base);
+void EvKQBaseTimeoutWheelDestroy(EvKQBase *kq_base);
+int EvKQBaseTimeoutWheelDispatch(EvKQBase *kq_base);
 
 /* ev_kq_timer.c */
 void EvKQBaseTimerArenaNew(EvKQBase *kq_base, int max_timer_count);
@@ -502,6 +572,17 @@ int EvKQBaseDeferReadRemoveByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd);
 int EvKQBaseDeferWriteCheckByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd, int event_sz);
 int EvKQBaseDeferWriteRemoveByKQFD(EvKQBase *kq_base, EvBaseKQFileDesc *kq_fd);
 
+/* ev_kq_thread.c */
+int EvKQBaseThreadEngineInit(EvKQBase *kq_base);
+void EvKQBaseThreadEngineStop(EvKQBase *kq_base);
+void EvKQBaseThreadEngineDestroy(EvKQBase *kq_base);
+int EvKQBaseThreadCountGet(EvKQBase *kq_base);
+EvKQBase *EvKQBaseThreadBaseGetByID(EvKQBase *kq_base, int thrd_id);
+int EvKQBaseThreadJobSend(EvKQBase *kq_base, int thrd_id, EvBaseKQCBH *cb_handler, void *cb_data);
+int EvKQBaseThreadWakeupInit(EvKQBase *kq_base);
+int EvKQBaseThreadWakeup(EvKQBase *kq_base);
+int EvKQBaseThreadInboxDispatch(EvKQBase *kq_base);
+
 /* ev_kq_ievents.c */
 int EvKQBaseInternalEventSet(EvKQBase *kq_base, int ev_type, int action, EvBaseKQCBH *cb_handler, void *cb_data);
 int EvKQBaseInternalEventDispatch(EvKQBase *kq_base, int ev_data, int thrd_id, int ev_type);
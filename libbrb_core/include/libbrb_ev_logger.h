@@ -35,12 +35,22 @@
 #ifndef LIBBRB_LOGGER_H_
 #define LIBBRB_LOGGER_H_
 
-#define KQBASE_LOG_PRINTF(log_base, type, color, msg, ...)	if (log_base) EvKQBaseLoggerAdd(log_base, 0, type, color, __FILE__, __func__, __LINE__, msg, ##__VA_ARGS__)
+/* Same level filter EvKQBaseLoggerAdd applies, inlined so disabled levels cost a branch and no call */
+#define KQBASE_LOG_LEVEL_ENABLED(log_base, type)	((LOGTYPE_DEBUG == (type)) ? (!(log_base)->flags.debug_disable) : ((log_base)->log_level <= (type)))
+
+#define KQBASE_LOG_PRINTF(log_base, type, color, msg, ...)	if ((log_base) && KQBASE_LOG_LEVEL_ENABLED(log_base, type)) EvKQBaseLoggerAdd(log_base, 0, type, color, __FILE__, __func__, __LINE__, msg, ##__VA_ARGS__)
 #define KQBASE_LOGSUB_PRINTF(log_sub, type, color, msg, ...) if (EvKQBaseLogSubIsEnabled(log_sub, type)) EvKQBaseLoggerAdd(((EvKQBaseLogSub *)log_sub)->log_base, 1, type, color, __FILE__, __func__, __LINE__, msg, ##__VA_ARGS__)
 
 /************************************************************************************************************************/
 /* DEFINES */
 /************************************************************/
+#define KQBASE_LOGGER_ASYNC_RING_MAX		64		/* Threads that can own an ASYNC RING, others write synchronously */
+#define KQBASE_LOGGER_ASYNC_SLOT_COUNT		512		/* Lines per RING, must be power of two */
+#define KQBASE_LOGGER_ASYNC_LINE_SZ			512		/* Longer lines are written synchronously */
+#define KQBASE_LOGGER_ASYNC_IOV_LINES		64		/* Lines gathered on each WRITEV */
+#define KQBASE_LOGGER_ASYNC_IDLE_USEC		1000	/* Writer thread nap when all RINGs are empty */
+#define KQBASE_LOGGER_ASYNC_FULL_RETRY		1024	/* Yields a producer waits on a full RING before dropping the line */
+/************************************************************/
 /* Background Colors
 /************************************************************/
 #define COLOR_BACKGROUND_BLACK 			"\033[40m"
@@ -116,6 +126,32 @@ typedef struct _EvKQBaseLogMemEntry
 
 } EvKQBaseLogMemEntry;
 /************************************************************/
+typedef struct _EvKQBaseLogTimeCache
+{
+	long sec;
+	int len;
+	char str[64];
+} EvKQBaseLogTimeCache;
+/************************************************************/
+typedef struct _EvKQBaseLogAsyncSlot
+{
+	char *color_str;
+	int line_sz;
+	char line_str[KQBASE_LOGGER_ASYNC_LINE_SZ];
+} EvKQBaseLogAsyncSlot;
+/************************************************************/
+typedef struct _EvKQBaseLogAsyncRing
+{
+	/* Single producer (owner thread) writes TAIL, single consumer (writer thread) writes HEAD */
+	unsigned long head;
+	unsigned long tail;
+	unsigned long drop_count;	/* Lines dropped on a full RING, reported in the stream by writer thread */
+	int orphan;
+
+	EvKQBaseLogTimeCache time_cache;
+	EvKQBaseLogAsyncSlot slot_arr[KQBASE_LOGGER_ASYNC_SLOT_COUNT];
+} EvKQBaseLogAsyncRing;
+/************************************************************/
 typedef struct _EvKQBaseLogBaseConf
 {
 	char *fileout_pathstr;
@@ -140,6 +176,7 @@ typedef struct _EvKQBaseLogBaseConf
 		unsigned int autohash_disable:1;
 		unsigned int dump_on_signal:1;
 		unsigned int destroyed:1;
+		unsigned int async_write:1;
 	} flags;
 
 } EvKQBaseLogBaseConf;
@@ -172,6 +209,18 @@ typedef struct _EvKQBaseLogBase
 		long lines_total_limit;
 	} mem;
 
+	struct
+	{
+		EvKQBaseLogAsyncRing *ring_arr[KQBASE_LOGGER_ASYNC_RING_MAX];
+		pthread_key_t ring_key;
+		pthread_t writer_thrd;
+		int ring_count;
+		int running;
+		int stop_request;
+	} async;
+
+	EvKQBaseLogTimeCache time_cache;
+
 	struct
 	{
 		unsigned int disable_colors_onfile:1;
@@ -184,6 +233,7 @@ typedef struct _EvKQBaseLogBase
 		unsigned int autohash_disable:1;
 		unsigned int dump_on_signal:1;
 		unsigned int destroyed:1;
+		unsigned int async_write:1;
 	} flags;
 
 } EvKQBaseLogBase;
@@ -222,5 +272,6 @@ void EvKQBaseLogHexDump(char *data, int size, int item_count, int column_count);
 int EvKQBaseLoggerMemDumpOnCrash(EvKQBaseLogBase *log_base);
 int EvKQBaseLoggerMemDumpToFile(EvKQBaseLogBase *log_base, char *path_str);
 int EvKQBaseLoggerMemDump(EvKQBaseLogBase *log_base);
+int EvKQBaseLoggerAsyncFlush(EvKQBaseLogBase *log_base);
 /************************************************************************************************************************/
 #endif /* LIBBRB_LOGGER_H_ */
@@ -39,6 +39,8 @@
 /***********************************************************************/
 #define THREAD_POOL_JOBS_MAX_ENQUEUED_COUNT 4096
 #define THREAD_POOL_JOBS_MAX_USERDATA_SIZE	1024
+#define THREAD_POOL_WORKER_DEQUE_SZ			256		/* Must be power of two */
+#define THREAD_POOL_WORKER_BATCH_MAX		8		/* JOBs a worker moves from INJECT queue into its own DEQUE at once */
 /**************************************************************************************************************************/
 /* TYPES */
 /***********************************************************************/
@@ -101,6 +103,14 @@ typedef struct _ThreadPoolInstance
 	int thread_state;
 	int thread_id_pool;
 
+	/* Work stealing DEQUE - Owner pushes and pops at BOTTOM, other workers steal from TOP */
+	struct
+	{
+		long top;
+		long bottom;
+		struct _ThreadPoolInstanceJob *job_arr[THREAD_POOL_WORKER_DEQUE_SZ];
+	} deque;
+
 	struct
 	{
 		unsigned volatile int init:1;
@@ -137,6 +147,7 @@ typedef struct _ThreadPoolInstanceJob
 {
 	DLinkedListNode node;
 	struct _ThreadPoolBase *parent_base;
+	struct _ThreadPoolInstanceJob *done_next;
 	int job_id;
 	int run_thread_id;
 	int retval_type;
@@ -194,6 +205,12 @@ typedef struct _ThreadPoolInstanceJob
 
 } ThreadPoolInstanceJob;
 /***********************************************************************/
+typedef struct _ThreadPoolInjectCell
+{
+	unsigned long seq;
+	ThreadPoolInstanceJob *thread_job;
+} ThreadPoolInjectCell;
+/***********************************************************************/
 typedef struct _ThreadPoolBaseConfig
 {
 	struct _EvKQBaseLogBase *log_base;
@@ -225,8 +242,33 @@ typedef struct _ThreadPoolBase
 	struct
 	{
 		MemSlotBase memslot;
+		ThreadPoolInstance **arr;
+		int count;
 	} instances;
 
+	/* Lock-free bounded MPMC queue where new JOBs are injected */
+	struct
+	{
+		ThreadPoolInjectCell *cell_arr;
+		unsigned long mask;
+		unsigned long head;
+		unsigned long tail;
+	} inject;
+
+	/* Lock-free stack of finished JOBs, drained by MAIN THREAD */
+	struct
+	{
+		ThreadPoolInstanceJob *head;
+	} done;
+
+	/* Idle workers sleep here */
+	struct
+	{
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		int idle_count;
+	} park;
+
 	struct
 	{
 		int worker_count_start;
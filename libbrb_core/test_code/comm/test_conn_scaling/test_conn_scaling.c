@@ -0,0 +1,373 @@
+/*
+ * test_conn_scaling.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_core.h>
+#include <sys/resource.h>
+
+#define CONN_COUNT_DEFAULT		10000
+#define CONN_BATCH_SZ			512
+#define CONN_PORT				9997
+#define CONN_SETTLE_LOOPS		2048
+#define CONN_RATE_PORT			9995
+#define CONN_RATE_COUNT			8
+#define CONN_RATE_BYTES			65536
+
+EvKQBase *glob_ev_base;
+CommEvTCPServer *glob_tcp_srv;
+
+static void TestConnScalingCheck(int cond, char *check_str);
+static int TestConnScalingListen(int port);
+static int TestConnScalingRateListen(int port);
+static void TestConnScalingRateCheck(void);
+static int TestConnScalingOpen(int *fd_arr, int conn_count, int port);
+static long TestConnScalingRSSGet(void);
+static void TestConnScalingLayoutReport(void);
+
+static CommEvTCPServerCBH TestConnScalingAcceptEvent;
+static CommEvTCPServerCBH TestConnScalingReadEvent;
+
+/**************************************************************************************************************************/
+int main(int argc, char **argv)
+{
+	EvKQBaseConf kq_conf;
+	struct rlimit fd_limit;
+	DLinkedListNode *node;
+	int *fd_arr;
+	long rss_base;
+	long rss_idle;
+	long rss_stats;
+	long conn_accepted;
+	long conn_with_stats;
+	int conn_count;
+	int conn_open;
+	int i;
+
+	conn_count = ((argc > 1) ? atoi(argv[1]) : CONN_COUNT_DEFAULT);
+
+	/* Both ends live in this process */
+	fd_limit.rlim_cur = fd_limit.rlim_max = ((conn_count * 2) + 64);
+	setrlimit(RLIMIT_NOFILE, &fd_limit);
+
+	/* Clean STACK */
+	memset(&kq_conf, 0, sizeof(EvKQBaseConf));
+
+	glob_ev_base	= EvKQBaseNew(&kq_conf);
+	glob_tcp_srv	= CommEvTCPServerNew(glob_ev_base);
+	fd_arr			= calloc(conn_count, sizeof(int));
+
+	TestConnScalingLayoutReport();
+
+	if (TestConnScalingListen(CONN_PORT) < 0)
+	{
+		printf("Failed listening on port [%d]\n", CONN_PORT);
+		return 0;
+	}
+
+	/* Let listener settle, then take baseline */
+	EvKQBaseDispatchOnce(glob_ev_base, 1);
+	rss_base	= TestConnScalingRSSGet();
+
+	/* Open idle connections - Nothing is ever written on them */
+	conn_open	= TestConnScalingOpen(fd_arr, conn_count, CONN_PORT);
+	rss_idle	= TestConnScalingRSSGet();
+
+	conn_accepted = glob_tcp_srv->conn.list.size;
+	TestConnScalingCheck((conn_accepted == conn_open), "All idle connections accepted");
+
+	/* Listener did not ask for datarate, so nobody should carry statistics yet */
+	for (conn_with_stats = 0, node = glob_tcp_srv->conn.list.head; node; node = node->next)
+		conn_with_stats += (((CommEvTCPServerConn*)node->data)->statistics ? 1 : 0);
+
+	TestConnScalingCheck((0 == conn_with_stats), "Idle connections carry no statistics");
+
+	printf("IDLE  - [%ld / %d] connections accepted - RSS [%ld -> %ld KB] - [%ld] bytes per idle connection\n",
+			conn_accepted, conn_open, rss_base, rss_idle, ((conn_accepted > 0) ? (((rss_idle - rss_base) * 1024) / conn_accepted) : 0));
+
+	/* Now ask for statistics on all of them, so cold blocks are grabbed */
+	for (node = glob_tcp_srv->conn.list.head; node; node = node->next)
+		CommEvTCPServerConnStatisticsGrab(node->data);
+
+	rss_stats	= TestConnScalingRSSGet();
+
+	printf("STATS - [%ld] connections with statistics - [%ld] extra bytes per connection\n",
+			conn_accepted, ((conn_accepted > 0) ? (((rss_stats - rss_idle) * 1024) / conn_accepted) : 0));
+
+	/* Close client side and let server notice */
+	for (i = 0; i < conn_open; i++)
+		close(fd_arr[i]);
+
+	for (i = 0; (i < CONN_SETTLE_LOOPS) && (glob_tcp_srv->conn.list.size > 0); i++)
+		EvKQBaseDispatchOnce(glob_ev_base, 1);
+
+	TestConnScalingCheck((0 == glob_tcp_srv->conn.list.size), "Server noticed all idle connections closing");
+
+	/* Now check datarate accounting on a listener that asked for it */
+	TestConnScalingRateCheck();
+
+	free(fd_arr);
+	CommEvTCPServerDestroy(glob_tcp_srv);
+	EvKQBaseDestroy(glob_ev_base);
+
+	printf("TEST_CONN_SCALING - All tests passed\n");
+	return 1;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static void TestConnScalingCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/**************************************************************************************************************************/
+static int TestConnScalingListen(int port)
+{
+	CommEvTCPServerConf conf_plain;
+	int plain_lid;
+
+	/* Clean up stack */
+	memset(&conf_plain, 0, sizeof(CommEvTCPServerConf));
+
+	/* Fill in control configuration */
+	conf_plain.bind_method			= COMM_SERVER_BINDANY;
+	conf_plain.read_mthd			= COMM_SERVER_READ_MEMBUFFER;
+	conf_plain.srv_proto			= COMM_SERVERPROTO_PLAIN;
+	conf_plain.port					= port;
+	conf_plain.flags.reuse_addr		= 1;
+	conf_plain.flags.reuse_port		= 1;
+
+	plain_lid = CommEvTCPServerListenerAdd(glob_tcp_srv, &conf_plain);
+
+	if (plain_lid < 0)
+		return plain_lid;
+
+	/* Accept and do nothing else, connection stays idle */
+	CommEvTCPServerEventSet(glob_tcp_srv, plain_lid, COMM_SERVER_EVENT_ACCEPT_AFTER, TestConnScalingAcceptEvent, NULL);
+	return plain_lid;
+}
+/**************************************************************************************************************************/
+static int TestConnScalingRateListen(int port)
+{
+	CommEvTCPServerConf conf_rate;
+	int rate_lid;
+
+	/* Clean up stack */
+	memset(&conf_rate, 0, sizeof(CommEvTCPServerConf));
+
+	/* Same as idle listener, but account datarate for every connection */
+	conf_rate.bind_method				= COMM_SERVER_BINDANY;
+	conf_rate.read_mthd					= COMM_SERVER_READ_MEMBUFFER;
+	conf_rate.srv_proto					= COMM_SERVERPROTO_PLAIN;
+	conf_rate.port						= port;
+	conf_rate.flags.reuse_addr			= 1;
+	conf_rate.flags.reuse_port			= 1;
+	conf_rate.flags.calculate_datarate	= 1;
+
+	rate_lid = CommEvTCPServerListenerAdd(glob_tcp_srv, &conf_rate);
+
+	if (rate_lid < 0)
+		return rate_lid;
+
+	CommEvTCPServerEventSet(glob_tcp_srv, rate_lid, COMM_SERVER_EVENT_ACCEPT_AFTER, TestConnScalingAcceptEvent, NULL);
+	CommEvTCPServerEventSet(glob_tcp_srv, rate_lid, COMM_SERVER_EVENT_DEFAULT_READ, TestConnScalingReadEvent, NULL);
+	return rate_lid;
+}
+/**************************************************************************************************************************/
+static void TestConnScalingRateCheck(void)
+{
+	CommEvTCPServerConn *conn_hnd;
+	DLinkedListNode *node;
+	struct timeval start_tv;
+	struct timeval now_tv;
+	char *data_buf;
+	long conn_ok;
+	long rx_total;
+	int fd_arr[CONN_RATE_COUNT];
+	int conn_open;
+	int wrote_sz;
+	int i;
+
+	TestConnScalingCheck((TestConnScalingRateListen(CONN_RATE_PORT) >= 0), "Datarate listener up");
+
+	conn_open = TestConnScalingOpen((int*)&fd_arr, CONN_RATE_COUNT, CONN_RATE_PORT);
+	TestConnScalingCheck(((CONN_RATE_COUNT == conn_open) && (CONN_RATE_COUNT == glob_tcp_srv->conn.list.size)), "Datarate connections accepted");
+
+	/* Statistics and rates timer must be there right from ACCEPT, before any byte moved */
+	for (conn_ok = 0, node = glob_tcp_srv->conn.list.head; node; node = node->next)
+	{
+		conn_hnd = node->data;
+		conn_ok += ((conn_hnd->flags.calculate_datarate && conn_hnd->statistics && (conn_hnd->timers.calculate_datarate_id > -1) &&
+				(0 == conn_hnd->statistics->total[COMM_CURRENT].byte_rx)) ? 1 : 0);
+	}
+
+	TestConnScalingCheck((CONN_RATE_COUNT == conn_ok), "Statistics and rates timer armed at ACCEPT");
+
+	/* Write a known amount from each client */
+	data_buf = calloc(1, CONN_RATE_BYTES);
+
+	for (i = 0; i < conn_open; i++)
+	{
+		fcntl(fd_arr[i], F_SETFL, 0);
+		wrote_sz = write(fd_arr[i], data_buf, CONN_RATE_BYTES);
+		TestConnScalingCheck((CONN_RATE_BYTES == wrote_sz), "Client wrote all bytes");
+	}
+
+	/* First timer tick at ACCEPT + 1s just sets rate time base, second one calculates - Give it 2.5 seconds */
+	gettimeofday(&start_tv, NULL);
+
+	do
+	{
+		EvKQBaseDispatchOnce(glob_ev_base, 10);
+		gettimeofday(&now_tv, NULL);
+	}
+	while (((now_tv.tv_sec - start_tv.tv_sec) * 1000 + ((now_tv.tv_usec - start_tv.tv_usec) / 1000)) < 2500);
+
+	/* All bytes accounted, and rates within what a ~1 second window allows */
+	for (conn_ok = 0, rx_total = 0, node = glob_tcp_srv->conn.list.head; node; node = node->next)
+	{
+		conn_hnd	= node->data;
+		rx_total	+= conn_hnd->statistics->total[COMM_CURRENT].byte_rx;
+
+		conn_ok += (((CONN_RATE_BYTES == conn_hnd->statistics->total[COMM_CURRENT].byte_rx) && (conn_hnd->statistics->total[COMM_CURRENT].packet_rx > 0) &&
+				(conn_hnd->statistics->rate.byte_rx > 0) && (conn_hnd->statistics->rate.byte_rx <= ((CONN_RATE_BYTES * 8.00 * 1000.00) / 900.00))) ? 1 : 0);
+	}
+
+	printf("RATES - [%ld] bytes received on [%d] connections\n", rx_total, conn_open);
+	TestConnScalingCheck((((long)CONN_RATE_BYTES * CONN_RATE_COUNT) == rx_total), "Byte counters account every byte since ACCEPT");
+	TestConnScalingCheck((CONN_RATE_COUNT == conn_ok), "Read rates calculated for every connection");
+
+	/* Close client side and let server notice */
+	for (i = 0; i < conn_open; i++)
+		close(fd_arr[i]);
+
+	for (i = 0; (i < CONN_SETTLE_LOOPS) && (glob_tcp_srv->conn.list.size > 0); i++)
+		EvKQBaseDispatchOnce(glob_ev_base, 1);
+
+	TestConnScalingCheck((0 == glob_tcp_srv->conn.list.size), "Server noticed all datarate connections closing");
+
+	free(data_buf);
+	return;
+}
+/**************************************************************************************************************************/
+static int TestConnScalingOpen(int *fd_arr, int conn_count, int port)
+{
+	struct sockaddr_in srv_addr;
+	int conn_open = 0;
+	int batch_end;
+	int i;
+
+	memset(&srv_addr, 0, sizeof(srv_addr));
+	srv_addr.sin_family			= AF_INET;
+	srv_addr.sin_port			= htons(port);
+	srv_addr.sin_addr.s_addr	= htonl(INADDR_LOOPBACK);
+
+	while (conn_open < conn_count)
+	{
+		batch_end = (((conn_open + CONN_BATCH_SZ) < conn_count) ? (conn_open + CONN_BATCH_SZ) : conn_count);
+
+		/* Fire a batch of non-blocking connects */
+		for (; conn_open < batch_end; conn_open++)
+		{
+			fd_arr[conn_open] = socket(AF_INET, SOCK_STREAM, 0);
+
+			if (fd_arr[conn_open] < 0)
+				goto finish;
+
+			fcntl(fd_arr[conn_open], F_SETFL, O_NONBLOCK);
+			connect(fd_arr[conn_open], (struct sockaddr*)&srv_addr, sizeof(srv_addr));
+		}
+
+		/* Drain accept queue before next batch overflows backlog */
+		for (i = 0; (i < CONN_SETTLE_LOOPS) && (glob_tcp_srv->conn.list.size < conn_open); i++)
+			EvKQBaseDispatchOnce(glob_ev_base, 1);
+	}
+
+	return conn_open;
+
+	finish:
+
+	printf("Stopped opening at [%d] connections - errno [%d]\n", conn_open, errno);
+
+	for (i = 0; (i < CONN_SETTLE_LOOPS) && (glob_tcp_srv->conn.list.size < conn_open); i++)
+		EvKQBaseDispatchOnce(glob_ev_base, 1);
+
+	return conn_open;
+}
+/**************************************************************************************************************************/
+static long TestConnScalingRSSGet(void)
+{
+	struct rusage usage;
+
+	/* Peak RSS in KB - Connections only grow during measurement, so peak is current */
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+/**************************************************************************************************************************/
+static void TestConnScalingLayoutReport(void)
+{
+	unsigned long hot_sz		= sizeof(CommEvTCPServerConn);
+	unsigned long cold_sz		= (sizeof(CommEvContentTransformerInfo) + sizeof(CommEvStatistics) + sizeof(CommEvTCPServerConnTransfer));
+	unsigned long inline_sz		= ((hot_sz - (3 * sizeof(void*))) + cold_sz + COMM_SSL_SNI_MAXSZ);
+
+	printf("CONN_HND hot header [%lu] bytes (SSLDATA [%lu] inline) - Cold blocks: TRANSFORM [%lu] STATISTICS [%lu] TRANSFER [%lu]\n",
+			hot_sz, sizeof(CommEvTCPSSLData), sizeof(CommEvContentTransformerInfo), sizeof(CommEvStatistics), sizeof(CommEvTCPServerConnTransfer));
+	printf("CONN_HND with everything inline would be [%lu] bytes - Idle slot now costs [%.1f%%] of that\n",
+			inline_sz, ((hot_sz * 100.0) / inline_sz));
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestConnScalingAcceptEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	return;
+}
+/**************************************************************************************************************************/
+static void TestConnScalingReadEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvTCPServerConn *conn_hnd = CommEvTCPServerConnArenaGrab(glob_tcp_srv, fd);
+
+	/* Statistics already accounted by server, just drop data */
+	if (conn_hnd->iodata.read_buffer)
+		MemBufferClean(conn_hnd->iodata.read_buffer);
+
+	return;
+}
+/**************************************************************************************************************************/
@@ -0,0 +1,298 @@
+/*
+ * test_ssl_forge.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_core.h>
+
+#define FORGE_PORT				9443
+#define FORGE_HOST_COUNT		8
+#define FORGE_CLIENTS_PER_HOST	8
+#define FORGE_CLIENT_COUNT		(FORGE_HOST_COUNT * FORGE_CLIENTS_PER_HOST)
+#define FORGE_SETTLE_LOOPS		20000
+#define FORGE_CA_CERT_PATH		"./test_ssl_forge_ca.crt"
+#define FORGE_CA_KEY_PATH		"./test_ssl_forge_ca.key"
+
+typedef struct _TestSSLForgeClient
+{
+	pthread_t thread;
+	char host_str[64];
+	int status;
+} TestSSLForgeClient;
+
+EvKQBase *glob_ev_base;
+CommEvTCPServer *glob_tcp_srv;
+ThreadPoolBase *glob_thrd_pool;
+SSL_CTX *glob_client_ctx;
+int glob_client_done;
+
+static void TestSSLForgeRound(TestSSLForgeClient *client_arr, const char *label_str);
+static int TestSSLForgeListen(int port);
+static int TestSSLForgeCAWrite(void);
+static void *TestSSLForgeClientThread(void *client_ptr);
+static void TestSSLForgeCheck(int cond, const char *label_str);
+
+static CommEvTCPServerCBH TestSSLForgeSNIEvent;
+
+/**************************************************************************************************************************/
+int main(int argc, char **argv)
+{
+	TestSSLForgeClient client_arr[FORGE_CLIENT_COUNT];
+	ThreadPoolBaseConfig pool_conf;
+	EvKQBaseConf kq_conf;
+	unsigned long forged_first;
+
+	/* Clean STACK */
+	memset(&kq_conf, 0, sizeof(EvKQBaseConf));
+	memset(&pool_conf, 0, sizeof(ThreadPoolBaseConfig));
+	memset(&client_arr, 0, sizeof(client_arr));
+
+	/* Connections are sharded across IO threads, so FORGE FINISH must hand them back to their owners */
+	kq_conf.engine_type				= KQ_BASE_MULTI_THREADED_ENGINE;
+	kq_conf.kq_thread.count_start	= 4;
+
+	glob_ev_base	= EvKQBaseNew(&kq_conf);
+	glob_tcp_srv	= CommEvTCPServerNew(glob_ev_base);
+
+	/* Signing THREAD_POOL, reporting back through KEVENT */
+	pool_conf.worker_count_start		= 2;
+	pool_conf.worker_count_max			= 2;
+	pool_conf.job_max_count				= 256;
+	pool_conf.flags.kevent_finish_notify	= 1;
+	glob_thrd_pool						= ThreadPoolBaseNew(glob_ev_base, &pool_conf);
+
+	TestSSLForgeCheck((TestSSLForgeCAWrite() > 0), "CA certificate written");
+	TestSSLForgeCheck((CommEvSSLUtils_GenerateRSAToServer(glob_tcp_srv, 2048) > 0), "server key generated");
+	TestSSLForgeCheck((TestSSLForgeListen(FORGE_PORT) >= 0), "SSL listener up");
+
+	glob_client_ctx = SSL_CTX_new(SSLv23_client_method());
+
+	/* First round - Every host misses cache, concurrent connections for same host coalesce into one JOB */
+	TestSSLForgeRound(client_arr, "FORGE");
+
+	forged_first = glob_tcp_srv->ssldata.cert_forge.stats.forged;
+
+	TestSSLForgeCheck((glob_tcp_srv->ssldata.cert_forge.stats.failed == 0), "no forge failed");
+	TestSSLForgeCheck((glob_tcp_srv->ssldata.cert_forge.stats.sync == 0), "all forges ran on THREAD_POOL");
+	TestSSLForgeCheck((forged_first >= FORGE_HOST_COUNT), "every host forged");
+	TestSSLForgeCheck((forged_first < FORGE_CLIENT_COUNT), "connections for same host shared a FORGE JOB");
+
+	/* Second round - All of them must come from cache, with a ready context */
+	TestSSLForgeRound(client_arr, "CACHE");
+
+	TestSSLForgeCheck((glob_tcp_srv->ssldata.cert_forge.stats.forged == forged_first), "cached hosts not forged again");
+	TestSSLForgeCheck((glob_tcp_srv->ssldata.cert_cache.stats.ctx_reuse >= FORGE_CLIENT_COUNT), "cached contexts reused");
+
+	/* Shrink cache under connections, evicted contexts must survive until their users are gone */
+	CommEvTCPServerSSLCertCacheSetMax(glob_tcp_srv, 1);
+	TestSSLForgeRound(client_arr, "EVICT");
+
+	TestSSLForgeCheck((glob_tcp_srv->ssldata.cert_cache.stats.evicted >= (FORGE_HOST_COUNT - 1)), "cache evicted down to limit");
+
+	printf("FORGED [%lu] - COALESCED [%lu] - HIT [%lu] - MISS [%lu] - EVICTED [%lu] - LATENCY MAX [%lu ms]\n",
+			glob_tcp_srv->ssldata.cert_forge.stats.forged, glob_tcp_srv->ssldata.cert_forge.stats.coalesced,
+			glob_tcp_srv->ssldata.cert_cache.stats.hit, glob_tcp_srv->ssldata.cert_cache.stats.miss,
+			glob_tcp_srv->ssldata.cert_cache.stats.evicted, glob_tcp_srv->ssldata.cert_forge.stats.latency_max_ms);
+
+	SSL_CTX_free(glob_client_ctx);
+	CommEvTCPServerDestroy(glob_tcp_srv);
+	ThreadPoolBaseDestroy(glob_thrd_pool);
+	EvKQBaseDestroy(glob_ev_base);
+
+	unlink(FORGE_CA_CERT_PATH);
+	unlink(FORGE_CA_KEY_PATH);
+
+	printf("SSL_FORGE - All tests passed\n");
+	return 0;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static void TestSSLForgeRound(TestSSLForgeClient *client_arr, const char *label_str)
+{
+	char check_str[128];
+	int ok_count = 0;
+	int i;
+
+	glob_client_done = 0;
+
+	/* Launch all clients at once, FORGE_CLIENTS_PER_HOST of them for each host */
+	for (i = 0; i < FORGE_CLIENT_COUNT; i++)
+	{
+		snprintf((char*)&client_arr[i].host_str, sizeof(client_arr[i].host_str), "host%d.forge.test", (i % FORGE_HOST_COUNT));
+		client_arr[i].status = 0;
+		pthread_create(&client_arr[i].thread, NULL, TestSSLForgeClientThread, &client_arr[i]);
+	}
+
+	/* Drive IO loop until all clients are done */
+	for (i = 0; (i < FORGE_SETTLE_LOOPS) && (__atomic_load_n(&glob_client_done, __ATOMIC_ACQUIRE) < FORGE_CLIENT_COUNT); i++)
+		EvKQBaseDispatchOnce(glob_ev_base, 1);
+
+	for (i = 0; i < FORGE_CLIENT_COUNT; i++)
+	{
+		pthread_join(client_arr[i].thread, NULL);
+		ok_count += client_arr[i].status;
+	}
+
+	snprintf((char*)&check_str, sizeof(check_str), "%s - [%d / %d] handshakes with a certificate valid for SNI", label_str, ok_count, FORGE_CLIENT_COUNT);
+	TestSSLForgeCheck((ok_count == FORGE_CLIENT_COUNT), check_str);
+
+	return;
+}
+/**************************************************************************************************************************/
+static int TestSSLForgeListen(int port)
+{
+	CommEvTCPServerConf conf_ssl;
+	int ssl_lid;
+
+	/* Clean up stack */
+	memset(&conf_ssl, 0, sizeof(CommEvTCPServerConf));
+
+	conf_ssl.bind_method		= COMM_SERVER_BINDANY;
+	conf_ssl.read_mthd			= COMM_SERVER_READ_MEMBUFFER;
+	conf_ssl.srv_proto			= COMM_SERVERPROTO_SSL;
+	conf_ssl.port				= port;
+	conf_ssl.flags.reuse_addr	= 1;
+	conf_ssl.flags.reuse_port	= 1;
+	conf_ssl.ssl.ca_cert_path	= FORGE_CA_CERT_PATH;
+	conf_ssl.ssl.ca_key_path	= FORGE_CA_KEY_PATH;
+
+	conf_ssl.events[COMM_SERVER_EVENT_ACCEPT_SNIPARSE].handler	= TestSSLForgeSNIEvent;
+	conf_ssl.events[COMM_SERVER_EVENT_ACCEPT_SNIPARSE].data		= NULL;
+
+	ssl_lid = CommEvTCPServerListenerAdd(glob_tcp_srv, &conf_ssl);
+	return ssl_lid;
+}
+/**************************************************************************************************************************/
+static int TestSSLForgeCAWrite(void)
+{
+	CommEvSSLUtilsCertReq cert_req;
+
+	/* Clean up stack */
+	memset(&cert_req, 0, sizeof(CommEvSSLUtilsCertReq));
+
+	cert_req.options.common_name_str	= "BrByte Forge Test CA";
+	cert_req.options.organization_str	= "BrByte";
+	cert_req.options.country_str		= "BR";
+	cert_req.options.serial				= 1;
+	cert_req.options.valid_days			= 1;
+	cert_req.options.self_sign			= 1;
+	cert_req.options.key_size			= 2048;
+	cert_req.options.exponent			= RSA_F4;
+
+	if (!CommEvSSLUtils_X509CertRootNew(&cert_req))
+		return 0;
+
+	CommEvSSLUtils_X509CertToFile(FORGE_CA_CERT_PATH, cert_req.result.x509_cert);
+	CommEvSSLUtils_X509PrivateKeyWriteToFile(FORGE_CA_KEY_PATH, cert_req.result.key_private);
+
+	X509_free(cert_req.result.x509_cert);
+	EVP_PKEY_free(cert_req.result.key_private);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static void *TestSSLForgeClientThread(void *client_ptr)
+{
+	TestSSLForgeClient *client = client_ptr;
+	struct sockaddr_in srv_addr;
+	X509 *peer_cert;
+	SSL *ssl_handle;
+	int socket_fd;
+
+	memset(&srv_addr, 0, sizeof(srv_addr));
+	srv_addr.sin_family			= AF_INET;
+	srv_addr.sin_port			= htons(FORGE_PORT);
+	srv_addr.sin_addr.s_addr	= htonl(INADDR_LOOPBACK);
+
+	socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	/* Blocking client, each one on its own thread */
+	if ((socket_fd < 0) || (connect(socket_fd, (struct sockaddr*)&srv_addr, sizeof(srv_addr)) < 0))
+		goto finish;
+
+	ssl_handle = SSL_new(glob_client_ctx);
+	SSL_set_fd(ssl_handle, socket_fd);
+	SSL_set_tlsext_host_name(ssl_handle, client->host_str);
+
+	/* Handshake only completes after FORGE FINISH woke our connection up on its own IO thread */
+	if (SSL_connect(ssl_handle) == 1)
+	{
+		peer_cert = SSL_get_peer_certificate(ssl_handle);
+
+		/* Server must present a certificate forged for the name we asked for */
+		if ((peer_cert) && (X509_check_host(peer_cert, client->host_str, 0, 0, NULL) == 1))
+			client->status = 1;
+
+		if (peer_cert)
+			X509_free(peer_cert);
+
+		SSL_shutdown(ssl_handle);
+	}
+
+	SSL_free(ssl_handle);
+
+	/* TAG to close and report */
+	finish:
+
+	if (socket_fd >= 0)
+		close(socket_fd);
+
+	__atomic_fetch_add(&glob_client_done, 1, __ATOMIC_ACQ_REL);
+	return NULL;
+}
+/**************************************************************************************************************************/
+static void TestSSLForgeCheck(int cond, const char *label_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", label_str);
+		abort();
+	}
+
+	printf("OK - %s\n", label_str);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestSSLForgeSNIEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvTCPServer *tcp_srv		= base_ptr;
+	CommEvTCPServerConn *conn_hnd	= CommEvTCPServerConnArenaGrab(tcp_srv, fd);
+
+	/* Cached, deferred until FORGE FINISH or failed - Failure closes here, others are taken care by server */
+	if (CommEvTCPServerSSLCertForge(conn_hnd, glob_thrd_pool, 3600, 0) < 0)
+		CommEvTCPServerConnClose(conn_hnd);
+
+	return;
+}
+/**************************************************************************************************************************/
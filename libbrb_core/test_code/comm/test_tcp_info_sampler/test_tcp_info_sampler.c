@@ -0,0 +1,230 @@
+/*
+ * test_tcp_info_sampler.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_core.h>
+
+#define SAMPLER_CLIENT_COUNT		16
+#define SAMPLER_PORT				9996
+#define SAMPLER_INTERVAL_MS			20
+#define SAMPLER_BATCH_MAX			4
+#define SAMPLER_SETTLE_LOOPS		2048
+
+EvKQBase *glob_ev_base;
+CommEvTCPServer *glob_tcp_srv;
+CommEvTCPInfoSampler *glob_srv_sampler;
+CommEvTCPInfoSampler *glob_cli_sampler;
+CommEvTCPClient *glob_tcpclient_arr[SAMPLER_CLIENT_COUNT];
+int glob_connected_count;
+int glob_closed_count;
+
+static void TestSamplerCheck(int cond, char *check_str);
+static int TestSamplerListen(int port);
+static void TestSamplerRoundsWait(CommEvTCPInfoSampler *sampler, unsigned long round_count);
+
+static CommEvTCPServerCBH TestSamplerAcceptEvent;
+static CommEvTCPClientCBH TestSamplerClientConnectEvent;
+static CommEvTCPClientCBH TestSamplerClientCloseEvent;
+
+/**************************************************************************************************************************/
+int main(int argc, char **argv)
+{
+	CommEvTCPClientConf cli_conf;
+	CommEvTCPServerConn *conn_hnd;
+	DLinkedListNode *node;
+	EvKQBaseConf kq_conf;
+	MemBuffer *json_mb;
+	unsigned long failed_count;
+	int dump_count;
+	int i;
+
+	/* Clean STACK */
+	memset(&kq_conf, 0, sizeof(EvKQBaseConf));
+	memset(&cli_conf, 0, sizeof(CommEvTCPClientConf));
+
+	glob_ev_base		= EvKQBaseNew(&kq_conf);
+	glob_tcp_srv		= CommEvTCPServerNew(glob_ev_base);
+	glob_srv_sampler	= CommEvTCPInfoSamplerNew(glob_ev_base, SAMPLER_INTERVAL_MS, SAMPLER_BATCH_MAX);
+	glob_cli_sampler	= CommEvTCPInfoSamplerNew(glob_ev_base, SAMPLER_INTERVAL_MS, SAMPLER_BATCH_MAX);
+
+	TestSamplerCheck((glob_srv_sampler && glob_cli_sampler), "sampler alloc");
+	CommEvTCPServerTCPInfoSamplerSet(glob_tcp_srv, glob_srv_sampler);
+	TestSamplerCheck((TestSamplerListen(SAMPLER_PORT) >= 0), "listen");
+
+	/* Plain clients, no reconnect, so a server side close ends in client INTERNAL_DISCONNECT */
+	cli_conf.hostname		= "127.0.0.1";
+	cli_conf.port			= SAMPLER_PORT;
+	cli_conf.cli_proto		= COMM_CLIENTPROTO_PLAIN;
+	cli_conf.read_mthd		= COMM_CLIENT_READ_MEMBUFFER;
+
+	for (i = 0; i < SAMPLER_CLIENT_COUNT; i++)
+	{
+		glob_tcpclient_arr[i] = CommEvTCPClientNew(glob_ev_base);
+
+		CommEvTCPClientTCPInfoSamplerSet(glob_tcpclient_arr[i], glob_cli_sampler);
+		CommEvTCPClientEventSet(glob_tcpclient_arr[i], COMM_CLIENT_EVENT_CONNECT, TestSamplerClientConnectEvent, NULL);
+		CommEvTCPClientEventSet(glob_tcpclient_arr[i], COMM_CLIENT_EVENT_CLOSE, TestSamplerClientCloseEvent, NULL);
+		CommEvTCPClientConnect(glob_tcpclient_arr[i], &cli_conf);
+	}
+
+	for (i = 0; (i < SAMPLER_SETTLE_LOOPS) && ((glob_connected_count < SAMPLER_CLIENT_COUNT) || (glob_tcp_srv->conn.list.size < SAMPLER_CLIENT_COUNT)); i++)
+		EvKQBaseDispatchOnce(glob_ev_base, 1);
+
+	TestSamplerCheck((glob_connected_count == SAMPLER_CLIENT_COUNT), "all clients connected");
+	TestSamplerCheck((glob_srv_sampler->stats_list.size == SAMPLER_CLIENT_COUNT), "server side registered");
+	TestSamplerCheck((glob_cli_sampler->stats_list.size == SAMPLER_CLIENT_COUNT), "client side registered");
+
+	/* Enough rounds for batches to cover every registered connection */
+	TestSamplerRoundsWait(glob_cli_sampler, ((SAMPLER_CLIENT_COUNT / SAMPLER_BATCH_MAX) + 1));
+	TestSamplerRoundsWait(glob_srv_sampler, ((SAMPLER_CLIENT_COUNT / SAMPLER_BATCH_MAX) + 1));
+
+	for (i = 0; i < SAMPLER_CLIENT_COUNT; i++)
+		TestSamplerCheck((glob_tcpclient_arr[i]->statistics.tcp_info.sample_ts > 0), "client sampled");
+
+	TestSamplerCheck((glob_srv_sampler->stats.failed == 0), "server side sample failures");
+	TestSamplerCheck((glob_cli_sampler->stats.failed == 0), "client side sample failures");
+
+	/* Dump is capped at MAX_COUNT */
+	json_mb		= MemBufferNew(BRBDATA_THREAD_UNSAFE, 1024);
+	dump_count	= CommEvTCPInfoSamplerDumpSlowest(glob_cli_sampler, json_mb, 4);
+	TestSamplerCheck((dump_count == 4), "dump slowest");
+	MemBufferDestroy(json_mb);
+
+	/* Close every connection from server side */
+	for (node = glob_tcp_srv->conn.list.head; node; )
+	{
+		conn_hnd	= node->data;
+		node		= node->next;
+		CommEvTCPServerConnClose(conn_hnd);
+	}
+
+	TestSamplerCheck((glob_srv_sampler->stats_list.size == 0), "server side left sampler on close");
+
+	/* Clients see EOF and go through INTERNAL_DISCONNECT, which must leave sampler before closing FD */
+	for (i = 0; (i < SAMPLER_SETTLE_LOOPS) && (glob_closed_count < SAMPLER_CLIENT_COUNT); i++)
+		EvKQBaseDispatchOnce(glob_ev_base, 1);
+
+	TestSamplerCheck((glob_closed_count == SAMPLER_CLIENT_COUNT), "all clients closed");
+	TestSamplerCheck((glob_cli_sampler->stats_list.size == 0), "client side left sampler on disconnect");
+
+	for (i = 0; i < SAMPLER_CLIENT_COUNT; i++)
+	{
+		TestSamplerCheck((!glob_tcpclient_arr[i]->statistics.tcp_info.sampler), "client detached");
+		TestSamplerCheck((glob_tcpclient_arr[i]->statistics.tcp_info.socket_fd == -1), "client sampler FD reset");
+	}
+
+	/* More rounds on empty lists must not query any stale descriptor */
+	failed_count = glob_cli_sampler->stats.failed;
+	TestSamplerRoundsWait(glob_cli_sampler, 2);
+	TestSamplerCheck((glob_cli_sampler->stats.failed == failed_count), "no sample after disconnect");
+
+	for (i = 0; i < SAMPLER_CLIENT_COUNT; i++)
+		CommEvTCPClientDestroy(glob_tcpclient_arr[i]);
+
+	CommEvTCPInfoSamplerDestroy(glob_cli_sampler);
+	CommEvTCPInfoSamplerDestroy(glob_srv_sampler);
+	CommEvTCPServerDestroy(glob_tcp_srv);
+	EvKQBaseDestroy(glob_ev_base);
+
+	printf("TEST_TCP_INFO_SAMPLER - All tests passed\n");
+	return 0;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static void TestSamplerCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/**************************************************************************************************************************/
+static int TestSamplerListen(int port)
+{
+	CommEvTCPServerConf conf_plain;
+	int plain_lid;
+
+	/* Clean up stack */
+	memset(&conf_plain, 0, sizeof(CommEvTCPServerConf));
+
+	/* Fill in control configuration */
+	conf_plain.bind_method			= COMM_SERVER_BINDANY;
+	conf_plain.read_mthd			= COMM_SERVER_READ_MEMBUFFER;
+	conf_plain.srv_proto			= COMM_SERVERPROTO_PLAIN;
+	conf_plain.port					= port;
+	conf_plain.flags.reuse_addr		= 1;
+	conf_plain.flags.reuse_port		= 1;
+
+	plain_lid = CommEvTCPServerListenerAdd(glob_tcp_srv, &conf_plain);
+
+	if (plain_lid < 0)
+		return plain_lid;
+
+	CommEvTCPServerEventSet(glob_tcp_srv, plain_lid, COMM_SERVER_EVENT_ACCEPT_AFTER, TestSamplerAcceptEvent, NULL);
+	return plain_lid;
+}
+/**************************************************************************************************************************/
+static void TestSamplerRoundsWait(CommEvTCPInfoSampler *sampler, unsigned long round_count)
+{
+	unsigned long round_target = (sampler->stats.rounds + round_count);
+	int i;
+
+	for (i = 0; (i < SAMPLER_SETTLE_LOOPS) && (sampler->stats.rounds < round_target); i++)
+		EvKQBaseDispatchOnce(glob_ev_base, SAMPLER_INTERVAL_MS);
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestSamplerAcceptEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	return;
+}
+/**************************************************************************************************************************/
+static void TestSamplerClientConnectEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	glob_connected_count++;
+	return;
+}
+/**************************************************************************************************************************/
+static void TestSamplerClientCloseEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	glob_closed_count++;
+	return;
+}
+/**************************************************************************************************************************/
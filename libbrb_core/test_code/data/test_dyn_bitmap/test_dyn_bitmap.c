@@ -34,6 +34,16 @@
 
 #include <libbrb_core.h>
 
+#define RANGE_IDX_MAX		(64 * 320)
+#define RANGE_OP_COUNT		4096
+#define RANGE_LEN_MAX		300
+
+static void TestDynBitMapCheck(int cond, char *check_str);
+static void TestDynBitMapRangeEdges(void);
+static void TestDynBitMapRangeRandom(void);
+static long TestDynBitMapRefCount(char *ref_arr, long begin_idx, long finish_idx);
+static long TestDynBitMapRefNext(char *ref_arr, long index, int want_set);
+
 /************************************************************************************************************************/
 int main(int argc, char **argv)
 {
@@ -132,7 +142,180 @@ int main(int argc, char **argv)
 	DynBitMapGenerateStringMap(dyn_bitmap_dump, (char*)&string_mask, (sizeof(string_mask) - 1));
 	printf("Step 2 - DUMP BITMAP STRING MASK [%s]\n", string_mask);
 
+	printf("---------------------------------- [ RANGE / FIND / POPCOUNT / RUN ] ----------------------------------\n");
 
+	TestDynBitMapRangeEdges();
+	TestDynBitMapRangeRandom();
+
+	printf("TEST_DYN_BITMAP - All tests passed\n");
 	return 1;
 }
 /************************************************************************************************************************/
+static void TestDynBitMapCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/************************************************************************************************************************/
+static void TestDynBitMapRangeEdges(void)
+{
+	DynBitMapValidBlockIdx run_idx;
+	DynBitMap *dyn_bitmap;
+
+	dyn_bitmap = DynBitMapNew(BRBDATA_THREAD_UNSAFE, 256);
+
+	/* Empty bitmap */
+	TestDynBitMapCheck((-1 == DynBitMapFindNextSet(dyn_bitmap, 0)), "Empty - FindNextSet misses");
+	TestDynBitMapCheck((0 == DynBitMapFindNextClear(dyn_bitmap, 0)), "Empty - FindNextClear hits first index");
+	TestDynBitMapCheck((0 == DynBitMapPopCountRange(dyn_bitmap, 0, 1000)), "Empty - PopCountRange is zero");
+	TestDynBitMapCheck(((0 == DynBitMapRunNext(dyn_bitmap, 0, &run_idx)) && (-1 == run_idx.first_idx) && (-1 == run_idx.last_idx)), "Empty - RunNext finds nothing");
+
+	/* Empty and invalid ranges touch nothing */
+	TestDynBitMapCheck((0 == DynBitMapBitSetRange(dyn_bitmap, 10, 9)), "Empty range - SetRange changes nothing");
+	TestDynBitMapCheck((0 == DynBitMapBitSetRange(dyn_bitmap, -1, 9)), "Negative range - SetRange changes nothing");
+	TestDynBitMapCheck((0 == DynBitMapBitClearRange(dyn_bitmap, 10, 9)), "Empty range - ClearRange changes nothing");
+	TestDynBitMapCheck((0 == DynBitMapPopCount(dyn_bitmap)), "Empty range - PopCount still zero");
+
+	/* Single bit range on word start */
+	TestDynBitMapCheck((1 == DynBitMapBitSetRange(dyn_bitmap, 0, 0)), "SetRange [0-0] sets one bit");
+	TestDynBitMapCheck((DynBitMapBitTest(dyn_bitmap, 0) && !DynBitMapBitTest(dyn_bitmap, 1)), "SetRange [0-0] sets only bit 0");
+	TestDynBitMapCheck((0 == DynBitMapBitSetRange(dyn_bitmap, 0, 0)), "SetRange [0-0] again changes nothing");
+
+	/* Range crossing word boundary */
+	TestDynBitMapCheck((2 == DynBitMapBitSetRange(dyn_bitmap, 63, 64)), "SetRange [63-64] across word boundary");
+	TestDynBitMapCheck((2 == DynBitMapPopCountRange(dyn_bitmap, 63, 64)), "PopCountRange [63-64] across word boundary");
+	TestDynBitMapCheck((2 == DynBitMapPopCountRange(dyn_bitmap, 62, 65)), "PopCountRange [62-65] trims edge words");
+	TestDynBitMapCheck((1 == DynBitMapPopCountRange(dyn_bitmap, 64, 64)), "PopCountRange [64-64] single bit on word start");
+	TestDynBitMapCheck((63 == DynBitMapFindNextSet(dyn_bitmap, 1)), "FindNextSet reaches last bit of a word");
+	TestDynBitMapCheck((65 == DynBitMapFindNextClear(dyn_bitmap, 63)), "FindNextClear skips run across word boundary");
+	TestDynBitMapCheck((DynBitMapRunNext(dyn_bitmap, 1, &run_idx) && (63 == run_idx.first_idx) && (64 == run_idx.last_idx)), "RunNext [63-64] across word boundary");
+
+	/* Exactly one whole word */
+	TestDynBitMapCheck((64 == DynBitMapBitSetRange(dyn_bitmap, 128, 191)), "SetRange [128-191] whole word");
+	TestDynBitMapCheck((64 == DynBitMapPopCountRange(dyn_bitmap, 127, 192)), "PopCountRange [127-192] whole word plus neighbours");
+	TestDynBitMapCheck((192 == DynBitMapFindNextClear(dyn_bitmap, 128)), "FindNextClear right after whole word");
+	TestDynBitMapCheck((DynBitMapRunNext(dyn_bitmap, 65, &run_idx) && (128 == run_idx.first_idx) && (191 == run_idx.last_idx)), "RunNext [128-191] whole word");
+
+	/* Overlapping set only counts bits that flipped */
+	TestDynBitMapCheck((28 == DynBitMapBitSetRange(dyn_bitmap, 100, 150)), "SetRange [100-150] counts only new bits");
+	TestDynBitMapCheck(((1 + 2 + 28 + 64) == DynBitMapPopCount(dyn_bitmap)), "PopCount follows range changes");
+
+	/* Clear across word boundaries, only set bits count */
+	TestDynBitMapCheck(((1 + 28 + 1) == DynBitMapBitClearRange(dyn_bitmap, 64, 128)), "ClearRange [64-128] across three words");
+	TestDynBitMapCheck((DynBitMapRunNext(dyn_bitmap, 64, &run_idx) && (129 == run_idx.first_idx) && (191 == run_idx.last_idx)), "RunNext after ClearRange");
+	TestDynBitMapCheck(((1 + 1 + 63) == DynBitMapPopCount(dyn_bitmap)), "PopCount after ClearRange");
+
+	/* Past higher seen everything is clear */
+	TestDynBitMapCheck((0 == DynBitMapBitClearRange(dyn_bitmap, 5000, 6000)), "ClearRange past higher seen changes nothing");
+	TestDynBitMapCheck((0 == DynBitMapPopCountRange(dyn_bitmap, 5000, 6000)), "PopCountRange past higher seen is zero");
+	TestDynBitMapCheck((-1 == DynBitMapFindNextSet(dyn_bitmap, 192)), "FindNextSet past last run misses");
+	TestDynBitMapCheck((5000 == DynBitMapFindNextClear(dyn_bitmap, 5000)), "FindNextClear past higher seen returns index");
+	TestDynBitMapCheck(((0 == DynBitMapRunNext(dyn_bitmap, 192, &run_idx)) && (-1 == run_idx.first_idx)), "RunNext past last run finds nothing");
+
+	/* Clear everything back */
+	TestDynBitMapCheck((65 == DynBitMapBitClearRange(dyn_bitmap, 0, 191)), "ClearRange [0-191] clears all");
+	TestDynBitMapCheck(((0 == DynBitMapPopCount(dyn_bitmap)) && (-1 == DynBitMapFindNextSet(dyn_bitmap, 0))), "Bitmap empty after ClearRange");
+
+	DynBitMapDestroy(dyn_bitmap);
+	return;
+}
+/************************************************************************************************************************/
+static void TestDynBitMapRangeRandom(void)
+{
+	DynBitMapValidBlockIdx run_idx;
+	DynBitMap *dyn_bitmap;
+	char *ref_arr;
+	long begin_idx;
+	long finish_idx;
+	long expected;
+	long index;
+	long mismatch_count;
+	long run_count;
+	int op_count;
+
+	dyn_bitmap	= DynBitMapNew(BRBDATA_THREAD_UNSAFE, 256);
+	ref_arr		= calloc(RANGE_IDX_MAX + 1, sizeof(char));
+
+	/* Random set and clear ranges, checked against a plain byte per bit reference */
+	for (mismatch_count = 0, op_count = 0; op_count < RANGE_OP_COUNT; op_count++)
+	{
+		begin_idx	= (arc4random() % (RANGE_IDX_MAX - RANGE_LEN_MAX));
+		finish_idx	= (begin_idx + (arc4random() % RANGE_LEN_MAX));
+
+		/* Set more than clear, so both long runs and holes show up */
+		if (arc4random() % 3)
+		{
+			expected = ((finish_idx - begin_idx + 1) - TestDynBitMapRefCount(ref_arr, begin_idx, finish_idx));
+			memset(&ref_arr[begin_idx], 1, (finish_idx - begin_idx + 1));
+			mismatch_count += (expected != DynBitMapBitSetRange(dyn_bitmap, begin_idx, finish_idx));
+		}
+		else
+		{
+			expected = TestDynBitMapRefCount(ref_arr, begin_idx, finish_idx);
+			memset(&ref_arr[begin_idx], 0, (finish_idx - begin_idx + 1));
+			mismatch_count += (expected != DynBitMapBitClearRange(dyn_bitmap, begin_idx, finish_idx));
+		}
+
+		mismatch_count += (TestDynBitMapRefCount(ref_arr, 0, RANGE_IDX_MAX) != DynBitMapPopCount(dyn_bitmap));
+
+		/* Probe a random window and a random starting point */
+		begin_idx	= (arc4random() % RANGE_IDX_MAX);
+		finish_idx	= (begin_idx + (arc4random() % RANGE_LEN_MAX));
+		finish_idx	= ((finish_idx > RANGE_IDX_MAX) ? RANGE_IDX_MAX : finish_idx);
+
+		mismatch_count += (TestDynBitMapRefCount(ref_arr, begin_idx, finish_idx) != DynBitMapPopCountRange(dyn_bitmap, begin_idx, finish_idx));
+		mismatch_count += (TestDynBitMapRefNext(ref_arr, begin_idx, 1) != DynBitMapFindNextSet(dyn_bitmap, begin_idx));
+		mismatch_count += (TestDynBitMapRefNext(ref_arr, begin_idx, 0) != DynBitMapFindNextClear(dyn_bitmap, begin_idx));
+	}
+
+	TestDynBitMapCheck((0 == mismatch_count), "Random SetRange, ClearRange, PopCountRange and FindNext match reference");
+
+	/* Walk all runs, they must cover every set bit exactly once */
+	for (mismatch_count = 0, run_count = 0, index = 0; DynBitMapRunNext(dyn_bitmap, index, &run_idx); index = (run_idx.last_idx + 1), run_count++)
+	{
+		mismatch_count += (TestDynBitMapRefNext(ref_arr, index, 1) != run_idx.first_idx);
+		mismatch_count += (TestDynBitMapRefNext(ref_arr, run_idx.first_idx, 0) != (run_idx.last_idx + 1));
+		mismatch_count += ((run_idx.last_idx - run_idx.first_idx + 1) != DynBitMapPopCountRange(dyn_bitmap, run_idx.first_idx, run_idx.last_idx));
+	}
+
+	mismatch_count += (-1 != TestDynBitMapRefNext(ref_arr, index, 1));
+
+	printf("Random ranges - [%d] ops - [%ld] bits set in [%ld] runs\n", op_count, DynBitMapPopCount(dyn_bitmap), run_count);
+	TestDynBitMapCheck((0 == mismatch_count), "RunNext walk matches reference");
+
+	free(ref_arr);
+	DynBitMapDestroy(dyn_bitmap);
+	return;
+}
+/************************************************************************************************************************/
+static long TestDynBitMapRefCount(char *ref_arr, long begin_idx, long finish_idx)
+{
+	long bit_count = 0;
+	long i;
+
+	for (i = begin_idx; i <= finish_idx; i++)
+		bit_count += ref_arr[i];
+
+	return bit_count;
+}
+/************************************************************************************************************************/
+static long TestDynBitMapRefNext(char *ref_arr, long index, int want_set)
+{
+	long i;
+
+	for (i = index; i <= RANGE_IDX_MAX; i++)
+	{
+		if (ref_arr[i] == want_set)
+			return i;
+	}
+
+	/* Everything past reference is clear */
+	return (want_set ? -1 : i);
+}
+/************************************************************************************************************************/
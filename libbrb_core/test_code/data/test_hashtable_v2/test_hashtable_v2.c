@@ -1,5 +1,5 @@
 /*
- * test_assoc_array.c
+ * test_hashtable_v2.c
  *
  *  Created on: 2011-10-11
  *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
@@ -34,219 +34,352 @@
 
 #include <libbrb_data.h>
 
-#define KV_MASK "%s,%s"
-#define HASH_TABLE_SIZE 1024 * 1024
+#define SAMPLE_COUNT		(1024 * 1024)
+#define SAMPLE_KEY_SZ		32
+#define THREAD_COUNT		4
+#define CHECK_COUNT			(64 * 1024)
 
-typedef struct _Sample {
+typedef struct _Sample
+{
 	HashTableV2Item hash_item;
-	char key[256];
-	char value[256];
-
-	BRB_MD5_CTX md5_key;
+	char key[SAMPLE_KEY_SZ];
+	int key_sz;
 } Sample;
 
-HashTableV2 *glob_hash_table;
-
-static int HashPopulate(void);
-static int HashSearch(void);
-
-
-static void SampleDestroy(void *ptr);
-static void SampleShow(Sample *sample_item);
-static Sample *SampleNew(char *key, char *value);
+typedef struct _TestThreadArg
+{
+	HashTableV2 *hash_table;
+	Sample *sample_arr;
+	int sample_begin;
+	int sample_end;
+	int miss_count;
+} TestThreadArg;
+
+static Sample *glob_sample_arr;
+
+static void TestHashTableCheck(int cond, char *label, char *check_str);
+static void TestHashTableFunctional(char *label, HashTableConfig *config);
+static void TestHashTableRun(char *label, HashTableConfig *config);
+static void TestHashTableThreadRun(char *label, HashTableConfig *config);
+static void *TestHashTableThreadWorker(void *arg_ptr);
+static double TestHashTableTimeNow(void);
 
 /**************************************************************************************************************************/
-static int HashPopulate(void)
+int main(int argc, char *argv[])
 {
-	Sample *sample_item;
-	char key[256];
-	char value[256];
-	unsigned int value_int;
+	HashTableConfig config;
 	int i;
 
-	printf ("Generating hash table with [%u] items\n", HASH_TABLE_SIZE);
+	/* Generate keys once, so all runs hash the same data */
+	glob_sample_arr = calloc(SAMPLE_COUNT, sizeof(Sample));
 
-	for (i = 0; i < HASH_TABLE_SIZE; i++)
-	{
-		value_int = (unsigned int)arc4random() % 10241024;
+	for (i = 0; i < SAMPLE_COUNT; i++)
+		glob_sample_arr[i].key_sz = snprintf(glob_sample_arr[i].key, sizeof(glob_sample_arr[i].key), "teste_key-%08d", i);
+
+	/* Functional checks first - CHAINED, SWISS and SWISS sharded */
+	memset(&config, 0, sizeof(HashTableConfig));
+	config.hashfunc_code		= HASHTABLE_HASHFUNC_MURMUR;
+	config.flags.key_match_sz	= 1;
+	TestHashTableFunctional("CHAINED", &config);
+
+	config.table_mode			= HASHTABLE_MODE_SWISS;
+	TestHashTableFunctional("SWISS", &config);
+
+	config.flags.thread_safe	= 1;
+	config.shard_count			= 1;
+	TestHashTableFunctional("SWISS-MT-1", &config);
 
-		memset(&key, 0, sizeof(key));
-		memset(&value, 0, sizeof(value));
+	config.shard_count			= HASHTABLE_V2_SHARD_DEFAULT;
+	TestHashTableFunctional("SWISS-MT-16", &config);
 
-		sprintf((char*)&key, "teste_key-%08d", value_int);
-		sprintf((char*)&value, "teste_value-%08d", value_int);
+	/* Benchmarks */
+	/* Current chained table, default and largest prime */
+	memset(&config, 0, sizeof(HashTableConfig));
+	config.hashfunc_code		= HASHTABLE_HASHFUNC_MURMUR;
+	config.flags.key_match_sz	= 1;
+	TestHashTableRun("CHAINED-7951", &config);
 
-		/* Create a new sample item */
-		sample_item 		= SampleNew((char*)key, (char*)value);
+	config.max_buckets			= 1024021;
+	TestHashTableRun("CHAINED-1024021", &config);
 
-		/* Clean up stack */
-		memset(&sample_item->md5_key, 0, sizeof(BRB_MD5_CTX));
+	/* SWISS table, starting small so growth is measured */
+	memset(&config, 0, sizeof(HashTableConfig));
+	config.hashfunc_code		= HASHTABLE_HASHFUNC_MURMUR;
+	config.table_mode			= HASHTABLE_MODE_SWISS;
+	config.flags.key_match_sz	= 1;
+	TestHashTableRun("SWISS", &config);
 
-		/* Generate a HASH signature of TABLE NAME */
-		BRB_MD5Init(&sample_item->md5_key);
-		BRB_MD5Update(&sample_item->md5_key, (char*)&key, sizeof(key));
-		BRB_MD5Final(&sample_item->md5_key);
+	/* Thread safe, single lock versus sharded */
+	config.flags.thread_safe	= 1;
+	config.shard_count			= 1;
+	TestHashTableThreadRun("SWISS-MT-1", &config);
 
-		/* Store it into HASH */
-		HashTableV2ItemAdd(glob_hash_table, &sample_item->hash_item, sample_item, (char*)&sample_item->md5_key, sizeof(sample_item->md5_key));
-		continue;
+	config.shard_count			= HASHTABLE_V2_SHARD_DEFAULT;
+	TestHashTableThreadRun("SWISS-MT-16", &config);
+
+	free(glob_sample_arr);
+
+	printf("TEST_HASHTABLE_V2 - All tests passed\n");
+	return 0;
+}
+/**************************************************************************************************************************/
+static void TestHashTableCheck(int cond, char *label, char *check_str)
+{
+	if (!cond)
+	{
+		printf("[%-16s] - FAILED - %s\n", label, check_str);
+		abort();
 	}
 
-	return 1;
+	return;
 }
 /**************************************************************************************************************************/
-static int HashSearch(void)
+static void TestHashTableFunctional(char *label, HashTableConfig *config)
 {
-	Sample *sample_item;
-	Sample *sample_item_ptr;
-	struct timeval current_time;
+	HashTableConfig check_config;
 	HashTableV2Item *hash_item;
-	long int begin_cur_time;
-	long int begin_cur_microtime;
-	long int finish_cur_time;
-	long int finish_cur_microtime;
-
-	BRB_MD5_CTX md5_key;
-	char key[256];
-	unsigned int value_int;
+	HashTableV2 *hash_table;
+	Sample dup_sample;
+	char miss_key[SAMPLE_KEY_SZ];
+	int miss_key_sz;
+	int fail_count;
 	int i;
 
-	printf ("Searching on hash table..\n");
+	/* Same config, refusing duplicates */
+	memcpy(&check_config, config, sizeof(HashTableConfig));
+	check_config.flags.item_check_dup = 1;
 
-	for (i = 0; i < HASH_TABLE_SIZE; i++)
-	{
-		//value_int = ((unsigned int)arc4random() % (HASH_TABLE_SIZE - 1));
-		value_int = (unsigned int)arc4random() % 10241024;
+	hash_table = HashTableV2New(&check_config);
 
-		memset(&key, 0, sizeof(key));
+	/* Explicit shard count must be honored, including a single shard */
+	if (HASHTABLE_MODE_SWISS == check_config.table_mode)
+		TestHashTableCheck((hash_table->swiss.shard_count == (check_config.shard_count > 0 ? check_config.shard_count : 1)), label, "shard count");
 
-		sprintf((char*)&key, "teste_key-%08X", value_int);
+	/* Insert, SWISS starts small so this goes through several grow and migrate cycles */
+	for (fail_count = 0, i = 0; i < CHECK_COUNT; i++)
+		if (!HashTableV2ItemAdd(hash_table, &glob_sample_arr[i].hash_item, &glob_sample_arr[i], glob_sample_arr[i].key, glob_sample_arr[i].key_sz))
+			fail_count++;
 
-		/* Benchmark */
-		gettimeofday(&current_time, NULL);
-		begin_cur_time = current_time.tv_sec;
-		begin_cur_microtime =  current_time.tv_usec;
+	TestHashTableCheck((fail_count == 0), label, "insert");
+	TestHashTableCheck((HashTableV2ItemCount(hash_table) == CHECK_COUNT), label, "count after insert");
 
-		printf("Looking up key: [%s]...\n ", key);
+	/* Duplicate key is refused and count stays */
+	memset(&dup_sample, 0, sizeof(Sample));
+	dup_sample.key_sz = snprintf(dup_sample.key, sizeof(dup_sample.key), "%s", glob_sample_arr[CHECK_COUNT / 2].key);
 
-		/* Clean up stack */
-		memset(&md5_key, 0, sizeof(BRB_MD5_CTX));
+	TestHashTableCheck((!HashTableV2ItemAdd(hash_table, &dup_sample.hash_item, &dup_sample, dup_sample.key, dup_sample.key_sz)), label, "duplicate refused");
+	TestHashTableCheck((HashTableV2ItemCount(hash_table) == CHECK_COUNT), label, "count after duplicate");
 
-		/* Generate a HASH signature of TABLE NAME */
-		BRB_MD5Init(&md5_key);
-		BRB_MD5Update(&md5_key, (char*)&key, sizeof(key));
-		BRB_MD5Final(&md5_key);
+	/* Every key finds its own item and data */
+	for (fail_count = 0, i = 0; i < CHECK_COUNT; i++)
+	{
+		hash_item = HashTableV2ItemFind(hash_table, glob_sample_arr[i].key, glob_sample_arr[i].key_sz);
 
-		/* Do the lookup */
-		hash_item 			= HashTableV2ItemFind(glob_hash_table, (char*)&md5_key.digest, sizeof(md5_key.digest));
+		if ((hash_item != &glob_sample_arr[i].hash_item) || (hash_item->data_ptr != &glob_sample_arr[i]))
+			fail_count++;
+	}
 
-		/* Do the lookup */
-//		hash_item 			= HashTableV2ItemFind(glob_hash_table, (char*)&key, sizeof(key));
-		sample_item_ptr 	= (hash_item ? hash_item->data_ptr : NULL);
+	TestHashTableCheck((fail_count == 0), label, "lookup hit");
 
-		/* Benchmark */
-		gettimeofday(&current_time, NULL);
-		finish_cur_time = current_time.tv_sec;
-		finish_cur_microtime =  current_time.tv_usec;
+	/* Keys never inserted are not found */
+	for (fail_count = 0, i = 0; i < CHECK_COUNT; i++)
+	{
+		miss_key_sz = snprintf(miss_key, sizeof(miss_key), "teste_miss-%08d", i);
+
+		if (HashTableV2ItemFind(hash_table, miss_key, miss_key_sz))
+			fail_count++;
+	}
 
-		if (sample_item_ptr)
-		{
-			printf("Found! Value is [%p] - Bucket_id [%d] bucket items [%lu] | Took [%ld - %ld]\n",
-					sample_item_ptr,  hash_item->bucket->id, hash_item->bucket->list.size, (finish_cur_time - begin_cur_time), (finish_cur_microtime - begin_cur_microtime));
+	TestHashTableCheck((fail_count == 0), label, "lookup miss");
 
-			SampleShow(sample_item_ptr);
-			HashTableV2ItemDel(glob_hash_table, hash_item);
-			SampleDestroy(sample_item_ptr);
-			abort();
-		}
-		else
-		{
-			printf("Not found!                             - Took [%ld - %ld]\n", (finish_cur_time - begin_cur_time), (finish_cur_microtime - begin_cur_microtime));
-		}
+	/* Remove even items, second remove of same item must fail */
+	for (fail_count = 0, i = 0; i < CHECK_COUNT; i += 2)
+	{
+		if (!HashTableV2ItemDel(hash_table, &glob_sample_arr[i].hash_item))
+			fail_count++;
 
-		continue;
+		if (HashTableV2ItemDel(hash_table, &glob_sample_arr[i].hash_item))
+			fail_count++;
 	}
 
+	TestHashTableCheck((fail_count == 0), label, "remove");
+	TestHashTableCheck((HashTableV2ItemCount(hash_table) == (CHECK_COUNT / 2)), label, "count after remove");
+
+	/* Walk all keys, only odd ones are left */
+	for (fail_count = 0, i = 0; i < CHECK_COUNT; i++)
+	{
+		hash_item = HashTableV2ItemFind(hash_table, glob_sample_arr[i].key, glob_sample_arr[i].key_sz);
+
+		if ((i % 2) ? (hash_item != &glob_sample_arr[i].hash_item) : (hash_item != NULL))
+			fail_count++;
+	}
 
+	TestHashTableCheck((fail_count == 0), label, "lookup after remove");
 
-	return 1;
+	/* Insert even items back, reusing tombstones */
+	for (fail_count = 0, i = 0; i < CHECK_COUNT; i += 2)
+		if (!HashTableV2ItemAdd(hash_table, &glob_sample_arr[i].hash_item, &glob_sample_arr[i], glob_sample_arr[i].key, glob_sample_arr[i].key_sz))
+			fail_count++;
+
+	TestHashTableCheck((fail_count == 0), label, "reinsert");
+	TestHashTableCheck((HashTableV2ItemCount(hash_table) == CHECK_COUNT), label, "count after reinsert");
+
+	/* Remove all */
+	for (fail_count = 0, i = 0; i < CHECK_COUNT; i++)
+		if (!HashTableV2ItemDel(hash_table, &glob_sample_arr[i].hash_item))
+			fail_count++;
+
+	TestHashTableCheck((fail_count == 0), label, "remove all");
+	TestHashTableCheck((HashTableV2ItemCount(hash_table) == 0), label, "count after remove all");
+
+	printf("[%-16s] - OK - insert, duplicate, lookup, remove and reinsert of [%d] items\n", label, CHECK_COUNT);
+
+	HashTableV2Destroy(hash_table);
+	return;
 }
 /**************************************************************************************************************************/
-int main(void)
+static void TestHashTableRun(char *label, HashTableConfig *config)
 {
-	HashTableV2Item *hash_item;
-	HashTableConfig hash_cfg;
-
-	struct timeval current_time;
-	long int begin_cur_time;
-	long int begin_cur_microtime;
-	long int finish_cur_time;
-	long int finish_cur_microtime;
-	Sample *sample_item;
-	Sample *sample_item_ptr;
+	HashTableV2 *hash_table;
+	char miss_key[SAMPLE_KEY_SZ];
+	double begin_time;
+	double op_time;
+	double insert_time;
+	double insert_max_time;
+	double hit_time;
+	double miss_time;
+	double del_time;
+	int miss_key_sz;
+	int found_count;
 	int i;
-	unsigned int value_int;
-	char key[256];
-	char value[256];
 
-	/* Create new HASH TABLE CONFIGURATION */
-	memset(&hash_cfg, 0, sizeof(HashTableConfig));
-	hash_cfg.flags.thread_safe = 1;
+	hash_table		= HashTableV2New(config);
+	insert_max_time	= 0;
+	begin_time		= TestHashTableTimeNow();
+
+	/* Insert, tracking slowest single insert to spot resize pauses */
+	for (i = 0; i < SAMPLE_COUNT; i++)
+	{
+		op_time = TestHashTableTimeNow();
+		HashTableV2ItemAdd(hash_table, &glob_sample_arr[i].hash_item, &glob_sample_arr[i], glob_sample_arr[i].key, glob_sample_arr[i].key_sz);
+		op_time = (TestHashTableTimeNow() - op_time);
 
-	/* Create new HASH TABLE */
-	glob_hash_table 	= HashTableV2New(&hash_cfg);
-//	glob_hash_table 	= HashTableV2New(NULL);
+		if (op_time > insert_max_time)
+			insert_max_time = op_time;
+	}
 
-	/* Benchmark */
-	gettimeofday(&current_time, NULL);
-	begin_cur_time = current_time.tv_sec;
-	begin_cur_microtime =  current_time.tv_usec;
+	insert_time = (TestHashTableTimeNow() - begin_time);
+	begin_time	= TestHashTableTimeNow();
 
-	/* Begin populating the hash table */
-	HashPopulate();
+	/* Lookups that hit */
+	for (found_count = 0, i = 0; i < SAMPLE_COUNT; i++)
+		if (HashTableV2ItemFind(hash_table, glob_sample_arr[i].key, glob_sample_arr[i].key_sz))
+			found_count++;
 
-	/* Benchmark */
-	gettimeofday(&current_time, NULL);
-	finish_cur_time = current_time.tv_sec;
-	finish_cur_microtime =  current_time.tv_usec;
+	hit_time	= (TestHashTableTimeNow() - begin_time);
+	begin_time	= TestHashTableTimeNow();
 
-	printf ("Finished generatin hash table - Took [%ld] \n", (finish_cur_time - begin_cur_time) );
-	getchar();
+	/* Lookups that miss */
+	for (i = 0; i < SAMPLE_COUNT; i++)
+	{
+		miss_key_sz = snprintf(miss_key, sizeof(miss_key), "teste_miss-%08d", i);
 
+		if (HashTableV2ItemFind(hash_table, miss_key, miss_key_sz))
+			found_count = -1;
+	}
 
-	HashSearch();
-	getchar();
-	HashTableV2Destroy(glob_hash_table);
-	getchar();
+	miss_time	= (TestHashTableTimeNow() - begin_time);
+	begin_time	= TestHashTableTimeNow();
 
-	//AssocArrayDebugShow(assoc_arr, stdout);
+	printf("[%-16s] - ITEMS [%lu] - FOUND [%d] - INSERT [%.3f] sec (max single [%.3f] ms) - HIT [%.3f] sec - MISS [%.3f] sec",
+			label, HashTableV2ItemCount(hash_table), found_count, insert_time, (insert_max_time * 1000), hit_time, miss_time);
 
-	return 0;
-}
-/**************************************************************************************************************************/
-/**/
-/**/
-/**************************************************************************************************************************/
-static void SampleDestroy(void *ptr)
-{
-	BRB_FREE(ptr);
+	/* Delete all */
+	for (i = 0; i < SAMPLE_COUNT; i++)
+		HashTableV2ItemDel(hash_table, &glob_sample_arr[i].hash_item);
+
+	del_time = (TestHashTableTimeNow() - begin_time);
+
+	printf(" - DELETE [%.3f] sec - LEFT [%lu]\n", del_time, HashTableV2ItemCount(hash_table));
+
+	HashTableV2Destroy(hash_table);
+	return;
 }
 /**************************************************************************************************************************/
-static void SampleShow(Sample *sample_item)
+static void TestHashTableThreadRun(char *label, HashTableConfig *config)
 {
-	printf("SampleShow - item_key = [%s] - item_value = [%s]\n", sample_item->key, sample_item->value);
+	TestThreadArg thread_arg[THREAD_COUNT];
+	pthread_t thread_id[THREAD_COUNT];
+	HashTableV2 *hash_table;
+	double begin_time;
+	int miss_count;
+	int slice_sz;
+	int i;
+
+	hash_table	= HashTableV2New(config);
+	slice_sz	= (SAMPLE_COUNT / THREAD_COUNT);
+	begin_time	= TestHashTableTimeNow();
+
+	/* Each thread inserts, looks up and deletes its own slice of keys */
+	for (i = 0; i < THREAD_COUNT; i++)
+	{
+		thread_arg[i].hash_table	= hash_table;
+		thread_arg[i].sample_arr	= glob_sample_arr;
+		thread_arg[i].sample_begin	= (i * slice_sz);
+		thread_arg[i].sample_end	= ((i + 1) * slice_sz);
+		thread_arg[i].miss_count	= 0;
+
+		pthread_create(&thread_id[i], NULL, TestHashTableThreadWorker, &thread_arg[i]);
+	}
+
+	for (miss_count = 0, i = 0; i < THREAD_COUNT; i++)
+	{
+		pthread_join(thread_id[i], NULL);
+		miss_count += thread_arg[i].miss_count;
+	}
+
+	/* Every thread must see all of its own keys, and leave nothing behind */
+	TestHashTableCheck((miss_count == 0), label, "thread lookup");
+	TestHashTableCheck((HashTableV2ItemCount(hash_table) == 0), label, "thread count after delete");
+
+	printf("[%-16s] - THREADS [%d] - ITEMS [%d] - INSERT+HIT+DELETE [%.3f] sec - LEFT [%lu]\n",
+			label, THREAD_COUNT, SAMPLE_COUNT, (TestHashTableTimeNow() - begin_time), HashTableV2ItemCount(hash_table));
+
+	HashTableV2Destroy(hash_table);
+	return;
 }
 /**************************************************************************************************************************/
-static Sample *SampleNew(char *key, char *value)
+static void *TestHashTableThreadWorker(void *arg_ptr)
 {
-	Sample *sample_item;
+	TestThreadArg *thread_arg = arg_ptr;
+	Sample *sample_ptr;
+	int i;
 
-	sample_item = (Sample*)calloc(1,sizeof(Sample));
+	for (i = thread_arg->sample_begin; i < thread_arg->sample_end; i++)
+	{
+		sample_ptr = &thread_arg->sample_arr[i];
+		HashTableV2ItemAdd(thread_arg->hash_table, &sample_ptr->hash_item, sample_ptr, sample_ptr->key, sample_ptr->key_sz);
+	}
 
-	strcpy((char*)&sample_item->key, key);
-	strcpy((char*)&sample_item->value, value);
+	for (i = thread_arg->sample_begin; i < thread_arg->sample_end; i++)
+	{
+		sample_ptr = &thread_arg->sample_arr[i];
+
+		if (HashTableV2ItemFind(thread_arg->hash_table, sample_ptr->key, sample_ptr->key_sz) != &sample_ptr->hash_item)
+			thread_arg->miss_count++;
+	}
 
-	return sample_item;
+	for (i = thread_arg->sample_begin; i < thread_arg->sample_end; i++)
+		HashTableV2ItemDel(thread_arg->hash_table, &thread_arg->sample_arr[i].hash_item);
+
+	return NULL;
 }
 /**************************************************************************************************************************/
+static double TestHashTableTimeNow(void)
+{
+	struct timeval current_time;
 
+	gettimeofday(&current_time, NULL);
+	return (current_time.tv_sec + (current_time.tv_usec / 1000000.0));
+}
+/**************************************************************************************************************************/
@@ -0,0 +1,397 @@
+/*
+ * test_mem_arena_mt.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_core.h>
+
+#define THREAD_COUNT		8
+#define ARENA_SLOT_COUNT	128
+#define HOLD_COUNT			256
+#define ROUND_COUNT			2000
+#define RING_SZ				512
+#define ID_TRACK_MAX		(1024 * 1024)
+#define SHARED_ID_BASE		(4 * 1024 * 1024)
+#define SHARED_ID_COUNT		(16 * 1024)
+#define LOCK_LOOP_COUNT		(64 * 1024)
+
+/* Single producer / single consumer ring, thread N hands IDs over to thread N+1 so frees are really remote */
+typedef struct _TestIDRing
+{
+	long id_arr[RING_SZ];
+	unsigned long head;
+	unsigned long tail;
+} TestIDRing;
+
+typedef struct _TestThreadArg
+{
+	pthread_t thread_id;
+	int thread_idx;
+	long grab_count;
+	long release_count;
+	long remote_count;
+	long error_count;
+} TestThreadArg;
+
+static MemArena *glob_arena;
+static TestIDRing glob_ring_arr[THREAD_COUNT];
+static int *glob_owner_arr;
+
+static void TestArenaCheck(int cond, char *check_str);
+static void TestArenaLockCheck(void);
+static void TestArenaMagazineCheck(void);
+static void *TestArenaThreadWorker(void *arg_ptr);
+static void *TestArenaSharedWorker(void *arg_ptr);
+static int TestArenaSlotVerify(TestThreadArg *thread_arg, long id, int owner_idx);
+static int TestArenaRingPush(TestIDRing *ring, long id);
+static long TestArenaRingPop(TestIDRing *ring);
+
+/**************************************************************************************************************************/
+int main(int argc, char **argv)
+{
+	TestThreadArg thread_arg[THREAD_COUNT];
+	long grab_count;
+	long release_count;
+	long remote_count;
+	long error_count;
+	long live_count;
+	long owner_count;
+	long id_next;
+	long id;
+	int i;
+
+	glob_arena		= MemArenaNew(16, sizeof(long), ARENA_SLOT_COUNT, MEMARENA_MT_CONCURRENT);
+	glob_owner_arr	= calloc(ID_TRACK_MAX, sizeof(int));
+
+	TestArenaCheck((glob_arena && glob_arena->flags.concurrent), "Concurrent arena created");
+
+	/* Lock and unlock on a page nobody created must fail, not crash */
+	TestArenaCheck((-1 == MemArenaLockByID(glob_arena, SHARED_ID_BASE)), "Lock on missing page returns error");
+	TestArenaCheck((-1 == MemArenaUnlockByID(glob_arena, SHARED_ID_BASE)), "Unlock on missing page returns error");
+
+	/* Stress magazines - Grab, verify, release locally and hand over to neighbour for remote release */
+	for (i = 0; i < THREAD_COUNT; i++)
+	{
+		memset(&thread_arg[i], 0, sizeof(TestThreadArg));
+		thread_arg[i].thread_idx = i;
+		pthread_create(&thread_arg[i].thread_id, NULL, TestArenaThreadWorker, &thread_arg[i]);
+	}
+
+	for (grab_count = 0, release_count = 0, remote_count = 0, error_count = 0, i = 0; i < THREAD_COUNT; i++)
+	{
+		pthread_join(thread_arg[i].thread_id, NULL);
+
+		grab_count		+= thread_arg[i].grab_count;
+		release_count	+= thread_arg[i].release_count;
+		remote_count	+= thread_arg[i].remote_count;
+		error_count		+= thread_arg[i].error_count;
+	}
+
+	/* Consumers may have finished before their producers, drain what is left on rings */
+	for (i = 0; i < THREAD_COUNT; i++)
+	{
+		while ((id = TestArenaRingPop(&glob_ring_arr[i])) > -1)
+		{
+			error_count += TestArenaSlotVerify(&thread_arg[i], id, ((i + THREAD_COUNT - 1) % THREAD_COUNT));
+			MemArenaSlotRelease(glob_arena, -1, id);
+			release_count++;
+			remote_count++;
+		}
+	}
+
+	id_next = glob_arena->concurrent.id_next;
+
+	/* Nothing may be left in use, neither on arena nor on our own ownership map */
+	for (live_count = 0, owner_count = 0, id = 0; id < id_next; id++)
+	{
+		live_count	+= (MemArenaFindByID(glob_arena, id) ? 1 : 0);
+		owner_count	+= ((id < ID_TRACK_MAX) && glob_owner_arr[id]) ? 1 : 0;
+	}
+
+	printf("MAGAZINES - THREADS [%d] - GRAB [%ld] - RELEASE [%ld] - REMOTE [%ld] - ID_NEXT [%ld] - PAGES [%ld]\n",
+			THREAD_COUNT, grab_count, release_count, remote_count, id_next, MemArenaGetSlotActiveCount(glob_arena));
+
+	TestArenaCheck((0 == error_count), "Every grabbed ID was unique and its slot untouched by others");
+	TestArenaCheck((grab_count == ((long)THREAD_COUNT * ROUND_COUNT * HOLD_COUNT)), "Grab count matches");
+	TestArenaCheck((grab_count == release_count), "Every grabbed ID was released");
+	TestArenaCheck((remote_count > 0), "Remote frees exercised");
+	TestArenaCheck((0 == live_count), "No slot left in use");
+	TestArenaCheck((0 == owner_count), "No ID left owned");
+
+	/* Freed IDs are reused, so ID space is bounded by what can be in flight, not by grab count */
+	TestArenaCheck((id_next <= ((long)THREAD_COUNT * (HOLD_COUNT + (2 * RING_SZ) + MEMARENA_ID_BATCH_SZ))), "Released IDs are reused");
+
+	TestArenaLockCheck();
+	TestArenaMagazineCheck();
+
+	MemArenaDestroy(glob_arena);
+	free(glob_owner_arr);
+
+	printf("TEST_MEM_ARENA_MT - All tests passed\n");
+	return 0;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static void TestArenaCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/**************************************************************************************************************************/
+static void *TestArenaSharedWorker(void *arg_ptr)
+{
+	TestThreadArg *thread_arg = arg_ptr;
+	long *slot_ptr;
+	long id;
+	int i;
+
+	/* IDs interleaved among threads, so all of them race to publish and busy the same pages */
+	for (id = (SHARED_ID_BASE + thread_arg->thread_idx); id < (SHARED_ID_BASE + SHARED_ID_COUNT); id += THREAD_COUNT)
+	{
+		slot_ptr	= MemArenaGrabByID(glob_arena, id);
+		*slot_ptr	= id;
+	}
+
+	/* Hammer busy count of first page, created back on magazine stress, with lock and unlock */
+	for (i = 0; i < LOCK_LOOP_COUNT; i++)
+	{
+		if (1 != MemArenaLockByID(glob_arena, 0))
+			thread_arg->error_count++;
+
+		if (0 != MemArenaUnlockByID(glob_arena, 0))
+			thread_arg->error_count++;
+	}
+
+	for (id = (SHARED_ID_BASE + thread_arg->thread_idx); id < (SHARED_ID_BASE + SHARED_ID_COUNT); id += THREAD_COUNT)
+	{
+		slot_ptr = MemArenaFindByID(glob_arena, id);
+
+		if ((!slot_ptr) || (*slot_ptr != id))
+			thread_arg->error_count++;
+
+		MemArenaReleaseByID(glob_arena, id);
+	}
+
+	return NULL;
+}
+/**************************************************************************************************************************/
+static void TestArenaLockCheck(void)
+{
+	TestThreadArg thread_arg[THREAD_COUNT];
+	MemArenaSlotHeader *header;
+	long error_count;
+	long live_count;
+	long id;
+	int i;
+
+	for (i = 0; i < THREAD_COUNT; i++)
+	{
+		memset(&thread_arg[i], 0, sizeof(TestThreadArg));
+		thread_arg[i].thread_idx = i;
+		pthread_create(&thread_arg[i].thread_id, NULL, TestArenaSharedWorker, &thread_arg[i]);
+	}
+
+	for (error_count = 0, i = 0; i < THREAD_COUNT; i++)
+	{
+		pthread_join(thread_arg[i].thread_id, NULL);
+		error_count += thread_arg[i].error_count;
+	}
+
+	for (live_count = 0, id = SHARED_ID_BASE; id < (SHARED_ID_BASE + SHARED_ID_COUNT); id++)
+		live_count += (MemArenaFindByID(glob_arena, id) ? 1 : 0);
+
+	/* Every lock was paired with an unlock and every slot went back, so first page busy count is back to zero */
+	header = (MemArenaSlotHeader *)glob_arena->concurrent.dir[0][0];
+
+	TestArenaCheck((0 == error_count), "Concurrent grab, find, lock and unlock by ID on shared pages");
+	TestArenaCheck((0 == live_count), "Shared pages left with no slot in use");
+	TestArenaCheck((header && (0 == header->busy_count)), "Page busy count back to zero");
+	return;
+}
+/**************************************************************************************************************************/
+static void TestArenaMagazineCheck(void)
+{
+	int magazine_arr[MEMARENA_MAGAZINE_MAX];
+	int registered_count;
+	int i;
+
+	/* Workers gave their magazines back, so all of them must be available again */
+	for (registered_count = 0, i = 0; i < MEMARENA_MAGAZINE_MAX; i++)
+	{
+		magazine_arr[i] = MemArenaMagazineRegister(glob_arena);
+		registered_count += ((magazine_arr[i] > -1) ? 1 : 0);
+	}
+
+	TestArenaCheck((MEMARENA_MAGAZINE_MAX == registered_count), "All magazines available after workers unregister");
+	TestArenaCheck((-1 == MemArenaMagazineRegister(glob_arena)), "Magazine register fails when all are taken");
+
+	for (i = 0; i < MEMARENA_MAGAZINE_MAX; i++)
+		MemArenaMagazineUnregister(glob_arena, magazine_arr[i]);
+
+	return;
+}
+/**************************************************************************************************************************/
+static void *TestArenaThreadWorker(void *arg_ptr)
+{
+	TestThreadArg *thread_arg	= arg_ptr;
+	TestIDRing *out_ring		= &glob_ring_arr[(thread_arg->thread_idx + 1) % THREAD_COUNT];
+	TestIDRing *in_ring			= &glob_ring_arr[thread_arg->thread_idx];
+	long hold_arr[HOLD_COUNT];
+	long *slot_ptr;
+	long id;
+	int magazine_id;
+	int expected;
+	int round;
+	int i;
+
+	magazine_id = MemArenaMagazineRegister(glob_arena);
+
+	if (magazine_id < 0)
+	{
+		thread_arg->error_count++;
+		return NULL;
+	}
+
+	for (round = 0; round < ROUND_COUNT; round++)
+	{
+		/* Grab a batch, each ID must be exclusively ours and its slot must come clean */
+		for (i = 0; i < HOLD_COUNT; i++)
+		{
+			slot_ptr = MemArenaSlotGrab(glob_arena, magazine_id, &hold_arr[i]);
+			thread_arg->grab_count++;
+
+			if ((!slot_ptr) || (hold_arr[i] < 0) || (hold_arr[i] >= ID_TRACK_MAX))
+			{
+				thread_arg->error_count++;
+				hold_arr[i] = -1;
+				continue;
+			}
+
+			expected = 0;
+
+			if (!__atomic_compare_exchange_n(&glob_owner_arr[hold_arr[i]], &expected, (thread_arg->thread_idx + 1), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+				thread_arg->error_count++;
+
+			if (0 != *slot_ptr)
+				thread_arg->error_count++;
+
+			*slot_ptr = (hold_arr[i] + 1);
+		}
+
+		/* Release what neighbour handed over to us - Remote frees into its magazine */
+		while ((id = TestArenaRingPop(in_ring)) > -1)
+		{
+			thread_arg->error_count += TestArenaSlotVerify(thread_arg, id, ((thread_arg->thread_idx + THREAD_COUNT - 1) % THREAD_COUNT));
+			MemArenaSlotRelease(glob_arena, magazine_id, id);
+			thread_arg->release_count++;
+			thread_arg->remote_count++;
+		}
+
+		/* Odd ones go to neighbour while there is room, the rest is released locally */
+		for (i = 0; i < HOLD_COUNT; i++)
+		{
+			if (hold_arr[i] < 0)
+				continue;
+
+			if ((i & 1) && TestArenaRingPush(out_ring, hold_arr[i]))
+				continue;
+
+			thread_arg->error_count += TestArenaSlotVerify(thread_arg, hold_arr[i], thread_arg->thread_idx);
+			MemArenaSlotRelease(glob_arena, magazine_id, hold_arr[i]);
+			thread_arg->release_count++;
+		}
+	}
+
+	MemArenaMagazineUnregister(glob_arena, magazine_id);
+	return NULL;
+}
+/**************************************************************************************************************************/
+static int TestArenaSlotVerify(TestThreadArg *thread_arg, long id, int owner_idx)
+{
+	long *slot_ptr;
+	int expected;
+	int error_count = 0;
+
+	slot_ptr = MemArenaFindByID(glob_arena, id);
+
+	/* Slot must be in use and still carry what owner wrote */
+	if ((!slot_ptr) || (*slot_ptr != (id + 1)))
+		error_count++;
+	else
+		*slot_ptr = 0;
+
+	/* Drop ownership before giving ID back, it may be grabbed again right after */
+	expected = (owner_idx + 1);
+
+	if (!__atomic_compare_exchange_n(&glob_owner_arr[id], &expected, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		error_count++;
+
+	return error_count;
+}
+/**************************************************************************************************************************/
+static int TestArenaRingPush(TestIDRing *ring, long id)
+{
+	unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+	unsigned long tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+	/* Ring full */
+	if ((head - tail) >= RING_SZ)
+		return 0;
+
+	ring->id_arr[head % RING_SZ] = id;
+	__atomic_store_n(&ring->head, (head + 1), __ATOMIC_RELEASE);
+	return 1;
+}
+/**************************************************************************************************************************/
+static long TestArenaRingPop(TestIDRing *ring)
+{
+	unsigned long tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	long id;
+
+	/* Ring empty */
+	if (tail == head)
+		return -1;
+
+	id = ring->id_arr[tail % RING_SZ];
+	__atomic_store_n(&ring->tail, (tail + 1), __ATOMIC_RELEASE);
+	return id;
+}
+/**************************************************************************************************************************/
@@ -0,0 +1,154 @@
+/*
+ * test_mem_buf_grow.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_data.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define BODY_TOTAL_SZ	(10 * 1024 * 1024)
+#define BODY_CHUNK_SZ	1024
+#define BODY_ROUNDS		8
+#define SMALL_ROUNDS	1000000
+#define SMALL_CHUNK_SZ	200
+
+static void TestMemBufAppendRun(MemBufferGrowPolicy grow_policy);
+static void TestMemBufSmallRun(void);
+static double TestMemBufTimeNow(void);
+
+/**************************************************************************************************************************/
+int main(int argc, char *argv[])
+{
+	pid_t child_pid;
+
+	/* Run each policy on its own process, so peak RSS of one does not hide the other */
+	child_pid = fork();
+
+	if (0 == child_pid)
+	{
+		TestMemBufAppendRun(MEMBUFFER_GROW_LINEAR);
+		exit(0);
+	}
+
+	waitpid(child_pid, NULL, 0);
+	child_pid = fork();
+
+	if (0 == child_pid)
+	{
+		TestMemBufAppendRun(MEMBUFFER_GROW_GEOMETRIC);
+		exit(0);
+	}
+
+	waitpid(child_pid, NULL, 0);
+
+	/* Small buffer churn, served from SLAB */
+	TestMemBufSmallRun();
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static void TestMemBufAppendRun(MemBufferGrowPolicy grow_policy)
+{
+	struct rusage usage;
+	MemBuffer *body_mb;
+	char chunk[BODY_CHUNK_SZ];
+	double begin_time;
+	double elapsed_time;
+	long append_count;
+	long j;
+	int i;
+
+	memset(&chunk, 'A', sizeof(chunk));
+	append_count	= (BODY_TOTAL_SZ / BODY_CHUNK_SZ);
+	begin_time		= TestMemBufTimeNow();
+
+	for (i = 0; i < BODY_ROUNDS; i++)
+	{
+		/* Simulate a 10MB HTTP body arriving in 1KB reads */
+		body_mb = MemBufferNew(BRBDATA_THREAD_UNSAFE, 0);
+		MemBufferGrowPolicySet(body_mb, grow_policy);
+
+		for (j = 0; j < append_count; j++)
+			MemBufferAdd(body_mb, &chunk, sizeof(chunk));
+
+		/* Trim slack left by geometric growth */
+		MemBufferShrinkToFit(body_mb);
+		MemBufferDestroy(body_mb);
+	}
+
+	elapsed_time = (TestMemBufTimeNow() - begin_time);
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf("POLICY [%-9s] - [%d] x [%d] bytes in [%d] byte appends - [%.3f] sec - [%.2f] MB/s - PEAK RSS [%ld] KB\n",
+			((MEMBUFFER_GROW_GEOMETRIC == grow_policy) ? "GEOMETRIC" : "LINEAR"), BODY_ROUNDS, BODY_TOTAL_SZ, BODY_CHUNK_SZ, elapsed_time,
+			(((double)BODY_TOTAL_SZ * BODY_ROUNDS) / (1024 * 1024)) / elapsed_time, usage.ru_maxrss);
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestMemBufSmallRun(void)
+{
+	MemBuffer *small_mb;
+	char chunk[SMALL_CHUNK_SZ];
+	double begin_time;
+	double elapsed_time;
+	int i;
+
+	memset(&chunk, 'B', sizeof(chunk));
+	begin_time = TestMemBufTimeNow();
+
+	/* Short lived small buffers, like headers and log lines */
+	for (i = 0; i < SMALL_ROUNDS; i++)
+	{
+		small_mb = MemBufferNew(BRBDATA_THREAD_UNSAFE, 0);
+		MemBufferAdd(small_mb, &chunk, sizeof(chunk));
+		MemBufferAdd(small_mb, &chunk, sizeof(chunk));
+		MemBufferDestroy(small_mb);
+	}
+
+	elapsed_time = (TestMemBufTimeNow() - begin_time);
+
+	printf("SMALL - [%d] buffers of [%d] bytes - [%.3f] sec - [%.0f] buffers/s\n",
+			SMALL_ROUNDS, (SMALL_CHUNK_SZ * 2), elapsed_time, (SMALL_ROUNDS / elapsed_time));
+
+	return;
+}
+/**************************************************************************************************************************/
+static double TestMemBufTimeNow(void)
+{
+	struct timeval current_time;
+
+	gettimeofday(&current_time, NULL);
+	return (current_time.tv_sec + (current_time.tv_usec / 1000000.0));
+}
+/**************************************************************************************************************************/
@@ -0,0 +1,295 @@
+/*
+ * test_mem_chain.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_core.h>
+
+static void TestMemChainFill(MemChain *mem_chain, unsigned long data_sz, int seed);
+static void TestMemChainSliceZeroCopy(void);
+static void TestMemChainSliceDup(void);
+static void TestMemChainSliceCoalesce(void);
+static void TestMemChainSliceHeap(void);
+static void TestMemChainFindBoundary(void);
+static void TestMemChainFindSplit(const char *token_str, int token_sz, unsigned long drain_sz);
+static long TestMemChainFindRef(const char *flat_buf, unsigned long flat_sz, unsigned long offset, const char *token_str, int token_sz);
+static void TestMemChainCheck(int cond, const char *label_str);
+
+/**************************************************************************************************************************/
+int main(int argc, char *argv[])
+{
+	TestMemChainSliceZeroCopy();
+	TestMemChainSliceDup();
+	TestMemChainSliceCoalesce();
+	TestMemChainSliceHeap();
+	TestMemChainFindBoundary();
+
+	printf("MEM_CHAIN - All tests passed\n");
+	return 0;
+}
+/**************************************************************************************************************************/
+static void TestMemChainSliceZeroCopy(void)
+{
+	MemChain *mem_chain;
+	MemChunk *head_chunk;
+	MemSlice mem_slice;
+
+	mem_chain = MemChainNew();
+	TestMemChainFill(mem_chain, 100, 1);
+
+	head_chunk = mem_chain->head;
+	TestMemChainCheck((1 == head_chunk->ref_count), "ZERO_COPY - Fresh chunk holds one reference");
+
+	/* Slice inside head chunk points into it and takes a reference */
+	TestMemChainCheck(MemChainSlicePop(mem_chain, 10, &mem_slice), "ZERO_COPY - Slice pop");
+	TestMemChainCheck((mem_slice.chunk == head_chunk), "ZERO_COPY - Slice points into head chunk");
+	TestMemChainCheck((!mem_slice.flags.heap), "ZERO_COPY - Slice is not on heap");
+	TestMemChainCheck((2 == head_chunk->ref_count), "ZERO_COPY - Slice retains chunk");
+	TestMemChainCheck((90 == MemChainGetSize(mem_chain)), "ZERO_COPY - Slice consumed from chain");
+
+	/* Releasing slice must drop its reference */
+	MemSliceRelease(&mem_slice);
+	TestMemChainCheck((1 == head_chunk->ref_count), "ZERO_COPY - Release drops chunk reference");
+	TestMemChainCheck((!mem_slice.chunk) && (!mem_slice.data), "ZERO_COPY - Released slice is clean");
+
+	/* Chain drained while slice is alive, slice becomes sole owner */
+	TestMemChainCheck(MemChainSlicePop(mem_chain, 50, &mem_slice), "ZERO_COPY - Second slice pop");
+	MemChainDrain(mem_chain, MemChainGetSize(mem_chain));
+
+	TestMemChainCheck((!mem_chain->head), "ZERO_COPY - Empty chain holds no chunk");
+	TestMemChainCheck((1 == mem_slice.chunk->ref_count), "ZERO_COPY - Slice is sole owner after drain");
+	TestMemChainCheck(((char)((10 * 7) + 1) == mem_slice.data[0]), "ZERO_COPY - Slice data survives drain");
+
+	MemSliceRelease(&mem_slice);
+	MemChainDestroy(mem_chain);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestMemChainSliceDup(void)
+{
+	MemChain *mem_chain;
+	MemChunk *head_chunk;
+	MemSlice mem_slice;
+	MemSlice dup_slice;
+
+	mem_chain = MemChainNew();
+	TestMemChainFill(mem_chain, 1000, 2);
+	head_chunk = mem_chain->head;
+
+	MemChainSlicePop(mem_chain, 100, &mem_slice);
+	MemSliceDup(&mem_slice, &dup_slice);
+
+	TestMemChainCheck((dup_slice.chunk == head_chunk), "DUP - Duplicate shares chunk");
+	TestMemChainCheck((3 == head_chunk->ref_count), "DUP - Duplicate retains chunk");
+
+	MemSliceRelease(&mem_slice);
+	TestMemChainCheck((2 == head_chunk->ref_count), "DUP - Release first slice");
+
+	MemSliceRelease(&dup_slice);
+	TestMemChainCheck((1 == head_chunk->ref_count), "DUP - Release duplicate");
+
+	MemChainDestroy(mem_chain);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestMemChainSliceCoalesce(void)
+{
+	MemChain *mem_chain;
+	MemChunk *head_chunk;
+	MemChunk *next_chunk;
+	MemSlice mem_slice;
+	char expect_buf[64];
+	int i;
+
+	mem_chain = MemChainNew();
+	TestMemChainFill(mem_chain, (MEMCHAIN_CHUNK_SZ + 100), 3);
+
+	/* Leave 20 bytes on head, so a 64 bytes slice crosses into next chunk */
+	MemChainDrain(mem_chain, (MEMCHAIN_CHUNK_SZ - 20));
+	MemChainPeek(mem_chain, 0, &expect_buf, sizeof(expect_buf));
+
+	head_chunk = mem_chain->head;
+	next_chunk = head_chunk->next;
+
+	TestMemChainCheck(MemChainSlicePop(mem_chain, sizeof(expect_buf), &mem_slice), "COALESCE - Slice pop");
+	TestMemChainCheck((mem_slice.chunk != head_chunk) && (mem_slice.chunk != next_chunk), "COALESCE - Slice on private chunk");
+	TestMemChainCheck((1 == mem_slice.chunk->ref_count), "COALESCE - Private chunk has single reference");
+	TestMemChainCheck((1 == next_chunk->ref_count), "COALESCE - Source chunk not retained");
+
+	for (i = 0; i < sizeof(expect_buf); i++)
+		TestMemChainCheck((expect_buf[i] == mem_slice.data[i]), "COALESCE - Slice data matches chain");
+
+	MemSliceRelease(&mem_slice);
+	MemChainDestroy(mem_chain);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestMemChainSliceHeap(void)
+{
+	MemChain *mem_chain;
+	MemSlice mem_slice;
+	int i;
+
+	mem_chain = MemChainNew();
+	TestMemChainFill(mem_chain, (MEMCHAIN_CHUNK_SZ * 3), 4);
+
+	/* Bigger than a chunk goes to HEAP and retains nothing */
+	TestMemChainCheck(MemChainSlicePop(mem_chain, (MEMCHAIN_CHUNK_SZ * 2), &mem_slice), "HEAP - Slice pop");
+	TestMemChainCheck((mem_slice.flags.heap) && (!mem_slice.chunk), "HEAP - Slice on heap");
+	TestMemChainCheck((1 == mem_chain->head->ref_count), "HEAP - Remaining chunk not retained");
+
+	for (i = 0; i < (MEMCHAIN_CHUNK_SZ * 2); i++)
+		TestMemChainCheck(((char)((i * 7) + 4) == mem_slice.data[i]), "HEAP - Slice data matches");
+
+	MemSliceRelease(&mem_slice);
+	TestMemChainCheck((!mem_slice.data) && (!mem_slice.flags.heap), "HEAP - Released slice is clean");
+
+	MemChainDestroy(mem_chain);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestMemChainFindBoundary(void)
+{
+	/* Tokens of 2, 4 and 7 bytes, with chain head at start of a chunk or partially drained */
+	TestMemChainFindSplit("\r\n", 2, 0);
+	TestMemChainFindSplit("\r\n\r\n", 4, 0);
+	TestMemChainFindSplit("\r\n\r\n", 4, 37);
+	TestMemChainFindSplit("BOUNDRY", 7, 0);
+	TestMemChainFindSplit("BOUNDRY", 7, (MEMCHAIN_CHUNK_SZ - 3));
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestMemChainFindSplit(const char *token_str, int token_sz, unsigned long drain_sz)
+{
+	unsigned long flat_sz = (MEMCHAIN_CHUNK_SZ * 3) + 100;
+	char *flat_buf = malloc(flat_sz);
+	unsigned long boundary_off;
+	unsigned long plant_off;
+	unsigned long chain_sz;
+	MemChain *mem_chain;
+	long expect_off;
+	long found_off;
+	int split;
+
+	for (split = 1; split < token_sz; split++)
+	{
+		/* Filler never holds a token byte - Plant a full token across each chunk boundary, split SPLIT bytes before it */
+		memset(flat_buf, '.', flat_sz);
+
+		for (boundary_off = MEMCHAIN_CHUNK_SZ; boundary_off < flat_sz; boundary_off += MEMCHAIN_CHUNK_SZ)
+			memcpy(&flat_buf[boundary_off - split], token_str, token_sz);
+
+		/* Near miss past first boundary, all but last token byte */
+		memcpy(&flat_buf[MEMCHAIN_CHUNK_SZ + 50 - split], token_str, (token_sz - 1));
+
+		mem_chain = MemChainNew();
+		MemChainAdd(mem_chain, flat_buf, flat_sz);
+		MemChainDrain(mem_chain, drain_sz);
+		chain_sz = MemChainGetSize(mem_chain);
+
+		TestMemChainCheck((mem_chain->chunk_count >= 3), "FIND - Chain spans several chunks");
+
+		/* Each planted token must be found from any offset before it, and at its own offset */
+		for (boundary_off = MEMCHAIN_CHUNK_SZ; boundary_off < flat_sz; boundary_off += MEMCHAIN_CHUNK_SZ)
+		{
+			if ((boundary_off - split) < drain_sz)
+				continue;
+
+			plant_off	= (boundary_off - split - drain_sz);
+			found_off	= MemChainFind(mem_chain, plant_off, token_str, token_sz);
+			TestMemChainCheck((found_off == (long)plant_off), "FIND - Token split across chunk boundary");
+
+			found_off	= MemChainFind(mem_chain, ((plant_off > 20) ? (plant_off - 20) : 0), token_str, token_sz);
+			expect_off	= TestMemChainFindRef(flat_buf + drain_sz, chain_sz, ((plant_off > 20) ? (plant_off - 20) : 0), token_str, token_sz);
+			TestMemChainCheck((found_off == expect_off) && (found_off == (long)plant_off), "FIND - Token found from before boundary");
+
+			/* One byte past token start must skip to next planted token, or none */
+			found_off	= MemChainFind(mem_chain, (plant_off + 1), token_str, token_sz);
+			expect_off	= TestMemChainFindRef(flat_buf + drain_sz, chain_sz, (plant_off + 1), token_str, token_sz);
+			TestMemChainCheck((found_off == expect_off), "FIND - Search past token matches scalar");
+		}
+
+		/* Token cut short by end of chain is not a match - Keep all but last byte of token planted on third boundary */
+		MemChainTruncate(mem_chain, ((MEMCHAIN_CHUNK_SZ * 3) - split + (token_sz - 1) - drain_sz));
+		chain_sz	= MemChainGetSize(mem_chain);
+		found_off	= MemChainFind(mem_chain, (chain_sz > 40) ? (chain_sz - 40) : 0, token_str, token_sz);
+		expect_off	= TestMemChainFindRef(flat_buf + drain_sz, chain_sz, (chain_sz > 40) ? (chain_sz - 40) : 0, token_str, token_sz);
+		TestMemChainCheck((found_off == expect_off) && (found_off < 0), "FIND - Partial token at chain end");
+
+		MemChainDestroy(mem_chain);
+	}
+
+	printf("OK - FIND - TOKEN [%d] bytes - DRAIN [%lu] - All splits\n", token_sz, drain_sz);
+
+	free(flat_buf);
+	return;
+}
+/**************************************************************************************************************************/
+static long TestMemChainFindRef(const char *flat_buf, unsigned long flat_sz, unsigned long offset, const char *token_str, int token_sz)
+{
+	unsigned long i;
+
+	for (i = offset; (i + token_sz) <= flat_sz; i++)
+	{
+		if (!memcmp(&flat_buf[i], token_str, token_sz))
+			return i;
+
+		continue;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+static void TestMemChainFill(MemChain *mem_chain, unsigned long data_sz, int seed)
+{
+	char *data_buf = malloc(data_sz);
+	unsigned long i;
+
+	/* Byte I is (I * 7) + SEED, so any offset can be checked back */
+	for (i = 0; i < data_sz; i++)
+		data_buf[i] = (char)((i * 7) + seed);
+
+	MemChainAdd(mem_chain, data_buf, data_sz);
+	free(data_buf);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestMemChainCheck(int cond, const char *label_str)
+{
+	if (cond)
+		return;
+
+	printf("FAILED - %s\n", label_str);
+	abort();
+}
+/**************************************************************************************************************************/
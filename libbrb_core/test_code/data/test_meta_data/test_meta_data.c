@@ -49,73 +49,284 @@ typedef enum
 	ITEM_LASTITEM
 } ItemCodes;
 
+typedef struct _TestMetaItem
+{
+	unsigned long item_id;
+	unsigned long item_sub_id;
+	void *data_ptr;
+	unsigned long data_sz;
+} TestMetaItem;
+
+static void TestMetaDataPopulate(MetaData *meta_data);
+static void TestMetaDataItemsCheck(MetaData *meta_data, char *check_str);
+static void TestMetaDataViewCheck(MetaDataView *meta_view, char *check_str);
+static void TestMetaDataCorruptCheck(MemBuffer *packed_mb, char *check_str);
+static void TestMetaDataTruncateCheck(MemBuffer *packed_mb, char *check_str);
+static void TestMetaDataCheck(int cond, char *check_str);
+
+GenericStruct glob_struct_arr[2] =
+{
+	{ 500, 99999, 45.66, "aaaaaaaaa" },
+	{ 501, 88888, 12.34, "bbbbbbbbbbbbbbbbb" },
+};
+
+TestMetaItem glob_item_arr[] =
+{
+	{ ITEM_GENERIC_STRUCT,	0,	&glob_struct_arr[0],				sizeof(GenericStruct) },
+	{ ITEM_STRING,			0,	"este eh um item do metadado",		sizeof("este eh um item do metadado") },
+	{ ITEM_STRING,			1,	"oiiiiiiiie",						sizeof("oiiiiiiiie") },
+	{ ITEM_GENERIC_STRUCT,	1,	&glob_struct_arr[1],				sizeof(GenericStruct) },
+	{ ITEM_STRING,			2,	"",									sizeof("") },
+	{ ITEM_STRING,			3,	"sub id bigger than bucket count",	sizeof("sub id bigger than bucket count") },
+};
+
+#define TEST_ITEM_COUNT		(sizeof(glob_item_arr) / sizeof(TestMetaItem))
+
 /************************************************************************************************************************/
 int main(int argc, char **argv)
 {
-	MetaDataItem *meta_item;
+	MetaDataView meta_view;
 	MetaData meta_data_pack;
 	MetaData meta_data_unpack;
-	GenericStruct generic_struct;
-	GenericStruct *generic_struct_ptr;
 	MemBuffer *packed_mb;
-	int i;
-
-	/* Create buffer to hold packed data and PACK */
-	packed_mb = MemBufferNew(BRBDATA_THREAD_UNSAFE, 512);
+	MemBuffer *packed_v2_mb;
+	int op_status;
 
 	/* Clean up stack */
 	memset(&meta_data_pack, 0, sizeof(MetaData));
 	memset(&meta_data_unpack, 0, sizeof(MetaData));
-	memset(&generic_struct, 0, sizeof(GenericStruct));
 
-	/* Populate generic structure */
-	generic_struct.a = 500;
-	generic_struct.b = 99999;
-	generic_struct.c = 45.66;
-	strlcpy(generic_struct.buf, "aaaaaaaaa", sizeof(generic_struct.buf));
+	TestMetaDataPopulate(&meta_data_pack);
+
+	/* V1 - Legacy stream */
+	packed_mb = MemBufferNew(BRBDATA_THREAD_UNSAFE, 512);
+	MetaDataPack(&meta_data_pack, packed_mb);
+	MemBufferWriteToFile(packed_mb, "./metadata.dump");
+
+	op_status = MetaDataUnpack(&meta_data_unpack, packed_mb, NULL);
+	TestMetaDataCheck((METADATA_UNPACK_SUCCESS == op_status), "V1 - Unpack");
+	TestMetaDataItemsCheck(&meta_data_unpack, "V1 - Unpacked items match");
+	TestMetaDataCheck((NULL == meta_data_unpack.view.header), "V1 - Unpack leaves no index");
+	MetaDataClean(&meta_data_unpack);
+
+	TestMetaDataCorruptCheck(packed_mb, "V1 - Corrupted data rejected by MD5");
+	TestMetaDataTruncateCheck(packed_mb, "V1 - Truncated buffer rejected");
+
+	/* V2 - Indexed, checked with CRC32C */
+	packed_v2_mb = MemBufferNew(BRBDATA_THREAD_UNSAFE, 512);
+	MetaDataPackV2(&meta_data_pack, packed_v2_mb, METADATA_CHECKSUM_CRC32C);
+	MemBufferWriteToFile(packed_v2_mb, "./metadata_v2.dump");
+
+	op_status = MetaDataViewOpen(&meta_view, MemBufferDeref(packed_v2_mb), MemBufferGetSize(packed_v2_mb), 1);
+	TestMetaDataCheck((METADATA_UNPACK_SUCCESS == op_status), "V2 - View open in memory");
+	TestMetaDataCheck((METADATA_CHECKSUM_CRC32C == meta_view.header->checksum_type), "V2 - Header carries CRC32C checksum type");
+	TestMetaDataViewCheck(&meta_view, "V2 - In memory view lookups match");
+	MetaDataViewClose(&meta_view);
+
+	/* Read in place from the mapped dump */
+	op_status = MetaDataViewOpenFile(&meta_view, "./metadata_v2.dump", 1);
+	TestMetaDataCheck((METADATA_UNPACK_SUCCESS == op_status), "V2 - View open mapped file");
+	TestMetaDataViewCheck(&meta_view, "V2 - Mapped view lookups match");
+	MetaDataViewClose(&meta_view);
+
+	/* V1 entry point must route V2 to indexed unpack */
+	op_status = MetaDataUnpack(&meta_data_unpack, packed_v2_mb, NULL);
+	TestMetaDataCheck((METADATA_UNPACK_SUCCESS == op_status), "V2 - Unpack");
+	TestMetaDataCheck((NULL != meta_data_unpack.view.header), "V2 - Unpack keeps hashed index");
+	TestMetaDataItemsCheck(&meta_data_unpack, "V2 - Unpacked items match");
+	MetaDataClean(&meta_data_unpack);
+
+	TestMetaDataCorruptCheck(packed_v2_mb, "V2 - Corrupted data rejected by CRC32C");
+	TestMetaDataTruncateCheck(packed_v2_mb, "V2 - Truncated buffer rejected");
+
+	/* V1 can not be read in place */
+	op_status = MetaDataViewOpen(&meta_view, MemBufferDeref(packed_mb), MemBufferGetSize(packed_mb), 1);
+	TestMetaDataCheck((METADATA_UNPACK_FAILED_INVALID_VERSION == op_status), "V1 - View open refused");
+
+	MetaDataClean(&meta_data_pack);
+	MemBufferDestroy(packed_v2_mb);
+	MemBufferDestroy(packed_mb);
+
+	printf("TEST_META_DATA - All tests passed\n");
+	return 1;
+}
+/************************************************************************************************************************/
+static void TestMetaDataPopulate(MetaData *meta_data)
+{
+	int i;
 
 	/* Add item into META */
-	MetaDataItemAdd(&meta_data_pack, ITEM_GENERIC_STRUCT, 0, &generic_struct, sizeof(GenericStruct));
-	MetaDataItemAdd(&meta_data_pack, ITEM_STRING, 0, "este eh um item do metadado", (strlen("este eh um item do metadado") + 1));
-	MetaDataItemAdd(&meta_data_pack, ITEM_STRING, 0, "oiiiiiiiie", (strlen("oiiiiiiiie") + 1));
-	MetaDataItemAdd(&meta_data_pack, ITEM_GENERIC_STRUCT, 0, &generic_struct, sizeof(GenericStruct));
-	MetaDataItemAdd(&meta_data_pack, ITEM_STRING, 0, "este eh um item do metadado", (strlen("este eh um item do metadado") + 1));
-	MetaDataItemAdd(&meta_data_pack, ITEM_GENERIC_STRUCT, 0, &generic_struct, sizeof(GenericStruct));
-	MetaDataItemAdd(&meta_data_pack, ITEM_GENERIC_STRUCT, 0, &generic_struct, sizeof(GenericStruct));
+	for (i = 0; i < TEST_ITEM_COUNT; i++)
+		MetaDataItemAdd(meta_data, glob_item_arr[i].item_id, glob_item_arr[i].item_sub_id, glob_item_arr[i].data_ptr, glob_item_arr[i].data_sz);
+
+	return;
+}
+/************************************************************************************************************************/
+static void TestMetaDataItemsCheck(MetaData *meta_data, char *check_str)
+{
+	MetaDataItem *meta_item;
+	void *data_ptr;
+	int i;
 
+	if (TEST_ITEM_COUNT != meta_data->items.count)
+		TestMetaDataCheck(0, check_str);
 
-	MetaDataPack(&meta_data_pack, packed_mb);
+	/* Items come back in PACK order, and ID lookup finds each one */
+	for (i = 0; i < TEST_ITEM_COUNT; i++)
+	{
+		meta_item = MemArenaGrabByID(meta_data->items.arena, i);
 
-	/* Now unpack METADATA */
-	MetaDataUnpack(&meta_data_unpack, packed_mb, NULL);
+		if ((meta_item->item_id != glob_item_arr[i].item_id) || (meta_item->item_sub_id != glob_item_arr[i].item_sub_id) ||
+				(meta_item->sz != glob_item_arr[i].data_sz) || (memcmp(meta_item->ptr, glob_item_arr[i].data_ptr, glob_item_arr[i].data_sz)))
+			TestMetaDataCheck(0, check_str);
 
-	MemBufferWriteToFile(packed_mb, "./metadata.dump");
+		if (meta_item != MetaDataItemGrabMetaByID(meta_data, glob_item_arr[i].item_id, glob_item_arr[i].item_sub_id))
+			TestMetaDataCheck(0, check_str);
+
+		continue;
+	}
 
-	for (i = 0; i < meta_data_unpack.items.count; i++)
+	/* V1 items are not aligned, compare bytes instead of reading fields */
+	data_ptr = MetaDataItemFindByID(meta_data, ITEM_GENERIC_STRUCT, 1);
+
+	if ((!data_ptr) || (memcmp(data_ptr, &glob_struct_arr[1], sizeof(GenericStruct))))
+		TestMetaDataCheck(0, check_str);
+
+	if (MetaDataItemFindByID(meta_data, ITEM_STRING, 99))
+		TestMetaDataCheck(0, check_str);
+
+	TestMetaDataCheck(1, check_str);
+	return;
+}
+/************************************************************************************************************************/
+static void TestMetaDataViewCheck(MetaDataView *meta_view, char *check_str)
+{
+	MetaDataIndexItem *index_item;
+	GenericStruct *generic_struct_ptr;
+	unsigned long item_sz;
+	char *item_ptr;
+	int i;
+
+	if (TEST_ITEM_COUNT != MetaDataViewGetCount(meta_view))
+		TestMetaDataCheck(0, check_str);
+
+	/* Index keeps PACK order, hashed lookup lands on same entry and returns its size */
+	for (i = 0; i < TEST_ITEM_COUNT; i++)
 	{
-		meta_item = MemArenaGrabByID(meta_data_unpack.items.arena, i);
+		index_item = MetaDataViewGrabByIdx(meta_view, i);
+
+		if ((index_item->item_id != glob_item_arr[i].item_id) || (index_item->item_sub_id != glob_item_arr[i].item_sub_id) || (index_item->sz != glob_item_arr[i].data_sz))
+			TestMetaDataCheck(0, check_str);
 
-		if (ITEM_STRING == meta_item->item_id)
-		{
-			printf("INDEX [%d] - STRING_ITEM - [%lu]-[%s]\n", i, meta_item->sz, meta_item->ptr);
-		}
-		else if (ITEM_GENERIC_STRUCT == meta_item->item_id)
-		{
-			generic_struct_ptr = meta_item->ptr;
+		if ((i != MetaDataViewFindIdx(meta_view, glob_item_arr[i].item_id, glob_item_arr[i].item_sub_id)) ||
+				(index_item != MetaDataViewGrabByID(meta_view, glob_item_arr[i].item_id, glob_item_arr[i].item_sub_id)))
+			TestMetaDataCheck(0, check_str);
 
-			printf("INDEX [%d] - BINARY ITEM ID [%lu] - A [%d] - B [%ld] - C [%f] - BUF [%s]\n",
-					i, meta_item->item_id, generic_struct_ptr->a, generic_struct_ptr->b, generic_struct_ptr->c, generic_struct_ptr->buf);
-		}
-		else
-		{
-			printf("INDEX [%d] - BINARY ITEM ID [%lu]\n", i, meta_item->item_id);
-		}
+		item_sz		= 0;
+		item_ptr	= MetaDataViewFindByID(meta_view, glob_item_arr[i].item_id, glob_item_arr[i].item_sub_id, &item_sz);
 
+		if ((!item_ptr) || (item_sz != glob_item_arr[i].data_sz) || (memcmp(item_ptr, glob_item_arr[i].data_ptr, item_sz)))
+			TestMetaDataCheck(0, check_str);
 
+		/* Items are aligned for in place reads */
+		if (((item_ptr - meta_view->base_ptr) % METADATA_V2_ALIGN) != 0)
+			TestMetaDataCheck(0, check_str);
 
 		continue;
 	}
 
-	return 1;
+	generic_struct_ptr = MetaDataViewFindByID(meta_view, ITEM_GENERIC_STRUCT, 0, NULL);
+
+	if ((!generic_struct_ptr) || (500 != generic_struct_ptr->a) || (99999 != generic_struct_ptr->b) || (strcmp(generic_struct_ptr->buf, "aaaaaaaaa")))
+		TestMetaDataCheck(0, check_str);
+
+	/* Misses, same ID with unknown SUB_ID and unknown ID */
+	if ((-1 != MetaDataViewFindIdx(meta_view, ITEM_STRING, 99)) || (MetaDataViewFindByID(meta_view, ITEM_LASTITEM, 0, NULL)))
+		TestMetaDataCheck(0, check_str);
+
+	TestMetaDataCheck(1, check_str);
+	return;
+}
+/************************************************************************************************************************/
+static void TestMetaDataCorruptCheck(MemBuffer *packed_mb, char *check_str)
+{
+	MetaDataView meta_view;
+	MetaData meta_data;
+	MemBuffer *corrupt_mb;
+	MetaDataHeader *meta_data_hdr;
+	char *data_ptr;
+	int op_status;
+
+	memset(&meta_data, 0, sizeof(MetaData));
+
+	/* Flip one bit on last body byte, digest must catch it */
+	corrupt_mb		= MemBufferNew(BRBDATA_THREAD_UNSAFE, 512);
+	MemBufferAdd(corrupt_mb, MemBufferDeref(packed_mb), MemBufferGetSize(packed_mb));
+
+	meta_data_hdr	= MemBufferDeref(corrupt_mb);
+	data_ptr		= MemBufferDeref(corrupt_mb);
+
+	/* V1 ends with a separator, flip last DATA byte instead */
+	data_ptr[MemBufferGetSize(corrupt_mb) - ((METADATA_VERSION_V2 == meta_data_hdr->version) ? 1 : (1 + METADATA_UNIT_SEPARATOR_SZ))] ^= 0x01;
+
+	op_status = MetaDataUnpack(&meta_data, corrupt_mb, NULL);
+	TestMetaDataCheck((METADATA_UNPACK_FAILED_DIGEST_INVALID == op_status), check_str);
+
+	/* In place reader must refuse it too, unless caller trusts the source */
+	if (METADATA_VERSION_V2 == meta_data_hdr->version)
+	{
+		op_status = MetaDataViewOpen(&meta_view, MemBufferDeref(corrupt_mb), MemBufferGetSize(corrupt_mb), 1);
+		TestMetaDataCheck((METADATA_UNPACK_FAILED_DIGEST_INVALID == op_status), "V2 - Corrupted data rejected by view");
+
+		op_status = MetaDataViewOpen(&meta_view, MemBufferDeref(corrupt_mb), MemBufferGetSize(corrupt_mb), 0);
+		TestMetaDataCheck((METADATA_UNPACK_SUCCESS == op_status), "V2 - Unverified view skips digest");
+		MetaDataViewClose(&meta_view);
+	}
+
+	MetaDataClean(&meta_data);
+	MemBufferDestroy(corrupt_mb);
+
+	return;
+}
+/************************************************************************************************************************/
+static void TestMetaDataTruncateCheck(MemBuffer *packed_mb, char *check_str)
+{
+	MetaDataUnpackerInfo unpacker_info;
+	MetaDataView meta_view;
+	MetaData meta_data;
+	MemBuffer *truncated_mb;
+	int op_status;
+
+	memset(&meta_data, 0, sizeof(MetaData));
+	memset(&unpacker_info, 0, sizeof(MetaDataUnpackerInfo));
+
+	/* Last byte missing, unpacker must ask for it */
+	truncated_mb = MemBufferNew(BRBDATA_THREAD_UNSAFE, 512);
+	MemBufferAdd(truncated_mb, MemBufferDeref(packed_mb), (MemBufferGetSize(packed_mb) - 1));
+
+	op_status = MetaDataUnpack(&meta_data, truncated_mb, &unpacker_info);
+	TestMetaDataCheck(((METADATA_UNPACK_FAILED_NEED_MORE_DATA_OBJECT == op_status) && (op_status == unpacker_info.error_code) && (1 == unpacker_info.cur_needed)), check_str);
+
+	/* Not even a full header */
+	op_status = MetaDataViewOpen(&meta_view, MemBufferDeref(packed_mb), (sizeof(MetaDataHeader) - 1), 1);
+	TestMetaDataCheck((METADATA_UNPACK_FAILED_NEED_MORE_DATA_METAITEM == op_status), "Short header rejected by view");
+
+	MetaDataClean(&meta_data);
+	MemBufferDestroy(truncated_mb);
+
+	return;
+}
+/************************************************************************************************************************/
+static void TestMetaDataCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		fflush(stdout);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
 }
 /************************************************************************************************************************/
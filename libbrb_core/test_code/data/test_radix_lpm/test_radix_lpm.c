@@ -0,0 +1,469 @@
+/*
+ * test_radix_lpm.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_core.h>
+
+#define BASE_COUNT			64
+#define V4_PREFIX_COUNT		4096
+#define V6_PREFIX_COUNT		2048
+#define LOOKUP_COUNT		(64 * 1024)
+#define REBUILD_COUNT		4
+#define READER_COUNT		4
+#define TAG_COUNT			(256 * 1024)
+
+typedef struct _TestReaderArg
+{
+	pthread_t thread_id;
+	RadixLPM *lpm;
+	long lookup_count;
+	long error_count;
+} TestReaderArg;
+
+static unsigned int glob_v4_base_arr[BASE_COUNT];
+static unsigned char glob_v6_base_arr[BASE_COUNT][16];
+static int glob_tag_arr[TAG_COUNT];
+static int glob_tag_next;
+static int glob_stop;
+
+static void TestLPMCheck(int cond, char *check_str);
+static void TestLPMV4Populate(RadixTree *radix, int prefix_count);
+static void TestLPMV6Populate(RadixTree *radix, int prefix_count);
+static void TestLPMV4AddrGen(struct in_addr *addr);
+static void TestLPMV6AddrGen(struct in6_addr *addr);
+static long TestLPMV4Compare(RadixTree *radix, RadixLPM *lpm);
+static long TestLPMV6Compare(RadixTree *radix, RadixLPM *lpm);
+static void TestLPMRebuildCheck(RadixTree *radix, RadixLPM *lpm, int family);
+static void TestLPMReclaimCheck(RadixTree *radix, RadixLPM *lpm);
+static void TestLPMConcurrentCheck(RadixTree *radix_v4, RadixLPM *lpm_v4);
+static void *TestLPMReaderWorker(void *arg_ptr);
+static void *TestLPMTagNext(void);
+static int TestLPMTagValid(void *data);
+
+/**************************************************************************************************************************/
+int main(int argc, char **argv)
+{
+	struct in6_addr v6_addr;
+	struct in_addr v4_addr;
+	RadixTree *radix_v4;
+	RadixTree *radix_v6;
+	RadixLPM *lpm_v4;
+	RadixLPM *lpm_v6;
+	int i;
+
+	/* Prefixes are clustered around a few bases, so they nest and overlap on both tbl24 and tbl8 levels */
+	for (i = 0; i < BASE_COUNT; i++)
+	{
+		glob_v4_base_arr[i] = arc4random();
+		arc4random_buf(&glob_v6_base_arr[i], 16);
+	}
+
+	radix_v4	= RadixTreeNew();
+	radix_v6	= RadixTreeNew();
+	lpm_v4		= RadixLPMNew(radix_v4);
+	lpm_v6		= RadixLPMNew(radix_v6);
+
+	/* Nothing published yet, lookups must miss and not crash */
+	TestLPMV4AddrGen(&v4_addr);
+	TestLPMV6AddrGen(&v6_addr);
+	TestLPMCheck(((NULL == RadixLPMLookupV4(lpm_v4, &v4_addr)) && (NULL == RadixLPMLookupV6(lpm_v6, &v6_addr))), "Lookup before first publish misses");
+
+	TestLPMV4Populate(radix_v4, V4_PREFIX_COUNT);
+	TestLPMV6Populate(radix_v6, V6_PREFIX_COUNT);
+
+	TestLPMCheck((RadixLPMPublish(lpm_v4) > 1), "V4 snapshot published");
+	TestLPMCheck((RadixLPMPublish(lpm_v6) > 1), "V6 snapshot published");
+
+	TestLPMCheck((0 == TestLPMV4Compare(radix_v4, lpm_v4)), "V4 lookup and batch lookup match RadixTreeSearchBest");
+	TestLPMCheck((0 == TestLPMV6Compare(radix_v6, lpm_v6)), "V6 lookup and batch lookup match RadixTreeSearchBest");
+
+	TestLPMRebuildCheck(radix_v4, lpm_v4, AF_INET);
+	TestLPMRebuildCheck(radix_v6, lpm_v6, AF_INET6);
+	TestLPMReclaimCheck(radix_v4, lpm_v4);
+	TestLPMConcurrentCheck(radix_v4, lpm_v4);
+
+	RadixLPMDestroy(lpm_v4);
+	RadixLPMDestroy(lpm_v6);
+	RadixTreeDestroy(radix_v4, NULL, NULL);
+	RadixTreeDestroy(radix_v6, NULL, NULL);
+
+	printf("TEST_RADIX_LPM - All tests passed\n");
+	return 0;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static void TestLPMCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestLPMV4Populate(RadixTree *radix, int prefix_count)
+{
+	RadixPrefix prefix;
+	RadixNode *node;
+	struct in_addr addr;
+	unsigned int bitlen;
+	unsigned int host_addr;
+	int i;
+
+	for (i = 0; i < prefix_count; i++)
+	{
+		TestLPMV4AddrGen(&addr);
+
+		/* Favour lengths past /24, so tbl8 groups get exercised as much as tbl24 */
+		bitlen		= ((i & 1) ? (24 + (arc4random() % 9)) : (arc4random() % 33));
+		host_addr	= ntohl(addr.s_addr);
+		host_addr	= (bitlen ? (host_addr & (0xFFFFFFFFU << (32 - bitlen))) : 0);
+		addr.s_addr	= htonl(host_addr);
+
+		RadixPrefixInit(&prefix, AF_INET, &addr, bitlen);
+		node		= RadixTreeLookup(radix, &prefix);
+		node->data	= TestLPMTagNext();
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestLPMV6Populate(RadixTree *radix, int prefix_count)
+{
+	RadixPrefix prefix;
+	RadixNode *node;
+	struct in6_addr addr;
+	unsigned char *addr_ptr;
+	unsigned int bitlen;
+	int i;
+	int j;
+
+	for (i = 0; i < prefix_count; i++)
+	{
+		TestLPMV6AddrGen(&addr);
+
+		/* Anything from /0 to /128, with bits past prefix length cleared */
+		bitlen		= (arc4random() % 129);
+		addr_ptr	= (unsigned char *)&addr;
+
+		for (j = 0; j < 16; j++)
+		{
+			if ((j * 8) >= bitlen)
+				addr_ptr[j] = 0;
+			else if (((j + 1) * 8) > bitlen)
+				addr_ptr[j] &= (0xFF << (((j + 1) * 8) - bitlen));
+		}
+
+		RadixPrefixInit(&prefix, AF_INET6, &addr, bitlen);
+		node		= RadixTreeLookup(radix, &prefix);
+		node->data	= TestLPMTagNext();
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestLPMV4AddrGen(struct in_addr *addr)
+{
+	/* Pick a base and flip a random amount of its low bits */
+	addr->s_addr = htonl(glob_v4_base_arr[arc4random() % BASE_COUNT] ^ (arc4random() >> (arc4random() % 32)));
+	return;
+}
+/**************************************************************************************************************************/
+static void TestLPMV6AddrGen(struct in6_addr *addr)
+{
+	unsigned char *addr_ptr = (unsigned char *)addr;
+	int keep_sz;
+	int i;
+
+	/* Keep a random amount of leading bytes of a base, randomize the rest */
+	memcpy(addr_ptr, &glob_v6_base_arr[arc4random() % BASE_COUNT], 16);
+	keep_sz = (arc4random() % 17);
+
+	for (i = keep_sz; i < 16; i++)
+		addr_ptr[i] = (arc4random() & 0xFF);
+
+	return;
+}
+/**************************************************************************************************************************/
+static long TestLPMV4Compare(RadixTree *radix, RadixLPM *lpm)
+{
+	static struct in_addr addr_arr[LOOKUP_COUNT];
+	static void *data_arr[LOOKUP_COUNT];
+	RadixPrefix prefix;
+	RadixNode *node;
+	void *expected;
+	long mismatch_count;
+	long hit_count;
+	int batch_hit;
+	int i;
+
+	for (i = 0; i < LOOKUP_COUNT; i++)
+		TestLPMV4AddrGen(&addr_arr[i]);
+
+	batch_hit = RadixLPMLookupV4Batch(lpm, addr_arr, data_arr, LOOKUP_COUNT);
+
+	for (mismatch_count = 0, hit_count = 0, i = 0; i < LOOKUP_COUNT; i++)
+	{
+		RadixPrefixInit(&prefix, AF_INET, &addr_arr[i], 32);
+		node		= RadixTreeSearchBest(radix, &prefix);
+		expected	= (node ? node->data : NULL);
+		hit_count	+= (expected ? 1 : 0);
+
+		if ((RadixLPMLookupV4(lpm, &addr_arr[i]) != expected) || (data_arr[i] != expected))
+			mismatch_count++;
+	}
+
+	/* Batch hit count must agree too, and clustered addresses must hit at least sometimes */
+	if ((batch_hit != hit_count) || (0 == hit_count))
+		mismatch_count++;
+
+	return mismatch_count;
+}
+/**************************************************************************************************************************/
+static long TestLPMV6Compare(RadixTree *radix, RadixLPM *lpm)
+{
+	static struct in6_addr addr_arr[LOOKUP_COUNT];
+	static void *data_arr[LOOKUP_COUNT];
+	RadixPrefix prefix;
+	RadixNode *node;
+	void *expected;
+	long mismatch_count;
+	long hit_count;
+	int batch_hit;
+	int i;
+
+	for (i = 0; i < LOOKUP_COUNT; i++)
+		TestLPMV6AddrGen(&addr_arr[i]);
+
+	batch_hit = RadixLPMLookupV6Batch(lpm, addr_arr, data_arr, LOOKUP_COUNT);
+
+	for (mismatch_count = 0, hit_count = 0, i = 0; i < LOOKUP_COUNT; i++)
+	{
+		RadixPrefixInit(&prefix, AF_INET6, &addr_arr[i], 128);
+		node		= RadixTreeSearchBest(radix, &prefix);
+		expected	= (node ? node->data : NULL);
+		hit_count	+= (expected ? 1 : 0);
+
+		if ((RadixLPMLookupV6(lpm, &addr_arr[i]) != expected) || (data_arr[i] != expected))
+			mismatch_count++;
+	}
+
+	if ((batch_hit != hit_count) || (0 == hit_count))
+		mismatch_count++;
+
+	return mismatch_count;
+}
+/**************************************************************************************************************************/
+static void TestLPMRebuildCheck(RadixTree *radix, RadixLPM *lpm, int family)
+{
+	RadixLPMSnapshot *old_snapshot;
+	RadixNode *node;
+	RadixNode *remove_arr[V4_PREFIX_COUNT];
+	int remove_count;
+	int round;
+	int i;
+
+	for (round = 0; round < REBUILD_COUNT - 1; round++)
+	{
+		remove_count = 0;
+
+		/* Drop about a quarter of prefixes and move data of the rest, so old answers turn wrong */
+		RADIX_WALK(radix->head, node)
+		{
+			if ((remove_count < V4_PREFIX_COUNT) && (0 == (arc4random() % 4)))
+				remove_arr[remove_count++] = node;
+			else
+				node->data = TestLPMTagNext();
+		} RADIX_WALK_END;
+
+		for (i = 0; i < remove_count; i++)
+			RadixTreeRemove(radix, remove_arr[i]);
+
+		/* Then add new ones */
+		if (AF_INET6 == family)
+			TestLPMV6Populate(radix, (V6_PREFIX_COUNT / 4));
+		else
+			TestLPMV4Populate(radix, (V4_PREFIX_COUNT / 4));
+
+		old_snapshot = lpm->current;
+
+		/* Nobody is registered as reader, old snapshot goes away right on publish */
+		TestLPMCheck((RadixLPMPublish(lpm) > 1), "Rebuilt snapshot published");
+		TestLPMCheck(((lpm->current != old_snapshot) && (NULL == lpm->retire_list)), "Rebuilt snapshot swapped in and old one reclaimed");
+
+		if (AF_INET6 == family)
+			TestLPMCheck((0 == TestLPMV6Compare(radix, lpm)), "V6 rebuilt snapshot matches RadixTreeSearchBest");
+		else
+			TestLPMCheck((0 == TestLPMV4Compare(radix, lpm)), "V4 rebuilt snapshot matches RadixTreeSearchBest");
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestLPMReclaimCheck(RadixTree *radix, RadixLPM *lpm)
+{
+	RadixLPMSnapshot *old_snapshot;
+	int reader_arr[2];
+
+	reader_arr[0] = RadixLPMReaderRegister(lpm);
+	reader_arr[1] = RadixLPMReaderRegister(lpm);
+
+	TestLPMCheck(((reader_arr[0] > -1) && (reader_arr[1] > -1) && (reader_arr[0] != reader_arr[1])), "Readers registered");
+
+	/* Readers did not announce quiescent state, so retired snapshot must stay */
+	old_snapshot = lpm->current;
+	RadixLPMPublish(lpm);
+
+	TestLPMCheck((lpm->retire_list == old_snapshot), "Retired snapshot kept while readers may hold it");
+	TestLPMCheck((0 == RadixLPMReclaim(lpm)), "Nothing reclaimed before readers pass quiescent state");
+
+	/* One reader is not enough */
+	RadixLPMReaderQuiescent(lpm, reader_arr[0]);
+	TestLPMCheck((0 == RadixLPMReclaim(lpm)), "Nothing reclaimed while one reader lags behind");
+
+	/* A second retired snapshot piles up behind the first one */
+	RadixLPMPublish(lpm);
+	TestLPMCheck(((lpm->retire_list) && (lpm->retire_list->retire_next == old_snapshot)), "Second retired snapshot queued");
+
+	RadixLPMReaderQuiescent(lpm, reader_arr[1]);
+	TestLPMCheck((1 == RadixLPMReclaim(lpm)), "Oldest snapshot reclaimed once every reader passed its epoch");
+
+	RadixLPMReaderQuiescent(lpm, reader_arr[0]);
+	TestLPMCheck(((1 == RadixLPMReclaim(lpm)) && (NULL == lpm->retire_list)), "Newer snapshot reclaimed after lagging reader caught up");
+
+	/* Unregistered readers do not hold anything back */
+	RadixLPMReaderUnregister(lpm, reader_arr[0]);
+	RadixLPMReaderUnregister(lpm, reader_arr[1]);
+	RadixLPMPublish(lpm);
+
+	TestLPMCheck((NULL == lpm->retire_list), "Unregistered readers hold nothing back");
+	TestLPMCheck((0 == TestLPMV4Compare(radix, lpm)), "Snapshot still matches RadixTreeSearchBest after reclaim");
+	return;
+}
+/**************************************************************************************************************************/
+static void TestLPMConcurrentCheck(RadixTree *radix_v4, RadixLPM *lpm_v4)
+{
+	TestReaderArg reader_arg[READER_COUNT];
+	long lookup_count;
+	long error_count;
+	int i;
+
+	glob_stop = 0;
+
+	for (i = 0; i < READER_COUNT; i++)
+	{
+		memset(&reader_arg[i], 0, sizeof(TestReaderArg));
+		reader_arg[i].lpm = lpm_v4;
+		pthread_create(&reader_arg[i].thread_id, NULL, TestLPMReaderWorker, &reader_arg[i]);
+	}
+
+	/* Writer keeps rebuilding while readers look up - Data stays valid, so any answer must be one of our tags */
+	for (i = 0; i < REBUILD_COUNT; i++)
+	{
+		TestLPMV4Populate(radix_v4, 64);
+		RadixLPMPublish(lpm_v4);
+		usleep(10000);
+	}
+
+	__atomic_store_n(&glob_stop, 1, __ATOMIC_RELEASE);
+
+	for (lookup_count = 0, error_count = 0, i = 0; i < READER_COUNT; i++)
+	{
+		pthread_join(reader_arg[i].thread_id, NULL);
+		lookup_count	+= reader_arg[i].lookup_count;
+		error_count		+= reader_arg[i].error_count;
+	}
+
+	RadixLPMReclaim(lpm_v4);
+
+	printf("CONCURRENT - READERS [%d] - LOOKUPS [%ld] - REBUILDS [%d]\n", READER_COUNT, lookup_count, REBUILD_COUNT);
+
+	TestLPMCheck(((lookup_count > 0) && (0 == error_count)), "Concurrent readers only ever see valid data");
+	TestLPMCheck((NULL == lpm_v4->retire_list), "Every retired snapshot reclaimed after readers left");
+	TestLPMCheck((0 == TestLPMV4Compare(radix_v4, lpm_v4)), "Final snapshot matches RadixTreeSearchBest");
+	return;
+}
+/**************************************************************************************************************************/
+static void *TestLPMReaderWorker(void *arg_ptr)
+{
+	TestReaderArg *reader_arg = arg_ptr;
+	struct in_addr addr;
+	void *data;
+	int reader_id;
+	int i;
+
+	reader_id = RadixLPMReaderRegister(reader_arg->lpm);
+
+	if (reader_id < 0)
+	{
+		reader_arg->error_count++;
+		return NULL;
+	}
+
+	while (!__atomic_load_n(&glob_stop, __ATOMIC_ACQUIRE))
+	{
+		for (i = 0; i < 1024; i++)
+		{
+			TestLPMV4AddrGen(&addr);
+			data = RadixLPMLookupV4(reader_arg->lpm, &addr);
+
+			if (data && !TestLPMTagValid(data))
+				reader_arg->error_count++;
+
+			reader_arg->lookup_count++;
+		}
+
+		/* Like an event loop iteration boundary */
+		RadixLPMReaderQuiescent(reader_arg->lpm, reader_id);
+	}
+
+	RadixLPMReaderUnregister(reader_arg->lpm, reader_id);
+	return NULL;
+}
+/**************************************************************************************************************************/
+static void *TestLPMTagNext(void)
+{
+	/* Plenty for every prefix and rebuild this test does, so no two live nodes ever share a tag */
+	return &glob_tag_arr[(glob_tag_next++) % TAG_COUNT];
+}
+/**************************************************************************************************************************/
+static int TestLPMTagValid(void *data)
+{
+	return ((data >= (void *)&glob_tag_arr[0]) && (data < (void *)&glob_tag_arr[TAG_COUNT]));
+}
+/**************************************************************************************************************************/
@@ -0,0 +1,312 @@
+/*
+ * test_selfsync_bench.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_data.h>
+
+#define LINE_TOTAL_SZ		(64 * 1024 * 1024)
+#define LINE_MIN_SZ			40
+#define LINE_MAX_SZ			160
+#define FRAME_TOTAL_SZ		(256 * 1024)
+#define FRAME_COUNT			64
+#define SEGMENT_SZ			1448
+#define TEN_GBE_BYTES_SEC	1250000000.0
+#define MATCH_BUF_SZ		512
+#define MATCH_ROUNDS		20000
+
+static char *TestSelfSyncLinesBuild(long total_sz);
+static long TestSelfSyncLinesRun(char *line_buf, long line_sz, int simd, long *ret_off_sum);
+static long TestSelfSyncFrameRun(int incremental);
+static void TestSelfSyncMatchScalar(void);
+static void TestSelfSyncCheck(int cond, char *check_str);
+static long TestSelfSyncScalarFind(const char *buffer_ptr, long buffer_sz, const char *token_str, int token_sz);
+static long TestSelfSyncScalarFindLast(const char *buffer_ptr, long buffer_sz, const char *token_str, int token_sz);
+static void TestSelfSyncReport(const char *label_str, double byte_count, double elapsed_time, long frame_count);
+static double TestSelfSyncTimeNow(void);
+
+/**************************************************************************************************************************/
+int main(int argc, char *argv[])
+{
+	char *line_buf;
+	long scalar_off_sum;
+	long simd_off_sum;
+	long scalar_count;
+	long simd_count;
+
+	/* SIMD search must agree with plain scan on every size, alignment and token placement before timing anything */
+	TestSelfSyncMatchScalar();
+
+	line_buf = TestSelfSyncLinesBuild(LINE_TOTAL_SZ);
+
+	/* Line oriented protocol, one frame every ~100 bytes, every frame must be located */
+	scalar_count	= TestSelfSyncLinesRun(line_buf, LINE_TOTAL_SZ, 0, &scalar_off_sum);
+	simd_count		= TestSelfSyncLinesRun(line_buf, LINE_TOTAL_SZ, 1, &simd_off_sum);
+	TestSelfSyncCheck((scalar_count == simd_count) && (scalar_off_sum == simd_off_sum), "LINES - SIMD frames match SCALAR frames");
+
+	/* Large frames arriving in MSS sized reads, token only at end of each frame */
+	scalar_count	= TestSelfSyncFrameRun(0);
+	simd_count		= TestSelfSyncFrameRun(1);
+	TestSelfSyncCheck((FRAME_COUNT == scalar_count) && (scalar_count == simd_count), "FRAMES - INCREMENTAL frames match RESCAN frames");
+
+	free(line_buf);
+
+	printf("TEST_SELFSYNC_BENCH - All tests passed\n");
+	return 0;
+}
+/**************************************************************************************************************************/
+static char *TestSelfSyncLinesBuild(long total_sz)
+{
+	char *line_buf = malloc(total_sz);
+	long line_sz;
+	long i, j;
+
+	srand(1);
+
+	/* Fill with printable text, break lines with CRLF at random lengths */
+	for (i = 0; i < total_sz; i += line_sz)
+	{
+		line_sz = LINE_MIN_SZ + (rand() % (LINE_MAX_SZ - LINE_MIN_SZ));
+		line_sz = ((i + line_sz) > total_sz) ? (total_sz - i) : line_sz;
+
+		for (j = 0; j < line_sz; j++)
+			line_buf[i + j] = 'A' + ((i + j) % 26);
+
+		if (line_sz >= 2)
+			memcpy(&line_buf[i + line_sz - 2], "\r\n", 2);
+	}
+
+	return line_buf;
+}
+/**************************************************************************************************************************/
+static long TestSelfSyncLinesRun(char *line_buf, long line_sz, int simd, long *ret_off_sum)
+{
+	double begin_time;
+	double elapsed_time;
+	long frame_count;
+	long scan_off;
+	long hit_off;
+
+	frame_count		= 0;
+	scan_off		= 0;
+	*ret_off_sum	= 0;
+	begin_time	= TestSelfSyncTimeNow();
+
+	/* Walk every token, same as chain SELF_SYNC collecting a batch */
+	while (scan_off < line_sz)
+	{
+		if (simd)
+			hit_off = BrbMemFind(line_buf + scan_off, (line_sz - scan_off), "\r\n", 2);
+		else
+			hit_off = TestSelfSyncScalarFind(line_buf + scan_off, (line_sz - scan_off), "\r\n", 2);
+
+		if (hit_off < 0)
+			break;
+
+		scan_off		+= (hit_off + 2);
+		*ret_off_sum	+= scan_off;
+		frame_count++;
+	}
+
+	elapsed_time = (TestSelfSyncTimeNow() - begin_time);
+	TestSelfSyncReport((simd ? "LINES - BrbMemFind" : "LINES - SCALAR"), line_sz, elapsed_time, frame_count);
+
+	return frame_count;
+}
+/**************************************************************************************************************************/
+static long TestSelfSyncFrameRun(int incremental)
+{
+	char *frame_buf = malloc(FRAME_TOTAL_SZ);
+	double begin_time;
+	double elapsed_time;
+	long frame_count;
+	long scan_off;
+	long hit_off;
+	long read_sz;
+	long seg_sz;
+	int i;
+
+	/* Frame body has no token, CRLFCRLF closes it */
+	memset(frame_buf, 'X', FRAME_TOTAL_SZ);
+	memcpy(&frame_buf[FRAME_TOTAL_SZ - 4], "\r\n\r\n", 4);
+
+	frame_count	= 0;
+	begin_time	= TestSelfSyncTimeNow();
+
+	for (i = 0; i < FRAME_COUNT; i++)
+	{
+		scan_off = 0;
+
+		/* Each read grows buffer by one segment and triggers a new search */
+		for (read_sz = 0; read_sz < FRAME_TOTAL_SZ; read_sz += seg_sz)
+		{
+			seg_sz = ((read_sz + SEGMENT_SZ) > FRAME_TOTAL_SZ) ? (FRAME_TOTAL_SZ - read_sz) : SEGMENT_SZ;
+
+			/* Legacy path searched whole buffer again on every read */
+			if (incremental)
+			{
+				hit_off		= BrbMemFindLast(frame_buf + scan_off, (read_sz + seg_sz - scan_off), "\r\n\r\n", 4);
+				scan_off	= (hit_off >= 0) ? 0 : (((read_sz + seg_sz) >= 4) ? (read_sz + seg_sz - 3) : 0);
+			}
+			else
+				hit_off		= TestSelfSyncScalarFindLast(frame_buf, (read_sz + seg_sz), "\r\n\r\n", 4);
+
+			if (hit_off >= 0)
+				frame_count++;
+
+			continue;
+		}
+	}
+
+	elapsed_time = (TestSelfSyncTimeNow() - begin_time);
+	TestSelfSyncReport((incremental ? "FRAMES - INCREMENTAL" : "FRAMES - RESCAN"), ((double)FRAME_TOTAL_SZ * FRAME_COUNT), elapsed_time, frame_count);
+
+	free(frame_buf);
+	return frame_count;
+}
+/**************************************************************************************************************************/
+static void TestSelfSyncMatchScalar(void)
+{
+	char match_buf[MATCH_BUF_SZ + 64];
+	char token_str[8];
+	long scalar_off;
+	long simd_off;
+	long buffer_sz;
+	int token_sz;
+	int align;
+	int round;
+	int i;
+
+	srand(2);
+
+	for (round = 0; round < MATCH_ROUNDS; round++)
+	{
+		/* Small alphabet so partial and full hits land everywhere, including on SIMD block edges */
+		buffer_sz	= (rand() % MATCH_BUF_SZ);
+		token_sz	= 1 + (rand() % (sizeof(token_str) - 1));
+		align		= (rand() % 32);
+
+		for (i = 0; i < buffer_sz; i++)
+			match_buf[align + i] = 'a' + (rand() % 3);
+
+		for (i = 0; i < token_sz; i++)
+			token_str[i] = 'a' + (rand() % 3);
+
+		/* Plant token on half of the rounds, so long tokens hit too */
+		if ((round & 1) && (buffer_sz >= token_sz))
+			memcpy(&match_buf[align + (rand() % (buffer_sz - token_sz + 1))], token_str, token_sz);
+
+		scalar_off	= TestSelfSyncScalarFind(&match_buf[align], buffer_sz, token_str, token_sz);
+		simd_off	= BrbMemFind(&match_buf[align], buffer_sz, token_str, token_sz);
+
+		if (scalar_off != simd_off)
+		{
+			printf("FAILED - BrbMemFind - SIZE [%ld] - ALIGN [%d] - TOKEN [%d] - SCALAR [%ld] - SIMD [%ld]\n", buffer_sz, align, token_sz, scalar_off, simd_off);
+			abort();
+		}
+
+		scalar_off	= TestSelfSyncScalarFindLast(&match_buf[align], buffer_sz, token_str, token_sz);
+		simd_off	= BrbMemFindLast(&match_buf[align], buffer_sz, token_str, token_sz);
+
+		if (scalar_off != simd_off)
+		{
+			printf("FAILED - BrbMemFindLast - SIZE [%ld] - ALIGN [%d] - TOKEN [%d] - SCALAR [%ld] - SIMD [%ld]\n", buffer_sz, align, token_sz, scalar_off, simd_off);
+			abort();
+		}
+
+		continue;
+	}
+
+	printf("OK - BrbMemFind and BrbMemFindLast match SCALAR on [%d] random buffers\n", MATCH_ROUNDS);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestSelfSyncCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/**************************************************************************************************************************/
+static long TestSelfSyncScalarFind(const char *buffer_ptr, long buffer_sz, const char *token_str, int token_sz)
+{
+	long i;
+
+	for (i = 0; (i + token_sz) <= buffer_sz; i++)
+	{
+		if ((buffer_ptr[i] == token_str[0]) && (!memcmp(&buffer_ptr[i], token_str, token_sz)))
+			return i;
+
+		continue;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+static long TestSelfSyncScalarFindLast(const char *buffer_ptr, long buffer_sz, const char *token_str, int token_sz)
+{
+	long i;
+
+	for (i = (buffer_sz - token_sz); i >= 0; i--)
+	{
+		if ((buffer_ptr[i] == token_str[0]) && (!memcmp(&buffer_ptr[i], token_str, token_sz)))
+			return i;
+
+		continue;
+	}
+
+	return -1;
+}
+/**************************************************************************************************************************/
+static void TestSelfSyncReport(const char *label_str, double byte_count, double elapsed_time, long frame_count)
+{
+	double byte_rate = (byte_count / elapsed_time);
+
+	printf("%-22s - [%ld] frames - [%.3f] sec - [%.2f] GB/s - [%.2f] Gbit/s - [%.1f%%] of 10GbE line rate\n",
+			label_str, frame_count, elapsed_time, (byte_rate / 1000000000.0), ((byte_rate * 8) / 1000000000.0), ((byte_rate / TEN_GBE_BYTES_SEC) * 100));
+
+	return;
+}
+/**************************************************************************************************************************/
+static double TestSelfSyncTimeNow(void)
+{
+	struct timeval current_time;
+
+	gettimeofday(&current_time, NULL);
+	return (current_time.tv_sec + (current_time.tv_usec / 1000000.0));
+}
+/**************************************************************************************************************************/
@@ -34,6 +34,17 @@
 
 #include <libbrb_core.h>
 
+#define BENCH_PATTERN_COUNT		50000
+#define BENCH_URL_COUNT			20000
+#define BENCH_MATCH_MAX			64
+#define BENCH_CHECK_COUNT		256
+
+static void TestSpeedRegExSetBench(void);
+static int TestSpeedRegExSetMatchCheck(SpeedRegEx **spd_reg_arr, SpeedRegExSet *spdreg_set, char *url_str);
+static int TestSpeedRegExIntCmp(const void *a, const void *b);
+static char *TestSpeedRegExPatternBuild(char *pattern_buf, int pattern_idx);
+static double TestSpeedRegExTimeNow(void);
+
 /****************************************************************************************************/
 int main(void)
 {
@@ -54,5 +65,188 @@ int main(void)
 
 	SpeedRegExDestroy(spd_reg);
 
+	TestSpeedRegExSetBench();
+	return 0;
+}
+/**************************************************************************************************************************/
+static void TestSpeedRegExSetBench(void)
+{
+	SpeedRegEx **spd_reg_arr;
+	SpeedRegExSet *spdreg_set;
+	SpeedRegExSet *loaded_set;
+	MemBuffer *dump_mb;
+	char pattern_buf[128];
+	static char url_buf[BENCH_URL_COUNT][128];
+	int match_arr[BENCH_MATCH_MAX];
+	double begin_time;
+	double loop_time;
+	double set_time;
+	long loop_hits;
+	long set_hits;
+	int check_hits;
+	int i, j;
+
+	spd_reg_arr	= calloc(BENCH_PATTERN_COUNT, sizeof(SpeedRegEx *));
+	spdreg_set	= SpeedRegExSetNew(SPDREGEX_MT_UNSAFE);
+
+	/* Same blocklist compiled both ways */
+	begin_time = TestSpeedRegExTimeNow();
+
+	for (i = 0; i < BENCH_PATTERN_COUNT; i++)
+	{
+		TestSpeedRegExPatternBuild(pattern_buf, i);
+		spd_reg_arr[i] = SpeedRegExCompile(pattern_buf, SPDREGEX_ORDER_SENSE, SPDREGEX_MT_UNSAFE);
+		SpeedRegExSetAdd(spdreg_set, pattern_buf, i);
+	}
+
+	SpeedRegExSetCompile(spdreg_set);
+	printf("COMPILE - [%d] patterns - [%.3f] sec\n", SpeedRegExSetGetCount(spdreg_set), (TestSpeedRegExTimeNow() - begin_time));
+
+	/* One in every eight URLs should hit some rule */
+	for (i = 0; i < BENCH_URL_COUNT; i++)
+	{
+		if (0 == (i % 8))
+			snprintf(url_buf[i], sizeof(url_buf[i]), "http://www.host%05d.example.com/banner/ad%d.gif", ((i * 7) % BENCH_PATTERN_COUNT), i);
+		else
+			snprintf(url_buf[i], sizeof(url_buf[i]), "http://cdn%d.clean-site.org/static/img/photo%d.jpg", i, (i * 13));
+	}
+
+	/* Legacy loop, one SpeedRegExExecute per rule, only first few thousand URLs since it is slow */
+	loop_hits	= 0;
+	begin_time	= TestSpeedRegExTimeNow();
+
+	for (i = 0; i < (BENCH_URL_COUNT / 100); i++)
+	{
+		for (j = 0; j < BENCH_PATTERN_COUNT; j++)
+			loop_hits += SpeedRegExExecute(spd_reg_arr[j], url_buf[i]);
+	}
+
+	loop_time = ((TestSpeedRegExTimeNow() - begin_time) / (BENCH_URL_COUNT / 100));
+	printf("LOOP - [%ld] hits - [%.3f] usec per URL\n", loop_hits, (loop_time * 1000000.0));
+
+	/* Single pass over each URL */
+	set_hits	= 0;
+	begin_time	= TestSpeedRegExTimeNow();
+
+	for (i = 0; i < BENCH_URL_COUNT; i++)
+		set_hits += SpeedRegExSetExecute(spdreg_set, url_buf[i], -1, match_arr, BENCH_MATCH_MAX);
+
+	set_time = ((TestSpeedRegExTimeNow() - begin_time) / BENCH_URL_COUNT);
+	printf("SET - [%ld] hits - [%.3f] usec per URL - [%.1fx] faster\n", set_hits, (set_time * 1000000.0), (loop_time / set_time));
+
+	/* Restart path, load compiled automaton instead of recompiling */
+	dump_mb = MemBufferNew(BRBDATA_THREAD_UNSAFE, 1024);
+	SpeedRegExSetSerialize(spdreg_set, dump_mb);
+
+	begin_time = TestSpeedRegExTimeNow();
+	loaded_set = SpeedRegExSetLoad(MemBufferDeref(dump_mb), MemBufferGetSize(dump_mb), SPDREGEX_MT_UNSAFE);
+	printf("LOAD - [%lu] bytes - [%.3f] sec - [%s]\n", MemBufferGetSize(dump_mb), (TestSpeedRegExTimeNow() - begin_time), (loaded_set ? "OK" : "FAILED"));
+
+	if (!loaded_set)
+		abort();
+
+	/* Combined automaton, compiled or loaded, must report exactly the rules that match one by one */
+	for (i = 0; i < BENCH_CHECK_COUNT; i++)
+	{
+		/* Timed URLs first, then one URL crafted for each rule kind */
+		if (i < (BENCH_CHECK_COUNT / 2))
+			strcpy(pattern_buf, url_buf[i]);
+		else if (0 == (i % 4))
+			snprintf(pattern_buf, sizeof(pattern_buf), "https://www.host%05d.example.com/index.html", ((i * 97) & ~3));
+		else if (1 == (i % 4))
+			snprintf(pattern_buf, sizeof(pattern_buf), "http://ads%d.tracker.com/img/banner.gif", (((i * 97) & ~3) | 1));
+		else if (2 == (i % 4))
+			snprintf(pattern_buf, sizeof(pattern_buf), "http://site.com/track%d/1x1pixel.png", (((i * 97) & ~3) | 2));
+		else
+			snprintf(pattern_buf, sizeof(pattern_buf), "http://exact%d.example.net/", (((i * 97) & ~3) | 3));
+
+		check_hits = TestSpeedRegExSetMatchCheck(spd_reg_arr, spdreg_set, pattern_buf);
+		TestSpeedRegExSetMatchCheck(spd_reg_arr, loaded_set, pattern_buf);
+
+		/* Crafted URLs must hit their rule, or the comparison proves nothing */
+		if ((i >= (BENCH_CHECK_COUNT / 2)) && (check_hits <= 0))
+		{
+			printf("FAILED - URL [%s] - Crafted URL did not hit any rule\n", pattern_buf);
+			abort();
+		}
+	}
+
+	printf("OK - SET and LOADED SET match per rule evaluation on [%d] URLs\n", BENCH_CHECK_COUNT);
+
+	for (i = 0; i < BENCH_PATTERN_COUNT; i++)
+		SpeedRegExDestroy(spd_reg_arr[i]);
+
+	SpeedRegExSetDestroy(loaded_set);
+	SpeedRegExSetDestroy(spdreg_set);
+	MemBufferDestroy(dump_mb);
+	free(spd_reg_arr);
+
+	return;
+}
+/**************************************************************************************************************************/
+static int TestSpeedRegExSetMatchCheck(SpeedRegEx **spd_reg_arr, SpeedRegExSet *spdreg_set, char *url_str)
+{
+	int expect_arr[BENCH_MATCH_MAX];
+	int match_arr[BENCH_MATCH_MAX];
+	int expect_count;
+	int match_count;
+	int i;
+
+	/* Rule IDs are array indexes, so plain loop gives them already sorted */
+	for (expect_count = 0, i = 0; i < BENCH_PATTERN_COUNT; i++)
+	{
+		if ((SpeedRegExExecute(spd_reg_arr[i], url_str)) && (expect_count < BENCH_MATCH_MAX))
+			expect_arr[expect_count++] = i;
+
+		continue;
+	}
+
+	match_count = SpeedRegExSetExecute(spdreg_set, url_str, -1, match_arr, BENCH_MATCH_MAX);
+
+	if (match_count > 1)
+		qsort(match_arr, match_count, sizeof(int), TestSpeedRegExIntCmp);
+
+	if ((match_count != expect_count) || ((match_count > 0) && (memcmp(match_arr, expect_arr, (match_count * sizeof(int))))))
+	{
+		printf("FAILED - URL [%s] - SET [%d] matches - LOOP [%d] matches\n", url_str, match_count, expect_count);
+		abort();
+	}
+
+	return match_count;
+}
+/**************************************************************************************************************************/
+static int TestSpeedRegExIntCmp(const void *a, const void *b)
+{
+	return (*(const int *)a - *(const int *)b);
+}
+/**************************************************************************************************************************/
+static char *TestSpeedRegExPatternBuild(char *pattern_buf, int pattern_idx)
+{
+	/* Mix of suffix, prefix, infix and exact rules */
+	switch (pattern_idx % 4)
+	{
+	case 0:
+		sprintf(pattern_buf, "*host%05d.example.com/*", pattern_idx);
+		break;
+	case 1:
+		sprintf(pattern_buf, "http://ads%d.*/*.gif", pattern_idx);
+		break;
+	case 2:
+		sprintf(pattern_buf, "*/track%d/*pixel*", pattern_idx);
+		break;
+	default:
+		sprintf(pattern_buf, "http://exact%d.example.net/", pattern_idx);
+		break;
+	}
+
+	return pattern_buf;
+}
+/**************************************************************************************************************************/
+static double TestSpeedRegExTimeNow(void)
+{
+	struct timeval current_time;
+
+	gettimeofday(&current_time, NULL);
+	return (current_time.tv_sec + (current_time.tv_usec / 1000000.0));
 }
 /**************************************************************************************************************************/
@@ -0,0 +1,372 @@
+/*
+ * test_aio_watermark.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_data.h>
+#include <libbrb_ev_kq.h>
+
+#define TEST_CHUNK_SZ		1024
+#define TEST_HIGH_SZ		(TEST_CHUNK_SZ * 4)
+#define TEST_LOW_SZ			(TEST_CHUNK_SZ * 1)
+#define TEST_ACCOUNT_SZ		(TEST_CHUNK_SZ * 8)
+
+typedef struct _TestQueueCtx
+{
+	EvAIOReqQueue queue;
+	CommEvBackpressure backpressure;
+
+	int high_count;
+	int low_count;
+	int shed_count;
+	int pause_count;
+	int resume_count;
+} TestQueueCtx;
+
+static EvAIOReqQueueWatermarkCBH TestWatermarkCB;
+static CommEvBackpressureReadCtlCBH TestReadCtlCB;
+static void TestQueueCtxInit(TestQueueCtx *ctx);
+static void TestQueueFill(TestQueueCtx *ctx, int chunk_count);
+static void TestQueueDrop(TestQueueCtx *ctx, int chunk_count);
+static void TestWatermarkAndBackpressure(void);
+static void TestWriteDrain(void);
+static void TestAccountRefuse(void);
+static void TestAccountShedLargest(void);
+static void TestCheck(int cond, char *check_str);
+
+EvKQBase *glob_ev_base;
+char glob_chunk_buf[TEST_CHUNK_SZ];
+
+/**************************************************************************************************************************/
+int main(int argc, char **argv)
+{
+	glob_ev_base = EvKQBaseNew(NULL);
+	memset(&glob_chunk_buf, 'A', sizeof(glob_chunk_buf));
+
+	TestWatermarkAndBackpressure();
+	TestWriteDrain();
+	TestAccountRefuse();
+	TestAccountShedLargest();
+
+	printf("TEST_AIO_WATERMARK - All tests passed\n");
+	exit(0);
+}
+/**************************************************************************************************************************/
+static void TestWatermarkAndBackpressure(void)
+{
+	TestQueueCtx writer;
+	TestQueueCtx reader;
+
+	TestQueueCtxInit(&writer);
+	TestQueueCtxInit(&reader);
+
+	/* READER feeds WRITER queue, so WRITER going above HIGH must pause READER */
+	CommEvBackpressureLink(&writer.backpressure, &reader.backpressure);
+	EvAIOReqQueueWatermarkSet(&writer.queue, TEST_HIGH_SZ, TEST_LOW_SZ, TestWatermarkCB, &writer);
+
+	/* Just below HIGH mark, nothing fires */
+	TestQueueFill(&writer, 3);
+	TestCheck((0 == writer.high_count), "no HIGH below mark");
+	TestCheck((!reader.backpressure.flags.read_paused), "peer reading below HIGH mark");
+
+	/* Reach HIGH, then keep going - Must fire only once */
+	TestQueueFill(&writer, 3);
+	TestCheck((1 == writer.high_count), "HIGH fired once while above mark");
+	TestCheck((reader.backpressure.flags.read_paused), "peer paused above HIGH mark");
+	TestCheck((1 == reader.pause_count), "peer READ_CTL paused once");
+
+	/* Between marks, still paused */
+	TestQueueDrop(&writer, 4);
+	TestCheck((0 == writer.low_count), "no LOW between marks");
+	TestCheck((reader.backpressure.flags.read_paused), "peer still paused between marks");
+
+	/* Reach LOW */
+	TestQueueDrop(&writer, 1);
+	TestCheck((1 == writer.low_count), "LOW fired once at mark");
+	TestCheck((!reader.backpressure.flags.read_paused), "peer resumed at LOW mark");
+	TestCheck((1 == reader.resume_count), "peer READ_CTL resumed once");
+
+	/* Paused again, then link goes away - Nobody must be left paused */
+	TestQueueFill(&writer, 4);
+	TestCheck((2 == writer.high_count), "HIGH fired again after LOW");
+	CommEvBackpressureUnlink(&writer.backpressure);
+	TestCheck((!reader.backpressure.flags.read_paused), "unlink resumes paused peer");
+	TestCheck((2 == reader.resume_count), "unlink resume reached READ_CTL");
+
+	EvAIOReqQueueClean(&writer.queue);
+	EvAIOReqQueueClean(&reader.queue);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestWriteDrain(void)
+{
+	TestQueueCtx writer;
+	EvAIOReq *aio_req;
+	char read_buf[TEST_CHUNK_SZ * 8];
+	long read_total;
+	long wrote_sz;
+	int sock_arr[2];
+	int op_status;
+
+	TestQueueCtxInit(&writer);
+	EvAIOReqQueueWatermarkSet(&writer.queue, TEST_HIGH_SZ, TEST_LOW_SZ, TestWatermarkCB, &writer);
+
+	op_status = socketpair(AF_UNIX, SOCK_STREAM, 0, (int*)&sock_arr);
+	TestCheck((0 == op_status), "socketpair created");
+
+	TestQueueFill(&writer, 8);
+	TestCheck((1 == writer.high_count), "drain queue above HIGH mark");
+
+	/* Partial gather write, last AIO_REQ is left half written */
+	wrote_sz = EvAIOReqQueueWriteVectored(&writer.queue, sock_arr[0], (TEST_CHUNK_SZ * 2) + (TEST_CHUNK_SZ / 2));
+	TestCheck((((TEST_CHUNK_SZ * 2) + (TEST_CHUNK_SZ / 2)) == wrote_sz), "partial gather write honors limit");
+
+	/* Finish fully written heads, as TCP and IPC write events do */
+	while ((aio_req = EvAIOReqQueuePointToHead(&writer.queue)) && (0 == EvAIOReqGetMissingSize(aio_req)))
+	{
+		EvAIOReqQueueDequeue(&writer.queue);
+		EvAIOReqDestroy(aio_req);
+	}
+
+	TestCheck((((TEST_CHUNK_SZ * 6)) == EvAIOReqQueueGetQueueSize(&writer.queue)), "only finished AIO_REQs left queue");
+
+	/* Drain the rest */
+	wrote_sz = EvAIOReqQueueWriteVectored(&writer.queue, sock_arr[0], LONG_MAX);
+	TestCheck((((TEST_CHUNK_SZ * 5) + (TEST_CHUNK_SZ / 2)) == wrote_sz), "gather write resumes at partial offset");
+
+	while ((aio_req = EvAIOReqQueuePointToHead(&writer.queue)) && (0 == EvAIOReqGetMissingSize(aio_req)))
+	{
+		EvAIOReqQueueDequeue(&writer.queue);
+		EvAIOReqDestroy(aio_req);
+	}
+
+	TestCheck((EvAIOReqQueueIsEmpty(&writer.queue)), "queue drained");
+	TestCheck((0 == EvAIOReqQueueGetQueueSize(&writer.queue)), "drained queue size is zero");
+	TestCheck((1 == writer.low_count), "LOW fired once while draining");
+
+	/* Every byte made it to the other side, in order */
+	for (read_total = 0; read_total < sizeof(read_buf); read_total += op_status)
+	{
+		op_status = read(sock_arr[1], &read_buf[read_total], (sizeof(read_buf) - read_total));
+
+		if (op_status <= 0)
+			break;
+	}
+
+	TestCheck((sizeof(read_buf) == read_total), "peer read every drained byte");
+
+	close(sock_arr[0]);
+	close(sock_arr[1]);
+	EvAIOReqQueueClean(&writer.queue);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestAccountRefuse(void)
+{
+	EvAIOReqQueueAccount *account;
+	TestQueueCtx queue_a;
+	TestQueueCtx queue_b;
+
+	TestQueueCtxInit(&queue_a);
+	TestQueueCtxInit(&queue_b);
+
+	account = EvAIOReqQueueAccountNew(TEST_ACCOUNT_SZ, AIOREQ_ACCOUNT_SHED_REFUSE);
+	EvAIOReqQueueAccountLink(&queue_a.queue, account);
+	EvAIOReqQueueAccountLink(&queue_b.queue, account);
+
+	/* Both queues add up against the same cap */
+	TestQueueFill(&queue_a, 5);
+	TestQueueFill(&queue_b, 3);
+	TestCheck((TEST_ACCOUNT_SZ == EvAIOReqQueueAccountGetSize(account)), "account sums all linked queues");
+	TestCheck((!EvAIOReqQueueCanEnqueue(&queue_b.queue, TEST_CHUNK_SZ)), "enqueue over global cap refused");
+	TestCheck((1 == account->stats.refuse_count), "refusal accounted");
+
+	/* Draining any queue makes room for any other */
+	TestQueueDrop(&queue_a, 1);
+	TestCheck((EvAIOReqQueueCanEnqueue(&queue_b.queue, TEST_CHUNK_SZ)), "enqueue fits after drain");
+
+	/* Clean and unlink give bytes back */
+	EvAIOReqQueueClean(&queue_a.queue);
+	TestCheck(((TEST_CHUNK_SZ * 3) == EvAIOReqQueueAccountGetSize(account)), "clean gives bytes back to account");
+	EvAIOReqQueueAccountUnlink(&queue_b.queue);
+	TestCheck((0 == EvAIOReqQueueAccountGetSize(account)), "unlink gives bytes back to account");
+
+	EvAIOReqQueueClean(&queue_b.queue);
+	EvAIOReqQueueAccountDestroy(account);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestAccountShedLargest(void)
+{
+	EvAIOReqQueueAccount *account;
+	TestQueueCtx queue_big;
+	TestQueueCtx queue_small;
+	TestQueueCtx queue_writer;
+
+	TestQueueCtxInit(&queue_big);
+	TestQueueCtxInit(&queue_small);
+	TestQueueCtxInit(&queue_writer);
+
+	account = EvAIOReqQueueAccountNew(TEST_ACCOUNT_SZ, AIOREQ_ACCOUNT_SHED_LARGEST);
+
+	/* Only queues with a watermark handler can be told to go away */
+	EvAIOReqQueueWatermarkSet(&queue_big.queue, (TEST_ACCOUNT_SZ * 2), 0, TestWatermarkCB, &queue_big);
+	EvAIOReqQueueWatermarkSet(&queue_small.queue, (TEST_ACCOUNT_SZ * 2), 0, TestWatermarkCB, &queue_small);
+	EvAIOReqQueueAccountLink(&queue_big.queue, account);
+	EvAIOReqQueueAccountLink(&queue_small.queue, account);
+	EvAIOReqQueueAccountLink(&queue_writer.queue, account);
+
+	TestQueueFill(&queue_big, 5);
+	TestQueueFill(&queue_small, 2);
+	TestQueueFill(&queue_writer, 1);
+
+	/* Owner drops victim from a JOB, so triggering write is refused but largest queue is told to go */
+	TestCheck((!EvAIOReqQueueCanEnqueue(&queue_writer.queue, TEST_CHUNK_SZ)), "over cap write refused while shed is pending");
+	TestCheck((1 == queue_big.shed_count), "largest queue shed");
+	TestCheck((0 == queue_small.shed_count), "smaller queue left alone");
+	TestCheck((1 == account->stats.shed_count), "shed accounted once");
+	TestCheck(((TEST_CHUNK_SZ * 5) == account->stats.shed_sz), "shed size is victim size");
+
+	/* Retries before JOB runs must not pick the same victim again */
+	TestCheck((!EvAIOReqQueueCanEnqueue(&queue_writer.queue, TEST_CHUNK_SZ)), "retry refused while shed is pending");
+	TestCheck((1 == queue_big.shed_count), "pending victim not shed twice");
+	TestCheck((1 == queue_small.shed_count), "next largest queue shed instead");
+	TestCheck((2 == account->stats.shed_count), "shed count not inflated by pending victim");
+	TestCheck(((TEST_CHUNK_SZ * 7) == account->stats.shed_sz), "shed size not inflated by pending victim");
+
+	/* Nothing left to shed, refuse without touching stats */
+	TestCheck((!EvAIOReqQueueCanEnqueue(&queue_writer.queue, TEST_CHUNK_SZ)), "refused with every victim pending");
+	TestCheck((2 == account->stats.shed_count), "no victim left to shed");
+
+	/* JOB drops victims, their bytes are back and the write fits */
+	EvAIOReqQueueClean(&queue_big.queue);
+	EvAIOReqQueueClean(&queue_small.queue);
+	TestCheck((!queue_big.queue.flags.shed_pending), "clean resets shed pending");
+	TestCheck((EvAIOReqQueueCanEnqueue(&queue_writer.queue, TEST_CHUNK_SZ)), "write fits once victims are dropped");
+
+	EvAIOReqQueueClean(&queue_writer.queue);
+	EvAIOReqQueueAccountDestroy(account);
+	return;
+}
+/**************************************************************************************************************************/
+static void TestWatermarkCB(EvAIOReqQueue *aio_req_queue, int wm_code, void *cb_data)
+{
+	TestQueueCtx *ctx = cb_data;
+
+	/* Same reaction as TCP server and client handlers */
+	switch (wm_code)
+	{
+	case AIOREQ_QUEUE_WATERMARK_HIGH:
+		ctx->high_count++;
+		CommEvBackpressurePeerPause(&ctx->backpressure);
+		break;
+	case AIOREQ_QUEUE_WATERMARK_LOW:
+		ctx->low_count++;
+		CommEvBackpressurePeerResume(&ctx->backpressure);
+		break;
+	case AIOREQ_QUEUE_WATERMARK_SHED:
+		ctx->shed_count++;
+		break;
+	default:
+		TestCheck(0, "known watermark code");
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static int TestReadCtlCB(void *owner_ptr, int pause)
+{
+	TestQueueCtx *ctx = owner_ptr;
+
+	if (pause)
+		ctx->pause_count++;
+	else
+		ctx->resume_count++;
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static void TestQueueCtxInit(TestQueueCtx *ctx)
+{
+	memset(ctx, 0, sizeof(TestQueueCtx));
+	EvAIOReqQueueInit(glob_ev_base, &ctx->queue, 1024, AIOREQ_QUEUE_MT_UNSAFE, AIOREQ_QUEUE_SIMPLE);
+	CommEvBackpressureInit(&ctx->backpressure, ctx, TestReadCtlCB);
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestQueueFill(TestQueueCtx *ctx, int chunk_count)
+{
+	EvAIOReq *aio_req;
+	int i;
+
+	for (i = 0; i < chunk_count; i++)
+	{
+		aio_req = EvAIOReqNew(&ctx->queue, -1, ctx, &glob_chunk_buf, TEST_CHUNK_SZ, 0, NULL, NULL, NULL);
+		aio_req->flags.aio_write = 1;
+		EvAIOReqQueueEnqueue(&ctx->queue, aio_req);
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestQueueDrop(TestQueueCtx *ctx, int chunk_count)
+{
+	EvAIOReq *aio_req;
+	int i;
+
+	for (i = 0; i < chunk_count; i++)
+	{
+		aio_req = EvAIOReqQueueDequeue(&ctx->queue);
+		/* Caller asked for more than it filled */
+		if (!aio_req)
+			TestCheck(0, "dequeue from filled queue");
+
+		EvAIOReqDestroy(aio_req);
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void TestCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		fflush(stdout);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/**************************************************************************************************************************/
@@ -35,10 +35,58 @@
 #include <libbrb_data.h>
 #include <libbrb_ev_kq.h>
 
+#define STUB_DEAD_PORT		15353
+#define STUB_LIVE_PORT		15354
+#define STUB_LOOKUP_COUNT	256
+
+/* Answer cache checks - STUB answers with a short TTL, so expiry can be watched without long waits */
+#define CACHE_HOST			"cache.stub.local"
+#define CACHE_HOST_NX		"nx.stub.local"
+#define CACHE_COALESCE_COUNT	8
+#define CACHE_ANSWER_TTL	2
+#define CACHE_TTL_MIN		1
+#define CACHE_NEGATIVE_TTL	2
+#define CACHE_STALE_SEC		2
+#define CACHE_STEP_MS		50
+#define CACHE_TIMEOUT_MS	15000
+
+typedef enum
+{
+	CACHE_STEP_COALESCE,
+	CACHE_STEP_HIT,
+	CACHE_STEP_STALE_WAIT,
+	CACHE_STEP_STALE,
+	CACHE_STEP_NEGATIVE,
+	CACHE_STEP_NEGATIVE_HIT,
+	CACHE_STEP_NEGATIVE_EXPIRE_WAIT,
+	CACHE_STEP_NEGATIVE_EXPIRED,
+} DNSCacheTestStep;
+
 static CommEvDNSResolverCBH DNSResolverCB;
+static CommEvDNSResolverCBH DNSResolverStubCB;
+static CommEvDNSResolverCBH DNSResolverCacheCB;
+static EvBaseKQCBH DNSStubServerReadEvent;
+static EvBaseKQCBH DNSCacheStepTimer;
+static EvBaseKQCBH DNSCacheTimeoutTimer;
+static int DNSStubServerInit(unsigned short port, int answer);
+static DNSCacheEntry *DNSCacheEntryGet(char *host);
+static void DNSResolverStatsShow(EvDNSResolverBase *resolv_base);
+static void DNSResolverStubCheck(int cond, char *check_str);
 
 EvKQBase *glob_ev_base;
 EvDNSResolverBase *glob_ev_dns;
+int glob_stub_reply_count;
+
+struct
+{
+	DNSCacheTestStep step;
+	long expire_ts;
+	long reply_ts;
+	int reply_count;
+	int fail_count;
+	int ip_count;
+	int ttl;
+} glob_cache;
 
 /**************************************************************************************************************************/
 static void DNSResolverCB(void *ev_dns_ptr, void *req_cb_data, void *a_reply_ptr, int code)
@@ -50,7 +98,10 @@ static void DNSResolverCB(void *ev_dns_ptr, void *req_cb_data, void *a_reply_ptr
 	CommEvDNSGetHostByName(glob_ev_dns, "softov.com.br", DNSResolverCB, NULL);
 
 	if (count++ > 64)
+	{
+		DNSResolverStatsShow(glob_ev_dns);
 		exit(0);
+	}
 
 	if (a_reply->ip_count > 0)
 	{
@@ -70,34 +121,379 @@ static void DNSResolverCB(void *ev_dns_ptr, void *req_cb_data, void *a_reply_ptr
 
 	return;
 }
+/**************************************************************************************************************************/
+static void DNSResolverStubCB(void *ev_dns_ptr, void *req_cb_data, void *a_reply_ptr, int code)
+{
+	DNSAReply *a_reply = a_reply_ptr;
+	static int count = 0;
+	static int fail_count = 0;
+
+	if ((DNS_REPLY_SUCCESS != code) || (a_reply->ip_count <= 0))
+		fail_count++;
+
+	if (++count < STUB_LOOKUP_COUNT)
+		return;
+
+	printf("DNSResolverStubCB - Finished [%d] lookups - FAILED [%d] - STUB replies [%d]\n", count, fail_count, glob_stub_reply_count);
+
+	DNSResolverStatsShow(glob_ev_dns);
+
+	/* Every lookup must have left the dead server for the live one */
+	DNSResolverStubCheck((0 == fail_count), "all lookups resolved");
+	DNSResolverStubCheck((STUB_LOOKUP_COUNT == glob_ev_dns->stats.reply_received_valid), "one valid reply per lookup");
+	DNSResolverStubCheck((glob_stub_reply_count >= STUB_LOOKUP_COUNT), "live STUB answered every lookup");
+	DNSResolverStubCheck((0 == glob_ev_dns->server.arr[0].stats.reply_received), "no replies from dead server");
+	DNSResolverStubCheck((glob_ev_dns->server.arr[1].stats.reply_received >= STUB_LOOKUP_COUNT), "live server replies accounted");
+	DNSResolverStubCheck(((glob_ev_dns->stats.request_hedged + glob_ev_dns->server.arr[0].stats.request_timeout) > 0), "lookups hedged or failed over");
+
+	/* Live server answered, so it must be preferred over the silent one */
+	DNSResolverStubCheck((0 == glob_ev_dns->server.arr[1].fail_count), "live server has no pending failures");
+	DNSResolverStubCheck((glob_ev_dns->server.arr[1].srtt_ms > 0), "live server RTT sampled");
+
+	printf("TEST_DNS_RESOLVER - All tests passed\n");
+	exit(0);
+}
+/**************************************************************************************************************************/
+static void DNSResolverCacheCB(void *ev_dns_ptr, void *req_cb_data, void *a_reply_ptr, int code)
+{
+	DNSAReply *a_reply = a_reply_ptr;
+
+	/* Save what upper layers would see, step timer checks it */
+	glob_cache.reply_count++;
+	glob_cache.reply_ts		= glob_ev_base->stats.cur_invoke_ts_sec;
+	glob_cache.ip_count		= a_reply->ip_count;
+	glob_cache.ttl			= ((a_reply->ip_count > 0) ? a_reply->ip_arr[0].ttl : -1);
+
+	if ((DNS_REPLY_SUCCESS != code) || ((a_reply->ip_count > 0) && (a_reply->ip_arr[0].addr.s_addr != inet_addr("127.0.0.1"))))
+		glob_cache.fail_count++;
+
+	return;
+}
+/**************************************************************************************************************************/
+static int DNSCacheStepTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	DNSCacheEntry *cache_entry;
+	long now_ts = glob_ev_base->stats.cur_invoke_ts_sec;
+
+	switch (glob_cache.step)
+	{
+	/* Lookups issued before first reply all ride on one query */
+	case CACHE_STEP_COALESCE:
+	{
+		if (glob_cache.reply_count < CACHE_COALESCE_COUNT)
+			break;
+
+		DNSResolverStubCheck((0 == glob_cache.fail_count), "coalesced lookups resolved");
+		DNSResolverStubCheck((1 == glob_stub_reply_count), "coalesced lookups sent one query");
+		DNSResolverStubCheck((1 == glob_ev_dns->stats.cache_miss), "coalesced lookups counted one miss");
+		DNSResolverStubCheck(((CACHE_COALESCE_COUNT - 1) == glob_ev_dns->stats.cache_coalesced), "coalesced lookups counted");
+
+		CommEvDNSGetHostByName(glob_ev_dns, CACHE_HOST, DNSResolverCacheCB, NULL);
+		glob_cache.step = CACHE_STEP_HIT;
+		break;
+	}
+	case CACHE_STEP_HIT:
+	{
+		if (glob_cache.reply_count < (CACHE_COALESCE_COUNT + 1))
+			break;
+
+		DNSResolverStubCheck((1 == glob_stub_reply_count), "cache hit sent no query");
+		DNSResolverStubCheck((1 == glob_ev_dns->stats.cache_hit), "cache hit counted");
+		DNSResolverStubCheck(((1 == glob_cache.ip_count) && (glob_cache.ttl <= CACHE_ANSWER_TTL)), "cache hit answer with remaining TTL");
+
+		glob_cache.step = CACHE_STEP_STALE_WAIT;
+		break;
+	}
+	/* Past TTL but inside STALE window, answer is served and refreshed in background */
+	case CACHE_STEP_STALE_WAIT:
+	{
+		cache_entry = DNSCacheEntryGet(CACHE_HOST);
+		DNSResolverStubCheck((NULL != cache_entry), "positive answer cached");
+
+		if (now_ts < cache_entry->expire_ts)
+			break;
+
+		DNSResolverStubCheck((now_ts < cache_entry->stale_ts), "inside STALE window");
+
+		glob_cache.expire_ts = cache_entry->expire_ts;
+		CommEvDNSGetHostByName(glob_ev_dns, CACHE_HOST, DNSResolverCacheCB, NULL);
+
+		glob_cache.step = CACHE_STEP_STALE;
+		break;
+	}
+	case CACHE_STEP_STALE:
+	{
+		cache_entry = DNSCacheEntryGet(CACHE_HOST);
+
+		if ((glob_cache.reply_count < (CACHE_COALESCE_COUNT + 2)) || (glob_stub_reply_count < 2) || (cache_entry->inflight_id > -1))
+			break;
+
+		DNSResolverStubCheck((1 == glob_ev_dns->stats.cache_hit_stale), "STALE hit counted");
+		DNSResolverStubCheck(((1 == glob_cache.ip_count) && (0 == glob_cache.ttl)), "STALE answer served with zero TTL");
+		DNSResolverStubCheck((1 == glob_ev_dns->stats.cache_refresh), "STALE hit refreshed once");
+		DNSResolverStubCheck((2 == glob_stub_reply_count), "refresh sent one query");
+		DNSResolverStubCheck((1 == glob_ev_dns->stats.cache_miss), "refresh is not a miss");
+		DNSResolverStubCheck((cache_entry->expire_ts > glob_cache.expire_ts), "refresh extended TTL");
+
+		CommEvDNSGetHostByName(glob_ev_dns, CACHE_HOST_NX, DNSResolverCacheCB, NULL);
+		glob_cache.step = CACHE_STEP_NEGATIVE;
+		break;
+	}
+	/* NXDOMAIN is cached for NEGATIVE_TTL, not for answer TTL */
+	case CACHE_STEP_NEGATIVE:
+	{
+		if (glob_cache.reply_count < (CACHE_COALESCE_COUNT + 3))
+			break;
+
+		cache_entry = DNSCacheEntryGet(CACHE_HOST_NX);
+
+		DNSResolverStubCheck((3 == glob_stub_reply_count), "NXDOMAIN lookup sent one query");
+		DNSResolverStubCheck((glob_cache.ip_count <= 0), "NXDOMAIN lookup has no address");
+		DNSResolverStubCheck(((NULL != cache_entry) && (cache_entry->flags.valid) && (cache_entry->flags.negative)), "NXDOMAIN cached as negative");
+		DNSResolverStubCheck(((glob_cache.reply_ts + CACHE_NEGATIVE_TTL) == cache_entry->expire_ts), "negative answer expires after NEGATIVE_TTL");
+
+		CommEvDNSGetHostByName(glob_ev_dns, CACHE_HOST_NX, DNSResolverCacheCB, NULL);
+		glob_cache.step = CACHE_STEP_NEGATIVE_HIT;
+		break;
+	}
+	case CACHE_STEP_NEGATIVE_HIT:
+	{
+		if (glob_cache.reply_count < (CACHE_COALESCE_COUNT + 4))
+			break;
+
+		DNSResolverStubCheck((3 == glob_stub_reply_count), "negative hit sent no query");
+		DNSResolverStubCheck((1 == glob_ev_dns->stats.cache_hit_negative), "negative hit counted");
+		DNSResolverStubCheck((glob_cache.ip_count <= 0), "negative hit has no address");
+
+		glob_cache.step = CACHE_STEP_NEGATIVE_EXPIRE_WAIT;
+		break;
+	}
+	/* Once past STALE window, negative entry is gone and NAME must go to the wire again */
+	case CACHE_STEP_NEGATIVE_EXPIRE_WAIT:
+	{
+		cache_entry = DNSCacheEntryGet(CACHE_HOST_NX);
+
+		if (now_ts < cache_entry->stale_ts)
+			break;
+
+		CommEvDNSGetHostByName(glob_ev_dns, CACHE_HOST_NX, DNSResolverCacheCB, NULL);
+		glob_cache.step = CACHE_STEP_NEGATIVE_EXPIRED;
+		break;
+	}
+	case CACHE_STEP_NEGATIVE_EXPIRED:
+	{
+		if (glob_cache.reply_count < (CACHE_COALESCE_COUNT + 5))
+			break;
+
+		DNSResolverStubCheck((4 == glob_stub_reply_count), "expired negative answer sent a new query");
+		DNSResolverStubCheck((3 == glob_ev_dns->stats.cache_miss), "expired negative answer counted as miss");
+		DNSResolverStubCheck((1 == glob_ev_dns->stats.cache_hit_negative), "expired negative answer not served");
+		DNSResolverStubCheck((0 == glob_cache.fail_count), "cached lookups resolved");
+
+		DNSResolverStatsShow(glob_ev_dns);
+
+		printf("TEST_DNS_RESOLVER - Cache - All tests passed\n");
+		exit(0);
+	}
+	}
+
+	EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, CACHE_STEP_MS, DNSCacheStepTimer, NULL);
+	return 1;
+}
+/**************************************************************************************************************************/
+static int DNSCacheTimeoutTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	printf("DNSCacheTimeoutTimer - Stuck at STEP [%d] - REPLIES [%d] - STUB replies [%d]\n", glob_cache.step, glob_cache.reply_count, glob_stub_reply_count);
+
+	DNSResolverStatsShow(glob_ev_dns);
+	DNSResolverStubCheck(0, "cache test finished before timeout");
+	return 0;
+}
+/**************************************************************************************************************************/
+static DNSCacheEntry *DNSCacheEntryGet(char *host)
+{
+	char key_str[RESOLVER_DNS_CACHE_KEY_SZ];
+
+	/* Same key resolver builds for TYPE_A lookups */
+	snprintf((char*)&key_str, sizeof(key_str), "%s/A", host);
+	return AssocArrayLookup(glob_ev_dns->cache.table, (char*)&key_str);
+}
+/**************************************************************************************************************************/
+static int DNSStubServerReadEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	unsigned char answer_rr[] = { 0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, CACHE_ANSWER_TTL, 0x00, 0x04, 127, 0, 0, 1 };
+	struct sockaddr_in from_addr;
+	socklen_t from_addr_sz;
+	char packet_buf[1024];
+	int data_read;
+
+	int answer = (long)cb_data;
+
+	from_addr_sz	= sizeof(struct sockaddr_in);
+	data_read		= recvfrom(fd, &packet_buf, (sizeof(packet_buf) - sizeof(answer_rr)), 0, (struct sockaddr *)&from_addr, &from_addr_sz);
+
+	/* Dead server just swallows queries */
+	if ((data_read < 12) || (!answer))
+		goto leave;
+
+	/* Flip QR bit */
+	packet_buf[2]	|= 0x80;
+
+	/* First label is NX, answer NXDOMAIN with no records */
+	if ((data_read > 15) && (2 == packet_buf[12]) && (!memcmp(&packet_buf[13], "nx", 2)))
+	{
+		packet_buf[3]	= ((packet_buf[3] & 0xF0) | RFC1035_RCODE_NXDOMAIN);
+
+		sendto(fd, &packet_buf, data_read, 0, (struct sockaddr *)&from_addr, from_addr_sz);
+		glob_stub_reply_count++;
+		goto leave;
+	}
+
+	/* Set ANCOUNT to one and append a single A record */
+	packet_buf[6]	= 0;
+	packet_buf[7]	= 1;
+	memcpy(&packet_buf[data_read], &answer_rr, sizeof(answer_rr));
+
+	sendto(fd, &packet_buf, (data_read + sizeof(answer_rr)), 0, (struct sockaddr *)&from_addr, from_addr_sz);
+	glob_stub_reply_count++;
+
+	leave:
+
+	EvKQBaseSetEvent(glob_ev_base, fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, DNSStubServerReadEvent, cb_data);
+	return data_read;
+}
+/**************************************************************************************************************************/
+static int DNSStubServerInit(unsigned short port, int answer)
+{
+	struct in_addr bind_ip;
+	int fd;
+
+	bind_ip.s_addr	= inet_addr("127.0.0.1");
+	fd				= EvKQBaseSocketUDPNewAndBind(glob_ev_base, &bind_ip, port);
+
+	if (fd < 0)
+	{
+		printf("DNSStubServerInit - Failed binding STUB server on PORT [%u]\n", port);
+		exit(1);
+	}
+
+	EvKQBaseSocketSetNonBlock(glob_ev_base, fd);
+	EvKQBaseSetEvent(glob_ev_base, fd, COMM_EV_READ, COMM_ACTION_ADD_VOLATILE, DNSStubServerReadEvent, (void*)(long)answer);
+
+	return fd;
+}
+/**************************************************************************************************************************/
+static void DNSResolverStatsShow(EvDNSResolverBase *resolv_base)
+{
+	DNSUpstreamServer *upstream_server;
+	int i;
+
+	printf("STATS - SENT [%ld] - VALID [%ld] - TIMEOUT [%ld] - HEDGED [%ld] - UNMATCHED [%ld] - HEDGE_DELAY [%d ms]\n",
+			resolv_base->stats.request_sent_write, resolv_base->stats.reply_received_valid, resolv_base->stats.request_timeout,
+			resolv_base->stats.request_hedged, resolv_base->stats.reply_unmatched, resolv_base->hedge.delay_ms);
+
+	for (i = 0; i < resolv_base->server.count; i++)
+	{
+		upstream_server = &resolv_base->server.arr[i];
+
+		printf("SERVER [%d] - [%s:%u] - SENT [%ld] - REPLIES [%ld] - TIMEOUTS [%ld] - SRTT [%d ms]\n", i, inet_ntoa(upstream_server->addr.sin_addr),
+				ntohs(upstream_server->addr.sin_port), upstream_server->stats.request_sent, upstream_server->stats.reply_received,
+				upstream_server->stats.request_timeout, upstream_server->srtt_ms);
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void DNSResolverStubCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		abort();
+	}
 
+	printf("OK - %s\n", check_str);
+	return;
+}
 /**************************************************************************************************************************/
 int main(int argc, char **argv)
 {
 	EvDNSResolverConf dns_conf;
-	int kq_retcode;
+	char host_buf[64];
+	int i;
 
 	glob_ev_base	= EvKQBaseNew(NULL);
 	memset(&dns_conf, 0, sizeof(EvDNSResolverConf));
 
 	if (argc < 2)
 	{
-		printf("Usage - %s HOSTNAME DNS_IP\n", argv[0]);
+		printf("Usage - %s HOSTNAME [DNS_IP[:PORT][,DNS_IP[:PORT]...]]\n", argv[0]);
+		printf("Usage - %s --stub - Resolve against a dead and a live local STUB server\n", argv[0]);
+		printf("Usage - %s --stub-cache - Check answer cache against a local STUB server\n", argv[0]);
 		exit(0);
 	}
 
-	char *host_str 				= argv[1] ? argv[1] : "www.brbyte.com";
-	/* Fill up DNS configuration */
-	dns_conf.dns_ip_str			= argv[2] ? argv[2] : "8.8.8.8";
+	/* Fill up DNS configuration - Default PORT for servers listed without one */
 	dns_conf.dns_port			= 8081;
 	dns_conf.lookup_timeout_ms	= 500;
 	dns_conf.retry_timeout_ms	= 50;
 	dns_conf.retry_count		= 10;
+	dns_conf.socket_count		= 4;
 
-	glob_ev_dns		= CommEvDNSResolverBaseNew(glob_ev_base, &dns_conf);
+	/* Resolve against local STUB servers - First one never answers, so lookups must hedge or fail over to second */
+	if (!strcmp(argv[1], "--stub"))
+	{
+		DNSStubServerInit(STUB_DEAD_PORT, 0);
+		DNSStubServerInit(STUB_LIVE_PORT, 1);
+
+		dns_conf.dns_ip_str			= "127.0.0.1:15353,127.0.0.1:15354";
+		dns_conf.lookup_timeout_ms	= 2000;
+		dns_conf.retry_timeout_ms	= 200;
+		dns_conf.flags.cache_disabled	= 1;
+
+		glob_ev_dns		= CommEvDNSResolverBaseNew(glob_ev_base, &dns_conf);
+
+		/* Schedule DNS queries */
+		for (i = 0; i < STUB_LOOKUP_COUNT; i++)
+		{
+			snprintf((char*)&host_buf, sizeof(host_buf), "host-%d.stub.local", i);
+			CommEvDNSGetHostByName(glob_ev_dns, (char*)&host_buf, DNSResolverStubCB, NULL);
+		}
+	}
+	/* Answer cache against a single STUB server - No hedge and slow retry, so every query STUB sees is a cache decision */
+	else if (!strcmp(argv[1], "--stub-cache"))
+	{
+		DNSStubServerInit(STUB_LIVE_PORT, 1);
+
+		dns_conf.dns_ip_str				= "127.0.0.1:15354";
+		dns_conf.lookup_timeout_ms		= 2000;
+		dns_conf.retry_timeout_ms		= 1000;
+		dns_conf.cache.ttl_min			= CACHE_TTL_MIN;
+		dns_conf.cache.negative_ttl		= CACHE_NEGATIVE_TTL;
+		dns_conf.cache.stale_sec		= CACHE_STALE_SEC;
+		dns_conf.flags.hedge_disabled	= 1;
 
-	/* Schedule new DNS query */
-	CommEvDNSGetHostByName(glob_ev_dns, host_str, DNSResolverCB, NULL);
+		glob_ev_dns		= CommEvDNSResolverBaseNew(glob_ev_base, &dns_conf);
+
+		/* Same NAME asked many times before any reply */
+		for (i = 0; i < CACHE_COALESCE_COUNT; i++)
+			CommEvDNSGetHostByName(glob_ev_dns, CACHE_HOST, DNSResolverCacheCB, NULL);
+
+		EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, CACHE_STEP_MS, DNSCacheStepTimer, NULL);
+		EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, CACHE_TIMEOUT_MS, DNSCacheTimeoutTimer, NULL);
+
+		/* Jump into event loop */
+		while (1)
+			EvKQBaseDispatch(glob_ev_base, 100);
+	}
+	else
+	{
+		dns_conf.dns_ip_str			= argv[2] ? argv[2] : "8.8.8.8";
+		glob_ev_dns		= CommEvDNSResolverBaseNew(glob_ev_base, &dns_conf);
+
+		/* Schedule new DNS query */
+		CommEvDNSGetHostByName(glob_ev_dns, argv[1], DNSResolverCB, NULL);
+	}
 
 	/* Jump into event loop */
 	EvKQBaseDispatch(glob_ev_base, 100);
@@ -0,0 +1,223 @@
+/*
+ * test_ipc.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_data.h>
+#include <libbrb_ev_kq.h>
+
+#define IPC_LINE_COUNT		512
+#define IPC_BULK_LINE_COUNT	4096
+#define IPC_TIMEOUT_MS		10000
+
+static IPCEvCBH IPCParentReadCB;
+static IPCEvCBH IPCParentCloseCB;
+static IPCEvCBH IPCParentFinishCB;
+static IPCEvCBH IPCChildReadCB;
+static IPCEvCBH IPCChildCloseCB;
+static EvBaseKQCBH IPCTimeoutTimer;
+static int IPCChildMain(void);
+static int IPCParentMain(char *prog);
+static void IPCTestCheck(int cond, char *check_str);
+
+EvKQBase *glob_ev_base;
+EvIPCBaseChild *glob_ipc_child;
+MemBuffer *glob_expect_mb;
+MemBuffer *glob_bulk_mb;
+unsigned long glob_recv_sz;
+int glob_finish_count;
+int glob_write_count;
+
+/**************************************************************************************************************************/
+int main(int argc, char **argv)
+{
+	/* Re-executed by IPC parent, we are the echo child */
+	if ((argc > 1) && (!strcmp(argv[1], "--child")))
+		return IPCChildMain();
+
+	return IPCParentMain(argv[0]);
+}
+/**************************************************************************************************************************/
+static int IPCParentMain(char *prog)
+{
+	EvIPCBase *ipc_base;
+	char *args[3];
+	char line_buf[64];
+	int line_sz;
+	int i;
+
+	glob_ev_base	= EvKQBaseNew(NULL);
+	ipc_base		= EvIPCBaseNew(glob_ev_base);
+	glob_expect_mb	= MemBufferNew(BRBDATA_THREAD_UNSAFE, 65535);
+	glob_bulk_mb	= MemBufferNew(BRBDATA_THREAD_UNSAFE, 65535);
+
+	EvIPCBaseEventSet(ipc_base, IPC_EVENT_READ, IPCParentReadCB, NULL);
+	EvIPCBaseEventSet(ipc_base, IPC_EVENT_CLOSE, IPCParentCloseCB, NULL);
+
+	/* Fire the child, which echoes back every line it reads */
+	args[0] = prog;
+	args[1] = "--child";
+	args[2] = NULL;
+
+	IPCTestCheck((EvIPCBaseExecute(ipc_base, prog, (char**)&args) > 0), "child executed");
+
+	/* Small writes, IPC creates their AIO_REQs with FD -1, write queue must still drain them */
+	for (i = 0; i < IPC_LINE_COUNT; i++)
+	{
+		line_sz = snprintf((char*)&line_buf, sizeof(line_buf), "PING [%04d]\n", i);
+		MemBufferAdd(glob_expect_mb, &line_buf, line_sz);
+
+		EvIPCWriteStringFmt(ipc_base, IPCParentFinishCB, NULL, "PING [%04d]\n", i);
+		glob_write_count++;
+	}
+
+	/* Bulk buffer larger than socket buffer, forces partial vectored writes */
+	for (i = 0; i < IPC_BULK_LINE_COUNT; i++)
+	{
+		line_sz = snprintf((char*)&line_buf, sizeof(line_buf), "BULK [%04d] - ABCDEFGHIJKLMNOPQRSTUVWXYZ\n", i);
+		MemBufferAdd(glob_bulk_mb, &line_buf, line_sz);
+	}
+
+	MemBufferAdd(glob_expect_mb, MemBufferDeref(glob_bulk_mb), MemBufferGetSize(glob_bulk_mb));
+	EvIPCWriteMemBuffer(ipc_base, IPCParentFinishCB, NULL, glob_bulk_mb);
+	glob_write_count++;
+
+	/* Never wait forever if echo stalls */
+	EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, IPC_TIMEOUT_MS, IPCTimeoutTimer, NULL);
+
+	/* Jump into event loop */
+	while (1)
+		EvKQBaseDispatch(glob_ev_base, 100);
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static int IPCChildMain(void)
+{
+	EvIPCBaseChildConf child_conf;
+
+	/* Child STDOUT is the IPC channel, never print from here */
+	memset(&child_conf, 0, sizeof(EvIPCBaseChildConf));
+	child_conf.self_sync.token_str		= "\n";
+	child_conf.self_sync.max_buffer_sz	= 1048576;
+
+	glob_ev_base	= EvKQBaseNew(NULL);
+	glob_ipc_child	= EvIPCBaseChildNew(glob_ev_base, &child_conf);
+
+	EvIPCBaseChildEventSet(glob_ipc_child, IPC_EVENT_READ, IPCChildReadCB, NULL);
+	EvIPCBaseChildEventSet(glob_ipc_child, IPC_EVENT_CLOSE, IPCChildCloseCB, NULL);
+	EvIPCBaseChildInit(glob_ev_base, glob_ipc_child);
+
+	/* Jump into event loop */
+	while (1)
+		EvKQBaseDispatch(glob_ev_base, 100);
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static void IPCParentReadCB(int fd, int data_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	EvIPCBase *ipc_base = base_ptr;
+	unsigned long read_sz;
+	char *read_ptr;
+
+	read_ptr	= MemBufferDeref(ipc_base->read_buffer);
+	read_sz		= MemBufferGetSize(ipc_base->read_buffer);
+
+	/* Echo must never exceed, nor diverge from, what we sent */
+	if ((glob_recv_sz + read_sz) > MemBufferGetSize(glob_expect_mb))
+		IPCTestCheck(0, "echo not larger than sent data");
+	else if (memcmp(MemBufferOffsetDeref(glob_expect_mb, glob_recv_sz), read_ptr, read_sz))
+		IPCTestCheck(0, "echo matches sent data");
+
+	glob_recv_sz += read_sz;
+	MemBufferClean(ipc_base->read_buffer);
+
+	/* Not there yet */
+	if (glob_recv_sz < MemBufferGetSize(glob_expect_mb))
+		return;
+
+	IPCTestCheck(1, "echo matches sent data");
+	IPCTestCheck((glob_finish_count == glob_write_count), "every write finish callback fired");
+
+	printf("TEST_IPC - Echoed [%lu] bytes over [%d] writes\n", glob_recv_sz, glob_write_count);
+	printf("TEST_IPC - All tests passed\n");
+	exit(0);
+}
+/**************************************************************************************************************************/
+static void IPCParentCloseCB(int fd, int data_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	IPCTestCheck(0, "child closed before echo completed");
+	return;
+}
+/**************************************************************************************************************************/
+static void IPCParentFinishCB(int fd, int data_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	glob_finish_count++;
+	return;
+}
+/**************************************************************************************************************************/
+static void IPCChildReadCB(int fd, int data_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	EvIPCBaseChild *ipc_base_child = base_ptr;
+
+	/* SELF_SYNC hands us whole NULL terminated lines, echo them back as they are */
+	EvIPCBaseChildWriteStringFmt(ipc_base_child, NULL, NULL, "%s", MemBufferDeref(ipc_base_child->read_buffer));
+	return;
+}
+/**************************************************************************************************************************/
+static void IPCChildCloseCB(int fd, int data_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	/* Parent is gone, so are we */
+	exit(0);
+}
+/**************************************************************************************************************************/
+static int IPCTimeoutTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	printf("TEST_IPC - Received [%lu] of [%lu] bytes - FINISH [%d] of [%d]\n", glob_recv_sz, MemBufferGetSize(glob_expect_mb), glob_finish_count, glob_write_count);
+	IPCTestCheck(0, "echo completed before timeout");
+	return 0;
+}
+/**************************************************************************************************************************/
+static void IPCTestCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		fflush(stdout);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/**************************************************************************************************************************/
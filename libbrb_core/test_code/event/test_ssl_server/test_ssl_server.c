@@ -97,7 +97,7 @@ void SSLServerEventsSNIParseEvent(int fd, int to_read_sz, int thrd_id, void *cb_
 	}
 
 	//printf("SSLServerEventsSNIParseEvent - Will use CERT [%s] for TLS/VHOST OFF [%d]-[*.%s]\n", CommEvSSLUtils_X509ToStr(conn_hnd->ssldata.x509_cert),
-	//		conn_hnd->ssldata.sni_host_tldpos, &conn_hnd->ssldata.sni_host_str[conn_hnd->ssldata.sni_host_tldpos]);
+	//		conn_hnd->ssldata.sni_host_tldpos, &conn_hnd->ssldata.sni_host_ptr[conn_hnd->ssldata.sni_host_tldpos]);
 
 	return;
 }
@@ -189,7 +189,7 @@ void PlainServerEventsAcceptEvent(int fd, int to_read_sz, int thrd_id, void *cb_
 	printf("PlainServerEventsAcceptEvent - Accept client from IP [%s]\n", conn_hnd->string_ip);
 
 	/* Load CRYPTO_RC4 TRANSFORM */
-//	EvAIOReqTransform_CryptoEnable(&conn_hnd->transform, COMM_CRYPTO_FUNC_RC4_MD5, "cryptokey", strlen("cryptokey"));
+//	EvAIOReqTransform_CryptoEnable(CommEvTCPServerConnTransformGrab(conn_hnd), COMM_CRYPTO_FUNC_RC4_MD5, "cryptokey", strlen("cryptokey"));
 
 	CommEvTCPServerConnAIOWriteString(conn_hnd, "ENCRYPTED ACCEPT aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\n", NULL, NULL);
 
@@ -0,0 +1,493 @@
+/*
+ * test_tcp_clientpool.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_data.h>
+#include <libbrb_ev_kq.h>
+
+#define POOL_ECHO_PORT			15370
+#define POOL_CLI_INIT			4
+#define POOL_CLI_MAX			6
+#define POOL_HEALTH_MS			100
+#define POOL_STEP_MS			50
+#define POOL_TIMEOUT_MS			30000
+#define POOL_SELECT_ROUNDS		100
+#define POOL_VICTIM_ID			1
+#define POOL_PING_STR			"PING\n"
+
+typedef enum
+{
+	POOL_STEP_CONNECT,
+	POOL_STEP_ECHO,
+	POOL_STEP_PROBE_WAIT,
+	POOL_STEP_READMIT,
+	POOL_STEP_GROW,
+	POOL_STEP_SHRINK,
+	POOL_STEP_REGROW,
+} PoolTestStep;
+
+static CommEvTCPServerCBH PoolEchoServerReadEvent;
+static CommEvTCPClientCBH PoolClientReadEvent;
+static EvBaseKQCBH PoolStepTimer;
+static EvBaseKQCBH PoolTimeoutTimer;
+static void PoolEchoServerInit(void);
+static void PoolSpreadCheck(void);
+static void PoolEjectCheck(void);
+static void PoolProbeCheck(void);
+static void PoolSlotCheck(int count_init, int count_alloc);
+static void PoolRoundRobinCount(int *count_arr, int round_count);
+static void PoolLoadInject(int cli_count, int load);
+static int PoolConnectedCount(void);
+static void PoolTestCheck(int cond, char *check_str);
+
+EvKQBase *glob_ev_base;
+CommEvTCPServer *glob_tcp_srv;
+CommEvTCPClientPool *glob_tcp_clientpool;
+PoolTestStep glob_step;
+
+/**************************************************************************************************************************/
+int main(int argc, char **argv)
+{
+	CommEvTCPClientPoolConf pool_conf;
+	CommEvTCPClientConf cli_conf;
+
+	memset(&pool_conf, 0, sizeof(CommEvTCPClientPoolConf));
+	memset(&cli_conf, 0, sizeof(CommEvTCPClientConf));
+
+	glob_ev_base						= EvKQBaseNew(NULL);
+	PoolEchoServerInit();
+
+	/* Never shrink below initial size, so selection checks always see the same members */
+	pool_conf.cli_count_init			= POOL_CLI_INIT;
+	pool_conf.cli_count_min				= POOL_CLI_INIT;
+	pool_conf.cli_count_max				= POOL_CLI_MAX;
+	pool_conf.health_check_ms			= POOL_HEALTH_MS;
+	pool_conf.flags.auto_resize			= 1;
+
+	glob_tcp_clientpool					= CommEvTCPClientPoolNew(glob_ev_base, &pool_conf);
+	PoolTestCheck((!glob_tcp_clientpool->flags.has_error), "pool created");
+
+	cli_conf.cli_proto					= COMM_CLIENTPROTO_PLAIN;
+	cli_conf.read_mthd					= COMM_CLIENT_READ_MEMBUFFER;
+	cli_conf.hostname					= "127.0.0.1";
+	cli_conf.port						= POOL_ECHO_PORT;
+	cli_conf.timeout.connect_ms			= 1000;
+
+	/* NULL on PoolEventSet will set SELF as CBDATA */
+	CommEvTCPClientPoolEventSet(glob_tcp_clientpool, COMM_CLIENT_EVENT_READ, PoolClientReadEvent, NULL);
+	CommEvTCPClientPoolConnect(glob_tcp_clientpool, &cli_conf);
+
+	EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, POOL_STEP_MS, PoolStepTimer, NULL);
+	EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, POOL_TIMEOUT_MS, PoolTimeoutTimer, NULL);
+
+	/* Jump into event loop */
+	while (1)
+		EvKQBaseDispatch(glob_ev_base, 100);
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static int PoolStepTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvPoolHealth *victim_health = &glob_tcp_clientpool->health.arr[POOL_VICTIM_ID];
+	int i;
+
+	switch (glob_step)
+	{
+	/* Wait whole pool to reach loopback echo server */
+	case POOL_STEP_CONNECT:
+	{
+		if (PoolConnectedCount() < POOL_CLI_INIT)
+			break;
+
+		PoolTestCheck(1, "all pool members connected");
+		PoolSpreadCheck();
+
+		/* One real round trip per member, READ must answer the pending write */
+		for (i = 0; i < POOL_CLI_INIT; i++)
+			CommEvTCPClientPoolAIOWrite(glob_tcp_clientpool, COMM_POOL_SELECT_ROUND_ROBIN, POOL_PING_STR, strlen(POOL_PING_STR), NULL, NULL);
+
+		glob_step = POOL_STEP_ECHO;
+		break;
+	}
+	case POOL_STEP_ECHO:
+	{
+		for (i = 0; i < POOL_CLI_INIT; i++)
+		{
+			if ((glob_tcp_clientpool->health.arr[i].sample_count < 1) || (glob_tcp_clientpool->health.arr[i].pending_count > 0))
+				goto reschedule;
+		}
+
+		PoolTestCheck(1, "echo replies sampled on every member");
+		PoolEjectCheck();
+
+		glob_step = POOL_STEP_PROBE_WAIT;
+		break;
+	}
+	/* Back-off must elapse before ejected member is offered a probe */
+	case POOL_STEP_PROBE_WAIT:
+	{
+		if (EvKQBaseTimeValSubMsec(&victim_health->ejected_tv, &glob_ev_base->stats.cur_invoke_tv) < (victim_health->eject_ms + POOL_STEP_MS))
+			break;
+
+		PoolProbeCheck();
+
+		glob_step = POOL_STEP_READMIT;
+		break;
+	}
+	case POOL_STEP_READMIT:
+	{
+		if (victim_health->flags.ejected)
+			break;
+
+		PoolTestCheck((!victim_health->flags.probing), "answered probe readmits member");
+		PoolTestCheck((0 == victim_health->fail_count), "readmitted member failure count reset");
+
+		/* Enough in flight to make health timer grow the pool up to MAX */
+		PoolLoadInject(POOL_CLI_INIT, (COMM_POOL_RESIZE_GROW_LOAD * 2));
+
+		glob_step = POOL_STEP_GROW;
+		break;
+	}
+	case POOL_STEP_GROW:
+	{
+		if ((glob_tcp_clientpool->client.count_init < POOL_CLI_MAX) || (PoolConnectedCount() < POOL_CLI_MAX))
+			break;
+
+		PoolTestCheck(1, "loaded pool grew to MAX");
+		PoolSlotCheck(POOL_CLI_MAX, POOL_CLI_MAX);
+
+		/* Work is done, idle ticks shrink pool back to MIN */
+		for (i = 0; i < POOL_CLI_MAX; i++)
+			CommEvPoolHealthClean(&glob_tcp_clientpool->health.arr[i]);
+
+		glob_step = POOL_STEP_SHRINK;
+		break;
+	}
+	case POOL_STEP_SHRINK:
+	{
+		if (glob_tcp_clientpool->client.count_init > POOL_CLI_INIT)
+			break;
+
+		PoolTestCheck((POOL_CLI_INIT == glob_tcp_clientpool->client.count_init), "idle pool shrank to MIN");
+		PoolSlotCheck(POOL_CLI_INIT, POOL_CLI_MAX);
+
+		/* Load again, GROW must reuse slots left behind by SHRINK */
+		PoolLoadInject(POOL_CLI_INIT, (COMM_POOL_RESIZE_GROW_LOAD * 2));
+
+		glob_step = POOL_STEP_REGROW;
+		break;
+	}
+	case POOL_STEP_REGROW:
+	{
+		if ((glob_tcp_clientpool->client.count_init < POOL_CLI_MAX) || (PoolConnectedCount() < POOL_CLI_MAX))
+			break;
+
+		PoolTestCheck(1, "pool grew again after shrink");
+		PoolSlotCheck(POOL_CLI_MAX, POOL_CLI_MAX);
+
+		printf("TEST_TCP_CLIENTPOOL - All tests passed\n");
+		exit(0);
+	}
+	}
+
+	/* TAG to check again on next step */
+	reschedule:
+
+	EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, POOL_STEP_MS, PoolStepTimer, NULL);
+	return 1;
+}
+/**************************************************************************************************************************/
+static void PoolSpreadCheck(void)
+{
+	CommEvTCPClient *ev_tcpclient;
+	int count_arr[COMM_TCP_CLIENT_POOL_MAX];
+	int count_min;
+	int count_max;
+	int i;
+
+	/* Round robin visits every healthy member the same number of times */
+	PoolRoundRobinCount((int*)&count_arr, (POOL_CLI_INIT * POOL_SELECT_ROUNDS));
+
+	for (i = 0; i < POOL_CLI_INIT; i++)
+	{
+		if (POOL_SELECT_ROUNDS != count_arr[i])
+			PoolTestCheck(0, "round robin spreads evenly");
+	}
+
+	PoolTestCheck(1, "round robin spreads evenly");
+
+	/* Power of two picks less loaded of each draw, every pick adds load as a pool write would */
+	memset(&count_arr, 0, sizeof(count_arr));
+
+	for (i = 0; i < (POOL_CLI_INIT * POOL_SELECT_ROUNDS); i++)
+	{
+		ev_tcpclient = CommEvTCPClientPoolClientSelect(glob_tcp_clientpool, COMM_POOL_SELECT_POWER_OF_TWO, COMM_CLIENT_STATE_CONNECTED);
+
+		if (!ev_tcpclient)
+			PoolTestCheck(0, "power of two selects a member");
+
+		count_arr[ev_tcpclient->cli_id_onpool]++;
+		CommEvPoolHealthWriteMark(&glob_tcp_clientpool->health.arr[ev_tcpclient->cli_id_onpool], &glob_ev_base->stats.cur_invoke_tv);
+	}
+
+	for (i = 0, count_min = INT_MAX, count_max = 0; i < POOL_CLI_INIT; i++)
+	{
+		count_min = ((count_arr[i] < count_min) ? count_arr[i] : count_min);
+		count_max = ((count_arr[i] > count_max) ? count_arr[i] : count_max);
+
+		CommEvPoolHealthClean(&glob_tcp_clientpool->health.arr[i]);
+	}
+
+	printf("PoolSpreadCheck - POWER_OF_TWO - MIN [%d] - MAX [%d]\n", count_min, count_max);
+	PoolTestCheck(((count_max - count_min) <= (POOL_SELECT_ROUNDS / 10)), "power of two keeps load balanced");
+
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolEjectCheck(void)
+{
+	CommEvPoolHealth *victim_health = &glob_tcp_clientpool->health.arr[POOL_VICTIM_ID];
+	CommEvTCPClient *victim_client	= MemSlotBaseSlotGrabByID(&glob_tcp_clientpool->client.memslot, POOL_VICTIM_ID);
+	int count_arr[COMM_TCP_CLIENT_POOL_MAX];
+	int i;
+
+	/* Writes left unanswered by a closing peer are failures, FAIL_MAX of them eject */
+	for (i = 0; i < COMM_POOL_HEALTH_FAIL_MAX; i++)
+	{
+		if (victim_health->flags.ejected)
+			PoolTestCheck(0, "member kept until FAIL_MAX");
+
+		CommEvPoolHealthWriteMark(victim_health, &glob_ev_base->stats.cur_invoke_tv);
+		CommEvTCPClientPoolClientEventNotify(glob_tcp_clientpool, victim_client, COMM_CLIENT_EVENT_CLOSE);
+	}
+
+	PoolTestCheck((victim_health->flags.ejected), "failing member ejected");
+	PoolTestCheck((COMM_POOL_HEALTH_EJECT_MIN_MS == victim_health->eject_ms), "first ejection uses minimum back-off");
+
+	/* Ejected member is out of every selection method */
+	PoolRoundRobinCount((int*)&count_arr, ((POOL_CLI_INIT - 1) * POOL_SELECT_ROUNDS));
+
+	for (i = 0; i < POOL_CLI_INIT; i++)
+	{
+		if ((POOL_VICTIM_ID == i) ? (0 != count_arr[i]) : (POOL_SELECT_ROUNDS != count_arr[i]))
+			PoolTestCheck(0, "round robin skips ejected member");
+	}
+
+	PoolTestCheck(1, "round robin skips ejected member");
+
+	for (i = 0; i < (POOL_CLI_INIT * POOL_SELECT_ROUNDS); i++)
+	{
+		if (victim_client == CommEvTCPClientPoolClientSelect(glob_tcp_clientpool, COMM_POOL_SELECT_POWER_OF_TWO, COMM_CLIENT_STATE_CONNECTED))
+			PoolTestCheck(0, "power of two skips ejected member");
+
+		if (victim_client == CommEvTCPClientPoolClientSelect(glob_tcp_clientpool, COMM_POOL_SELECT_LEAST_LATENCY, COMM_CLIENT_STATE_CONNECTED))
+			PoolTestCheck(0, "least latency skips ejected member");
+	}
+
+	PoolTestCheck(1, "power of two and least latency skip ejected member");
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolProbeCheck(void)
+{
+	CommEvPoolHealth *victim_health = &glob_tcp_clientpool->health.arr[POOL_VICTIM_ID];
+	int i;
+
+	PoolTestCheck((CommEvPoolHealthCanSelect(victim_health, &glob_ev_base->stats.cur_invoke_tv)), "ejected member selectable after back-off");
+
+	/* Real write to every member, the one landing on the ejected member is its probe */
+	for (i = 0; i < POOL_CLI_INIT; i++)
+		CommEvTCPClientPoolAIOWrite(glob_tcp_clientpool, COMM_POOL_SELECT_ROUND_ROBIN, POOL_PING_STR, strlen(POOL_PING_STR), NULL, NULL);
+
+	PoolTestCheck((victim_health->flags.probing), "write to ejected member is a probe");
+	PoolTestCheck((!CommEvPoolHealthCanSelect(victim_health, &glob_ev_base->stats.cur_invoke_tv)), "only one probe in flight");
+
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolSlotCheck(int count_init, int count_alloc)
+{
+	CommEvTCPClient *ev_tcpclient;
+	int count_arr[COMM_TCP_CLIENT_POOL_MAX];
+	int i;
+
+	PoolTestCheck((count_init == glob_tcp_clientpool->client.count_init), "active member count");
+	PoolTestCheck((count_alloc == glob_tcp_clientpool->client.count_alloc), "slot count, shrunk slots are kept for reuse");
+
+	/* Active members are packed at [0, count_init), each one knows its own slot */
+	for (i = 0; i < glob_tcp_clientpool->client.count_init; i++)
+	{
+		ev_tcpclient = MemSlotBaseSlotGrabByID(&glob_tcp_clientpool->client.memslot, i);
+
+		if ((ev_tcpclient->cli_id_onpool != i) || (ev_tcpclient->parent_pool != glob_tcp_clientpool))
+			PoolTestCheck(0, "slot array consistent with member IDs");
+	}
+
+	PoolTestCheck(1, "slot array consistent with member IDs");
+
+	/* Selection never hands out a slot beyond active count */
+	PoolRoundRobinCount((int*)&count_arr, (count_init * POOL_SELECT_ROUNDS));
+
+	for (i = 0; i < COMM_TCP_CLIENT_POOL_MAX; i++)
+	{
+		if ((i < count_init) ? (POOL_SELECT_ROUNDS != count_arr[i]) : (0 != count_arr[i]))
+			PoolTestCheck(0, "round robin covers exactly active members");
+	}
+
+	PoolTestCheck(1, "round robin covers exactly active members");
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolRoundRobinCount(int *count_arr, int round_count)
+{
+	CommEvTCPClient *ev_tcpclient;
+	int i;
+
+	memset(count_arr, 0, (sizeof(int) * COMM_TCP_CLIENT_POOL_MAX));
+
+	for (i = 0; i < round_count; i++)
+	{
+		ev_tcpclient = CommEvTCPClientPoolClientSelect(glob_tcp_clientpool, COMM_POOL_SELECT_ROUND_ROBIN, COMM_CLIENT_STATE_CONNECTED);
+
+		if (!ev_tcpclient)
+			PoolTestCheck(0, "round robin selects a member");
+
+		count_arr[ev_tcpclient->cli_id_onpool]++;
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolLoadInject(int cli_count, int load)
+{
+	int i;
+	int j;
+
+	/* Writes in flight count as load for health timer */
+	for (i = 0; i < cli_count; i++)
+	{
+		for (j = 0; j < load; j++)
+			CommEvPoolHealthWriteMark(&glob_tcp_clientpool->health.arr[i], &glob_ev_base->stats.cur_invoke_tv);
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static int PoolConnectedCount(void)
+{
+	CommEvTCPClient *ev_tcpclient;
+	int connected_count;
+	int i;
+
+	for (connected_count = 0, i = 0; i < glob_tcp_clientpool->client.count_init; i++)
+	{
+		ev_tcpclient = MemSlotBaseSlotGrabByID(&glob_tcp_clientpool->client.memslot, i);
+
+		if (COMM_CLIENT_STATE_CONNECTED == ev_tcpclient->socket_state)
+			connected_count++;
+	}
+
+	return connected_count;
+}
+/**************************************************************************************************************************/
+static void PoolEchoServerInit(void)
+{
+	CommEvTCPServerConf conf_plain;
+	int listener_id;
+
+	memset(&conf_plain, 0, sizeof(CommEvTCPServerConf));
+
+	conf_plain.bind_method			= COMM_SERVER_BINDLOOPBACK;
+	conf_plain.read_mthd			= COMM_SERVER_READ_MEMBUFFER;
+	conf_plain.srv_proto			= COMM_SERVERPROTO_PLAIN;
+	conf_plain.port					= POOL_ECHO_PORT;
+	conf_plain.flags.reuse_addr		= 1;
+
+	glob_tcp_srv	= CommEvTCPServerNew(glob_ev_base);
+	listener_id		= CommEvTCPServerListenerAdd(glob_tcp_srv, &conf_plain);
+
+	PoolTestCheck((listener_id >= 0), "loopback echo server listening");
+	CommEvTCPServerEventSet(glob_tcp_srv, listener_id, COMM_SERVER_EVENT_DEFAULT_READ, PoolEchoServerReadEvent, NULL);
+
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolEchoServerReadEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvTCPServer *ev_tcpsrv		= base_ptr;
+	CommEvTCPServerConn *conn_hnd	= CommEvTCPServerConnArenaGrab(ev_tcpsrv, fd);
+
+	if (!conn_hnd->iodata.read_buffer)
+		return;
+
+	/* Echo back whatever arrived */
+	CommEvTCPServerConnAIOWriteStringFmt(conn_hnd, NULL, NULL, "%.*s", (int)MemBufferGetSize(conn_hnd->iodata.read_buffer), MemBufferDeref(conn_hnd->iodata.read_buffer));
+	MemBufferClean(conn_hnd->iodata.read_buffer);
+
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolClientReadEvent(int fd, int to_read_sz, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvTCPClient *ev_tcpclient = cb_data;
+
+	/* Pool health already took this READ as a reply, just drop the echo */
+	if (ev_tcpclient->iodata.read_buffer)
+		MemBufferClean(ev_tcpclient->iodata.read_buffer);
+
+	return;
+}
+/**************************************************************************************************************************/
+static int PoolTimeoutTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	printf("TEST_TCP_CLIENTPOOL - Stuck at STEP [%d] - CLI_COUNT [%d / %d] - CONNECTED [%d]\n", glob_step,
+			glob_tcp_clientpool->client.count_init, glob_tcp_clientpool->client.count_alloc, PoolConnectedCount());
+
+	PoolTestCheck(0, "pool test finished before timeout");
+	return 0;
+}
+/**************************************************************************************************************************/
+static void PoolTestCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		fflush(stdout);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/**************************************************************************************************************************/
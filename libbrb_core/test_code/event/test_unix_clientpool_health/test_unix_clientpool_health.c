@@ -0,0 +1,430 @@
+/*
+ * test_unix_clientpool_health.c
+ *
+ *  Created on: 2026-10-17
+ *      Author: Guilherme Amorim de Oliveira Alves <guilherme@brbyte.com>
+ *      Author: Luiz Fernando Souza Softov <softov@brbyte.com>
+ *
+ *
+ * Copyright (c) 2026 BrByte Software (Oliveira Alves & Amorim LTDA)
+ * Todos os direitos reservados. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libbrb_data.h>
+#include <libbrb_ev_kq.h>
+
+#define POOL_SERVER_PATH		"/tmp/test_unix_clientpool_health.sock"
+#define POOL_CLI_INIT			6
+#define POOL_CLI_MIN			4
+#define POOL_HEALTH_MS			100
+#define POOL_STEP_MS			50
+#define POOL_TIMEOUT_MS			30000
+#define POOL_SELECT_ROUNDS		100
+#define POOL_VICTIM_ID			1
+#define POOL_PING_STR			"PING"
+
+typedef enum
+{
+	POOL_STEP_CONNECT,
+	POOL_STEP_SHRINK,
+	POOL_STEP_ACK,
+	POOL_STEP_PROBE_WAIT,
+	POOL_STEP_READMIT,
+} PoolTestStep;
+
+static CommEvUNIXACKCBH PoolClientACKEvent;
+static EvBaseKQCBH PoolStepTimer;
+static EvBaseKQCBH PoolTimeoutTimer;
+static void PoolServerInit(void);
+static void PoolPingWrite(int write_count);
+static void PoolSpreadCheck(void);
+static void PoolEjectCheck(void);
+static void PoolProbeCheck(void);
+static void PoolSlotCheck(int count_init, int count_alloc);
+static void PoolRoundRobinCount(int *count_arr, int round_count);
+static int PoolConnectedCount(void);
+static void PoolTestCheck(int cond, char *check_str);
+
+EvKQBase *glob_ev_base;
+CommEvUNIXServer *glob_unix_srv;
+CommEvUNIXClientPool *glob_unix_clientpool;
+PoolTestStep glob_step;
+int glob_ack_count;
+
+/**************************************************************************************************************************/
+int main(int argc, char **argv)
+{
+	CommEvUNIXClientPoolConf pool_conf;
+	CommEvUNIXClientConf cli_conf;
+
+	memset(&pool_conf, 0, sizeof(CommEvUNIXClientPoolConf));
+	memset(&cli_conf, 0, sizeof(CommEvUNIXClientConf));
+
+	glob_ev_base						= EvKQBaseNew(NULL);
+	PoolServerInit();
+
+	/* Start above MIN, so idle pool shrinks before selection checks run on a stable member set */
+	pool_conf.cli_count_init			= POOL_CLI_INIT;
+	pool_conf.cli_count_min				= POOL_CLI_MIN;
+	pool_conf.cli_count_max				= POOL_CLI_INIT;
+	pool_conf.health_check_ms			= POOL_HEALTH_MS;
+	pool_conf.flags.auto_resize			= 1;
+
+	glob_unix_clientpool				= CommEvUNIXClientPoolNew(glob_ev_base, &pool_conf);
+	PoolTestCheck((!glob_unix_clientpool->flags.has_error), "pool created");
+
+	cli_conf.server_path				= POOL_SERVER_PATH;
+	cli_conf.timeout.connect_ms			= 1000;
+
+	CommEvUNIXClientPoolConnect(glob_unix_clientpool, &cli_conf);
+
+	EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, POOL_STEP_MS, PoolStepTimer, NULL);
+	EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, POOL_TIMEOUT_MS, PoolTimeoutTimer, NULL);
+
+	/* Jump into event loop */
+	while (1)
+		EvKQBaseDispatch(glob_ev_base, 100);
+
+	return 0;
+}
+/**************************************************************************************************************************/
+static int PoolStepTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	CommEvPoolHealth *victim_health = &glob_unix_clientpool->health.arr[POOL_VICTIM_ID];
+	int i;
+
+	switch (glob_step)
+	{
+	/* Wait whole pool to reach UNIX server */
+	case POOL_STEP_CONNECT:
+	{
+		if (PoolConnectedCount() < POOL_CLI_INIT)
+			break;
+
+		PoolTestCheck(1, "all pool members connected");
+		PoolSlotCheck(POOL_CLI_INIT, POOL_CLI_INIT);
+
+		glob_step = POOL_STEP_SHRINK;
+		break;
+	}
+	/* Nothing in flight, idle ticks drop members down to MIN */
+	case POOL_STEP_SHRINK:
+	{
+		if (glob_unix_clientpool->client.count_init > POOL_CLI_MIN)
+			break;
+
+		PoolTestCheck((POOL_CLI_MIN == glob_unix_clientpool->client.count_init), "idle pool shrank to MIN");
+		PoolSlotCheck(POOL_CLI_MIN, POOL_CLI_INIT);
+		PoolSpreadCheck();
+
+		/* One real round trip per member, server ACK must answer the pending write */
+		PoolPingWrite(POOL_CLI_MIN);
+
+		glob_step = POOL_STEP_ACK;
+		break;
+	}
+	case POOL_STEP_ACK:
+	{
+		for (i = 0; i < POOL_CLI_MIN; i++)
+		{
+			if ((glob_unix_clientpool->health.arr[i].sample_count < 1) || (glob_unix_clientpool->health.arr[i].pending_count > 0))
+				goto reschedule;
+		}
+
+		PoolTestCheck((POOL_CLI_MIN == glob_ack_count), "ACK replies sampled on every member");
+		PoolEjectCheck();
+
+		glob_step = POOL_STEP_PROBE_WAIT;
+		break;
+	}
+	/* Back-off must elapse before ejected member is offered a probe */
+	case POOL_STEP_PROBE_WAIT:
+	{
+		if (EvKQBaseTimeValSubMsec(&victim_health->ejected_tv, &glob_ev_base->stats.cur_invoke_tv) < (victim_health->eject_ms + POOL_STEP_MS))
+			break;
+
+		PoolProbeCheck();
+
+		glob_step = POOL_STEP_READMIT;
+		break;
+	}
+	case POOL_STEP_READMIT:
+	{
+		if (victim_health->flags.ejected)
+			break;
+
+		PoolTestCheck((!victim_health->flags.probing), "ACKed probe readmits member");
+		PoolTestCheck((0 == victim_health->fail_count), "readmitted member failure count reset");
+		PoolSlotCheck(POOL_CLI_MIN, POOL_CLI_INIT);
+
+		printf("TEST_UNIX_CLIENTPOOL_HEALTH - All tests passed\n");
+		exit(0);
+	}
+	}
+
+	/* TAG to check again on next step */
+	reschedule:
+
+	EvKQBaseTimerAdd(glob_ev_base, COMM_ACTION_ADD_VOLATILE, POOL_STEP_MS, PoolStepTimer, NULL);
+	return 1;
+}
+/**************************************************************************************************************************/
+static void PoolPingWrite(int write_count)
+{
+	int write_id;
+	int i;
+
+	/* ACK_CB makes server answer, and only answered writes are sampled by pool health */
+	for (i = 0; i < write_count; i++)
+	{
+		write_id = CommEvUNIXClientPoolAIOWrite(glob_unix_clientpool, COMM_UNIX_SELECT_ROUND_ROBIN, POOL_PING_STR, strlen(POOL_PING_STR), NULL, 0,
+				NULL, PoolClientACKEvent, NULL, NULL);
+
+		if (write_id < 0)
+			PoolTestCheck(0, "pool write scheduled");
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolSpreadCheck(void)
+{
+	CommEvUNIXClient *ev_unixclient;
+	int count_arr[COMM_UNIX_CLIENT_POOL_MAX];
+	int i;
+
+	/* Round robin visits every healthy member the same number of times */
+	PoolRoundRobinCount((int*)&count_arr, (POOL_CLI_MIN * POOL_SELECT_ROUNDS));
+
+	for (i = 0; i < POOL_CLI_MIN; i++)
+	{
+		if (POOL_SELECT_ROUNDS != count_arr[i])
+			PoolTestCheck(0, "round robin spreads evenly");
+	}
+
+	PoolTestCheck(1, "round robin spreads evenly");
+
+	/* Idle pool has no load to tell members apart, power of two must still reach all of them and nothing past active count */
+	memset(&count_arr, 0, sizeof(count_arr));
+
+	for (i = 0; i < (POOL_CLI_MIN * POOL_SELECT_ROUNDS); i++)
+	{
+		ev_unixclient = CommEvUNIXClientPoolClientSelect(glob_unix_clientpool, COMM_UNIX_SELECT_POWER_OF_TWO, COMM_UNIX_SELECT_CONNECTED);
+
+		if (!ev_unixclient)
+			PoolTestCheck(0, "power of two selects a member");
+
+		count_arr[ev_unixclient->cli_id_onpool]++;
+	}
+
+	for (i = 0; i < COMM_UNIX_CLIENT_POOL_MAX; i++)
+	{
+		if ((i < POOL_CLI_MIN) ? (0 == count_arr[i]) : (0 != count_arr[i]))
+			PoolTestCheck(0, "power of two spreads over active members");
+	}
+
+	PoolTestCheck(1, "power of two spreads over active members");
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolEjectCheck(void)
+{
+	CommEvPoolHealth *victim_health = &glob_unix_clientpool->health.arr[POOL_VICTIM_ID];
+	CommEvUNIXClient *victim_client	= MemSlotBaseSlotGrabByID(&glob_unix_clientpool->client.memslot, POOL_VICTIM_ID);
+	int count_arr[COMM_UNIX_CLIENT_POOL_MAX];
+	int i;
+
+	/* Writes left without ACK by a closing peer are failures, FAIL_MAX of them eject */
+	for (i = 0; i < COMM_POOL_HEALTH_FAIL_MAX; i++)
+	{
+		if (victim_health->flags.ejected)
+			PoolTestCheck(0, "member kept until FAIL_MAX");
+
+		CommEvPoolHealthWriteMark(victim_health, &glob_ev_base->stats.cur_invoke_tv);
+		CommEvUNIXClientPoolClientEventNotify(glob_unix_clientpool, victim_client, COMM_UNIX_CLIENT_EVENT_CLOSE);
+	}
+
+	PoolTestCheck((victim_health->flags.ejected), "failing member ejected");
+	PoolTestCheck((COMM_POOL_HEALTH_EJECT_MIN_MS == victim_health->eject_ms), "first ejection uses minimum back-off");
+
+	/* Ejected member is out of every selection method */
+	PoolRoundRobinCount((int*)&count_arr, ((POOL_CLI_MIN - 1) * POOL_SELECT_ROUNDS));
+
+	for (i = 0; i < POOL_CLI_MIN; i++)
+	{
+		if ((POOL_VICTIM_ID == i) ? (0 != count_arr[i]) : (POOL_SELECT_ROUNDS != count_arr[i]))
+			PoolTestCheck(0, "round robin skips ejected member");
+	}
+
+	PoolTestCheck(1, "round robin skips ejected member");
+
+	for (i = 0; i < (POOL_CLI_MIN * POOL_SELECT_ROUNDS); i++)
+	{
+		if (victim_client == CommEvUNIXClientPoolClientSelect(glob_unix_clientpool, COMM_UNIX_SELECT_POWER_OF_TWO, COMM_UNIX_SELECT_CONNECTED))
+			PoolTestCheck(0, "power of two skips ejected member");
+
+		if (victim_client == CommEvUNIXClientPoolClientSelect(glob_unix_clientpool, COMM_UNIX_SELECT_LEAST_LATENCY, COMM_UNIX_SELECT_CONNECTED))
+			PoolTestCheck(0, "least latency skips ejected member");
+
+		if (victim_client == CommEvUNIXClientPoolClientSelect(glob_unix_clientpool, COMM_UNIX_SELECT_LEAST_LOAD, COMM_UNIX_SELECT_CONNECTED))
+			PoolTestCheck(0, "least load skips ejected member");
+	}
+
+	PoolTestCheck(1, "power of two, least latency and least load skip ejected member");
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolProbeCheck(void)
+{
+	CommEvPoolHealth *victim_health = &glob_unix_clientpool->health.arr[POOL_VICTIM_ID];
+
+	PoolTestCheck((CommEvPoolHealthCanSelect(victim_health, &glob_ev_base->stats.cur_invoke_tv)), "ejected member selectable after back-off");
+
+	/* Real write to every member, the one landing on the ejected member is its probe */
+	PoolPingWrite(POOL_CLI_MIN);
+
+	PoolTestCheck((victim_health->flags.probing), "write to ejected member is a probe");
+	PoolTestCheck((!CommEvPoolHealthCanSelect(victim_health, &glob_ev_base->stats.cur_invoke_tv)), "only one probe in flight");
+
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolSlotCheck(int count_init, int count_alloc)
+{
+	CommEvUNIXClient *ev_unixclient;
+	int count_arr[COMM_UNIX_CLIENT_POOL_MAX];
+	int i;
+
+	PoolTestCheck((count_init == glob_unix_clientpool->client.count_init), "active member count");
+	PoolTestCheck((count_alloc == glob_unix_clientpool->client.count_alloc), "slot count, shrunk slots are kept for reuse");
+
+	/* Active members are packed at [0, count_init), each one knows its own slot */
+	for (i = 0; i < glob_unix_clientpool->client.count_init; i++)
+	{
+		ev_unixclient = MemSlotBaseSlotGrabByID(&glob_unix_clientpool->client.memslot, i);
+
+		if ((ev_unixclient->cli_id_onpool != i) || (ev_unixclient->parent_pool != glob_unix_clientpool))
+			PoolTestCheck(0, "slot array consistent with member IDs");
+	}
+
+	PoolTestCheck(1, "slot array consistent with member IDs");
+
+	/* Selection never hands out a slot beyond active count */
+	PoolRoundRobinCount((int*)&count_arr, (count_init * POOL_SELECT_ROUNDS));
+
+	for (i = 0; i < COMM_UNIX_CLIENT_POOL_MAX; i++)
+	{
+		if ((i < count_init) ? (POOL_SELECT_ROUNDS != count_arr[i]) : (0 != count_arr[i]))
+			PoolTestCheck(0, "round robin covers exactly active members");
+	}
+
+	PoolTestCheck(1, "round robin covers exactly active members");
+	return;
+}
+/**************************************************************************************************************************/
+static void PoolRoundRobinCount(int *count_arr, int round_count)
+{
+	CommEvUNIXClient *ev_unixclient;
+	int i;
+
+	memset(count_arr, 0, (sizeof(int) * COMM_UNIX_CLIENT_POOL_MAX));
+
+	for (i = 0; i < round_count; i++)
+	{
+		ev_unixclient = CommEvUNIXClientPoolClientSelect(glob_unix_clientpool, COMM_UNIX_SELECT_ROUND_ROBIN, COMM_UNIX_SELECT_CONNECTED);
+
+		if (!ev_unixclient)
+			PoolTestCheck(0, "round robin selects a member");
+
+		count_arr[ev_unixclient->cli_id_onpool]++;
+	}
+
+	return;
+}
+/**************************************************************************************************************************/
+static int PoolConnectedCount(void)
+{
+	CommEvUNIXClient *ev_unixclient;
+	int connected_count;
+	int i;
+
+	for (connected_count = 0, i = 0; i < glob_unix_clientpool->client.count_init; i++)
+	{
+		ev_unixclient = MemSlotBaseSlotGrabByID(&glob_unix_clientpool->client.memslot, i);
+
+		if (COMM_CLIENT_STATE_CONNECTED == ev_unixclient->socket_state)
+			connected_count++;
+	}
+
+	return connected_count;
+}
+/**************************************************************************************************************************/
+static void PoolServerInit(void)
+{
+	CommEvUNIXServerConf server_conf;
+	int listener_id;
+
+	memset(&server_conf, 0, sizeof(CommEvUNIXServerConf));
+
+	/* Server ACKs every request flagged WANT_ACK by itself, no READ handler needed */
+	server_conf.path_str			= POOL_SERVER_PATH;
+	server_conf.listen_queue_sz		= 64;
+	server_conf.flags.reuse_addr	= 1;
+
+	glob_unix_srv	= CommEvUNIXServerNew(glob_ev_base);
+	listener_id		= CommEvUNIXServerListenerAdd(glob_unix_srv, &server_conf);
+
+	PoolTestCheck((listener_id >= 0), "UNIX server listening");
+	return;
+}
+/**************************************************************************************************************************/
+static int PoolClientACKEvent(int ack_code, void *pend_req_ptr, void *cb_data)
+{
+	glob_ack_count++;
+	return 1;
+}
+/**************************************************************************************************************************/
+static int PoolTimeoutTimer(int timer_id, int unused, int thrd_id, void *cb_data, void *base_ptr)
+{
+	printf("TEST_UNIX_CLIENTPOOL_HEALTH - Stuck at STEP [%d] - CLI_COUNT [%d / %d] - CONNECTED [%d] - ACKS [%d]\n", glob_step,
+			glob_unix_clientpool->client.count_init, glob_unix_clientpool->client.count_alloc, PoolConnectedCount(), glob_ack_count);
+
+	PoolTestCheck(0, "pool test finished before timeout");
+	return 0;
+}
+/**************************************************************************************************************************/
+static void PoolTestCheck(int cond, char *check_str)
+{
+	if (!cond)
+	{
+		printf("FAILED - %s\n", check_str);
+		fflush(stdout);
+		abort();
+	}
+
+	printf("OK - %s\n", check_str);
+	return;
+}
+/**************************************************************************************************************************/
@@ -34,6 +34,10 @@
 
 #include <libbrb_core.h>
 
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
 static int ThreadPoolBaseThreadsGrowIfNeeded(ThreadPoolBase *thread_pool);
 static int ThreadPoolBaseThreadsLauch(ThreadPoolBase *thrd_base, int count);
 static int ThreadPoolBaseNotifyPipeInit(ThreadPoolBase *thrd_base);
@@ -41,9 +45,23 @@ static EvBaseKQCBH ThreadPoolBaseNotifyPipeEventRead;
 
 static void ThreadPoolInstanceExecute(ThreadPoolBase *thrd_base, ThreadPoolInstance *thrd_instance, int thrdid_onpool);
 static void ThreadPoolInstanceBlockSignals(void);
-static int ThreadPoolInstanceNotifyFinish(ThreadPoolBase *thread_pool, ThreadPoolInstanceJob *thread_job);
+static int ThreadPoolInstanceNotifyFinish(ThreadPoolBase *thread_pool, int job_id, int thrd_id);
+static void ThreadPoolInstanceJobDone(ThreadPoolBase *thread_pool, ThreadPoolInstanceJob *thread_job);
+static ThreadPoolInstanceJob *ThreadPoolInstanceJobGrab(ThreadPoolBase *thread_pool, ThreadPoolInstance *thread_instance);
+static int ThreadPoolInstancePark(ThreadPoolBase *thread_pool, ThreadPoolInstance *thread_instance);
 static ThreadInstanceEntryPoint ThreadPoolInstanceMainLoop;
 
+static int ThreadPoolInjectInit(ThreadPoolBase *thread_pool, long job_max_count);
+static int ThreadPoolInjectPush(ThreadPoolBase *thread_pool, ThreadPoolInstanceJob *thread_job);
+static ThreadPoolInstanceJob *ThreadPoolInjectPop(ThreadPoolBase *thread_pool);
+static int ThreadPoolInjectIsEmpty(ThreadPoolBase *thread_pool);
+static void ThreadPoolIdleWakeUp(ThreadPoolBase *thread_pool, int broadcast);
+
+static int ThreadPoolDequePush(ThreadPoolInstance *thread_instance, ThreadPoolInstanceJob *thread_job);
+static ThreadPoolInstanceJob *ThreadPoolDequePop(ThreadPoolInstance *thread_instance);
+static ThreadPoolInstanceJob *ThreadPoolDequeSteal(ThreadPoolInstance *thread_instance);
+static long ThreadPoolDequeSize(ThreadPoolInstance *thread_instance);
+
 /**************************************************************************************************************************/
 ThreadPoolBase *ThreadPoolBaseNew(EvKQBase *ev_base, ThreadPoolBaseConfig *thread_pool_conf)
 {
@@ -71,6 +89,14 @@ ThreadPoolBase *ThreadPoolBaseNew(EvKQBase *ev_base, ThreadPoolBaseConfig *threa
 	MemSlotBaseInit(&thread_pool->instances.memslot, (sizeof(ThreadPoolInstance) + 1), (thread_pool->config.worker_count_max + 1), BRBDATA_THREAD_UNSAFE);
 	MemSlotBaseInit(&thread_pool->jobs.memslot, (sizeof(ThreadPoolInstanceJob) + 1), (thread_pool->config.job_max_count + 1), BRBDATA_THREAD_SAFE);
 
+	/* Workers look each other up here to steal JOBs */
+	thread_pool->instances.arr = calloc((thread_pool->config.worker_count_max + 1), sizeof(ThreadPoolInstance*));
+
+	/* Initialize INJECT queue, big enough to hold every JOB slot, and PARK for idle workers */
+	ThreadPoolInjectInit(thread_pool, (thread_pool->config.job_max_count + 1));
+	pthread_mutex_init(&thread_pool->park.mutex, NULL);
+	pthread_cond_init(&thread_pool->park.cond, NULL);
+
 	/* Initialize NOTIFY PIPE FD pair */
 	if ((thread_pool->ev_base) && (thread_pool->flags.kevent_finish_notify))
 		ThreadPoolBaseNotifyPipeInit(thread_pool);
@@ -105,6 +131,9 @@ void ThreadPoolBaseDestroy(ThreadPoolBase *thread_pool)
 		continue;
 	}
 
+	/* Wake up PARKED workers so they see shutdown flag */
+	ThreadPoolIdleWakeUp(thread_pool, 1);
+
 	/* TAG to wait thread shutdown */
 	sync_wait:
 
@@ -131,6 +160,12 @@ void ThreadPoolBaseDestroy(ThreadPoolBase *thread_pool)
 	MemSlotBaseClean(&thread_pool->instances.memslot);
 	MemSlotBaseClean(&thread_pool->jobs.memslot);
 
+	/* Release INJECT queue and PARK */
+	pthread_mutex_destroy(&thread_pool->park.mutex);
+	pthread_cond_destroy(&thread_pool->park.cond);
+	free(thread_pool->inject.cell_arr);
+	free(thread_pool->instances.arr);
+
 	free(thread_pool);
 
 	return;
@@ -188,9 +223,9 @@ int ThreadPoolJobEnqueue(ThreadPoolBase *thread_pool, ThreadPoolJobProto *job_pr
 	ThreadPoolBaseThreadsGrowIfNeeded(thread_pool);
 
 	/* Request a JOB SLOT from MEM_SLOT */
-	thread_job = MemSlotBaseSlotGrabAndLeaveLocked(&thread_pool->jobs.memslot);
+	thread_job = MemSlotBaseSlotGrab(&thread_pool->jobs.memslot);
 
-	/* No more THREAD_JOB slots - No need to UNLOCK */
+	/* No more THREAD_JOB slots */
 	if (!thread_job)
 	{
 		KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "Too many enqueued JOBs [%ld]\n",  MemSlotBaseSlotListSizeAll(&thread_pool->jobs.memslot));
@@ -229,11 +264,18 @@ int ThreadPoolJobEnqueue(ThreadPoolBase *thread_pool, ThreadPoolJobProto *job_pr
 		memcpy(&thread_job->user_data_buf, job_proto->udata, local_udata_sz);
 	}
 
+	/* Publish JOB on INJECT queue, it is sized to hold every JOB slot so this should never fail */
+	if (!ThreadPoolInjectPush(thread_pool, thread_job))
+	{
+		KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_WARNING, LOGCOLOR_RED, "JOB_ID [%d] - INJECT queue full\n", thread_job->job_id);
+		MemSlotBaseSlotFree(&thread_pool->jobs.memslot, thread_job);
+		return -1;
+	}
+
 	KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "Enqueued JOB_ID [%d]\n", thread_job->job_id);
 
-	/* Release the FUCKING LOCK and BROADCAST COND_SIGNAL to the thread POOL */
-	MemSlotBaseUnlock(&thread_pool->jobs.memslot);
-	pthread_cond_signal(&thread_pool->jobs.memslot.thrd_cond.cond);
+	/* Wake up a PARKED worker, if any */
+	ThreadPoolIdleWakeUp(thread_pool, 0);
 
 	return thread_job->job_id;
 }
@@ -264,33 +306,42 @@ int ThreadPoolJobSimple(ThreadPoolBase *thread_pool, ThreadInstanceJobCB_Generic
 int ThreadPoolJobConsumeReplies(ThreadPoolBase *thread_pool)
 {
 	ThreadPoolInstanceJob *thread_job;
+	ThreadPoolInstanceJob *done_list;
+	ThreadPoolInstanceJob *next_job;
 	int consume_count = 0;
 
-	/* Consume all replies */
-	while (1)
+	/* Detach whole DONE stack at once, workers that finish after this will notify again */
+	while ((done_list = __atomic_exchange_n(&thread_pool->done.head, NULL, __ATOMIC_ACQ_REL)))
 	{
-		thread_job = MemSlotBaseSlotPointToHead(&thread_pool->jobs.memslot, THREAD_LIST_JOB_DONE);
-
-		/* Nothing else to dispatch, STOP */
-		if (!thread_job)
+		/* Stack is LIFO, reverse it so replies are dispatched in finish order */
+		for (thread_job = NULL; done_list; done_list = next_job)
 		{
-			KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_INFO, LOGCOLOR_CYAN, "Finished consuming [%d] REPLIEs\n", consume_count);
-			break;
+			next_job				= done_list->done_next;
+			done_list->done_next	= thread_job;
+			thread_job				= done_list;
 		}
 
-		assert(!thread_job->flags.in_use);
-		assert(thread_job->flags.finished);
+		/* Consume all replies */
+		for (; thread_job; thread_job = next_job)
+		{
+			next_job = thread_job->done_next;
 
-		/* Notify finish CALLBACK, if we have not been canceled */
-		if ((thread_job->finish_callback.cbh_ptr) && (!thread_job->flags.cancelled))
-			thread_job->finish_callback.cbh_ptr(thread_job, (thread_job->finish_callback.cbdata ? thread_job->finish_callback.cbdata : thread_job->job_callback.job_cbdata));
+			assert(!thread_job->flags.in_use);
+			assert(thread_job->flags.finished);
 
-		KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Main THREAD - Invoked CB_FUNC for JOB_ID [%d] - CB [%p]/[%p]/[%p]\n",
-				thread_job->job_id, thread_job->finish_callback.cbh_ptr, thread_job->finish_callback.cbdata, thread_job->job_callback.job_cbdata);
+			/* Notify finish CALLBACK, if we have not been canceled */
+			if ((thread_job->finish_callback.cbh_ptr) && (!thread_job->flags.cancelled))
+				thread_job->finish_callback.cbh_ptr(thread_job, (thread_job->finish_callback.cbdata ? thread_job->finish_callback.cbdata : thread_job->job_callback.job_cbdata));
+
+			KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Main THREAD - Invoked CB_FUNC for JOB_ID [%d] - CB [%p]/[%p]/[%p]\n",
+					thread_job->job_id, thread_job->finish_callback.cbh_ptr, thread_job->finish_callback.cbdata, thread_job->job_callback.job_cbdata);
+
+			/* Free used slot for this job */
+			MemSlotBaseSlotFree(&thread_pool->jobs.memslot, thread_job);
+			consume_count++;
+			continue;
+		}
 
-		/* Free used slot for this job */
-		MemSlotBaseSlotFree(&thread_pool->jobs.memslot, thread_job);
-		consume_count++;
 		continue;
 	}
 
@@ -306,7 +357,7 @@ static int ThreadPoolBaseThreadsGrowIfNeeded(ThreadPoolBase *thrd_base)
 	int all_busy;
 
 	/* Maximum size reached, bail out */
-	if (thrd_base->instances.memslot.list[0].size >= thrd_base->config.worker_count_max)
+	if (thrd_base->instances.count >= thrd_base->config.worker_count_max)
 		return 0;
 
 	/* Check if all threads are busy */
@@ -340,8 +391,8 @@ static int ThreadPoolBaseThreadsLauch(ThreadPoolBase *thrd_base, int count)
 		if (!thrd_instance)
 			break;
 
-		/* Execute THREAD */
-		ThreadPoolInstanceExecute(thrd_base, thrd_instance, i);
+		/* Execute THREAD - Its ID on pool is its index on INSTANCE array */
+		ThreadPoolInstanceExecute(thrd_base, thrd_instance, thrd_base->instances.count);
 		continue;
 	}
 
@@ -350,7 +401,11 @@ static int ThreadPoolBaseThreadsLauch(ThreadPoolBase *thrd_base, int count)
 /**************************************************************************************************************************/
 static int ThreadPoolBaseNotifyPipeInit(ThreadPoolBase *thrd_base)
 {
-#if !defined(linux)
+#if defined(__linux__)
+	/* A single EVENTFD is enough, workers and MAIN share it */
+	thrd_base->notify_pipe[THREAD_NOTIFY_PIPE_MAIN]		= eventfd(0, 0);
+	thrd_base->notify_pipe[THREAD_NOTIFY_PIPE_THREADS]	= thrd_base->notify_pipe[THREAD_NOTIFY_PIPE_MAIN];
+#else
 	/* Initialize done pipe signal */
 	pipe(thrd_base->notify_pipe);
 #endif
@@ -386,7 +441,7 @@ static int ThreadPoolBaseNotifyPipeEventRead(int fd, int can_read_sz, int thrd_i
 	ThreadPoolBase *thrd_base				= cb_data;
 	ThreadPoolNotifyData *notify_data_arr	= (ThreadPoolNotifyData*)&read_buf;
 
-	/* Drain PIPE data */
+	/* Drain PIPE data - Each packet is a BURST of finished JOBs, not a single one */
 	read_sz			= read(fd, notify_data_arr, (sizeof(read_buf) - 1));
 	packet_count	= (read_sz / sizeof(ThreadPoolNotifyData));
 
@@ -416,6 +471,10 @@ static void ThreadPoolInstanceExecute(ThreadPoolBase *thrd_base, ThreadPoolInsta
 	thrd_instance->thread_pool		= thrd_base;
 	thrd_instance->thread_state		= THREAD_INSTANCE_STATE_STARTING;
 
+	/* Publish on INSTANCE array so other workers can steal from us */
+	thrd_base->instances.arr[thrdid_onpool] = thrd_instance;
+	__atomic_store_n(&thrd_base->instances.count, (thrdid_onpool + 1), __ATOMIC_RELEASE);
+
 	/* Set schedule parameters */
 	pthread_setschedparam(main_thread, SCHED_OTHER, &globsched);
 
@@ -451,15 +510,23 @@ static void ThreadPoolInstanceBlockSignals(void)
 	return;
 }
 /**************************************************************************************************************************/
-static int ThreadPoolInstanceNotifyFinish(ThreadPoolBase *thread_pool, ThreadPoolInstanceJob *thread_job)
+static int ThreadPoolInstanceNotifyFinish(ThreadPoolBase *thread_pool, int job_id, int thrd_id)
 {
+#if defined(__linux__)
+	uint64_t notify_count = 1;
+	int op_status;
+
+	/* Bump EVENTFD counter */
+	op_status 				= write(thread_pool->notify_pipe[THREAD_NOTIFY_PIPE_THREADS], (char*)&notify_count, sizeof(uint64_t));
+	return op_status;
+#else
 	ThreadPoolNotifyData notify_data;
 	int op_status;
 
 	/* Cleanup and FILL notify DATA */
 	memset(&notify_data, 0, sizeof(ThreadPoolNotifyData));
-	notify_data.job_id		= thread_job->job_id;
-	notify_data.thrd_id 	= thread_job->run_thread_id;
+	notify_data.job_id		= job_id;
+	notify_data.thrd_id 	= thrd_id;
 
 	/* Write to NOTIFY_PIPE */
 	op_status 				= write(thread_pool->notify_pipe[THREAD_NOTIFY_PIPE_THREADS], (char*)&notify_data, sizeof(ThreadPoolNotifyData));
@@ -469,6 +536,331 @@ static int ThreadPoolInstanceNotifyFinish(ThreadPoolBase *thread_pool, ThreadPoo
 			notify_data.thrd_id, notify_data.job_id, op_status);
 
 	return op_status;
+#endif
+}
+/**************************************************************************************************************************/
+static void ThreadPoolInstanceJobDone(ThreadPoolBase *thread_pool, ThreadPoolInstanceJob *thread_job)
+{
+	ThreadPoolInstanceJob *old_head = __atomic_load_n(&thread_pool->done.head, __ATOMIC_RELAXED);
+	int job_id						= thread_job->job_id;
+	int thrd_id						= thread_job->run_thread_id;
+
+	/* Push into DONE stack - WARNING: DO NOT TOUCH THREAD_JOB ANYMORE ONCE THIS SUCCEEDS */
+	do
+	{
+		thread_job->done_next = old_head;
+	} while (!__atomic_compare_exchange_n(&thread_pool->done.head, &old_head, thread_job, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	/* Stack was not empty, MAIN_THREAD has already been notified for this burst */
+	if (old_head)
+		return;
+
+	/* Write NOTIFY_PIPE to tell MAIN_THREAD we are FINISHED */
+	if ((thread_pool->ev_base) && (thread_pool->flags.kevent_finish_notify))
+		ThreadPoolInstanceNotifyFinish(thread_pool, job_id, thrd_id);
+
+	return;
+}
+/**************************************************************************************************************************/
+static ThreadPoolInstanceJob *ThreadPoolInstanceJobGrab(ThreadPoolBase *thread_pool, ThreadPoolInstance *thread_instance)
+{
+	ThreadPoolInstanceJob *thread_job;
+	ThreadPoolInstanceJob *batch_job;
+	ThreadPoolInstance *victim_instance;
+	int instance_count;
+	int batch_count;
+	int i;
+
+	/* Own DEQUE first */
+	if ((thread_job = ThreadPoolDequePop(thread_instance)))
+		return thread_job;
+
+	/* Then INJECT queue, move a small batch into our DEQUE so other workers can steal it */
+	if ((thread_job = ThreadPoolInjectPop(thread_pool)))
+	{
+		for (batch_count = 0; batch_count < (THREAD_POOL_WORKER_BATCH_MAX - 1); batch_count++)
+		{
+			if (!(batch_job = ThreadPoolInjectPop(thread_pool)))
+				break;
+
+			ThreadPoolDequePush(thread_instance, batch_job);
+			continue;
+		}
+
+		/* We took more than we can run now, let an idle worker come and steal */
+		if (batch_count > 0)
+			ThreadPoolIdleWakeUp(thread_pool, 0);
+
+		return thread_job;
+	}
+
+	/* Last, try to steal from other workers, starting by our neighbor */
+	instance_count = __atomic_load_n(&thread_pool->instances.count, __ATOMIC_ACQUIRE);
+
+	for (i = 1; i < instance_count; i++)
+	{
+		victim_instance = thread_pool->instances.arr[(thread_instance->thread_id_pool + i) % instance_count];
+
+		if ((thread_job = ThreadPoolDequeSteal(victim_instance)))
+			return thread_job;
+
+		continue;
+	}
+
+	return NULL;
+}
+/**************************************************************************************************************************/
+static int ThreadPoolInstancePark(ThreadPoolBase *thread_pool, ThreadPoolInstance *thread_instance)
+{
+	int instance_count;
+	int i;
+
+	pthread_mutex_lock(&thread_pool->park.mutex);
+
+	/* Announce we are going IDLE before checking for work, so an ENQUEUE racing with us will either be seen or will wake us */
+	__atomic_add_fetch(&thread_pool->park.idle_count, 1, __ATOMIC_SEQ_CST);
+
+	/* Shutdown requested, do not sleep */
+	if (thread_instance->flags.do_shutdown)
+		goto leave;
+
+	/* Work showed up on INJECT queue */
+	if (!ThreadPoolInjectIsEmpty(thread_pool))
+		goto leave;
+
+	/* Work showed up on some worker DEQUE */
+	instance_count = __atomic_load_n(&thread_pool->instances.count, __ATOMIC_ACQUIRE);
+
+	for (i = 0; i < instance_count; i++)
+		if (ThreadPoolDequeSize(thread_pool->instances.arr[i]) > 0)
+			goto leave;
+
+	KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Hello from thread context [%d]-[%d] - Blocking at pthread_cond_wait\n",
+			thread_instance->thread_id_pool, thread_instance->thread_id_sys);
+
+	/* Block waiting for condition */
+	pthread_cond_wait(&thread_pool->park.cond, &thread_pool->park.mutex);
+
+	leave:
+
+	__atomic_sub_fetch(&thread_pool->park.idle_count, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&thread_pool->park.mutex);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static int ThreadPoolInjectInit(ThreadPoolBase *thread_pool, long job_max_count)
+{
+	unsigned long cell_count = 2;
+	unsigned long i;
+
+	/* Round up to power of two */
+	while (cell_count < job_max_count)
+		cell_count <<= 1;
+
+	thread_pool->inject.cell_arr	= calloc(cell_count, sizeof(ThreadPoolInjectCell));
+	thread_pool->inject.mask		= (cell_count - 1);
+	thread_pool->inject.head		= 0;
+	thread_pool->inject.tail		= 0;
+
+	/* Each cell SEQ tells the position it is ready to be written at */
+	for (i = 0; i < cell_count; i++)
+		thread_pool->inject.cell_arr[i].seq = i;
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static int ThreadPoolInjectPush(ThreadPoolBase *thread_pool, ThreadPoolInstanceJob *thread_job)
+{
+	ThreadPoolInjectCell *inject_cell;
+	unsigned long cell_seq;
+	unsigned long pos;
+	long seq_diff;
+
+	pos = __atomic_load_n(&thread_pool->inject.tail, __ATOMIC_RELAXED);
+
+	while (1)
+	{
+		inject_cell	= &thread_pool->inject.cell_arr[pos & thread_pool->inject.mask];
+		cell_seq	= __atomic_load_n(&inject_cell->seq, __ATOMIC_ACQUIRE);
+		seq_diff	= ((long)cell_seq - (long)pos);
+
+		/* Cell is free at this position, try to claim it */
+		if (0 == seq_diff)
+		{
+			if (__atomic_compare_exchange_n(&thread_pool->inject.tail, &pos, (pos + 1), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		}
+		/* Queue is full */
+		else if (seq_diff < 0)
+			return 0;
+		/* Someone else claimed it, reload */
+		else
+			pos = __atomic_load_n(&thread_pool->inject.tail, __ATOMIC_RELAXED);
+
+		continue;
+	}
+
+	/* Fill in and publish */
+	inject_cell->thread_job = thread_job;
+	__atomic_store_n(&inject_cell->seq, (pos + 1), __ATOMIC_RELEASE);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static ThreadPoolInstanceJob *ThreadPoolInjectPop(ThreadPoolBase *thread_pool)
+{
+	ThreadPoolInjectCell *inject_cell;
+	ThreadPoolInstanceJob *thread_job;
+	unsigned long cell_seq;
+	unsigned long pos;
+	long seq_diff;
+
+	pos = __atomic_load_n(&thread_pool->inject.head, __ATOMIC_RELAXED);
+
+	while (1)
+	{
+		inject_cell	= &thread_pool->inject.cell_arr[pos & thread_pool->inject.mask];
+		cell_seq	= __atomic_load_n(&inject_cell->seq, __ATOMIC_ACQUIRE);
+		seq_diff	= ((long)cell_seq - (long)(pos + 1));
+
+		/* Cell has been published at this position, try to claim it */
+		if (0 == seq_diff)
+		{
+			if (__atomic_compare_exchange_n(&thread_pool->inject.head, &pos, (pos + 1), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		}
+		/* Queue is empty */
+		else if (seq_diff < 0)
+			return NULL;
+		/* Someone else claimed it, reload */
+		else
+			pos = __atomic_load_n(&thread_pool->inject.head, __ATOMIC_RELAXED);
+
+		continue;
+	}
+
+	/* Grab JOB and release cell for next lap */
+	thread_job = inject_cell->thread_job;
+	__atomic_store_n(&inject_cell->seq, (pos + thread_pool->inject.mask + 1), __ATOMIC_RELEASE);
+
+	return thread_job;
+}
+/**************************************************************************************************************************/
+static int ThreadPoolInjectIsEmpty(ThreadPoolBase *thread_pool)
+{
+	ThreadPoolInjectCell *inject_cell;
+	unsigned long pos;
+
+	pos			= __atomic_load_n(&thread_pool->inject.head, __ATOMIC_SEQ_CST);
+	inject_cell	= &thread_pool->inject.cell_arr[pos & thread_pool->inject.mask];
+
+	/* Head cell has not been published yet */
+	return (__atomic_load_n(&inject_cell->seq, __ATOMIC_SEQ_CST) != (pos + 1));
+}
+/**************************************************************************************************************************/
+static void ThreadPoolIdleWakeUp(ThreadPoolBase *thread_pool, int broadcast)
+{
+	/* Pairs with IDLE_COUNT increment on ThreadPoolInstancePark */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	/* Nobody is PARKED, skip MUTEX */
+	if ((!broadcast) && (__atomic_load_n(&thread_pool->park.idle_count, __ATOMIC_SEQ_CST) <= 0))
+		return;
+
+	pthread_mutex_lock(&thread_pool->park.mutex);
+
+	if (broadcast)
+		pthread_cond_broadcast(&thread_pool->park.cond);
+	else
+		pthread_cond_signal(&thread_pool->park.cond);
+
+	pthread_mutex_unlock(&thread_pool->park.mutex);
+	return;
+}
+/**************************************************************************************************************************/
+/**/
+/**/
+/**************************************************************************************************************************/
+static int ThreadPoolDequePush(ThreadPoolInstance *thread_instance, ThreadPoolInstanceJob *thread_job)
+{
+	long bottom	= __atomic_load_n(&thread_instance->deque.bottom, __ATOMIC_RELAXED);
+	long top	= __atomic_load_n(&thread_instance->deque.top, __ATOMIC_ACQUIRE);
+
+	/* DEQUE is full */
+	if ((bottom - top) >= THREAD_POOL_WORKER_DEQUE_SZ)
+		return 0;
+
+	__atomic_store_n(&thread_instance->deque.job_arr[bottom & (THREAD_POOL_WORKER_DEQUE_SZ - 1)], thread_job, __ATOMIC_RELAXED);
+	__atomic_store_n(&thread_instance->deque.bottom, (bottom + 1), __ATOMIC_RELEASE);
+
+	return 1;
+}
+/**************************************************************************************************************************/
+static ThreadPoolInstanceJob *ThreadPoolDequePop(ThreadPoolInstance *thread_instance)
+{
+	ThreadPoolInstanceJob *thread_job;
+	long bottom;
+	long top;
+
+	/* Reserve BOTTOM item before looking at TOP */
+	bottom	= (__atomic_load_n(&thread_instance->deque.bottom, __ATOMIC_RELAXED) - 1);
+	__atomic_store_n(&thread_instance->deque.bottom, bottom, __ATOMIC_SEQ_CST);
+	top		= __atomic_load_n(&thread_instance->deque.top, __ATOMIC_SEQ_CST);
+
+	/* DEQUE was empty, restore BOTTOM */
+	if (top > bottom)
+	{
+		__atomic_store_n(&thread_instance->deque.bottom, (bottom + 1), __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	thread_job = __atomic_load_n(&thread_instance->deque.job_arr[bottom & (THREAD_POOL_WORKER_DEQUE_SZ - 1)], __ATOMIC_RELAXED);
+
+	/* More than one item left, no thief can reach this one */
+	if (top < bottom)
+		return thread_job;
+
+	/* Last item, race against thieves for it */
+	if (!__atomic_compare_exchange_n(&thread_instance->deque.top, &top, (top + 1), 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		thread_job = NULL;
+
+	__atomic_store_n(&thread_instance->deque.bottom, (bottom + 1), __ATOMIC_RELAXED);
+	return thread_job;
+}
+/**************************************************************************************************************************/
+static ThreadPoolInstanceJob *ThreadPoolDequeSteal(ThreadPoolInstance *thread_instance)
+{
+	ThreadPoolInstanceJob *thread_job;
+	long bottom;
+	long top;
+
+	top		= __atomic_load_n(&thread_instance->deque.top, __ATOMIC_ACQUIRE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	bottom	= __atomic_load_n(&thread_instance->deque.bottom, __ATOMIC_ACQUIRE);
+
+	/* Nothing to steal */
+	if (top >= bottom)
+		return NULL;
+
+	thread_job = __atomic_load_n(&thread_instance->deque.job_arr[top & (THREAD_POOL_WORKER_DEQUE_SZ - 1)], __ATOMIC_RELAXED);
+
+	/* Lost the race against owner or another thief */
+	if (!__atomic_compare_exchange_n(&thread_instance->deque.top, &top, (top + 1), 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return NULL;
+
+	return thread_job;
+}
+/**************************************************************************************************************************/
+static long ThreadPoolDequeSize(ThreadPoolInstance *thread_instance)
+{
+	long bottom	= __atomic_load_n(&thread_instance->deque.bottom, __ATOMIC_SEQ_CST);
+	long top	= __atomic_load_n(&thread_instance->deque.top, __ATOMIC_SEQ_CST);
+
+	return (bottom - top);
 }
 /**************************************************************************************************************************/
 static void *ThreadPoolInstanceMainLoop(void *thread_instance_ptr)
@@ -488,29 +880,23 @@ static void *ThreadPoolInstanceMainLoop(void *thread_instance_ptr)
 	/* Jump into main loop */
 	while (1)
 	{
-		/* Set THREAD state and lock JOB list MUTEX */
+		/* Set THREAD state */
 		thread_instance->thread_state		= THREAD_INSTANCE_STATE_FREE;
-		pthread_mutex_lock(&thread_pool->jobs.memslot.thrd_cond.mutex);
 
-		/* Create condition to block for */
-		while (!thread_pool->jobs.memslot.list[THREAD_LIST_JOB_PENDING].head)
-		{
-			KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_INFO, LOGCOLOR_PURPLE, "Hello from thread context [%d]-[%d] - Blocking at pthread_cond_wait\n",
-					thread_instance->thread_id_pool, thread_instance->thread_id_sys);
+		/* Flag request for a graceful shutdown */
+		if (thread_instance->flags.do_shutdown)
+			break;
 
-			/* Block waiting for condition */
-			pthread_cond_wait(&thread_pool->jobs.memslot.thrd_cond.cond, &thread_pool->jobs.memslot.thrd_cond.mutex);
+		/* Grab a JOB from our DEQUE, INJECT queue or steal one, PARK if there is none */
+		if (!(thread_job = ThreadPoolInstanceJobGrab(thread_pool, thread_instance)))
+		{
+			ThreadPoolInstancePark(thread_pool, thread_instance);
+			continue;
 		}
 
-		/* Grab and remove this job from shared job list and unlock shared job request list MUTEX */
-		thread_job = MemSlotBaseSlotPointToHeadAndSwitchListID(&thread_pool->jobs.memslot, THREAD_LIST_JOB_PENDING, THREAD_LIST_JOB_WORKING);
-		assert(thread_job);
-
 		KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_INFO, LOGCOLOR_GREEN, "Thread [%d] - Waking up to dispatch JOB_ID [%d] - IN_USE [%d]\n",
 						thread_instance->thread_id_pool, thread_job->job_id, thread_job->flags.in_use);
 
-		pthread_mutex_unlock(&thread_pool->jobs.memslot.thrd_cond.mutex);
-
 		/* Set THREAD state */
 		assert(thread_job->flags.in_use);
 		thread_instance->thread_state		= THREAD_INSTANCE_STATE_BUSY;
@@ -519,10 +905,6 @@ static void *ThreadPoolInstanceMainLoop(void *thread_instance_ptr)
 		if (ev_base)
 			memcpy(&thread_job->tv.begin, &ev_base->stats.cur_invoke_tv, sizeof(struct timeval));
 
-		/* Flag request for a graceful shutdown */
-		if (thread_instance->flags.do_shutdown)
-			break;
-
 		/* Job has been canceled */
 		if (thread_job->flags.cancelled)
 			goto clean_up;
@@ -578,12 +960,8 @@ static void *ThreadPoolInstanceMainLoop(void *thread_instance_ptr)
 		KQBASE_LOG_PRINTF(thread_pool->log_base, LOGTYPE_INFO, LOGCOLOR_YELLOW, "Thread ID [%d] - Finished JOB_ID [%d] - NOTIFY BEGIN\n",
 				thread_instance->thread_id_pool, thread_job->job_id);
 
-		/* Add into done queue for further caller examination - WARNING: DO NOT TOUCH THREAD_JOB ANYMORE ONCE YOU DO THIS LIST SWITCH */
-		MemSlotBaseSlotListIDSwitchToTail(&thread_pool->jobs.memslot, thread_job->job_id, THREAD_LIST_JOB_DONE);
-
-		/* Write NOTIFY_PIPE to tell MAIN_THREAD we are FINISHED */
-		if ((thread_pool->ev_base) && (thread_pool->flags.kevent_finish_notify))
-			ThreadPoolInstanceNotifyFinish(thread_pool, thread_job);
+		/* Add into done stack for further caller examination, only first JOB of a burst writes NOTIFY_PIPE */
+		ThreadPoolInstanceJobDone(thread_pool, thread_job);
 
 		/* Set THREAD state */
 		thread_instance->thread_state		= THREAD_INSTANCE_STATE_DONE;